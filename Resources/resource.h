@@ -28,6 +28,10 @@
 #define IDC_RADIOFINDDOWN               1006
 #define IDC_RADIOFINDANY                1007
 #define IDC_CHECKMATCHCASE              1008
+#define IDC_CHECKREGEX                  1018
+#define IDC_REPLACEWORKSPACE            1019
+#define IDC_FINDWORKSPACE               1020
+#define IDC_ABOUTSTATS                  1021
 #define IDM_FILE_NEWARTICLE             40001
 #define IDM_FILE_NEWTEMPLATE            40002
 #define IDM_FILE_OPENWS                 40003
@@ -51,14 +55,17 @@
 #define IDM_FILE_CLOSEWS                40024
 #define IDM_FILE_REFRESHWS              40025
 #define IDM_VIEW_TOGGLEPAGE             40026
+#define IDM_FILE_IMPORTARTICLES         40027
+#define IDM_FILE_IMPORTTEMPLATES        40028
+#define IDM_VIEW_DEPENDENTS             40029
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        139
-#define _APS_NEXT_COMMAND_VALUE         40027
-#define _APS_NEXT_CONTROL_VALUE         1018
+#define _APS_NEXT_COMMAND_VALUE         40030
+#define _APS_NEXT_CONTROL_VALUE         1022
 #define _APS_NEXT_SYMED_VALUE           105
 #endif
 #endif
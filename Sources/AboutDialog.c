@@ -7,10 +7,14 @@
 
 #include "AboutDialog.h"
 #include "resource.h"
+#include "RenderCache.h"
+#include "PageManager.h"
+#include "ImageCache.h"
 
 // Private methods.
 BOOL CALLBACK AboutDialogProc(HWND hWnd, UINT wMsg, WPARAM wParam,
 							  LPARAM lParam);
+void ShowCacheStats(HWND hWnd);
 
 /**
  * Shows a nice About dialog.
@@ -36,10 +40,47 @@ int ShowAboutDialog(HINSTANCE hParentInst, HWND hwndParent) {
 BOOL CALLBACK AboutDialogProc(HWND hWnd, UINT wMsg, WPARAM wParam,
 							  LPARAM lParam) {
 	switch (wMsg) {
+	case WM_INITDIALOG:
+		ShowCacheStats(hWnd);
+		return TRUE;
 	case WM_CLOSE:
 		EndDialog(hWnd, 0);
 		return FALSE;
 	}
 
 	return FALSE;
+}
+
+/**
+ * Shows how the caches have been doing since the application started, which
+ * is what their limits get tuned by on a real device.
+ *
+ * @param hWnd Dialog window handler.
+ */
+void ShowCacheStats(HWND hWnd) {
+	RENDERCACHE_STATS rcsRender;
+	PAGEVIEW_STATS pvsView;
+	IMAGECACHE_STATS icsImages;
+	TCHAR szStats[256];
+	int cchStats;
+
+	// Rendered pages.
+	GetRenderCacheStats(&rcsRender);
+	cchStats = wsprintf(szStats, L"Pages: %lu hits, %lu misses, %lu KB\r\n"
+		L"Prefetched: %lu, %lu used", rcsRender.dwHits, rcsRender.dwMisses,
+		rcsRender.cbUsed / 1024, rcsRender.dwPrefetches,
+		rcsRender.dwPrefetchHits);
+
+	// Time it takes for the viewer to show them.
+	GetPageViewStats(&pvsView);
+	cchStats += wsprintf(szStats + cchStats,
+		L"\r\nShown: %lu ms, max %lu, all %lu", pvsView.dwLastFirstChunk,
+		pvsView.dwMaxFirstChunk, pvsView.dwLastComplete);
+
+	// Images in them.
+	GetImageCacheStats(&icsImages);
+	wsprintf(szStats + cchStats, L"\r\nImages: %lu hits, %lu misses, %lu KB",
+		icsImages.dwHits, icsImages.dwMisses, icsImages.cbUsed / 1024);
+
+	SetDlgItemText(hWnd, IDC_ABOUTSTATS, szStats);
 }
\ No newline at end of file
@@ -0,0 +1,467 @@
+/**
+ * ArticleTree.c
+ * A platform-neutral model of the article hierarchy of a Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "ArticleTree.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Definitions.
+#define ARTTREE_INITIAL_CAPACITY 256
+
+// Private methods.
+long NewNode(ARTICLETREE *atTree, long lParent, const char *szaName,
+			 size_t nNameLen, long nArticle);
+long FindChildFolder(const ARTICLETREE *atTree, long lParent,
+					 const char *szaName, size_t nNameLen);
+long ResolveParentFolder(ARTICLETREE *atTree, const char *szaParent);
+
+/**
+ * Initializes an empty article tree with only its root node.
+ *
+ * @param  atTree Article tree to be initialized.
+ * @return        Non-zero if the initialization was successful.
+ */
+int ArticleTreeInitialize(ARTICLETREE *atTree) {
+	// Set everything to its defaults.
+	atTree->lpNodes = NULL;
+	atTree->nNodes = 0L;
+	atTree->nCapacity = 0L;
+	atTree->nArticles = 0L;
+	atTree->szaLastParent = NULL;
+	atTree->lLastFolder = ARTTREE_ROOT;
+
+	// Create the root node.
+	return NewNode(atTree, ARTTREE_NONE, "", 0, ARTTREE_NONE) == ARTTREE_ROOT;
+}
+
+/**
+ * Frees everything allocated by the article tree.
+ *
+ * @param atTree Article tree to be freed.
+ */
+void ArticleTreeFree(ARTICLETREE *atTree) {
+	if (atTree->lpNodes != NULL)
+		free(atTree->lpNodes);
+
+	atTree->lpNodes = NULL;
+	atTree->nNodes = 0L;
+	atTree->nCapacity = 0L;
+	atTree->nArticles = 0L;
+	atTree->szaLastParent = NULL;
+	atTree->lLastFolder = ARTTREE_ROOT;
+}
+
+/**
+ * Adds an article to the tree, creating its parent folders along the way.
+ * @remark The strings aren't copied, so they must outlive the tree.
+ *
+ * @param  atTree    Article tree.
+ * @param  nArticle  Index of the article in the Uki engine.
+ * @param  szaParent Parent folder path of the article or NULL for the root.
+ * @param  szaName   Name of the article.
+ * @return           Index of the node created or ARTTREE_NONE on failure.
+ */
+long ArticleTreeAddArticle(ARTICLETREE *atTree, long nArticle,
+						   const char *szaParent, const char *szaName) {
+	long lFolder;
+	long lNode;
+
+	// Get the folder where this article should live in.
+	lFolder = ResolveParentFolder(atTree, szaParent);
+	if (lFolder == ARTTREE_NONE)
+		return ARTTREE_NONE;
+
+	// Append the article node.
+	lNode = NewNode(atTree, lFolder, szaName, strlen(szaName), nArticle);
+	if (lNode != ARTTREE_NONE)
+		atTree->nArticles++;
+
+	return lNode;
+}
+
+/**
+ * Builds the tree from all of the articles currently loaded in the Uki engine.
+ *
+ * @param  atTree Initialized article tree.
+ * @return        Number of articles added to the tree or -1 on failure.
+ */
+long ArticleTreeBuildFromUki(ARTICLETREE *atTree) {
+	uki_article_t article;
+	long nAvailable;
+	long iArticle;
+
+	// Go through the articles.
+	nAvailable = (long)uki_articles_available();
+	for (iArticle = 0; iArticle < nAvailable; iArticle++) {
+		article = uki_article((size_t)iArticle);
+		if (article.name == NULL)
+			break;
+
+		// Add article to the tree.
+		if (ArticleTreeAddArticle(atTree, iArticle, article.parent,
+				article.name) == ARTTREE_NONE) {
+			return -1L;
+		}
+	}
+
+	return atTree->nArticles;
+}
+
+/**
+ * Gets a node from the tree.
+ *
+ * @param  atTree Article tree.
+ * @param  lNode  Node index.
+ * @return        Pointer to the node or NULL if the index is out of bounds.
+ */
+const ARTTREE_NODE* ArticleTreeGetNode(const ARTICLETREE *atTree, long lNode) {
+	if ((lNode < 0L) || (lNode >= atTree->nNodes))
+		return NULL;
+
+	return &atTree->lpNodes[lNode];
+}
+
+/**
+ * Checks if a node is a folder (the root node is also considered a folder).
+ *
+ * @param  atTree Article tree.
+ * @param  lNode  Node index.
+ * @return        Non-zero if the node is a folder.
+ */
+int ArticleTreeIsFolder(const ARTICLETREE *atTree, long lNode) {
+	const ARTTREE_NODE *lpNode = ArticleTreeGetNode(atTree, lNode);
+	return (lpNode != NULL) && (lpNode->nArticle == ARTTREE_NONE);
+}
+
+/**
+ * Gets the Uki article index associated with a node.
+ *
+ * @param  atTree Article tree.
+ * @param  lNode  Node index.
+ * @return        Article index or ARTTREE_NONE if the node isn't an article.
+ */
+long ArticleTreeGetArticle(const ARTICLETREE *atTree, long lNode) {
+	const ARTTREE_NODE *lpNode = ArticleTreeGetNode(atTree, lNode);
+	if (lpNode == NULL)
+		return ARTTREE_NONE;
+
+	return lpNode->nArticle;
+}
+
+/**
+ * Gets the articles that live next to a node in the same folder, closest ones
+ * first, alternating between the ones after and before it.
+ *
+ * @param  atTree     Article tree.
+ * @param  lNode      Node index.
+ * @param  lpArticles Pre-allocated array to receive the article indices.
+ * @param  nMax       Maximum number of articles to get.
+ * @return            Number of articles placed in the array.
+ */
+long ArticleTreeGetSiblingArticles(const ARTICLETREE *atTree, long lNode,
+								   long *lpArticles, long nMax) {
+	const ARTTREE_NODE *lpNode = ArticleTreeGetNode(atTree, lNode);
+	const ARTTREE_NODE *lpSibling;
+	long *lpBefore;
+	long *lpAfter;
+	long nBefore;
+	long nAfter;
+	long nFound;
+	long lSibling;
+	long i;
+	int fPassed;
+
+	// Check if there's anything to look at.
+	if ((lpNode == NULL) || (lpNode->lParent == ARTTREE_NONE) || (nMax <= 0L))
+		return 0L;
+	lpBefore = (long *)malloc(sizeof(long) * nMax * 2);
+	if (lpBefore == NULL)
+		return 0L;
+	lpAfter = lpBefore + nMax;
+
+	// Go through the folder keeping the last articles before the node in a
+	// ring and the first ones after it.
+	nBefore = 0L;
+	nAfter = 0L;
+	fPassed = 0;
+	lSibling = atTree->lpNodes[lpNode->lParent].lFirstChild;
+	while ((lSibling != ARTTREE_NONE) && (nAfter < nMax)) {
+		lpSibling = &atTree->lpNodes[lSibling];
+		if (lSibling == lNode) {
+			fPassed = 1;
+		} else if (lpSibling->nArticle != ARTTREE_NONE) {
+			if (fPassed) {
+				lpAfter[nAfter++] = lpSibling->nArticle;
+			} else {
+				lpBefore[nBefore % nMax] = lpSibling->nArticle;
+				nBefore++;
+			}
+		}
+
+		lSibling = lpSibling->lNextSibling;
+	}
+
+	// Interleave them by distance.
+	nFound = 0L;
+	for (i = 0L; (nFound < nMax) && ((i < nAfter) || (i < nBefore)); i++) {
+		if (i < nAfter)
+			lpArticles[nFound++] = lpAfter[i];
+		if ((i < nBefore) && (i < nMax) && (nFound < nMax))
+			lpArticles[nFound++] = lpBefore[(nBefore - 1 - i) % nMax];
+	}
+
+	free(lpBefore);
+	return nFound;
+}
+
+/**
+ * Copies the name of a node into a buffer.
+ *
+ * @param  atTree  Article tree.
+ * @param  lNode   Node index.
+ * @param  szaName Pre-allocated buffer to receive the name.
+ * @param  nMaxLen Size of the buffer including the NUL terminator.
+ * @return         Number of characters copied.
+ */
+size_t ArticleTreeGetName(const ARTICLETREE *atTree, long lNode,
+						  char *szaName, size_t nMaxLen) {
+	const ARTTREE_NODE *lpNode = ArticleTreeGetNode(atTree, lNode);
+	size_t nLen;
+
+	// Check if we have somewhere to put things.
+	if (nMaxLen == 0)
+		return 0;
+
+	// Check if the node exists.
+	if (lpNode == NULL) {
+		szaName[0] = '\0';
+		return 0;
+	}
+
+	// Copy the name truncating it if needed.
+	nLen = lpNode->nNameLen;
+	if (nLen >= nMaxLen)
+		nLen = nMaxLen - 1;
+	memcpy(szaName, lpNode->szaName, nLen);
+	szaName[nLen] = '\0';
+
+	return nLen;
+}
+
+/**
+ * Checks if the children of a node have already been materialized.
+ *
+ * @param  atTree Article tree.
+ * @param  lNode  Node index.
+ * @return        Non-zero if they were.
+ */
+int ArticleTreeIsMaterialized(const ARTICLETREE *atTree, long lNode) {
+	const ARTTREE_NODE *lpNode = ArticleTreeGetNode(atTree, lNode);
+	return (lpNode != NULL) && lpNode->fMaterialized;
+}
+
+/**
+ * Sets the materialization state of the children of a node.
+ *
+ * @param atTree        Article tree.
+ * @param lNode         Node index.
+ * @param fMaterialized Have the node's children been materialized?
+ */
+void ArticleTreeSetMaterialized(ARTICLETREE *atTree, long lNode,
+								int fMaterialized) {
+	if ((lNode < 0L) || (lNode >= atTree->nNodes))
+		return;
+
+	atTree->lpNodes[lNode].fMaterialized = fMaterialized;
+}
+
+/**
+ * Gets the user interface item associated with a node.
+ *
+ * @param  atTree Article tree.
+ * @param  lNode  Node index.
+ * @return        Item associated with the node or NULL if there isn't one.
+ */
+void* ArticleTreeGetItem(const ARTICLETREE *atTree, long lNode) {
+	const ARTTREE_NODE *lpNode = ArticleTreeGetNode(atTree, lNode);
+	if (lpNode == NULL)
+		return NULL;
+
+	return lpNode->lpItem;
+}
+
+/**
+ * Associates a user interface item with a node.
+ *
+ * @param atTree Article tree.
+ * @param lNode  Node index.
+ * @param lpItem Item to be associated with the node.
+ */
+void ArticleTreeSetItem(ARTICLETREE *atTree, long lNode, void *lpItem) {
+	if ((lNode < 0L) || (lNode >= atTree->nNodes))
+		return;
+
+	atTree->lpNodes[lNode].lpItem = lpItem;
+}
+
+/**
+ * Appends a new node to the tree and links it to its parent.
+ *
+ * @param  atTree   Article tree.
+ * @param  lParent  Parent node index or ARTTREE_NONE for the root.
+ * @param  szaName  Node name. Doesn't need to be NUL terminated.
+ * @param  nNameLen Length of the node name.
+ * @param  nArticle Article index or ARTTREE_NONE for a folder.
+ * @return          Index of the new node or ARTTREE_NONE on failure.
+ */
+long NewNode(ARTICLETREE *atTree, long lParent, const char *szaName,
+			 size_t nNameLen, long nArticle) {
+	ARTTREE_NODE *lpNode;
+	ARTTREE_NODE *lpParent;
+	long lNode;
+
+	// Grow the node array if needed.
+	if (atTree->nNodes == atTree->nCapacity) {
+		ARTTREE_NODE *lpNewNodes;
+		long nNewCapacity;
+
+		nNewCapacity = (atTree->nCapacity == 0L) ? ARTTREE_INITIAL_CAPACITY :
+			atTree->nCapacity * 2;
+		lpNewNodes = (ARTTREE_NODE*)realloc(atTree->lpNodes,
+			nNewCapacity * sizeof(ARTTREE_NODE));
+		if (lpNewNodes == NULL)
+			return ARTTREE_NONE;
+
+		atTree->lpNodes = lpNewNodes;
+		atTree->nCapacity = nNewCapacity;
+	}
+
+	// Populate the node.
+	lNode = atTree->nNodes++;
+	lpNode = &atTree->lpNodes[lNode];
+	lpNode->szaName = szaName;
+	lpNode->nNameLen = nNameLen;
+	lpNode->nArticle = nArticle;
+	lpNode->lParent = lParent;
+	lpNode->lFirstChild = ARTTREE_NONE;
+	lpNode->lLastChild = ARTTREE_NONE;
+	lpNode->lNextSibling = ARTTREE_NONE;
+	lpNode->lFirstFolder = ARTTREE_NONE;
+	lpNode->lNextFolder = ARTTREE_NONE;
+	lpNode->nChildren = 0L;
+	lpNode->fMaterialized = 0;
+	lpNode->lpItem = NULL;
+
+	// Root node doesn't have anyone to be linked to.
+	if (lParent == ARTTREE_NONE)
+		return lNode;
+
+	// Link it to the end of the parent's children list to keep the order.
+	lpParent = &atTree->lpNodes[lParent];
+	if (lpParent->lLastChild == ARTTREE_NONE) {
+		lpParent->lFirstChild = lNode;
+	} else {
+		atTree->lpNodes[lpParent->lLastChild].lNextSibling = lNode;
+	}
+	lpParent->lLastChild = lNode;
+	lpParent->nChildren++;
+
+	// Folders are also kept in a separate list to speed up lookups.
+	if (nArticle == ARTTREE_NONE) {
+		lpNode->lNextFolder = lpParent->lFirstFolder;
+		lpParent->lFirstFolder = lNode;
+	}
+
+	return lNode;
+}
+
+/**
+ * Finds a sub-folder by its name.
+ *
+ * @param  atTree   Article tree.
+ * @param  lParent  Folder to search in.
+ * @param  szaName  Name of the folder. Doesn't need to be NUL terminated.
+ * @param  nNameLen Length of the folder name.
+ * @return          Index of the folder node or ARTTREE_NONE if not found.
+ */
+long FindChildFolder(const ARTICLETREE *atTree, long lParent,
+					 const char *szaName, size_t nNameLen) {
+	const ARTTREE_NODE *lpFolder;
+	long lFolder;
+
+	// Go through the sub-folders.
+	lFolder = atTree->lpNodes[lParent].lFirstFolder;
+	while (lFolder != ARTTREE_NONE) {
+		lpFolder = &atTree->lpNodes[lFolder];
+		if ((lpFolder->nNameLen == nNameLen) &&
+			(strncmp(lpFolder->szaName, szaName, nNameLen) == 0)) {
+			return lFolder;
+		}
+
+		lFolder = lpFolder->lNextFolder;
+	}
+
+	return ARTTREE_NONE;
+}
+
+/**
+ * Resolves a parent path into a folder node, creating any missing folders.
+ *
+ * @param  atTree    Article tree.
+ * @param  szaParent Parent folder path or NULL for the root.
+ * @return           Folder node index or ARTTREE_NONE on failure.
+ */
+long ResolveParentFolder(ARTICLETREE *atTree, const char *szaParent) {
+	const char *lpComponent;
+	const char *lpEnd;
+	long lFolder;
+	long lChild;
+
+	// Articles in the root.
+	if ((szaParent == NULL) || (szaParent[0] == '\0'))
+		return ARTTREE_ROOT;
+
+	// Articles come grouped by their folders, so try the last one first.
+	if ((atTree->szaLastParent != NULL) &&
+		((atTree->szaLastParent == szaParent) ||
+		 (strcmp(atTree->szaLastParent, szaParent) == 0))) {
+		return atTree->lLastFolder;
+	}
+
+	// Walk the path one component at a time.
+	lFolder = ARTTREE_ROOT;
+	lpComponent = szaParent;
+	while (*lpComponent != '\0') {
+		// Find the end of the component.
+		for (lpEnd = lpComponent; (*lpEnd != '\0') && (*lpEnd != '/') &&
+			(*lpEnd != '\\'); lpEnd++)
+			;
+
+		// Ignore empty components.
+		if (lpEnd != lpComponent) {
+			lChild = FindChildFolder(atTree, lFolder, lpComponent,
+				lpEnd - lpComponent);
+			if (lChild == ARTTREE_NONE) {
+				lChild = NewNode(atTree, lFolder, lpComponent,
+					lpEnd - lpComponent, ARTTREE_NONE);
+				if (lChild == ARTTREE_NONE)
+					return ARTTREE_NONE;
+			}
+
+			lFolder = lChild;
+		}
+
+		// Skip the separator.
+		lpComponent = (*lpEnd == '\0') ? lpEnd : lpEnd + 1;
+	}
+
+	// Cache the folder for the next article.
+	atTree->szaLastParent = szaParent;
+	atTree->lLastFolder = lFolder;
+
+	return lFolder;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * ArticleTree.h
+ * A platform-neutral model of the article hierarchy of a Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _ARTICLETREE_H
+#define _ARTICLETREE_H
+
+#include <stddef.h>
+#include "uki.h"
+
+// Special node values.
+#define ARTTREE_ROOT    0L
+#define ARTTREE_NONE    -1L
+
+// A single node in the article tree. Folders have a nArticle of ARTTREE_NONE.
+typedef struct {
+	const char *szaName;
+	size_t nNameLen;
+	long nArticle;
+	long lParent;
+	long lFirstChild;
+	long lLastChild;
+	long lNextSibling;
+	long lFirstFolder;
+	long lNextFolder;
+	long nChildren;
+	int fMaterialized;
+	void *lpItem;
+} ARTTREE_NODE;
+
+// The whole article tree.
+typedef struct {
+	ARTTREE_NODE *lpNodes;
+	long nNodes;
+	long nCapacity;
+	long nArticles;
+	const char *szaLastParent;
+	long lLastFolder;
+} ARTICLETREE;
+
+// Initialization and destruction.
+int ArticleTreeInitialize(ARTICLETREE *atTree);
+void ArticleTreeFree(ARTICLETREE *atTree);
+
+// Building.
+long ArticleTreeAddArticle(ARTICLETREE *atTree, long nArticle,
+						   const char *szaParent, const char *szaName);
+long ArticleTreeBuildFromUki(ARTICLETREE *atTree);
+
+// Lookup.
+const ARTTREE_NODE* ArticleTreeGetNode(const ARTICLETREE *atTree, long lNode);
+int ArticleTreeIsFolder(const ARTICLETREE *atTree, long lNode);
+long ArticleTreeGetArticle(const ARTICLETREE *atTree, long lNode);
+long ArticleTreeGetSiblingArticles(const ARTICLETREE *atTree, long lNode,
+								   long *lpArticles, long nMax);
+size_t ArticleTreeGetName(const ARTICLETREE *atTree, long lNode,
+						  char *szaName, size_t nMaxLen);
+
+// Materialization state.
+int ArticleTreeIsMaterialized(const ARTICLETREE *atTree, long lNode);
+void ArticleTreeSetMaterialized(ARTICLETREE *atTree, long lNode,
+								int fMaterialized);
+
+// User interface item associated with a node.
+void* ArticleTreeGetItem(const ARTICLETREE *atTree, long lNode);
+void ArticleTreeSetItem(ARTICLETREE *atTree, long lNode, void *lpItem);
+
+#endif  // _ARTICLETREE_H
\ No newline at end of file
@@ -94,4 +94,40 @@ BOOL SaveNewPage(LPTSTR szFilePath, LPCTSTR szDialogTitle, BOOL fIsArticle) {
 
 	// Open the file dialog.
 	return GetSaveFileName(&ofn);
+}
+
+/**
+ * Opens a dialog to choose a folder of pages to be imported. There's no folder
+ * picker on every platform, so the user picks any of the pages instead.
+ *
+ * @param  szFolder      Pre-allocated string with MAX_PATH characters to store
+ *                       the folder path.
+ * @param  szDialogTitle String containing the open dialog title.
+ * @return               TRUE if the user actually selected a folder.
+ */
+BOOL OpenImportFolder(LPTSTR szFolder, LPCTSTR szDialogTitle) {
+	OPENFILENAME ofn = {0};
+	LPTSTR szName;
+	szFolder[0] = L'\0';
+
+	// Populate the structure.
+	ofn.lStructSize = sizeof(ofn);
+	ofn.lpstrTitle = szDialogTitle;
+	ofn.hwndOwner = hwndParent;
+	ofn.lpstrFilter = L"HTML File (*.htm)\0*.htm;*.html\0";
+	ofn.lpstrFile = szFolder;
+	ofn.nMaxFile = MAX_PATH;
+	ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST;
+
+	// Open the file dialog.
+	if (!GetOpenFileName(&ofn))
+		return FALSE;
+
+	// Strip the file name.
+	szName = wcsrchr(szFolder, L'\\');
+	if (szName == NULL)
+		return FALSE;
+	*szName = L'\0';
+
+	return TRUE;
 }
\ No newline at end of file
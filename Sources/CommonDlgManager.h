@@ -16,5 +16,6 @@ BOOL InitializeCommonDialogs(HINSTANCE hParentInst, HWND hParentWindow);
 // Dialogs.
 BOOL OpenWorkspace(LPTSTR szWikiRoot);
 BOOL SaveNewPage(LPTSTR szFilePath, LPCTSTR szDialogTitle, BOOL fIsArticle);
+BOOL OpenImportFolder(LPTSTR szFolder, LPCTSTR szDialogTitle);
 
 #endif  // _COMMONDLGMANAGER_H
\ No newline at end of file
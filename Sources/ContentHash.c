@@ -0,0 +1,196 @@
+/**
+ * ContentHash.c
+ * A platform-neutral fast non-cryptographic hash of file and page contents,
+ * used to tell if something really changed. This is xxHash32, which keeps four
+ * independent lanes going so that the processor can work on them in parallel.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "ContentHash.h"
+#include <string.h>
+
+// Constants of the hash.
+#define PRIME1 2654435761U
+#define PRIME2 2246822519U
+#define PRIME3 3266489917U
+#define PRIME4  668265263U
+#define PRIME5  374761393U
+
+// Rotates a 32-bit value to the left.
+#define ROTL32(x, r) (((x) << (r)) | ((x) >> (32 - (r))))
+
+// Private methods.
+unsigned int ReadLane(const unsigned char *lpData);
+unsigned int MixLane(unsigned int dwLane, unsigned int dwInput);
+void ConsumeStripes(unsigned int *aLanes, const unsigned char *lpData,
+					size_t nStripes);
+
+/**
+ * Starts a new hash.
+ *
+ * @param lpHash Hash state to be initialized.
+ */
+void ContentHashInitialize(CONTENTHASH *lpHash) {
+	lpHash->aLanes[0] = PRIME1 + PRIME2;
+	lpHash->aLanes[1] = PRIME2;
+	lpHash->aLanes[2] = 0;
+	lpHash->aLanes[3] = 0U - PRIME1;
+	lpHash->cbStripe = 0;
+	lpHash->dwLength = 0;
+	lpHash->fLarge = 0;
+}
+
+/**
+ * Adds a piece of data to a hash. Splitting the data in any number of pieces
+ * gives the same result as hashing it in one go.
+ *
+ * @param lpHash Hash state.
+ * @param lpData Data to be hashed.
+ * @param cbData Size of the data in bytes.
+ */
+void ContentHashUpdate(CONTENTHASH *lpHash, const void *lpData, size_t cbData) {
+	const unsigned char *lpBytes = (const unsigned char*)lpData;
+	size_t cbTake;
+
+	lpHash->dwLength += (unsigned int)cbData;
+	if ((lpHash->cbStripe + cbData) >= CONTENTHASH_STRIPE)
+		lpHash->fLarge = 1;
+
+	// Complete a stripe left over from the previous piece.
+	if (lpHash->cbStripe > 0) {
+		cbTake = CONTENTHASH_STRIPE - lpHash->cbStripe;
+		if (cbTake > cbData)
+			cbTake = cbData;
+		memcpy(lpHash->abStripe + lpHash->cbStripe, lpBytes, cbTake);
+		lpHash->cbStripe += cbTake;
+		lpBytes += cbTake;
+		cbData -= cbTake;
+
+		if (lpHash->cbStripe < CONTENTHASH_STRIPE)
+			return;
+		ConsumeStripes(lpHash->aLanes, lpHash->abStripe, 1);
+		lpHash->cbStripe = 0;
+	}
+
+	// Go through the whole stripes straight from the data.
+	ConsumeStripes(lpHash->aLanes, lpBytes, cbData / CONTENTHASH_STRIPE);
+	lpBytes += cbData - (cbData % CONTENTHASH_STRIPE);
+	cbData %= CONTENTHASH_STRIPE;
+
+	// Keep the rest for later.
+	memcpy(lpHash->abStripe, lpBytes, cbData);
+	lpHash->cbStripe = cbData;
+}
+
+/**
+ * Gets the hash of everything that was added so far. The state is left
+ * untouched, so more data can still be added afterwards.
+ *
+ * @param  lpHash Hash state.
+ * @return        32-bit hash of the data.
+ */
+unsigned long ContentHashFinal(const CONTENTHASH *lpHash) {
+	const unsigned char *lpTail;
+	unsigned int dwHash;
+	size_t cbTail;
+
+	// Merge the lanes.
+	if (lpHash->fLarge) {
+		dwHash = ROTL32(lpHash->aLanes[0], 1) + ROTL32(lpHash->aLanes[1], 7) +
+			ROTL32(lpHash->aLanes[2], 12) + ROTL32(lpHash->aLanes[3], 18);
+	} else {
+		dwHash = lpHash->aLanes[2] + PRIME5;
+	}
+	dwHash += lpHash->dwLength;
+
+	// Mix in what didn't fill a stripe.
+	lpTail = lpHash->abStripe;
+	cbTail = lpHash->cbStripe;
+	for (; cbTail >= 4; cbTail -= 4, lpTail += 4) {
+		dwHash += ReadLane(lpTail) * PRIME3;
+		dwHash = ROTL32(dwHash, 17) * PRIME4;
+	}
+	for (; cbTail > 0; cbTail--, lpTail++) {
+		dwHash += (*lpTail) * PRIME5;
+		dwHash = ROTL32(dwHash, 11) * PRIME1;
+	}
+
+	// Spread every bit across the whole value.
+	dwHash ^= dwHash >> 15;
+	dwHash *= PRIME2;
+	dwHash ^= dwHash >> 13;
+	dwHash *= PRIME3;
+	dwHash ^= dwHash >> 16;
+
+	return (unsigned long)dwHash;
+}
+
+/**
+ * Hashes a whole buffer in one go.
+ *
+ * @param  lpData Data to be hashed.
+ * @param  cbData Size of the data in bytes.
+ * @return        32-bit hash of the data.
+ */
+unsigned long ContentHashBuffer(const void *lpData, size_t cbData) {
+	CONTENTHASH chHash;
+
+	ContentHashInitialize(&chHash);
+	ContentHashUpdate(&chHash, lpData, cbData);
+
+	return ContentHashFinal(&chHash);
+}
+
+/**
+ * Reads a little-endian 32-bit value from a possibly unaligned address.
+ *
+ * @param  lpData Where the value is.
+ * @return        Value that was read.
+ */
+unsigned int ReadLane(const unsigned char *lpData) {
+	return (unsigned int)lpData[0] | ((unsigned int)lpData[1] << 8) |
+		((unsigned int)lpData[2] << 16) | ((unsigned int)lpData[3] << 24);
+}
+
+/**
+ * Mixes a value into a lane.
+ *
+ * @param  dwLane  Current value of the lane.
+ * @param  dwInput Value to be mixed in.
+ * @return         New value of the lane.
+ */
+unsigned int MixLane(unsigned int dwLane, unsigned int dwInput) {
+	dwLane += dwInput * PRIME2;
+	dwLane = ROTL32(dwLane, 13);
+
+	return dwLane * PRIME1;
+}
+
+/**
+ * Mixes whole stripes into the lanes.
+ *
+ * @param aLanes   The four lanes of the hash.
+ * @param lpData   Stripes to be mixed in.
+ * @param nStripes Number of stripes.
+ */
+void ConsumeStripes(unsigned int *aLanes, const unsigned char *lpData,
+					size_t nStripes) {
+	unsigned int dwLane0 = aLanes[0];
+	unsigned int dwLane1 = aLanes[1];
+	unsigned int dwLane2 = aLanes[2];
+	unsigned int dwLane3 = aLanes[3];
+
+	// Keep the lanes in registers while going through the data.
+	for (; nStripes > 0; nStripes--, lpData += CONTENTHASH_STRIPE) {
+		dwLane0 = MixLane(dwLane0, ReadLane(lpData));
+		dwLane1 = MixLane(dwLane1, ReadLane(lpData + 4));
+		dwLane2 = MixLane(dwLane2, ReadLane(lpData + 8));
+		dwLane3 = MixLane(dwLane3, ReadLane(lpData + 12));
+	}
+
+	aLanes[0] = dwLane0;
+	aLanes[1] = dwLane1;
+	aLanes[2] = dwLane2;
+	aLanes[3] = dwLane3;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+/**
+ * ContentHash.h
+ * A platform-neutral fast non-cryptographic hash of file and page contents,
+ * used to tell if something really changed.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _CONTENTHASH_H
+#define _CONTENTHASH_H
+
+#include <stddef.h>
+
+// Size of the blocks the hash consumes at a time.
+#define CONTENTHASH_STRIPE 16
+
+// State of a hash being calculated a piece at a time. Every lane is a 32-bit
+// value, which is what an unsigned int is on all of our platforms.
+typedef struct {
+	unsigned int aLanes[4];
+	unsigned char abStripe[CONTENTHASH_STRIPE];
+	size_t cbStripe;
+	unsigned int dwLength;
+	int fLarge;
+} CONTENTHASH;
+
+// Incremental hashing.
+void ContentHashInitialize(CONTENTHASH *lpHash);
+void ContentHashUpdate(CONTENTHASH *lpHash, const void *lpData, size_t cbData);
+unsigned long ContentHashFinal(const CONTENTHASH *lpHash);
+
+// One-shot hashing.
+unsigned long ContentHashBuffer(const void *lpData, size_t cbData);
+
+#endif  // _CONTENTHASH_H
\ No newline at end of file
@@ -0,0 +1,873 @@
+/**
+ * DependencyIndex.c
+ * Keeps track of which articles depend on each template and variable.
+ *
+ * A page is considered to use a template or variable when it mentions its name
+ * as a whole word, which is looked up in the workspace search index. Templates
+ * can use other templates and variables, so an article depends on everything
+ * that is reachable from the templates it mentions. This may overestimate what
+ * a render really uses, which is the safe side for invalidation.
+ *
+ * The direct mentions are kept around, so saving a page only has to look at
+ * what that page mentions instead of searching the whole workspace again.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "DependencyIndex.h"
+#include "UkiHelper.h"
+#include "WorkspaceSearch.h"
+#include "RenderCache.h"
+#include "Utilities.h"
+
+// Sorted list of the pages that depend on something.
+typedef struct {
+	LONG *lpPages;
+	LONG nPages;
+} DEPENDENTS;
+
+// Everything the index knows. The direct mentions come from the search index
+// and are kept so that a single page can be updated, everything else is
+// derived from them.
+typedef struct {
+	DEPENDENTS *lpTemplateDeps;
+	DEPENDENTS *lpTemplateDirect;
+	DEPENDENTS *lpTemplateMentions;
+	DEPENDENTS *lpTemplateUsers;
+	LONG nTemplates;
+	DEPENDENTS *lpVariableDeps;
+	DEPENDENTS *lpVariableDirect;
+	DEPENDENTS *lpVariableMentions;
+	const char **lpszaKeys;
+	LONG nVariables;
+} DEPGRAPH;
+
+// Pages gathered while building a dependents list, without duplicates.
+typedef struct {
+	LONG *lpPages;
+	LONG nPages;
+	LPBYTE lpMarks;
+	LONG nMaxPages;
+} DEPUNION;
+
+// Scratch space used while building the index.
+typedef struct {
+	TXTIDX_MATCH *lpMatches;
+	LONG nMaxMatches;
+	DEPUNION duArticles;
+	DEPUNION duTemplates;
+} DEPBUILD;
+
+// Global variables.
+CRITICAL_SECTION csDependencies;
+DEPGRAPH dgIndex;
+BOOL fDependenciesReady = FALSE;
+
+// Private methods.
+LONG CountUkiVariables(LONG *lpnFirstConfig);
+BOOL AllocateGraph(DEPGRAPH *lpGraph, LONG nTemplates, LONG nVariables);
+void FreeGraph(DEPGRAPH *lpGraph);
+BOOL AllocateBuild(DEPBUILD *lpBuild, LONG nArticles, LONG nTemplates);
+void FreeBuild(DEPBUILD *lpBuild);
+BOOL DeriveDependents(DEPBUILD *lpBuild, DEPGRAPH *lpGraph);
+BOOL IsGraphCurrent(const DEPGRAPH *lpGraph);
+void FindMentions(DEPBUILD *lpBuild, const char *szaName);
+void AddToUnion(DEPUNION *lpUnion, const DEPENDENTS *lpDeps);
+BOOL TakeUnion(DEPUNION *lpUnion, DEPENDENTS *lpDeps);
+BOOL SetDependent(DEPENDENTS *lpDeps, LONG nPage, BOOL fDepends);
+BOOL IsAnyMarked(const DEPENDENTS *lpDeps, const BYTE *lpMarks);
+int ComparePages(const void *lpA, const void *lpB);
+void FreeDependents(DEPENDENTS *lpDeps, LONG nDeps);
+LONG CopyDependents(const DEPENDENTS *lpDeps, LONG *lpArticles,
+					LONG nMaxArticles);
+LONG FindVariable(LPCTSTR szKey);
+
+/**
+ * Initializes the dependency index.
+ */
+void InitializeDependencyIndex() {
+	InitializeCriticalSection(&csDependencies);
+}
+
+/**
+ * Frees everything allocated by the dependency index.
+ */
+void DestroyDependencyIndex() {
+	ClearDependencyIndex();
+	DeleteCriticalSection(&csDependencies);
+}
+
+/**
+ * Forgets all of the dependencies.
+ */
+void ClearDependencyIndex() {
+	EnterCriticalSection(&csDependencies);
+	FreeGraph(&dgIndex);
+	fDependenciesReady = FALSE;
+	LeaveCriticalSection(&csDependencies);
+}
+
+/**
+ * Builds the dependency index from the workspace search index, replacing the
+ * previous one. Safe to be called from a worker thread as long as the engine
+ * isn't changed in the meantime.
+ *
+ * @return TRUE if the operation was successful.
+ */
+BOOL BuildDependencyIndex() {
+	DEPBUILD dbBuild;
+	DEPGRAPH dgGraph;
+	UKITEMPLATE ukiTemplate;
+	LONG nFirstConfig;
+	LONG iTemplate;
+	LONG iVariable;
+	BOOL bSuccess;
+
+	// Allocate everything up front.
+	memset(&dgGraph, 0, sizeof(DEPGRAPH));
+	bSuccess = AllocateGraph(&dgGraph, GetUkiTemplatesAvailable(),
+		CountUkiVariables(&nFirstConfig));
+	bSuccess = AllocateBuild(&dbBuild, GetUkiArticlesAvailable(),
+		dgGraph.nTemplates) && bSuccess;
+
+	// Find the pages that mention each template directly.
+	for (iTemplate = 0L; bSuccess && (iTemplate < dgGraph.nTemplates);
+			iTemplate++) {
+		if (GetUkiTemplate(&ukiTemplate, (size_t)iTemplate))
+			FindMentions(&dbBuild, ukiTemplate.name);
+
+		bSuccess = TakeUnion(&dbBuild.duArticles,
+			&dgGraph.lpTemplateDirect[iTemplate]) &&
+			TakeUnion(&dbBuild.duTemplates,
+			&dgGraph.lpTemplateMentions[iTemplate]);
+	}
+
+	// Same thing for the variables.
+	for (iVariable = 0L; bSuccess && (iVariable < dgGraph.nVariables);
+			iVariable++) {
+		if (iVariable < nFirstConfig) {
+			dgGraph.lpszaKeys[iVariable] = uki_variable((size_t)iVariable).key;
+		} else {
+			dgGraph.lpszaKeys[iVariable] = uki_config(
+				(size_t)(iVariable - nFirstConfig)).key;
+		}
+
+		FindMentions(&dbBuild, dgGraph.lpszaKeys[iVariable]);
+		bSuccess = TakeUnion(&dbBuild.duArticles,
+			&dgGraph.lpVariableDirect[iVariable]) &&
+			TakeUnion(&dbBuild.duTemplates,
+			&dgGraph.lpVariableMentions[iVariable]);
+	}
+
+	// Work out what depends on what from the mentions.
+	if (bSuccess)
+		bSuccess = DeriveDependents(&dbBuild, &dgGraph);
+	FreeBuild(&dbBuild);
+
+	// Swap the new index in.
+	if (!bSuccess) {
+		FreeGraph(&dgGraph);
+		return FALSE;
+	}
+	EnterCriticalSection(&csDependencies);
+	FreeGraph(&dgIndex);
+	dgIndex = dgGraph;
+	fDependenciesReady = TRUE;
+	LeaveCriticalSection(&csDependencies);
+
+	return TRUE;
+}
+
+/**
+ * Updates the index after an article was saved. Only what the article itself
+ * mentions can have changed, so that's all that gets looked at, instead of
+ * building the whole index again.
+ * @remark The workspace search index must already have the new contents.
+ *
+ * @param  nArticle Index of the article that was saved.
+ * @return          TRUE if the index is up to date.
+ */
+BOOL UpdateArticleDependencies(LONG nArticle) {
+	UKITEMPLATE ukiTemplate;
+	LPBYTE lpMentioned;
+	LPBYTE lpUsed;
+	LONG iTemplate;
+	LONG iVariable;
+	BOOL fDepends;
+	BOOL bSuccess;
+
+	// Pages added since the last build need a full one.
+	EnterCriticalSection(&csDependencies);
+	if (!fDependenciesReady || (nArticle < 0L)) {
+		LeaveCriticalSection(&csDependencies);
+		return FALSE;
+	}
+	if (!IsGraphCurrent(&dgIndex)) {
+		LeaveCriticalSection(&csDependencies);
+		return BuildDependencyIndex();
+	}
+
+	// Flags for the templates that the article mentions and uses.
+	lpMentioned = (LPBYTE)LocalAlloc(LPTR, (dgIndex.nTemplates * 2) + 1);
+	bSuccess = lpMentioned != NULL;
+	lpUsed = (bSuccess) ? lpMentioned + dgIndex.nTemplates : NULL;
+
+	// Check which templates it mentions directly.
+	for (iTemplate = 0L; bSuccess && (iTemplate < dgIndex.nTemplates);
+			iTemplate++) {
+		if (GetUkiTemplate(&ukiTemplate, (size_t)iTemplate) &&
+				(ukiTemplate.name != NULL)) {
+			lpMentioned[iTemplate] = (BYTE)WorkspacePageHasWords(
+				TXTIDX_ARTICLE, nArticle, ukiTemplate.name);
+		}
+
+		bSuccess = SetDependent(&dgIndex.lpTemplateDirect[iTemplate], nArticle,
+			lpMentioned[iTemplate]);
+	}
+
+	// It uses a template if it mentions any of the templates that use it.
+	for (iTemplate = 0L; bSuccess && (iTemplate < dgIndex.nTemplates);
+			iTemplate++) {
+		lpUsed[iTemplate] = (BYTE)IsAnyMarked(
+			&dgIndex.lpTemplateUsers[iTemplate], lpMentioned);
+		bSuccess = SetDependent(&dgIndex.lpTemplateDeps[iTemplate], nArticle,
+			lpUsed[iTemplate]);
+	}
+
+	// And a variable if it or any of the templates it uses mention it.
+	for (iVariable = 0L; bSuccess && (iVariable < dgIndex.nVariables);
+			iVariable++) {
+		fDepends = (dgIndex.lpszaKeys[iVariable] != NULL) &&
+			WorkspacePageHasWords(TXTIDX_ARTICLE, nArticle,
+				dgIndex.lpszaKeys[iVariable]);
+		bSuccess = SetDependent(&dgIndex.lpVariableDirect[iVariable], nArticle,
+			fDepends);
+
+		if (!fDepends) {
+			fDepends = IsAnyMarked(&dgIndex.lpVariableMentions[iVariable],
+				lpUsed);
+		}
+		bSuccess = bSuccess && SetDependent(
+			&dgIndex.lpVariableDeps[iVariable], nArticle, fDepends);
+	}
+
+	// A half updated index is worse than none.
+	if (!bSuccess) {
+		FreeGraph(&dgIndex);
+		fDependenciesReady = FALSE;
+	}
+	LeaveCriticalSection(&csDependencies);
+
+	if (lpMentioned != NULL)
+		LocalFree(lpMentioned);
+	return bSuccess;
+}
+
+/**
+ * Updates the index after a template was saved. What the template mentions is
+ * looked up again, but the rest comes from the mentions that are already
+ * known, so no other page has to be searched.
+ * @remark The workspace search index must already have the new contents.
+ *
+ * @param  nTemplate Index of the template that was saved.
+ * @return           TRUE if the index is up to date.
+ */
+BOOL UpdateTemplateDependencies(LONG nTemplate) {
+	UKITEMPLATE ukiTemplate;
+	DEPBUILD dbBuild;
+	LONG iTemplate;
+	LONG iVariable;
+	BOOL fMentions;
+	BOOL bSuccess;
+
+	// Pages added since the last build need a full one.
+	EnterCriticalSection(&csDependencies);
+	if (!fDependenciesReady || (nTemplate < 0L)) {
+		LeaveCriticalSection(&csDependencies);
+		return FALSE;
+	}
+	if (!IsGraphCurrent(&dgIndex)) {
+		LeaveCriticalSection(&csDependencies);
+		return BuildDependencyIndex();
+	}
+	bSuccess = AllocateBuild(&dbBuild, GetUkiArticlesAvailable(),
+		dgIndex.nTemplates);
+
+	// Check which templates it mentions now.
+	for (iTemplate = 0L; bSuccess && (iTemplate < dgIndex.nTemplates);
+			iTemplate++) {
+		fMentions = GetUkiTemplate(&ukiTemplate, (size_t)iTemplate) &&
+			(ukiTemplate.name != NULL) && WorkspacePageHasWords(
+				TXTIDX_TEMPLATE, nTemplate, ukiTemplate.name);
+		bSuccess = SetDependent(&dgIndex.lpTemplateMentions[iTemplate],
+			nTemplate, fMentions);
+	}
+
+	// And which variables.
+	for (iVariable = 0L; bSuccess && (iVariable < dgIndex.nVariables);
+			iVariable++) {
+		fMentions = (dgIndex.lpszaKeys[iVariable] != NULL) &&
+			WorkspacePageHasWords(TXTIDX_TEMPLATE, nTemplate,
+				dgIndex.lpszaKeys[iVariable]);
+		bSuccess = SetDependent(&dgIndex.lpVariableMentions[iVariable],
+			nTemplate, fMentions);
+	}
+
+	// Which templates use which may have changed anywhere.
+	if (bSuccess)
+		bSuccess = DeriveDependents(&dbBuild, &dgIndex);
+	FreeBuild(&dbBuild);
+
+	// A half updated index is worse than none.
+	if (!bSuccess) {
+		FreeGraph(&dgIndex);
+		fDependenciesReady = FALSE;
+	}
+	LeaveCriticalSection(&csDependencies);
+
+	return bSuccess;
+}
+
+/**
+ * Checks if the dependency index was built.
+ *
+ * @return TRUE if the index can be queried.
+ */
+BOOL IsDependencyIndexReady() {
+	return fDependenciesReady;
+}
+
+/**
+ * Gets the articles that depend on a template, which is what breaks if it
+ * gets edited.
+ *
+ * @param  nTemplate    Template index.
+ * @param  lpArticles   Array to receive the sorted article indices.
+ * @param  nMaxArticles Maximum number of articles to be copied.
+ * @return              Total number of dependent articles or -1 if the index
+ *                      isn't ready.
+ */
+LONG GetTemplateDependents(LONG nTemplate, LONG *lpArticles,
+						   LONG nMaxArticles) {
+	LONG nDependents = -1L;
+
+	EnterCriticalSection(&csDependencies);
+	if (fDependenciesReady && (nTemplate >= 0L) &&
+			(nTemplate < dgIndex.nTemplates)) {
+		nDependents = CopyDependents(&dgIndex.lpTemplateDeps[nTemplate],
+			lpArticles, nMaxArticles);
+	}
+	LeaveCriticalSection(&csDependencies);
+
+	return nDependents;
+}
+
+/**
+ * Gets the articles that depend on a variable or configuration key.
+ *
+ * @param  szKey        Variable key.
+ * @param  lpArticles   Array to receive the sorted article indices.
+ * @param  nMaxArticles Maximum number of articles to be copied.
+ * @return              Total number of dependent articles or -1 if the index
+ *                      isn't ready or the variable doesn't exist.
+ */
+LONG GetVariableDependents(LPCTSTR szKey, LONG *lpArticles,
+						   LONG nMaxArticles) {
+	LONG nDependents = -1L;
+	LONG iVariable;
+
+	EnterCriticalSection(&csDependencies);
+	iVariable = FindVariable(szKey);
+	if (iVariable >= 0L) {
+		nDependents = CopyDependents(&dgIndex.lpVariableDeps[iVariable],
+			lpArticles, nMaxArticles);
+	}
+	LeaveCriticalSection(&csDependencies);
+
+	return nDependents;
+}
+
+/**
+ * Marks the articles that depend on a template as stale.
+ *
+ * @param  nTemplate Template index.
+ * @return           FALSE if the index isn't ready and the caller should
+ *                   consider every article stale.
+ */
+BOOL InvalidateTemplateDependents(LONG nTemplate) {
+	const DEPENDENTS *lpDeps;
+	LONG iArticle;
+	BOOL bSuccess = FALSE;
+
+	EnterCriticalSection(&csDependencies);
+	if (fDependenciesReady && (nTemplate >= 0L) &&
+			(nTemplate < dgIndex.nTemplates)) {
+		lpDeps = &dgIndex.lpTemplateDeps[nTemplate];
+		for (iArticle = 0L; iArticle < lpDeps->nPages; iArticle++)
+			InvalidateRenderedArticle(lpDeps->lpPages[iArticle]);
+
+		bSuccess = TRUE;
+	}
+	LeaveCriticalSection(&csDependencies);
+
+	return bSuccess;
+}
+
+/**
+ * Counts the variables and configuration keys of the workspace.
+ *
+ * @param  lpnFirstConfig Index where the configuration keys start.
+ * @return                Number of variables and configuration keys.
+ */
+LONG CountUkiVariables(LONG *lpnFirstConfig) {
+	LONG nVariables = 0L;
+	LONG nConfigs = 0L;
+
+	while (uki_variable((size_t)nVariables).key != NULL)
+		nVariables++;
+	while (uki_config((size_t)nConfigs).key != NULL)
+		nConfigs++;
+
+	*lpnFirstConfig = nVariables;
+	return nVariables + nConfigs;
+}
+
+/**
+ * Allocates the lists of a dependency graph, all of them empty.
+ *
+ * @param  lpGraph    Zeroed graph to be allocated.
+ * @param  nTemplates Number of templates in the workspace.
+ * @param  nVariables Number of variables and configuration keys.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL AllocateGraph(DEPGRAPH *lpGraph, LONG nTemplates, LONG nVariables) {
+	DWORD cbTemplates;
+	DWORD cbVariables;
+
+	lpGraph->nTemplates = nTemplates;
+	lpGraph->nVariables = nVariables;
+	cbTemplates = (nTemplates + 1) * sizeof(DEPENDENTS);
+	cbVariables = (nVariables + 1) * sizeof(DEPENDENTS);
+
+	lpGraph->lpTemplateDeps = (DEPENDENTS*)LocalAlloc(LPTR, cbTemplates);
+	lpGraph->lpTemplateDirect = (DEPENDENTS*)LocalAlloc(LPTR, cbTemplates);
+	lpGraph->lpTemplateMentions = (DEPENDENTS*)LocalAlloc(LPTR, cbTemplates);
+	lpGraph->lpTemplateUsers = (DEPENDENTS*)LocalAlloc(LPTR, cbTemplates);
+	lpGraph->lpVariableDeps = (DEPENDENTS*)LocalAlloc(LPTR, cbVariables);
+	lpGraph->lpVariableDirect = (DEPENDENTS*)LocalAlloc(LPTR, cbVariables);
+	lpGraph->lpVariableMentions = (DEPENDENTS*)LocalAlloc(LPTR, cbVariables);
+	lpGraph->lpszaKeys = (const char**)LocalAlloc(LPTR,
+		(nVariables + 1) * sizeof(const char*));
+
+	return (lpGraph->lpTemplateDeps != NULL) &&
+		(lpGraph->lpTemplateDirect != NULL) &&
+		(lpGraph->lpTemplateMentions != NULL) &&
+		(lpGraph->lpTemplateUsers != NULL) &&
+		(lpGraph->lpVariableDeps != NULL) &&
+		(lpGraph->lpVariableDirect != NULL) &&
+		(lpGraph->lpVariableMentions != NULL) && (lpGraph->lpszaKeys != NULL);
+}
+
+/**
+ * Frees everything allocated for a dependency graph and zeroes it.
+ *
+ * @param lpGraph Graph to be freed.
+ */
+void FreeGraph(DEPGRAPH *lpGraph) {
+	FreeDependents(lpGraph->lpTemplateDeps, lpGraph->nTemplates);
+	FreeDependents(lpGraph->lpTemplateDirect, lpGraph->nTemplates);
+	FreeDependents(lpGraph->lpTemplateMentions, lpGraph->nTemplates);
+	FreeDependents(lpGraph->lpTemplateUsers, lpGraph->nTemplates);
+	FreeDependents(lpGraph->lpVariableDeps, lpGraph->nVariables);
+	FreeDependents(lpGraph->lpVariableDirect, lpGraph->nVariables);
+	FreeDependents(lpGraph->lpVariableMentions, lpGraph->nVariables);
+	if (lpGraph->lpszaKeys != NULL)
+		LocalFree((HLOCAL)lpGraph->lpszaKeys);
+
+	memset(lpGraph, 0, sizeof(DEPGRAPH));
+}
+
+/**
+ * Allocates the scratch space used to build dependents lists.
+ *
+ * @param  lpBuild    Scratch space to be allocated.
+ * @param  nArticles  Number of articles in the workspace.
+ * @param  nTemplates Number of templates in the workspace.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL AllocateBuild(DEPBUILD *lpBuild, LONG nArticles, LONG nTemplates) {
+	lpBuild->nMaxMatches = nArticles + nTemplates;
+	lpBuild->lpMatches = (TXTIDX_MATCH*)LocalAlloc(LMEM_FIXED,
+		(lpBuild->nMaxMatches + 1) * sizeof(TXTIDX_MATCH));
+
+	lpBuild->duArticles.nPages = 0L;
+	lpBuild->duArticles.nMaxPages = nArticles;
+	lpBuild->duArticles.lpPages = (LONG*)LocalAlloc(LMEM_FIXED,
+		(nArticles + 1) * sizeof(LONG));
+	lpBuild->duArticles.lpMarks = (LPBYTE)LocalAlloc(LPTR, nArticles + 1);
+
+	lpBuild->duTemplates.nPages = 0L;
+	lpBuild->duTemplates.nMaxPages = nTemplates;
+	lpBuild->duTemplates.lpPages = (LONG*)LocalAlloc(LMEM_FIXED,
+		(nTemplates + 1) * sizeof(LONG));
+	lpBuild->duTemplates.lpMarks = (LPBYTE)LocalAlloc(LPTR, nTemplates + 1);
+
+	return (lpBuild->lpMatches != NULL) &&
+		(lpBuild->duArticles.lpPages != NULL) &&
+		(lpBuild->duArticles.lpMarks != NULL) &&
+		(lpBuild->duTemplates.lpPages != NULL) &&
+		(lpBuild->duTemplates.lpMarks != NULL);
+}
+
+/**
+ * Frees the scratch space used to build dependents lists.
+ *
+ * @param lpBuild Scratch space to be freed.
+ */
+void FreeBuild(DEPBUILD *lpBuild) {
+	if (lpBuild->lpMatches != NULL)
+		LocalFree(lpBuild->lpMatches);
+	if (lpBuild->duArticles.lpPages != NULL)
+		LocalFree(lpBuild->duArticles.lpPages);
+	if (lpBuild->duArticles.lpMarks != NULL)
+		LocalFree(lpBuild->duArticles.lpMarks);
+	if (lpBuild->duTemplates.lpPages != NULL)
+		LocalFree(lpBuild->duTemplates.lpPages);
+	if (lpBuild->duTemplates.lpMarks != NULL)
+		LocalFree(lpBuild->duTemplates.lpMarks);
+}
+
+/**
+ * Works out which articles depend on each template and variable from the
+ * direct mentions in the graph, replacing whatever was derived before.
+ * Templates can use other templates, so the templates that end up using each
+ * one are found with a breadth-first search over the mentions, which only
+ * ever visits templates that are actually connected.
+ *
+ * @param  lpBuild Scratch space.
+ * @param  lpGraph Graph with the direct mentions filled in.
+ * @return         TRUE if the operation was successful.
+ */
+BOOL DeriveDependents(DEPBUILD *lpBuild, DEPGRAPH *lpGraph) {
+	DEPUNION *lpUsers;
+	LONG iTemplate;
+	LONG iVariable;
+	LONG iUser;
+	BOOL bSuccess = TRUE;
+
+	// An article depends on a template when it mentions it or any template
+	// that ends up using it.
+	lpUsers = &lpBuild->duTemplates;
+	for (iTemplate = 0L; bSuccess && (iTemplate < lpGraph->nTemplates);
+			iTemplate++) {
+		// The union doubles as the queue, since it only grows at the end.
+		lpUsers->lpMarks[iTemplate] = 1;
+		lpUsers->lpPages[0] = iTemplate;
+		lpUsers->nPages = 1L;
+		for (iUser = 0L; iUser < lpUsers->nPages; iUser++) {
+			AddToUnion(lpUsers,
+				&lpGraph->lpTemplateMentions[lpUsers->lpPages[iUser]]);
+			AddToUnion(&lpBuild->duArticles,
+				&lpGraph->lpTemplateDirect[lpUsers->lpPages[iUser]]);
+		}
+
+		FreeDependents(&lpGraph->lpTemplateDeps[iTemplate], -1L);
+		FreeDependents(&lpGraph->lpTemplateUsers[iTemplate], -1L);
+		bSuccess = TakeUnion(&lpBuild->duArticles,
+			&lpGraph->lpTemplateDeps[iTemplate]) &&
+			TakeUnion(lpUsers, &lpGraph->lpTemplateUsers[iTemplate]);
+	}
+
+	// An article depends on a variable when it or any of its templates
+	// mention it.
+	for (iVariable = 0L; bSuccess && (iVariable < lpGraph->nVariables);
+			iVariable++) {
+		AddToUnion(&lpBuild->duArticles,
+			&lpGraph->lpVariableDirect[iVariable]);
+		for (iUser = 0L; iUser < lpGraph->lpVariableMentions[iVariable].nPages;
+				iUser++) {
+			AddToUnion(&lpBuild->duArticles, &lpGraph->lpTemplateDeps[
+				lpGraph->lpVariableMentions[iVariable].lpPages[iUser]]);
+		}
+
+		FreeDependents(&lpGraph->lpVariableDeps[iVariable], -1L);
+		bSuccess = TakeUnion(&lpBuild->duArticles,
+			&lpGraph->lpVariableDeps[iVariable]);
+	}
+
+	return bSuccess;
+}
+
+/**
+ * Checks if the graph still covers every page and variable of the workspace.
+ *
+ * @param  lpGraph Dependency graph.
+ * @return         TRUE if nothing was added since it was built.
+ */
+BOOL IsGraphCurrent(const DEPGRAPH *lpGraph) {
+	LONG nFirstConfig;
+
+	return (lpGraph->nTemplates == GetUkiTemplatesAvailable()) &&
+		(lpGraph->nVariables == CountUkiVariables(&nFirstConfig));
+}
+
+/**
+ * Finds the pages that mention a name, putting the articles and templates in
+ * their unions.
+ *
+ * @param lpBuild Build scratch space.
+ * @param szaName Name to look for.
+ */
+void FindMentions(DEPBUILD *lpBuild, const char *szaName) {
+	TXTIDX_MATCH *lpMatch;
+	DEPENDENTS dpPage;
+	LONG nMatches;
+	LONG iMatch;
+	LONG nPage;
+
+	// Look the name up in the search index.
+	if (szaName == NULL)
+		return;
+	nMatches = FindWordsInWorkspace(szaName, lpBuild->lpMatches,
+		lpBuild->nMaxMatches);
+
+	// Separate articles from templates.
+	dpPage.nPages = 1L;
+	for (iMatch = 0L; iMatch < nMatches; iMatch++) {
+		lpMatch = &lpBuild->lpMatches[iMatch];
+		nPage = (LONG)lpMatch->nPage;
+		dpPage.lpPages = &nPage;
+
+		AddToUnion((lpMatch->iKind == TXTIDX_ARTICLE) ? &lpBuild->duArticles :
+			&lpBuild->duTemplates, &dpPage);
+	}
+}
+
+/**
+ * Adds pages to a union being built, ignoring duplicates.
+ *
+ * @param lpUnion Union being built.
+ * @param lpDeps  Pages to be added.
+ */
+void AddToUnion(DEPUNION *lpUnion, const DEPENDENTS *lpDeps) {
+	LONG iPage;
+	LONG nPage;
+
+	for (iPage = 0L; iPage < lpDeps->nPages; iPage++) {
+		nPage = lpDeps->lpPages[iPage];
+		if ((nPage < 0L) || (nPage >= lpUnion->nMaxPages) ||
+				lpUnion->lpMarks[nPage]) {
+			continue;
+		}
+
+		lpUnion->lpMarks[nPage] = 1;
+		lpUnion->lpPages[lpUnion->nPages++] = nPage;
+	}
+}
+
+/**
+ * Moves a union being built into a sorted dependents list and resets it.
+ *
+ * @param  lpUnion Union being built.
+ * @param  lpDeps  Dependents list to receive the union.
+ * @return         TRUE if the operation was successful.
+ */
+BOOL TakeUnion(DEPUNION *lpUnion, DEPENDENTS *lpDeps) {
+	LONG iPage;
+
+	// Reset the marks for the next union.
+	for (iPage = 0L; iPage < lpUnion->nPages; iPage++)
+		lpUnion->lpMarks[lpUnion->lpPages[iPage]] = 0;
+
+	// Copy the sorted pages.
+	lpDeps->nPages = lpUnion->nPages;
+	lpDeps->lpPages = NULL;
+	if (lpUnion->nPages > 0L) {
+		qsort(lpUnion->lpPages, lpUnion->nPages, sizeof(LONG), ComparePages);
+
+		lpDeps->lpPages = (LONG*)LocalAlloc(LMEM_FIXED,
+			lpUnion->nPages * sizeof(LONG));
+		if (lpDeps->lpPages == NULL) {
+			lpDeps->nPages = 0L;
+			lpUnion->nPages = 0L;
+
+			return FALSE;
+		}
+		memcpy(lpDeps->lpPages, lpUnion->lpPages,
+			lpUnion->nPages * sizeof(LONG));
+	}
+
+	lpUnion->nPages = 0L;
+	return TRUE;
+}
+
+/**
+ * Adds a page to or removes it from a sorted dependents list.
+ *
+ * @param  lpDeps    Dependents list.
+ * @param  nPage     Page index.
+ * @param  fDepends  Should the page be in the list?
+ * @return           TRUE if the operation was successful.
+ */
+BOOL SetDependent(DEPENDENTS *lpDeps, LONG nPage, BOOL fDepends) {
+	LONG *lpNewPages;
+	LONG lLow;
+	LONG lHigh;
+	LONG lMiddle;
+	BOOL fFound;
+
+	// Find where the page is or should be.
+	lLow = 0L;
+	lHigh = lpDeps->nPages;
+	while (lLow < lHigh) {
+		lMiddle = lLow + ((lHigh - lLow) / 2L);
+		if (lpDeps->lpPages[lMiddle] < nPage) {
+			lLow = lMiddle + 1L;
+		} else {
+			lHigh = lMiddle;
+		}
+	}
+	fFound = (lLow < lpDeps->nPages) && (lpDeps->lpPages[lLow] == nPage);
+
+	// Check if there's anything to be done.
+	if (fFound == (fDepends != FALSE))
+		return TRUE;
+
+	// Take it out.
+	if (fFound) {
+		memmove(lpDeps->lpPages + lLow, lpDeps->lpPages + lLow + 1,
+			(lpDeps->nPages - lLow - 1) * sizeof(LONG));
+		lpDeps->nPages--;
+
+		return TRUE;
+	}
+
+	// Put it in.
+	if (lpDeps->lpPages == NULL) {
+		lpNewPages = (LONG*)LocalAlloc(LMEM_FIXED, sizeof(LONG));
+	} else {
+		lpNewPages = (LONG*)LocalReAlloc(lpDeps->lpPages,
+			(lpDeps->nPages + 1) * sizeof(LONG), LMEM_MOVEABLE);
+	}
+	if (lpNewPages == NULL)
+		return FALSE;
+	memmove(lpNewPages + lLow + 1, lpNewPages + lLow,
+		(lpDeps->nPages - lLow) * sizeof(LONG));
+	lpNewPages[lLow] = nPage;
+	lpDeps->lpPages = lpNewPages;
+	lpDeps->nPages++;
+
+	return TRUE;
+}
+
+/**
+ * Checks if any of the pages in a list is flagged.
+ *
+ * @param  lpDeps  Dependents list.
+ * @param  lpMarks Flags indexed by page.
+ * @return         TRUE if at least one of the pages is flagged.
+ */
+BOOL IsAnyMarked(const DEPENDENTS *lpDeps, const BYTE *lpMarks) {
+	LONG iPage;
+
+	for (iPage = 0L; iPage < lpDeps->nPages; iPage++) {
+		if (lpMarks[lpDeps->lpPages[iPage]])
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * Compares two page indices for qsort.
+ *
+ * @param  lpA First page index.
+ * @param  lpB Second page index.
+ * @return     Negative, zero, or positive, like strcmp.
+ */
+int ComparePages(const void *lpA, const void *lpB) {
+	LONG nA = *(const LONG*)lpA;
+	LONG nB = *(const LONG*)lpB;
+
+	return (nA > nB) - (nA < nB);
+}
+
+/**
+ * Frees an array of dependents lists, or only the pages of a single one when
+ * the number of lists is negative. An empty array still has to be freed.
+ *
+ * @param lpDeps Array of dependents lists, may be NULL.
+ * @param nDeps  Number of lists in the array or -1 for a single list.
+ */
+void FreeDependents(DEPENDENTS *lpDeps, LONG nDeps) {
+	LONG iDep;
+
+	if (lpDeps == NULL)
+		return;
+
+	// Just empty a single list.
+	if (nDeps < 0L) {
+		if (lpDeps->lpPages != NULL)
+			LocalFree(lpDeps->lpPages);
+		lpDeps->lpPages = NULL;
+		lpDeps->nPages = 0L;
+
+		return;
+	}
+
+	for (iDep = 0L; iDep < nDeps; iDep++) {
+		if (lpDeps[iDep].lpPages != NULL)
+			LocalFree(lpDeps[iDep].lpPages);
+	}
+	LocalFree(lpDeps);
+}
+
+/**
+ * Copies a dependents list to a caller buffer.
+ *
+ * @param  lpDeps       Dependents list.
+ * @param  lpArticles   Array to receive the article indices, may be NULL.
+ * @param  nMaxArticles Maximum number of articles to be copied.
+ * @return              Total number of dependent articles.
+ */
+LONG CopyDependents(const DEPENDENTS *lpDeps, LONG *lpArticles,
+					LONG nMaxArticles) {
+	LONG nCopy;
+
+	nCopy = (lpDeps->nPages < nMaxArticles) ? lpDeps->nPages :
+		nMaxArticles;
+	if ((lpArticles != NULL) && (nCopy > 0L))
+		memcpy(lpArticles, lpDeps->lpPages, nCopy * sizeof(LONG));
+
+	return lpDeps->nPages;
+}
+
+/**
+ * Finds a variable in the index.
+ * @remark Must be called with the critical section held.
+ *
+ * @param  szKey Variable key.
+ * @return       Index of the variable or -1 if it isn't known.
+ */
+LONG FindVariable(LPCTSTR szKey) {
+	char szaKey[UKI_MAX_PATH];
+	LONG iVariable;
+
+	// Check if there's anything to look at.
+	if (!fDependenciesReady)
+		return -1L;
+	if (ConvertBufferWtoA(szaKey, UKI_MAX_PATH, szKey, -1) == 0)
+		return -1L;
+
+	// Go through the keys.
+	for (iVariable = 0L; iVariable < dgIndex.nVariables; iVariable++) {
+		if ((dgIndex.lpszaKeys[iVariable] != NULL) &&
+				(strcmp(dgIndex.lpszaKeys[iVariable], szaKey) == 0)) {
+			return iVariable;
+		}
+	}
+
+	return -1L;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+/**
+ * DependencyIndex.h
+ * Keeps track of which articles depend on each template and variable.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _DEPENDENCYINDEX_H
+#define _DEPENDENCYINDEX_H
+
+#include <windows.h>
+
+// Initialization and destruction.
+void InitializeDependencyIndex();
+void DestroyDependencyIndex();
+void ClearDependencyIndex();
+BOOL BuildDependencyIndex();
+BOOL IsDependencyIndexReady();
+
+// Updating.
+BOOL UpdateArticleDependencies(LONG nArticle);
+BOOL UpdateTemplateDependencies(LONG nTemplate);
+
+// Querying.
+LONG GetTemplateDependents(LONG nTemplate, LONG *lpArticles,
+						   LONG nMaxArticles);
+LONG GetVariableDependents(LPCTSTR szKey, LONG *lpArticles,
+						   LONG nMaxArticles);
+
+// Invalidation.
+BOOL InvalidateTemplateDependents(LONG nTemplate);
+
+#endif  // _DEPENDENCYINDEX_H
\ No newline at end of file
@@ -0,0 +1,563 @@
+/**
+ * EditJournal.c
+ * Keeps a journal of the unsaved edits to the open page, so that they can be
+ * recovered if the device resets before they are saved.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "EditJournal.h"
+#include "PageManager.h"
+#include "UkiHelper.h"
+#include "Utilities.h"
+#include "ContentHash.h"
+#include <string.h>
+
+// Types of records in the journal.
+#define JOURNAL_PAGE 1
+#define JOURNAL_EDIT 2
+
+// Number of deleted characters of an edit that replaces the whole text.
+#define JOURNAL_ALL  0xFFFFFFFF
+
+// Number of characters in each hashed block of the last text written, which
+// is also how close to the actual change an edit record gets.
+#define JOURNAL_BLOCK 64
+
+// A single record in the journal, which is followed by cchText characters.
+// Page records have the path of the page as text and the modification time of
+// the file the edits apply to in place of the edit range.
+typedef struct {
+	DWORD dwType;
+	DWORD dwStart;
+	DWORD cchDeleted;
+	DWORD cchText;
+	DWORD dwChecksum;
+} JOURNAL_RECORD;
+
+// Global variables.
+TCHAR szJournalPath[MAX_PATH];
+TCHAR szJournalPage[MAX_PATH];
+FILETIME ftJournalPage;
+BOOL fJournalTracking = FALSE;
+BOOL fJournalStarted;
+DWORD *lpdwJournalHeads = NULL;
+DWORD *lpdwJournalTails = NULL;
+DWORD cchJournalText;
+DWORD dwJournalGeneration;
+
+// Private methods.
+BOOL GetEditJournalPath(LPTSTR szPath);
+BOOL AppendJournalRecord(HANDLE hFile, DWORD dwType, DWORD dwStart,
+						 DWORD cchDeleted, LPCTSTR szText, DWORD cchText);
+DWORD GetJournalChecksum(const JOURNAL_RECORD *lpRecord, LPCTSTR szText);
+BOOL ApplyJournalEdit(LPTSTR *lpszText, DWORD *lpcchText,
+					  const JOURNAL_RECORD *lpRecord, LPCTSTR szText);
+BOOL HashJournalText(LPCTSTR szText, DWORD cchText, DWORD **lplpdwHeads,
+					 DWORD **lplpdwTails);
+void FreeJournalHashes();
+
+/**
+ * Starts tracking a page that was just loaded or saved. Whatever was in the
+ * journal is already on disk, so it's thrown away.
+ *
+ * @param szPagePath   Path to the page file.
+ * @param lpftModified Modification time of the page file.
+ */
+void ResetEditJournal(LPCTSTR szPagePath, const FILETIME *lpftModified) {
+	DiscardEditJournal();
+
+	// Check if the page can be tracked.
+	if ((wcslen(szPagePath) >= MAX_PATH) || !GetEditJournalPath(szJournalPath))
+		return;
+
+	wcscpy(szJournalPage, szPagePath);
+	ftJournalPage = *lpftModified;
+	dwJournalGeneration = GetPageEditGeneration();
+	fJournalTracking = TRUE;
+}
+
+/**
+ * Stops tracking the open page and throws away its journal, since its changes
+ * are either saved or no longer wanted.
+ */
+void DiscardEditJournal() {
+	if (fJournalTracking && fJournalStarted)
+		DeleteFile(szJournalPath);
+
+	FreeJournalHashes();
+	fJournalTracking = FALSE;
+	fJournalStarted = FALSE;
+}
+
+/**
+ * Appends the changes made to the open page since the last time to the
+ * journal. Meant to be called periodically, it does nothing when there
+ * weren't any. Only the hashes of the last text written are kept around, so
+ * an edit covers the blocks that changed rather than exactly what was typed.
+ *
+ * @return TRUE if the journal is up to date.
+ */
+BOOL FlushEditJournal() {
+	HANDLE hFile;
+	LPTSTR szText;
+	DWORD *lpdwHeads;
+	DWORD *lpdwTails;
+	DWORD cchText;
+	DWORD cchCommon;
+	DWORD cchPrefix;
+	DWORD cchSuffix;
+	DWORD cchDeleted;
+	BOOL bSuccess;
+
+	// Check if there's anything new to be written.
+	if (!fJournalTracking || (dwJournalGeneration == GetPageEditGeneration()))
+		return TRUE;
+
+	// The edits were undone back to the text on disk, so there's nothing left
+	// to recover. The next edit starts a new journal.
+	if (!IsPageDirty()) {
+		if (fJournalStarted)
+			DeleteFile(szJournalPath);
+
+		FreeJournalHashes();
+		fJournalStarted = FALSE;
+		dwJournalGeneration = GetPageEditGeneration();
+		return TRUE;
+	}
+
+	// Get the text as it is now.
+	cchText = (DWORD)SendPageEditMessage(WM_GETTEXTLENGTH, 0, 0);
+	szText = (LPTSTR)LocalAlloc(LMEM_FIXED, (cchText + 1) * sizeof(TCHAR));
+	if (szText == NULL)
+		return FALSE;
+	cchText = (DWORD)SendPageEditMessage(WM_GETTEXT, (WPARAM)(cchText + 1),
+		(LPARAM)szText);
+
+	// Hash it, since that's what the next edits will be compared against.
+	if (!HashJournalText(szText, cchText, &lpdwHeads, &lpdwTails)) {
+		LocalFree(szText);
+		return FALSE;
+	}
+
+	// Open the journal, starting it with the page it belongs to.
+	if (!fJournalStarted) {
+		FILETIME ftModified;
+		LPTSTR szFileText;
+		DWORD cchFileText;
+
+		// The first edits are relative to the file as it was loaded, if it's
+		// still the same.
+		FreeJournalHashes();
+		if (GetFileModifiedTime(szJournalPage, &ftModified) &&
+				(CompareFileTime(&ftModified, &ftJournalPage) == 0) &&
+				ReadFileText(szJournalPage, &szFileText, &cchFileText)) {
+			if (HashJournalText(szFileText, cchFileText, &lpdwJournalHeads,
+					&lpdwJournalTails)) {
+				cchJournalText = cchFileText;
+			}
+			LocalFree(szFileText);
+		}
+
+		hFile = CreateFile(szJournalPath, GENERIC_WRITE, 0, NULL,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if ((hFile != INVALID_HANDLE_VALUE) && !AppendJournalRecord(hFile,
+				JOURNAL_PAGE, ftJournalPage.dwLowDateTime,
+				ftJournalPage.dwHighDateTime, szJournalPage,
+				(DWORD)wcslen(szJournalPage))) {
+			CloseHandle(hFile);
+			hFile = INVALID_HANDLE_VALUE;
+		}
+	} else {
+		hFile = CreateFile(szJournalPath, GENERIC_WRITE, 0, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile != INVALID_HANDLE_VALUE)
+			SetFilePointer(hFile, 0, NULL, FILE_END);
+	}
+	if (hFile == INVALID_HANDLE_VALUE) {
+		LocalFree(lpdwHeads);
+		LocalFree(lpdwTails);
+		LocalFree(szText);
+		return FALSE;
+	}
+
+	if (lpdwJournalHeads == NULL) {
+		// Without the previous text the edit has to cover everything.
+		bSuccess = AppendJournalRecord(hFile, JOURNAL_EDIT, 0, JOURNAL_ALL,
+			szText, cchText);
+	} else {
+		// Only the blocks between the ones that are the same at both ends
+		// changed.
+		cchCommon = min(cchText, cchJournalText);
+		cchPrefix = 0;
+		while (((cchPrefix + JOURNAL_BLOCK) <= cchCommon) &&
+				(lpdwHeads[cchPrefix / JOURNAL_BLOCK] ==
+				lpdwJournalHeads[cchPrefix / JOURNAL_BLOCK])) {
+			cchPrefix += JOURNAL_BLOCK;
+		}
+		cchSuffix = 0;
+		while (((cchPrefix + cchSuffix + JOURNAL_BLOCK) <= cchCommon) &&
+				(lpdwTails[cchSuffix / JOURNAL_BLOCK] ==
+				lpdwJournalTails[cchSuffix / JOURNAL_BLOCK])) {
+			cchSuffix += JOURNAL_BLOCK;
+		}
+		cchDeleted = cchJournalText - cchPrefix - cchSuffix;
+
+		bSuccess = AppendJournalRecord(hFile, JOURNAL_EDIT, cchPrefix,
+			cchDeleted, szText + cchPrefix, cchText - cchPrefix - cchSuffix);
+	}
+	bSuccess = bSuccess && FlushFileBuffers(hFile);
+	CloseHandle(hFile);
+
+	// The next edits are relative to this text. After a failure the journal
+	// is started over, since it may end with a partial record.
+	FreeJournalHashes();
+	LocalFree(szText);
+	fJournalStarted = bSuccess;
+	if (bSuccess) {
+		lpdwJournalHeads = lpdwHeads;
+		lpdwJournalTails = lpdwTails;
+		cchJournalText = cchText;
+		dwJournalGeneration = GetPageEditGeneration();
+	} else {
+		LocalFree(lpdwHeads);
+		LocalFree(lpdwTails);
+	}
+
+	return bSuccess;
+}
+
+/**
+ * Reads the journal left behind in the current workspace and replays it to
+ * get back the unsaved text of the page it belongs to. A record that was
+ * only partially written ends the journal.
+ * @remark Remember to free the text with LocalFree.
+ *
+ * @param  szPagePath Buffer with MAX_PATH characters to receive the path to
+ *                    the page file.
+ * @param  lpszText   Pointer to receive the recovered text.
+ * @return            TRUE if there was something to be recovered.
+ */
+BOOL ReadEditJournal(LPTSTR szPagePath, LPTSTR *lpszText) {
+	TCHAR szPath[MAX_PATH];
+	JOURNAL_RECORD jrRecord;
+	FILETIME ftModified;
+	HANDLE hFile;
+	LPTSTR szRecordText;
+	LPTSTR szText;
+	DWORD cchText;
+	DWORD dwBytesRead;
+	LONG nEdits;
+	BOOL fHasPage;
+	BOOL bSuccess;
+
+	// Open the journal.
+	if (!GetEditJournalPath(szPath))
+		return FALSE;
+	hFile = CreateFile(szPath, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	szText = NULL;
+	cchText = 0;
+	nEdits = 0;
+	fHasPage = FALSE;
+	bSuccess = TRUE;
+	for (;;) {
+		// Read the next record.
+		if (!ReadFile(hFile, &jrRecord, sizeof(JOURNAL_RECORD), &dwBytesRead,
+				NULL) || (dwBytesRead != sizeof(JOURNAL_RECORD)) ||
+				(jrRecord.cchText >= 0x7FFFFFFF / sizeof(TCHAR))) {
+			break;
+		}
+		szRecordText = (LPTSTR)LocalAlloc(LMEM_FIXED,
+			(jrRecord.cchText + 1) * sizeof(TCHAR));
+		if (szRecordText == NULL) {
+			bSuccess = FALSE;
+			break;
+		}
+		if (!ReadFile(hFile, szRecordText, jrRecord.cchText * sizeof(TCHAR),
+				&dwBytesRead, NULL) ||
+				(dwBytesRead != (jrRecord.cchText * sizeof(TCHAR))) ||
+				(jrRecord.dwChecksum != GetJournalChecksum(&jrRecord,
+				szRecordText))) {
+			LocalFree(szRecordText);
+			break;
+		}
+		szRecordText[jrRecord.cchText] = L'\0';
+
+		if (nEdits < 0) {
+			// Anything after a bad edit can't be trusted.
+		} else if (jrRecord.dwType == JOURNAL_PAGE) {
+			// Only the first record tells which page this is.
+			if (fHasPage || (jrRecord.cchText >= MAX_PATH)) {
+				nEdits = -1;
+			} else {
+				wcscpy(szPagePath, szRecordText);
+				ftModified.dwLowDateTime = jrRecord.dwStart;
+				ftModified.dwHighDateTime = jrRecord.cchDeleted;
+				fHasPage = TRUE;
+			}
+		} else if (!fHasPage) {
+			nEdits = -1;
+		} else if (jrRecord.dwType == JOURNAL_EDIT) {
+			// Start from the file the edits were made to, unless the first
+			// edit replaces everything in it.
+			if ((nEdits == 0) && (jrRecord.cchDeleted != JOURNAL_ALL)) {
+				FILETIME ftCurrent;
+
+				if (!GetFileModifiedTime(szPagePath, &ftCurrent) ||
+						(CompareFileTime(&ftCurrent, &ftModified) != 0) ||
+						!ReadFileText(szPagePath, &szText, &cchText)) {
+					szText = NULL;
+					nEdits = -1;
+				}
+			}
+
+			// Replay the edit.
+			if (nEdits >= 0) {
+				if (ApplyJournalEdit(&szText, &cchText, &jrRecord,
+						szRecordText)) {
+					nEdits++;
+				} else {
+					nEdits = -1;
+				}
+			}
+		} else {
+			nEdits = -1;
+		}
+
+		LocalFree(szRecordText);
+	}
+	CloseHandle(hFile);
+
+	// Check if we got anything out of it.
+	if (!bSuccess || (nEdits <= 0)) {
+		if (szText != NULL)
+			LocalFree(szText);
+
+		return FALSE;
+	}
+
+	*lpszText = szText;
+	return TRUE;
+}
+
+/**
+ * Deletes the journal left behind in the current workspace.
+ */
+void DeleteEditJournal() {
+	TCHAR szPath[MAX_PATH];
+
+	if (GetEditJournalPath(szPath))
+		DeleteFile(szPath);
+}
+
+/**
+ * Gets the path to the journal file of the current workspace.
+ *
+ * @param  szPath Buffer with MAX_PATH characters to receive the path.
+ * @return        TRUE if there's a workspace open.
+ */
+BOOL GetEditJournalPath(LPTSTR szPath) {
+	LPCTSTR szRoot;
+	size_t nLen;
+
+	// The journal lives next to the manifest in the workspace root.
+	szRoot = GetCurrentWorkspace();
+	nLen = wcslen(szRoot);
+	if ((nLen == 0) || ((nLen + wcslen(EDIT_JOURNAL_FILE) + 1) >= MAX_PATH))
+		return FALSE;
+
+	wcscpy(szPath, szRoot);
+	if (szPath[nLen - 1] != L'\\')
+		wcscat(szPath, L"\\");
+	wcscat(szPath, EDIT_JOURNAL_FILE);
+
+	return TRUE;
+}
+
+/**
+ * Writes a record to the end of the journal.
+ *
+ * @param  hFile      Journal file handle.
+ * @param  dwType     Type of the record.
+ * @param  dwStart    Position where the edit starts.
+ * @param  cchDeleted Number of characters removed by the edit.
+ * @param  szText     Text of the record.
+ * @param  cchText    Length of the text of the record.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL AppendJournalRecord(HANDLE hFile, DWORD dwType, DWORD dwStart,
+						 DWORD cchDeleted, LPCTSTR szText, DWORD cchText) {
+	JOURNAL_RECORD jrRecord;
+	DWORD dwBytesWritten;
+
+	// Build the header.
+	jrRecord.dwType = dwType;
+	jrRecord.dwStart = dwStart;
+	jrRecord.cchDeleted = cchDeleted;
+	jrRecord.cchText = cchText;
+	jrRecord.dwChecksum = GetJournalChecksum(&jrRecord, szText);
+
+	// Write it along with the text.
+	if (!WriteFile(hFile, &jrRecord, sizeof(JOURNAL_RECORD), &dwBytesWritten,
+			NULL) || (dwBytesWritten != sizeof(JOURNAL_RECORD))) {
+		return FALSE;
+	}
+	if (cchText == 0)
+		return TRUE;
+
+	return WriteFile(hFile, szText, cchText * sizeof(TCHAR), &dwBytesWritten,
+		NULL) && (dwBytesWritten == (cchText * sizeof(TCHAR)));
+}
+
+/**
+ * Calculates the FNV-1a checksum of a record, which catches the ones that
+ * were only partially written when the device went down.
+ *
+ * @param  lpRecord Record header. Its checksum field isn't included.
+ * @param  szText   Text of the record.
+ * @return          Checksum of the record.
+ */
+DWORD GetJournalChecksum(const JOURNAL_RECORD *lpRecord, LPCTSTR szText) {
+	DWORD adwFields[4];
+	const BYTE *lpData;
+	DWORD dwHash;
+	DWORD cbData;
+	DWORD iByte;
+
+	adwFields[0] = lpRecord->dwType;
+	adwFields[1] = lpRecord->dwStart;
+	adwFields[2] = lpRecord->cchDeleted;
+	adwFields[3] = lpRecord->cchText;
+
+	// Header fields.
+	dwHash = 2166136261UL;
+	lpData = (const BYTE*)adwFields;
+	for (iByte = 0; iByte < sizeof(adwFields); iByte++)
+		dwHash = (dwHash ^ lpData[iByte]) * 16777619UL;
+
+	// Text.
+	lpData = (const BYTE*)szText;
+	cbData = lpRecord->cchText * sizeof(TCHAR);
+	for (iByte = 0; iByte < cbData; iByte++)
+		dwHash = (dwHash ^ lpData[iByte]) * 16777619UL;
+
+	return dwHash;
+}
+
+/**
+ * Replays an edit record on a text.
+ *
+ * @param  lpszText  Pointer to the text, which gets reallocated. Can point to
+ *                   NULL when the edit replaces everything.
+ * @param  lpcchText Pointer to the length of the text.
+ * @param  lpRecord  Edit record.
+ * @param  szText    Text inserted by the edit.
+ * @return           TRUE if the edit fits the text.
+ */
+BOOL ApplyJournalEdit(LPTSTR *lpszText, DWORD *lpcchText,
+					  const JOURNAL_RECORD *lpRecord, LPCTSTR szText) {
+	LPTSTR szNew;
+	DWORD cchDeleted;
+	DWORD cchNew;
+
+	// Check if the edit is within the text.
+	cchDeleted = lpRecord->cchDeleted;
+	if (cchDeleted == JOURNAL_ALL) {
+		if (lpRecord->dwStart != 0)
+			return FALSE;
+
+		cchDeleted = *lpcchText;
+	}
+	if ((lpRecord->dwStart > *lpcchText) ||
+			(cchDeleted > (*lpcchText - lpRecord->dwStart))) {
+		return FALSE;
+	}
+
+	// Put together the new text.
+	cchNew = *lpcchText - cchDeleted + lpRecord->cchText;
+	szNew = (LPTSTR)LocalAlloc(LMEM_FIXED, (cchNew + 1) * sizeof(TCHAR));
+	if (szNew == NULL)
+		return FALSE;
+	if (lpRecord->dwStart > 0)
+		memcpy(szNew, *lpszText, lpRecord->dwStart * sizeof(TCHAR));
+	memcpy(szNew + lpRecord->dwStart, szText,
+		lpRecord->cchText * sizeof(TCHAR));
+	memcpy(szNew + lpRecord->dwStart + lpRecord->cchText,
+		*lpszText + lpRecord->dwStart + cchDeleted,
+		(*lpcchText - lpRecord->dwStart - cchDeleted) * sizeof(TCHAR));
+	szNew[cchNew] = L'\0';
+
+	// Swap it with the old one.
+	if (*lpszText != NULL)
+		LocalFree(*lpszText);
+	*lpszText = szNew;
+	*lpcchText = cchNew;
+
+	return TRUE;
+}
+
+/**
+ * Hashes a text in blocks counted from its start and from its end, which is
+ * enough to tell which part of it a later text changed without keeping a copy
+ * of it around. A partial block at either end is never hashed.
+ * @remark Remember to free both hash arrays with LocalFree.
+ *
+ * @param  szText      Text to be hashed.
+ * @param  cchText     Length of the text.
+ * @param  lplpdwHeads Pointer to receive the hashes of the blocks from the
+ *                     start of the text.
+ * @param  lplpdwTails Pointer to receive the hashes of the blocks from the end
+ *                     of the text.
+ * @return             TRUE if the operation was successful.
+ */
+BOOL HashJournalText(LPCTSTR szText, DWORD cchText, DWORD **lplpdwHeads,
+					 DWORD **lplpdwTails) {
+	DWORD nBlocks;
+	DWORD iBlock;
+
+	// Allocate the hashes.
+	nBlocks = cchText / JOURNAL_BLOCK;
+	*lplpdwHeads = (DWORD*)LocalAlloc(LMEM_FIXED,
+		(nBlocks + 1) * sizeof(DWORD));
+	*lplpdwTails = (DWORD*)LocalAlloc(LMEM_FIXED,
+		(nBlocks + 1) * sizeof(DWORD));
+	if ((*lplpdwHeads == NULL) || (*lplpdwTails == NULL)) {
+		if (*lplpdwHeads != NULL)
+			LocalFree(*lplpdwHeads);
+		if (*lplpdwTails != NULL)
+			LocalFree(*lplpdwTails);
+
+		*lplpdwHeads = NULL;
+		*lplpdwTails = NULL;
+		return FALSE;
+	}
+
+	// Hash every whole block from both ends.
+	for (iBlock = 0; iBlock < nBlocks; iBlock++) {
+		(*lplpdwHeads)[iBlock] = (DWORD)ContentHashBuffer(
+			szText + (iBlock * JOURNAL_BLOCK), JOURNAL_BLOCK * sizeof(TCHAR));
+		(*lplpdwTails)[iBlock] = (DWORD)ContentHashBuffer(
+			szText + cchText - ((iBlock + 1) * JOURNAL_BLOCK),
+			JOURNAL_BLOCK * sizeof(TCHAR));
+	}
+
+	return TRUE;
+}
+
+/**
+ * Frees the hashes of the text the next edits are relative to.
+ */
+void FreeJournalHashes() {
+	if (lpdwJournalHeads != NULL)
+		LocalFree(lpdwJournalHeads);
+	if (lpdwJournalTails != NULL)
+		LocalFree(lpdwJournalTails);
+
+	lpdwJournalHeads = NULL;
+	lpdwJournalTails = NULL;
+	cchJournalText = 0;
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+/**
+ * EditJournal.h
+ * Keeps a journal of the unsaved edits to the open page, so that they can be
+ * recovered if the device resets before they are saved.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _EDITJOURNAL_H
+#define _EDITJOURNAL_H
+
+#include <windows.h>
+
+// Name of the journal file in the root of the workspace.
+#define EDIT_JOURNAL_FILE L"MANIFEST.jnl"
+
+// Minimum time between journal writes in milliseconds.
+#define EDIT_JOURNAL_INTERVAL 2000
+
+// Tracking the open page.
+void ResetEditJournal(LPCTSTR szPagePath, const FILETIME *lpftModified);
+void DiscardEditJournal();
+
+// Journaling.
+BOOL FlushEditJournal();
+
+// Recovery.
+BOOL ReadEditJournal(LPTSTR szPagePath, LPTSTR *lpszText);
+void DeleteEditJournal();
+
+#endif  // _EDITJOURNAL_H
\ No newline at end of file
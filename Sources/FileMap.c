@@ -0,0 +1,215 @@
+/**
+ * FileMap.c
+ * A platform-neutral read-only view of a whole file, which is memory-mapped
+ * when the file is large enough and read into memory otherwise.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "FileMap.h"
+#include <stdlib.h>
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+// Private methods.
+void FileMapInitialize(FILEMAP *lpMap);
+int FileMapMapView(FILEMAP *lpMap, FILEMAP_PATH szPath);
+int FileMapReadAll(FILEMAP *lpMap);
+
+/**
+ * Opens a view of a whole file.
+ * @remark Remember to close the view with FileMapClose.
+ *
+ * @param  lpMap       View to be opened.
+ * @param  szPath      Path to the file.
+ * @param  cbMinMapped Size from which the file gets mapped instead of read.
+ * @return             1 if the file could be opened, 0 otherwise.
+ */
+int FileMapOpen(FILEMAP *lpMap, FILEMAP_PATH szPath, size_t cbMinMapped) {
+#ifdef _WIN32
+	DWORD dwSize;
+#else
+	struct stat stFile;
+#endif
+
+	FileMapInitialize(lpMap);
+
+	// Open the file and get its size.
+#ifdef _WIN32
+	lpMap->hFile = CreateFile(szPath, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (lpMap->hFile == INVALID_HANDLE_VALUE)
+		return 0;
+	dwSize = GetFileSize(lpMap->hFile, NULL);
+	if (dwSize == 0xFFFFFFFF) {
+		FileMapClose(lpMap);
+		return 0;
+	}
+	lpMap->cbData = (size_t)dwSize;
+#else
+	lpMap->fd = open(szPath, O_RDONLY);
+	if (lpMap->fd < 0)
+		return 0;
+	if (fstat(lpMap->fd, &stFile) != 0) {
+		FileMapClose(lpMap);
+		return 0;
+	}
+	lpMap->cbData = (size_t)stFile.st_size;
+#endif
+
+	// Empty files have nothing to be mapped.
+	if (lpMap->cbData == 0) {
+		lpMap->lpData = "";
+		return 1;
+	}
+
+	// Map large files, falling back to reading them if it isn't supported.
+	if ((lpMap->cbData >= cbMinMapped) && FileMapMapView(lpMap, szPath))
+		return 1;
+	if (!FileMapReadAll(lpMap)) {
+		FileMapClose(lpMap);
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Closes a view of a file.
+ *
+ * @param lpMap View to be closed.
+ */
+void FileMapClose(FILEMAP *lpMap) {
+#ifdef _WIN32
+	if (lpMap->fMapped)
+		UnmapViewOfFile((LPVOID)lpMap->lpData);
+	if (lpMap->hMapping != NULL)
+		CloseHandle(lpMap->hMapping);
+	if (lpMap->hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(lpMap->hFile);
+#else
+	if (lpMap->fMapped)
+		munmap((void*)lpMap->lpData, lpMap->cbData);
+	if (lpMap->fd >= 0)
+		close(lpMap->fd);
+#endif
+	free(lpMap->lpBuffer);
+
+	FileMapInitialize(lpMap);
+}
+
+/**
+ * Puts a view in its closed state.
+ *
+ * @param lpMap View to be initialized.
+ */
+void FileMapInitialize(FILEMAP *lpMap) {
+	lpMap->lpData = NULL;
+	lpMap->cbData = 0;
+	lpMap->fMapped = 0;
+	lpMap->lpBuffer = NULL;
+#ifdef _WIN32
+	lpMap->hFile = INVALID_HANDLE_VALUE;
+	lpMap->hMapping = NULL;
+#else
+	lpMap->fd = -1;
+#endif
+}
+
+/**
+ * Maps the whole file into memory.
+ *
+ * @param  lpMap  View with the file open.
+ * @param  szPath Path to the file.
+ * @return        1 if the file was mapped, 0 otherwise.
+ */
+int FileMapMapView(FILEMAP *lpMap, FILEMAP_PATH szPath) {
+#ifdef _WIN32
+	HANDLE hMappable;
+
+	// Windows CE can only map files that were opened specifically for it.
+#ifdef UNDER_CE
+	hMappable = CreateFileForMapping(szPath, GENERIC_READ, FILE_SHARE_READ,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hMappable == INVALID_HANDLE_VALUE)
+		return 0;
+#else
+	hMappable = lpMap->hFile;
+	(void)szPath;
+#endif
+
+	// Map it.
+	lpMap->hMapping = CreateFileMapping(hMappable, NULL, PAGE_READONLY, 0, 0,
+		NULL);
+#ifdef UNDER_CE
+	CloseHandle(hMappable);
+#endif
+	if (lpMap->hMapping == NULL)
+		return 0;
+	lpMap->lpData = (const char*)MapViewOfFile(lpMap->hMapping, FILE_MAP_READ,
+		0, 0, 0);
+	if (lpMap->lpData == NULL) {
+		CloseHandle(lpMap->hMapping);
+		lpMap->hMapping = NULL;
+
+		return 0;
+	}
+#else
+	void *lpView;
+
+	// The file is already open, so the path isn't needed here.
+	(void)szPath;
+	lpView = mmap(NULL, lpMap->cbData, PROT_READ, MAP_PRIVATE, lpMap->fd, 0);
+	if (lpView == MAP_FAILED)
+		return 0;
+	lpMap->lpData = (const char*)lpView;
+#endif
+
+	lpMap->fMapped = 1;
+	return 1;
+}
+
+/**
+ * Reads the whole file into memory.
+ *
+ * @param  lpMap View with the file open.
+ * @return       1 if the file was read, 0 otherwise.
+ */
+int FileMapReadAll(FILEMAP *lpMap) {
+	size_t cbRead;
+#ifdef _WIN32
+	DWORD dwBytesRead;
+#else
+	ssize_t nBytesRead;
+#endif
+
+	lpMap->lpBuffer = (char*)malloc(lpMap->cbData);
+	if (lpMap->lpBuffer == NULL)
+		return 0;
+
+	// Read until we have all of it.
+	cbRead = 0;
+	while (cbRead < lpMap->cbData) {
+#ifdef _WIN32
+		if (!ReadFile(lpMap->hFile, lpMap->lpBuffer + cbRead,
+				(DWORD)(lpMap->cbData - cbRead), &dwBytesRead, NULL) ||
+				(dwBytesRead == 0)) {
+			return 0;
+		}
+		cbRead += dwBytesRead;
+#else
+		nBytesRead = read(lpMap->fd, lpMap->lpBuffer + cbRead,
+			lpMap->cbData - cbRead);
+		if (nBytesRead <= 0)
+			return 0;
+		cbRead += (size_t)nBytesRead;
+#endif
+	}
+
+	lpMap->lpData = lpMap->lpBuffer;
+	return 1;
+}
\ No newline at end of file
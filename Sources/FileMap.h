@@ -0,0 +1,45 @@
+/**
+ * FileMap.h
+ * A platform-neutral read-only view of a whole file, which is memory-mapped
+ * when the file is large enough and read into memory otherwise.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _FILEMAP_H
+#define _FILEMAP_H
+
+#include <stddef.h>
+#ifdef _WIN32
+	#include <windows.h>
+#endif
+
+// Files smaller than this are usually cheaper to read than to map.
+#define FILEMAP_MIN_MAPPED (64 * 1024)
+
+// Paths are in the native character type of the platform.
+#ifdef _WIN32
+typedef const TCHAR *FILEMAP_PATH;
+#else
+typedef const char *FILEMAP_PATH;
+#endif
+
+// View of a file.
+typedef struct {
+	const char *lpData;
+	size_t cbData;
+	int fMapped;
+	char *lpBuffer;
+#ifdef _WIN32
+	HANDLE hFile;
+	HANDLE hMapping;
+#else
+	int fd;
+#endif
+} FILEMAP;
+
+// Opening and closing.
+int FileMapOpen(FILEMAP *lpMap, FILEMAP_PATH szPath, size_t cbMinMapped);
+void FileMapClose(FILEMAP *lpMap);
+
+#endif  // _FILEMAP_H
\ No newline at end of file
@@ -9,10 +9,24 @@
 #include <ctype.h>
 #include "FindReplace.h"
 #include "PageManager.h"
+#include "TextSearch.h"
+#include "Regex.h"
+#include "UkiHelper.h"
+#include "WorkspaceLoader.h"
+#include "WorkspaceReplace.h"
+#include "WorkspaceSearch.h"
 #include "resource.h"
 
 // Constants.
-#define MAX_FIND_STRLEN 100
+#define MAX_FIND_STRLEN    100
+#define MAX_CAPTION_STRLEN 50
+#define MAX_PREVIEW_FILES  10
+#define MAX_PREVIEW_STRLEN 1024
+#define MAX_WORKSPACE_PAGES 100
+
+// Incremental search.
+#define IDT_INCREMENTAL_FIND    1
+#define INCREMENTAL_FIND_DELAY  150
 
 // Global variables.
 HINSTANCE hInst;
@@ -23,12 +37,46 @@ TCHAR szNeedle[MAX_FIND_STRLEN + 1];
 TCHAR szReplacement[MAX_FIND_STRLEN + 1];
 int fDirection;
 BOOL fMatchCase;
+BOOL fRegex;
 BOOL fCanFindNext;
+TCHAR szDialogCaption[MAX_CAPTION_STRLEN + 1];
+size_t *lpMatches;
+size_t *lpMatchEnds;
+long nMatches;
+BOOL fMatchesValid;
+DWORD dwMatchesGeneration;
+TCHAR szMatchesNeedle[MAX_FIND_STRLEN + 1];
+BOOL fMatchesCase;
+BOOL fMatchesRegex;
+REGEX reNeedle;
+BOOL fNeedleCompiled;
+TCHAR szCompiledNeedle[MAX_FIND_STRLEN + 1];
+BOOL fCompiledCase;
+LPTSTR szHaystack;
+size_t cchHaystack;
+DWORD dwHaystackGeneration;
+DWORD dwIncrementalAnchor;
+TXTIDX_MATCH amWorkspacePages[MAX_WORKSPACE_PAGES];
+LONG nWorkspacePages;
+LONG iWorkspacePage;
+TCHAR szWorkspaceNeedle[MAX_FIND_STRLEN + 1];
 
 // Private methods.
-LONG FindNext(LPTSTR szHaystack, LONG nCursorPos);
+BOOL UpdateMatchSet();
+void ClearMatchSet();
+LPCTSTR GetHaystack(size_t *lpcchHaystack);
+void ReleaseHaystack();
+BOOL IncrementalFind(HWND hWnd);
+BOOL CompileNeedle();
+LPCTSTR GetRegexErrorMessage(int nError);
+BOOL ReplaceSelectedMatch();
+void ShowMatchPosition(long iMatch);
+void ShowNotFoundMessage();
+void SetDialogHandle(HWND hWnd);
 BOOL SetFindNextState(HWND hWnd);
 UINT SaveNeedleText(HWND hWnd);
+BOOL FindInAllArticles(HWND hWnd);
+BOOL ShowWorkspacePages(HWND hWnd);
 BOOL DlgFindInit(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam);
 BOOL DlgFindCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam);
 BOOL CALLBACK FindDialogProc(HWND hWnd, UINT wMsg, WPARAM wParam,
@@ -36,6 +84,7 @@ BOOL CALLBACK FindDialogProc(HWND hWnd, UINT wMsg, WPARAM wParam,
 BOOL SetFindNextReplaceState(HWND hWnd);
 UINT SaveReplacementText(HWND hWnd);
 BOOL PrepareReplaceNext(BOOL fSelectAll);
+BOOL ReplaceInAllArticles(HWND hWnd);
 BOOL DlgReplaceInit(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam);
 BOOL DlgReplaceCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam);
 BOOL CALLBACK ReplaceDialogProc(HWND hWnd, UINT wMsg, WPARAM wParam,
@@ -60,7 +109,19 @@ BOOL InitializeFindReplace(HINSTANCE hParentInst, HWND hParentWindow,
 	szNeedle[0] = L'\0';
 	fDirection = IDC_RADIOFINDDOWN;
 	fMatchCase = FALSE;
+	fRegex = FALSE;
 	fCanFindNext = FALSE;
+	hwndDialog = NULL;
+
+	// Match set and compiled expression.
+	lpMatches = NULL;
+	lpMatchEnds = NULL;
+	nMatches = 0L;
+	fMatchesValid = FALSE;
+	fNeedleCompiled = FALSE;
+	szHaystack = NULL;
+	cchHaystack = 0;
+	nWorkspacePages = 0L;
 
 	return TRUE;
 }
@@ -73,52 +134,52 @@ BOOL InitializeFindReplace(HINSTANCE hParentInst, HWND hParentWindow,
  * @return          TRUE if we found something.
  */
 BOOL PageEditFindNext(BOOL fShowMsg) {
-	LPTSTR szHaystack;
-	LONG nTextLen;
-	LONG nCursorPos;
-	size_t nNeedleLen;
-	int fCachedDirection = fDirection;
-	BOOL bSuccess = FALSE;
+	DWORD dwSelStart;
+	DWORD dwSelEnd;
+	long iMatch;
 
-	// Allocate memory for the haystack and get the text.
-	nTextLen = SendPageEditMessage(WM_GETTEXTLENGTH, 0, 0) + 1;
-	szHaystack = LocalAlloc(LMEM_FIXED, (nTextLen + 1) * sizeof(TCHAR));
-	SendPageEditMessage(WM_GETTEXT, (WPARAM)nTextLen, (LPARAM)szHaystack);
+	// Make sure we know where every occurence is.
+	if (!UpdateMatchSet())
+		return FALSE;
 
-	// Get current cursor position and needle length.
-	SendPageEditMessage(EM_GETSEL, (WPARAM)NULL, (LPARAM)&nCursorPos);
-	nNeedleLen = wcslen(szNeedle);
+	// Get the current selection.
+	SendPageEditMessage(EM_GETSEL, (WPARAM)&dwSelStart, (LPARAM)&dwSelEnd);
 
 	// Respect the direction chosen.
-	if (fDirection == IDC_RADIOFINDANY) {
-		nCursorPos = 0;
-		fDirection = IDC_RADIOFINDDOWN;
+	switch (fDirection) {
+	case IDC_RADIOFINDUP:
+		iMatch = TextSearchPreviousMatch(lpMatches, nMatches,
+			(size_t)dwSelStart);
+		break;
+	case IDC_RADIOFINDANY:
+		iMatch = TextSearchNextMatch(lpMatches, nMatches, 0);
+		break;
+	default:
+		iMatch = TextSearchNextMatch(lpMatches, nMatches, (size_t)dwSelEnd);
+		break;
 	}
 
-	// Find occurence.
-	nCursorPos = FindNext(szHaystack, nCursorPos);
-	if (nCursorPos >= 0L) {
-		// Select the text.
-		ShowPageEditor();
-		SendPageEditMessage(EM_SETSEL, (WPARAM)nCursorPos,
-			(LPARAM)(nCursorPos + nNeedleLen));
-		bSuccess = TRUE;
-	} else {
-		// Show not found message.
-		if (fShowMsg) {
-			TCHAR szMsg[MAX_FIND_STRLEN + 21];
-			wsprintf(szMsg, L"Cannot find \"%s\".", szNeedle);
-			MessageBox(NULL, szMsg, L"Not Found", MB_OK | MB_ICONEXCLAMATION);
-		}
+	// Check if we found anything.
+	if (iMatch < 0L) {
+		ShowMatchPosition(-1L);
+		if (fShowMsg)
+			ShowNotFoundMessage();
 
-		// Reset the direction flag in case it was in Any before.
-		fDirection = fCachedDirection;
-		bSuccess = FALSE;
+		return FALSE;
 	}
 
-	// Clean up and return.
-	LocalFree(szHaystack);
-	return bSuccess;
+	// Following searches continue from the cursor.
+	if (fDirection == IDC_RADIOFINDANY)
+		fDirection = IDC_RADIOFINDDOWN;
+
+	// Select the text.
+	ShowPageEditor();
+	SendPageEditMessage(EM_SETSEL, (WPARAM)lpMatches[iMatch],
+		(LPARAM)((lpMatchEnds != NULL) ? lpMatchEnds[iMatch] :
+		(lpMatches[iMatch] + wcslen(szNeedle))));
+	ShowMatchPosition(iMatch);
+
+	return TRUE;
 }
 
 /**
@@ -131,6 +192,10 @@ BOOL PageEditFindNext(BOOL fShowMsg) {
 BOOL PageEditReplaceNext(BOOL fShowMsg) {
 	// Find something first.
 	if (PageEditFindNext(fShowMsg)) {
+		// Expressions may refer to the groups of the match.
+		if (fRegex)
+			return ReplaceSelectedMatch();
+
 		// Replace selection.
 		SendPageEditMessage(EM_REPLACESEL, (WPARAM)TRUE, (LPARAM)szReplacement);
 		return TRUE;
@@ -145,67 +210,411 @@ BOOL PageEditReplaceNext(BOOL fShowMsg) {
  * @return TRUE if we found something.
  */
 BOOL PageEditReplaceAll() {
-	// Do a first replace and check if it was successful.
-	if (!PageEditReplaceNext(TRUE))
+	TXTSRCH_REPLACE trReplace;
+	LPTSTR szHaystack;
+	LONG nTextLen;
+	DWORD dwCursorPos;
+	long nReplaced;
+
+	// Make sure the expression is valid before doing anything.
+	if (fRegex && !CompileNeedle())
 		return FALSE;
 
-	// Go replacing until we can't
-	while (PageEditReplaceNext(FALSE)) {
-		continue;
+	// Allocate memory for the haystack and get the text.
+	nTextLen = SendPageEditMessage(WM_GETTEXTLENGTH, 0, 0);
+	szHaystack = LocalAlloc(LMEM_FIXED, (nTextLen + 1) * sizeof(TCHAR));
+	if (szHaystack == NULL)
+		return FALSE;
+	nTextLen = SendPageEditMessage(WM_GETTEXT, (WPARAM)(nTextLen + 1),
+		(LPARAM)szHaystack);
+
+	// Start from the cursor unless we were asked to go through everything.
+	dwCursorPos = 0;
+	if (fDirection != IDC_RADIOFINDANY)
+		SendPageEditMessage(EM_GETSEL, (WPARAM)&dwCursorPos, (LPARAM)NULL);
+
+	// Replace everything in a single pass.
+	if (fRegex) {
+		nReplaced = RegexReplaceAll(&reNeedle, szHaystack, (size_t)nTextLen,
+			(size_t)dwCursorPos, szReplacement, wcslen(szReplacement),
+			&trReplace);
+	} else {
+		nReplaced = TextSearchReplaceAll(szHaystack, (size_t)nTextLen,
+			(size_t)dwCursorPos, szNeedle, wcslen(szNeedle), szReplacement,
+			wcslen(szReplacement), fMatchCase, &trReplace);
 	}
+	LocalFree(szHaystack);
+	if (nReplaced < 0L) {
+		MessageBox(NULL, L"Not enough memory to replace the text.",
+			L"Replace All Failed", MB_OK | MB_ICONERROR);
+		return FALSE;
+	} else if (nReplaced == 0L) {
+		ShowNotFoundMessage();
+		return FALSE;
+	}
+
+	// Swap the whole changed part of the text in a single undoable operation.
+	ShowPageEditor();
+	SendPageEditMessage(EM_SETSEL, (WPARAM)trReplace.nStart,
+		(LPARAM)trReplace.nEnd);
+	SendPageEditMessage(EM_REPLACESEL, (WPARAM)TRUE,
+		(LPARAM)trReplace.szResult);
+	TextSearchFreeReplace(&trReplace);
+
+	// Following searches continue from the cursor.
+	if (fDirection == IDC_RADIOFINDANY)
+		fDirection = IDC_RADIOFINDDOWN;
 
 	return TRUE;
 }
 
 /**
- * Finds the next occurence of a needle in a haystack after the cursor position.
+ * Tells the user that the needle couldn't be found.
+ */
+void ShowNotFoundMessage() {
+	TCHAR szMsg[MAX_FIND_STRLEN + 21];
+
+	wsprintf(szMsg, L"Cannot find \"%s\".", szNeedle);
+	MessageBox(NULL, szMsg, L"Not Found", MB_OK | MB_ICONEXCLAMATION);
+}
+
+/**
+ * Makes sure the match set has every occurence of the current needle in the
+ * current text of the page editor. It's only built again when the needle, the
+ * case option, or the text changes.
  *
- * @param  szHaystack Haystack to find the needle in.
- * @param  nCursorPos Starting cursor position.
- * @return            Cursor position of the next occurence or -1 in case of
- *                    failure.
- */
-LONG FindNext(LPTSTR szHaystack, LONG nCursorPos) {
-	LPTSTR szLocalNeedle;
-	LPTSTR lpLocalNeedle;
-	LPTSTR lpHaystack = szHaystack;
-	LPTSTR lpFound;
-	LONG nPos;
-
-	// Convert everything to uppercase if we want a case insensitive search.
-	if (!fMatchCase) {
-		// Allocate space for string.
-		szLocalNeedle = (LPTSTR)LocalAlloc(LMEM_FIXED, (wcslen(szNeedle) + 1) *
-			sizeof(TCHAR));
-		lpLocalNeedle = szLocalNeedle;
-
-		// Copy needle string and convert to uppercase.
-		wcscpy(szLocalNeedle, szNeedle);
-		for ( ; *lpLocalNeedle; lpLocalNeedle++)
-			*lpLocalNeedle = towupper(*lpLocalNeedle);
-
-		// Convert haystack string to uppercase.
-		for ( ; *lpHaystack; lpHaystack++)
-			*lpHaystack = towupper(*lpHaystack);
+ * @return TRUE if the match set is up to date.
+ */
+BOOL UpdateMatchSet() {
+	LPCTSTR szText;
+	size_t cchText;
+	size_t cchPrefix;
+
+	// Check if the one we have is still good.
+	if (fMatchesValid && (dwMatchesGeneration == GetPageEditGeneration()) &&
+			(fMatchesCase == fMatchCase) && (fMatchesRegex == fRegex) &&
+			(wcscmp(szMatchesNeedle, szNeedle) == 0)) {
+		return TRUE;
+	}
+
+	// Make sure the expression is valid.
+	if (fRegex && !CompileNeedle()) {
+		ClearMatchSet();
+		return FALSE;
+	}
+
+	// Get the text.
+	szText = GetHaystack(&cchText);
+	if (szText == NULL) {
+		ClearMatchSet();
+		return FALSE;
+	}
+
+	// When the needle was just typed further we only need to look at where
+	// the previous one was.
+	cchPrefix = wcslen(szMatchesNeedle);
+	if (fMatchesValid && (dwMatchesGeneration == GetPageEditGeneration()) &&
+			(fMatchesCase == fMatchCase) && !fMatchesRegex && !fRegex &&
+			(cchPrefix > 0) && (wcslen(szNeedle) > cchPrefix) &&
+			(wcsncmp(szMatchesNeedle, szNeedle, cchPrefix) == 0)) {
+		nMatches = TextSearchNarrowMatches(szText, cchText, lpMatches,
+			nMatches, cchPrefix, szNeedle, wcslen(szNeedle), fMatchCase);
+		wcscpy(szMatchesNeedle, szNeedle);
+		if (hwndDialog == NULL)
+			ReleaseHaystack();
+
+		return TRUE;
+	}
+	ClearMatchSet();
+
+	// Find every occurence in a single pass. Empty matches can't be selected,
+	// so they are left out.
+	if (fRegex) {
+		nMatches = RegexFindAll(&reNeedle, szText, cchText, 0, TRUE,
+			&lpMatches, &lpMatchEnds);
 	} else {
-		szLocalNeedle = szNeedle;
+		nMatches = TextSearchFindAll(szText, cchText, 0, szNeedle,
+			wcslen(szNeedle), fMatchCase, &lpMatches);
+	}
+
+	// Only hold on to a copy of the text while a dialog is searching it.
+	if (hwndDialog == NULL)
+		ReleaseHaystack();
+	if (nMatches < 0L) {
+		nMatches = 0L;
+		MessageBox(NULL, L"Not enough memory to search the text.",
+			L"Find Failed", MB_OK | MB_ICONERROR);
+		return FALSE;
+	}
+
+	// Remember what it was built for.
+	wcscpy(szMatchesNeedle, szNeedle);
+	fMatchesCase = fMatchCase;
+	fMatchesRegex = fRegex;
+	dwMatchesGeneration = GetPageEditGeneration();
+	fMatchesValid = TRUE;
+
+	return TRUE;
+}
+
+/**
+ * Throws away the match set.
+ */
+void ClearMatchSet() {
+	TextSearchFreeMatches(lpMatches);
+	TextSearchFreeMatches(lpMatchEnds);
+	lpMatches = NULL;
+	lpMatchEnds = NULL;
+	nMatches = 0L;
+	fMatchesValid = FALSE;
+}
+
+/**
+ * Gets the current text of the page editor. A copy is kept around while a
+ * dialog is open, since every keystroke in it searches the same text again.
+ *
+ * @param  lpcchHaystack Pointer to receive the length of the text.
+ * @return               Text of the page editor or NULL if we ran out of
+ *                       memory.
+ */
+LPCTSTR GetHaystack(size_t *lpcchHaystack) {
+	LONG nTextLen;
+
+	// Check if the copy we have is still good.
+	if ((szHaystack != NULL) &&
+			(dwHaystackGeneration == GetPageEditGeneration())) {
+		*lpcchHaystack = cchHaystack;
+		return szHaystack;
 	}
+	ReleaseHaystack();
+
+	// Allocate memory for the haystack and get the text.
+	nTextLen = SendPageEditMessage(WM_GETTEXTLENGTH, 0, 0);
+	szHaystack = LocalAlloc(LMEM_FIXED, (nTextLen + 1) * sizeof(TCHAR));
+	if (szHaystack == NULL)
+		return NULL;
+	nTextLen = SendPageEditMessage(WM_GETTEXT, (WPARAM)(nTextLen + 1),
+		(LPARAM)szHaystack);
+	cchHaystack = (size_t)nTextLen;
+	dwHaystackGeneration = GetPageEditGeneration();
 
-	// Find occurence.
-	lpLocalNeedle = szLocalNeedle;
-	lpHaystack = szHaystack + nCursorPos;
-	lpFound = wcsstr(lpHaystack, szLocalNeedle);
-	if (lpFound == NULL)
-		return -1L;
+	*lpcchHaystack = cchHaystack;
+	return szHaystack;
+}
 
-	// Cleanup.
-	if (!fMatchCase) {
-		LocalFree(szLocalNeedle);
+/**
+ * Frees the copy of the page editor text.
+ */
+void ReleaseHaystack() {
+	if (szHaystack != NULL)
+		LocalFree(szHaystack);
+
+	szHaystack = NULL;
+	cchHaystack = 0;
+}
+
+/**
+ * Makes sure the needle is compiled as a regular expression. It's only
+ * compiled again when the needle or the case option changes.
+ *
+ * @return TRUE if the needle is a valid expression.
+ */
+BOOL CompileNeedle() {
+	TCHAR szMsg[MAX_FIND_STRLEN + 100];
+	size_t nErrorPos;
+	int nError;
+
+	// Check if the one we have is still good.
+	if (fNeedleCompiled && (fCompiledCase == fMatchCase) &&
+			(wcscmp(szCompiledNeedle, szNeedle) == 0)) {
+		return TRUE;
 	}
 
-	// Calculate the cursor position and return.
-	nPos = lpFound - szHaystack;
-	return nPos;
+	// Get rid of the old one.
+	if (fNeedleCompiled) {
+		RegexFree(&reNeedle);
+		fNeedleCompiled = FALSE;
+	}
+
+	// Compile it.
+	nError = RegexCompile(&reNeedle, szNeedle, wcslen(szNeedle), fMatchCase,
+		&nErrorPos);
+	if (nError != REGEX_OK) {
+		wsprintf(szMsg, L"%s at character %d of \"%s\".",
+			GetRegexErrorMessage(nError), (int)nErrorPos + 1, szNeedle);
+		MessageBox(NULL, szMsg, L"Invalid Regular Expression",
+			MB_OK | MB_ICONERROR);
+		return FALSE;
+	}
+
+	// Remember what it was compiled from.
+	wcscpy(szCompiledNeedle, szNeedle);
+	fCompiledCase = fMatchCase;
+	fNeedleCompiled = TRUE;
+
+	return TRUE;
+}
+
+/**
+ * Gets a description of a regular expression compilation error.
+ *
+ * @param  nError Error returned by RegexCompile.
+ * @return        Description of the error.
+ */
+LPCTSTR GetRegexErrorMessage(int nError) {
+	switch (nError) {
+	case REGEX_ERR_MEMORY:
+		return L"Not enough memory";
+	case REGEX_ERR_PAREN:
+		return L"Unbalanced parenthesis";
+	case REGEX_ERR_BRACKET:
+		return L"Invalid character class";
+	case REGEX_ERR_ESCAPE:
+		return L"Invalid escape sequence";
+	case REGEX_ERR_REPEAT:
+		return L"Invalid repetition";
+	case REGEX_ERR_TOOBIG:
+		return L"Expression too complex";
+	}
+
+	return L"Invalid expression";
+}
+
+/**
+ * Replaces the regular expression match that's currently selected, expanding
+ * the references to its groups in the replacement.
+ *
+ * @return TRUE if the match was replaced.
+ */
+BOOL ReplaceSelectedMatch() {
+	REGEX_MATCH rmMatch;
+	LPTSTR szHaystack;
+	LPTSTR szExpanded;
+	LONG nTextLen;
+	DWORD dwSelStart;
+	size_t cchExpanded;
+
+	// Allocate memory for the haystack and get the text.
+	nTextLen = SendPageEditMessage(WM_GETTEXTLENGTH, 0, 0);
+	szHaystack = LocalAlloc(LMEM_FIXED, (nTextLen + 1) * sizeof(TCHAR));
+	if (szHaystack == NULL)
+		return FALSE;
+	nTextLen = SendPageEditMessage(WM_GETTEXT, (WPARAM)(nTextLen + 1),
+		(LPARAM)szHaystack);
+
+	// Match it again to know where its groups are.
+	SendPageEditMessage(EM_GETSEL, (WPARAM)&dwSelStart, (LPARAM)NULL);
+	if (RegexSearch(&reNeedle, szHaystack, (size_t)nTextLen,
+			(size_t)dwSelStart, &rmMatch) <= 0) {
+		LocalFree(szHaystack);
+		return FALSE;
+	}
+
+	// Expand the replacement.
+	cchExpanded = RegexExpand(szHaystack, &rmMatch, szReplacement,
+		wcslen(szReplacement), NULL);
+	szExpanded = LocalAlloc(LMEM_FIXED, (cchExpanded + 1) * sizeof(TCHAR));
+	if (szExpanded == NULL) {
+		LocalFree(szHaystack);
+		return FALSE;
+	}
+	RegexExpand(szHaystack, &rmMatch, szReplacement, wcslen(szReplacement),
+		szExpanded);
+	szExpanded[cchExpanded] = L'\0';
+	LocalFree(szHaystack);
+
+	// Replace the match.
+	SendPageEditMessage(EM_SETSEL, (WPARAM)rmMatch.aCaptures[0],
+		(LPARAM)rmMatch.aCaptures[1]);
+	SendPageEditMessage(EM_REPLACESEL, (WPARAM)TRUE, (LPARAM)szExpanded);
+	LocalFree(szExpanded);
+
+	return TRUE;
+}
+
+/**
+ * Shows which of the matches is selected in the caption of the open dialog.
+ *
+ * @param iMatch Index of the selected match or -1 if there isn't one.
+ */
+void ShowMatchPosition(long iMatch) {
+	TCHAR szCaption[MAX_CAPTION_STRLEN + 30];
+
+	// Check if there's a dialog to show it in.
+	if (hwndDialog == NULL)
+		return;
+
+	if (iMatch < 0L) {
+		wsprintf(szCaption, L"%s - %ld found", szDialogCaption, nMatches);
+	} else {
+		wsprintf(szCaption, L"%s - %ld of %ld", szDialogCaption, iMatch + 1L,
+			nMatches);
+	}
+
+	SetWindowText(hwndDialog, szCaption);
+}
+
+/**
+ * Selects the first match of what was typed so far, starting from where the
+ * cursor was when the dialog was opened. Regular expressions are left for
+ * "Find Next", since they are usually invalid while being typed.
+ *
+ * @param  hWnd Dialog window handler.
+ * @return      TRUE if something was found.
+ */
+BOOL IncrementalFind(HWND hWnd) {
+	long iMatch;
+
+	// Check if there's anything to look for.
+	SaveNeedleText(hWnd);
+	if (fRegex)
+		return FALSE;
+	if (szNeedle[0] == L'\0') {
+		SendPageEditMessage(EM_SETSEL, (WPARAM)dwIncrementalAnchor,
+			(LPARAM)dwIncrementalAnchor);
+		SetWindowText(hWnd, szDialogCaption);
+
+		return FALSE;
+	}
+
+	// Get the match set, narrowing the previous one when possible.
+	if (!UpdateMatchSet())
+		return FALSE;
+
+	// Go for the first one after the anchor, wrapping around the end.
+	iMatch = TextSearchNextMatch(lpMatches, nMatches,
+		(size_t)dwIncrementalAnchor);
+	if ((iMatch < 0L) && (nMatches > 0L))
+		iMatch = 0L;
+	if (iMatch < 0L) {
+		SendPageEditMessage(EM_SETSEL, (WPARAM)dwIncrementalAnchor,
+			(LPARAM)dwIncrementalAnchor);
+		ShowMatchPosition(-1L);
+
+		return FALSE;
+	}
+
+	// Highlight it without taking the focus from the dialog.
+	SendPageEditMessage(EM_SETSEL, (WPARAM)lpMatches[iMatch],
+		(LPARAM)(lpMatches[iMatch] + wcslen(szNeedle)));
+	SendPageEditMessage(EM_SCROLLCARET, 0, 0);
+	ShowMatchPosition(iMatch);
+
+	return TRUE;
+}
+
+/**
+ * Keeps track of the dialog that's currently open.
+ *
+ * @param hWnd Dialog window handle or NULL if it was closed.
+ */
+void SetDialogHandle(HWND hWnd) {
+	hwndDialog = hWnd;
+	if (hwndDialog != NULL) {
+		GetWindowText(hwndDialog, szDialogCaption, MAX_CAPTION_STRLEN);
+	} else {
+		szDialogCaption[0] = L'\0';
+	}
 }
 
 /**
@@ -224,7 +633,15 @@ BOOL CALLBACK FindDialogProc(HWND hWnd, UINT wMsg, WPARAM wParam,
 		return DlgFindInit(hWnd, wMsg, wParam, lParam);
 	case WM_COMMAND:
 		return DlgFindCommand(hWnd, wMsg, wParam, lParam);
+	case WM_TIMER:
+		if (wParam == IDT_INCREMENTAL_FIND) {
+			KillTimer(hWnd, IDT_INCREMENTAL_FIND);
+			IncrementalFind(hWnd);
+			return TRUE;
+		}
+		break;
 	case WM_CLOSE:
+		KillTimer(hWnd, IDT_INCREMENTAL_FIND);
 		SaveNeedleText(hWnd);
 		EndDialog(hWnd, 0);
 		return FALSE;
@@ -269,6 +686,15 @@ BOOL CALLBACK ReplaceDialogProc(HWND hWnd, UINT wMsg, WPARAM wParam,
  * @return        TRUE if we have processed the message.
  */
 BOOL DlgFindInit(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
+	DWORD dwSelEnd;
+
+	// Keep track of the dialog to show the match position in.
+	SetDialogHandle(hWnd);
+
+	// Typing in the dialog searches from where the cursor is.
+	SendPageEditMessage(EM_GETSEL, (WPARAM)&dwIncrementalAnchor,
+		(LPARAM)&dwSelEnd);
+
 	// Limit the text input to fit our find buffer and set the text.
 	SendDlgItemMessage(hWnd, IDC_FINDEDIT, EM_LIMITTEXT, MAX_FIND_STRLEN, 0);
 	SendDlgItemMessage(hWnd, IDC_FINDEDIT, WM_SETTEXT, 0, (LPARAM)szNeedle);
@@ -290,9 +716,19 @@ BOOL DlgFindInit(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 			BST_UNCHECKED, 0);
 	}
 
+	// Set the regular expression checkbox.
+	if (fRegex) {
+		SendDlgItemMessage(hWnd, IDC_CHECKREGEX, BM_SETCHECK, BST_CHECKED, 0);
+	} else {
+		SendDlgItemMessage(hWnd, IDC_CHECKREGEX, BM_SETCHECK, BST_UNCHECKED, 0);
+	}
+
 	// Enable/disable the Find Next button if there's something in the edit box.
 	SetFindNextState(hWnd);
 
+	// Pages found in the workspace may have changed since the last time.
+	nWorkspacePages = 0L;
+
 	return TRUE;
 }
 
@@ -306,6 +742,9 @@ BOOL DlgFindInit(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
  * @return        TRUE if we have processed the message.
  */
 BOOL DlgReplaceInit(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
+	// Keep track of the dialog to show the match position in.
+	SetDialogHandle(hWnd);
+
 	// Limit the text input to fit our find buffer and set the text.
 	SendDlgItemMessage(hWnd, IDC_FINDEDIT, EM_LIMITTEXT, MAX_FIND_STRLEN, 0);
 	SendDlgItemMessage(hWnd, IDC_FINDEDIT, WM_SETTEXT, 0, (LPARAM)szNeedle);
@@ -327,6 +766,13 @@ BOOL DlgReplaceInit(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 			BST_UNCHECKED, 0);
 	}
 
+	// Set the regular expression checkbox.
+	if (fRegex) {
+		SendDlgItemMessage(hWnd, IDC_CHECKREGEX, BM_SETCHECK, BST_CHECKED, 0);
+	} else {
+		SendDlgItemMessage(hWnd, IDC_CHECKREGEX, BM_SETCHECK, BST_UNCHECKED, 0);
+	}
+
 	// Enable/disable the buttons if there's something in the edit box.
 	SetFindNextReplaceState(hWnd);
 
@@ -349,6 +795,11 @@ BOOL DlgFindCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 		fMatchCase = SendDlgItemMessage(hWnd, IDC_CHECKMATCHCASE,
 			BM_GETCHECK, 0, 0) == BST_CHECKED;
 		break;
+	case IDC_CHECKREGEX:
+		// Regular Expression checkbox.
+		fRegex = SendDlgItemMessage(hWnd, IDC_CHECKREGEX, BM_GETCHECK, 0, 0)
+			== BST_CHECKED;
+		break;
 	case IDC_RADIOFINDUP:
 		// Up direction radio button.
 		if (SendDlgItemMessage(hWnd, IDC_RADIOFINDUP, BM_GETCHECK, 0, 0)
@@ -369,11 +820,19 @@ BOOL DlgFindCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 		break;
 	case IDC_FINDNEXT:
 		// Find Next button.
+		KillTimer(hWnd, IDT_INCREMENTAL_FIND);
 		SaveNeedleText(hWnd);
 		PageEditFindNext(TRUE);
 		break;
+	case IDC_FINDWORKSPACE:
+		// Workspace button.
+		KillTimer(hWnd, IDT_INCREMENTAL_FIND);
+		SaveNeedleText(hWnd);
+		FindInAllArticles(hWnd);
+		break;
 	case IDC_FINDCANCEL:
 		// Cancel button.
+		KillTimer(hWnd, IDT_INCREMENTAL_FIND);
 		SaveNeedleText(hWnd);
 		EndDialog(hWnd, 0);
 		break;
@@ -381,8 +840,10 @@ BOOL DlgFindCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 		// Find edit box.
 		switch (HIWORD(wParam)) {
 		case EN_CHANGE:
-			// Change event.
+			// Change event. Wait for a pause in the typing to search.
 			SetFindNextState(hWnd);
+			SetTimer(hWnd, IDT_INCREMENTAL_FIND, INCREMENTAL_FIND_DELAY,
+				NULL);
 		}
 		break;
 	}
@@ -406,6 +867,11 @@ BOOL DlgReplaceCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 		fMatchCase = SendDlgItemMessage(hWnd, IDC_CHECKMATCHCASE,
 			BM_GETCHECK, 0, 0) == BST_CHECKED;
 		break;
+	case IDC_CHECKREGEX:
+		// Regular Expression checkbox.
+		fRegex = SendDlgItemMessage(hWnd, IDC_CHECKREGEX, BM_GETCHECK, 0, 0)
+			== BST_CHECKED;
+		break;
 	case IDC_FINDNEXT:
 		// Find Next button.
 		SaveNeedleText(hWnd);
@@ -426,6 +892,12 @@ BOOL DlgReplaceCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 		PrepareReplaceNext(TRUE);
 		PageEditReplaceAll();
 		break;
+	case IDC_REPLACEWORKSPACE:
+		// Workspace button.
+		SaveNeedleText(hWnd);
+		SaveReplacementText(hWnd);
+		ReplaceInAllArticles(hWnd);
+		break;
 	case IDC_FINDCANCEL:
 		// Cancel button.
 		SaveNeedleText(hWnd);
@@ -454,9 +926,11 @@ BOOL DlgReplaceCommand(HWND hWnd, UINT wMsg, WPARAM wParam, LPARAM lParam) {
 BOOL SetFindNextState(HWND hWnd) {
 	if (SendDlgItemMessage(hWnd, IDC_FINDEDIT, WM_GETTEXTLENGTH, 0, 0) > 0) {
 		EnableWindow(GetDlgItem(hWnd, IDC_FINDNEXT), TRUE);
+		EnableWindow(GetDlgItem(hWnd, IDC_FINDWORKSPACE), TRUE);
 		fCanFindNext = TRUE;
 	} else {
 		EnableWindow(GetDlgItem(hWnd, IDC_FINDNEXT), FALSE);
+		EnableWindow(GetDlgItem(hWnd, IDC_FINDWORKSPACE), FALSE);
 		fCanFindNext = FALSE;
 	}
 
@@ -474,12 +948,14 @@ BOOL SetFindNextReplaceState(HWND hWnd) {
 		EnableWindow(GetDlgItem(hWnd, IDC_FINDNEXT), TRUE);
 		EnableWindow(GetDlgItem(hWnd, IDC_REPLACEBTN), TRUE);
 		EnableWindow(GetDlgItem(hWnd, IDC_REPLACEALL), TRUE);
+		EnableWindow(GetDlgItem(hWnd, IDC_REPLACEWORKSPACE), TRUE);
 
 		fCanFindNext = TRUE;
 	} else {
 		EnableWindow(GetDlgItem(hWnd, IDC_FINDNEXT), FALSE);
 		EnableWindow(GetDlgItem(hWnd, IDC_REPLACEBTN), FALSE);
 		EnableWindow(GetDlgItem(hWnd, IDC_REPLACEALL), FALSE);
+		EnableWindow(GetDlgItem(hWnd, IDC_REPLACEWORKSPACE), FALSE);
 		fCanFindNext = FALSE;
 	}
 
@@ -516,6 +992,230 @@ BOOL PrepareReplaceNext(BOOL fSelectAll) {
 	return bSelected;
 }
 
+/**
+ * Replaces the needle in every article of the workspace. Shows what's going
+ * to be changed and asks for confirmation before touching any files.
+ *
+ * @param  hWnd Dialog window handler.
+ * @return      TRUE if anything was replaced.
+ */
+BOOL ReplaceInAllArticles(HWND hWnd) {
+	TCHAR szMsg[MAX_PREVIEW_STRLEN];
+	WSREPLACE_REPORT wrReport;
+	const REGEX *lpRegex;
+	LPCTSTR szName;
+	HCURSOR hcurPrevious;
+	LONG iFile;
+	BOOL bSuccess;
+	int cchMsg;
+
+	// The articles can't change under our feet.
+	if (IsWorkspaceLoading()) {
+		MessageBox(hWnd, L"Wait for the workspace to finish loading before "
+			L"replacing in it.", L"Workspace Loading",
+			MB_OK | MB_ICONEXCLAMATION);
+		return FALSE;
+	}
+
+	// Unsaved edits to the open page would overwrite the replacements in it
+	// the next time it gets saved, so they have to go to the disk first.
+	if (IsPageDirty()) {
+		if (MessageBox(hWnd, L"The open page has unsaved changes, which have "
+				L"to be saved before replacing in the workspace. Save them "
+				L"now?", L"Unsaved Changes", MB_YESNO | MB_ICONQUESTION) != IDYES) {
+			return FALSE;
+		}
+
+		SaveCurrentPage();
+		if (IsPageDirty())
+			return FALSE;
+	}
+
+	// Get the expression ready.
+	lpRegex = NULL;
+	if (fRegex) {
+		if (!CompileNeedle())
+			return FALSE;
+
+		lpRegex = &reNeedle;
+	}
+
+	// See what would be replaced first. This blocks the window until every
+	// article was gone through, so at least show that it's busy.
+	hcurPrevious = SetCursor(LoadCursor(NULL, IDC_WAIT));
+	bSuccess = ReplaceInWorkspace(szNeedle, lpRegex, szReplacement, fMatchCase,
+		TRUE, &wrReport);
+	SetCursor(hcurPrevious);
+	if (!bSuccess) {
+		MessageBox(hWnd, L"Not enough memory to search the workspace.",
+			L"Replace Failed", MB_OK | MB_ICONERROR);
+		return FALSE;
+	}
+	if (wrReport.nReplaced == 0) {
+		FreeWorkspaceReplaceReport(&wrReport);
+		ShowNotFoundMessage();
+
+		return FALSE;
+	}
+
+	// Ask for confirmation listing the first few articles.
+	cchMsg = wsprintf(szMsg, L"Replace %ld occurrences in %ld articles?\r\n",
+		wrReport.nReplaced, wrReport.nFiles - wrReport.nFailed);
+	for (iFile = 0; (iFile < wrReport.nFiles) &&
+			(iFile < MAX_PREVIEW_FILES); iFile++) {
+		if (wrReport.lpFiles[iFile].fFailed)
+			continue;
+
+		szName = GetUkiArticleName(wrReport.lpFiles[iFile].nArticle);
+		cchMsg += wsprintf(szMsg + cchMsg, L"\r\n%.60s: %ld",
+			(szName != NULL) ? szName : L"?",
+			wrReport.lpFiles[iFile].nReplaced);
+	}
+	if (wrReport.nFiles > MAX_PREVIEW_FILES) {
+		wsprintf(szMsg + cchMsg, L"\r\n...and %ld more",
+			wrReport.nFiles - MAX_PREVIEW_FILES);
+	}
+	FreeWorkspaceReplaceReport(&wrReport);
+	if (MessageBox(hWnd, szMsg, L"Replace in Workspace",
+			MB_YESNO | MB_ICONQUESTION) != IDYES) {
+		return FALSE;
+	}
+
+	// Replace for real.
+	hcurPrevious = SetCursor(LoadCursor(NULL, IDC_WAIT));
+	bSuccess = ReplaceInWorkspace(szNeedle, lpRegex, szReplacement, fMatchCase,
+		FALSE, &wrReport);
+	SetCursor(hcurPrevious);
+	if (!bSuccess) {
+		MessageBox(hWnd, L"Not enough memory to replace in the workspace.",
+			L"Replace Failed", MB_OK | MB_ICONERROR);
+		return FALSE;
+	}
+	if (wrReport.nFailed > 0) {
+		wsprintf(szMsg, L"Replaced %ld occurrences, but %ld articles couldn't "
+			L"be changed.", wrReport.nReplaced, wrReport.nFailed);
+		MessageBox(hWnd, szMsg, L"Replace Failed", MB_OK | MB_ICONERROR);
+	}
+	FreeWorkspaceReplaceReport(&wrReport);
+
+	// Show the changes in the open page.
+	if (!IsPageDirty() && IsPageChangedOnDisk())
+		ReloadCurrentPage();
+
+	return TRUE;
+}
+
+/**
+ * Finds the pages of the workspace that have every word of the needle. The
+ * first time it lists them, and each time after that it opens the next one,
+ * where Find Next takes over.
+ *
+ * @param  hWnd Dialog window handler.
+ * @return      TRUE if a page was opened.
+ */
+BOOL FindInAllArticles(HWND hWnd) {
+	const TXTIDX_MATCH *lpPage;
+
+	// The index is only complete once the workspace is done loading.
+	if (IsWorkspaceLoading()) {
+		MessageBox(hWnd, L"Wait for the workspace to finish loading before "
+			L"searching in it.", L"Workspace Loading",
+			MB_OK | MB_ICONEXCLAMATION);
+		return FALSE;
+	}
+
+	// Only whole words are indexed.
+	if (fRegex) {
+		MessageBox(hWnd, L"Only words can be searched for in the whole "
+			L"workspace, not regular expressions.", L"Find in Workspace",
+			MB_OK | MB_ICONEXCLAMATION);
+		return FALSE;
+	}
+
+	// Look the needle up and show what was found.
+	if ((nWorkspacePages == 0L) || (wcscmp(szNeedle, szWorkspaceNeedle) != 0)) {
+		wcscpy(szWorkspaceNeedle, szNeedle);
+		iWorkspacePage = 0L;
+		nWorkspacePages = FindInWorkspace(szNeedle, amWorkspacePages,
+			MAX_WORKSPACE_PAGES);
+		if (nWorkspacePages <= 0L) {
+			nWorkspacePages = 0L;
+			ShowNotFoundMessage();
+
+			return FALSE;
+		}
+
+		if (!ShowWorkspacePages(hWnd)) {
+			nWorkspacePages = 0L;
+			return FALSE;
+		}
+	}
+
+	// Opening another page would throw away the unsaved edits.
+	if (IsPageDirty()) {
+		if (MessageBox(hWnd, L"The open page has unsaved changes. Save them "
+				L"before opening the next page?", L"Unsaved Changes",
+				MB_YESNO | MB_ICONQUESTION) != IDYES) {
+			return FALSE;
+		}
+
+		SaveCurrentPage();
+		if (IsPageDirty())
+			return FALSE;
+	}
+
+	// Open the next page, going back to the first after the last one.
+	lpPage = &amWorkspacePages[iWorkspacePage];
+	iWorkspacePage = (iWorkspacePage + 1L) % nWorkspacePages;
+	if (lpPage->iKind == TXTIDX_TEMPLATE)
+		return PopulatePageViewTemplate((size_t)lpPage->nPage);
+
+	return PopulatePageViewArticle((size_t)lpPage->nPage);
+}
+
+/**
+ * Lists the first few pages found in the workspace and asks if they should be
+ * opened.
+ *
+ * @param  hWnd Dialog window handler.
+ * @return      TRUE if the pages should be opened.
+ */
+BOOL ShowWorkspacePages(HWND hWnd) {
+	TCHAR szMsg[MAX_PREVIEW_STRLEN];
+	const TXTIDX_MATCH *lpPage;
+	LPCTSTR szName;
+	LONG iPage;
+	int cchMsg;
+
+	// Say how many there are, knowing they may have been cut short.
+	cchMsg = wsprintf(szMsg, L"Found %s%ld pages with \"%.40s\":\r\n",
+		(nWorkspacePages == MAX_WORKSPACE_PAGES) ? L"at least " : L"",
+		nWorkspacePages, szNeedle);
+
+	// List the first few.
+	for (iPage = 0L; (iPage < nWorkspacePages) &&
+			(iPage < MAX_PREVIEW_FILES); iPage++) {
+		lpPage = &amWorkspacePages[iPage];
+		if (lpPage->iKind == TXTIDX_TEMPLATE) {
+			szName = GetUkiTemplateName((LONG)lpPage->nPage);
+		} else {
+			szName = GetUkiArticleName((LONG)lpPage->nPage);
+		}
+
+		cchMsg += wsprintf(szMsg + cchMsg, L"\r\n%s%.60s",
+			(lpPage->iKind == TXTIDX_TEMPLATE) ? L"Template: " : L"",
+			(szName != NULL) ? szName : L"?");
+	}
+	if (nWorkspacePages > MAX_PREVIEW_FILES) {
+		cchMsg += wsprintf(szMsg + cchMsg, L"\r\n...and %ld more",
+			nWorkspacePages - MAX_PREVIEW_FILES);
+	}
+	wsprintf(szMsg + cchMsg, L"\r\n\r\nOpen them one at a time?");
+
+	return MessageBox(hWnd, szMsg, L"Find in Workspace",
+		MB_YESNO | MB_ICONQUESTION) == IDYES;
+}
+
 /**
  * Saves the find edit box contents to the needle buffer.
  *
@@ -542,8 +1242,14 @@ UINT SaveReplacementText(HWND hWnd) {
  * @return The value of the nResult parameter in the call to the EndDialog.
  */
 int ShowFindDialog() {
-	return DialogBox(hInst, MAKEINTRESOURCE(IDD_FIND), hwndParent,
+	int nResult;
+
+	nResult = DialogBox(hInst, MAKEINTRESOURCE(IDD_FIND), hwndParent,
 		FindDialogProc);
+	SetDialogHandle(NULL);
+	ReleaseHaystack();
+
+	return nResult;
 }
 
 /**
@@ -552,8 +1258,14 @@ int ShowFindDialog() {
  * @return The value of the nResult parameter in the call to the EndDialog.
  */
 int ShowReplaceDialog() {
-	return DialogBox(hInst, MAKEINTRESOURCE(IDD_REPLACE), hwndParent,
+	int nResult;
+
+	nResult = DialogBox(hInst, MAKEINTRESOURCE(IDD_REPLACE), hwndParent,
 		ReplaceDialogProc);
+	SetDialogHandle(NULL);
+	ReleaseHaystack();
+
+	return nResult;
 }
 
 /**
@@ -0,0 +1,385 @@
+/**
+ * FolderSnapshot.c
+ * Takes snapshots of folder trees and compares them to find what changed.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "FolderSnapshot.h"
+#include "Utilities.h"
+#include <stdlib.h>
+
+// Definitions.
+#define SNAPSHOT_INITIAL_ENTRIES 128
+#define SNAPSHOT_INITIAL_POOL    (SNAPSHOT_INITIAL_ENTRIES * 32)
+
+// Private methods.
+BOOL WalkFolder(FOLDERSNAPSHOT *lpSnapshot, LPCTSTR szFolder);
+BOOL AppendEntry(FOLDERSNAPSHOT *lpSnapshot, BOOL fFolder, LPCTSTR szPath,
+				 DWORD dwSize, const FILETIME *lpftModified);
+BOOL GrowEntries(SNAPSHOT_ENTRY **lppEntries, DWORD nEntries,
+				 DWORD *lpnCapacity);
+int CompareEntries(const void *lpA, const void *lpB);
+
+/**
+ * Initializes an empty folder snapshot.
+ *
+ * @param lpSnapshot Snapshot to be initialized.
+ */
+void InitializeFolderSnapshot(FOLDERSNAPSHOT *lpSnapshot) {
+	lpSnapshot->lpEntries = NULL;
+	lpSnapshot->nEntries = 0;
+	lpSnapshot->nCapacity = 0;
+	lpSnapshot->lpFolders = NULL;
+	lpSnapshot->nFolders = 0;
+	lpSnapshot->nFolderCapacity = 0;
+	lpSnapshot->szPool = NULL;
+	lpSnapshot->cchPool = 0;
+	lpSnapshot->cchPoolCapacity = 0;
+	lpSnapshot->fBorrowedPool = FALSE;
+}
+
+/**
+ * Takes a snapshot of every page (path, size, and modification time) inside a
+ * folder and its sub-folders.
+ *
+ * @param  lpSnapshot Initialized snapshot to be populated.
+ * @param  szFolder   Folder to take the snapshot of.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL SnapshotFolder(FOLDERSNAPSHOT *lpSnapshot, LPCTSTR szFolder) {
+	WIN32_FILE_ATTRIBUTE_DATA wfad;
+
+	// Start from scratch.
+	FreeFolderSnapshot(lpSnapshot);
+
+	// Record the root folder itself.
+	if (!GetFileAttributesEx(szFolder, GetFileExInfoStandard, &wfad))
+		return FALSE;
+	if (!AppendEntry(lpSnapshot, TRUE, szFolder, 0, &wfad.ftLastWriteTime)) {
+		FreeFolderSnapshot(lpSnapshot);
+		return FALSE;
+	}
+
+	// Go through the folder tree.
+	if (!WalkFolder(lpSnapshot, szFolder)) {
+		FreeFolderSnapshot(lpSnapshot);
+		return FALSE;
+	}
+
+	// The pool won't move anymore, so we can resolve the paths.
+	ResolveSnapshotPaths(lpSnapshot);
+
+	// Sort the entries to make comparisons linear.
+	if (lpSnapshot->nEntries > 1) {
+		qsort(lpSnapshot->lpEntries, lpSnapshot->nEntries,
+			sizeof(SNAPSHOT_ENTRY), CompareEntries);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Frees everything allocated by a snapshot.
+ *
+ * @param lpSnapshot Snapshot to be freed.
+ */
+void FreeFolderSnapshot(FOLDERSNAPSHOT *lpSnapshot) {
+	if (lpSnapshot->lpEntries != NULL)
+		LocalFree(lpSnapshot->lpEntries);
+	if (lpSnapshot->lpFolders != NULL)
+		LocalFree(lpSnapshot->lpFolders);
+	if ((lpSnapshot->szPool != NULL) && !lpSnapshot->fBorrowedPool)
+		LocalFree(lpSnapshot->szPool);
+
+	InitializeFolderSnapshot(lpSnapshot);
+}
+
+/**
+ * Resolves the path pointers of every entry from their offsets in the pool.
+ * @remark Only call this when the pool won't be moved anymore.
+ *
+ * @param lpSnapshot Snapshot to have its paths resolved.
+ */
+void ResolveSnapshotPaths(FOLDERSNAPSHOT *lpSnapshot) {
+	DWORD iEntry;
+
+	for (iEntry = 0; iEntry < lpSnapshot->nEntries; iEntry++) {
+		lpSnapshot->lpEntries[iEntry].szPath = lpSnapshot->szPool +
+			lpSnapshot->lpEntries[iEntry].dwOffset;
+	}
+
+	for (iEntry = 0; iEntry < lpSnapshot->nFolders; iEntry++) {
+		lpSnapshot->lpFolders[iEntry].szPath = lpSnapshot->szPool +
+			lpSnapshot->lpFolders[iEntry].dwOffset;
+	}
+}
+
+/**
+ * Checks if a snapshot still represents a folder by looking only at the
+ * modification times of the folders, which change when files are added to
+ * or removed from them.
+ *
+ * @param  lpSnapshot Snapshot to be checked.
+ * @param  szFolder   Folder the snapshot should represent.
+ * @return            TRUE if the snapshot is still current.
+ */
+BOOL IsFolderSnapshotCurrent(const FOLDERSNAPSHOT *lpSnapshot,
+							 LPCTSTR szFolder) {
+	WIN32_FILE_ATTRIBUTE_DATA wfad;
+	const SNAPSHOT_ENTRY *lpFolder;
+	DWORD iFolder;
+
+	// Check if the snapshot is of the same folder.
+	if ((lpSnapshot->nFolders == 0) ||
+		(wcscmp(lpSnapshot->lpFolders[0].szPath, szFolder) != 0)) {
+		return FALSE;
+	}
+
+	// Check if any of the folders changed.
+	for (iFolder = 0; iFolder < lpSnapshot->nFolders; iFolder++) {
+		lpFolder = &lpSnapshot->lpFolders[iFolder];
+		if (!GetFileAttributesEx(lpFolder->szPath, GetFileExInfoStandard,
+				&wfad)) {
+			return FALSE;
+		}
+
+		if (CompareFileTime(&wfad.ftLastWriteTime,
+				&lpFolder->ftModified) != 0) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Compares two snapshots and calls a procedure for each difference found.
+ *
+ * @param  lpOld    Previous snapshot.
+ * @param  lpNew    Current snapshot.
+ * @param  lpfnDiff Procedure called for each difference. Returning FALSE from
+ *                  it stops the comparison.
+ * @param  lParam   Parameter passed to the procedure.
+ * @return          TRUE if the comparison went through all of the entries.
+ */
+BOOL DiffFolderSnapshots(const FOLDERSNAPSHOT *lpOld,
+						 const FOLDERSNAPSHOT *lpNew,
+						 SNAPSHOTDIFFPROC lpfnDiff, LPARAM lParam) {
+	const SNAPSHOT_ENTRY *lpOldEntry;
+	const SNAPSHOT_ENTRY *lpNewEntry;
+	DWORD iOld = 0;
+	DWORD iNew = 0;
+	int nCompare;
+
+	// Walk both sorted lists at the same time.
+	while ((iOld < lpOld->nEntries) || (iNew < lpNew->nEntries)) {
+		lpOldEntry = (iOld < lpOld->nEntries) ? &lpOld->lpEntries[iOld] : NULL;
+		lpNewEntry = (iNew < lpNew->nEntries) ? &lpNew->lpEntries[iNew] : NULL;
+
+		// Check which side is behind.
+		if (lpOldEntry == NULL) {
+			nCompare = 1;
+		} else if (lpNewEntry == NULL) {
+			nCompare = -1;
+		} else {
+			nCompare = wcscmp(lpOldEntry->szPath, lpNewEntry->szPath);
+		}
+
+		// Report the difference.
+		if (nCompare < 0) {
+			if (!lpfnDiff(SNAPSHOT_REMOVED, lpOldEntry, lParam))
+				return FALSE;
+			iOld++;
+		} else if (nCompare > 0) {
+			if (!lpfnDiff(SNAPSHOT_ADDED, lpNewEntry, lParam))
+				return FALSE;
+			iNew++;
+		} else {
+			if ((lpOldEntry->dwSize != lpNewEntry->dwSize) ||
+				(CompareFileTime(&lpOldEntry->ftModified,
+					&lpNewEntry->ftModified) != 0)) {
+				if (!lpfnDiff(SNAPSHOT_CHANGED, lpNewEntry, lParam))
+					return FALSE;
+			}
+
+			iOld++;
+			iNew++;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Recursively walks a folder appending its pages to the snapshot. Anything the
+ * engine wouldn't load as a page, like images or the temporary and backup
+ * files of interrupted saves, is left out.
+ *
+ * @param  lpSnapshot Snapshot being populated.
+ * @param  szFolder   Folder to walk.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL WalkFolder(FOLDERSNAPSHOT *lpSnapshot, LPCTSTR szFolder) {
+	WIN32_FIND_DATA wfd;
+	TCHAR szPath[MAX_PATH];
+	HANDLE hFind;
+	BOOL bSuccess = TRUE;
+
+	// Build the search pattern.
+	if ((wcslen(szFolder) + 3) >= MAX_PATH)
+		return FALSE;
+	wsprintf(szPath, L"%s\\*", szFolder);
+
+	// Start looking for files.
+	hFind = FindFirstFile(szPath, &wfd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return TRUE;
+
+	do {
+		// Ignore the special folders.
+		if ((wcscmp(wfd.cFileName, L".") == 0) ||
+			(wcscmp(wfd.cFileName, L"..") == 0)) {
+			continue;
+		}
+
+		// Build the full path.
+		if ((wcslen(szFolder) + wcslen(wfd.cFileName) + 2) >= MAX_PATH)
+			continue;
+		wsprintf(szPath, L"%s\\%s", szFolder, wfd.cFileName);
+
+		// Go into sub-folders or append files.
+		if (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			bSuccess = AppendEntry(lpSnapshot, TRUE, szPath, 0,
+				&wfd.ftLastWriteTime);
+			if (bSuccess)
+				bSuccess = WalkFolder(lpSnapshot, szPath);
+		} else if (IsPageFile(wfd.cFileName)) {
+			bSuccess = AppendEntry(lpSnapshot, FALSE, szPath,
+				wfd.nFileSizeLow, &wfd.ftLastWriteTime);
+		}
+	} while (bSuccess && FindNextFile(hFind, &wfd));
+
+	// Clean up.
+	FindClose(hFind);
+	return bSuccess;
+}
+
+/**
+ * Appends a file or folder to the snapshot.
+ *
+ * @param  lpSnapshot   Snapshot being populated.
+ * @param  fFolder      Is this entry a folder?
+ * @param  szPath       Full path to the file or folder.
+ * @param  dwSize       Size of the file.
+ * @param  lpftModified Last modification time.
+ * @return              TRUE if the operation was successful.
+ */
+BOOL AppendEntry(FOLDERSNAPSHOT *lpSnapshot, BOOL fFolder, LPCTSTR szPath,
+				 DWORD dwSize, const FILETIME *lpftModified) {
+	SNAPSHOT_ENTRY *lpEntry;
+	DWORD cchPath;
+
+	// Grow the entries array if needed.
+	if (fFolder) {
+		if (!GrowEntries(&lpSnapshot->lpFolders, lpSnapshot->nFolders,
+				&lpSnapshot->nFolderCapacity)) {
+			return FALSE;
+		}
+	} else {
+		if (!GrowEntries(&lpSnapshot->lpEntries, lpSnapshot->nEntries,
+				&lpSnapshot->nCapacity)) {
+			return FALSE;
+		}
+	}
+
+	// Grow the string pool if needed.
+	cchPath = wcslen(szPath) + 1;
+	if ((lpSnapshot->cchPool + cchPath) > lpSnapshot->cchPoolCapacity) {
+		LPTSTR szNewPool;
+		DWORD cchNewCapacity;
+
+		cchNewCapacity = (lpSnapshot->cchPoolCapacity == 0) ?
+			SNAPSHOT_INITIAL_POOL : lpSnapshot->cchPoolCapacity * 2;
+		while (cchNewCapacity < (lpSnapshot->cchPool + cchPath))
+			cchNewCapacity *= 2;
+
+		if (lpSnapshot->szPool == NULL) {
+			szNewPool = (LPTSTR)LocalAlloc(LMEM_FIXED,
+				cchNewCapacity * sizeof(TCHAR));
+		} else {
+			szNewPool = (LPTSTR)LocalReAlloc(lpSnapshot->szPool,
+				cchNewCapacity * sizeof(TCHAR), LMEM_MOVEABLE);
+		}
+		if (szNewPool == NULL)
+			return FALSE;
+
+		lpSnapshot->szPool = szNewPool;
+		lpSnapshot->cchPoolCapacity = cchNewCapacity;
+	}
+
+	// Copy the path into the pool.
+	wcscpy(lpSnapshot->szPool + lpSnapshot->cchPool, szPath);
+
+	// Populate the entry.
+	if (fFolder) {
+		lpEntry = &lpSnapshot->lpFolders[lpSnapshot->nFolders++];
+	} else {
+		lpEntry = &lpSnapshot->lpEntries[lpSnapshot->nEntries++];
+	}
+	lpEntry->szPath = NULL;
+	lpEntry->dwOffset = lpSnapshot->cchPool;
+	lpEntry->dwSize = dwSize;
+	lpEntry->ftModified = *lpftModified;
+	lpSnapshot->cchPool += cchPath;
+
+	return TRUE;
+}
+
+/**
+ * Makes sure there's room for one more entry in an array, growing it if needed.
+ *
+ * @param  lppEntries  Pointer to the entries array.
+ * @param  nEntries    Number of entries currently in the array.
+ * @param  lpnCapacity Pointer to the capacity of the array.
+ * @return             TRUE if there's room for another entry.
+ */
+BOOL GrowEntries(SNAPSHOT_ENTRY **lppEntries, DWORD nEntries,
+				 DWORD *lpnCapacity) {
+	SNAPSHOT_ENTRY *lpNewEntries;
+	DWORD nNewCapacity;
+
+	// Check if there's still room.
+	if (nEntries < *lpnCapacity)
+		return TRUE;
+
+	// Allocate a bigger array.
+	nNewCapacity = (*lpnCapacity == 0) ? SNAPSHOT_INITIAL_ENTRIES :
+		*lpnCapacity * 2;
+	if (*lppEntries == NULL) {
+		lpNewEntries = (SNAPSHOT_ENTRY*)LocalAlloc(LMEM_FIXED,
+			nNewCapacity * sizeof(SNAPSHOT_ENTRY));
+	} else {
+		lpNewEntries = (SNAPSHOT_ENTRY*)LocalReAlloc(*lppEntries,
+			nNewCapacity * sizeof(SNAPSHOT_ENTRY), LMEM_MOVEABLE);
+	}
+	if (lpNewEntries == NULL)
+		return FALSE;
+
+	*lppEntries = lpNewEntries;
+	*lpnCapacity = nNewCapacity;
+
+	return TRUE;
+}
+
+/**
+ * Compares two snapshot entries by their paths. Used by qsort.
+ *
+ * @param  lpA First entry.
+ * @param  lpB Second entry.
+ * @return     Same as wcscmp.
+ */
+int CompareEntries(const void *lpA, const void *lpB) {
+	return wcscmp(((const SNAPSHOT_ENTRY*)lpA)->szPath,
+		((const SNAPSHOT_ENTRY*)lpB)->szPath);
+}
\ No newline at end of file
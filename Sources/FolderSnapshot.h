@@ -0,0 +1,60 @@
+/**
+ * FolderSnapshot.h
+ * Takes snapshots of folder trees and compares them to find what changed.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _FOLDERSNAPSHOT_H
+#define _FOLDERSNAPSHOT_H
+
+#include <windows.h>
+
+// Types of changes reported by a snapshot comparison.
+#define SNAPSHOT_ADDED   1
+#define SNAPSHOT_REMOVED 2
+#define SNAPSHOT_CHANGED 3
+
+// A single file in a snapshot.
+typedef struct {
+	LPCTSTR szPath;
+	DWORD dwOffset;
+	DWORD dwSize;
+	FILETIME ftModified;
+} SNAPSHOT_ENTRY;
+
+// Snapshot of all of the pages inside a folder tree, sorted by their paths,
+// and of the folders themselves, with the root folder always first.
+typedef struct {
+	SNAPSHOT_ENTRY *lpEntries;
+	DWORD nEntries;
+	DWORD nCapacity;
+	SNAPSHOT_ENTRY *lpFolders;
+	DWORD nFolders;
+	DWORD nFolderCapacity;
+	LPTSTR szPool;
+	DWORD cchPool;
+	DWORD cchPoolCapacity;
+	BOOL fBorrowedPool;
+} FOLDERSNAPSHOT;
+
+// Callback for every difference found between two snapshots.
+typedef BOOL (*SNAPSHOTDIFFPROC)(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+								 LPARAM lParam);
+
+// Creation and destruction.
+void InitializeFolderSnapshot(FOLDERSNAPSHOT *lpSnapshot);
+BOOL SnapshotFolder(FOLDERSNAPSHOT *lpSnapshot, LPCTSTR szFolder);
+void FreeFolderSnapshot(FOLDERSNAPSHOT *lpSnapshot);
+void ResolveSnapshotPaths(FOLDERSNAPSHOT *lpSnapshot);
+
+// Validation.
+BOOL IsFolderSnapshotCurrent(const FOLDERSNAPSHOT *lpSnapshot,
+							 LPCTSTR szFolder);
+
+// Comparison.
+BOOL DiffFolderSnapshots(const FOLDERSNAPSHOT *lpOld,
+						 const FOLDERSNAPSHOT *lpNew,
+						 SNAPSHOTDIFFPROC lpfnDiff, LPARAM lParam);
+
+#endif  // _FOLDERSNAPSHOT_H
\ No newline at end of file
@@ -0,0 +1,180 @@
+/**
+ * HtmlChunk.c
+ * A platform-neutral splitter that breaks UTF-16 HTML documents into chunks at
+ * places where the viewer can safely render what it got so far.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "HtmlChunk.h"
+
+// Where the scanner is in the document.
+#define HTMLCHUNK_TEXT    0
+#define HTMLCHUNK_TAG     1
+#define HTMLCHUNK_QUOTE   2
+#define HTMLCHUNK_COMMENT 3
+#define HTMLCHUNK_RAW     4
+
+// Private methods.
+int MatchesAt(const unsigned short *szHTML, size_t cchHTML, size_t nPos,
+			  const char *szaWord);
+int IsRawTextTag(const unsigned short *szHTML, size_t cchHTML, size_t nPos);
+
+/**
+ * Finds where the next chunk of a document should end. Chunks end right after
+ * a tag, never inside a tag, comment, script or style, so the viewer can show
+ * everything it got. If there's no such place within the maximum size the
+ * chunk is cut there, without splitting a surrogate pair or an entity.
+ * @remark The previous chunk must have ended where this function said.
+ *
+ * @param  szHTML  Whole document.
+ * @param  cchHTML Length of the document in characters.
+ * @param  nStart  Where the chunk starts.
+ * @param  cchMax  Maximum length of the chunk in characters.
+ * @return         Position right after the end of the chunk.
+ */
+size_t HtmlChunkEnd(const unsigned short *szHTML, size_t cchHTML,
+					size_t nStart, size_t cchMax) {
+	size_t nLimit;
+	size_t nSafe;
+	size_t nPos;
+	size_t nBack;
+	unsigned short chQuote;
+	int fRawTag;
+	int iState;
+
+	// Check if the rest of the document fits.
+	if ((cchHTML - nStart) <= cchMax)
+		return cchHTML;
+	nLimit = nStart + cchMax;
+
+	// Look for the last place right after a tag.
+	nSafe = nStart;
+	iState = HTMLCHUNK_TEXT;
+	chQuote = 0;
+	fRawTag = 0;
+	nPos = nStart;
+	while (nPos < nLimit) {
+		switch (iState) {
+		case HTMLCHUNK_TEXT:
+			if (szHTML[nPos] == '<') {
+				if (MatchesAt(szHTML, cchHTML, nPos, "<!--")) {
+					iState = HTMLCHUNK_COMMENT;
+					nPos += 3;
+				} else {
+					iState = HTMLCHUNK_TAG;
+					fRawTag = IsRawTextTag(szHTML, cchHTML, nPos);
+				}
+			}
+			break;
+		case HTMLCHUNK_TAG:
+			if ((szHTML[nPos] == '"') || (szHTML[nPos] == '\'')) {
+				iState = HTMLCHUNK_QUOTE;
+				chQuote = szHTML[nPos];
+			} else if (szHTML[nPos] == '>') {
+				if (fRawTag) {
+					iState = HTMLCHUNK_RAW;
+				} else {
+					iState = HTMLCHUNK_TEXT;
+					nSafe = nPos + 1;
+				}
+			}
+			break;
+		case HTMLCHUNK_QUOTE:
+			if (szHTML[nPos] == chQuote)
+				iState = HTMLCHUNK_TAG;
+			break;
+		case HTMLCHUNK_COMMENT:
+			if (MatchesAt(szHTML, cchHTML, nPos, "-->")) {
+				iState = HTMLCHUNK_TEXT;
+				nPos += 2;
+
+				// Keep the last place if this one ends past the limit.
+				if (nPos < nLimit)
+					nSafe = nPos + 1;
+			}
+			break;
+		case HTMLCHUNK_RAW:
+			if (MatchesAt(szHTML, cchHTML, nPos, "</script") ||
+					MatchesAt(szHTML, cchHTML, nPos, "</style")) {
+				iState = HTMLCHUNK_TAG;
+				fRawTag = 0;
+			}
+			break;
+		}
+
+		nPos++;
+	}
+	if ((nSafe > nStart) && (nSafe <= nLimit))
+		return nSafe;
+
+	// Cut it anyway, but keep characters and entities in one piece.
+	nPos = nLimit;
+	if (((nPos - 1) > nStart) && (szHTML[nPos - 1] >= 0xD800) &&
+			(szHTML[nPos - 1] <= 0xDBFF)) {
+		nPos--;
+	}
+	for (nBack = 1; (nBack <= 8) && (nBack < (nPos - nStart)); nBack++) {
+		if (szHTML[nPos - nBack] == ';')
+			break;
+		if (szHTML[nPos - nBack] == '&') {
+			nPos -= nBack;
+			break;
+		}
+	}
+
+	return nPos;
+}
+
+/**
+ * Checks if an ASCII word is at a position of the document, ignoring the case.
+ *
+ * @param  szHTML  Whole document.
+ * @param  cchHTML Length of the document in characters.
+ * @param  nPos    Position to be checked.
+ * @param  szaWord Lowercase word to look for.
+ * @return         1 if the word is there, 0 otherwise.
+ */
+int MatchesAt(const unsigned short *szHTML, size_t cchHTML, size_t nPos,
+			  const char *szaWord) {
+	unsigned short ch;
+
+	for (; *szaWord != '\0'; szaWord++, nPos++) {
+		if (nPos >= cchHTML)
+			return 0;
+
+		ch = szHTML[nPos];
+		if ((ch >= 'A') && (ch <= 'Z'))
+			ch += 'a' - 'A';
+		if (ch != (unsigned short)*szaWord)
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Checks if a tag opens an element whose contents aren't HTML.
+ *
+ * @param  szHTML  Whole document.
+ * @param  cchHTML Length of the document in characters.
+ * @param  nPos    Position of the opening bracket of the tag.
+ * @return         1 if it's a script or style tag, 0 otherwise.
+ */
+int IsRawTextTag(const unsigned short *szHTML, size_t cchHTML, size_t nPos) {
+	size_t nEnd;
+
+	if (MatchesAt(szHTML, cchHTML, nPos, "<script")) {
+		nEnd = nPos + 7;
+	} else if (MatchesAt(szHTML, cchHTML, nPos, "<style")) {
+		nEnd = nPos + 6;
+	} else {
+		return 0;
+	}
+
+	// Make sure it's not just the start of a longer name.
+	return (nEnd >= cchHTML) || (szHTML[nEnd] == '>') ||
+		(szHTML[nEnd] == ' ') || (szHTML[nEnd] == '\t') ||
+		(szHTML[nEnd] == '\r') || (szHTML[nEnd] == '\n') ||
+		(szHTML[nEnd] == '/');
+}
\ No newline at end of file
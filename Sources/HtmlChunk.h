@@ -0,0 +1,18 @@
+/**
+ * HtmlChunk.h
+ * A platform-neutral splitter that breaks UTF-16 HTML documents into chunks at
+ * places where the viewer can safely render what it got so far.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _HTMLCHUNK_H
+#define _HTMLCHUNK_H
+
+#include <stddef.h>
+
+// Splitting.
+size_t HtmlChunkEnd(const unsigned short *szHTML, size_t cchHTML,
+					size_t nStart, size_t cchMax);
+
+#endif  // _HTMLCHUNK_H
\ No newline at end of file
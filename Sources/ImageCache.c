@@ -0,0 +1,402 @@
+/**
+ * ImageCache.c
+ * Keeps the images of the pages around already shrunk to fit the page viewer,
+ * so that they are only decoded once instead of on every visit.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "ImageCache.h"
+#include "ImageScale.h"
+#include "FileMap.h"
+#include "Utilities.h"
+#include <string.h>
+
+// A shrunk image. Entries without a szPath are free, and the ones without a
+// bitmap are images we couldn't decode, kept so that we don't try again.
+typedef struct {
+	LPTSTR szPath;
+	FILETIME ftModified;
+	LONG nMaxWidth;
+	LONG nWidth;
+	LONG nHeight;
+	HBITMAP hbmImage;
+	DWORD cbImage;
+	DWORD dwLastUsed;
+	BOOL fShown;
+} IMAGECACHE_ENTRY;
+
+// Global variables.
+IMAGECACHE_ENTRY iceEntries[IMAGECACHE_MAX_ENTRIES];
+IMAGECACHE_STATS icsStats;
+DWORD cbImageCacheMax = IMAGECACHE_MAX_BYTES;
+DWORD dwImageUseCounter = 0;
+
+// Private methods.
+BOOL DecodeScaledImage(LPCTSTR szPath, LONG nMaxWidth, IMAGE_PIXELS *lpImage);
+HBITMAP CreateImageBitmap(const IMAGE_PIXELS *lpImage);
+BOOL StoreImageEntry(LPCTSTR szPath, const FILETIME *lpftModified,
+					 LONG nMaxWidth, HBITMAP hbmImage, LONG nWidth,
+					 LONG nHeight, DWORD cbImage);
+int FindImageEntry(LPCTSTR szPath, LONG nMaxWidth);
+int GetFreeImageEntry(DWORD cbNeeded);
+void FreeImageEntry(int iEntry);
+
+/**
+ * Initializes the image cache.
+ *
+ * @param cbMaxBytes Maximum number of bytes of pixels to keep around.
+ */
+void InitializeImageCache(DWORD cbMaxBytes) {
+	int iEntry;
+
+	// Set the limit and mark every entry as free.
+	cbImageCacheMax = cbMaxBytes;
+	for (iEntry = 0; iEntry < IMAGECACHE_MAX_ENTRIES; iEntry++) {
+		iceEntries[iEntry].szPath = NULL;
+		iceEntries[iEntry].hbmImage = NULL;
+		iceEntries[iEntry].cbImage = 0;
+		iceEntries[iEntry].fShown = FALSE;
+	}
+
+	// Reset the counters.
+	icsStats.dwHits = 0;
+	icsStats.dwMisses = 0;
+	icsStats.dwEvictions = 0;
+	icsStats.dwUndecodable = 0;
+	icsStats.nEntries = 0;
+	icsStats.cbUsed = 0;
+}
+
+/**
+ * Throws away everything in the cache. The page viewer must have been cleared
+ * before this, since it may still be showing some of the bitmaps.
+ */
+void ClearImageCache() {
+	int iEntry;
+
+	for (iEntry = 0; iEntry < IMAGECACHE_MAX_ENTRIES; iEntry++)
+		FreeImageEntry(iEntry);
+}
+
+/**
+ * Throws away every image that isn't being shown right now, used to give
+ * memory back to the system.
+ */
+void TrimImageCache() {
+	int iEntry;
+
+	for (iEntry = 0; iEntry < IMAGECACHE_MAX_ENTRIES; iEntry++) {
+		if (!iceEntries[iEntry].fShown)
+			FreeImageEntry(iEntry);
+	}
+}
+
+/**
+ * Gets an image shrunk to fit a width, only decoding it if the cached version
+ * is missing or out of date.
+ *
+ * @param  szPath    Path to the image file.
+ * @param  nMaxWidth Maximum width of the image.
+ * @param  lpnWidth  Width of the shrunk image.
+ * @param  lpnHeight Height of the shrunk image.
+ * @param  lpfCached Set to TRUE if the bitmap is owned by the cache, in which
+ *                   case it's valid until the next call to ReleaseShownImages,
+ *                   otherwise it's up to the caller to delete it.
+ * @return           The image or NULL if it couldn't be decoded.
+ */
+HBITMAP GetScaledImage(LPCTSTR szPath, LONG nMaxWidth, LONG *lpnWidth,
+					   LONG *lpnHeight, BOOL *lpfCached) {
+	IMAGECACHE_ENTRY *lpEntry;
+	IMAGE_PIXELS ipImage;
+	FILETIME ftModified;
+	HBITMAP hbmImage;
+	DWORD cbImage;
+	int iEntry;
+
+	// Get when the file was last changed.
+	*lpfCached = FALSE;
+	if (!GetFileModifiedTime(szPath, &ftModified))
+		return NULL;
+
+	// Check if we already have it.
+	iEntry = FindImageEntry(szPath, nMaxWidth);
+	if (iEntry >= 0) {
+		lpEntry = &iceEntries[iEntry];
+		if (CompareFileTime(&lpEntry->ftModified, &ftModified) == 0) {
+			if (lpEntry->hbmImage == NULL)
+				return NULL;
+
+			icsStats.dwHits++;
+			lpEntry->dwLastUsed = ++dwImageUseCounter;
+			lpEntry->fShown = TRUE;
+			*lpnWidth = lpEntry->nWidth;
+			*lpnHeight = lpEntry->nHeight;
+			*lpfCached = TRUE;
+
+			return lpEntry->hbmImage;
+		}
+
+		// Out of date.
+		FreeImageEntry(iEntry);
+	}
+
+	// Decode and shrink the image.
+	icsStats.dwMisses++;
+	if (!DecodeScaledImage(szPath, nMaxWidth, &ipImage)) {
+		icsStats.dwUndecodable++;
+		StoreImageEntry(szPath, &ftModified, nMaxWidth, NULL, 0, 0, 0);
+
+		return NULL;
+	}
+	hbmImage = CreateImageBitmap(&ipImage);
+	*lpnWidth = ipImage.nWidth;
+	*lpnHeight = ipImage.nHeight;
+	cbImage = (DWORD)(ipImage.nStride * ipImage.nHeight);
+	ImagePixelsFree(&ipImage);
+	if (hbmImage == NULL)
+		return NULL;
+
+	// Store it, unless the cache is full of images that are being shown.
+	*lpfCached = StoreImageEntry(szPath, &ftModified, nMaxWidth, hbmImage,
+		*lpnWidth, *lpnHeight, cbImage);
+	return hbmImage;
+}
+
+/**
+ * Lets go of the images of the page that was being shown, allowing them to be
+ * evicted. Must be called whenever the page viewer is cleared.
+ */
+void ReleaseShownImages() {
+	int iEntry;
+
+	for (iEntry = 0; iEntry < IMAGECACHE_MAX_ENTRIES; iEntry++)
+		iceEntries[iEntry].fShown = FALSE;
+}
+
+/**
+ * Gets the cache usage counters.
+ *
+ * @param lpStats Structure to receive the counters.
+ */
+void GetImageCacheStats(IMAGECACHE_STATS *lpStats) {
+	*lpStats = icsStats;
+}
+
+/**
+ * Decodes an image file and shrinks it to fit a width.
+ *
+ * @param  szPath    Path to the image file.
+ * @param  nMaxWidth Maximum width of the image.
+ * @param  lpImage   Image to receive the pixels. Free it with ImagePixelsFree.
+ * @return           TRUE if the image was decoded.
+ */
+BOOL DecodeScaledImage(LPCTSTR szPath, LONG nMaxWidth, IMAGE_PIXELS *lpImage) {
+	IMAGE_PIXELS ipFull;
+	FILEMAP fmFile;
+	long nWidth;
+	long nHeight;
+	int nResult;
+
+	// Decode the whole image.
+	if (!FileMapOpen(&fmFile, szPath, FILEMAP_MIN_MAPPED))
+		return FALSE;
+	nResult = ImageDecodeBmp((const unsigned char*)fmFile.lpData,
+		fmFile.cbData, &ipFull);
+	FileMapClose(&fmFile);
+	if (nResult != IMAGE_OK)
+		return FALSE;
+
+	// Check if it already fits.
+	ImageScaledSize(ipFull.nWidth, ipFull.nHeight, nMaxWidth, &nWidth,
+		&nHeight);
+	if (nWidth == ipFull.nWidth) {
+		*lpImage = ipFull;
+		return TRUE;
+	}
+
+	// Shrink it.
+	nResult = ImageDownscale(&ipFull, nWidth, nHeight, lpImage);
+	ImagePixelsFree(&ipFull);
+
+	return nResult == IMAGE_OK;
+}
+
+/**
+ * Creates a bitmap with the pixels of an image.
+ *
+ * @param  lpImage Image to be copied.
+ * @return         The bitmap or NULL if it couldn't be created.
+ */
+HBITMAP CreateImageBitmap(const IMAGE_PIXELS *lpImage) {
+	BITMAPINFO bmiImage;
+	HBITMAP hbmImage;
+	LPBYTE lpBits;
+	HDC hdcScreen;
+	LONG y;
+
+	// Describe the pixels.
+	bmiImage.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmiImage.bmiHeader.biWidth = lpImage->nWidth;
+	bmiImage.bmiHeader.biHeight = lpImage->nHeight;
+	bmiImage.bmiHeader.biPlanes = 1;
+	bmiImage.bmiHeader.biBitCount = 24;
+	bmiImage.bmiHeader.biCompression = BI_RGB;
+	bmiImage.bmiHeader.biSizeImage = 0;
+	bmiImage.bmiHeader.biXPelsPerMeter = 0;
+	bmiImage.bmiHeader.biYPelsPerMeter = 0;
+	bmiImage.bmiHeader.biClrUsed = 0;
+	bmiImage.bmiHeader.biClrImportant = 0;
+
+	// Create the bitmap.
+	hdcScreen = GetDC(NULL);
+	hbmImage = CreateDIBSection(hdcScreen, &bmiImage, DIB_RGB_COLORS,
+		(void**)&lpBits, NULL, 0);
+	ReleaseDC(NULL, hdcScreen);
+	if (hbmImage == NULL)
+		return NULL;
+
+	// Copy the rows over, bitmaps are stored bottom-up.
+	for (y = 0; y < lpImage->nHeight; y++) {
+		memcpy(lpBits + ((lpImage->nHeight - 1 - y) * lpImage->nStride),
+			lpImage->lpBits + (y * lpImage->nStride), lpImage->nStride);
+	}
+
+	return hbmImage;
+}
+
+/**
+ * Stores an image in the cache.
+ *
+ * @param  szPath       Path to the image file.
+ * @param  lpftModified When the image file was last changed.
+ * @param  nMaxWidth    Width the image was shrunk to fit.
+ * @param  hbmImage     The image or NULL if it couldn't be decoded.
+ * @param  nWidth       Width of the image.
+ * @param  nHeight      Height of the image.
+ * @param  cbImage      Size of the pixels of the image in bytes.
+ * @return              TRUE if the cache took ownership of the image.
+ */
+BOOL StoreImageEntry(LPCTSTR szPath, const FILETIME *lpftModified,
+					 LONG nMaxWidth, HBITMAP hbmImage, LONG nWidth,
+					 LONG nHeight, DWORD cbImage) {
+	IMAGECACHE_ENTRY *lpEntry;
+	LPTSTR szCopy;
+	int iEntry;
+
+	// Get somewhere to put it.
+	iEntry = GetFreeImageEntry(cbImage);
+	if (iEntry < 0)
+		return FALSE;
+	szCopy = (LPTSTR)LocalAlloc(LMEM_FIXED,
+		(wcslen(szPath) + 1) * sizeof(TCHAR));
+	if (szCopy == NULL)
+		return FALSE;
+	wcscpy(szCopy, szPath);
+
+	lpEntry = &iceEntries[iEntry];
+	lpEntry->szPath = szCopy;
+	lpEntry->ftModified = *lpftModified;
+	lpEntry->nMaxWidth = nMaxWidth;
+	lpEntry->nWidth = nWidth;
+	lpEntry->nHeight = nHeight;
+	lpEntry->hbmImage = hbmImage;
+	lpEntry->cbImage = cbImage;
+	lpEntry->dwLastUsed = ++dwImageUseCounter;
+	lpEntry->fShown = hbmImage != NULL;
+	icsStats.nEntries++;
+	icsStats.cbUsed += cbImage;
+
+	return TRUE;
+}
+
+/**
+ * Finds the cache entry of an image shrunk to fit a width.
+ *
+ * @param  szPath    Path to the image file.
+ * @param  nMaxWidth Width the image was shrunk to fit.
+ * @return           Index of the entry or -1 if the image isn't cached.
+ */
+int FindImageEntry(LPCTSTR szPath, LONG nMaxWidth) {
+	int iEntry;
+
+	for (iEntry = 0; iEntry < IMAGECACHE_MAX_ENTRIES; iEntry++) {
+		if ((iceEntries[iEntry].szPath != NULL) &&
+				(iceEntries[iEntry].nMaxWidth == nMaxWidth) &&
+				(wcscmp(iceEntries[iEntry].szPath, szPath) == 0)) {
+			return iEntry;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Gets a free cache entry, evicting the least recently used images that aren't
+ * being shown until there's an entry available and the new one fits in the
+ * memory budget.
+ * @remark The images being shown may take the cache over its budget, the
+ *         extra ones are evicted once they are released.
+ *
+ * @param  cbNeeded Size of the image that will be stored.
+ * @return          Index of the free entry or -1 if every entry is taken by
+ *                  an image that's being shown.
+ */
+int GetFreeImageEntry(DWORD cbNeeded) {
+	int iFree;
+	int iOldest;
+	int iEntry;
+
+	for (;;) {
+		// Look for a free entry and the least recently used one.
+		iFree = -1;
+		iOldest = -1;
+		for (iEntry = 0; iEntry < IMAGECACHE_MAX_ENTRIES; iEntry++) {
+			if (iceEntries[iEntry].szPath == NULL) {
+				if (iFree < 0)
+					iFree = iEntry;
+			} else if (!iceEntries[iEntry].fShown && ((iOldest < 0) ||
+					(iceEntries[iEntry].dwLastUsed <
+					iceEntries[iOldest].dwLastUsed))) {
+				iOldest = iEntry;
+			}
+		}
+
+		// Check if we are done.
+		if ((iFree >= 0) && ((iOldest < 0) ||
+				((icsStats.cbUsed + cbNeeded) <= cbImageCacheMax))) {
+			return iFree;
+		}
+		if (iOldest < 0)
+			return -1;
+
+		// Evict the least recently used entry.
+		FreeImageEntry(iOldest);
+		icsStats.dwEvictions++;
+	}
+}
+
+/**
+ * Frees a cache entry.
+ *
+ * @param iEntry Index of the entry.
+ */
+void FreeImageEntry(int iEntry) {
+	IMAGECACHE_ENTRY *lpEntry = &iceEntries[iEntry];
+
+	// Check if there's anything to be done.
+	if (lpEntry->szPath == NULL)
+		return;
+
+	// Release the image.
+	icsStats.nEntries--;
+	icsStats.cbUsed -= lpEntry->cbImage;
+	if (lpEntry->hbmImage != NULL)
+		DeleteObject(lpEntry->hbmImage);
+	LocalFree(lpEntry->szPath);
+
+	lpEntry->szPath = NULL;
+	lpEntry->hbmImage = NULL;
+	lpEntry->cbImage = 0;
+	lpEntry->fShown = FALSE;
+}
\ No newline at end of file
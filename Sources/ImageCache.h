@@ -0,0 +1,40 @@
+/**
+ * ImageCache.h
+ * Keeps the images of the pages around already shrunk to fit the page viewer.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _IMAGECACHE_H
+#define _IMAGECACHE_H
+
+#include <windows.h>
+
+// Default limits of the cache.
+#define IMAGECACHE_MAX_ENTRIES 24
+#define IMAGECACHE_MAX_BYTES   (512 * 1024)
+
+// Cache usage counters.
+typedef struct {
+	DWORD dwHits;
+	DWORD dwMisses;
+	DWORD dwEvictions;
+	DWORD dwUndecodable;
+	DWORD nEntries;
+	DWORD cbUsed;
+} IMAGECACHE_STATS;
+
+// Initialization and destruction.
+void InitializeImageCache(DWORD cbMaxBytes);
+void ClearImageCache();
+void TrimImageCache();
+
+// Images.
+HBITMAP GetScaledImage(LPCTSTR szPath, LONG nMaxWidth, LONG *lpnWidth,
+					   LONG *lpnHeight, BOOL *lpfCached);
+void ReleaseShownImages();
+
+// Statistics.
+void GetImageCacheStats(IMAGECACHE_STATS *lpStats);
+
+#endif  // _IMAGECACHE_H
\ No newline at end of file
@@ -0,0 +1,591 @@
+/**
+ * ImageScale.c
+ * A platform-neutral decoder and downscaler for the images shown in the page
+ * viewer. Images are shrunk with an area average, where every source pixel
+ * contributes to a target pixel in proportion to how much of it is covered,
+ * which keeps text and thin lines readable unlike simply dropping pixels.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "ImageScale.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Sizes of the BMP headers.
+#define BMP_FILE_HEADER 14
+#define BMP_CORE_HEADER 12
+#define BMP_INFO_HEADER 40
+
+// Compression methods of a BMP file that we understand.
+#define BMP_RGB       0
+#define BMP_BITFIELDS 3
+
+// Extra precision kept between the horizontal and vertical passes.
+#define SCALE_PRECISION 256
+
+// A color channel of a pixel described by a bit mask.
+typedef struct {
+	unsigned long dwMask;
+	int nShift;
+	int nBits;
+} BMP_CHANNEL;
+
+// Source pixels that cover a target pixel along one axis. Their weights are
+// stored one after the other starting at iWeight, and always add up to the
+// size of the source.
+typedef struct {
+	long nFirst;
+	long nCount;
+	long iWeight;
+} SCALE_SPAN;
+
+// Private methods.
+unsigned long ReadLE16(const unsigned char *lpData);
+unsigned long ReadLE32(const unsigned char *lpData);
+long ReadSignedLE32(const unsigned char *lpData);
+void SetupChannel(BMP_CHANNEL *lpChannel, unsigned long dwMask);
+unsigned char ExtractChannel(const BMP_CHANNEL *lpChannel,
+							 unsigned long dwPixel);
+SCALE_SPAN* BuildSpans(long nSource, long nTarget, unsigned long **lppWeights);
+void FreeSpans(SCALE_SPAN *lpSpans, unsigned long *lpWeights);
+void ScaleRow(const unsigned char *lpRow, const SCALE_SPAN *lpSpans,
+			  const unsigned long *lpWeights, long nTarget, long nSource,
+			  unsigned long *lpOutput);
+
+/**
+ * Allocates the pixels of an image, initializing them to black.
+ *
+ * @param  lpImage Image to be allocated.
+ * @param  nWidth  Width of the image in pixels.
+ * @param  nHeight Height of the image in pixels.
+ * @return         IMAGE_OK if the image was allocated.
+ */
+int ImagePixelsAllocate(IMAGE_PIXELS *lpImage, long nWidth, long nHeight) {
+	lpImage->lpBits = NULL;
+
+	// Check if it's a sensible size.
+	if ((nWidth <= 0) || (nHeight <= 0))
+		return IMAGE_ERR_CORRUPT;
+	if ((nWidth > IMAGE_MAX_DIMENSION) || (nHeight > IMAGE_MAX_DIMENSION))
+		return IMAGE_ERR_TOOBIG;
+
+	lpImage->nWidth = nWidth;
+	lpImage->nHeight = nHeight;
+	lpImage->nStride = ImageStride(nWidth);
+	lpImage->lpBits = (unsigned char*)calloc((size_t)lpImage->nStride,
+		(size_t)nHeight);
+	if (lpImage->lpBits == NULL)
+		return IMAGE_ERR_MEMORY;
+
+	return IMAGE_OK;
+}
+
+/**
+ * Frees the pixels of an image.
+ *
+ * @param lpImage Image to be freed.
+ */
+void ImagePixelsFree(IMAGE_PIXELS *lpImage) {
+	if (lpImage->lpBits != NULL)
+		free(lpImage->lpBits);
+
+	lpImage->lpBits = NULL;
+}
+
+/**
+ * Gets the size of a row of pixels including its padding.
+ *
+ * @param  nWidth Width of the image in pixels.
+ * @return        Size of a row in bytes.
+ */
+long ImageStride(long nWidth) {
+	return ((nWidth * 3) + 3) & ~3L;
+}
+
+/**
+ * Decodes an uncompressed BMP file, in any of the bit depths and header
+ * versions that are found in the wild.
+ *
+ * @param  lpData  Contents of the file.
+ * @param  cbData  Size of the file in bytes.
+ * @param  lpImage Image to receive the pixels. Free it with ImagePixelsFree.
+ * @return         IMAGE_OK if the image was decoded or IMAGE_ERR_FORMAT if
+ *                 this isn't a kind of file we understand.
+ */
+int ImageDecodeBmp(const unsigned char *lpData, size_t cbData,
+				   IMAGE_PIXELS *lpImage) {
+	unsigned char abPalette[256][3];
+	BMP_CHANNEL abcChannels[3];
+	const unsigned char *lpRow;
+	const unsigned char *lpPalette;
+	unsigned char *lpPixel;
+	unsigned long cbHeader;
+	unsigned long dwOffset;
+	unsigned long dwCompression;
+	unsigned long dwPixel;
+	unsigned long nColors;
+	unsigned long cbColor;
+	long nWidth;
+	long nHeight;
+	long nBitCount;
+	long nSourceStride;
+	long x;
+	long y;
+	int fTopDown;
+	int nResult;
+	int i;
+
+	lpImage->lpBits = NULL;
+
+	// Check the file header.
+	if ((cbData < (BMP_FILE_HEADER + BMP_CORE_HEADER)) || (lpData[0] != 'B') ||
+			(lpData[1] != 'M')) {
+		return IMAGE_ERR_FORMAT;
+	}
+	dwOffset = ReadLE32(lpData + 10);
+	cbHeader = ReadLE32(lpData + BMP_FILE_HEADER);
+
+	// Read the image header.
+	if (cbHeader == BMP_CORE_HEADER) {
+		nWidth = (long)ReadLE16(lpData + 18);
+		nHeight = (long)ReadLE16(lpData + 20);
+		nBitCount = (long)ReadLE16(lpData + 24);
+		dwCompression = BMP_RGB;
+		nColors = 0;
+		cbColor = 3;
+	} else if ((cbHeader >= BMP_INFO_HEADER) &&
+			(cbHeader <= (cbData - BMP_FILE_HEADER))) {
+		nWidth = ReadSignedLE32(lpData + 18);
+		nHeight = ReadSignedLE32(lpData + 22);
+		nBitCount = (long)ReadLE16(lpData + 28);
+		dwCompression = ReadLE32(lpData + 30);
+		nColors = ReadLE32(lpData + 46);
+		cbColor = 4;
+	} else {
+		return IMAGE_ERR_FORMAT;
+	}
+
+	// Bottom-up is the norm, a negative height means it's top-down.
+	fTopDown = nHeight < 0;
+	if (fTopDown)
+		nHeight = -nHeight;
+	if ((nWidth <= 0) || (nHeight <= 0))
+		return IMAGE_ERR_CORRUPT;
+	if ((nWidth > IMAGE_MAX_DIMENSION) || (nHeight > IMAGE_MAX_DIMENSION))
+		return IMAGE_ERR_TOOBIG;
+
+	// Get the palette or the layout of the pixels.
+	switch (nBitCount) {
+	case 1:
+	case 4:
+	case 8:
+		if (dwCompression != BMP_RGB)
+			return IMAGE_ERR_FORMAT;
+		if ((nColors == 0) || (nColors > (1UL << nBitCount)))
+			nColors = 1UL << nBitCount;
+		if ((nColors * cbColor) > (cbData - BMP_FILE_HEADER - cbHeader))
+			return IMAGE_ERR_CORRUPT;
+
+		// Colors past the ones in the file are black.
+		memset(abPalette, 0, sizeof(abPalette));
+		lpPalette = lpData + BMP_FILE_HEADER + cbHeader;
+		for (i = 0; i < (int)nColors; i++) {
+			abPalette[i][0] = lpPalette[(i * cbColor)];
+			abPalette[i][1] = lpPalette[(i * cbColor) + 1];
+			abPalette[i][2] = lpPalette[(i * cbColor) + 2];
+		}
+		break;
+	case 16:
+	case 32:
+		if (dwCompression == BMP_BITFIELDS) {
+			// The masks follow the header or are part of the newer ones.
+			if ((cbHeader == BMP_CORE_HEADER) ||
+					(cbData < (BMP_FILE_HEADER + BMP_INFO_HEADER + 12))) {
+				return IMAGE_ERR_CORRUPT;
+			}
+			SetupChannel(&abcChannels[2], ReadLE32(lpData + 54));
+			SetupChannel(&abcChannels[1], ReadLE32(lpData + 58));
+			SetupChannel(&abcChannels[0], ReadLE32(lpData + 62));
+		} else if (dwCompression != BMP_RGB) {
+			return IMAGE_ERR_FORMAT;
+		} else if (nBitCount == 16) {
+			SetupChannel(&abcChannels[2], 0x7C00UL);
+			SetupChannel(&abcChannels[1], 0x03E0UL);
+			SetupChannel(&abcChannels[0], 0x001FUL);
+		} else {
+			SetupChannel(&abcChannels[2], 0xFF0000UL);
+			SetupChannel(&abcChannels[1], 0x00FF00UL);
+			SetupChannel(&abcChannels[0], 0x0000FFUL);
+		}
+		break;
+	case 24:
+		if (dwCompression != BMP_RGB)
+			return IMAGE_ERR_FORMAT;
+		break;
+	default:
+		return IMAGE_ERR_FORMAT;
+	}
+
+	// Make sure all of the pixels are in the file.
+	nSourceStride = (((nWidth * nBitCount) + 31) / 32) * 4;
+	if ((dwOffset > cbData) ||
+			(((cbData - dwOffset) / (size_t)nSourceStride) < (size_t)nHeight)) {
+		return IMAGE_ERR_CORRUPT;
+	}
+
+	// Convert the pixels.
+	nResult = ImagePixelsAllocate(lpImage, nWidth, nHeight);
+	if (nResult != IMAGE_OK)
+		return nResult;
+	for (y = 0; y < nHeight; y++) {
+		lpRow = lpData + dwOffset + ((fTopDown ? y : (nHeight - 1 - y)) *
+			nSourceStride);
+		lpPixel = lpImage->lpBits + (y * lpImage->nStride);
+
+		switch (nBitCount) {
+		case 24:
+			memcpy(lpPixel, lpRow, (size_t)(nWidth * 3));
+			break;
+		case 16:
+		case 32:
+			for (x = 0; x < nWidth; x++) {
+				if (nBitCount == 16) {
+					dwPixel = ReadLE16(lpRow + (x * 2));
+				} else {
+					dwPixel = ReadLE32(lpRow + (x * 4));
+				}
+
+				*lpPixel++ = ExtractChannel(&abcChannels[0], dwPixel);
+				*lpPixel++ = ExtractChannel(&abcChannels[1], dwPixel);
+				*lpPixel++ = ExtractChannel(&abcChannels[2], dwPixel);
+			}
+			break;
+		default:
+			for (x = 0; x < nWidth; x++) {
+				// Pick the index out of the packed bits.
+				dwPixel = lpRow[(x * nBitCount) / 8];
+				dwPixel >>= 8 - nBitCount - ((x * nBitCount) % 8);
+				dwPixel &= (1UL << nBitCount) - 1;
+
+				*lpPixel++ = abPalette[dwPixel][0];
+				*lpPixel++ = abPalette[dwPixel][1];
+				*lpPixel++ = abPalette[dwPixel][2];
+			}
+			break;
+		}
+	}
+
+	return IMAGE_OK;
+}
+
+/**
+ * Calculates the size of an image shrunk to fit a width, keeping its aspect
+ * ratio. Images that already fit are left alone.
+ *
+ * @param nWidth    Width of the image.
+ * @param nHeight   Height of the image.
+ * @param nMaxWidth Maximum width of the image.
+ * @param lpnWidth  Width of the shrunk image.
+ * @param lpnHeight Height of the shrunk image.
+ */
+void ImageScaledSize(long nWidth, long nHeight, long nMaxWidth,
+					 long *lpnWidth, long *lpnHeight) {
+	// Check if it already fits.
+	if ((nMaxWidth <= 0) || (nWidth <= nMaxWidth)) {
+		*lpnWidth = nWidth;
+		*lpnHeight = nHeight;
+		return;
+	}
+
+	*lpnWidth = nMaxWidth;
+	*lpnHeight = ((nHeight * nMaxWidth) + (nWidth / 2)) / nWidth;
+	if (*lpnHeight < 1)
+		*lpnHeight = 1;
+}
+
+/**
+ * Shrinks an image to a smaller size.
+ *
+ * @param  lpSource Image to be shrunk.
+ * @param  nWidth   Width of the new image, up to the width of the source.
+ * @param  nHeight  Height of the new image, up to the height of the source.
+ * @param  lpScaled Image to receive the shrunk version. Free it with
+ *                  ImagePixelsFree.
+ * @return          IMAGE_OK if the image was shrunk.
+ */
+int ImageDownscale(const IMAGE_PIXELS *lpSource, long nWidth, long nHeight,
+				   IMAGE_PIXELS *lpScaled) {
+	const SCALE_SPAN *lpSpan;
+	SCALE_SPAN *lpColumns;
+	SCALE_SPAN *lpRows;
+	unsigned long *lpColumnWeights;
+	unsigned long *lpRowWeights;
+	unsigned long *lpScaledRow;
+	unsigned long *lpSum;
+	unsigned long dwWeight;
+	unsigned long dwDivisor;
+	unsigned char *lpPixel;
+	long nLastRow;
+	long nValues;
+	long iRow;
+	long x;
+	long y;
+	int nResult;
+
+	lpScaled->lpBits = NULL;
+
+	// We only make things smaller.
+	if ((nWidth > lpSource->nWidth) || (nHeight > lpSource->nHeight))
+		return IMAGE_ERR_TOOBIG;
+	nResult = ImagePixelsAllocate(lpScaled, nWidth, nHeight);
+	if (nResult != IMAGE_OK)
+		return nResult;
+
+	// Work out which source pixels go into each target one.
+	nValues = nWidth * 3;
+	lpColumns = BuildSpans(lpSource->nWidth, nWidth, &lpColumnWeights);
+	lpRows = BuildSpans(lpSource->nHeight, nHeight, &lpRowWeights);
+	lpScaledRow = (unsigned long*)malloc(sizeof(unsigned long) * nValues * 2);
+	if ((lpColumns == NULL) || (lpRows == NULL) || (lpScaledRow == NULL)) {
+		FreeSpans(lpColumns, lpColumnWeights);
+		FreeSpans(lpRows, lpRowWeights);
+		if (lpScaledRow != NULL)
+			free(lpScaledRow);
+		ImagePixelsFree(lpScaled);
+
+		return IMAGE_ERR_MEMORY;
+	}
+	lpSum = lpScaledRow + nValues;
+
+	// Shrink every row that makes up a target row and mix them together.
+	dwDivisor = (unsigned long)lpSource->nHeight * SCALE_PRECISION;
+	nLastRow = -1;
+	for (y = 0; y < nHeight; y++) {
+		lpSpan = &lpRows[y];
+		memset(lpSum, 0, sizeof(unsigned long) * nValues);
+
+		for (iRow = 0; iRow < lpSpan->nCount; iRow++) {
+			// A source row shared with the previous target row is reused.
+			if ((lpSpan->nFirst + iRow) != nLastRow) {
+				nLastRow = lpSpan->nFirst + iRow;
+				ScaleRow(lpSource->lpBits + (nLastRow * lpSource->nStride),
+					lpColumns, lpColumnWeights, nWidth, lpSource->nWidth,
+					lpScaledRow);
+			}
+
+			dwWeight = lpRowWeights[lpSpan->iWeight + iRow];
+			for (x = 0; x < nValues; x++)
+				lpSum[x] += lpScaledRow[x] * dwWeight;
+		}
+
+		lpPixel = lpScaled->lpBits + (y * lpScaled->nStride);
+		for (x = 0; x < nValues; x++)
+			lpPixel[x] = (unsigned char)((lpSum[x] + (dwDivisor / 2)) /
+				dwDivisor);
+	}
+
+	// Clean up.
+	FreeSpans(lpColumns, lpColumnWeights);
+	FreeSpans(lpRows, lpRowWeights);
+	free(lpScaledRow);
+
+	return IMAGE_OK;
+}
+
+/**
+ * Works out how much each source pixel covers of every target pixel along an
+ * axis. Both are laid over a grid of nSource * nTarget units, where a source
+ * pixel is nTarget units long and a target pixel is nSource units long, so
+ * that every overlap is a whole number.
+ *
+ * @param  nSource    Number of source pixels.
+ * @param  nTarget    Number of target pixels.
+ * @param  lppWeights Pointer to receive the weights of the spans.
+ * @return            Span of every target pixel or NULL if we ran out of
+ *                    memory.
+ */
+SCALE_SPAN* BuildSpans(long nSource, long nTarget, unsigned long **lppWeights) {
+	SCALE_SPAN *lpSpans;
+	unsigned long *lpWeights;
+	long nStart;
+	long nEnd;
+	long nFrom;
+	long nTo;
+	long nWeight;
+	long i;
+	long j;
+
+	// Every target pixel overlaps at most one source pixel with the next one.
+	*lppWeights = NULL;
+	lpSpans = (SCALE_SPAN*)malloc(sizeof(SCALE_SPAN) * nTarget);
+	lpWeights = (unsigned long*)malloc(sizeof(unsigned long) *
+		(nSource + nTarget));
+	if ((lpSpans == NULL) || (lpWeights == NULL)) {
+		FreeSpans(lpSpans, lpWeights);
+		return NULL;
+	}
+
+	nWeight = 0;
+	for (j = 0; j < nTarget; j++) {
+		nStart = j * nSource;
+		nEnd = nStart + nSource;
+
+		lpSpans[j].nFirst = nStart / nTarget;
+		lpSpans[j].nCount = ((nEnd - 1) / nTarget) - lpSpans[j].nFirst + 1;
+		lpSpans[j].iWeight = nWeight;
+
+		for (i = lpSpans[j].nFirst; i < (lpSpans[j].nFirst +
+				lpSpans[j].nCount); i++) {
+			nFrom = i * nTarget;
+			nTo = nFrom + nTarget;
+			if (nFrom < nStart)
+				nFrom = nStart;
+			if (nTo > nEnd)
+				nTo = nEnd;
+
+			lpWeights[nWeight++] = (unsigned long)(nTo - nFrom);
+		}
+	}
+
+	*lppWeights = lpWeights;
+	return lpSpans;
+}
+
+/**
+ * Frees the spans built by BuildSpans.
+ *
+ * @param lpSpans   Spans to be freed or NULL.
+ * @param lpWeights Weights of the spans or NULL.
+ */
+void FreeSpans(SCALE_SPAN *lpSpans, unsigned long *lpWeights) {
+	if (lpSpans != NULL)
+		free(lpSpans);
+	if (lpWeights != NULL)
+		free(lpWeights);
+}
+
+/**
+ * Shrinks a single row of pixels, keeping some extra precision for when the
+ * rows are mixed together.
+ *
+ * @param lpRow     Source row.
+ * @param lpSpans   Span of every target pixel.
+ * @param lpWeights Weights of the spans.
+ * @param nTarget   Width of the target row.
+ * @param nSource   Width of the source row.
+ * @param lpOutput  Buffer to receive the 3 values of every target pixel
+ *                  multiplied by SCALE_PRECISION.
+ */
+void ScaleRow(const unsigned char *lpRow, const SCALE_SPAN *lpSpans,
+			  const unsigned long *lpWeights, long nTarget, long nSource,
+			  unsigned long *lpOutput) {
+	const unsigned char *lpPixel;
+	const unsigned long *lpWeight;
+	unsigned long dwBlue;
+	unsigned long dwGreen;
+	unsigned long dwRed;
+	unsigned long dwRound;
+	long i;
+	long j;
+
+	dwRound = (unsigned long)nSource / 2;
+	for (j = 0; j < nTarget; j++) {
+		lpPixel = lpRow + (lpSpans[j].nFirst * 3);
+		lpWeight = lpWeights + lpSpans[j].iWeight;
+		dwBlue = 0;
+		dwGreen = 0;
+		dwRed = 0;
+
+		for (i = 0; i < lpSpans[j].nCount; i++) {
+			dwBlue += lpPixel[0] * lpWeight[i];
+			dwGreen += lpPixel[1] * lpWeight[i];
+			dwRed += lpPixel[2] * lpWeight[i];
+			lpPixel += 3;
+		}
+
+		*lpOutput++ = ((dwBlue * SCALE_PRECISION) + dwRound) / nSource;
+		*lpOutput++ = ((dwGreen * SCALE_PRECISION) + dwRound) / nSource;
+		*lpOutput++ = ((dwRed * SCALE_PRECISION) + dwRound) / nSource;
+	}
+}
+
+/**
+ * Reads a little-endian 16-bit value.
+ *
+ * @param  lpData Where the value is.
+ * @return        The value.
+ */
+unsigned long ReadLE16(const unsigned char *lpData) {
+	return (unsigned long)lpData[0] | ((unsigned long)lpData[1] << 8);
+}
+
+/**
+ * Reads a little-endian 32-bit value.
+ *
+ * @param  lpData Where the value is.
+ * @return        The value.
+ */
+unsigned long ReadLE32(const unsigned char *lpData) {
+	return (unsigned long)lpData[0] | ((unsigned long)lpData[1] << 8) |
+		((unsigned long)lpData[2] << 16) | ((unsigned long)lpData[3] << 24);
+}
+
+/**
+ * Reads a little-endian signed 32-bit value.
+ *
+ * @param  lpData Where the value is.
+ * @return        The value.
+ */
+long ReadSignedLE32(const unsigned char *lpData) {
+	unsigned long dwValue = ReadLE32(lpData);
+
+	if (dwValue & 0x80000000UL)
+		return -(long)((~dwValue + 1) & 0x7FFFFFFFUL);
+
+	return (long)dwValue;
+}
+
+/**
+ * Sets up the extraction of a color channel from its mask.
+ *
+ * @param lpChannel Channel to be set up.
+ * @param dwMask    Bits of the pixel that make up the channel.
+ */
+void SetupChannel(BMP_CHANNEL *lpChannel, unsigned long dwMask) {
+	lpChannel->dwMask = dwMask & 0xFFFFFFFFUL;
+	lpChannel->nShift = 0;
+	lpChannel->nBits = 0;
+
+	// Find where the channel starts and how wide it is.
+	if (lpChannel->dwMask == 0)
+		return;
+	while (!((lpChannel->dwMask >> lpChannel->nShift) & 1))
+		lpChannel->nShift++;
+	while ((lpChannel->nShift + lpChannel->nBits) < 32 &&
+			((lpChannel->dwMask >> (lpChannel->nShift + lpChannel->nBits)) & 1))
+		lpChannel->nBits++;
+}
+
+/**
+ * Gets the 8-bit value of a color channel from a pixel.
+ *
+ * @param  lpChannel Channel to extract.
+ * @param  dwPixel   Pixel value.
+ * @return           Value of the channel stretched to 8 bits.
+ */
+unsigned char ExtractChannel(const BMP_CHANNEL *lpChannel,
+							 unsigned long dwPixel) {
+	unsigned long dwValue;
+	unsigned long dwMax;
+
+	if (lpChannel->nBits == 0)
+		return 0;
+	dwValue = (dwPixel & lpChannel->dwMask) >> lpChannel->nShift;
+
+	// Wide channels just lose their lower bits, narrow ones get stretched.
+	if (lpChannel->nBits >= 8)
+		return (unsigned char)(dwValue >> (lpChannel->nBits - 8));
+	dwMax = (1UL << lpChannel->nBits) - 1;
+	return (unsigned char)(((dwValue * 255) + (dwMax / 2)) / dwMax);
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+/**
+ * ImageScale.h
+ * A platform-neutral decoder and downscaler for the images shown in the page
+ * viewer.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _IMAGESCALE_H
+#define _IMAGESCALE_H
+
+#include <stddef.h>
+
+// Largest width or height of an image we are willing to decode.
+#define IMAGE_MAX_DIMENSION 4096
+
+// Results.
+#define IMAGE_OK          0
+#define IMAGE_ERR_MEMORY  1
+#define IMAGE_ERR_FORMAT  2
+#define IMAGE_ERR_CORRUPT 3
+#define IMAGE_ERR_TOOBIG  4
+
+// An image as top-down rows of 24-bit BGR pixels, each row padded to a
+// multiple of 4 bytes, exactly like the bits of a DIB section.
+typedef struct {
+	long nWidth;
+	long nHeight;
+	long nStride;
+	unsigned char *lpBits;
+} IMAGE_PIXELS;
+
+// Allocation.
+int ImagePixelsAllocate(IMAGE_PIXELS *lpImage, long nWidth, long nHeight);
+void ImagePixelsFree(IMAGE_PIXELS *lpImage);
+long ImageStride(long nWidth);
+
+// Decoding.
+int ImageDecodeBmp(const unsigned char *lpData, size_t cbData,
+				   IMAGE_PIXELS *lpImage);
+
+// Scaling.
+void ImageScaledSize(long nWidth, long nHeight, long nMaxWidth,
+					 long *lpnWidth, long *lpnHeight);
+int ImageDownscale(const IMAGE_PIXELS *lpSource, long nWidth, long nHeight,
+				   IMAGE_PIXELS *lpScaled);
+
+#endif  // _IMAGESCALE_H
\ No newline at end of file
@@ -0,0 +1,303 @@
+/**
+ * PageImport.c
+ * Imports many pages into the Uki workspace in a single batch.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "PageImport.h"
+#include "Utilities.h"
+#include "DependencyIndex.h"
+
+// Definitions.
+#define PAGEIMPORT_MAX_WORKERS 4
+#define PAGEIMPORT_PATTERN     L"*.htm*"
+
+// Work shared between all of the copying threads.
+typedef struct {
+	LPCTSTR *lpszFiles;
+	LONG nFiles;
+	LONG nNextFile;
+	LPCTSTR szFolder;
+	LPBYTE lpfCopied;
+} PAGEIMPORT_JOB;
+
+// Private methods.
+DWORD WINAPI PageImportThread(LPVOID lpParam);
+BOOL BuildImportPath(LPTSTR szTarget, LPCTSTR szFolder, LPCTSTR szSource);
+BOOL ListFolderPages(LPCTSTR szFolder, LPTSTR *lpszPool, LPCTSTR **lppszFiles,
+					 LONG *lpnFiles);
+
+/**
+ * Imports a list of page files into the workspace. The files are copied into
+ * the articles or templates folder by a small pool of threads, and only then
+ * registered with the engine one after the other, so that the TreeView and
+ * the dependency index only have to be updated once for the whole batch.
+ * Files that would overwrite a page of the workspace are not imported.
+ *
+ * @param  lpszFiles  Paths to the files to be imported.
+ * @param  nFiles     Number of files in the list.
+ * @param  fIsArticle Are the files articles?
+ * @param  lpReport   Report to receive the pages that were added.
+ * @return            TRUE if the operation was successful, even if some of the
+ *                    files couldn't be imported.
+ */
+BOOL ImportPageFiles(LPCTSTR *lpszFiles, LONG nFiles, BOOL fIsArticle,
+					 PAGEIMPORT_REPORT *lpReport) {
+	HANDLE ahWorkers[PAGEIMPORT_MAX_WORKERS];
+	TCHAR szTarget[MAX_PATH];
+	PAGEIMPORT_JOB piJob;
+	SYSTEM_INFO siSystem;
+	DWORD dwThreadID;
+	DWORD nWorkers;
+	DWORD iWorker;
+	LONG iFile;
+	LONG nIndex;
+
+	// Start with an empty report.
+	lpReport->ukiAdded.nFirstNewArticle = GetUkiArticlesAvailable();
+	lpReport->ukiAdded.nFirstNewTemplate = GetUkiTemplatesAvailable();
+	lpReport->ukiAdded.nAdded = 0L;
+	lpReport->ukiAdded.nRemoved = 0L;
+	lpReport->ukiAdded.nChanged = 0L;
+	lpReport->ukiAdded.fManifestChanged = FALSE;
+	lpReport->nFailed = 0L;
+
+	// Set up the job.
+	piJob.lpszFiles = lpszFiles;
+	piJob.nFiles = nFiles;
+	piJob.nNextFile = 0L;
+	piJob.szFolder = (fIsArticle) ? GetUkiArticlesFolder() :
+		GetUkiTemplatesFolder();
+	if (piJob.szFolder == NULL)
+		return FALSE;
+	if (nFiles <= 0L)
+		return TRUE;
+	piJob.lpfCopied = (LPBYTE)LocalAlloc(LPTR, nFiles);
+	if (piJob.lpfCopied == NULL)
+		return FALSE;
+
+	// Copying is all waiting on the disk, so a few threads keep it busy even
+	// on a single processor. The calling thread is one of them.
+	GetSystemInfo(&siSystem);
+	nWorkers = siSystem.dwNumberOfProcessors;
+	if (nWorkers < PAGEIMPORT_MAX_WORKERS)
+		nWorkers = PAGEIMPORT_MAX_WORKERS;
+	nWorkers--;
+	if (nWorkers >= (DWORD)nFiles)
+		nWorkers = (DWORD)nFiles - 1;
+
+	// Fan out the files and pitch in until they've all been taken.
+	for (iWorker = 0; iWorker < nWorkers; iWorker++) {
+		ahWorkers[iWorker] = CreateThread(NULL, 0, PageImportThread,
+			(LPVOID)&piJob, 0, &dwThreadID);
+		if (ahWorkers[iWorker] == NULL)
+			break;
+	}
+	nWorkers = iWorker;
+	PageImportThread((LPVOID)&piJob);
+
+	// Wait for the others to finish their last files.
+	if (nWorkers > 0) {
+		WaitForMultipleObjects(nWorkers, ahWorkers, TRUE, INFINITE);
+		for (iWorker = 0; iWorker < nWorkers; iWorker++)
+			CloseHandle(ahWorkers[iWorker]);
+	}
+
+	// Register the copies with the engine in the order they were given.
+	for (iFile = 0L; iFile < nFiles; iFile++) {
+		nIndex = -1L;
+		if (piJob.lpfCopied[iFile]) {
+			BuildImportPath(szTarget, piJob.szFolder, lpszFiles[iFile]);
+			nIndex = (fIsArticle) ? AddUkiArticle(szTarget) :
+				AddUkiTemplate(szTarget);
+		}
+
+		if (nIndex >= 0L) {
+			lpReport->ukiAdded.nAdded++;
+		} else {
+			lpReport->nFailed++;
+		}
+	}
+	LocalFree(piJob.lpfCopied);
+
+	// The new pages may depend on the others or be depended upon.
+	if ((lpReport->ukiAdded.nAdded > 0L) && IsDependencyIndexReady())
+		BuildDependencyIndex();
+
+	return TRUE;
+}
+
+/**
+ * Imports every page file inside a folder into the workspace.
+ *
+ * @param  szFolder   Folder with the files to be imported.
+ * @param  fIsArticle Are the files articles?
+ * @param  lpReport   Report to receive the pages that were added.
+ * @return            TRUE if the operation was successful, even if some of the
+ *                    files couldn't be imported.
+ */
+BOOL ImportPageFolder(LPCTSTR szFolder, BOOL fIsArticle,
+					  PAGEIMPORT_REPORT *lpReport) {
+	LPCTSTR *lpszFiles;
+	LPTSTR szPool;
+	LONG nFiles;
+	BOOL bSuccess;
+
+	// Get the files.
+	if (!ListFolderPages(szFolder, &szPool, &lpszFiles, &nFiles))
+		return FALSE;
+
+	// Import them.
+	bSuccess = ImportPageFiles(lpszFiles, nFiles, fIsArticle, lpReport);
+	if (szPool != NULL)
+		LocalFree(szPool);
+	if (lpszFiles != NULL)
+		LocalFree(lpszFiles);
+
+	return bSuccess;
+}
+
+/**
+ * Takes files from the shared job and copies them into the workspace until
+ * there are none left.
+ *
+ * @param  lpParam Pointer to the shared job.
+ * @return         Always 0.
+ */
+DWORD WINAPI PageImportThread(LPVOID lpParam) {
+	PAGEIMPORT_JOB *lpJob = (PAGEIMPORT_JOB*)lpParam;
+	TCHAR szTarget[MAX_PATH];
+	LONG iFile;
+
+	iFile = InterlockedIncrement(&lpJob->nNextFile) - 1;
+	while (iFile < lpJob->nFiles) {
+		// Never overwrite a page that is already in the workspace.
+		lpJob->lpfCopied[iFile] = BuildImportPath(szTarget, lpJob->szFolder,
+			lpJob->lpszFiles[iFile]) && CopyFile(lpJob->lpszFiles[iFile],
+			szTarget, TRUE);
+
+		iFile = InterlockedIncrement(&lpJob->nNextFile) - 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Builds the path a file gets when it's imported into a workspace folder.
+ *
+ * @param  szTarget Buffer with MAX_PATH characters to receive the path.
+ * @param  szFolder Workspace folder the file is going into.
+ * @param  szSource Path to the file being imported.
+ * @return          TRUE if the path fits in the buffer.
+ */
+BOOL BuildImportPath(LPTSTR szTarget, LPCTSTR szFolder, LPCTSTR szSource) {
+	LPCTSTR szName;
+
+	// Get the name of the file.
+	szName = wcsrchr(szSource, L'\\');
+	szName = (szName == NULL) ? szSource : szName + 1;
+
+	// Put it in the folder.
+	if ((wcslen(szFolder) + wcslen(szName) + 2) >= MAX_PATH)
+		return FALSE;
+	wsprintf(szTarget, L"%s\\%s", szFolder, szName);
+
+	return TRUE;
+}
+
+/**
+ * Lists the page files inside a folder. All of the paths are stored in a
+ * single pool, so a whole folder only takes two allocations.
+ * @remark Remember to free the pool and the list with LocalFree.
+ *
+ * @param  szFolder   Folder to be listed.
+ * @param  lpszPool   Pointer to receive the pool with the paths.
+ * @param  lppszFiles Pointer to receive the list of paths.
+ * @param  lpnFiles   Pointer to receive the number of paths in the list.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL ListFolderPages(LPCTSTR szFolder, LPTSTR *lpszPool, LPCTSTR **lppszFiles,
+					 LONG *lpnFiles) {
+	WIN32_FIND_DATA wfd;
+	TCHAR szPattern[MAX_PATH];
+	HANDLE hFind;
+	LPTSTR szPool;
+	LPTSTR szNewPool;
+	LPTSTR szPath;
+	DWORD cchPool;
+	DWORD cchUsed;
+	DWORD cchPath;
+	LONG iFile;
+	BOOL bSuccess;
+
+	*lpszPool = NULL;
+	*lppszFiles = NULL;
+	szPool = NULL;
+	*lpnFiles = 0L;
+
+	// Look for the pages.
+	if ((wcslen(szFolder) + wcslen(PAGEIMPORT_PATTERN) + 2) >= MAX_PATH)
+		return FALSE;
+	wsprintf(szPattern, L"%s\\%s", szFolder, PAGEIMPORT_PATTERN);
+	hFind = FindFirstFile(szPattern, &wfd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return TRUE;
+
+	// Append each path to the pool.
+	bSuccess = TRUE;
+	cchPool = 0;
+	cchUsed = 0;
+	do {
+		if (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			continue;
+
+		// Make room for it.
+		cchPath = (DWORD)(wcslen(szFolder) + wcslen(wfd.cFileName) + 2);
+		if (cchPath > MAX_PATH)
+			continue;
+		if ((cchUsed + cchPath) > cchPool) {
+			cchPool = (cchPool == 0) ? (MAX_PATH * 16) : (cchPool * 2);
+			if (szPool == NULL) {
+				szNewPool = (LPTSTR)LocalAlloc(LMEM_FIXED,
+					cchPool * sizeof(TCHAR));
+			} else {
+				szNewPool = (LPTSTR)LocalReAlloc(szPool,
+					cchPool * sizeof(TCHAR), LMEM_MOVEABLE);
+			}
+			if (szNewPool == NULL) {
+				bSuccess = FALSE;
+				break;
+			}
+			szPool = szNewPool;
+		}
+
+		// Append it.
+		wsprintf(szPool + cchUsed, L"%s\\%s", szFolder, wfd.cFileName);
+		cchUsed += cchPath;
+		(*lpnFiles)++;
+	} while (FindNextFile(hFind, &wfd));
+	FindClose(hFind);
+
+	// Point the list at the paths now that the pool won't move anymore.
+	if (bSuccess && (*lpnFiles > 0L)) {
+		*lppszFiles = (LPCTSTR*)LocalAlloc(LMEM_FIXED,
+			*lpnFiles * sizeof(LPCTSTR));
+		bSuccess = *lppszFiles != NULL;
+	}
+	if (!bSuccess) {
+		if (szPool != NULL)
+			LocalFree(szPool);
+		*lpnFiles = 0L;
+
+		return FALSE;
+	}
+	szPath = szPool;
+	for (iFile = 0L; iFile < *lpnFiles; iFile++) {
+		(*lppszFiles)[iFile] = szPath;
+		szPath += wcslen(szPath) + 1;
+	}
+	*lpszPool = szPool;
+
+	return TRUE;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+/**
+ * PageImport.h
+ * Imports many pages into the Uki workspace in a single batch.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _PAGEIMPORT_H
+#define _PAGEIMPORT_H
+
+#include <windows.h>
+#include "UkiHelper.h"
+
+// Outcome of an import. The added pages are described the same way as the
+// ones found by a workspace refresh, so the TreeView can be patched with them.
+typedef struct {
+	UKIREFRESH ukiAdded;
+	LONG nFailed;
+} PAGEIMPORT_REPORT;
+
+// Importing.
+BOOL ImportPageFiles(LPCTSTR *lpszFiles, LONG nFiles, BOOL fIsArticle,
+					 PAGEIMPORT_REPORT *lpReport);
+BOOL ImportPageFolder(LPCTSTR szFolder, BOOL fIsArticle,
+					  PAGEIMPORT_REPORT *lpReport);
+
+#endif  // _PAGEIMPORT_H
\ No newline at end of file
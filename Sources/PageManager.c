@@ -10,7 +10,36 @@
 #include "CommonDlgManager.h"
 #include "UkiHelper.h"
 #include "Utilities.h"
+#include "ContentHash.h"
+#include "HtmlChunk.h"
+#include "RenderCache.h"
+#include "ImageCache.h"
+#include "EditJournal.h"
+#include "DependencyIndex.h"
 #include "resource.h"
+#include <string.h>
+
+// Sizes of the chunks fed to the page viewer. The first one is small so that
+// the top of the page shows up right away.
+#define PAGEVIEW_FIRST_CHUNK 1024
+#define PAGEVIEW_CHUNK       FILE_CHUNK_SIZE
+
+// Space left between the images and the border of the page viewer.
+#define PAGEVIEW_IMAGE_MARGIN 8
+
+// Limits of what's shown when asked what depends on a page or variable.
+#define DEPENDENTS_MAX_SHOWN 12
+#define DEPENDENTS_MAX_KEY   64
+#define DEPENDENTS_MAX_LINE  512
+#define DEPENDENTS_MSG_LEN   ((DEPENDENTS_MAX_SHOWN + 4) * 80)
+
+// State of a page being streamed into the controls.
+typedef struct {
+	BOOL fViewer;
+	DWORD cchLoaded;
+	DWORD dwStarted;
+	CONTENTHASH chText;
+} PAGELOAD;
 
 // Global variables.
 HINSTANCE hInst;
@@ -18,11 +47,40 @@ HINSTANCE hinstHTML;
 HWND hwndPageEdit;
 HWND hwndPageView;
 UKIARTICLE ukiOpenArticle;
+LONG nOpenArticle;
 UKITEMPLATE ukiOpenTemplate;
+FILETIME ftOpenPageModified;
+DWORD dwPageEditGeneration;
+BOOL fPageViewerCurrent;
+BOOL fPageViewerRendered;
+DWORD dwPageViewerGeneration;
+DWORD dwPageViewerRenderGeneration;
+PAGEVIEW_STATS pvsStats;
+BOOL fOpenPageHashed;
+DWORD dwOpenPageHash;
+DWORD dwDirtyCheckGeneration;
+BOOL fDirtyCheckResult;
 
 // Private methods.
 void ClearUkiState();
 BOOL ShowWelcomePage();
+BOOL GetCurrentPagePath(LPTSTR szPath);
+BOOL LoadPageContents(LPCTSTR szPath);
+BOOL AppendPageChunk(LPCTSTR szChunk, DWORD cchChunk, LPARAM lParam);
+BOOL ShowRenderedArticle();
+void SetPageViewerText(LPCTSTR szText, DWORD dwStarted);
+void ClearPageViewer();
+BOOL LoadPageViewImage(DWORD dwCookie, LPCTSTR szSource);
+BOOL GetPageImagePath(LPTSTR szPath, LPCTSTR szSource);
+void RecordPageViewFirstChunk(DWORD dwStarted);
+void RecordPageViewComplete(DWORD dwStarted);
+void SetPageViewerSource(BOOL fRendered);
+BOOL IsPageViewerCurrent();
+void SetPageEditText(LPCTSTR szText);
+void SetOpenPageHash(DWORD dwHash);
+BOOL IsPageEditTextSaved();
+BOOL IsPageTextOnDisk(LPCTSTR szText, DWORD cchText);
+BOOL GetSelectedKey(LPTSTR szKey);
 
 /**
  * Initializes the TreeView component.
@@ -57,7 +115,8 @@ BOOL InitializePageView(HINSTANCE hParentInst, HWND hwndParent, RECT rcClient,
 		rcClient.left, rcClient.top, rcClient.right, rcClient.bottom,
 		hwndParent, hPageViewID, hInst, NULL);
 
-	// Make images fit the HTML viewer.
+	// Make images fit the HTML viewer. The ones we can decode ourselves are
+	// already shrunk by the image cache, this takes care of the rest.
 	SendMessage(hwndPageView, DTM_ENABLESHRINK, 0, (LPARAM)TRUE);
 	
 	return TRUE;
@@ -87,6 +146,10 @@ LRESULT SendPageEditMessage(UINT wMsg, WPARAM wParam, LPARAM lParam) {
 LRESULT PageEditHandleCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
 							  LPARAM lParam) {
 	switch(HIWORD(wParam)) {
+	case EN_CHANGE:
+		// Anything derived from the old text is now out of date.
+		dwPageEditGeneration++;
+		break;
 	default:
 		return DefWindowProc(hWnd, wMsg, wParam, lParam);
 	}
@@ -94,6 +157,35 @@ LRESULT PageEditHandleCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
 	return 0;
 }
 
+/**
+ * Process the WM_NOTIFY message for the page viewer.
+ *
+ * @param  hWnd   Window handler.
+ * @param  wMsg   Message type.
+ * @param  wParam Message parameter.
+ * @param  lParam Message parameter.
+ * @return        TRUE if we took care of the notification.
+ */
+LRESULT PageViewHandleNotify(HWND hWnd, UINT wMsg, WPARAM wParam,
+							 LPARAM lParam) {
+	NM_HTMLVIEW *lpnmView = (NM_HTMLVIEW*)lParam;
+	TCHAR szSource[UKI_MAX_PATH];
+
+	switch (lpnmView->hdr.code) {
+	case NM_INLINE_IMAGE:
+		// Serve the image from our cache, otherwise let the viewer load it.
+		if ((lpnmView->szTarget == NULL) ||
+				(strlen(lpnmView->szTarget) >= UKI_MAX_PATH) ||
+				!ConvertStringAtoW(szSource, lpnmView->szTarget)) {
+			return FALSE;
+		}
+
+		return LoadPageViewImage(lpnmView->dwCookie, szSource);
+	}
+
+	return FALSE;
+}
+
 /**
  * Populates the page view with an article.
  *
@@ -102,29 +194,16 @@ LRESULT PageEditHandleCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
  */
 BOOL PopulatePageViewArticle(const size_t nIndex) {
 	TCHAR szPath[UKI_MAX_PATH];
-	LPTSTR szFileContents;
 
 	// Clear our Uki state.
 	ClearUkiState();
 
-	// Get article and file contents.
+	// Get article and its contents.
 	GetUkiArticle(&ukiOpenArticle, nIndex);
 	GetUkiArticlePath(szPath, ukiOpenArticle);
-	ReadFileContents(szPath, &szFileContents);
-
-	// Set contents.
-	SendMessage(hwndPageEdit, WM_SETTEXT, 0, (LPARAM)szFileContents);
-    SendMessage(hwndPageView, WM_SETTEXT, 0, (LPARAM)L"");
-    SendMessage(hwndPageView, DTM_ADDTEXTW, 0, (LPARAM)szFileContents);
-    SendMessage(hwndPageView, DTM_ENDOFSOURCE, 0, 0);
-
-	// Clear the modification flag of the edit control.
-	SendMessage(hwndPageEdit, EM_SETMODIFY, (WPARAM)FALSE, 0);
+	nOpenArticle = (LONG)nIndex;
 
-	// Free the file contents buffer.
-	LocalFree(szFileContents);
-
-	return TRUE;
+	return LoadPageContents(szPath);
 }
 
 /**
@@ -135,58 +214,429 @@ BOOL PopulatePageViewArticle(const size_t nIndex) {
  */
 BOOL PopulatePageViewTemplate(const size_t nIndex) {
 	TCHAR szPath[UKI_MAX_PATH];
-	LPTSTR szFileContents;
 
 	// Clear our Uki state.
 	ClearUkiState();
 
-	// Get template and file contents.
+	// Get template and its contents.
 	GetUkiTemplate(&ukiOpenTemplate, nIndex);
 	GetUkiTemplatePath(szPath, ukiOpenTemplate);
-	ReadFileContents(szPath, &szFileContents);
 
-	// Set contents.
-	SendMessage(hwndPageEdit, WM_SETTEXT, 0, (LPARAM)szFileContents);
-    SendMessage(hwndPageView, WM_SETTEXT, 0, (LPARAM)L"");
-    SendMessage(hwndPageView, DTM_ADDTEXTW, 0, (LPARAM)szFileContents);
-    SendMessage(hwndPageView, DTM_ENDOFSOURCE, 0, 0);
+	return LoadPageContents(szPath);
+}
 
-	// Clear the modification flag of the edit control.
+/**
+ * Reloads the currently open page from its file.
+ *
+ * @return TRUE if the operation was successful.
+ */
+BOOL ReloadCurrentPage() {
+	TCHAR szPath[UKI_MAX_PATH];
+
+	// Get the path of the open page.
+	if (!GetCurrentPagePath(szPath))
+		return FALSE;
+
+	return LoadPageContents(szPath);
+}
+
+/**
+ * Checks if the file of the currently open page was modified by someone else
+ * since we loaded or saved it. A file that was only touched, or written back
+ * with the same text, doesn't count as changed.
+ *
+ * @return TRUE if the file was changed.
+ */
+BOOL IsPageChangedOnDisk() {
+	TCHAR szPath[UKI_MAX_PATH];
+	FILETIME ftModified;
+	LPTSTR szText;
+	DWORD cchText;
+	BOOL fChanged;
+
+	// Get the path of the open page and its modification time.
+	if (!GetCurrentPagePath(szPath))
+		return FALSE;
+	if (!GetFileModifiedTime(szPath, &ftModified))
+		return FALSE;
+	if (CompareFileTime(&ftModified, &ftOpenPageModified) == 0)
+		return FALSE;
+
+	// Check if the text really changed.
+	if (!fOpenPageHashed || !ReadFileText(szPath, &szText, &cchText))
+		return TRUE;
+	fChanged = ContentHashBuffer(szText, cchText * sizeof(TCHAR)) !=
+		dwOpenPageHash;
+	LocalFree(szText);
+
+	// Nothing to reload, so just remember the new modification time.
+	if (!fChanged)
+		ftOpenPageModified = ftModified;
+
+	return fChanged;
+}
+
+/**
+ * Loads the contents of a page file into the editor and viewer.
+ *
+ * @param  szPath Path to the page file.
+ * @return        TRUE if the operation was successful.
+ */
+BOOL LoadPageContents(LPCTSTR szPath) {
+	PAGELOAD plLoad;
+	BOOL bSuccess;
+
+	// Start from empty controls. Articles are shown rendered, everything else
+	// is streamed into the viewer as it is.
+	SetPageEditText(L"");
 	SendMessage(hwndPageEdit, EM_SETMODIFY, (WPARAM)FALSE, 0);
+	plLoad.dwStarted = GetTickCount();
+	plLoad.fViewer = !ShowRenderedArticle();
+	plLoad.cchLoaded = 0;
+	ContentHashInitialize(&plLoad.chText);
+	if (plLoad.fViewer)
+		ClearPageViewer();
+
+	// Stream the file contents into the controls.
+	SendMessage(hwndPageEdit, WM_SETREDRAW, (WPARAM)FALSE, 0);
+	bSuccess = StreamFileContents(szPath, AppendPageChunk, (LPARAM)&plLoad);
+	SendMessage(hwndPageEdit, WM_SETREDRAW, (WPARAM)TRUE, 0);
+	InvalidateRect(hwndPageEdit, NULL, TRUE);
+	if (plLoad.fViewer) {
+		SendMessage(hwndPageView, DTM_ENDOFSOURCE, 0, 0);
+		RecordPageViewComplete(plLoad.dwStarted);
+	}
+	fPageViewerCurrent = FALSE;
+
+	// Go back to the top and clear the modification flag set by the appends.
+	SendMessage(hwndPageEdit, EM_SETSEL, 0, 0);
+	SendMessage(hwndPageEdit, EM_SCROLLCARET, 0, 0);
+	SendMessage(hwndPageEdit, EM_SETMODIFY, (WPARAM)FALSE, 0);
+	if (!bSuccess)
+		return FALSE;
 
-	// Free the file contents buffer.
-	LocalFree(szFileContents);
+	// Remember what was loaded and when the file was last modified to detect
+	// changes, and start journaling the edits made to it.
+	SetOpenPageHash((DWORD)ContentHashFinal(&plLoad.chText));
+	SetPageViewerSource(!plLoad.fViewer);
+	GetFileModifiedTime(szPath, &ftOpenPageModified);
+	ResetEditJournal(szPath, &ftOpenPageModified);
 
 	return TRUE;
 }
 
 /**
- * Shows the HTML viewer control.
+ * Appends a block of a page file being loaded to the editor and viewer.
+ *
+ * @param  szChunk   Block of the file contents.
+ * @param  cchChunk  Length of the block in characters.
+ * @param  lParam    Pointer to the PAGELOAD state of the load.
+ * @return           TRUE to continue loading.
+ */
+BOOL AppendPageChunk(LPCTSTR szChunk, DWORD cchChunk, LPARAM lParam) {
+	PAGELOAD *lpLoad = (PAGELOAD*)lParam;
+
+	// Append to the end of the editor.
+	SendMessage(hwndPageEdit, EM_SETSEL, (WPARAM)lpLoad->cchLoaded,
+		(LPARAM)lpLoad->cchLoaded);
+	SendMessage(hwndPageEdit, EM_REPLACESEL, (WPARAM)FALSE, (LPARAM)szChunk);
+	lpLoad->cchLoaded += cchChunk;
+	ContentHashUpdate(&lpLoad->chText, szChunk, cchChunk * sizeof(TCHAR));
+
+	// Feed the viewer as we go, showing the top of the page right away.
+	if (lpLoad->fViewer) {
+		SendMessage(hwndPageView, DTM_ADDTEXTW, 0, (LPARAM)szChunk);
+		if (lpLoad->cchLoaded == cchChunk) {
+			UpdateWindow(hwndPageView);
+			RecordPageViewFirstChunk(lpLoad->dwStarted);
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Shows the rendered version of the open article in the page viewer.
+ *
+ * @return TRUE if there was a saved article to be shown.
+ */
+BOOL ShowRenderedArticle() {
+	LPCTSTR szHTML;
+	DWORD dwStarted;
+
+	// Unsaved changes can't be rendered by the engine.
+	if (!IsArticleLoaded() || (nOpenArticle < 0L) || IsPageDirty())
+		return FALSE;
+
+	// Get the rendered article from the cache.
+	dwStarted = GetTickCount();
+	szHTML = GetRenderedArticle(nOpenArticle);
+	if (szHTML == NULL)
+		return FALSE;
+
+	SetPageViewerText(szHTML, dwStarted);
+	return TRUE;
+}
+
+/**
+ * Replaces the contents of the page viewer. The HTML is fed in chunks that end
+ * right after a tag, and the viewer is painted after the first one, so the top
+ * of a long page shows up before the rest of it was parsed.
+ *
+ * @param szText    HTML to be shown.
+ * @param dwStarted Tick count of when the page was asked for.
+ */
+void SetPageViewerText(LPCTSTR szText, DWORD dwStarted) {
+	TCHAR szChunk[PAGEVIEW_CHUNK + 1];
+	size_t cchText;
+	size_t cchMax;
+	size_t nStart;
+	size_t nEnd;
+
+	ClearPageViewer();
+
+	// Feed the viewer a chunk at a time.
+	cchText = wcslen(szText);
+	cchMax = PAGEVIEW_FIRST_CHUNK;
+	for (nStart = 0; nStart < cchText; nStart = nEnd) {
+		nEnd = HtmlChunkEnd((const unsigned short*)szText, cchText, nStart,
+			cchMax);
+		memcpy(szChunk, szText + nStart, (nEnd - nStart) * sizeof(TCHAR));
+		szChunk[nEnd - nStart] = L'\0';
+		SendMessage(hwndPageView, DTM_ADDTEXTW, 0, (LPARAM)szChunk);
+
+		// Paint the top of the page before going on with the rest.
+		if (nStart == 0) {
+			UpdateWindow(hwndPageView);
+			RecordPageViewFirstChunk(dwStarted);
+		}
+		cchMax = PAGEVIEW_CHUNK;
+	}
+
+	SendMessage(hwndPageView, DTM_ENDOFSOURCE, 0, 0);
+	RecordPageViewComplete(dwStarted);
+}
+
+/**
+ * Empties the page viewer, letting go of the images it was showing.
+ */
+void ClearPageViewer() {
+	SendMessage(hwndPageView, WM_SETTEXT, 0, (LPARAM)L"");
+	ReleaseShownImages();
+}
+
+/**
+ * Gives an image of the page to the viewer already shrunk to fit it.
+ *
+ * @param  dwCookie Identifier of the image in the viewer.
+ * @param  szSource Source of the image as it's in the page.
+ * @return          TRUE if the image was given to the viewer, FALSE if the
+ *                  viewer should load it by itself.
+ */
+BOOL LoadPageViewImage(DWORD dwCookie, LPCTSTR szSource) {
+	TCHAR szPath[UKI_MAX_PATH];
+	INLINEIMAGEINFO iiImage;
+	HBITMAP hbmImage;
+	RECT rcView;
+	LONG nWidth;
+	LONG nHeight;
+	BOOL fCached;
+
+	// Get the image that fits the viewer.
+	if (!GetPageImagePath(szPath, szSource))
+		return FALSE;
+	GetClientRect(hwndPageView, &rcView);
+	hbmImage = GetScaledImage(szPath, (rcView.right - rcView.left) -
+		GetSystemMetrics(SM_CXVSCROLL) - PAGEVIEW_IMAGE_MARGIN, &nWidth,
+		&nHeight, &fCached);
+	if (hbmImage == NULL)
+		return FALSE;
+
+	// Hand it over, letting the viewer delete the ones the cache couldn't keep.
+	iiImage.dwCookie = dwCookie;
+	iiImage.iOrigWidth = (int)nWidth;
+	iiImage.iOrigHeight = (int)nHeight;
+	iiImage.hbm = hbmImage;
+	iiImage.bOwnBitmap = !fCached;
+	SendMessage(hwndPageView, DTM_SETIMAGE, 0, (LPARAM)&iiImage);
+
+	return TRUE;
+}
+
+/**
+ * Gets the path to an image of the open page. Relative sources are resolved
+ * from the folder of the page.
+ *
+ * @param  szPath   Pre-allocated buffer of UKI_MAX_PATH characters to receive
+ *                  the path.
+ * @param  szSource Source of the image as it's in the page.
+ * @return          TRUE if the source points to a local file.
+ */
+BOOL GetPageImagePath(LPTSTR szPath, LPCTSTR szSource) {
+	LPTSTR szSlash;
+	size_t cchPath;
+	size_t cchSegment;
+
+	// Other protocols and inline data are up to the viewer.
+	if (wcschr(szSource, L':') != NULL)
+		return FALSE;
+
+	// Absolute sources start from the root.
+	if ((szSource[0] == L'\\') || (szSource[0] == L'/')) {
+		szPath[0] = L'\0';
+	} else {
+		if (!GetCurrentPagePath(szPath))
+			return FALSE;
+		szSlash = wcsrchr(szPath, L'\\');
+		if (szSlash == NULL)
+			return FALSE;
+		*szSlash = L'\0';
+	}
+
+	// Append the source a folder at a time, stopping at any URL parameters.
+	cchPath = wcslen(szPath);
+	while ((*szSource != L'\0') && (*szSource != L'?') &&
+			(*szSource != L'#')) {
+		cchSegment = wcscspn(szSource, L"\\/?#");
+
+		if ((cchSegment == 2) && (szSource[0] == L'.') &&
+				(szSource[1] == L'.')) {
+			// Go up a folder.
+			szSlash = wcsrchr(szPath, L'\\');
+			if (szSlash == NULL)
+				return FALSE;
+			*szSlash = L'\0';
+			cchPath = szSlash - szPath;
+		} else if ((cchSegment > 0) && !((cchSegment == 1) &&
+				(szSource[0] == L'.'))) {
+			// Go into a folder or file.
+			if ((cchPath + 1 + cchSegment) >= UKI_MAX_PATH)
+				return FALSE;
+			szPath[cchPath++] = L'\\';
+			memcpy(szPath + cchPath, szSource, cchSegment * sizeof(TCHAR));
+			cchPath += cchSegment;
+			szPath[cchPath] = L'\0';
+		}
+
+		szSource += cchSegment;
+		if ((*szSource == L'\\') || (*szSource == L'/'))
+			szSource++;
+	}
+
+	return cchPath > 0;
+}
+
+/**
+ * Records how long it took for the first chunk of a page to be painted.
+ *
+ * @param dwStarted Tick count of when the page was asked for.
+ */
+void RecordPageViewFirstChunk(DWORD dwStarted) {
+	pvsStats.dwLastFirstChunk = GetTickCount() - dwStarted;
+	if (pvsStats.dwLastFirstChunk > pvsStats.dwMaxFirstChunk)
+		pvsStats.dwMaxFirstChunk = pvsStats.dwLastFirstChunk;
+}
+
+/**
+ * Records how long it took for a whole page to be fed to the viewer.
+ *
+ * @param dwStarted Tick count of when the page was asked for.
+ */
+void RecordPageViewComplete(DWORD dwStarted) {
+	pvsStats.dwLastComplete = GetTickCount() - dwStarted;
+	pvsStats.nFeeds++;
+}
+
+/**
+ * Gets the times taken to feed pages to the viewer.
+ *
+ * @param lpStats Structure to receive the times.
+ */
+void GetPageViewStats(PAGEVIEW_STATS *lpStats) {
+	*lpStats = pvsStats;
+}
+
+/**
+ * Gets the file path of the currently open page.
+ *
+ * @param  szPath Pre-allocated buffer to receive the file path.
+ * @return        TRUE if there's a page open.
+ */
+BOOL GetCurrentPagePath(LPTSTR szPath) {
+	if (IsArticleLoaded()) {
+		return GetUkiArticlePath(szPath, ukiOpenArticle);
+	} else if (IsTemplateLoaded()) {
+		return GetUkiTemplatePath(szPath, ukiOpenTemplate);
+	}
+
+	return FALSE;
+}
+
+/**
+ * Shows the HTML viewer control. The viewer is only fed again if the editor
+ * text changed since it was last shown.
  */
 void ShowPageViewer() {
 	LPTSTR szEditorContents;
 	LONG nTextLen;
+	DWORD dwStarted;
 
 	ShowWindow(hwndPageEdit, SW_HIDE);
 	ShowWindow(hwndPageView, SW_SHOW);
 
-	// TODO: Check for modifications.
+	// Nothing changed since the viewer was last fed.
+	if (IsPageViewerCurrent())
+		return;
+
+	// Saved articles can be shown rendered.
+	if (ShowRenderedArticle()) {
+		SetPageViewerSource(TRUE);
+		return;
+	}
 
 	// Allocate buffer and populate it.
+	dwStarted = GetTickCount();
 	nTextLen = SendMessage(hwndPageEdit, WM_GETTEXTLENGTH, 0, 0) + 1;
-	szEditorContents = LocalAlloc(LMEM_FIXED, (nTextLen + 1) * sizeof(TCHAR));
+	szEditorContents = LocalAlloc(LMEM_FIXED, nTextLen * sizeof(TCHAR));
+	if (szEditorContents == NULL)
+		return;
 	SendMessage(hwndPageEdit, WM_GETTEXT, (WPARAM)nTextLen,
 		(LPARAM)szEditorContents);
 
 	// Set page view contents to page editor.
-    SendMessage(hwndPageView, WM_SETTEXT, 0, (LPARAM)L"");
-    SendMessage(hwndPageView, DTM_ADDTEXTW, 0, (LPARAM)szEditorContents);
-    SendMessage(hwndPageView, DTM_ENDOFSOURCE, 0, 0);
+	SetPageViewerText(szEditorContents, dwStarted);
+	SetPageViewerSource(FALSE);
 
 	// Clean up.
 	LocalFree(szEditorContents);
 }
 
+/**
+ * Records that the page viewer now shows the text currently in the editor.
+ *
+ * @param fRendered Is it showing the rendered article instead of the text?
+ */
+void SetPageViewerSource(BOOL fRendered) {
+	fPageViewerCurrent = TRUE;
+	fPageViewerRendered = fRendered;
+	dwPageViewerGeneration = dwPageEditGeneration;
+	dwPageViewerRenderGeneration = GetUkiRenderGeneration();
+}
+
+/**
+ * Checks if the page viewer still shows what it would be fed right now.
+ *
+ * @return TRUE if the viewer doesn't have to be fed again.
+ */
+BOOL IsPageViewerCurrent() {
+	if (!fPageViewerCurrent || (dwPageViewerGeneration != dwPageEditGeneration))
+		return FALSE;
+
+	// Rendered articles also depend on the templates and variables.
+	return !fPageViewerRendered ||
+		(dwPageViewerRenderGeneration == GetUkiRenderGeneration());
+}
+
 /**
  * Saves the currently open page.
  *
@@ -195,15 +645,29 @@ void ShowPageViewer() {
 LRESULT SaveCurrentPage() {
 	LPTSTR szContents;
 	LONG nTextLen;
+	DWORD dwHash;
 	BOOL bSuccess = FALSE;
 	
-	// Allocate memory and load contents from the page editor control.
+	// Allocate memory and load contents from the page editor control. This is
+	// the only full copy of the page made while saving.
 	nTextLen = SendMessage(hwndPageEdit, WM_GETTEXTLENGTH, 0, 0) + 1;
-	szContents = (LPTSTR)LocalAlloc(LMEM_FIXED, (nTextLen + 1) * sizeof(TCHAR));
-	SendMessage(hwndPageEdit, WM_GETTEXT, (WPARAM)nTextLen, (LPARAM)szContents);
-
-	// Save article or template.
-	if (IsArticleLoaded()) {
+	szContents = (LPTSTR)LocalAlloc(LMEM_FIXED, nTextLen * sizeof(TCHAR));
+	if (szContents == NULL) {
+		MessageBox(NULL, L"Not enough memory to save the page.",
+			L"Save Page Error", MB_OK | MB_ICONERROR);
+		return 1;
+	}
+	nTextLen = SendMessage(hwndPageEdit, WM_GETTEXT, (WPARAM)nTextLen,
+		(LPARAM)szContents);
+	dwHash = (DWORD)ContentHashBuffer(szContents, nTextLen * sizeof(TCHAR));
+
+	// Save article or template, unless it's exactly what is already there. The
+	// hash only rules out the pages that changed, a match is checked against
+	// the file itself.
+	if (fOpenPageHashed && (dwHash == dwOpenPageHash) &&
+			IsPageTextOnDisk(szContents, (DWORD)nTextLen)) {
+		bSuccess = TRUE;
+	} else if (IsArticleLoaded()) {
 		bSuccess = SaveUkiArticle(ukiOpenArticle, szContents);
 	} else if (IsTemplateLoaded()) {
 		bSuccess = SaveUkiTemplate(ukiOpenTemplate, szContents);
@@ -212,10 +676,37 @@ LRESULT SaveCurrentPage() {
 	// Clear the modification flag of the edit control.
 	SendMessage(hwndPageEdit, EM_SETMODIFY, (WPARAM)FALSE, 0);
 
+	// Our own changes shouldn't look like external ones, and saved articles
+	// can now be shown rendered.
+	if (bSuccess) {
+		TCHAR szPath[UKI_MAX_PATH];
+
+		fPageViewerCurrent = FALSE;
+
+		// The journal only needs what comes after this.
+		SetOpenPageHash(dwHash);
+		if (GetCurrentPagePath(szPath)) {
+			GetFileModifiedTime(szPath, &ftOpenPageModified);
+			ResetEditJournal(szPath, &ftOpenPageModified);
+		}
+	}
+
 	LocalFree(szContents);
 	return (LRESULT)(!bSuccess);
 }
 
+/**
+ * Puts back the unsaved text of the open page that was recovered from a
+ * previous session. The page is left dirty, so the user can choose to save it.
+ *
+ * @param szText Recovered text of the page.
+ */
+void RestorePageText(LPCTSTR szText) {
+	SetPageEditText(szText);
+	SendMessage(hwndPageEdit, EM_SETMODIFY, (WPARAM)TRUE, 0);
+	ShowPageEditor();
+}
+
 /**
  * Creates a new page with the contents empty.
  * @remark Remember to refresh the TreeView after this.
@@ -246,6 +737,7 @@ LRESULT CreateNewPage(BOOL fIsArticle) {
 		// Set current open article.
 		ClearUkiState();
 		GetUkiArticle(&ukiOpenArticle, nIndex);
+		nOpenArticle = nIndex;
 	} else {
 		// Add template.
 		nIndex = AddUkiTemplate(szPath);
@@ -258,7 +750,7 @@ LRESULT CreateNewPage(BOOL fIsArticle) {
 	}
 
 	// Clear the editor contents.
-	SendMessage(hwndPageEdit, WM_SETTEXT, 0, (LPARAM)L" ");
+	SetPageEditText(L" ");
 
 	// Save the new page.
 	if (SaveCurrentPage())
@@ -298,6 +790,7 @@ LRESULT SavePageAs() {
 		// Set current open article.
 		ClearUkiState();
 		GetUkiArticle(&ukiOpenArticle, nIndex);
+		nOpenArticle = nIndex;
 	} else if (IsTemplateLoaded()) {
 		// Add template.
 		nIndex = AddUkiTemplate(szPath);
@@ -316,6 +809,115 @@ LRESULT SavePageAs() {
 	return 0;
 }
 
+/**
+ * Shows which articles would be affected by an edit to what the user is
+ * looking at. That's the variable whose key is selected in the page editor,
+ * or else the template that is open.
+ *
+ * @return 0 if the dependents were shown.
+ */
+LRESULT ShowPageDependents() {
+	TCHAR szMsg[DEPENDENTS_MSG_LEN];
+	TCHAR szKey[DEPENDENTS_MAX_KEY + 1];
+	LONG alArticles[DEPENDENTS_MAX_SHOWN];
+	LPCTSTR szName;
+	LONG nDependents;
+	LONG iArticle;
+	int cchMsg;
+
+	// Everything comes from the dependency index.
+	if (!IsDependencyIndexReady()) {
+		MessageBox(NULL, L"The workspace is still being indexed. Try again "
+			L"once it finished loading.", L"Dependents", MB_OK |
+			MB_ICONINFORMATION);
+		return 1;
+	}
+
+	// Find out what we're being asked about.
+	if (GetSelectedKey(szKey)) {
+		nDependents = GetVariableDependents(szKey, alArticles,
+			DEPENDENTS_MAX_SHOWN);
+		szName = szKey;
+	} else if (IsTemplateLoaded()) {
+		nDependents = GetTemplateDependents(
+			GetUkiTemplateIndex(ukiOpenTemplate), alArticles,
+			DEPENDENTS_MAX_SHOWN);
+		szName = GetUkiTemplateName(GetUkiTemplateIndex(ukiOpenTemplate));
+	} else {
+		nDependents = -1L;
+		szName = NULL;
+	}
+	if ((nDependents < 0L) || (szName == NULL)) {
+		MessageBox(NULL, L"Open a template or select the key of a variable in "
+			L"the page editor to see which articles use it.", L"Dependents",
+			MB_OK | MB_ICONINFORMATION);
+		return 1;
+	}
+
+	// List the first few articles.
+	cchMsg = wsprintf(szMsg, L"Articles that use %.60s: %ld\r\n", szName,
+		nDependents);
+	for (iArticle = 0L; (iArticle < nDependents) &&
+			(iArticle < DEPENDENTS_MAX_SHOWN); iArticle++) {
+		szName = GetUkiArticleName(alArticles[iArticle]);
+		cchMsg += wsprintf(szMsg + cchMsg, L"\r\n%.60s",
+			(szName != NULL) ? szName : L"?");
+	}
+	if (nDependents > DEPENDENTS_MAX_SHOWN) {
+		wsprintf(szMsg + cchMsg, L"\r\n...and %ld more.",
+			nDependents - DEPENDENTS_MAX_SHOWN);
+	}
+
+	MessageBox(NULL, szMsg, L"Dependents", MB_OK | MB_ICONINFORMATION);
+	return 0;
+}
+
+/**
+ * Gets the text selected in the page editor when it could be the key of a
+ * variable, which is short and on a single line. Only that line is copied out
+ * of the editor.
+ *
+ * @param  szKey Buffer for DEPENDENTS_MAX_KEY characters and a terminator.
+ * @return       TRUE if there was a suitable selection.
+ */
+BOOL GetSelectedKey(LPTSTR szKey) {
+	TCHAR szLine[DEPENDENTS_MAX_LINE + 1];
+	DWORD dwSelStart;
+	DWORD dwSelEnd;
+	LONG nLine;
+	LONG nLineStart;
+	LONG cchLine;
+
+	// Check if the selection could be a key at all.
+	SendMessage(hwndPageEdit, EM_GETSEL, (WPARAM)&dwSelStart,
+		(LPARAM)&dwSelEnd);
+	if ((dwSelEnd <= dwSelStart) ||
+			((dwSelEnd - dwSelStart) > DEPENDENTS_MAX_KEY)) {
+		return FALSE;
+	}
+
+	// It must be on a single line that isn't too far from its start.
+	nLine = SendMessage(hwndPageEdit, EM_LINEFROMCHAR, dwSelStart, 0);
+	if (SendMessage(hwndPageEdit, EM_LINEFROMCHAR, dwSelEnd, 0) != nLine)
+		return FALSE;
+	nLineStart = SendMessage(hwndPageEdit, EM_LINEINDEX, nLine, 0);
+	if ((nLineStart < 0L) ||
+			((dwSelEnd - (DWORD)nLineStart) > DEPENDENTS_MAX_LINE)) {
+		return FALSE;
+	}
+
+	// Copy the line and cut the selection out of it.
+	*((WORD*)szLine) = DEPENDENTS_MAX_LINE;
+	cchLine = SendMessage(hwndPageEdit, EM_GETLINE, nLine, (LPARAM)szLine);
+	if (cchLine < (LONG)(dwSelEnd - (DWORD)nLineStart))
+		return FALSE;
+	memcpy(szKey, szLine + (dwSelStart - (DWORD)nLineStart),
+		(dwSelEnd - dwSelStart) * sizeof(TCHAR));
+	szKey[dwSelEnd - dwSelStart] = L'\0';
+
+	return TRUE;
+}
+
 /**
  * Shows a nice welcome page in the page viewer.
  *
@@ -323,7 +925,7 @@ LRESULT SavePageAs() {
  */
 BOOL ShowWelcomePage() {
 	// TODO: Load a static folder with the assets from the program root.
-	SendMessage(hwndPageView, WM_SETTEXT, 0, (LPARAM)L"");
+	ClearPageViewer();
 	SendMessage(hwndPageView, DTM_ADDTEXTW, 0, (LPARAM)L"<h1>Welcome to "
 		L"WinUki</h1>");
 	SendMessage(hwndPageView, DTM_ENDOFSOURCE, 0, 0);
@@ -335,7 +937,12 @@ BOOL ShowWelcomePage() {
  * Clears the internal Uki state of the module.
  */
 void ClearUkiState() {
+	// Unsaved changes to the page aren't wanted anymore.
+	DiscardEditJournal();
+	fOpenPageHashed = FALSE;
+
 	// Clear article.
+	nOpenArticle = -1L;
 	ukiOpenArticle.path = NULL;
 	ukiOpenArticle.name = NULL;
 	ukiOpenArticle.parent = NULL;
@@ -356,14 +963,15 @@ void ClearUkiState() {
  */
 void ClearPageToDefaults(BOOL fMakeEmpty) {
 	// Clear controls.
-	SendMessage(hwndPageEdit, WM_SETTEXT, 0, (LPARAM)L"");
+	SetPageEditText(L"");
 	if (fMakeEmpty) {
-		SendMessage(hwndPageView, WM_SETTEXT, 0, (LPARAM)L"");
+		ClearPageViewer();
 	} else {
 		ShowWelcomePage();
 	}
 
 	// Clear internal state.
+	fPageViewerCurrent = FALSE;
 	ClearUkiState();
 }
 
@@ -395,6 +1003,27 @@ BOOL IsPageEditorActive() {
 	return IsWindowVisible(hwndPageEdit);
 }
 
+/**
+ * Replaces the whole text of the page editor. Multiline edit controls don't
+ * notify us with EN_CHANGE in this case, so the generation is bumped here.
+ *
+ * @param szText Text to be placed in the editor.
+ */
+void SetPageEditText(LPCTSTR szText) {
+	SendMessage(hwndPageEdit, WM_SETTEXT, 0, (LPARAM)szText);
+	dwPageEditGeneration++;
+}
+
+/**
+ * Gets the generation of the text in the page editor, which changes every time
+ * the text does.
+ *
+ * @return Current generation of the page editor text.
+ */
+DWORD GetPageEditGeneration() {
+	return dwPageEditGeneration;
+}
+
 /**
  * Fetches the page editor window handle.
  *
@@ -432,10 +1061,96 @@ BOOL IsTemplateLoaded() {
 }
 
 /**
- * Checks if the page text was modified and haven't been saved yet.
+ * Checks if the page text was modified and haven't been saved yet. Edits that
+ * were undone, or typed back the same way, leave the page clean.
  *
  * @return TRUE if the text state is dirty.
  */
 BOOL IsPageDirty() {
-	return SendMessage(hwndPageEdit, EM_GETMODIFY, 0, 0);
+	// Nothing was touched.
+	if (!SendMessage(hwndPageEdit, EM_GETMODIFY, 0, 0))
+		return FALSE;
+
+	// Compare the text with what was loaded or saved, once per generation.
+	if (!fOpenPageHashed)
+		return TRUE;
+	if (dwDirtyCheckGeneration != dwPageEditGeneration) {
+		fDirtyCheckResult = !IsPageEditTextSaved();
+		dwDirtyCheckGeneration = dwPageEditGeneration;
+	}
+
+	// Spare the next checks from hashing the text.
+	if (!fDirtyCheckResult)
+		SendMessage(hwndPageEdit, EM_SETMODIFY, (WPARAM)FALSE, 0);
+
+	return fDirtyCheckResult;
+}
+
+/**
+ * Records the hash of the text that is on the disk for the open page. The text
+ * currently in the editor is known to match it.
+ *
+ * @param dwHash Hash of the page text.
+ */
+void SetOpenPageHash(DWORD dwHash) {
+	dwOpenPageHash = dwHash;
+	fOpenPageHashed = TRUE;
+	dwDirtyCheckGeneration = dwPageEditGeneration;
+	fDirtyCheckResult = FALSE;
+}
+
+/**
+ * Checks if the text currently in the page editor is the same that's saved in
+ * the file of the open page. The hash weeds out the text that changed without
+ * having to read the file, only a match is compared with the file itself.
+ *
+ * @return TRUE if the text is saved, FALSE if it isn't or we couldn't tell.
+ */
+BOOL IsPageEditTextSaved() {
+	LPTSTR szText;
+	LONG nTextLen;
+	BOOL fSaved;
+
+	// Get the text.
+	nTextLen = SendMessage(hwndPageEdit, WM_GETTEXTLENGTH, 0, 0) + 1;
+	szText = (LPTSTR)LocalAlloc(LMEM_FIXED, nTextLen * sizeof(TCHAR));
+	if (szText == NULL)
+		return FALSE;
+	nTextLen = SendMessage(hwndPageEdit, WM_GETTEXT, (WPARAM)nTextLen,
+		(LPARAM)szText);
+
+	// Compare it.
+	fSaved = ((DWORD)ContentHashBuffer(szText, nTextLen * sizeof(TCHAR)) ==
+		dwOpenPageHash) && IsPageTextOnDisk(szText, (DWORD)nTextLen);
+	LocalFree(szText);
+
+	return fSaved;
+}
+
+/**
+ * Checks if a text is exactly what's in the file of the open page.
+ *
+ * @param  szText  Text to be compared.
+ * @param  cchText Length of the text in characters.
+ * @return         TRUE if the file has the same text, FALSE if it doesn't or
+ *                 it couldn't be read.
+ */
+BOOL IsPageTextOnDisk(LPCTSTR szText, DWORD cchText) {
+	TCHAR szPath[UKI_MAX_PATH];
+	LPTSTR szFileText;
+	DWORD cchFileText;
+	BOOL fSame;
+
+	// Read the file.
+	if (!GetCurrentPagePath(szPath) ||
+			!ReadFileText(szPath, &szFileText, &cchFileText)) {
+		return FALSE;
+	}
+
+	// Compare them.
+	fSame = (cchFileText == cchText) &&
+		(memcmp(szFileText, szText, cchText * sizeof(TCHAR)) == 0);
+	LocalFree(szFileText);
+
+	return fSame;
 }
\ No newline at end of file
@@ -10,6 +10,15 @@
 
 #include <windows.h>
 
+// Times taken to feed pages to the viewer, in milliseconds since the page was
+// asked for, including any rendering.
+typedef struct {
+	DWORD nFeeds;
+	DWORD dwLastFirstChunk;
+	DWORD dwLastComplete;
+	DWORD dwMaxFirstChunk;
+} PAGEVIEW_STATS;
+
 // State check.
 BOOL IsArticleLoaded();
 BOOL IsTemplateLoaded();
@@ -23,10 +32,15 @@ BOOL InitializePageView(HINSTANCE hParentInst, HWND hwndParent, RECT rcClient,
 LRESULT SendPageEditMessage(UINT wMsg, WPARAM wParam, LPARAM lParam);
 LRESULT PageEditHandleCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
 							  LPARAM lParam);
+LRESULT PageViewHandleNotify(HWND hWnd, UINT wMsg, WPARAM wParam,
+							 LPARAM lParam);
+DWORD GetPageEditGeneration();
 
 // Population.
 BOOL PopulatePageViewArticle(const size_t nIndex);
 BOOL PopulatePageViewTemplate(const size_t nIndex);
+BOOL ReloadCurrentPage();
+BOOL IsPageChangedOnDisk();
 
 // Visibility.
 BOOL IsPageEditorActive();
@@ -37,9 +51,16 @@ void TogglePageView();
 // Saving.
 BOOL IsPageDirty();
 LRESULT SaveCurrentPage();
+void RestorePageText(LPCTSTR szText);
 LRESULT CreateNewPage(BOOL fIsArticle);
 LRESULT SavePageAs();
 
+// Dependencies.
+LRESULT ShowPageDependents();
+
+// Statistics.
+void GetPageViewStats(PAGEVIEW_STATS *lpStats);
+
 // Handle getters.
 HWND GetPageEditHandle();
 HWND GetPageViewHandle();
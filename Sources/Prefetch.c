@@ -0,0 +1,199 @@
+/**
+ * Prefetch.c
+ * Renders the articles the user is likely to open next while the application
+ * is idle.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "Prefetch.h"
+#include "RenderCache.h"
+#include "WorkspaceLoader.h"
+
+// Definitions.
+#define PREFETCH_MAX_QUEUE (PREFETCH_MAX_NEIGHBOURS + PREFETCH_MAX_RECENT)
+
+// Global variables.
+HWND hwndPrefetchOwner = NULL;
+UINT uPrefetchTimer = 0;
+DWORD cbPrefetchBudget = PREFETCH_MAX_BYTES;
+LONG alRecentArticles[PREFETCH_MAX_RECENT];
+LONG nRecentArticles = 0;
+LONG alPrefetchQueue[PREFETCH_MAX_QUEUE];
+LONG nPrefetchQueue = 0;
+LONG nNextPrefetch = 0;
+BOOL fPrefetchTimerSet = FALSE;
+BOOL fPrefetchBackingOff = FALSE;
+DWORD dwPrefetchBackoffStart = 0;
+
+// Private methods.
+void QueuePrefetchArticle(LONG nArticle, LONG nSkip);
+void StopPrefetchTimer();
+
+/**
+ * Initializes the prefetcher.
+ *
+ * @param hwndOwner Window that will receive the idle timer messages.
+ * @param uTimerID  Identifier of the timer to be used.
+ * @param cbBudget  Maximum number of bytes that articles rendered ahead of
+ *                  time and not opened yet may take.
+ */
+void InitializePrefetch(HWND hwndOwner, UINT uTimerID, DWORD cbBudget) {
+	hwndPrefetchOwner = hwndOwner;
+	uPrefetchTimer = uTimerID;
+	cbPrefetchBudget = cbBudget;
+	fPrefetchBackingOff = FALSE;
+
+	ClearPrefetch();
+}
+
+/**
+ * Forgets everything that was visited and queued. Must be called whenever the
+ * article indices stop being valid, like when the workspace is closed.
+ */
+void ClearPrefetch() {
+	CancelPrefetch();
+	nRecentArticles = 0;
+}
+
+/**
+ * Remembers that an article was opened, so that it can be prefetched again
+ * once it falls out of the render cache.
+ *
+ * @param nArticle Article index.
+ */
+void RecordArticleVisit(LONG nArticle) {
+	LONG i;
+
+	// Find it in the list or make room for it at the end.
+	for (i = 0; i < nRecentArticles; i++) {
+		if (alRecentArticles[i] == nArticle)
+			break;
+	}
+	if (i == nRecentArticles) {
+		if (nRecentArticles < PREFETCH_MAX_RECENT) {
+			nRecentArticles++;
+		} else {
+			i--;
+		}
+	}
+
+	// Move it to the front.
+	for (; i > 0; i--)
+		alRecentArticles[i] = alRecentArticles[i - 1];
+	alRecentArticles[0] = nArticle;
+}
+
+/**
+ * Replaces the prefetch queue with the neighbours of the article that was just
+ * opened followed by the most recently visited ones, and starts waiting for
+ * the application to be idle.
+ *
+ * @param lpNeighbours Articles around the open one, closest ones first.
+ * @param nNeighbours  Number of neighbouring articles.
+ */
+void SchedulePrefetch(const LONG *lpNeighbours, LONG nNeighbours) {
+	LONG nOpen;
+	LONG i;
+
+	// Start from scratch.
+	CancelPrefetch();
+
+	// Give the system some time to recover after a memory shortage.
+	if (fPrefetchBackingOff) {
+		if ((GetTickCount() - dwPrefetchBackoffStart) < PREFETCH_BACKOFF)
+			return;
+		fPrefetchBackingOff = FALSE;
+	}
+
+	// Build the queue. The first recent article is the one that's open.
+	nOpen = (nRecentArticles > 0) ? alRecentArticles[0] : -1L;
+	if (nNeighbours > PREFETCH_MAX_NEIGHBOURS)
+		nNeighbours = PREFETCH_MAX_NEIGHBOURS;
+	for (i = 0; i < nNeighbours; i++)
+		QueuePrefetchArticle(lpNeighbours[i], nOpen);
+	for (i = 1; i < nRecentArticles; i++)
+		QueuePrefetchArticle(alRecentArticles[i], nOpen);
+
+	// Wait for things to calm down.
+	if (nPrefetchQueue > 0) {
+		SetTimer(hwndPrefetchOwner, uPrefetchTimer, PREFETCH_IDLE_DELAY, NULL);
+		fPrefetchTimerSet = TRUE;
+	}
+}
+
+/**
+ * Stops prefetching the articles that are still queued.
+ */
+void CancelPrefetch() {
+	StopPrefetchTimer();
+	nPrefetchQueue = 0;
+	nNextPrefetch = 0;
+}
+
+/**
+ * Gives the memory used by prefetched articles back to the system and stops
+ * prefetching for a while. Used when the system is running low on memory.
+ */
+void HibernatePrefetch() {
+	CancelPrefetch();
+	DropPrefetchedArticles();
+
+	fPrefetchBackingOff = TRUE;
+	dwPrefetchBackoffStart = GetTickCount();
+}
+
+/**
+ * Prefetches the next article in the queue if the user isn't doing anything.
+ * Should be called every time the prefetch timer fires, so that a single
+ * article is rendered at a time and the interface stays responsive.
+ */
+void ProcessPrefetch() {
+	// Leave the way clear for the user and the workspace loader.
+	if (HIWORD(GetQueueStatus(QS_INPUT)) || IsWorkspaceLoading())
+		return;
+
+	// Render the next article while there's room for it.
+	if ((nNextPrefetch >= nPrefetchQueue) ||
+			!PrefetchRenderedArticle(alPrefetchQueue[nNextPrefetch++],
+			cbPrefetchBudget) || (nNextPrefetch >= nPrefetchQueue)) {
+		CancelPrefetch();
+		return;
+	}
+
+	// Keep going at a faster pace now that we are idle.
+	SetTimer(hwndPrefetchOwner, uPrefetchTimer, PREFETCH_INTERVAL, NULL);
+}
+
+/**
+ * Adds an article to the end of the prefetch queue if it isn't already there.
+ *
+ * @param nArticle Article index.
+ * @param nSkip    Article that shouldn't be queued.
+ */
+void QueuePrefetchArticle(LONG nArticle, LONG nSkip) {
+	LONG i;
+
+	// Check if it's worth queueing.
+	if ((nArticle < 0L) || (nArticle == nSkip) ||
+			(nPrefetchQueue >= PREFETCH_MAX_QUEUE)) {
+		return;
+	}
+	for (i = 0; i < nPrefetchQueue; i++) {
+		if (alPrefetchQueue[i] == nArticle)
+			return;
+	}
+
+	alPrefetchQueue[nPrefetchQueue++] = nArticle;
+}
+
+/**
+ * Stops the prefetch timer if it's running.
+ */
+void StopPrefetchTimer() {
+	if (!fPrefetchTimerSet)
+		return;
+
+	KillTimer(hwndPrefetchOwner, uPrefetchTimer);
+	fPrefetchTimerSet = FALSE;
+}
\ No newline at end of file
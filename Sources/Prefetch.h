@@ -0,0 +1,39 @@
+/**
+ * Prefetch.h
+ * Renders the articles the user is likely to open next while the application
+ * is idle.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _PREFETCH_H
+#define _PREFETCH_H
+
+#include <windows.h>
+
+// Default memory budget for articles that were rendered ahead of time.
+#define PREFETCH_MAX_BYTES (128 * 1024)
+
+// Limits of the candidate lists.
+#define PREFETCH_MAX_NEIGHBOURS 6
+#define PREFETCH_MAX_RECENT     8
+
+// Timings in milliseconds.
+#define PREFETCH_IDLE_DELAY 500
+#define PREFETCH_INTERVAL   50
+#define PREFETCH_BACKOFF    60000
+
+// Initialization and destruction.
+void InitializePrefetch(HWND hwndOwner, UINT uTimerID, DWORD cbBudget);
+void ClearPrefetch();
+
+// Scheduling.
+void RecordArticleVisit(LONG nArticle);
+void SchedulePrefetch(const LONG *lpNeighbours, LONG nNeighbours);
+void CancelPrefetch();
+void HibernatePrefetch();
+
+// Idle processing.
+void ProcessPrefetch();
+
+#endif  // _PREFETCH_H
\ No newline at end of file
@@ -0,0 +1,1804 @@
+/**
+ * Regex.c
+ * A platform-neutral regular expression engine for UTF-16 buffers that
+ * matches in linear time.
+ *
+ * Expressions are compiled into a program for a Thompson NFA that's simulated
+ * in lockstep over the text (a Pike VM), so every match takes time
+ * proportional to the length of the text times the size of the program, with
+ * no backtracking.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "Regex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+
+// Definitions.
+#define REGEX_INITIAL_NODES   32L
+#define REGEX_INITIAL_RANGES  8L
+#define REGEX_INITIAL_PROGRAM 32L
+#define REGEX_INITIAL_MATCHES 64L
+#define REGEX_INITIAL_OUTPUT  256
+#define REGEX_MAX_REPEAT      1000L
+#define REGEX_MAX_DEPTH       100
+
+// Instructions.
+#define OP_CHAR   0
+#define OP_ANY    1
+#define OP_CLASS  2
+#define OP_MATCH  3
+#define OP_JMP    4
+#define OP_SPLIT  5
+#define OP_SAVE   6
+#define OP_BOL    7
+#define OP_EOL    8
+#define OP_WORDB  9
+#define OP_NWORDB 10
+
+// Syntax tree nodes.
+#define NODE_EMPTY  0
+#define NODE_CHAR   1
+#define NODE_ANY    2
+#define NODE_CLASS  3
+#define NODE_ASSERT 4
+#define NODE_CAT    5
+#define NODE_ALT    6
+#define NODE_REPEAT 7
+#define NODE_GROUP  8
+
+// Character class flags.
+#define CLASS_NEGATE  0x01
+#define CLASS_DIGIT   0x02
+#define CLASS_WORD    0x04
+#define CLASS_SPACE   0x08
+#define CLASS_NDIGIT  0x10
+#define CLASS_NWORD   0x20
+#define CLASS_NSPACE  0x40
+
+// Splits that go back to the start of a loop, and which of their arguments
+// leaves it.
+#define LOOP_NONE   0
+#define LOOP_EXIT_X 1
+#define LOOP_EXIT_Y 2
+
+// Kinds of escape sequences.
+#define ESC_CHAR   0
+#define ESC_CLASS  1
+#define ESC_ASSERT 2
+
+// Special values.
+#define REPEAT_INFINITE -1L
+#define NODE_NONE       -1L
+
+// Folds the case of a character the same way the literal search does.
+#define FOLD_UPPER(c) (((c) < 0x80) ? \
+	(unsigned short)((((c) >= 'a') && ((c) <= 'z')) ? ((c) - 0x20) : (c)) : \
+	(unsigned short)towupper(c))
+
+// Checks if a character is part of a word.
+#define IS_WORD_CHAR(c) (iswalnum(c) || ((c) == '_'))
+
+// A node of the syntax tree. Children of concatenations and alternations are
+// chained through lNext.
+typedef struct {
+	int nType;
+	unsigned short c;
+	int fFlag;
+	long lChild;
+	long lNext;
+	long nMin;
+	long nMax;
+} RE_NODE;
+
+// State of the compilation of an expression.
+typedef struct {
+	const unsigned short *szPattern;
+	size_t cchPattern;
+	size_t nPos;
+	int nDepth;
+	int nGroups;
+	int nError;
+	RE_NODE *lpNodes;
+	long nNodes;
+	long nNodeCapacity;
+	REGEX *lpRegex;
+	long nRangeCapacity;
+	long nInstCapacity;
+} RE_COMPILER;
+
+// An entry of the thread stack. A negative lPC restores a capture slot.
+typedef struct {
+	long lPC;
+	int nSlot;
+	size_t nValue;
+} RE_STACKITEM;
+
+// State of the machine that runs the program.
+typedef struct {
+	long *lpPCs[2];
+	size_t *lpCaps[2];
+	long nThreads[2];
+	unsigned long *lpMarks;
+	unsigned long ulMark;
+	RE_STACKITEM *lpStack;
+	size_t *lpWork;
+} RE_MACHINE;
+
+// Private methods.
+int GrowRegexArray(void **lppArray, long *lpnCapacity, long nNeeded,
+				   long nInitial, size_t nItemSize);
+long NewNode(RE_COMPILER *lpComp, int nType);
+long ParseAlternation(RE_COMPILER *lpComp);
+long ParseConcatenation(RE_COMPILER *lpComp);
+long ParseRepeat(RE_COMPILER *lpComp);
+long ParseAtom(RE_COMPILER *lpComp);
+long ParseClass(RE_COMPILER *lpComp);
+int ParseEscape(RE_COMPILER *lpComp, int fInClass, unsigned short *lpChar);
+int ParseCount(RE_COMPILER *lpComp, long *lpnCount);
+int AddRange(RE_COMPILER *lpComp, unsigned short wFirst, unsigned short wLast);
+long Emit(RE_COMPILER *lpComp, unsigned char bOp, unsigned short c, long x,
+		  long y);
+int GenerateNode(RE_COMPILER *lpComp, long lNode);
+int GenerateRepeat(RE_COMPILER *lpComp, long lNode);
+int ExtractPrefix(RE_COMPILER *lpComp, long lNode);
+int CreateMachine(RE_MACHINE *lpMachine, const REGEX *lpRegex);
+void FreeMachine(RE_MACHINE *lpMachine);
+int RunMachine(RE_MACHINE *lpMachine, const REGEX *lpRegex,
+			   const unsigned short *szText, size_t cchText, size_t nFrom,
+			   REGEX_MATCH *lpMatch);
+void AddThread(RE_MACHINE *lpMachine, const REGEX *lpRegex, int iList,
+			   long lPC, size_t nPos, const size_t *lpCaps,
+			   const unsigned short *szText, size_t cchText);
+int CheckAssertion(unsigned char bOp, const unsigned short *szText,
+				   size_t cchText, size_t nPos);
+int MatchInstruction(const REGEX *lpRegex, const REGEX_INST *lpInst,
+					 unsigned short c);
+int MatchClass(const REGEX *lpRegex, const REGEX_INST *lpInst,
+			   unsigned short c);
+int AppendOutput(unsigned short **lpszOutput, size_t *lpcchOutput,
+				 size_t *lpcchCapacity, const unsigned short *szText,
+				 size_t cchText);
+
+/**
+ * Compiles a regular expression.
+ * @remark Remember to free the expression with RegexFree.
+ *
+ * Supports literals, ".", character classes with ranges and negation, the
+ * \d \w \s \D \W \S classes, the ^ $ \b \B assertions, capturing and
+ * non-capturing (?:) groups, alternation, and the * + ? {n} {n,} {n,m}
+ * quantifiers along with their lazy versions.
+ *
+ * @param  lpRegex    Expression to be populated.
+ * @param  szPattern  Pattern to be compiled.
+ * @param  cchPattern Length of the pattern in characters.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @param  lpErrorPos Position in the pattern where an error was found. Can be
+ *                    NULL.
+ * @return            REGEX_OK if the compilation was successful, otherwise one
+ *                    of the REGEX_ERR_* values.
+ */
+int RegexCompile(REGEX *lpRegex, const unsigned short *szPattern,
+				 size_t cchPattern, int fMatchCase, size_t *lpErrorPos) {
+	RE_COMPILER rcComp;
+	long lRoot;
+
+	// Set the defaults.
+	lpRegex->lpProgram = NULL;
+	lpRegex->nInst = 0L;
+	lpRegex->lpRanges = NULL;
+	lpRegex->nRanges = 0L;
+	lpRegex->nCaptures = 2;
+	lpRegex->fMatchCase = fMatchCase;
+	lpRegex->szPrefix = NULL;
+	lpRegex->cchPrefix = 0;
+	rcComp.szPattern = szPattern;
+	rcComp.cchPattern = cchPattern;
+	rcComp.nPos = 0;
+	rcComp.nDepth = 0;
+	rcComp.nGroups = 0;
+	rcComp.nError = REGEX_OK;
+	rcComp.lpNodes = NULL;
+	rcComp.nNodes = 0L;
+	rcComp.nNodeCapacity = 0L;
+	rcComp.lpRegex = lpRegex;
+	rcComp.nRangeCapacity = 0L;
+	rcComp.nInstCapacity = 0L;
+
+	// Parse the whole pattern. Stopping early means a stray parenthesis.
+	lRoot = ParseAlternation(&rcComp);
+	if ((lRoot != NODE_NONE) && (rcComp.nPos < cchPattern))
+		rcComp.nError = REGEX_ERR_PAREN;
+
+	// Generate the program surrounded by the whole match group.
+	if (rcComp.nError == REGEX_OK) {
+		lpRegex->nCaptures = ((rcComp.nGroups < REGEX_MAX_GROUPS) ?
+			(rcComp.nGroups + 1) : REGEX_MAX_GROUPS) * 2;
+		if ((Emit(&rcComp, OP_SAVE, 0, 0L, 0L) >= 0L) &&
+				GenerateNode(&rcComp, lRoot) &&
+				(Emit(&rcComp, OP_SAVE, 0, 1L, 0L) >= 0L)) {
+			Emit(&rcComp, OP_MATCH, 0, 0L, 0L);
+		}
+	}
+
+	// Find out which text every match must start with.
+	if (rcComp.nError == REGEX_OK)
+		ExtractPrefix(&rcComp, lRoot);
+
+	// Clean up.
+	free(rcComp.lpNodes);
+	if (rcComp.nError != REGEX_OK) {
+		if (lpErrorPos != NULL)
+			*lpErrorPos = rcComp.nPos;
+		RegexFree(lpRegex);
+	}
+
+	return rcComp.nError;
+}
+
+/**
+ * Frees a compiled expression.
+ *
+ * @param lpRegex Expression to be freed.
+ */
+void RegexFree(REGEX *lpRegex) {
+	free(lpRegex->lpProgram);
+	free(lpRegex->lpRanges);
+	free(lpRegex->szPrefix);
+	lpRegex->lpProgram = NULL;
+	lpRegex->nInst = 0L;
+	lpRegex->lpRanges = NULL;
+	lpRegex->nRanges = 0L;
+	lpRegex->szPrefix = NULL;
+	lpRegex->cchPrefix = 0;
+}
+
+/**
+ * Finds the leftmost match of an expression after a position. Among matches
+ * starting at the same position the one preferred by the expression wins, the
+ * same way a backtracking engine would.
+ *
+ * @param  lpRegex Compiled expression.
+ * @param  szText  Text to search in. Doesn't need to be NULL terminated.
+ * @param  cchText Length of the text in characters.
+ * @param  nFrom   Position to start searching from.
+ * @param  lpMatch Positions of the match and its groups.
+ * @return         1 if a match was found, 0 if there isn't one, or -1 if we
+ *                 ran out of memory.
+ */
+int RegexSearch(const REGEX *lpRegex, const unsigned short *szText,
+				size_t cchText, size_t nFrom, REGEX_MATCH *lpMatch) {
+	RE_MACHINE rmMachine;
+	int nResult;
+
+	if (!CreateMachine(&rmMachine, lpRegex))
+		return -1;
+
+	nResult = RunMachine(&rmMachine, lpRegex, szText, cchText, nFrom,
+		lpMatch);
+	FreeMachine(&rmMachine);
+
+	return nResult;
+}
+
+/**
+ * Finds every match of an expression after a position in a single pass.
+ * Matches don't overlap and are taken from left to right.
+ * @remark Remember to free the arrays with TextSearchFreeMatches.
+ *
+ * @param  lpRegex    Compiled expression.
+ * @param  szText     Text to search in.
+ * @param  cchText    Length of the text in characters.
+ * @param  nFrom      Position to start searching from.
+ * @param  fSkipEmpty Leave out matches that have no characters in them.
+ * @param  lppStarts  Sorted positions where the matches start. NULL if none
+ *                    were found.
+ * @param  lppEnds    Positions where the matches end. NULL if none were
+ *                    found.
+ * @return            Number of matches found or -1 if we ran out of memory.
+ */
+long RegexFindAll(const REGEX *lpRegex, const unsigned short *szText,
+				  size_t cchText, size_t nFrom, int fSkipEmpty,
+				  size_t **lppStarts, size_t **lppEnds) {
+	RE_MACHINE rmMachine;
+	REGEX_MATCH rmMatch;
+	size_t *lpStarts;
+	size_t *lpEnds;
+	long nCapacity;
+	long nEndCapacity;
+	long nMatches;
+	size_t nPos;
+	int nResult;
+
+	lpStarts = NULL;
+	lpEnds = NULL;
+	nCapacity = 0L;
+	nEndCapacity = 0L;
+	nMatches = 0L;
+	*lppStarts = NULL;
+	*lppEnds = NULL;
+
+	if (!CreateMachine(&rmMachine, lpRegex))
+		return -1L;
+
+	// Go through every match.
+	nPos = nFrom;
+	while ((nResult = RunMachine(&rmMachine, lpRegex, szText, cchText, nPos,
+			&rmMatch)) > 0) {
+		// Keep it.
+		if (!fSkipEmpty || (rmMatch.aCaptures[1] > rmMatch.aCaptures[0])) {
+			if (!GrowRegexArray((void**)&lpStarts, &nCapacity, nMatches + 1,
+					REGEX_INITIAL_MATCHES, sizeof(size_t)) ||
+					!GrowRegexArray((void**)&lpEnds, &nEndCapacity,
+					nMatches + 1, REGEX_INITIAL_MATCHES, sizeof(size_t))) {
+				nResult = -1;
+				break;
+			}
+
+			lpStarts[nMatches] = rmMatch.aCaptures[0];
+			lpEnds[nMatches] = rmMatch.aCaptures[1];
+			nMatches++;
+		}
+
+		// Empty matches would keep matching at the same place.
+		nPos = rmMatch.aCaptures[1];
+		if (rmMatch.aCaptures[1] == rmMatch.aCaptures[0])
+			nPos++;
+		if (nPos > cchText)
+			break;
+	}
+	FreeMachine(&rmMachine);
+
+	// Check if we ran out of memory along the way.
+	if (nResult < 0) {
+		free(lpStarts);
+		free(lpEnds);
+		return -1L;
+	}
+
+	*lppStarts = lpStarts;
+	*lppEnds = lpEnds;
+	return nMatches;
+}
+
+/**
+ * Expands a replacement template for a match. $0 to $9 are replaced by the
+ * text of the group with that number, $$ by a dollar sign, and \n, \r, \t and
+ * \\ by the characters they stand for.
+ *
+ * @param  szText      Text the match was found in.
+ * @param  lpMatch     Match to expand the template for.
+ * @param  szTemplate  Replacement template.
+ * @param  cchTemplate Length of the template in characters.
+ * @param  szOutput    Buffer to place the expanded text in, which isn't NULL
+ *                     terminated. Pass NULL to just measure it.
+ * @return             Length of the expanded text in characters.
+ */
+size_t RegexExpand(const unsigned short *szText, const REGEX_MATCH *lpMatch,
+				   const unsigned short *szTemplate, size_t cchTemplate,
+				   unsigned short *szOutput) {
+	size_t cchOutput = 0;
+	size_t iPos;
+	size_t nStart;
+	size_t nEnd;
+	unsigned short c;
+	int nGroup;
+
+	for (iPos = 0; iPos < cchTemplate; iPos++) {
+		c = szTemplate[iPos];
+
+		// Group references.
+		if ((c == '$') && ((iPos + 1) < cchTemplate) &&
+				(szTemplate[iPos + 1] >= '0') &&
+				(szTemplate[iPos + 1] <= '9')) {
+			nGroup = szTemplate[++iPos] - '0';
+			nStart = lpMatch->aCaptures[nGroup * 2];
+			nEnd = lpMatch->aCaptures[(nGroup * 2) + 1];
+			if ((nStart == REGEX_NONE) || (nEnd == REGEX_NONE))
+				continue;
+
+			if (szOutput != NULL) {
+				memcpy(szOutput + cchOutput, szText + nStart,
+					(nEnd - nStart) * sizeof(unsigned short));
+			}
+			cchOutput += nEnd - nStart;
+			continue;
+		}
+
+		// Escaped characters.
+		if (((c == '$') || (c == '\\')) && ((iPos + 1) < cchTemplate)) {
+			switch (szTemplate[iPos + 1]) {
+			case '$':
+				if (c == '$') {
+					iPos++;
+				}
+				break;
+			case '\\':
+				if (c == '\\') {
+					iPos++;
+				}
+				break;
+			case 'n':
+				if (c == '\\') {
+					c = '\n';
+					iPos++;
+				}
+				break;
+			case 'r':
+				if (c == '\\') {
+					c = '\r';
+					iPos++;
+				}
+				break;
+			case 't':
+				if (c == '\\') {
+					c = '\t';
+					iPos++;
+				}
+				break;
+			}
+		}
+
+		if (szOutput != NULL)
+			szOutput[cchOutput] = c;
+		cchOutput++;
+	}
+
+	return cchOutput;
+}
+
+/**
+ * Replaces every match of an expression after a position in a single pass.
+ * Matches don't overlap and are taken from left to right.
+ * @remark Remember to free the result with TextSearchFreeReplace.
+ *
+ * @param  lpRegex     Compiled expression.
+ * @param  szText      Text to search in.
+ * @param  cchText     Length of the text in characters.
+ * @param  nFrom       Position to start replacing from.
+ * @param  szTemplate  Replacement template. See RegexExpand.
+ * @param  cchTemplate Length of the template in characters.
+ * @param  lpReplace   Result of the operation, which only covers the part of
+ *                     the text between the first and last matches.
+ * @return             Number of matches replaced or -1 if we ran out of
+ *                     memory.
+ */
+long RegexReplaceAll(const REGEX *lpRegex, const unsigned short *szText,
+					 size_t cchText, size_t nFrom,
+					 const unsigned short *szTemplate, size_t cchTemplate,
+					 TXTSRCH_REPLACE *lpReplace) {
+	RE_MACHINE rmMachine;
+	REGEX_MATCH rmMatch;
+	unsigned short *szOutput;
+	size_t cchOutput;
+	size_t cchCapacity;
+	size_t cchExpanded;
+	size_t nLast;
+	size_t nPos;
+	long nMatches;
+	int nResult;
+
+	// Set the defaults.
+	lpReplace->szResult = NULL;
+	lpReplace->cchResult = 0;
+	lpReplace->nStart = 0;
+	lpReplace->nEnd = 0;
+	lpReplace->nMatches = 0L;
+	szOutput = NULL;
+	cchOutput = 0;
+	cchCapacity = 0;
+	nMatches = 0L;
+	nLast = 0;
+
+	if (!CreateMachine(&rmMachine, lpRegex))
+		return -1L;
+
+	// Go through every match.
+	nPos = nFrom;
+	while ((nResult = RunMachine(&rmMachine, lpRegex, szText, cchText, nPos,
+			&rmMatch)) > 0) {
+		// Copy what was between this match and the previous one.
+		if (nMatches == 0L) {
+			lpReplace->nStart = rmMatch.aCaptures[0];
+		} else if (!AppendOutput(&szOutput, &cchOutput, &cchCapacity,
+				szText + nLast, rmMatch.aCaptures[0] - nLast)) {
+			nResult = -1;
+			break;
+		}
+
+		// Put the replacement in.
+		cchExpanded = RegexExpand(szText, &rmMatch, szTemplate, cchTemplate,
+			NULL);
+		if (!AppendOutput(&szOutput, &cchOutput, &cchCapacity, NULL,
+				cchExpanded)) {
+			nResult = -1;
+			break;
+		}
+		RegexExpand(szText, &rmMatch, szTemplate, cchTemplate,
+			szOutput + cchOutput - cchExpanded);
+		nLast = rmMatch.aCaptures[1];
+		nMatches++;
+
+		// Empty matches would keep matching at the same place.
+		nPos = rmMatch.aCaptures[1];
+		if (rmMatch.aCaptures[1] == rmMatch.aCaptures[0])
+			nPos++;
+		if (nPos > cchText)
+			break;
+	}
+	FreeMachine(&rmMachine);
+
+	// Check if we ran out of memory along the way.
+	if ((nResult < 0) || ((nMatches > 0L) &&
+			!AppendOutput(&szOutput, &cchOutput, &cchCapacity, NULL, 1))) {
+		free(szOutput);
+		return -1L;
+	}
+
+	// Check if there was anything to be replaced.
+	if (nMatches == 0L)
+		return 0L;
+
+	// Terminate the result.
+	szOutput[--cchOutput] = 0;
+	lpReplace->szResult = szOutput;
+	lpReplace->cchResult = cchOutput;
+	lpReplace->nEnd = nLast;
+	lpReplace->nMatches = nMatches;
+
+	return nMatches;
+}
+
+/**
+ * Makes sure a dynamic array has space for a number of items.
+ *
+ * @param  lppArray    Array to be grown.
+ * @param  lpnCapacity Current capacity of the array.
+ * @param  nNeeded     Number of items that must fit.
+ * @param  nInitial    Capacity to start from when the array is empty.
+ * @param  nItemSize   Size of each item in bytes.
+ * @return             TRUE if the array has enough space.
+ */
+int GrowRegexArray(void **lppArray, long *lpnCapacity, long nNeeded,
+				   long nInitial, size_t nItemSize) {
+	void *lpNew;
+	long nCapacity;
+
+	// Check if we have enough space already.
+	if (nNeeded <= *lpnCapacity)
+		return 1;
+
+	// Double it until it fits.
+	nCapacity = (*lpnCapacity == 0L) ? nInitial : *lpnCapacity;
+	while (nCapacity < nNeeded)
+		nCapacity *= 2;
+
+	lpNew = realloc(*lppArray, nCapacity * nItemSize);
+	if (lpNew == NULL)
+		return 0;
+
+	*lppArray = lpNew;
+	*lpnCapacity = nCapacity;
+	return 1;
+}
+
+/**
+ * Creates a new node in the syntax tree.
+ *
+ * @param  lpComp Compilation state.
+ * @param  nType  Type of the node.
+ * @return        Index of the node or NODE_NONE if we ran out of memory.
+ */
+long NewNode(RE_COMPILER *lpComp, int nType) {
+	RE_NODE *lpNode;
+
+	if (!GrowRegexArray((void**)&lpComp->lpNodes, &lpComp->nNodeCapacity,
+			lpComp->nNodes + 1, REGEX_INITIAL_NODES, sizeof(RE_NODE))) {
+		lpComp->nError = REGEX_ERR_MEMORY;
+		return NODE_NONE;
+	}
+
+	lpNode = &lpComp->lpNodes[lpComp->nNodes];
+	lpNode->nType = nType;
+	lpNode->c = 0;
+	lpNode->fFlag = 0;
+	lpNode->lChild = NODE_NONE;
+	lpNode->lNext = NODE_NONE;
+	lpNode->nMin = 0L;
+	lpNode->nMax = 0L;
+
+	return lpComp->nNodes++;
+}
+
+/**
+ * Parses a list of alternatives separated by |.
+ *
+ * @param  lpComp Compilation state.
+ * @return        Index of the node or NODE_NONE if an error was found.
+ */
+long ParseAlternation(RE_COMPILER *lpComp) {
+	long lFirst;
+	long lLast;
+	long lBranch;
+	long lNode;
+
+	// Check if there are any alternatives at all.
+	lFirst = ParseConcatenation(lpComp);
+	if ((lFirst == NODE_NONE) || (lpComp->nPos >= lpComp->cchPattern) ||
+			(lpComp->szPattern[lpComp->nPos] != '|')) {
+		return lFirst;
+	}
+
+	lNode = NewNode(lpComp, NODE_ALT);
+	if (lNode == NODE_NONE)
+		return NODE_NONE;
+	lpComp->lpNodes[lNode].lChild = lFirst;
+
+	// Chain every one of them.
+	lLast = lFirst;
+	while ((lpComp->nPos < lpComp->cchPattern) &&
+			(lpComp->szPattern[lpComp->nPos] == '|')) {
+		lpComp->nPos++;
+		lBranch = ParseConcatenation(lpComp);
+		if (lBranch == NODE_NONE)
+			return NODE_NONE;
+
+		lpComp->lpNodes[lLast].lNext = lBranch;
+		lLast = lBranch;
+	}
+
+	return lNode;
+}
+
+/**
+ * Parses a sequence of items that must match one after the other.
+ *
+ * @param  lpComp Compilation state.
+ * @return        Index of the node or NODE_NONE if an error was found.
+ */
+long ParseConcatenation(RE_COMPILER *lpComp) {
+	long lNode;
+	long lItem;
+	long lLast;
+
+	lNode = NewNode(lpComp, NODE_CAT);
+	if (lNode == NODE_NONE)
+		return NODE_NONE;
+
+	// Chain every item until the end of this alternative.
+	lLast = NODE_NONE;
+	while ((lpComp->nPos < lpComp->cchPattern) &&
+			(lpComp->szPattern[lpComp->nPos] != '|') &&
+			(lpComp->szPattern[lpComp->nPos] != ')')) {
+		lItem = ParseRepeat(lpComp);
+		if (lItem == NODE_NONE)
+			return NODE_NONE;
+
+		if (lLast == NODE_NONE) {
+			lpComp->lpNodes[lNode].lChild = lItem;
+		} else {
+			lpComp->lpNodes[lLast].lNext = lItem;
+		}
+		lLast = lItem;
+	}
+
+	return lNode;
+}
+
+/**
+ * Parses an item along with any quantifiers after it.
+ *
+ * @param  lpComp Compilation state.
+ * @return        Index of the node or NODE_NONE if an error was found.
+ */
+long ParseRepeat(RE_COMPILER *lpComp) {
+	long lNode;
+	long lRepeat;
+	long nMin;
+	long nMax;
+	size_t nStart;
+	unsigned short c;
+
+	lNode = ParseAtom(lpComp);
+	while ((lNode != NODE_NONE) && (lpComp->nPos < lpComp->cchPattern)) {
+		// Figure out the bounds of the quantifier.
+		nStart = lpComp->nPos;
+		c = lpComp->szPattern[lpComp->nPos];
+		if (c == '*') {
+			nMin = 0L;
+			nMax = REPEAT_INFINITE;
+			lpComp->nPos++;
+		} else if (c == '+') {
+			nMin = 1L;
+			nMax = REPEAT_INFINITE;
+			lpComp->nPos++;
+		} else if (c == '?') {
+			nMin = 0L;
+			nMax = 1L;
+			lpComp->nPos++;
+		} else if (c == '{') {
+			// Braces that aren't a valid count are taken literally.
+			lpComp->nPos++;
+			if (!ParseCount(lpComp, &nMin)) {
+				lpComp->nPos = nStart;
+				break;
+			}
+
+			nMax = nMin;
+			if ((lpComp->nPos < lpComp->cchPattern) &&
+					(lpComp->szPattern[lpComp->nPos] == ',')) {
+				lpComp->nPos++;
+				nMax = REPEAT_INFINITE;
+				if ((lpComp->nPos < lpComp->cchPattern) &&
+						(lpComp->szPattern[lpComp->nPos] != '}') &&
+						!ParseCount(lpComp, &nMax)) {
+					lpComp->nPos = nStart;
+					break;
+				}
+			}
+
+			if ((lpComp->nPos >= lpComp->cchPattern) ||
+					(lpComp->szPattern[lpComp->nPos] != '}')) {
+				lpComp->nPos = nStart;
+				break;
+			}
+			lpComp->nPos++;
+
+			// Check if the bounds make sense.
+			if ((nMin > REGEX_MAX_REPEAT) || (nMax > REGEX_MAX_REPEAT) ||
+					((nMax != REPEAT_INFINITE) && (nMax < nMin))) {
+				lpComp->nPos = nStart;
+				lpComp->nError = REGEX_ERR_REPEAT;
+				return NODE_NONE;
+			}
+		} else {
+			break;
+		}
+
+		// Assertions don't have anything to repeat.
+		if (lpComp->lpNodes[lNode].nType == NODE_ASSERT) {
+			lpComp->nPos = nStart;
+			lpComp->nError = REGEX_ERR_REPEAT;
+			return NODE_NONE;
+		}
+
+		// Wrap the item.
+		lRepeat = NewNode(lpComp, NODE_REPEAT);
+		if (lRepeat == NODE_NONE)
+			return NODE_NONE;
+		lpComp->lpNodes[lRepeat].lChild = lNode;
+		lpComp->lpNodes[lRepeat].nMin = nMin;
+		lpComp->lpNodes[lRepeat].nMax = nMax;
+		lpComp->lpNodes[lRepeat].fFlag = 1;
+
+		// Lazy quantifiers.
+		if ((lpComp->nPos < lpComp->cchPattern) &&
+				(lpComp->szPattern[lpComp->nPos] == '?')) {
+			lpComp->lpNodes[lRepeat].fFlag = 0;
+			lpComp->nPos++;
+		}
+
+		lNode = lRepeat;
+	}
+
+	return lNode;
+}
+
+/**
+ * Parses a single item of the expression.
+ *
+ * @param  lpComp Compilation state.
+ * @return        Index of the node or NODE_NONE if an error was found.
+ */
+long ParseAtom(RE_COMPILER *lpComp) {
+	long lNode;
+	long lChild;
+	int nGroup;
+	int nEscape;
+	unsigned short c;
+
+	c = lpComp->szPattern[lpComp->nPos];
+	switch (c) {
+	case '(':
+		// Groups.
+		lpComp->nPos++;
+		if (++lpComp->nDepth > REGEX_MAX_DEPTH) {
+			lpComp->nError = REGEX_ERR_TOOBIG;
+			return NODE_NONE;
+		}
+
+		// Only the first few groups are captured.
+		nGroup = -1;
+		if (((lpComp->nPos + 1) < lpComp->cchPattern) &&
+				(lpComp->szPattern[lpComp->nPos] == '?') &&
+				(lpComp->szPattern[lpComp->nPos + 1] == ':')) {
+			lpComp->nPos += 2;
+		} else if (++lpComp->nGroups < REGEX_MAX_GROUPS) {
+			nGroup = lpComp->nGroups;
+		}
+
+		lChild = ParseAlternation(lpComp);
+		if (lChild == NODE_NONE)
+			return NODE_NONE;
+		if ((lpComp->nPos >= lpComp->cchPattern) ||
+				(lpComp->szPattern[lpComp->nPos] != ')')) {
+			lpComp->nError = REGEX_ERR_PAREN;
+			return NODE_NONE;
+		}
+		lpComp->nPos++;
+		lpComp->nDepth--;
+
+		lNode = NewNode(lpComp, NODE_GROUP);
+		if (lNode == NODE_NONE)
+			return NODE_NONE;
+		lpComp->lpNodes[lNode].lChild = lChild;
+		lpComp->lpNodes[lNode].nMin = nGroup;
+
+		return lNode;
+	case '[':
+		// Character classes.
+		lpComp->nPos++;
+		return ParseClass(lpComp);
+	case '*':
+	case '+':
+	case '?':
+		// Quantifiers without anything before them.
+		lpComp->nError = REGEX_ERR_REPEAT;
+		return NODE_NONE;
+	case '.':
+		lpComp->nPos++;
+		return NewNode(lpComp, NODE_ANY);
+	case '^':
+	case '$':
+		// Line assertions.
+		lpComp->nPos++;
+		lNode = NewNode(lpComp, NODE_ASSERT);
+		if (lNode != NODE_NONE)
+			lpComp->lpNodes[lNode].c = (c == '^') ? OP_BOL : OP_EOL;
+
+		return lNode;
+	case '\\':
+		// Escape sequences.
+		lpComp->nPos++;
+		nEscape = ParseEscape(lpComp, 0, &c);
+		if (nEscape < 0)
+			return NODE_NONE;
+
+		if (nEscape == ESC_CLASS) {
+			lNode = NewNode(lpComp, NODE_CLASS);
+			if (lNode != NODE_NONE) {
+				lpComp->lpNodes[lNode].fFlag = c;
+				lpComp->lpNodes[lNode].nMin = lpComp->lpRegex->nRanges;
+			}
+		} else if (nEscape == ESC_ASSERT) {
+			lNode = NewNode(lpComp, NODE_ASSERT);
+			if (lNode != NODE_NONE)
+				lpComp->lpNodes[lNode].c = c;
+		} else {
+			lNode = NewNode(lpComp, NODE_CHAR);
+			if (lNode != NODE_NONE)
+				lpComp->lpNodes[lNode].c = c;
+		}
+
+		return lNode;
+	}
+
+	// Plain old characters.
+	lpComp->nPos++;
+	lNode = NewNode(lpComp, NODE_CHAR);
+	if (lNode != NODE_NONE)
+		lpComp->lpNodes[lNode].c = c;
+
+	return lNode;
+}
+
+/**
+ * Parses a character class right after its opening bracket.
+ *
+ * @param  lpComp Compilation state.
+ * @return        Index of the node or NODE_NONE if an error was found.
+ */
+long ParseClass(RE_COMPILER *lpComp) {
+	long lNode;
+	int fFlags;
+	int nEscape;
+	int fFirst;
+	unsigned short wFirst;
+	unsigned short wLast;
+
+	lNode = NewNode(lpComp, NODE_CLASS);
+	if (lNode == NODE_NONE)
+		return NODE_NONE;
+	lpComp->lpNodes[lNode].nMin = lpComp->lpRegex->nRanges;
+
+	// Negated classes.
+	fFlags = 0;
+	if ((lpComp->nPos < lpComp->cchPattern) &&
+			(lpComp->szPattern[lpComp->nPos] == '^')) {
+		fFlags |= CLASS_NEGATE;
+		lpComp->nPos++;
+	}
+
+	// Go through the items. A bracket right at the start is taken literally.
+	fFirst = 1;
+	while (1) {
+		if (lpComp->nPos >= lpComp->cchPattern) {
+			lpComp->nError = REGEX_ERR_BRACKET;
+			return NODE_NONE;
+		}
+
+		wFirst = lpComp->szPattern[lpComp->nPos++];
+		if ((wFirst == ']') && !fFirst)
+			break;
+		fFirst = 0;
+
+		// Escape sequences.
+		if (wFirst == '\\') {
+			nEscape = ParseEscape(lpComp, 1, &wFirst);
+			if (nEscape < 0)
+				return NODE_NONE;
+
+			if (nEscape == ESC_CLASS) {
+				fFlags |= wFirst;
+				continue;
+			}
+		}
+
+		// Ranges.
+		wLast = wFirst;
+		if (((lpComp->nPos + 1) < lpComp->cchPattern) &&
+				(lpComp->szPattern[lpComp->nPos] == '-') &&
+				(lpComp->szPattern[lpComp->nPos + 1] != ']')) {
+			lpComp->nPos++;
+			wLast = lpComp->szPattern[lpComp->nPos++];
+			if (wLast == '\\') {
+				nEscape = ParseEscape(lpComp, 1, &wLast);
+				if (nEscape < 0)
+					return NODE_NONE;
+
+				if (nEscape == ESC_CLASS) {
+					lpComp->nError = REGEX_ERR_BRACKET;
+					return NODE_NONE;
+				}
+			}
+
+			if (wLast < wFirst) {
+				lpComp->nError = REGEX_ERR_BRACKET;
+				return NODE_NONE;
+			}
+		}
+
+		if (!AddRange(lpComp, wFirst, wLast))
+			return NODE_NONE;
+	}
+
+	lpComp->lpNodes[lNode].fFlag = fFlags;
+	lpComp->lpNodes[lNode].nMax = lpComp->lpRegex->nRanges -
+		lpComp->lpNodes[lNode].nMin;
+
+	return lNode;
+}
+
+/**
+ * Parses an escape sequence right after its backslash.
+ *
+ * @param  lpComp   Compilation state.
+ * @param  fInClass Are we inside of a character class?
+ * @param  lpChar   The character, class flag or assertion instruction that
+ *                  the sequence stands for.
+ * @return          One of the ESC_* values or -1 if it's invalid.
+ */
+int ParseEscape(RE_COMPILER *lpComp, int fInClass, unsigned short *lpChar) {
+	unsigned short c;
+	unsigned short wValue;
+	int nDigits;
+	int iDigit;
+
+	// Check if there's anything being escaped.
+	if (lpComp->nPos >= lpComp->cchPattern) {
+		lpComp->nError = REGEX_ERR_ESCAPE;
+		return -1;
+	}
+
+	c = lpComp->szPattern[lpComp->nPos++];
+	switch (c) {
+	case 'd':
+		*lpChar = CLASS_DIGIT;
+		return ESC_CLASS;
+	case 'D':
+		*lpChar = CLASS_NDIGIT;
+		return ESC_CLASS;
+	case 'w':
+		*lpChar = CLASS_WORD;
+		return ESC_CLASS;
+	case 'W':
+		*lpChar = CLASS_NWORD;
+		return ESC_CLASS;
+	case 's':
+		*lpChar = CLASS_SPACE;
+		return ESC_CLASS;
+	case 'S':
+		*lpChar = CLASS_NSPACE;
+		return ESC_CLASS;
+	case 'b':
+		// Inside of a class this is a backspace.
+		if (fInClass) {
+			*lpChar = '\b';
+			return ESC_CHAR;
+		}
+
+		*lpChar = OP_WORDB;
+		return ESC_ASSERT;
+	case 'B':
+		if (fInClass)
+			break;
+
+		*lpChar = OP_NWORDB;
+		return ESC_ASSERT;
+	case 'n':
+		*lpChar = '\n';
+		return ESC_CHAR;
+	case 'r':
+		*lpChar = '\r';
+		return ESC_CHAR;
+	case 't':
+		*lpChar = '\t';
+		return ESC_CHAR;
+	case 'f':
+		*lpChar = '\f';
+		return ESC_CHAR;
+	case 'v':
+		*lpChar = '\v';
+		return ESC_CHAR;
+	case 'x':
+	case 'u':
+		// Character codes.
+		nDigits = (c == 'x') ? 2 : 4;
+		wValue = 0;
+		for (iDigit = 0; iDigit < nDigits; iDigit++) {
+			if (lpComp->nPos >= lpComp->cchPattern) {
+				lpComp->nError = REGEX_ERR_ESCAPE;
+				return -1;
+			}
+
+			c = lpComp->szPattern[lpComp->nPos++];
+			if ((c >= '0') && (c <= '9')) {
+				wValue = (unsigned short)((wValue << 4) | (c - '0'));
+			} else if ((c >= 'a') && (c <= 'f')) {
+				wValue = (unsigned short)((wValue << 4) | (c - 'a' + 10));
+			} else if ((c >= 'A') && (c <= 'F')) {
+				wValue = (unsigned short)((wValue << 4) | (c - 'A' + 10));
+			} else {
+				lpComp->nError = REGEX_ERR_ESCAPE;
+				return -1;
+			}
+		}
+
+		*lpChar = wValue;
+		return ESC_CHAR;
+	default:
+		// Anything that isn't a letter or a digit stands for itself.
+		if (!iswalnum(c)) {
+			*lpChar = c;
+			return ESC_CHAR;
+		}
+	}
+
+	lpComp->nError = REGEX_ERR_ESCAPE;
+	return -1;
+}
+
+/**
+ * Parses the decimal number of a counted quantifier.
+ *
+ * @param  lpComp   Compilation state.
+ * @param  lpnCount Number that was parsed.
+ * @return          TRUE if there was a number.
+ */
+int ParseCount(RE_COMPILER *lpComp, long *lpnCount) {
+	size_t nStart = lpComp->nPos;
+	unsigned short c;
+
+	*lpnCount = 0L;
+	while (lpComp->nPos < lpComp->cchPattern) {
+		c = lpComp->szPattern[lpComp->nPos];
+		if ((c < '0') || (c > '9'))
+			break;
+
+		// Saturate instead of overflowing, it'll be rejected anyway.
+		if (*lpnCount <= REGEX_MAX_REPEAT)
+			*lpnCount = (*lpnCount * 10L) + (c - '0');
+		lpComp->nPos++;
+	}
+
+	return lpComp->nPos > nStart;
+}
+
+/**
+ * Adds a range of characters to the ones used by the character classes.
+ *
+ * @param  lpComp Compilation state.
+ * @param  wFirst First character of the range.
+ * @param  wLast  Last character of the range.
+ * @return        TRUE if the range was added.
+ */
+int AddRange(RE_COMPILER *lpComp, unsigned short wFirst,
+			 unsigned short wLast) {
+	REGEX *lpRegex = lpComp->lpRegex;
+
+	if (!GrowRegexArray((void**)&lpRegex->lpRanges, &lpComp->nRangeCapacity,
+			(lpRegex->nRanges + 1) * 2, REGEX_INITIAL_RANGES * 2,
+			sizeof(unsigned short))) {
+		lpComp->nError = REGEX_ERR_MEMORY;
+		return 0;
+	}
+
+	lpRegex->lpRanges[lpRegex->nRanges * 2] = wFirst;
+	lpRegex->lpRanges[(lpRegex->nRanges * 2) + 1] = wLast;
+	lpRegex->nRanges++;
+
+	return 1;
+}
+
+/**
+ * Appends an instruction to the program.
+ *
+ * @param  lpComp Compilation state.
+ * @param  bOp    Instruction.
+ * @param  c      Character or flags argument.
+ * @param  x      First argument.
+ * @param  y      Second argument.
+ * @return        Position of the instruction or -1 if it doesn't fit.
+ */
+long Emit(RE_COMPILER *lpComp, unsigned char bOp, unsigned short c, long x,
+		  long y) {
+	REGEX *lpRegex = lpComp->lpRegex;
+	REGEX_INST *lpInst;
+
+	// Check if the program has grown too large.
+	if (lpRegex->nInst >= REGEX_MAX_PROGRAM) {
+		lpComp->nError = REGEX_ERR_TOOBIG;
+		return -1L;
+	}
+
+	if (!GrowRegexArray((void**)&lpRegex->lpProgram, &lpComp->nInstCapacity,
+			lpRegex->nInst + 1, REGEX_INITIAL_PROGRAM, sizeof(REGEX_INST))) {
+		lpComp->nError = REGEX_ERR_MEMORY;
+		return -1L;
+	}
+
+	lpInst = &lpRegex->lpProgram[lpRegex->nInst];
+	lpInst->bOp = bOp;
+	lpInst->c = c;
+	lpInst->x = x;
+	lpInst->y = y;
+
+	return lpRegex->nInst++;
+}
+
+/**
+ * Generates the instructions for a node of the syntax tree.
+ *
+ * @param  lpComp Compilation state.
+ * @param  lNode  Node to generate the instructions for.
+ * @return        TRUE if the instructions were generated.
+ */
+int GenerateNode(RE_COMPILER *lpComp, long lNode) {
+	RE_NODE *lpNode = &lpComp->lpNodes[lNode];
+	REGEX_INST *lpProgram;
+	long lChild;
+	long lSplit;
+	long lJump;
+	long lPending;
+	long lNext;
+	int nGroup;
+
+	switch (lpNode->nType) {
+	case NODE_CHAR:
+		return Emit(lpComp, OP_CHAR, (unsigned short)(lpComp->lpRegex->fMatchCase ?
+			lpNode->c : FOLD_UPPER(lpNode->c)), 0L, 0L) >= 0L;
+	case NODE_ANY:
+		return Emit(lpComp, OP_ANY, 0, 0L, 0L) >= 0L;
+	case NODE_CLASS:
+		return Emit(lpComp, OP_CLASS, (unsigned short)lpNode->fFlag,
+			lpNode->nMin, lpNode->nMax) >= 0L;
+	case NODE_ASSERT:
+		return Emit(lpComp, (unsigned char)lpNode->c, 0, 0L, 0L) >= 0L;
+	case NODE_CAT:
+		for (lChild = lpNode->lChild; lChild != NODE_NONE;
+				lChild = lpComp->lpNodes[lChild].lNext) {
+			if (!GenerateNode(lpComp, lChild))
+				return 0;
+		}
+
+		return 1;
+	case NODE_ALT:
+		// Every alternative but the last one tries the next one if it fails
+		// and jumps to the end if it works. The pending jumps are chained
+		// through their arguments until we know where the end is.
+		lPending = -1L;
+		for (lChild = lpNode->lChild; lChild != NODE_NONE; lChild = lNext) {
+			lNext = lpComp->lpNodes[lChild].lNext;
+			if (lNext == NODE_NONE)
+				break;
+
+			lSplit = Emit(lpComp, OP_SPLIT, 0, 0L, 0L);
+			if ((lSplit < 0L) || !GenerateNode(lpComp, lChild))
+				return 0;
+			lJump = Emit(lpComp, OP_JMP, 0, lPending, 0L);
+			if (lJump < 0L)
+				return 0;
+			lPending = lJump;
+
+			lpProgram = lpComp->lpRegex->lpProgram;
+			lpProgram[lSplit].x = lSplit + 1;
+			lpProgram[lSplit].y = lJump + 1;
+		}
+
+		if (!GenerateNode(lpComp, lChild))
+			return 0;
+
+		// Point the pending jumps to the end.
+		lpProgram = lpComp->lpRegex->lpProgram;
+		while (lPending >= 0L) {
+			lJump = lpProgram[lPending].x;
+			lpProgram[lPending].x = lpComp->lpRegex->nInst;
+			lPending = lJump;
+		}
+
+		return 1;
+	case NODE_GROUP:
+		nGroup = (int)lpNode->nMin;
+		lChild = lpNode->lChild;
+		if (nGroup < 0)
+			return GenerateNode(lpComp, lChild);
+
+		return (Emit(lpComp, OP_SAVE, 0, nGroup * 2L, 0L) >= 0L) &&
+			GenerateNode(lpComp, lChild) &&
+			(Emit(lpComp, OP_SAVE, 0, (nGroup * 2L) + 1L, 0L) >= 0L);
+	case NODE_REPEAT:
+		return GenerateRepeat(lpComp, lNode);
+	}
+
+	// Empty nodes don't need anything.
+	return 1;
+}
+
+/**
+ * Generates the instructions for a quantified node. The item is repeated for
+ * the required count and the optional ones are wrapped in splits.
+ *
+ * @param  lpComp Compilation state.
+ * @param  lNode  Node to generate the instructions for.
+ * @return        TRUE if the instructions were generated.
+ */
+int GenerateRepeat(RE_COMPILER *lpComp, long lNode) {
+	REGEX_INST *lpProgram;
+	long lChild = lpComp->lpNodes[lNode].lChild;
+	long nMin = lpComp->lpNodes[lNode].nMin;
+	long nMax = lpComp->lpNodes[lNode].nMax;
+	int fGreedy = lpComp->lpNodes[lNode].fFlag;
+	long lLoop;
+	long lSplit;
+	long lPending;
+	long iCount;
+
+	// Required repetitions. The last one is part of the loop for x+.
+	for (iCount = 0L; iCount < nMin; iCount++) {
+		if ((nMax == REPEAT_INFINITE) && (iCount == (nMin - 1L))) {
+			lLoop = lpComp->lpRegex->nInst;
+			if (!GenerateNode(lpComp, lChild))
+				return 0;
+
+			lSplit = Emit(lpComp, OP_SPLIT, (unsigned short)(fGreedy ?
+				LOOP_EXIT_Y : LOOP_EXIT_X), 0L, 0L);
+			if (lSplit < 0L)
+				return 0;
+
+			lpProgram = lpComp->lpRegex->lpProgram;
+			lpProgram[lSplit].x = fGreedy ? lLoop : (lSplit + 1);
+			lpProgram[lSplit].y = fGreedy ? (lSplit + 1) : lLoop;
+			return 1;
+		}
+
+		if (!GenerateNode(lpComp, lChild))
+			return 0;
+	}
+
+	// Unbounded repetitions for x*, which is generated as (x+)? so that an
+	// iteration that matches nothing can still leave the loop.
+	if (nMax == REPEAT_INFINITE) {
+		lSplit = Emit(lpComp, OP_SPLIT, 0, 0L, 0L);
+		if ((lSplit < 0L) || !GenerateNode(lpComp, lChild))
+			return 0;
+		lLoop = Emit(lpComp, OP_SPLIT, (unsigned short)(fGreedy ?
+			LOOP_EXIT_Y : LOOP_EXIT_X), 0L, 0L);
+		if (lLoop < 0L)
+			return 0;
+
+		lpProgram = lpComp->lpRegex->lpProgram;
+		lpProgram[lSplit].x = fGreedy ? (lSplit + 1) : (lLoop + 1);
+		lpProgram[lSplit].y = fGreedy ? (lLoop + 1) : (lSplit + 1);
+		lpProgram[lLoop].x = fGreedy ? (lSplit + 1) : (lLoop + 1);
+		lpProgram[lLoop].y = fGreedy ? (lLoop + 1) : (lSplit + 1);
+		return 1;
+	}
+
+	// Optional repetitions, which all bail out to the end. The pending splits
+	// are chained through the argument that will point to the end.
+	lPending = -1L;
+	for (iCount = nMin; iCount < nMax; iCount++) {
+		lSplit = Emit(lpComp, OP_SPLIT, 0, lPending, 0L);
+		if ((lSplit < 0L) || !GenerateNode(lpComp, lChild))
+			return 0;
+		lPending = lSplit;
+	}
+
+	lpProgram = lpComp->lpRegex->lpProgram;
+	while (lPending >= 0L) {
+		lSplit = lPending;
+		lPending = lpProgram[lSplit].x;
+		lpProgram[lSplit].x = fGreedy ? (lSplit + 1) : lpComp->lpRegex->nInst;
+		lpProgram[lSplit].y = fGreedy ? lpComp->lpRegex->nInst : (lSplit + 1);
+	}
+
+	return 1;
+}
+
+/**
+ * Extracts the literal text every match must start with, so that the search
+ * can skip straight to it.
+ *
+ * @param  lpComp Compilation state.
+ * @param  lNode  Root of the syntax tree.
+ * @return        TRUE if everything went fine.
+ */
+int ExtractPrefix(RE_COMPILER *lpComp, long lNode) {
+	REGEX *lpRegex = lpComp->lpRegex;
+	long lChild;
+	size_t cchPrefix;
+
+	// Only literal characters at the start of the expression matter.
+	if (lpComp->lpNodes[lNode].nType != NODE_CAT)
+		return 1;
+
+	cchPrefix = 0;
+	for (lChild = lpComp->lpNodes[lNode].lChild; (lChild != NODE_NONE) &&
+			(lpComp->lpNodes[lChild].nType == NODE_CHAR);
+			lChild = lpComp->lpNodes[lChild].lNext) {
+		cchPrefix++;
+	}
+	if (cchPrefix == 0)
+		return 1;
+
+	// Copy it.
+	lpRegex->szPrefix = (unsigned short*)malloc(cchPrefix *
+		sizeof(unsigned short));
+	if (lpRegex->szPrefix == NULL) {
+		lpComp->nError = REGEX_ERR_MEMORY;
+		return 0;
+	}
+
+	for (lChild = lpComp->lpNodes[lNode].lChild; (lChild != NODE_NONE) &&
+			(lpComp->lpNodes[lChild].nType == NODE_CHAR);
+			lChild = lpComp->lpNodes[lChild].lNext) {
+		lpRegex->szPrefix[lpRegex->cchPrefix++] = lpComp->lpNodes[lChild].c;
+	}
+
+	return 1;
+}
+
+/**
+ * Allocates the machine that runs a program.
+ *
+ * @param  lpMachine Machine to be allocated.
+ * @param  lpRegex   Compiled expression it'll run.
+ * @return           TRUE if the allocation was successful.
+ */
+int CreateMachine(RE_MACHINE *lpMachine, const REGEX *lpRegex) {
+	size_t nInst = (size_t)lpRegex->nInst;
+	size_t nCaptures = (size_t)lpRegex->nCaptures;
+
+	lpMachine->lpPCs[0] = (long*)malloc(nInst * sizeof(long));
+	lpMachine->lpPCs[1] = (long*)malloc(nInst * sizeof(long));
+	lpMachine->lpCaps[0] = (size_t*)malloc(nInst * nCaptures *
+		sizeof(size_t));
+	lpMachine->lpCaps[1] = (size_t*)malloc(nInst * nCaptures *
+		sizeof(size_t));
+	lpMachine->lpMarks = (unsigned long*)calloc(nInst, sizeof(unsigned long));
+	// Closing the groups of an empty iteration can visit each capture
+	// instruction again, on top of the one entry per instruction.
+	lpMachine->lpStack = (RE_STACKITEM*)malloc(((nInst * 3) + 1) *
+		sizeof(RE_STACKITEM));
+	lpMachine->lpWork = (size_t*)malloc(nCaptures * sizeof(size_t));
+	lpMachine->ulMark = 0;
+
+	if ((lpMachine->lpPCs[0] == NULL) || (lpMachine->lpPCs[1] == NULL) ||
+			(lpMachine->lpCaps[0] == NULL) || (lpMachine->lpCaps[1] == NULL) ||
+			(lpMachine->lpMarks == NULL) || (lpMachine->lpStack == NULL) ||
+			(lpMachine->lpWork == NULL)) {
+		FreeMachine(lpMachine);
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Frees a machine.
+ *
+ * @param lpMachine Machine to be freed.
+ */
+void FreeMachine(RE_MACHINE *lpMachine) {
+	free(lpMachine->lpPCs[0]);
+	free(lpMachine->lpPCs[1]);
+	free(lpMachine->lpCaps[0]);
+	free(lpMachine->lpCaps[1]);
+	free(lpMachine->lpMarks);
+	free(lpMachine->lpStack);
+	free(lpMachine->lpWork);
+}
+
+/**
+ * Runs the program over the text in lockstep, one character at a time, to
+ * find the leftmost match after a position.
+ *
+ * @param  lpMachine Machine to run the program in.
+ * @param  lpRegex   Compiled expression.
+ * @param  szText    Text to search in.
+ * @param  cchText   Length of the text in characters.
+ * @param  nFrom     Position to start searching from.
+ * @param  lpMatch   Positions of the match and its groups.
+ * @return           1 if a match was found, 0 otherwise.
+ */
+int RunMachine(RE_MACHINE *lpMachine, const REGEX *lpRegex,
+			   const unsigned short *szText, size_t cchText, size_t nFrom,
+			   REGEX_MATCH *lpMatch) {
+	const REGEX_INST *lpInst;
+	const size_t *lpCaps;
+	size_t nCaptures = (size_t)lpRegex->nCaptures;
+	size_t nPos;
+	size_t nNext;
+	size_t iSlot;
+	long iThread;
+	int iList;
+	int fMatched;
+	unsigned short c;
+
+	// Nothing took part in the match yet.
+	for (iSlot = 0; iSlot < (REGEX_MAX_GROUPS * 2); iSlot++)
+		lpMatch->aCaptures[iSlot] = REGEX_NONE;
+	for (iSlot = 0; iSlot < nCaptures; iSlot++)
+		lpMachine->lpWork[iSlot] = REGEX_NONE;
+	if (nFrom > cchText)
+		return 0;
+
+	// Start with an empty list.
+	iList = 0;
+	lpMachine->nThreads[iList] = 0L;
+	lpMachine->ulMark++;
+	fMatched = 0;
+
+	for (nPos = nFrom; ; nPos++) {
+		// Start a new attempt at every position until something matches.
+		if (!fMatched) {
+			// Skip straight to the places that could start a match.
+			if ((lpMachine->nThreads[iList] == 0L) && (lpRegex->cchPrefix > 0)) {
+				nNext = TextSearchFind(szText, cchText, nPos, lpRegex->szPrefix,
+					lpRegex->cchPrefix, lpRegex->fMatchCase);
+				if (nNext == TXTSRCH_NONE)
+					break;
+
+				if (nNext != nPos) {
+					nPos = nNext;
+					lpMachine->ulMark++;
+				}
+			}
+
+			for (iSlot = 0; iSlot < nCaptures; iSlot++)
+				lpMachine->lpWork[iSlot] = REGEX_NONE;
+			AddThread(lpMachine, lpRegex, iList, 0L, nPos,
+				lpMachine->lpWork, szText, cchText);
+		}
+
+		// Check if there's anything still going.
+		if (lpMachine->nThreads[iList] == 0L) {
+			if (fMatched || (nPos >= cchText))
+				break;
+
+			lpMachine->ulMark++;
+			continue;
+		}
+
+		// Advance every thread through the current character, in priority
+		// order. A match cuts off every thread with a lower priority.
+		c = (nPos < cchText) ? szText[nPos] : 0;
+		lpMachine->nThreads[1 - iList] = 0L;
+		lpMachine->ulMark++;
+		for (iThread = 0L; iThread < lpMachine->nThreads[iList]; iThread++) {
+			lpInst = &lpRegex->lpProgram[lpMachine->lpPCs[iList][iThread]];
+			lpCaps = lpMachine->lpCaps[iList] + (iThread * nCaptures);
+
+			if (lpInst->bOp == OP_MATCH) {
+				memcpy(lpMatch->aCaptures, lpCaps, nCaptures * sizeof(size_t));
+				fMatched = 1;
+				break;
+			}
+
+			if ((nPos < cchText) && MatchInstruction(lpRegex, lpInst, c)) {
+				AddThread(lpMachine, lpRegex, 1 - iList,
+					lpMachine->lpPCs[iList][iThread] + 1L, nPos + 1, lpCaps,
+					szText, cchText);
+			}
+		}
+		iList = 1 - iList;
+
+		// Nothing can go past the end.
+		if (nPos >= cchText)
+			break;
+	}
+
+	return fMatched;
+}
+
+/**
+ * Adds a thread to a list, following every jump, split, capture and assertion
+ * until it reaches instructions that consume characters or match. Threads
+ * that were already added at this position are skipped, which is what keeps
+ * the whole thing linear.
+ *
+ * @param lpMachine Machine that's running the program.
+ * @param lpRegex   Compiled expression.
+ * @param iList     List to add the thread to.
+ * @param lPC       Instruction the thread starts at.
+ * @param nPos      Position of the thread in the text.
+ * @param lpCaps    Capture slots of the thread.
+ * @param szText    Text being searched.
+ * @param cchText   Length of the text in characters.
+ */
+void AddThread(RE_MACHINE *lpMachine, const REGEX *lpRegex, int iList,
+			   long lPC, size_t nPos, const size_t *lpCaps,
+			   const unsigned short *szText, size_t cchText) {
+	const REGEX_INST *lpInst;
+	RE_STACKITEM *lpStack = lpMachine->lpStack;
+	size_t *lpWork = lpMachine->lpWork;
+	size_t nCaptures = (size_t)lpRegex->nCaptures;
+	long nStack;
+	long nThread;
+
+	// Work on a copy of the captures so they can be restored on the way back.
+	if (lpCaps != lpWork)
+		memcpy(lpWork, lpCaps, nCaptures * sizeof(size_t));
+	lpStack[0].lPC = lPC;
+	nStack = 1L;
+
+	while (nStack > 0L) {
+		nStack--;
+		if (lpStack[nStack].lPC < 0L) {
+			lpWork[lpStack[nStack].nSlot] = lpStack[nStack].nValue;
+			continue;
+		}
+
+		// Follow the instructions until the thread stops or forks.
+		lPC = lpStack[nStack].lPC;
+		while (1) {
+			lpInst = &lpRegex->lpProgram[lPC];
+			if (lpMachine->lpMarks[lPC] == lpMachine->ulMark) {
+				// Coming back to a loop without having consumed anything
+				// means this iteration was empty, so close the groups it's in
+				// and leave the loop the same way a backtracking engine would.
+				while ((lpInst->bOp == OP_SAVE) || (lpInst->bOp == OP_JMP)) {
+					if (lpInst->bOp == OP_JMP) {
+						lPC = lpInst->x;
+					} else {
+						if (lpInst->x < lpRegex->nCaptures) {
+							lpStack[nStack].lPC = -1L;
+							lpStack[nStack].nSlot = (int)lpInst->x;
+							lpStack[nStack].nValue = lpWork[lpInst->x];
+							nStack++;
+							lpWork[lpInst->x] = nPos;
+						}
+
+						lPC++;
+					}
+
+					lpInst = &lpRegex->lpProgram[lPC];
+				}
+
+				if ((lpInst->bOp != OP_SPLIT) || (lpInst->c == LOOP_NONE))
+					break;
+
+				lPC = (lpInst->c == LOOP_EXIT_X) ? lpInst->x : lpInst->y;
+				if (lpMachine->lpMarks[lPC] == lpMachine->ulMark)
+					break;
+				lpInst = &lpRegex->lpProgram[lPC];
+			}
+			lpMachine->lpMarks[lPC] = lpMachine->ulMark;
+
+			switch (lpInst->bOp) {
+			case OP_JMP:
+				lPC = lpInst->x;
+				continue;
+			case OP_SPLIT:
+				lpStack[nStack].lPC = lpInst->y;
+				nStack++;
+				lPC = lpInst->x;
+				continue;
+			case OP_SAVE:
+				if (lpInst->x < lpRegex->nCaptures) {
+					lpStack[nStack].lPC = -1L;
+					lpStack[nStack].nSlot = (int)lpInst->x;
+					lpStack[nStack].nValue = lpWork[lpInst->x];
+					nStack++;
+					lpWork[lpInst->x] = nPos;
+				}
+
+				lPC++;
+				continue;
+			case OP_BOL:
+			case OP_EOL:
+			case OP_WORDB:
+			case OP_NWORDB:
+				if (!CheckAssertion(lpInst->bOp, szText, cchText, nPos))
+					break;
+
+				lPC++;
+				continue;
+			default:
+				// Consuming instructions and matches become threads.
+				nThread = lpMachine->nThreads[iList]++;
+				lpMachine->lpPCs[iList][nThread] = lPC;
+				memcpy(lpMachine->lpCaps[iList] + (nThread * nCaptures), lpWork,
+					nCaptures * sizeof(size_t));
+				break;
+			}
+
+			break;
+		}
+	}
+}
+
+/**
+ * Checks if an assertion holds at a position. Lines may end with CR, LF or
+ * CRLF.
+ *
+ * @param  bOp     Assertion instruction.
+ * @param  szText  Text being searched.
+ * @param  cchText Length of the text in characters.
+ * @param  nPos    Position in the text.
+ * @return         TRUE if the assertion holds.
+ */
+int CheckAssertion(unsigned char bOp, const unsigned short *szText,
+				   size_t cchText, size_t nPos) {
+	int fWordBefore;
+	int fWordAfter;
+
+	switch (bOp) {
+	case OP_BOL:
+		return (nPos == 0) || (szText[nPos - 1] == '\n') ||
+			((szText[nPos - 1] == '\r') &&
+			 ((nPos >= cchText) || (szText[nPos] != '\n')));
+	case OP_EOL:
+		return (nPos >= cchText) || (szText[nPos] == '\r') ||
+			((szText[nPos] == '\n') &&
+			 ((nPos == 0) || (szText[nPos - 1] != '\r')));
+	case OP_WORDB:
+	case OP_NWORDB:
+		fWordBefore = (nPos > 0) && IS_WORD_CHAR(szText[nPos - 1]);
+		fWordAfter = (nPos < cchText) && IS_WORD_CHAR(szText[nPos]);
+
+		return (fWordBefore != fWordAfter) == (bOp == OP_WORDB);
+	}
+
+	return 0;
+}
+
+/**
+ * Checks if a character is accepted by a consuming instruction.
+ *
+ * @param  lpRegex Compiled expression.
+ * @param  lpInst  Instruction to check against.
+ * @param  c       Character to be checked.
+ * @return         TRUE if the character is accepted.
+ */
+int MatchInstruction(const REGEX *lpRegex, const REGEX_INST *lpInst,
+					 unsigned short c) {
+	switch (lpInst->bOp) {
+	case OP_CHAR:
+		if (lpRegex->fMatchCase)
+			return c == lpInst->c;
+
+		return FOLD_UPPER(c) == lpInst->c;
+	case OP_ANY:
+		return (c != '\n') && (c != '\r');
+	case OP_CLASS:
+		return MatchClass(lpRegex, lpInst, c);
+	}
+
+	return 0;
+}
+
+/**
+ * Checks if a character belongs to a character class. When ignoring the case
+ * both the upper and lower case versions of the character are checked.
+ *
+ * @param  lpRegex Compiled expression.
+ * @param  lpInst  Class instruction to check against.
+ * @param  c       Character to be checked.
+ * @return         TRUE if the character belongs to the class.
+ */
+int MatchClass(const REGEX *lpRegex, const REGEX_INST *lpInst,
+			   unsigned short c) {
+	const unsigned short *lpRange;
+	unsigned short wUpper;
+	unsigned short wLower;
+	unsigned short wFlags = lpInst->c;
+	long iRange;
+	int fFound;
+
+	// Predefined classes.
+	fFound = ((wFlags & CLASS_DIGIT) && iswdigit(c)) ||
+		((wFlags & CLASS_NDIGIT) && !iswdigit(c)) ||
+		((wFlags & CLASS_WORD) && IS_WORD_CHAR(c)) ||
+		((wFlags & CLASS_NWORD) && !IS_WORD_CHAR(c)) ||
+		((wFlags & CLASS_SPACE) && iswspace(c)) ||
+		((wFlags & CLASS_NSPACE) && !iswspace(c));
+
+	// Ranges.
+	wUpper = (unsigned short)towupper(c);
+	wLower = (unsigned short)towlower(c);
+	lpRange = lpRegex->lpRanges + (lpInst->x * 2);
+	for (iRange = 0L; !fFound && (iRange < lpInst->y); iRange++) {
+		fFound = ((c >= lpRange[0]) && (c <= lpRange[1])) ||
+			(!lpRegex->fMatchCase &&
+			 (((wUpper >= lpRange[0]) && (wUpper <= lpRange[1])) ||
+			  ((wLower >= lpRange[0]) && (wLower <= lpRange[1]))));
+		lpRange += 2;
+	}
+
+	return fFound != ((wFlags & CLASS_NEGATE) != 0);
+}
+
+/**
+ * Appends text to a growing output buffer.
+ *
+ * @param  lpszOutput    Output buffer.
+ * @param  lpcchOutput   Length of the text in the buffer.
+ * @param  lpcchCapacity Capacity of the buffer in characters.
+ * @param  szText        Text to be appended. Pass NULL to just reserve the
+ *                       space for it.
+ * @param  cchText       Length of the text in characters.
+ * @return               TRUE if the text was appended.
+ */
+int AppendOutput(unsigned short **lpszOutput, size_t *lpcchOutput,
+				 size_t *lpcchCapacity, const unsigned short *szText,
+				 size_t cchText) {
+	unsigned short *szNew;
+	size_t cchCapacity;
+
+	// Make space for it.
+	if ((*lpcchOutput + cchText) > *lpcchCapacity) {
+		cchCapacity = (*lpcchCapacity == 0) ? REGEX_INITIAL_OUTPUT :
+			*lpcchCapacity;
+		while (cchCapacity < (*lpcchOutput + cchText))
+			cchCapacity *= 2;
+
+		szNew = (unsigned short*)realloc(*lpszOutput, cchCapacity *
+			sizeof(unsigned short));
+		if (szNew == NULL)
+			return 0;
+
+		*lpszOutput = szNew;
+		*lpcchCapacity = cchCapacity;
+	}
+
+	if (szText != NULL) {
+		memcpy(*lpszOutput + *lpcchOutput, szText,
+			cchText * sizeof(unsigned short));
+	}
+	*lpcchOutput += cchText;
+
+	return 1;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+/**
+ * Regex.h
+ * A platform-neutral regular expression engine for UTF-16 buffers that
+ * matches in linear time.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _REGEX_H
+#define _REGEX_H
+
+#include <stddef.h>
+#include "TextSearch.h"
+
+// Limits.
+#define REGEX_MAX_GROUPS  10
+#define REGEX_MAX_PROGRAM 8192
+
+// Position of a group that didn't take part in a match.
+#define REGEX_NONE ((size_t)-1)
+
+// Compilation results.
+#define REGEX_OK          0
+#define REGEX_ERR_MEMORY  1
+#define REGEX_ERR_PAREN   2
+#define REGEX_ERR_BRACKET 3
+#define REGEX_ERR_ESCAPE  4
+#define REGEX_ERR_REPEAT  5
+#define REGEX_ERR_TOOBIG  6
+
+// A single instruction of a compiled expression.
+typedef struct {
+	unsigned char bOp;
+	unsigned short c;
+	long x;
+	long y;
+} REGEX_INST;
+
+// A compiled regular expression.
+typedef struct {
+	REGEX_INST *lpProgram;
+	long nInst;
+	unsigned short *lpRanges;
+	long nRanges;
+	int nCaptures;
+	int fMatchCase;
+	unsigned short *szPrefix;
+	size_t cchPrefix;
+} REGEX;
+
+// Positions of a match and its groups. Group n goes from aCaptures[2n] to
+// aCaptures[2n + 1].
+typedef struct {
+	size_t aCaptures[REGEX_MAX_GROUPS * 2];
+} REGEX_MATCH;
+
+// Compilation and destruction.
+int RegexCompile(REGEX *lpRegex, const unsigned short *szPattern,
+				 size_t cchPattern, int fMatchCase, size_t *lpErrorPos);
+void RegexFree(REGEX *lpRegex);
+
+// Matching.
+int RegexSearch(const REGEX *lpRegex, const unsigned short *szText,
+				size_t cchText, size_t nFrom, REGEX_MATCH *lpMatch);
+long RegexFindAll(const REGEX *lpRegex, const unsigned short *szText,
+				  size_t cchText, size_t nFrom, int fSkipEmpty,
+				  size_t **lppStarts, size_t **lppEnds);
+
+// Replacing.
+size_t RegexExpand(const unsigned short *szText, const REGEX_MATCH *lpMatch,
+				   const unsigned short *szTemplate, size_t cchTemplate,
+				   unsigned short *szOutput);
+long RegexReplaceAll(const REGEX *lpRegex, const unsigned short *szText,
+					 size_t cchText, size_t nFrom,
+					 const unsigned short *szTemplate, size_t cchTemplate,
+					 TXTSRCH_REPLACE *lpReplace);
+
+#endif  // _REGEX_H
\ No newline at end of file
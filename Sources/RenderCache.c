@@ -0,0 +1,339 @@
+/**
+ * RenderCache.c
+ * Keeps the most recently rendered articles around for the page viewer.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "RenderCache.h"
+#include "UkiHelper.h"
+#include "Utilities.h"
+
+// A rendered article. Entries with a nArticle of -1 are free.
+typedef struct {
+	LONG nArticle;
+	FILETIME ftModified;
+	DWORD dwContentHash;
+	BOOL fHashed;
+	DWORD dwGeneration;
+	DWORD dwLastUsed;
+	BOOL fPrefetched;
+	LPTSTR szHTML;
+	DWORD cbHTML;
+} RENDERCACHE_ENTRY;
+
+// Global variables.
+RENDERCACHE_ENTRY rceEntries[RENDERCACHE_MAX_ENTRIES];
+RENDERCACHE_STATS rcsStats;
+DWORD cbRenderCacheMax = RENDERCACHE_MAX_BYTES;
+DWORD dwUseCounter = 0;
+
+// Private methods.
+int LoadCacheEntry(LONG nArticle, BOOL *lpfHit);
+int FindCacheEntry(LONG nArticle);
+int GetFreeCacheEntry(DWORD cbNeeded);
+void FreeCacheEntry(int iEntry);
+
+/**
+ * Initializes the render cache.
+ *
+ * @param cbMaxBytes Maximum number of bytes of HTML to keep around.
+ */
+void InitializeRenderCache(DWORD cbMaxBytes) {
+	int iEntry;
+
+	// Set the limit and mark every entry as free.
+	cbRenderCacheMax = cbMaxBytes;
+	for (iEntry = 0; iEntry < RENDERCACHE_MAX_ENTRIES; iEntry++) {
+		rceEntries[iEntry].nArticle = -1L;
+		rceEntries[iEntry].fPrefetched = FALSE;
+		rceEntries[iEntry].szHTML = NULL;
+		rceEntries[iEntry].cbHTML = 0;
+	}
+
+	// Reset the counters.
+	rcsStats.dwHits = 0;
+	rcsStats.dwMisses = 0;
+	rcsStats.dwEvictions = 0;
+	rcsStats.nEntries = 0;
+	rcsStats.cbUsed = 0;
+	rcsStats.dwPrefetches = 0;
+	rcsStats.dwPrefetchHits = 0;
+	rcsStats.cbPrefetched = 0;
+}
+
+/**
+ * Throws away everything in the cache. Must be called whenever the article
+ * indices stop being valid, like when the workspace is closed.
+ */
+void ClearRenderCache() {
+	int iEntry;
+
+	for (iEntry = 0; iEntry < RENDERCACHE_MAX_ENTRIES; iEntry++)
+		FreeCacheEntry(iEntry);
+}
+
+/**
+ * Gets the rendered HTML of an article, only rendering it if the cached
+ * version is missing or out of date.
+ *
+ * @param  nArticle Article index.
+ * @return          Rendered HTML, owned by the cache and valid until the next
+ *                  call, or NULL if the article couldn't be rendered.
+ */
+LPCTSTR GetRenderedArticle(LONG nArticle) {
+	RENDERCACHE_ENTRY *lpEntry;
+	BOOL fHit;
+	int iEntry;
+
+	// Get it from the cache or render it.
+	iEntry = LoadCacheEntry(nArticle, &fHit);
+	if (iEntry < 0)
+		return NULL;
+	lpEntry = &rceEntries[iEntry];
+	if (fHit) {
+		rcsStats.dwHits++;
+	} else {
+		rcsStats.dwMisses++;
+	}
+
+	// Someone finally asked for a prefetched article.
+	if (lpEntry->fPrefetched) {
+		lpEntry->fPrefetched = FALSE;
+		rcsStats.cbPrefetched -= lpEntry->cbHTML;
+		rcsStats.dwPrefetchHits++;
+	}
+
+	lpEntry->dwLastUsed = ++dwUseCounter;
+	return lpEntry->szHTML;
+}
+
+/**
+ * Renders an article ahead of time so that it's already in the cache when it
+ * gets requested.
+ *
+ * @param  nArticle Article index.
+ * @param  cbBudget Maximum number of bytes that prefetched articles that
+ *                  weren't requested yet may take.
+ * @return          FALSE if the budget has been used up.
+ */
+BOOL PrefetchRenderedArticle(LONG nArticle, DWORD cbBudget) {
+	RENDERCACHE_ENTRY *lpEntry;
+	BOOL fHit;
+	int iEntry;
+
+	// Check if we still have room for it.
+	if (rcsStats.cbPrefetched >= cbBudget)
+		return FALSE;
+
+	// Get it into the cache.
+	iEntry = LoadCacheEntry(nArticle, &fHit);
+	if ((iEntry < 0) || fHit)
+		return TRUE;
+	lpEntry = &rceEntries[iEntry];
+
+	// Don't let a single big article push us over the budget.
+	if ((rcsStats.cbPrefetched + lpEntry->cbHTML) > cbBudget) {
+		FreeCacheEntry(iEntry);
+		return FALSE;
+	}
+
+	lpEntry->fPrefetched = TRUE;
+	rcsStats.cbPrefetched += lpEntry->cbHTML;
+	rcsStats.dwPrefetches++;
+
+	return TRUE;
+}
+
+/**
+ * Throws away every prefetched article that wasn't requested yet, used to give
+ * memory back to the system.
+ */
+void DropPrefetchedArticles() {
+	int iEntry;
+
+	for (iEntry = 0; iEntry < RENDERCACHE_MAX_ENTRIES; iEntry++) {
+		if (rceEntries[iEntry].fPrefetched)
+			FreeCacheEntry(iEntry);
+	}
+}
+
+/**
+ * Gets the index of the cache entry with the up to date rendered HTML of an
+ * article, only rendering it if the cached version is missing or out of date.
+ *
+ * @param  nArticle Article index.
+ * @param  lpfHit   Set to TRUE if the cached version was already up to date.
+ * @return          Index of the entry or -1 if the article couldn't be
+ *                  rendered.
+ */
+int LoadCacheEntry(LONG nArticle, BOOL *lpfHit) {
+	TCHAR szPath[UKI_MAX_PATH];
+	UKIARTICLE ukiArticle;
+	FILETIME ftModified;
+	LPTSTR szHTML;
+	DWORD dwGeneration;
+	DWORD dwContentHash;
+	DWORD cbHTML;
+	BOOL fHashed;
+	int iEntry;
+
+	// Get the article and when its file was last changed.
+	*lpfHit = FALSE;
+	if (!GetUkiArticle(&ukiArticle, (size_t)nArticle))
+		return -1;
+	if (!GetUkiArticlePath(szPath, ukiArticle) ||
+			!GetFileModifiedTime(szPath, &ftModified)) {
+		return -1;
+	}
+	dwGeneration = GetUkiRenderGeneration();
+
+	// Check if we already have it.
+	iEntry = FindCacheEntry(nArticle);
+	if ((iEntry >= 0) && (rceEntries[iEntry].dwGeneration == dwGeneration)) {
+		// A file that was only touched still has the same rendered version.
+		if ((CompareFileTime(&rceEntries[iEntry].ftModified,
+				&ftModified) != 0) && rceEntries[iEntry].fHashed &&
+				GetFileContentHash(szPath, &dwContentHash) &&
+				(dwContentHash == rceEntries[iEntry].dwContentHash)) {
+			rceEntries[iEntry].ftModified = ftModified;
+		}
+
+		if (CompareFileTime(&rceEntries[iEntry].ftModified,
+				&ftModified) == 0) {
+			*lpfHit = TRUE;
+			return iEntry;
+		}
+	}
+
+	// Out of date.
+	if (iEntry >= 0)
+		FreeCacheEntry(iEntry);
+
+	// Render the article.
+	if (!RenderUkiArticle(ukiArticle, &szHTML))
+		return -1;
+	fHashed = GetFileContentHash(szPath, &dwContentHash);
+	cbHTML = (wcslen(szHTML) + 1) * sizeof(TCHAR);
+
+	// Store it.
+	iEntry = GetFreeCacheEntry(cbHTML);
+	rceEntries[iEntry].nArticle = nArticle;
+	rceEntries[iEntry].ftModified = ftModified;
+	rceEntries[iEntry].dwContentHash = dwContentHash;
+	rceEntries[iEntry].fHashed = fHashed;
+	rceEntries[iEntry].dwGeneration = dwGeneration;
+	rceEntries[iEntry].dwLastUsed = ++dwUseCounter;
+	rceEntries[iEntry].fPrefetched = FALSE;
+	rceEntries[iEntry].szHTML = szHTML;
+	rceEntries[iEntry].cbHTML = cbHTML;
+	rcsStats.nEntries++;
+	rcsStats.cbUsed += cbHTML;
+
+	return iEntry;
+}
+
+/**
+ * Throws away the rendered version of an article because something it depends
+ * on has changed.
+ *
+ * @param nArticle Article index.
+ */
+void InvalidateRenderedArticle(LONG nArticle) {
+	int iEntry;
+
+	iEntry = FindCacheEntry(nArticle);
+	if (iEntry >= 0)
+		FreeCacheEntry(iEntry);
+}
+
+/**
+ * Gets the cache usage counters.
+ *
+ * @param lpStats Structure to receive the counters.
+ */
+void GetRenderCacheStats(RENDERCACHE_STATS *lpStats) {
+	*lpStats = rcsStats;
+}
+
+/**
+ * Finds the cache entry of an article.
+ *
+ * @param  nArticle Article index.
+ * @return          Index of the entry or -1 if the article isn't cached.
+ */
+int FindCacheEntry(LONG nArticle) {
+	int iEntry;
+
+	for (iEntry = 0; iEntry < RENDERCACHE_MAX_ENTRIES; iEntry++) {
+		if (rceEntries[iEntry].nArticle == nArticle)
+			return iEntry;
+	}
+
+	return -1;
+}
+
+/**
+ * Gets a free cache entry, evicting the least recently used ones until there's
+ * an entry available and the new one fits in the memory budget.
+ * @remark An article bigger than the whole budget still gets an entry, it just
+ *         ends up alone in the cache.
+ *
+ * @param  cbNeeded Size of the HTML that will be stored.
+ * @return          Index of the free entry.
+ */
+int GetFreeCacheEntry(DWORD cbNeeded) {
+	int iFree;
+	int iOldest;
+	int iEntry;
+
+	for (;;) {
+		// Look for a free entry and the least recently used one.
+		iFree = -1;
+		iOldest = -1;
+		for (iEntry = 0; iEntry < RENDERCACHE_MAX_ENTRIES; iEntry++) {
+			if (rceEntries[iEntry].nArticle < 0L) {
+				if (iFree < 0)
+					iFree = iEntry;
+			} else if ((iOldest < 0) || (rceEntries[iEntry].dwLastUsed <
+					rceEntries[iOldest].dwLastUsed)) {
+				iOldest = iEntry;
+			}
+		}
+
+		// Check if we are done.
+		if ((iFree >= 0) && ((iOldest < 0) ||
+				((rcsStats.cbUsed + cbNeeded) <= cbRenderCacheMax))) {
+			return iFree;
+		}
+
+		// Evict the least recently used entry.
+		FreeCacheEntry(iOldest);
+		rcsStats.dwEvictions++;
+	}
+}
+
+/**
+ * Frees a cache entry.
+ *
+ * @param iEntry Index of the entry.
+ */
+void FreeCacheEntry(int iEntry) {
+	RENDERCACHE_ENTRY *lpEntry = &rceEntries[iEntry];
+
+	// Check if there's anything to be done.
+	if (lpEntry->nArticle < 0L)
+		return;
+
+	// Release the HTML.
+	rcsStats.nEntries--;
+	rcsStats.cbUsed -= lpEntry->cbHTML;
+	if (lpEntry->fPrefetched)
+		rcsStats.cbPrefetched -= lpEntry->cbHTML;
+	LocalFree(lpEntry->szHTML);
+
+	lpEntry->nArticle = -1L;
+	lpEntry->fPrefetched = FALSE;
+	lpEntry->szHTML = NULL;
+	lpEntry->cbHTML = 0;
+}
\ No newline at end of file
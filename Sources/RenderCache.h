@@ -0,0 +1,44 @@
+/**
+ * RenderCache.h
+ * Keeps the most recently rendered articles around for the page viewer.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _RENDERCACHE_H
+#define _RENDERCACHE_H
+
+#include <windows.h>
+
+// Default limits of the cache.
+#define RENDERCACHE_MAX_ENTRIES 32
+#define RENDERCACHE_MAX_BYTES   (256 * 1024)
+
+// Cache usage counters.
+typedef struct {
+	DWORD dwHits;
+	DWORD dwMisses;
+	DWORD dwEvictions;
+	DWORD nEntries;
+	DWORD cbUsed;
+	DWORD dwPrefetches;
+	DWORD dwPrefetchHits;
+	DWORD cbPrefetched;
+} RENDERCACHE_STATS;
+
+// Initialization and destruction.
+void InitializeRenderCache(DWORD cbMaxBytes);
+void ClearRenderCache();
+
+// Rendering.
+LPCTSTR GetRenderedArticle(LONG nArticle);
+void InvalidateRenderedArticle(LONG nArticle);
+
+// Prefetching.
+BOOL PrefetchRenderedArticle(LONG nArticle, DWORD cbBudget);
+void DropPrefetchedArticles();
+
+// Statistics.
+void GetRenderCacheStats(RENDERCACHE_STATS *lpStats);
+
+#endif  // _RENDERCACHE_H
\ No newline at end of file
@@ -0,0 +1,337 @@
+/**
+ * StringTable.c
+ * Interned wide strings for the names, parents, and paths of a set of pages.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "StringTable.h"
+#include "Utilities.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Definitions.
+#define STRTABLE_INITIAL_ENTRIES 64
+#define STRTABLE_EMPTY_BUCKET    -1L
+
+// Private methods.
+BOOL GrowStringTable(STRINGTABLE *lpTable);
+BOOL RehashStringTable(STRINGTABLE *lpTable, DWORD nBuckets);
+DWORD HashStringKey(const char *szaKey);
+
+/**
+ * Initializes an empty string pool.
+ *
+ * @param lpPool String pool to be initialized.
+ */
+void StringPoolInitialize(STRINGPOOL *lpPool) {
+	lpPool->lpBlocks = NULL;
+}
+
+/**
+ * Adds the wide form of a string to the pool.
+ *
+ * @param  lpPool    String pool.
+ * @param  szaString String to be converted and added.
+ * @return           Pointer to the interned string, which stays valid until
+ *                   the pool is freed, or NULL in case of an error.
+ */
+LPCTSTR StringPoolAdd(STRINGPOOL *lpPool, const char *szaString) {
+	STRPOOL_BLOCK *lpBlock;
+	LPTSTR szString;
+	DWORD cchSize;
+	int cchString;
+
+	// Get the size of the converted string.
+	if (szaString == NULL)
+		return NULL;
+	cchString = ConvertBufferAtoW(NULL, 0, szaString, -1);
+	if (cchString == 0)
+		return NULL;
+
+	// Start a new block if the string doesn't fit in the current one.
+	lpBlock = lpPool->lpBlocks;
+	if ((lpBlock == NULL) ||
+		((lpBlock->cchSize - lpBlock->cchUsed) < (DWORD)cchString)) {
+		cchSize = max(STRPOOL_BLOCK_SIZE, (DWORD)cchString);
+		lpBlock = (STRPOOL_BLOCK*)malloc(sizeof(STRPOOL_BLOCK) +
+			(cchSize * sizeof(WCHAR)));
+		if (lpBlock == NULL)
+			return NULL;
+
+		lpBlock->lpNext = lpPool->lpBlocks;
+		lpBlock->cchUsed = 0;
+		lpBlock->cchSize = cchSize;
+		lpPool->lpBlocks = lpBlock;
+	}
+
+	// Convert the string into the block.
+	szString = lpBlock->szData + lpBlock->cchUsed;
+	ConvertBufferAtoW(szString, cchString, szaString, -1);
+	lpBlock->cchUsed += (DWORD)cchString;
+
+	return szString;
+}
+
+/**
+ * Frees every string in the pool at once.
+ *
+ * @param lpPool String pool to be freed.
+ */
+void StringPoolFree(STRINGPOOL *lpPool) {
+	STRPOOL_BLOCK *lpNext;
+
+	while (lpPool->lpBlocks != NULL) {
+		lpNext = lpPool->lpBlocks->lpNext;
+		free(lpPool->lpBlocks);
+		lpPool->lpBlocks = lpNext;
+	}
+}
+
+/**
+ * Initializes an empty string table.
+ *
+ * @param lpTable String table to be initialized.
+ */
+void StringTableInitialize(STRINGTABLE *lpTable) {
+	lpTable->lpszaKeys = NULL;
+	lpTable->lpszNames = NULL;
+	lpTable->lpszParents = NULL;
+	lpTable->lpszPaths = NULL;
+	lpTable->nEntries = 0L;
+	lpTable->nCapacity = 0L;
+	lpTable->lpnBuckets = NULL;
+	lpTable->nBuckets = 0;
+	lpTable->szaLastParent = NULL;
+}
+
+/**
+ * Appends the strings of a page to the table. Pages in the same folder share
+ * the same interned parent string.
+ *
+ * @param  lpTable   String table.
+ * @param  lpPool    Pool that will hold the strings.
+ * @param  szaKey    String that identifies the page in the engine. Only its
+ *                   address is used, so it must stay valid.
+ * @param  szaName   Name of the page.
+ * @param  szaParent Parent folder of the page. Can be NULL.
+ * @param  szaPath   Full path to the page file.
+ * @return           Index of the new entry or -1 if it couldn't be added. A
+ *                   string that couldn't be interned is left as NULL.
+ */
+LONG StringTableAdd(STRINGTABLE *lpTable, STRINGPOOL *lpPool,
+					const char *szaKey, const char *szaName,
+					const char *szaParent, const char *szaPath) {
+	LONG nEntry;
+	DWORD iBucket;
+
+	// Make sure we have space for the new entry.
+	if ((lpTable->nEntries == lpTable->nCapacity) && !GrowStringTable(lpTable))
+		return -1L;
+	if (((DWORD)(lpTable->nEntries + 1) * 2) > lpTable->nBuckets) {
+		if (!RehashStringTable(lpTable, max(lpTable->nBuckets * 2,
+				STRTABLE_INITIAL_ENTRIES * 2))) {
+			return -1L;
+		}
+	}
+
+	// Intern the strings.
+	nEntry = lpTable->nEntries;
+	lpTable->lpszaKeys[nEntry] = szaKey;
+	lpTable->lpszNames[nEntry] = StringPoolAdd(lpPool, szaName);
+	lpTable->lpszPaths[nEntry] = StringPoolAdd(lpPool, szaPath);
+	if ((nEntry > 0L) && (szaParent != NULL) &&
+		(lpTable->szaLastParent != NULL) &&
+		((szaParent == lpTable->szaLastParent) ||
+		 (strcmp(szaParent, lpTable->szaLastParent) == 0))) {
+		lpTable->lpszParents[nEntry] = lpTable->lpszParents[nEntry - 1];
+	} else {
+		lpTable->lpszParents[nEntry] = StringPoolAdd(lpPool, szaParent);
+	}
+	lpTable->szaLastParent = szaParent;
+
+	// Index the key.
+	iBucket = HashStringKey(szaKey) & (lpTable->nBuckets - 1);
+	while (lpTable->lpnBuckets[iBucket] != STRTABLE_EMPTY_BUCKET)
+		iBucket = (iBucket + 1) & (lpTable->nBuckets - 1);
+	lpTable->lpnBuckets[iBucket] = nEntry;
+
+	lpTable->nEntries++;
+	return nEntry;
+}
+
+/**
+ * Finds a page by the address of its key string.
+ *
+ * @param  lpTable String table.
+ * @param  szaKey  String that identifies the page in the engine.
+ * @return         Index of the entry or -1 if it wasn't found.
+ */
+LONG StringTableFind(const STRINGTABLE *lpTable, const char *szaKey) {
+	DWORD iBucket;
+	LONG nEntry;
+
+	// Check if there's anything to look at.
+	if ((lpTable->nBuckets == 0) || (szaKey == NULL))
+		return -1L;
+
+	// Probe the buckets.
+	iBucket = HashStringKey(szaKey) & (lpTable->nBuckets - 1);
+	while ((nEntry = lpTable->lpnBuckets[iBucket]) != STRTABLE_EMPTY_BUCKET) {
+		if (lpTable->lpszaKeys[nEntry] == szaKey)
+			return nEntry;
+
+		iBucket = (iBucket + 1) & (lpTable->nBuckets - 1);
+	}
+
+	return -1L;
+}
+
+/**
+ * Gets the name of a page.
+ *
+ * @param  lpTable String table.
+ * @param  nEntry  Index of the entry.
+ * @return         Interned name or NULL if the entry doesn't exist.
+ */
+LPCTSTR StringTableGetName(const STRINGTABLE *lpTable, LONG nEntry) {
+	if ((nEntry < 0L) || (nEntry >= lpTable->nEntries))
+		return NULL;
+
+	return lpTable->lpszNames[nEntry];
+}
+
+/**
+ * Gets the parent folder of a page.
+ *
+ * @param  lpTable String table.
+ * @param  nEntry  Index of the entry.
+ * @return         Interned parent or NULL if there isn't one.
+ */
+LPCTSTR StringTableGetParent(const STRINGTABLE *lpTable, LONG nEntry) {
+	if ((nEntry < 0L) || (nEntry >= lpTable->nEntries))
+		return NULL;
+
+	return lpTable->lpszParents[nEntry];
+}
+
+/**
+ * Gets the full file path of a page.
+ *
+ * @param  lpTable String table.
+ * @param  nEntry  Index of the entry.
+ * @return         Interned path or NULL if the entry doesn't exist.
+ */
+LPCTSTR StringTableGetPath(const STRINGTABLE *lpTable, LONG nEntry) {
+	if ((nEntry < 0L) || (nEntry >= lpTable->nEntries))
+		return NULL;
+
+	return lpTable->lpszPaths[nEntry];
+}
+
+/**
+ * Frees the arrays of a string table. The strings themselves belong to the
+ * pool.
+ *
+ * @param lpTable String table to be freed.
+ */
+void StringTableFree(STRINGTABLE *lpTable) {
+	free((void*)lpTable->lpszaKeys);
+	free((void*)lpTable->lpszNames);
+	free((void*)lpTable->lpszParents);
+	free((void*)lpTable->lpszPaths);
+	free(lpTable->lpnBuckets);
+
+	StringTableInitialize(lpTable);
+}
+
+/**
+ * Doubles the capacity of the arrays of a string table.
+ *
+ * @param  lpTable String table.
+ * @return         TRUE if the operation was successful.
+ */
+BOOL GrowStringTable(STRINGTABLE *lpTable) {
+	LONG nCapacity;
+	void *lpNew;
+
+	// Get the new capacity.
+	nCapacity = lpTable->nCapacity * 2L;
+	if (nCapacity == 0L)
+		nCapacity = STRTABLE_INITIAL_ENTRIES;
+
+	// Grow each array. Whatever got reallocated stays valid on failure.
+	lpNew = realloc((void*)lpTable->lpszaKeys, nCapacity * sizeof(const char*));
+	if (lpNew == NULL)
+		return FALSE;
+	lpTable->lpszaKeys = (const char**)lpNew;
+
+	lpNew = realloc((void*)lpTable->lpszNames, nCapacity * sizeof(LPCTSTR));
+	if (lpNew == NULL)
+		return FALSE;
+	lpTable->lpszNames = (LPCTSTR*)lpNew;
+
+	lpNew = realloc((void*)lpTable->lpszParents, nCapacity * sizeof(LPCTSTR));
+	if (lpNew == NULL)
+		return FALSE;
+	lpTable->lpszParents = (LPCTSTR*)lpNew;
+
+	lpNew = realloc((void*)lpTable->lpszPaths, nCapacity * sizeof(LPCTSTR));
+	if (lpNew == NULL)
+		return FALSE;
+	lpTable->lpszPaths = (LPCTSTR*)lpNew;
+
+	lpTable->nCapacity = nCapacity;
+	return TRUE;
+}
+
+/**
+ * Rebuilds the key buckets of a string table with a new size.
+ *
+ * @param  lpTable  String table.
+ * @param  nBuckets New number of buckets. Must be a power of two.
+ * @return          TRUE if the operation was successful.
+ */
+BOOL RehashStringTable(STRINGTABLE *lpTable, DWORD nBuckets) {
+	LONG *lpnBuckets;
+	DWORD iBucket;
+	LONG iEntry;
+
+	// Allocate the new buckets.
+	lpnBuckets = (LONG*)malloc(nBuckets * sizeof(LONG));
+	if (lpnBuckets == NULL)
+		return FALSE;
+	for (iBucket = 0; iBucket < nBuckets; iBucket++)
+		lpnBuckets[iBucket] = STRTABLE_EMPTY_BUCKET;
+
+	// Put the existing entries in them.
+	for (iEntry = 0L; iEntry < lpTable->nEntries; iEntry++) {
+		iBucket = HashStringKey(lpTable->lpszaKeys[iEntry]) & (nBuckets - 1);
+		while (lpnBuckets[iBucket] != STRTABLE_EMPTY_BUCKET)
+			iBucket = (iBucket + 1) & (nBuckets - 1);
+		lpnBuckets[iBucket] = iEntry;
+	}
+
+	free(lpTable->lpnBuckets);
+	lpTable->lpnBuckets = lpnBuckets;
+	lpTable->nBuckets = nBuckets;
+
+	return TRUE;
+}
+
+/**
+ * Hashes the address of a key string.
+ *
+ * @param  szaKey Key string.
+ * @return        Hash of its address.
+ */
+DWORD HashStringKey(const char *szaKey) {
+	DWORD dwHash = (DWORD)(size_t)szaKey;
+
+	// Mix the bits so that aligned addresses spread over the buckets.
+	dwHash ^= dwHash >> 16;
+	dwHash *= 0x7FEB352DUL;
+	dwHash ^= dwHash >> 15;
+
+	return dwHash;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+/**
+ * StringTable.h
+ * Interned wide strings for the names, parents, and paths of a set of pages.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _STRINGTABLE_H
+#define _STRINGTABLE_H
+
+#include <windows.h>
+
+// Characters in each block of a string pool.
+#define STRPOOL_BLOCK_SIZE 4096
+
+// A block of interned strings. Strings never move once they are added.
+typedef struct STRPOOL_BLOCK {
+	struct STRPOOL_BLOCK *lpNext;
+	DWORD cchUsed;
+	DWORD cchSize;
+	WCHAR szData[1];
+} STRPOOL_BLOCK;
+
+// Pool that owns the interned strings.
+typedef struct {
+	STRPOOL_BLOCK *lpBlocks;
+} STRINGPOOL;
+
+// Wide forms of the strings of a set of pages, one array per field. Pages can
+// also be found by the address of the string the engine uses as their key.
+typedef struct {
+	const char **lpszaKeys;
+	LPCTSTR *lpszNames;
+	LPCTSTR *lpszParents;
+	LPCTSTR *lpszPaths;
+	LONG nEntries;
+	LONG nCapacity;
+	LONG *lpnBuckets;
+	DWORD nBuckets;
+	const char *szaLastParent;
+} STRINGTABLE;
+
+// String pool.
+void StringPoolInitialize(STRINGPOOL *lpPool);
+LPCTSTR StringPoolAdd(STRINGPOOL *lpPool, const char *szaString);
+void StringPoolFree(STRINGPOOL *lpPool);
+
+// Page strings.
+void StringTableInitialize(STRINGTABLE *lpTable);
+LONG StringTableAdd(STRINGTABLE *lpTable, STRINGPOOL *lpPool,
+					const char *szaKey, const char *szaName,
+					const char *szaParent, const char *szaPath);
+LONG StringTableFind(const STRINGTABLE *lpTable, const char *szaKey);
+LPCTSTR StringTableGetName(const STRINGTABLE *lpTable, LONG nEntry);
+LPCTSTR StringTableGetParent(const STRINGTABLE *lpTable, LONG nEntry);
+LPCTSTR StringTableGetPath(const STRINGTABLE *lpTable, LONG nEntry);
+void StringTableFree(STRINGTABLE *lpTable);
+
+#endif  // _STRINGTABLE_H
\ No newline at end of file
@@ -0,0 +1,678 @@
+/**
+ * TextIndex.c
+ * A platform-neutral inverted index of the words in the pages of a workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "TextIndex.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Definitions.
+#define TXTIDX_INITIAL_BUCKETS  1024L
+#define TXTIDX_INITIAL_CAPACITY 4L
+#define TXTIDX_INITIAL_POOL     4096
+#define TXTIDX_PURGE_MIN        256L
+
+// Checks if a character is part of a word. Bytes outside of ASCII are treated
+// as letters so that encoded text isn't split apart.
+#define IS_WORD_CHAR(c) (isalnum((unsigned char)(c)) || ((c) == '_') || \
+						 ((unsigned char)(c) >= 0x80))
+
+// Private methods.
+int GrowArray(void **lppArray, long *lpnCapacity, long nNeeded,
+			  size_t nItemSize);
+const char* NextWord(const char *lpText, const char *lpEnd, size_t *lpnLen);
+void LowerWord(char *szaDest, const char *lpWord, size_t nLen);
+unsigned long HashWord(const char *szaWord, size_t nLen);
+long FindTerm(const TEXTINDEX *tiIndex, const char *szaWord, size_t nLen,
+			  unsigned long dwHash);
+long AddTerm(TEXTINDEX *tiIndex, const char *szaWord, size_t nLen,
+			 unsigned long dwHash);
+int RehashTerms(TEXTINDEX *tiIndex, long nBuckets);
+long FindPosting(const TXTIDX_TERM *lpTerm, long lDoc);
+int MapPage(TEXTINDEX *tiIndex, int iKind, long nPage, long lDoc);
+void PurgeDeadDocuments(TEXTINDEX *tiIndex);
+
+/**
+ * Initializes an empty text index.
+ *
+ * @param  tiIndex Text index to be initialized.
+ * @return         Non-zero if the initialization was successful.
+ */
+int TextIndexInitialize(TEXTINDEX *tiIndex) {
+	int iKind;
+
+	// Set everything to its defaults.
+	tiIndex->lpTerms = NULL;
+	tiIndex->nTerms = 0L;
+	tiIndex->nTermCapacity = 0L;
+	tiIndex->lpBuckets = NULL;
+	tiIndex->nBuckets = 0L;
+	tiIndex->szaPool = NULL;
+	tiIndex->cchPool = 0;
+	tiIndex->cchPoolCapacity = 0;
+	tiIndex->lpDocs = NULL;
+	tiIndex->nDocs = 0L;
+	tiIndex->nDocCapacity = 0L;
+	tiIndex->nDeadDocs = 0L;
+	for (iKind = 0; iKind < TXTIDX_KINDS; iKind++) {
+		tiIndex->alpPageDocs[iKind] = NULL;
+		tiIndex->anPageCapacity[iKind] = 0L;
+	}
+
+	// Create the dictionary hash table.
+	return RehashTerms(tiIndex, TXTIDX_INITIAL_BUCKETS);
+}
+
+/**
+ * Frees everything allocated by the text index.
+ *
+ * @param tiIndex Text index to be freed.
+ */
+void TextIndexFree(TEXTINDEX *tiIndex) {
+	long lTerm;
+	int iKind;
+
+	// Free the postings.
+	for (lTerm = 0L; lTerm < tiIndex->nTerms; lTerm++) {
+		if (tiIndex->lpTerms[lTerm].lpPostings != NULL)
+			free(tiIndex->lpTerms[lTerm].lpPostings);
+	}
+
+	// Free the tables.
+	if (tiIndex->lpTerms != NULL)
+		free(tiIndex->lpTerms);
+	if (tiIndex->lpBuckets != NULL)
+		free(tiIndex->lpBuckets);
+	if (tiIndex->szaPool != NULL)
+		free(tiIndex->szaPool);
+	if (tiIndex->lpDocs != NULL)
+		free(tiIndex->lpDocs);
+	for (iKind = 0; iKind < TXTIDX_KINDS; iKind++) {
+		if (tiIndex->alpPageDocs[iKind] != NULL)
+			free(tiIndex->alpPageDocs[iKind]);
+		tiIndex->alpPageDocs[iKind] = NULL;
+		tiIndex->anPageCapacity[iKind] = 0L;
+	}
+
+	tiIndex->lpTerms = NULL;
+	tiIndex->nTerms = 0L;
+	tiIndex->nTermCapacity = 0L;
+	tiIndex->lpBuckets = NULL;
+	tiIndex->nBuckets = 0L;
+	tiIndex->szaPool = NULL;
+	tiIndex->cchPool = 0;
+	tiIndex->cchPoolCapacity = 0;
+	tiIndex->lpDocs = NULL;
+	tiIndex->nDocs = 0L;
+	tiIndex->nDocCapacity = 0L;
+	tiIndex->nDeadDocs = 0L;
+}
+
+/**
+ * Indexes the text of a page, replacing whatever was indexed for it before.
+ *
+ * @param  tiIndex Text index.
+ * @param  iKind   Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param  nPage   Index of the page in the Uki engine.
+ * @param  szaText Text of the page.
+ * @param  nLen    Length of the text.
+ * @return         Non-zero if the operation was successful.
+ */
+int TextIndexSetDocument(TEXTINDEX *tiIndex, int iKind, long nPage,
+						 const char *szaText, size_t nLen) {
+	char szaWord[TXTIDX_MAX_TERM_LEN + 1];
+	TXTIDX_TERM *lpTerm;
+	TXTIDX_DOC *lpDoc;
+	const char *lpWord;
+	const char *lpEnd;
+	size_t nWordLen;
+	unsigned long dwHash;
+	long lTerm;
+	long lDoc;
+
+	// Check the page.
+	if ((iKind < 0) || (iKind >= TXTIDX_KINDS) || (nPage < 0L))
+		return 0;
+
+	// Forget the previous version of the page.
+	TextIndexRemoveDocument(tiIndex, iKind, nPage);
+
+	// Create the new document.
+	if (!GrowArray((void**)&tiIndex->lpDocs, &tiIndex->nDocCapacity,
+			tiIndex->nDocs + 1L, sizeof(TXTIDX_DOC))) {
+		return 0;
+	}
+	lDoc = tiIndex->nDocs;
+	if (!MapPage(tiIndex, iKind, nPage, lDoc))
+		return 0;
+	lpDoc = &tiIndex->lpDocs[lDoc];
+	lpDoc->iKind = iKind;
+	lpDoc->nPage = nPage;
+	lpDoc->fDead = 0;
+	tiIndex->nDocs++;
+
+	// Go through the words in the text.
+	lpEnd = szaText + nLen;
+	for (lpWord = NextWord(szaText, lpEnd, &nWordLen); lpWord != NULL;
+			lpWord = NextWord(lpWord + nWordLen, lpEnd, &nWordLen)) {
+		if (nWordLen > TXTIDX_MAX_TERM_LEN)
+			continue;
+
+		// Get the word from the dictionary.
+		LowerWord(szaWord, lpWord, nWordLen);
+		dwHash = HashWord(szaWord, nWordLen);
+		lTerm = FindTerm(tiIndex, szaWord, nWordLen, dwHash);
+		if (lTerm == TXTIDX_NONE) {
+			lTerm = AddTerm(tiIndex, szaWord, nWordLen, dwHash);
+			if (lTerm == TXTIDX_NONE)
+				return 0;
+		}
+
+		// Only the first occurrence is recorded. This document is always the
+		// newest one, so it can only be at the end of the postings.
+		lpTerm = &tiIndex->lpTerms[lTerm];
+		if ((lpTerm->nPostings > 0L) &&
+				(lpTerm->lpPostings[lpTerm->nPostings - 1].lDoc == lDoc)) {
+			continue;
+		}
+
+		// Append the posting.
+		if (!GrowArray((void**)&lpTerm->lpPostings, &lpTerm->nCapacity,
+				lpTerm->nPostings + 1L, sizeof(TXTIDX_POSTING))) {
+			return 0;
+		}
+		lpTerm->lpPostings[lpTerm->nPostings].lDoc = lDoc;
+		lpTerm->lpPostings[lpTerm->nPostings].dwOffset =
+			(unsigned long)(lpWord - szaText);
+		lpTerm->nPostings++;
+	}
+
+	// Get rid of dead postings once they start to weigh on the queries.
+	if ((tiIndex->nDeadDocs >= TXTIDX_PURGE_MIN) &&
+			((tiIndex->nDeadDocs * 4L) >= tiIndex->nDocs)) {
+		PurgeDeadDocuments(tiIndex);
+	}
+
+	return 1;
+}
+
+/**
+ * Removes a page from the index.
+ *
+ * @param tiIndex Text index.
+ * @param iKind   Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param nPage   Index of the page in the Uki engine.
+ */
+void TextIndexRemoveDocument(TEXTINDEX *tiIndex, int iKind, long nPage) {
+	long lDoc;
+
+	// Check if the page was indexed.
+	if ((iKind < 0) || (iKind >= TXTIDX_KINDS) || (nPage < 0L) ||
+			(nPage >= tiIndex->anPageCapacity[iKind])) {
+		return;
+	}
+	lDoc = tiIndex->alpPageDocs[iKind][nPage];
+	if (lDoc == TXTIDX_NONE)
+		return;
+
+	// Its postings are skipped until they get purged.
+	tiIndex->lpDocs[lDoc].fDead = 1;
+	tiIndex->alpPageDocs[iKind][nPage] = TXTIDX_NONE;
+	tiIndex->nDeadDocs++;
+}
+
+/**
+ * Finds the pages that contain all of the words in a query.
+ *
+ * @param  tiIndex     Text index.
+ * @param  szaQuery    Words to look for, case insensitive.
+ * @param  lpMatches   Array to receive the matches, in indexing order.
+ * @param  nMaxMatches Maximum number of matches to return.
+ * @return             Number of matches found.
+ */
+long TextIndexQuery(const TEXTINDEX *tiIndex, const char *szaQuery,
+					TXTIDX_MATCH *lpMatches, long nMaxMatches) {
+	const TXTIDX_TERM *alpTerms[TXTIDX_MAX_QUERY_TERMS];
+	const TXTIDX_POSTING *lpPosting;
+	const TXTIDX_DOC *lpDoc;
+	char szaWord[TXTIDX_MAX_TERM_LEN + 1];
+	const char *lpWord;
+	const char *lpEnd;
+	size_t nWordLen;
+	unsigned long dwOffset;
+	long lTerm;
+	long lFound;
+	long iPosting;
+	long nMatches;
+	int nTerms;
+	int iRarest;
+	int iTerm;
+
+	// Look up the query words.
+	nTerms = 0;
+	lpEnd = szaQuery + strlen(szaQuery);
+	for (lpWord = NextWord(szaQuery, lpEnd, &nWordLen); lpWord != NULL;
+			lpWord = NextWord(lpWord + nWordLen, lpEnd, &nWordLen)) {
+		if ((nWordLen > TXTIDX_MAX_TERM_LEN) ||
+				(nTerms == TXTIDX_MAX_QUERY_TERMS)) {
+			return 0L;
+		}
+
+		// A word that was never seen can't match anything.
+		LowerWord(szaWord, lpWord, nWordLen);
+		lTerm = FindTerm(tiIndex, szaWord, nWordLen,
+			HashWord(szaWord, nWordLen));
+		if (lTerm == TXTIDX_NONE)
+			return 0L;
+
+		alpTerms[nTerms++] = &tiIndex->lpTerms[lTerm];
+	}
+	if (nTerms == 0)
+		return 0L;
+
+	// Drive the intersection from the rarest word.
+	iRarest = 0;
+	for (iTerm = 1; iTerm < nTerms; iTerm++) {
+		if (alpTerms[iTerm]->nPostings < alpTerms[iRarest]->nPostings)
+			iRarest = iTerm;
+	}
+
+	// Go through the candidate documents.
+	nMatches = 0L;
+	for (iPosting = 0L; (iPosting < alpTerms[iRarest]->nPostings) &&
+			(nMatches < nMaxMatches); iPosting++) {
+		lpPosting = &alpTerms[iRarest]->lpPostings[iPosting];
+		lpDoc = &tiIndex->lpDocs[lpPosting->lDoc];
+		if (lpDoc->fDead)
+			continue;
+
+		// Check if every other word is in this document.
+		dwOffset = lpPosting->dwOffset;
+		for (iTerm = 0; iTerm < nTerms; iTerm++) {
+			if (iTerm == iRarest)
+				continue;
+
+			lFound = FindPosting(alpTerms[iTerm], lpPosting->lDoc);
+			if (lFound == TXTIDX_NONE)
+				break;
+
+			// Report where the first word of the query is.
+			if (iTerm == 0)
+				dwOffset = alpTerms[0]->lpPostings[lFound].dwOffset;
+		}
+		if (iTerm < nTerms)
+			continue;
+
+		// Append the match.
+		lpMatches[nMatches].iKind = lpDoc->iKind;
+		lpMatches[nMatches].nPage = lpDoc->nPage;
+		lpMatches[nMatches].dwOffset = dwOffset;
+		nMatches++;
+	}
+
+	return nMatches;
+}
+
+/**
+ * Checks if a single page contains all of the words in a query, which is the
+ * same as asking if it would be one of the matches of TextIndexQuery without
+ * going through every other page.
+ *
+ * @param  tiIndex  Text index.
+ * @param  iKind    Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param  nPage    Index of the page in the Uki engine.
+ * @param  szaQuery Words to look for, case insensitive.
+ * @return          Non-zero if the page contains every word.
+ */
+int TextIndexPageHasWords(const TEXTINDEX *tiIndex, int iKind, long nPage,
+						  const char *szaQuery) {
+	char szaWord[TXTIDX_MAX_TERM_LEN + 1];
+	const char *lpWord;
+	const char *lpEnd;
+	size_t nWordLen;
+	long lTerm;
+	long lDoc;
+	int nTerms;
+
+	// Get the current document of the page.
+	if ((iKind < 0) || (iKind >= TXTIDX_KINDS) || (nPage < 0L) ||
+			(nPage >= tiIndex->anPageCapacity[iKind])) {
+		return 0;
+	}
+	lDoc = tiIndex->alpPageDocs[iKind][nPage];
+	if (lDoc == TXTIDX_NONE)
+		return 0;
+
+	// Check every word of the query, with the same limits as a query.
+	nTerms = 0;
+	lpEnd = szaQuery + strlen(szaQuery);
+	for (lpWord = NextWord(szaQuery, lpEnd, &nWordLen); lpWord != NULL;
+			lpWord = NextWord(lpWord + nWordLen, lpEnd, &nWordLen)) {
+		if ((nWordLen > TXTIDX_MAX_TERM_LEN) ||
+				(nTerms == TXTIDX_MAX_QUERY_TERMS)) {
+			return 0;
+		}
+
+		LowerWord(szaWord, lpWord, nWordLen);
+		lTerm = FindTerm(tiIndex, szaWord, nWordLen,
+			HashWord(szaWord, nWordLen));
+		if ((lTerm == TXTIDX_NONE) ||
+				(FindPosting(&tiIndex->lpTerms[lTerm], lDoc) == TXTIDX_NONE)) {
+			return 0;
+		}
+
+		nTerms++;
+	}
+
+	return nTerms > 0;
+}
+
+/**
+ * Makes sure an array has room for a number of items.
+ *
+ * @param  lppArray    Pointer to the array, which may be NULL.
+ * @param  lpnCapacity Pointer to the current capacity of the array.
+ * @param  nNeeded     Number of items that must fit.
+ * @param  nItemSize   Size of each item.
+ * @return             Non-zero if the array is big enough.
+ */
+int GrowArray(void **lppArray, long *lpnCapacity, long nNeeded,
+			  size_t nItemSize) {
+	void *lpNewArray;
+	long nCapacity;
+
+	// Check if there's anything to be done.
+	if (nNeeded <= *lpnCapacity)
+		return 1;
+
+	// Double the capacity until it fits.
+	nCapacity = (*lpnCapacity > 0L) ? *lpnCapacity : TXTIDX_INITIAL_CAPACITY;
+	while (nCapacity < nNeeded)
+		nCapacity *= 2L;
+
+	// Reallocate the array.
+	lpNewArray = realloc(*lppArray, (size_t)nCapacity * nItemSize);
+	if (lpNewArray == NULL)
+		return 0;
+
+	*lppArray = lpNewArray;
+	*lpnCapacity = nCapacity;
+	return 1;
+}
+
+/**
+ * Finds the next word in a text.
+ *
+ * @param  lpText  Where to start looking.
+ * @param  lpEnd   End of the text.
+ * @param  lpnLen  Length of the word found.
+ * @return         Start of the word or NULL if there are no more words.
+ */
+const char* NextWord(const char *lpText, const char *lpEnd, size_t *lpnLen) {
+	const char *lpWord;
+
+	// Skip the separators.
+	while ((lpText < lpEnd) && !IS_WORD_CHAR(*lpText))
+		lpText++;
+	if (lpText == lpEnd)
+		return NULL;
+
+	// Go through the word.
+	lpWord = lpText;
+	while ((lpText < lpEnd) && IS_WORD_CHAR(*lpText))
+		lpText++;
+
+	*lpnLen = (size_t)(lpText - lpWord);
+	return lpWord;
+}
+
+/**
+ * Copies a word in lower case.
+ *
+ * @param szaDest Buffer big enough for the word and its terminator.
+ * @param lpWord  Start of the word.
+ * @param nLen    Length of the word.
+ */
+void LowerWord(char *szaDest, const char *lpWord, size_t nLen) {
+	size_t i;
+
+	for (i = 0; i < nLen; i++)
+		szaDest[i] = (char)tolower((unsigned char)lpWord[i]);
+	szaDest[nLen] = '\0';
+}
+
+/**
+ * Hashes a word with FNV-1a.
+ *
+ * @param  szaWord Word to be hashed.
+ * @param  nLen    Length of the word.
+ * @return         Hash of the word.
+ */
+unsigned long HashWord(const char *szaWord, size_t nLen) {
+	unsigned long dwHash = 2166136261UL;
+	size_t i;
+
+	for (i = 0; i < nLen; i++) {
+		dwHash ^= (unsigned char)szaWord[i];
+		dwHash = (dwHash * 16777619UL) & 0xFFFFFFFFUL;
+	}
+
+	return dwHash;
+}
+
+/**
+ * Finds a word in the dictionary.
+ *
+ * @param  tiIndex Text index.
+ * @param  szaWord Word in lower case.
+ * @param  nLen    Length of the word.
+ * @param  dwHash  Hash of the word.
+ * @return         Index of the term or TXTIDX_NONE if it isn't there.
+ */
+long FindTerm(const TEXTINDEX *tiIndex, const char *szaWord, size_t nLen,
+			  unsigned long dwHash) {
+	const TXTIDX_TERM *lpTerm;
+	long lMask;
+	long lBucket;
+
+	// Probe the hash table.
+	lMask = tiIndex->nBuckets - 1L;
+	for (lBucket = (long)(dwHash & (unsigned long)lMask);
+			tiIndex->lpBuckets[lBucket] != TXTIDX_NONE;
+			lBucket = (lBucket + 1L) & lMask) {
+		lpTerm = &tiIndex->lpTerms[tiIndex->lpBuckets[lBucket]];
+		if ((lpTerm->dwHash == dwHash) && (lpTerm->nLen == nLen) &&
+				(memcmp(tiIndex->szaPool + lpTerm->nPoolOffset, szaWord,
+					nLen) == 0)) {
+			return tiIndex->lpBuckets[lBucket];
+		}
+	}
+
+	return TXTIDX_NONE;
+}
+
+/**
+ * Adds a word to the dictionary.
+ *
+ * @param  tiIndex Text index.
+ * @param  szaWord Word in lower case.
+ * @param  nLen    Length of the word.
+ * @param  dwHash  Hash of the word.
+ * @return         Index of the new term or TXTIDX_NONE on failure.
+ */
+long AddTerm(TEXTINDEX *tiIndex, const char *szaWord, size_t nLen,
+			 unsigned long dwHash) {
+	TXTIDX_TERM *lpTerm;
+	long lMask;
+	long lBucket;
+
+	// Keep the hash table at most half full.
+	if (((tiIndex->nTerms + 1L) * 2L) > tiIndex->nBuckets) {
+		if (!RehashTerms(tiIndex, tiIndex->nBuckets * 2L))
+			return TXTIDX_NONE;
+	}
+
+	// Make room for the term and its string.
+	if (!GrowArray((void**)&tiIndex->lpTerms, &tiIndex->nTermCapacity,
+			tiIndex->nTerms + 1L, sizeof(TXTIDX_TERM))) {
+		return TXTIDX_NONE;
+	}
+	if ((tiIndex->cchPool + nLen) > tiIndex->cchPoolCapacity) {
+		size_t cchCapacity;
+		char *szaNewPool;
+
+		cchCapacity = (tiIndex->cchPoolCapacity > 0) ?
+			tiIndex->cchPoolCapacity : TXTIDX_INITIAL_POOL;
+		while (cchCapacity < (tiIndex->cchPool + nLen))
+			cchCapacity *= 2;
+
+		szaNewPool = (char*)realloc(tiIndex->szaPool, cchCapacity);
+		if (szaNewPool == NULL)
+			return TXTIDX_NONE;
+		tiIndex->szaPool = szaNewPool;
+		tiIndex->cchPoolCapacity = cchCapacity;
+	}
+
+	// Populate the term.
+	lpTerm = &tiIndex->lpTerms[tiIndex->nTerms];
+	memcpy(tiIndex->szaPool + tiIndex->cchPool, szaWord, nLen);
+	lpTerm->nPoolOffset = tiIndex->cchPool;
+	lpTerm->nLen = nLen;
+	lpTerm->dwHash = dwHash;
+	lpTerm->lpPostings = NULL;
+	lpTerm->nPostings = 0L;
+	lpTerm->nCapacity = 0L;
+	tiIndex->cchPool += nLen;
+
+	// Put it in the hash table.
+	lMask = tiIndex->nBuckets - 1L;
+	lBucket = (long)(dwHash & (unsigned long)lMask);
+	while (tiIndex->lpBuckets[lBucket] != TXTIDX_NONE)
+		lBucket = (lBucket + 1L) & lMask;
+	tiIndex->lpBuckets[lBucket] = tiIndex->nTerms;
+
+	return tiIndex->nTerms++;
+}
+
+/**
+ * Rebuilds the dictionary hash table with a new size.
+ *
+ * @param  tiIndex  Text index.
+ * @param  nBuckets New number of buckets, must be a power of two.
+ * @return          Non-zero if the operation was successful.
+ */
+int RehashTerms(TEXTINDEX *tiIndex, long nBuckets) {
+	long *lpBuckets;
+	long lMask;
+	long lBucket;
+	long lTerm;
+
+	// Allocate the new table.
+	lpBuckets = (long*)malloc((size_t)nBuckets * sizeof(long));
+	if (lpBuckets == NULL)
+		return 0;
+	for (lBucket = 0L; lBucket < nBuckets; lBucket++)
+		lpBuckets[lBucket] = TXTIDX_NONE;
+
+	// Put the terms back in.
+	lMask = nBuckets - 1L;
+	for (lTerm = 0L; lTerm < tiIndex->nTerms; lTerm++) {
+		lBucket = (long)(tiIndex->lpTerms[lTerm].dwHash & (unsigned long)lMask);
+		while (lpBuckets[lBucket] != TXTIDX_NONE)
+			lBucket = (lBucket + 1L) & lMask;
+		lpBuckets[lBucket] = lTerm;
+	}
+
+	// Swap the tables.
+	if (tiIndex->lpBuckets != NULL)
+		free(tiIndex->lpBuckets);
+	tiIndex->lpBuckets = lpBuckets;
+	tiIndex->nBuckets = nBuckets;
+
+	return 1;
+}
+
+/**
+ * Finds the posting of a document in a term.
+ *
+ * @param  lpTerm Term to search.
+ * @param  lDoc   Document to look for.
+ * @return        Index of the posting or TXTIDX_NONE if it isn't there.
+ */
+long FindPosting(const TXTIDX_TERM *lpTerm, long lDoc) {
+	long lLow;
+	long lHigh;
+	long lMiddle;
+
+	// Postings are sorted by document, so do a binary search.
+	lLow = 0L;
+	lHigh = lpTerm->nPostings - 1L;
+	while (lLow <= lHigh) {
+		lMiddle = lLow + ((lHigh - lLow) / 2L);
+		if (lpTerm->lpPostings[lMiddle].lDoc == lDoc) {
+			return lMiddle;
+		} else if (lpTerm->lpPostings[lMiddle].lDoc < lDoc) {
+			lLow = lMiddle + 1L;
+		} else {
+			lHigh = lMiddle - 1L;
+		}
+	}
+
+	return TXTIDX_NONE;
+}
+
+/**
+ * Associates a page with its current document.
+ *
+ * @param  tiIndex Text index.
+ * @param  iKind   Kind of the page.
+ * @param  nPage   Index of the page in the Uki engine.
+ * @param  lDoc    Document of the page.
+ * @return         Non-zero if the operation was successful.
+ */
+int MapPage(TEXTINDEX *tiIndex, int iKind, long nPage, long lDoc) {
+	long nOldCapacity;
+	long lPage;
+
+	// Make room for the page.
+	nOldCapacity = tiIndex->anPageCapacity[iKind];
+	if (!GrowArray((void**)&tiIndex->alpPageDocs[iKind],
+			&tiIndex->anPageCapacity[iKind], nPage + 1L, sizeof(long))) {
+		return 0;
+	}
+	for (lPage = nOldCapacity; lPage < tiIndex->anPageCapacity[iKind]; lPage++)
+		tiIndex->alpPageDocs[iKind][lPage] = TXTIDX_NONE;
+
+	tiIndex->alpPageDocs[iKind][nPage] = lDoc;
+	return 1;
+}
+
+/**
+ * Removes the postings of all of the dead documents.
+ *
+ * @param tiIndex Text index.
+ */
+void PurgeDeadDocuments(TEXTINDEX *tiIndex) {
+	TXTIDX_TERM *lpTerm;
+	long lTerm;
+	long iPosting;
+	long nKept;
+
+	// Go through the terms compacting their postings.
+	for (lTerm = 0L; lTerm < tiIndex->nTerms; lTerm++) {
+		lpTerm = &tiIndex->lpTerms[lTerm];
+
+		nKept = 0L;
+		for (iPosting = 0L; iPosting < lpTerm->nPostings; iPosting++) {
+			if (!tiIndex->lpDocs[lpTerm->lpPostings[iPosting].lDoc].fDead)
+				lpTerm->lpPostings[nKept++] = lpTerm->lpPostings[iPosting];
+		}
+		lpTerm->nPostings = nKept;
+	}
+
+	tiIndex->nDeadDocs = 0L;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+/**
+ * TextIndex.h
+ * A platform-neutral inverted index of the words in the pages of a workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _TEXTINDEX_H
+#define _TEXTINDEX_H
+
+#include <stddef.h>
+
+// Kinds of pages that can be indexed.
+#define TXTIDX_ARTICLE  0
+#define TXTIDX_TEMPLATE 1
+#define TXTIDX_KINDS    2
+
+// Special values.
+#define TXTIDX_NONE -1L
+
+// Longest word that gets indexed, longer ones are ignored.
+#define TXTIDX_MAX_TERM_LEN 64
+
+// Maximum number of words in a query.
+#define TXTIDX_MAX_QUERY_TERMS 8
+
+// First occurrence of a word in a document.
+typedef struct {
+	long lDoc;
+	unsigned long dwOffset;
+} TXTIDX_POSTING;
+
+// A word in the dictionary and the documents it appears in, sorted by document.
+typedef struct {
+	size_t nPoolOffset;
+	size_t nLen;
+	unsigned long dwHash;
+	TXTIDX_POSTING *lpPostings;
+	long nPostings;
+	long nCapacity;
+} TXTIDX_TERM;
+
+// A version of a page. Saving a page creates a new document and kills the
+// previous one, whose postings get purged when enough of them pile up.
+typedef struct {
+	int iKind;
+	long nPage;
+	int fDead;
+} TXTIDX_DOC;
+
+// A page that matched a query and the offset of the first query word in it.
+typedef struct {
+	int iKind;
+	long nPage;
+	unsigned long dwOffset;
+} TXTIDX_MATCH;
+
+// The whole index.
+typedef struct {
+	TXTIDX_TERM *lpTerms;
+	long nTerms;
+	long nTermCapacity;
+	long *lpBuckets;
+	long nBuckets;
+	char *szaPool;
+	size_t cchPool;
+	size_t cchPoolCapacity;
+	TXTIDX_DOC *lpDocs;
+	long nDocs;
+	long nDocCapacity;
+	long nDeadDocs;
+	long *alpPageDocs[TXTIDX_KINDS];
+	long anPageCapacity[TXTIDX_KINDS];
+} TEXTINDEX;
+
+// Initialization and destruction.
+int TextIndexInitialize(TEXTINDEX *tiIndex);
+void TextIndexFree(TEXTINDEX *tiIndex);
+
+// Documents.
+int TextIndexSetDocument(TEXTINDEX *tiIndex, int iKind, long nPage,
+						 const char *szaText, size_t nLen);
+void TextIndexRemoveDocument(TEXTINDEX *tiIndex, int iKind, long nPage);
+
+// Querying.
+long TextIndexQuery(const TEXTINDEX *tiIndex, const char *szaQuery,
+					TXTIDX_MATCH *lpMatches, long nMaxMatches);
+int TextIndexPageHasWords(const TEXTINDEX *tiIndex, int iKind, long nPage,
+						  const char *szaQuery);
+
+#endif  // _TEXTINDEX_H
\ No newline at end of file
@@ -0,0 +1,462 @@
+/**
+ * TextSearch.c
+ * A platform-neutral engine to find and replace text in UTF-16 buffers.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "TextSearch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+
+// Pick the vector instructions available.
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define TXTSRCH_SSE2
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define TXTSRCH_NEON
+	#include <arm_neon.h>
+#endif
+
+// Definitions.
+#define TXTSRCH_INITIAL_MATCHES 64
+#define TXTSRCH_SCAN_MAX_NEEDLE 4
+
+// Skip table of the search kernels. Characters are bucketed by their low
+// byte, which can only make the shifts shorter.
+#define SHIFT_BUCKETS  256
+#define SHIFT_INDEX(c) ((c) & 0xFF)
+
+// Ways of folding characters before comparing them.
+#define FOLD_EXACT(c) (c)
+#define FOLD_UPPER(c) (((c) < 0x80) ? \
+	(unsigned short)((((c) >= 'a') && ((c) <= 'z')) ? ((c) - 0x20) : (c)) : \
+	(unsigned short)towupper(c))
+
+// Private methods.
+long FindMatchBound(const size_t *lpMatches, long nMatches, size_t nPos);
+size_t FindExactShort(const unsigned short *szText, size_t cchText,
+					  size_t nFrom, const unsigned short *szNeedle,
+					  size_t cchNeedle);
+size_t ScanForChar(const unsigned short *lpText, size_t cchText,
+				   unsigned short wChar);
+
+// Search kernels.
+#define KERNEL_NAME    FindExactForward
+#define KERNEL_FOLD    FOLD_EXACT
+#define KERNEL_REVERSE 0
+#include "TextSearchKernel.h"
+
+#define KERNEL_NAME    FindFoldedForward
+#define KERNEL_FOLD    FOLD_UPPER
+#define KERNEL_REVERSE 0
+#include "TextSearchKernel.h"
+
+#define KERNEL_NAME    FindExactReverse
+#define KERNEL_FOLD    FOLD_EXACT
+#define KERNEL_REVERSE 1
+#include "TextSearchKernel.h"
+
+#define KERNEL_NAME    FindFoldedReverse
+#define KERNEL_FOLD    FOLD_UPPER
+#define KERNEL_REVERSE 1
+#include "TextSearchKernel.h"
+
+/**
+ * Finds the next occurrence of a needle in a text.
+ *
+ * @param  szText     Text to search in. Doesn't need to be NULL terminated.
+ * @param  cchText    Length of the text in characters.
+ * @param  nFrom      Position to start searching from.
+ * @param  szNeedle   Text to look for.
+ * @param  cchNeedle  Length of the needle in characters.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Position of the occurrence or TXTSRCH_NONE if there isn't
+ *                    one.
+ */
+size_t TextSearchFind(const unsigned short *szText, size_t cchText,
+					  size_t nFrom, const unsigned short *szNeedle,
+					  size_t cchNeedle, int fMatchCase) {
+	// Check if the needle even fits.
+	if ((cchNeedle == 0) || (cchNeedle > cchText) ||
+		(nFrom > (cchText - cchNeedle))) {
+		return TXTSRCH_NONE;
+	}
+
+	// Short needles barely skip anything, so just scan for them.
+	if (fMatchCase) {
+		if (cchNeedle < TXTSRCH_SCAN_MAX_NEEDLE) {
+			return FindExactShort(szText, cchText, nFrom, szNeedle,
+				cchNeedle);
+		}
+
+		return FindExactForward(szText, cchText, nFrom, szNeedle, cchNeedle);
+	}
+
+	return FindFoldedForward(szText, cchText, nFrom, szNeedle, cchNeedle);
+}
+
+/**
+ * Finds the previous occurrence of a needle in a text.
+ *
+ * @param  szText     Text to search in. Doesn't need to be NULL terminated.
+ * @param  cchText    Length of the text in characters.
+ * @param  nBefore    Position where the occurrence must end by.
+ * @param  szNeedle   Text to look for.
+ * @param  cchNeedle  Length of the needle in characters.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Position of the occurrence or TXTSRCH_NONE if there isn't
+ *                    one.
+ */
+size_t TextSearchFindReverse(const unsigned short *szText, size_t cchText,
+							 size_t nBefore, const unsigned short *szNeedle,
+							 size_t cchNeedle, int fMatchCase) {
+	// Check if the needle even fits.
+	if ((cchNeedle == 0) || (cchNeedle > cchText))
+		return TXTSRCH_NONE;
+
+	if (fMatchCase)
+		return FindExactReverse(szText, cchText, nBefore, szNeedle, cchNeedle);
+
+	return FindFoldedReverse(szText, cchText, nBefore, szNeedle, cchNeedle);
+}
+
+/**
+ * Finds every occurrence of a needle after a position in a single pass.
+ * Occurrences don't overlap and are taken from left to right.
+ * @remark Remember to free the matches with TextSearchFreeMatches.
+ *
+ * @param  szText     Text to search in.
+ * @param  cchText    Length of the text in characters.
+ * @param  nFrom      Position to start searching from.
+ * @param  szNeedle   Text to look for.
+ * @param  cchNeedle  Length of the needle in characters.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @param  lppMatches Sorted positions of the occurrences. NULL if none were
+ *                    found.
+ * @return            Number of occurrences found or -1 if we ran out of memory.
+ */
+long TextSearchFindAll(const unsigned short *szText, size_t cchText,
+					   size_t nFrom, const unsigned short *szNeedle,
+					   size_t cchNeedle, int fMatchCase, size_t **lppMatches) {
+	size_t *lpMatches;
+	size_t *lpNew;
+	size_t nCapacity;
+	size_t nMatches;
+	size_t nPos;
+
+	lpMatches = NULL;
+	nCapacity = 0;
+	nMatches = 0;
+	*lppMatches = NULL;
+
+	// Go through every occurrence.
+	nPos = TextSearchFind(szText, cchText, nFrom, szNeedle, cchNeedle,
+		fMatchCase);
+	while (nPos != TXTSRCH_NONE) {
+		// Make space for it.
+		if (nMatches == nCapacity) {
+			nCapacity = (nCapacity == 0) ? TXTSRCH_INITIAL_MATCHES :
+				(nCapacity * 2);
+			lpNew = (size_t*)realloc(lpMatches, nCapacity * sizeof(size_t));
+			if (lpNew == NULL) {
+				free(lpMatches);
+				return -1L;
+			}
+			lpMatches = lpNew;
+		}
+
+		lpMatches[nMatches++] = nPos;
+		nPos = TextSearchFind(szText, cchText, nPos + cchNeedle, szNeedle,
+			cchNeedle, fMatchCase);
+	}
+
+	*lppMatches = lpMatches;
+	return (long)nMatches;
+}
+
+/**
+ * Finds the first match in a match set that starts at or after a position.
+ *
+ * @param  lpMatches Sorted positions of the matches.
+ * @param  nMatches  Number of matches in the set.
+ * @param  nPos      Position to look from.
+ * @return           Index of the match or -1 if there isn't one.
+ */
+long TextSearchNextMatch(const size_t *lpMatches, long nMatches, size_t nPos) {
+	long lMatch = FindMatchBound(lpMatches, nMatches, nPos);
+
+	return (lMatch < nMatches) ? lMatch : -1L;
+}
+
+/**
+ * Finds the last match in a match set that starts before a position.
+ *
+ * @param  lpMatches Sorted positions of the matches.
+ * @param  nMatches  Number of matches in the set.
+ * @param  nPos      Position to look from.
+ * @return           Index of the match or -1 if there isn't one.
+ */
+long TextSearchPreviousMatch(const size_t *lpMatches, long nMatches,
+							 size_t nPos) {
+	// The one we want is right before the first one that isn't before it.
+	return FindMatchBound(lpMatches, nMatches, nPos) - 1L;
+}
+
+/**
+ * Narrows a match set down to the occurrences of a longer needle that starts
+ * with the one the set was built for, without going through the whole text
+ * again. Every occurrence of the longer needle must begin within a match of
+ * the shorter one, so only those spots need to be looked at.
+ *
+ * @param  szText     Text the match set was built from.
+ * @param  cchText    Length of the text in characters.
+ * @param  lpMatches  Match set of the shorter needle, which gets narrowed in
+ *                    place.
+ * @param  nMatches   Number of matches in the set.
+ * @param  cchPrefix  Length of the needle the set was built for.
+ * @param  szNeedle   Longer needle to look for.
+ * @param  cchNeedle  Length of the longer needle in characters.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Number of matches left in the set.
+ */
+long TextSearchNarrowMatches(const unsigned short *szText, size_t cchText,
+							 size_t *lpMatches, long nMatches,
+							 size_t cchPrefix, const unsigned short *szNeedle,
+							 size_t cchNeedle, int fMatchCase) {
+	size_t nLastEnd;
+	size_t nFrom;
+	size_t nPos;
+	size_t cchWindow;
+	long iMatch;
+	long nKept;
+
+	nLastEnd = 0;
+	nKept = 0;
+	for (iMatch = 0; iMatch < nMatches; iMatch++) {
+		// Occurrences can't overlap the last one we kept.
+		nFrom = lpMatches[iMatch];
+		if (nFrom < nLastEnd)
+			nFrom = nLastEnd;
+
+		// Look for one starting anywhere the shorter match covers, which is
+		// more than one spot when the needle repeats itself.
+		cchWindow = lpMatches[iMatch] + cchPrefix - 1 + cchNeedle;
+		if (cchWindow > cchText)
+			cchWindow = cchText;
+		nPos = TextSearchFind(szText, cchWindow, nFrom, szNeedle, cchNeedle,
+			fMatchCase);
+		if (nPos == TXTSRCH_NONE)
+			continue;
+
+		lpMatches[nKept++] = nPos;
+		nLastEnd = nPos + cchNeedle;
+	}
+
+	return nKept;
+}
+
+/**
+ * Frees a match set.
+ *
+ * @param lpMatches Match set to be freed.
+ */
+void TextSearchFreeMatches(size_t *lpMatches) {
+	free(lpMatches);
+}
+
+/**
+ * Replaces every occurrence of a needle after a position in a single pass.
+ * Occurrences don't overlap and are taken from left to right.
+ * @remark Remember to free the result with TextSearchFreeReplace.
+ *
+ * @param  szText         Text to search in.
+ * @param  cchText        Length of the text in characters.
+ * @param  nFrom          Position to start replacing from.
+ * @param  szNeedle       Text to look for.
+ * @param  cchNeedle      Length of the needle in characters.
+ * @param  szReplacement  Text to put in place of the needle.
+ * @param  cchReplacement Length of the replacement in characters.
+ * @param  fMatchCase     Should the case of the letters be taken into account?
+ * @param  lpReplace      Result of the operation, which only covers the part
+ *                        of the text between the first and last occurrences.
+ * @return                Number of occurrences replaced or -1 if we ran out of
+ *                        memory.
+ */
+long TextSearchReplaceAll(const unsigned short *szText, size_t cchText,
+						  size_t nFrom, const unsigned short *szNeedle,
+						  size_t cchNeedle, const unsigned short *szReplacement,
+						  size_t cchReplacement, int fMatchCase,
+						  TXTSRCH_REPLACE *lpReplace) {
+	size_t *lpMatches;
+	long nFound;
+	size_t nMatches;
+	size_t iMatch;
+	size_t nLast;
+	unsigned short *lpOut;
+
+	// Set the defaults.
+	lpReplace->szResult = NULL;
+	lpReplace->cchResult = 0;
+	lpReplace->nStart = 0;
+	lpReplace->nEnd = 0;
+	lpReplace->nMatches = 0L;
+
+	// Find every occurrence.
+	nFound = TextSearchFindAll(szText, cchText, nFrom, szNeedle, cchNeedle,
+		fMatchCase, &lpMatches);
+	if (nFound <= 0L)
+		return nFound;
+	nMatches = (size_t)nFound;
+
+	// Allocate the result for the part between the first and last occurrences.
+	lpReplace->nStart = lpMatches[0];
+	lpReplace->nEnd = lpMatches[nMatches - 1] + cchNeedle;
+	lpReplace->cchResult = (lpReplace->nEnd - lpReplace->nStart) -
+		(nMatches * cchNeedle) + (nMatches * cchReplacement);
+	lpReplace->szResult = (unsigned short*)malloc((lpReplace->cchResult + 1) *
+		sizeof(unsigned short));
+	if (lpReplace->szResult == NULL) {
+		free(lpMatches);
+		return -1L;
+	}
+
+	// Build it.
+	lpOut = lpReplace->szResult;
+	for (iMatch = 0; iMatch < nMatches; iMatch++) {
+		// Copy what was between this occurrence and the previous one.
+		if (iMatch > 0) {
+			nLast = lpMatches[iMatch - 1] + cchNeedle;
+			memcpy(lpOut, szText + nLast,
+				(lpMatches[iMatch] - nLast) * sizeof(unsigned short));
+			lpOut += lpMatches[iMatch] - nLast;
+		}
+
+		// Put the replacement in.
+		memcpy(lpOut, szReplacement, cchReplacement * sizeof(unsigned short));
+		lpOut += cchReplacement;
+	}
+	*lpOut = 0;
+
+	lpReplace->nMatches = (long)nMatches;
+	free(lpMatches);
+
+	return lpReplace->nMatches;
+}
+
+/**
+ * Frees the result of a replace operation.
+ *
+ * @param lpReplace Result to be freed.
+ */
+void TextSearchFreeReplace(TXTSRCH_REPLACE *lpReplace) {
+	free(lpReplace->szResult);
+	lpReplace->szResult = NULL;
+	lpReplace->cchResult = 0;
+}
+
+/**
+ * Binary searches a match set for the first match that isn't before a
+ * position.
+ *
+ * @param  lpMatches Sorted positions of the matches.
+ * @param  nMatches  Number of matches in the set.
+ * @param  nPos      Position to look from.
+ * @return           Index of the match or nMatches if every match is before
+ *                   the position.
+ */
+long FindMatchBound(const size_t *lpMatches, long nMatches, size_t nPos) {
+	long lLow = 0L;
+	long lHigh = nMatches;
+	long lMiddle;
+
+	// Look for the first position that isn't before the one given.
+	while (lLow < lHigh) {
+		lMiddle = lLow + ((lHigh - lLow) / 2);
+		if (lpMatches[lMiddle] < nPos) {
+			lLow = lMiddle + 1;
+		} else {
+			lHigh = lMiddle;
+		}
+	}
+
+	return lLow;
+}
+
+/**
+ * Finds the next occurrence of a short needle, matching the case, by scanning
+ * for its first character.
+ *
+ * @param  szText    Text to search in.
+ * @param  cchText   Length of the text in characters.
+ * @param  nFrom     Position to start searching from.
+ * @param  szNeedle  Text to look for.
+ * @param  cchNeedle Length of the needle in characters. Must fit in the text.
+ * @return           Position of the occurrence or TXTSRCH_NONE.
+ */
+size_t FindExactShort(const unsigned short *szText, size_t cchText,
+					  size_t nFrom, const unsigned short *szNeedle,
+					  size_t cchNeedle) {
+	size_t nLast = cchText - cchNeedle;
+	size_t iPos = nFrom;
+
+	while (iPos <= nLast) {
+		// Jump to the next candidate.
+		iPos += ScanForChar(szText + iPos, nLast - iPos + 1, szNeedle[0]);
+		if (iPos > nLast)
+			break;
+
+		// Check the rest of it.
+		if (memcmp(szText + iPos + 1, szNeedle + 1,
+				(cchNeedle - 1) * sizeof(unsigned short)) == 0) {
+			return iPos;
+		}
+
+		iPos++;
+	}
+
+	return TXTSRCH_NONE;
+}
+
+/**
+ * Finds the first occurrence of a character.
+ *
+ * @param  lpText  Text to search in.
+ * @param  cchText Length of the text in characters.
+ * @param  wChar   Character to look for.
+ * @return         Position of the character or cchText if it isn't there.
+ */
+size_t ScanForChar(const unsigned short *lpText, size_t cchText,
+				   unsigned short wChar) {
+	size_t iChar = 0;
+
+#if defined(TXTSRCH_SSE2)
+	// Compare 8 characters at a time.
+	__m128i vChar = _mm_set1_epi16((short)wChar);
+	for (; (cchText - iChar) >= 8; iChar += 8) {
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128(
+				(const __m128i*)(lpText + iChar)), vChar)) != 0) {
+			break;
+		}
+	}
+#elif defined(TXTSRCH_NEON)
+	// Compare 8 characters at a time.
+	uint16x8_t vChar = vdupq_n_u16(wChar);
+	for (; (cchText - iChar) >= 8; iChar += 8) {
+		uint16x8_t vEqual = vceqq_u16(vld1q_u16(lpText + iChar), vChar);
+		uint16x4_t vBits = vorr_u16(vget_low_u16(vEqual),
+			vget_high_u16(vEqual));
+
+		if (vget_lane_u64(vreinterpret_u64_u16(vBits), 0) != 0)
+			break;
+	}
+#endif
+
+	// Find the exact character.
+	while ((iChar < cchText) && (lpText[iChar] != wChar))
+		iChar++;
+
+	return iChar;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+/**
+ * TextSearch.h
+ * A platform-neutral engine to find and replace text in UTF-16 buffers.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _TEXTSEARCH_H
+#define _TEXTSEARCH_H
+
+#include <stddef.h>
+
+// Returned when nothing was found.
+#define TXTSRCH_NONE ((size_t)-1)
+
+// Result of a replace operation. The replaced text is what goes in place of
+// the characters between nStart and nEnd of the original text.
+typedef struct {
+	unsigned short *szResult;
+	size_t cchResult;
+	size_t nStart;
+	size_t nEnd;
+	long nMatches;
+} TXTSRCH_REPLACE;
+
+// Finding.
+size_t TextSearchFind(const unsigned short *szText, size_t cchText,
+					  size_t nFrom, const unsigned short *szNeedle,
+					  size_t cchNeedle, int fMatchCase);
+size_t TextSearchFindReverse(const unsigned short *szText, size_t cchText,
+							 size_t nBefore, const unsigned short *szNeedle,
+							 size_t cchNeedle, int fMatchCase);
+
+// Match sets.
+long TextSearchFindAll(const unsigned short *szText, size_t cchText,
+					   size_t nFrom, const unsigned short *szNeedle,
+					   size_t cchNeedle, int fMatchCase, size_t **lppMatches);
+long TextSearchNextMatch(const size_t *lpMatches, long nMatches, size_t nPos);
+long TextSearchPreviousMatch(const size_t *lpMatches, long nMatches,
+							 size_t nPos);
+long TextSearchNarrowMatches(const unsigned short *szText, size_t cchText,
+							 size_t *lpMatches, long nMatches,
+							 size_t cchPrefix, const unsigned short *szNeedle,
+							 size_t cchNeedle, int fMatchCase);
+void TextSearchFreeMatches(size_t *lpMatches);
+
+// Replacing.
+long TextSearchReplaceAll(const unsigned short *szText, size_t cchText,
+						  size_t nFrom, const unsigned short *szNeedle,
+						  size_t cchNeedle, const unsigned short *szReplacement,
+						  size_t cchReplacement, int fMatchCase,
+						  TXTSRCH_REPLACE *lpReplace);
+void TextSearchFreeReplace(TXTSRCH_REPLACE *lpReplace);
+
+#endif  // _TEXTSEARCH_H
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * TextSearchKernel.h
+ * Boyer-Moore-Horspool search kernel for TextSearch.c, which includes this
+ * file once for every combination of case folding and direction it needs.
+ *
+ * Before including it define:
+ *   KERNEL_NAME    Name of the function to be generated.
+ *   KERNEL_FOLD(c) How a character is folded before comparing.
+ *   KERNEL_REVERSE 1 to search backwards, 0 to search forwards.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+/**
+ * Finds an occurrence of a needle in a text.
+ *
+ * @param  szText    Text to search in.
+ * @param  cchText   Length of the text in characters.
+ * @param  nFrom     When searching forwards, first position where the needle
+ *                   can start. Backwards, the position where it must end by.
+ * @param  szNeedle  Text to look for.
+ * @param  cchNeedle Length of the needle in characters. Must fit in the text.
+ * @return           Position of the occurrence or TXTSRCH_NONE.
+ */
+size_t KERNEL_NAME(const unsigned short *szText, size_t cchText, size_t nFrom,
+				   const unsigned short *szNeedle, size_t cchNeedle) {
+	size_t aShift[SHIFT_BUCKETS];
+	size_t nLast = cchNeedle - 1;
+	size_t iPos;
+	size_t iChar;
+	unsigned short wKey;
+	unsigned short wChar;
+
+	// Characters that aren't in the needle let us skip all of it.
+	for (iChar = 0; iChar < SHIFT_BUCKETS; iChar++)
+		aShift[iChar] = cchNeedle;
+
+#if KERNEL_REVERSE
+	// Shifts are based on the first character of the window.
+	for (iChar = nLast; iChar > 0; iChar--)
+		aShift[SHIFT_INDEX(KERNEL_FOLD(szNeedle[iChar]))] = iChar;
+	wKey = KERNEL_FOLD(szNeedle[0]);
+
+	// Slide the window backwards.
+	if (nFrom > cchText)
+		nFrom = cchText;
+	if (nFrom < cchNeedle)
+		return TXTSRCH_NONE;
+	iPos = nFrom - cchNeedle;
+	for (;;) {
+		wChar = KERNEL_FOLD(szText[iPos]);
+		if (wChar == wKey) {
+			for (iChar = 1; iChar < cchNeedle; iChar++) {
+				if (KERNEL_FOLD(szText[iPos + iChar]) !=
+						KERNEL_FOLD(szNeedle[iChar])) {
+					break;
+				}
+			}
+			if (iChar == cchNeedle)
+				return iPos;
+		}
+
+		// Move on.
+		if (aShift[SHIFT_INDEX(wChar)] > iPos)
+			break;
+		iPos -= aShift[SHIFT_INDEX(wChar)];
+	}
+#else
+	// Shifts are based on the last character of the window.
+	for (iChar = 0; iChar < nLast; iChar++)
+		aShift[SHIFT_INDEX(KERNEL_FOLD(szNeedle[iChar]))] = nLast - iChar;
+	wKey = KERNEL_FOLD(szNeedle[nLast]);
+
+	// Slide the window forwards.
+	for (iPos = nFrom; (cchText - iPos) > nLast; ) {
+		wChar = KERNEL_FOLD(szText[iPos + nLast]);
+		if (wChar == wKey) {
+			for (iChar = 0; iChar < nLast; iChar++) {
+				if (KERNEL_FOLD(szText[iPos + iChar]) !=
+						KERNEL_FOLD(szNeedle[iChar])) {
+					break;
+				}
+			}
+			if (iChar == nLast)
+				return iPos;
+		}
+
+		// Move on.
+		iPos += aShift[SHIFT_INDEX(wChar)];
+	}
+#endif
+
+	return TXTSRCH_NONE;
+}
+
+#undef KERNEL_NAME
+#undef KERNEL_FOLD
+#undef KERNEL_REVERSE
\ No newline at end of file
@@ -0,0 +1,476 @@
+/**
+ * Transcode.c
+ * A platform-neutral set of ASCII and UTF-8 to UTF-16 conversion routines with
+ * vectorized paths for runs of plain ASCII text.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "Transcode.h"
+#include <string.h>
+
+// Pick the vector instructions available.
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define TRANSCODE_SSE2
+	#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define TRANSCODE_NEON
+	#include <arm_neon.h>
+#endif
+
+// High bit of every byte in a machine word.
+#define WORD_HIGH_BITS ((~0UL / 0xFFUL) * 0x80UL)
+
+// Private methods.
+size_t DecodeUtf8(const unsigned char *lpSrc, size_t cbSrc,
+				  unsigned long *lpdwChar);
+size_t DecodeUtf16(const unsigned short *lpSrc, size_t cchSrc,
+				   unsigned long *lpdwChar);
+
+/**
+ * Gets the length of the run of ASCII characters at the start of a buffer.
+ *
+ * @param  szaSrc Buffer to be checked.
+ * @param  cbSrc  Length of the buffer in bytes.
+ * @return        Number of bytes before the first one that isn't ASCII.
+ */
+size_t TranscodeAsciiSpan(const char *szaSrc, size_t cbSrc) {
+	size_t iByte = 0;
+	unsigned long dwWord;
+
+#if defined(TRANSCODE_SSE2)
+	// Check 16 bytes at a time.
+	for (; (cbSrc - iByte) >= 16; iByte += 16) {
+		if (_mm_movemask_epi8(_mm_loadu_si128(
+				(const __m128i*)(szaSrc + iByte))) != 0) {
+			break;
+		}
+	}
+#elif defined(TRANSCODE_NEON)
+	// Check 16 bytes at a time.
+	for (; (cbSrc - iByte) >= 16; iByte += 16) {
+		uint8x16_t vBytes = vld1q_u8((const uint8_t*)(szaSrc + iByte));
+		uint8x8_t vBits = vorr_u8(vget_low_u8(vBytes), vget_high_u8(vBytes));
+
+		if ((vget_lane_u64(vreinterpret_u64_u8(vBits), 0) &
+				0x8080808080808080ULL) != 0) {
+			break;
+		}
+	}
+#endif
+
+	// Check a word at a time.
+	for (; (cbSrc - iByte) >= sizeof(dwWord); iByte += sizeof(dwWord)) {
+		memcpy(&dwWord, szaSrc + iByte, sizeof(dwWord));
+		if (dwWord & WORD_HIGH_BITS)
+			break;
+	}
+
+	// Find the exact byte.
+	while ((iByte < cbSrc) && !(szaSrc[iByte] & 0x80))
+		iByte++;
+
+	return iByte;
+}
+
+/**
+ * Gets the length of the run of ASCII characters at the start of a UTF-16
+ * buffer.
+ *
+ * @param  szSrc  Buffer to be checked.
+ * @param  cchSrc Length of the buffer in characters.
+ * @return        Number of characters before the first one that isn't ASCII.
+ */
+size_t TranscodeWideAsciiSpan(const unsigned short *szSrc, size_t cchSrc) {
+	size_t iChar = 0;
+
+#if defined(TRANSCODE_SSE2)
+	// Check 8 characters at a time.
+	__m128i vMask = _mm_set1_epi16((short)0xFF80);
+	__m128i vZero = _mm_setzero_si128();
+	for (; (cchSrc - iChar) >= 8; iChar += 8) {
+		__m128i vChars = _mm_loadu_si128((const __m128i*)(szSrc + iChar));
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(vChars, vMask),
+				vZero)) != 0xFFFF) {
+			break;
+		}
+	}
+#elif defined(TRANSCODE_NEON)
+	// Check 8 characters at a time.
+	for (; (cchSrc - iChar) >= 8; iChar += 8) {
+		uint16x8_t vChars = vld1q_u16(szSrc + iChar);
+		uint16x4_t vBits = vorr_u16(vget_low_u16(vChars),
+			vget_high_u16(vChars));
+
+		if ((vget_lane_u64(vreinterpret_u64_u16(vBits), 0) &
+				0xFF80FF80FF80FF80ULL) != 0) {
+			break;
+		}
+	}
+#endif
+
+	// Find the exact character.
+	while ((iChar < cchSrc) && (szSrc[iChar] < 0x80))
+		iChar++;
+
+	return iChar;
+}
+
+/**
+ * Widens a run of ASCII characters to UTF-16.
+ *
+ * @param szDest Buffer to receive nLen characters.
+ * @param szaSrc ASCII characters to be widened.
+ * @param nLen   Number of characters.
+ */
+void TranscodeAsciiToWide(unsigned short *szDest, const char *szaSrc,
+						  size_t nLen) {
+	size_t iChar = 0;
+
+#if defined(TRANSCODE_SSE2)
+	// Widen 16 characters at a time.
+	__m128i vZero = _mm_setzero_si128();
+	for (; (nLen - iChar) >= 16; iChar += 16) {
+		__m128i vBytes = _mm_loadu_si128((const __m128i*)(szaSrc + iChar));
+
+		_mm_storeu_si128((__m128i*)(szDest + iChar),
+			_mm_unpacklo_epi8(vBytes, vZero));
+		_mm_storeu_si128((__m128i*)(szDest + iChar + 8),
+			_mm_unpackhi_epi8(vBytes, vZero));
+	}
+#elif defined(TRANSCODE_NEON)
+	// Widen 16 characters at a time.
+	for (; (nLen - iChar) >= 16; iChar += 16) {
+		uint8x16_t vBytes = vld1q_u8((const uint8_t*)(szaSrc + iChar));
+
+		vst1q_u16(szDest + iChar, vmovl_u8(vget_low_u8(vBytes)));
+		vst1q_u16(szDest + iChar + 8, vmovl_u8(vget_high_u8(vBytes)));
+	}
+#endif
+
+	// Widen whatever is left.
+	for (; iChar < nLen; iChar++)
+		szDest[iChar] = (unsigned char)szaSrc[iChar];
+}
+
+/**
+ * Narrows a run of ASCII characters from UTF-16.
+ *
+ * @param szaDest Buffer to receive nLen characters.
+ * @param szSrc   UTF-16 characters, all of them below 0x80.
+ * @param nLen    Number of characters.
+ */
+void TranscodeWideToAscii(char *szaDest, const unsigned short *szSrc,
+						  size_t nLen) {
+	size_t iChar = 0;
+
+#if defined(TRANSCODE_SSE2)
+	// Narrow 16 characters at a time.
+	for (; (nLen - iChar) >= 16; iChar += 16) {
+		__m128i vLow = _mm_loadu_si128((const __m128i*)(szSrc + iChar));
+		__m128i vHigh = _mm_loadu_si128((const __m128i*)(szSrc + iChar + 8));
+
+		_mm_storeu_si128((__m128i*)(szaDest + iChar),
+			_mm_packus_epi16(vLow, vHigh));
+	}
+#elif defined(TRANSCODE_NEON)
+	// Narrow 16 characters at a time.
+	for (; (nLen - iChar) >= 16; iChar += 16) {
+		vst1q_u8((uint8_t*)(szaDest + iChar),
+			vcombine_u8(vmovn_u16(vld1q_u16(szSrc + iChar)),
+						vmovn_u16(vld1q_u16(szSrc + iChar + 8))));
+	}
+#endif
+
+	// Narrow whatever is left.
+	for (; iChar < nLen; iChar++)
+		szaDest[iChar] = (char)szSrc[iChar];
+}
+
+/**
+ * Gets the number of UTF-16 characters needed to hold a UTF-8 buffer.
+ *
+ * @param  szaSrc UTF-8 buffer.
+ * @param  cbSrc  Length of the buffer in bytes.
+ * @return        Number of UTF-16 characters TranscodeUtf8ToWide will write.
+ */
+size_t TranscodeUtf8Length(const char *szaSrc, size_t cbSrc) {
+	const unsigned char *lpSrc = (const unsigned char*)szaSrc;
+	unsigned long dwChar;
+	size_t cchDest = 0;
+	size_t iByte = 0;
+	size_t nAscii;
+
+	while (iByte < cbSrc) {
+		// ASCII maps one to one.
+		if (lpSrc[iByte] < 0x80) {
+			nAscii = TranscodeAsciiSpan(szaSrc + iByte, cbSrc - iByte);
+			iByte += nAscii;
+			cchDest += nAscii;
+			if (iByte == cbSrc)
+				break;
+		}
+
+		// Everything else takes one or two characters.
+		iByte += DecodeUtf8(lpSrc + iByte, cbSrc - iByte, &dwChar);
+		cchDest += (dwChar > 0xFFFF) ? 2 : 1;
+	}
+
+	return cchDest;
+}
+
+/**
+ * Converts a UTF-8 buffer to UTF-16. Invalid sequences are replaced by
+ * TRANSCODE_REPLACEMENT.
+ *
+ * @param  szDest Buffer big enough for what TranscodeUtf8Length says.
+ * @param  szaSrc UTF-8 buffer.
+ * @param  cbSrc  Length of the buffer in bytes.
+ * @return        Number of UTF-16 characters written.
+ */
+size_t TranscodeUtf8ToWide(unsigned short *szDest, const char *szaSrc,
+						   size_t cbSrc) {
+	const unsigned char *lpSrc = (const unsigned char*)szaSrc;
+	unsigned long dwChar;
+	size_t cchDest = 0;
+	size_t iByte = 0;
+	size_t nAscii;
+
+	while (iByte < cbSrc) {
+		// Widen runs of ASCII in one go.
+		if (lpSrc[iByte] < 0x80) {
+			nAscii = TranscodeAsciiSpan(szaSrc + iByte, cbSrc - iByte);
+			TranscodeAsciiToWide(szDest + cchDest, szaSrc + iByte, nAscii);
+			iByte += nAscii;
+			cchDest += nAscii;
+			if (iByte == cbSrc)
+				break;
+		}
+
+		// Decode the next character.
+		iByte += DecodeUtf8(lpSrc + iByte, cbSrc - iByte, &dwChar);
+		if (dwChar > 0xFFFF) {
+			dwChar -= 0x10000;
+			szDest[cchDest++] = (unsigned short)(0xD800 + (dwChar >> 10));
+			szDest[cchDest++] = (unsigned short)(0xDC00 + (dwChar & 0x3FF));
+		} else {
+			szDest[cchDest++] = (unsigned short)dwChar;
+		}
+	}
+
+	return cchDest;
+}
+
+/**
+ * Gets the number of bytes needed to hold a UTF-16 buffer as UTF-8.
+ *
+ * @param  szSrc  UTF-16 buffer.
+ * @param  cchSrc Length of the buffer in characters.
+ * @return        Number of bytes TranscodeWideToUtf8 will write.
+ */
+size_t TranscodeWideUtf8Length(const unsigned short *szSrc, size_t cchSrc) {
+	unsigned long dwChar;
+	size_t cbDest = 0;
+	size_t iChar = 0;
+	size_t nAscii;
+
+	while (iChar < cchSrc) {
+		// ASCII maps one to one.
+		if (szSrc[iChar] < 0x80) {
+			nAscii = TranscodeWideAsciiSpan(szSrc + iChar, cchSrc - iChar);
+			iChar += nAscii;
+			cbDest += nAscii;
+			if (iChar == cchSrc)
+				break;
+		}
+
+		// Everything else takes two to four bytes.
+		iChar += DecodeUtf16(szSrc + iChar, cchSrc - iChar, &dwChar);
+		if (dwChar < 0x800) {
+			cbDest += 2;
+		} else if (dwChar < 0x10000) {
+			cbDest += 3;
+		} else {
+			cbDest += 4;
+		}
+	}
+
+	return cbDest;
+}
+
+/**
+ * Converts a UTF-16 buffer to UTF-8. Unpaired surrogates are replaced by
+ * TRANSCODE_REPLACEMENT.
+ *
+ * @param  szaDest Buffer big enough for what TranscodeWideUtf8Length says.
+ * @param  szSrc   UTF-16 buffer.
+ * @param  cchSrc  Length of the buffer in characters.
+ * @return         Number of bytes written.
+ */
+size_t TranscodeWideToUtf8(char *szaDest, const unsigned short *szSrc,
+						   size_t cchSrc) {
+	unsigned char *lpDest = (unsigned char*)szaDest;
+	unsigned long dwChar;
+	size_t cbDest = 0;
+	size_t iChar = 0;
+	size_t nAscii;
+
+	while (iChar < cchSrc) {
+		// Narrow runs of ASCII in one go.
+		if (szSrc[iChar] < 0x80) {
+			nAscii = TranscodeWideAsciiSpan(szSrc + iChar, cchSrc - iChar);
+			TranscodeWideToAscii(szaDest + cbDest, szSrc + iChar, nAscii);
+			iChar += nAscii;
+			cbDest += nAscii;
+			if (iChar == cchSrc)
+				break;
+		}
+
+		// Encode the next character.
+		iChar += DecodeUtf16(szSrc + iChar, cchSrc - iChar, &dwChar);
+		if (dwChar < 0x800) {
+			lpDest[cbDest++] = (unsigned char)(0xC0 | (dwChar >> 6));
+		} else if (dwChar < 0x10000) {
+			lpDest[cbDest++] = (unsigned char)(0xE0 | (dwChar >> 12));
+			lpDest[cbDest++] = (unsigned char)(0x80 | ((dwChar >> 6) & 0x3F));
+		} else {
+			lpDest[cbDest++] = (unsigned char)(0xF0 | (dwChar >> 18));
+			lpDest[cbDest++] = (unsigned char)(0x80 | ((dwChar >> 12) & 0x3F));
+			lpDest[cbDest++] = (unsigned char)(0x80 | ((dwChar >> 6) & 0x3F));
+		}
+		lpDest[cbDest++] = (unsigned char)(0x80 | (dwChar & 0x3F));
+	}
+
+	return cbDest;
+}
+
+/**
+ * Gets the number of bytes at the end of a buffer that are the start of a
+ * UTF-8 sequence which continues past it, so that a stream can be converted
+ * in blocks without splitting characters.
+ *
+ * @param  szaSrc UTF-8 buffer.
+ * @param  cbSrc  Length of the buffer in bytes.
+ * @return        Number of bytes to hold back for the next block.
+ */
+size_t TranscodeUtf8Tail(const char *szaSrc, size_t cbSrc) {
+	const unsigned char *lpSrc = (const unsigned char*)szaSrc;
+	size_t nTail;
+	size_t nNeeded;
+
+	// Look back for the lead byte of the last sequence.
+	for (nTail = 1; (nTail <= 3) && (nTail <= cbSrc); nTail++) {
+		unsigned char cByte = lpSrc[cbSrc - nTail];
+
+		// Continuation bytes belong to something further back.
+		if ((cByte & 0xC0) == 0x80)
+			continue;
+
+		// Check how long the sequence started by this byte is.
+		if (cByte >= 0xF0) {
+			nNeeded = 4;
+		} else if (cByte >= 0xE0) {
+			nNeeded = 3;
+		} else if (cByte >= 0xC0) {
+			nNeeded = 2;
+		} else {
+			nNeeded = 1;
+		}
+
+		return (nNeeded > nTail) ? nTail : 0;
+	}
+
+	return 0;
+}
+
+/**
+ * Decodes a single UTF-8 character that isn't ASCII.
+ *
+ * @param  lpSrc    Start of the character.
+ * @param  cbSrc    Bytes available.
+ * @param  lpdwChar Decoded code point or TRANSCODE_REPLACEMENT if the
+ *                  sequence is invalid.
+ * @return          Number of bytes consumed, always at least one.
+ */
+size_t DecodeUtf8(const unsigned char *lpSrc, size_t cbSrc,
+				  unsigned long *lpdwChar) {
+	unsigned long dwChar;
+	unsigned char cLow;
+	unsigned char cHigh;
+	size_t nLen;
+	size_t iByte;
+
+	// Figure out the length of the sequence from the lead byte and the range
+	// of its second byte, which rules out overlong forms, surrogates, and
+	// anything past Unicode.
+	*lpdwChar = TRANSCODE_REPLACEMENT;
+	cLow = 0x80;
+	cHigh = 0xBF;
+	if ((lpSrc[0] >= 0xC2) && (lpSrc[0] <= 0xDF)) {
+		nLen = 2;
+		dwChar = lpSrc[0] & 0x1F;
+	} else if ((lpSrc[0] >= 0xE0) && (lpSrc[0] <= 0xEF)) {
+		nLen = 3;
+		dwChar = lpSrc[0] & 0x0F;
+		if (lpSrc[0] == 0xE0)
+			cLow = 0xA0;
+		if (lpSrc[0] == 0xED)
+			cHigh = 0x9F;
+	} else if ((lpSrc[0] >= 0xF0) && (lpSrc[0] <= 0xF4)) {
+		nLen = 4;
+		dwChar = lpSrc[0] & 0x07;
+		if (lpSrc[0] == 0xF0)
+			cLow = 0x90;
+		if (lpSrc[0] == 0xF4)
+			cHigh = 0x8F;
+	} else {
+		return 1;
+	}
+
+	// Gather the continuation bytes. A broken sequence is replaced as a whole
+	// up to where it broke.
+	for (iByte = 1; iByte < nLen; iByte++) {
+		if ((iByte >= cbSrc) || (lpSrc[iByte] < cLow) ||
+			(lpSrc[iByte] > cHigh)) {
+			return iByte;
+		}
+
+		dwChar = (dwChar << 6) | (lpSrc[iByte] & 0x3F);
+		cLow = 0x80;
+		cHigh = 0xBF;
+	}
+
+	*lpdwChar = dwChar;
+	return nLen;
+}
+
+/**
+ * Decodes a single UTF-16 character that isn't ASCII.
+ *
+ * @param  lpSrc    Start of the character.
+ * @param  cchSrc   Characters available.
+ * @param  lpdwChar Decoded code point or TRANSCODE_REPLACEMENT if it's an
+ *                  unpaired surrogate.
+ * @return          Number of characters consumed.
+ */
+size_t DecodeUtf16(const unsigned short *lpSrc, size_t cchSrc,
+				   unsigned long *lpdwChar) {
+	// Most characters are just themselves.
+	if ((lpSrc[0] < 0xD800) || (lpSrc[0] > 0xDFFF)) {
+		*lpdwChar = lpSrc[0];
+		return 1;
+	}
+
+	// Join surrogate pairs.
+	if ((lpSrc[0] <= 0xDBFF) && (cchSrc > 1) && (lpSrc[1] >= 0xDC00) &&
+		(lpSrc[1] <= 0xDFFF)) {
+		*lpdwChar = 0x10000 + (((unsigned long)(lpSrc[0] - 0xD800) << 10) |
+			(lpSrc[1] - 0xDC00));
+		return 2;
+	}
+
+	*lpdwChar = TRANSCODE_REPLACEMENT;
+	return 1;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+/**
+ * Transcode.h
+ * A platform-neutral set of ASCII and UTF-8 to UTF-16 conversion routines with
+ * vectorized paths for runs of plain ASCII text.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _TRANSCODE_H
+#define _TRANSCODE_H
+
+#include <stddef.h>
+
+// Character used in place of invalid sequences.
+#define TRANSCODE_REPLACEMENT 0xFFFD
+
+// Runs of ASCII text.
+size_t TranscodeAsciiSpan(const char *szaSrc, size_t cbSrc);
+size_t TranscodeWideAsciiSpan(const unsigned short *szSrc, size_t cchSrc);
+void TranscodeAsciiToWide(unsigned short *szDest, const char *szaSrc,
+						  size_t nLen);
+void TranscodeWideToAscii(char *szaDest, const unsigned short *szSrc,
+						  size_t nLen);
+
+// UTF-8.
+size_t TranscodeUtf8Length(const char *szaSrc, size_t cbSrc);
+size_t TranscodeUtf8ToWide(unsigned short *szDest, const char *szaSrc,
+						   size_t cbSrc);
+size_t TranscodeWideUtf8Length(const unsigned short *szSrc, size_t cchSrc);
+size_t TranscodeWideToUtf8(char *szaDest, const unsigned short *szSrc,
+						   size_t cchSrc);
+size_t TranscodeUtf8Tail(const char *szaSrc, size_t cbSrc);
+
+#endif  // _TRANSCODE_H
\ No newline at end of file
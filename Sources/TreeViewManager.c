@@ -74,6 +74,62 @@ HTREEITEM TreeViewAddItem(HTREEITEM hParent, LPTSTR szText,
 	return hItem;
 }
 
+/**
+ * Adds an item to the TreeView that will have its caption requested through
+ * the TVN_GETDISPINFO notification and its children inserted only when
+ * it gets expanded.
+ *
+ * @param  hParent      Parent TreeView item handle.
+ * @param  hInsAfter    Insert after this TreeView item handle.
+ * @param  iImage       Index to the item icon in the ImageList.
+ * @param  fHasChildren Should the item show the expand button?
+ * @param  lParam       Item lParam.
+ * @return              Added item handle.
+ */
+HTREEITEM TreeViewAddCallbackItem(HTREEITEM hParent, HTREEITEM hInsAfter,
+								  int iImage, BOOL fHasChildren,
+								  LPARAM lParam) {
+	TV_ITEM tvItem;
+	TV_INSERTSTRUCT tvInsert;
+
+	// Fill out the item structure.
+	tvItem.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_PARAM |
+		TVIF_CHILDREN;
+	tvItem.pszText = LPSTR_TEXTCALLBACK;
+	tvItem.cchTextMax = 0;
+	tvItem.iImage = iImage;
+	tvItem.iSelectedImage = iImage;
+	tvItem.cChildren = fHasChildren ? 1 : 0;
+	tvItem.lParam = lParam;
+
+	// Fill out the insert structure.
+	tvInsert.item = tvItem;
+	tvInsert.hInsertAfter = hInsAfter;
+	tvInsert.hParent = hParent;
+
+	// Insert the item into the tree.
+	return (HTREEITEM)SendMessage(hwndTreeView, TVM_INSERTITEM, 0,
+		(LPARAM)(LPTV_INSERTSTRUCT)&tvInsert);
+}
+
+/**
+ * Changes the caption of a TreeView item.
+ *
+ * @param  hItem  TreeView item handle.
+ * @param  szText New item caption.
+ * @return        TRUE if the operation was successful.
+ */
+BOOL TreeViewSetItemText(HTREEITEM hItem, LPTSTR szText) {
+	TV_ITEM tvItem;
+
+	tvItem.mask = TVIF_TEXT;
+	tvItem.hItem = hItem;
+	tvItem.pszText = szText;
+	tvItem.cchTextMax = wcslen(szText);
+
+	return TreeView_SetItem(hwndTreeView, &tvItem);
+}
+
 /**
  * Gets a TreeView item.
  *
@@ -84,6 +140,15 @@ BOOL TreeViewGetItem(TVITEM *tvItem) {
 	return TreeView_GetItem(hwndTreeView, tvItem);
 }
 
+/**
+ * Gets the item that is selected in the TreeView.
+ *
+ * @return Handle to the selected item or NULL if there's none.
+ */
+HTREEITEM TreeViewGetSelection() {
+	return TreeView_GetSelection(hwndTreeView);
+}
+
 /**
  * Expands a node in the TreeView.
  *
@@ -22,7 +22,12 @@ BOOL TreeViewClear();
 HTREEITEM TreeViewAddItem(HTREEITEM hParent, LPTSTR szText,
 						  HTREEITEM hInsAfter, int iImage,
 						  LPARAM lParam);
+HTREEITEM TreeViewAddCallbackItem(HTREEITEM hParent, HTREEITEM hInsAfter,
+								  int iImage, BOOL fHasChildren,
+								  LPARAM lParam);
+BOOL TreeViewSetItemText(HTREEITEM hItem, LPTSTR szText);
 BOOL TreeViewGetItem(TVITEM *tvItem);
+HTREEITEM TreeViewGetSelection();
 BOOL TreeViewExpandNode(HTREEITEM hNode);
 
 #endif  // _TREEVIEWMANAGER_H
\ No newline at end of file
@@ -5,13 +5,46 @@
  * @author Nathan Campos <hi@nathancampos.me>
  */
 
+#include <stdlib.h>
 #include "UkiHelper.h"
 #include "Utilities.h"
+#include "FolderSnapshot.h"
+#include "WorkspaceIndex.h"
+#include "WorkspaceSearch.h"
+#include "DependencyIndex.h"
+#include "StringTable.h"
 
 // Global variables.
 TCHAR szCurrentWikiRoot[UKI_MAX_PATH];
 TCHAR szArticlesFolder[UKI_MAX_PATH];
 TCHAR szTemplatesFolder[UKI_MAX_PATH];
+FOLDERSNAPSHOT fsArticles;
+FOLDERSNAPSHOT fsTemplates;
+WORKSPACEINDEX wiIndex;
+DWORD dwRenderGeneration = 0;
+BOOL fRefreshBroken = FALSE;
+FILETIME ftManifest;
+STRINGPOOL spStrings;
+STRINGTABLE stArticles;
+STRINGTABLE stTemplates;
+
+// Private methods.
+BOOL LoadWorkspaceSnapshots();
+BOOL RecoverWorkspaceWrites();
+void GetWorkspaceIndexPath(LPTSTR szIndexPath);
+BOOL GetManifestModifiedTime(FILETIME *lpftModified);
+BOOL TakeWorkspaceSnapshots(FOLDERSNAPSHOT *lpArticles,
+							FOLDERSNAPSHOT *lpTemplates);
+BOOL CountSnapshotChange(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+						 LPARAM lParam);
+BOOL ApplyArticleChange(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+						LPARAM lParam);
+BOOL ApplyTemplateChange(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+						 LPARAM lParam);
+void BuildUkiStrings();
+BOOL InternUkiArticle(LONG nIndex);
+BOOL InternUkiTemplate(LONG nIndex);
+LONG FindInternedPath(const STRINGTABLE *lpTable, LPCTSTR szPath);
 
 /**
  * Initializes the Uki engine.
@@ -20,30 +53,94 @@ TCHAR szTemplatesFolder[UKI_MAX_PATH];
  * @return            TRUE if everything went fine.
  */
 BOOL InitializeUki(LPCTSTR szWikiPath) {
-	char szaPath[UKI_MAX_PATH];
 	int err;
 
+	// Initialize the engine.
+	if (!InitializeUkiEngine(szWikiPath, &err)) {
+		if (err == UKI_OK) {
+			MessageBox(NULL, L"Failed to convert the wiki path from Unicode to "
+				L"ASCII", L"Conversion Error", MB_OK | MB_ICONERROR);
+		} else {
+			ShowUkiErrorDialog(err);
+		}
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Initializes the Uki engine without showing anything to the user, so that it
+ * can be done from a worker thread.
+ *
+ * @param  szWikiPath Path to the root of the Uki wiki.
+ * @param  lpnError   Engine error code or UKI_OK if the path couldn't be
+ *                    converted to ASCII.
+ * @return            TRUE if everything went fine.
+ */
+BOOL InitializeUkiEngine(LPCTSTR szWikiPath, int *lpnError) {
+	char szaPath[UKI_MAX_PATH];
+
 	// Convert Unicode string to ASCII.
-	if (ConvertStringWtoA(szaPath, szWikiPath)) {
-		// Save our current wiki path.
-		wcscpy(szCurrentWikiRoot, szWikiPath);
+	*lpnError = UKI_OK;
+	if (!ConvertStringWtoA(szaPath, szWikiPath, UKI_MAX_PATH))
+		return FALSE;
 
-		// Initialize the engine.
-		if ((err = uki_initialize(szaPath)) != UKI_OK) {
-			ShowUkiErrorDialog(err);
-			CloseUki();
+	// Save our current wiki path.
+	wcscpy(szCurrentWikiRoot, szWikiPath);
+
+	// Initialize the engine.
+	if ((*lpnError = uki_initialize(szaPath)) != UKI_OK) {
+		CloseUki();
+		return FALSE;
+	}
 
+	// Don't let an interrupted save leave a page missing or show up as one.
+	// That's rare enough that starting the engine over beats looking for the
+	// leftovers before the engine tells us where its folders are.
+	if (RecoverWorkspaceWrites()) {
+		CloseUki();
+		if ((*lpnError = uki_initialize(szaPath)) != UKI_OK) {
+			CloseUki();
 			return FALSE;
 		}
-	} else {
-		MessageBox(NULL, L"Failed to convert the wiki path from ASCII to Unicode",
-			L"Conversion Error", MB_OK | MB_ICONERROR);
-		return FALSE;
 	}
 
+	// Remember which manifest the variables came from.
+	if (!GetManifestModifiedTime(&ftManifest)) {
+		ftManifest.dwLowDateTime = 0;
+		ftManifest.dwHighDateTime = 0;
+	}
+
+	// Keep the wide forms of the page strings around.
+	BuildUkiStrings();
+
+	// Get a snapshot of the workspace to make refreshes incremental.
+	LoadWorkspaceSnapshots();
+
 	return TRUE;
 }
 
+/**
+ * Cleans up after saves that were interrupted in the articles and templates
+ * folders of the workspace.
+ *
+ * @return TRUE if anything was left behind, so the engine may have seen it.
+ */
+BOOL RecoverWorkspaceWrites() {
+	LPCTSTR szFolder;
+	UINT uFound;
+
+	uFound = 0;
+	if ((szFolder = GetUkiArticlesFolder()) != NULL)
+		uFound += RecoverInterruptedWrites(szFolder);
+	if ((szFolder = GetUkiTemplatesFolder()) != NULL)
+		uFound += RecoverInterruptedWrites(szFolder);
+
+	return uFound > 0;
+}
+
 /**
  * Saves a Uki article to its file.
  *
@@ -53,6 +150,7 @@ BOOL InitializeUki(LPCTSTR szWikiPath) {
  */
 BOOL SaveUkiArticle(const UKIARTICLE ukiArticle, LPCTSTR szContents) {
 	TCHAR szPath[UKI_MAX_PATH];
+	LONG nArticle;
 
 	// Get the article path.
 	if (!GetUkiArticlePath(szPath, ukiArticle)) {
@@ -62,7 +160,16 @@ BOOL SaveUkiArticle(const UKIARTICLE ukiArticle, LPCTSTR szContents) {
 	}
 
 	// Write the contents to the file.
-	return SaveFileContents(szPath, szContents);
+	if (!SaveFileContents(szPath, szContents))
+		return FALSE;
+
+	// Keep the search and dependency indices up to date.
+	nArticle = GetUkiArticleIndex(ukiArticle);
+	UpdateWorkspaceSearch(TXTIDX_ARTICLE, nArticle, szContents);
+	if (IsDependencyIndexReady())
+		UpdateArticleDependencies(nArticle);
+
+	return TRUE;
 }
 
 /**
@@ -74,6 +181,7 @@ BOOL SaveUkiArticle(const UKIARTICLE ukiArticle, LPCTSTR szContents) {
  */
 BOOL SaveUkiTemplate(const UKITEMPLATE ukiTemplate, LPCTSTR szContents) {
 	TCHAR szPath[UKI_MAX_PATH];
+	LONG nTemplate;
 
 	// Get the template path.
 	if (!GetUkiTemplatePath(szPath, ukiTemplate)) {
@@ -83,7 +191,63 @@ BOOL SaveUkiTemplate(const UKITEMPLATE ukiTemplate, LPCTSTR szContents) {
 	}
 
 	// Write the contents to the file.
-	return SaveFileContents(szPath, szContents);
+	if (!SaveFileContents(szPath, szContents))
+		return FALSE;
+
+	// Only the articles that use this template need to be rendered again,
+	// unless we don't know which ones they are yet.
+	nTemplate = GetUkiTemplateIndex(ukiTemplate);
+	if (!InvalidateTemplateDependents(nTemplate))
+		dwRenderGeneration++;
+
+	// Keep the search and dependency indices up to date.
+	UpdateWorkspaceSearch(TXTIDX_TEMPLATE, nTemplate, szContents);
+	if (IsDependencyIndexReady())
+		UpdateTemplateDependencies(nTemplate);
+
+	return TRUE;
+}
+
+/**
+ * Renders an article with its templates.
+ * @remark Remember to free the HTML buffer with LocalFree.
+ *
+ * @param  ukiArticle Uki article to be rendered.
+ * @param  szHTML     Rendered HTML buffer. Allocated by this function.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL RenderUkiArticle(const UKIARTICLE ukiArticle, LPTSTR *szHTML) {
+	char *szaRendered;
+	int nLen;
+
+	// Render the page.
+	if (uki_render_page(&szaRendered, ukiArticle.path) != UKI_OK)
+		return FALSE;
+
+	// Convert it to Unicode.
+	nLen = ConvertBufferAtoW(NULL, 0, szaRendered, -1);
+	*szHTML = (LPTSTR)LocalAlloc(LMEM_FIXED, nLen * sizeof(TCHAR));
+	if ((nLen == 0) || (*szHTML == NULL)) {
+		if (*szHTML != NULL)
+			LocalFree(*szHTML);
+		free(szaRendered);
+
+		return FALSE;
+	}
+	ConvertBufferAtoW(*szHTML, nLen, szaRendered, -1);
+
+	free(szaRendered);
+	return TRUE;
+}
+
+/**
+ * Gets the current render generation. It changes whenever something that
+ * affects every rendered page, like a template, changes.
+ *
+ * @return Current render generation.
+ */
+DWORD GetUkiRenderGeneration() {
+	return dwRenderGeneration;
 }
 
 /**
@@ -136,8 +300,17 @@ BOOL GetUkiRootFromManifest(LPTSTR szWikiRoot, LPCTSTR szManifestPath) {
  */
 BOOL GetUkiArticlePath(LPTSTR szArticlePath, const UKIARTICLE ukiArticle) {
 	char szaPath[UKI_MAX_PATH];
+	LPCTSTR szPath;
 	int err;
 
+	// Use the interned path if we have it.
+	szPath = StringTableGetPath(&stArticles,
+		StringTableFind(&stArticles, ukiArticle.path));
+	if (szPath != NULL) {
+		wcscpy(szArticlePath, szPath);
+		return TRUE;
+	}
+
 	// Get the file path.
 	if ((err = uki_article_fpath(szaPath, ukiArticle)) != UKI_OK) {
 		ShowUkiErrorDialog(err);
@@ -162,8 +335,17 @@ BOOL GetUkiArticlePath(LPTSTR szArticlePath, const UKIARTICLE ukiArticle) {
  */
 BOOL GetUkiTemplatePath(LPTSTR szTemplatePath, const UKITEMPLATE ukiTemplate) {
 	char szaPath[UKI_MAX_PATH];
+	LPCTSTR szPath;
 	int err;
 
+	// Use the interned path if we have it.
+	szPath = StringTableGetPath(&stTemplates,
+		StringTableFind(&stTemplates, ukiTemplate.path));
+	if (szPath != NULL) {
+		wcscpy(szTemplatePath, szPath);
+		return TRUE;
+	}
+
 	// Get the file path.
 	if ((err = uki_template_fpath(szaPath, ukiTemplate)) != UKI_OK) {
 		ShowUkiErrorDialog(err);
@@ -231,14 +413,18 @@ LONG AddUkiArticle(LPCTSTR szFilePath) {
 	char szaPath[UKI_MAX_PATH];
 
 	// Convert Unicode string to ASCII.
-	if (!ConvertStringWtoA(szaPath, szFilePath)) {
+	if (!ConvertStringWtoA(szaPath, szFilePath, UKI_MAX_PATH)) {
 		MessageBox(NULL, L"Failed to convert the article path from Unicode "
 			L"to ASCII", L"Conversion Error", MB_OK | MB_ICONERROR);
 		return -1L;
 	}
 
-	// Add article and return its index.
+	// Add article and index its contents.
 	uki_add_article(szaPath);
+	InternUkiArticle(GetUkiArticlesAvailable() - 1);
+	IndexWorkspacePage(TXTIDX_ARTICLE, GetUkiArticlesAvailable() - 1,
+		szFilePath);
+
 	return GetUkiArticlesAvailable() - 1;
 }
 
@@ -252,17 +438,209 @@ LONG AddUkiTemplate(LPCTSTR szFilePath) {
 	char szaPath[UKI_MAX_PATH];
 
 	// Convert Unicode string to ASCII.
-	if (!ConvertStringWtoA(szaPath, szFilePath)) {
+	if (!ConvertStringWtoA(szaPath, szFilePath, UKI_MAX_PATH)) {
 		MessageBox(NULL, L"Failed to convert the template path from Unicode "
 			L"to ASCII", L"Conversion Error", MB_OK | MB_ICONERROR);
 		return -1L;
 	}
 
-	// Add template and return its index.
+	// Add template and index its contents.
 	uki_add_template(szaPath);
+	InternUkiTemplate(GetUkiTemplatesAvailable() - 1);
+	IndexWorkspacePage(TXTIDX_TEMPLATE, GetUkiTemplatesAvailable() - 1,
+		szFilePath);
+
 	return GetUkiTemplatesAvailable() - 1;
 }
 
+/**
+ * Finds the index of an article in the engine.
+ *
+ * @param  ukiArticle Uki article structure.
+ * @return            Index of the article or -1 if it wasn't found.
+ */
+LONG GetUkiArticleIndex(const UKIARTICLE ukiArticle) {
+	UKIARTICLE ukiCurrent;
+	LONG nArticles;
+	LONG iArticle;
+
+	// The engine hands out the same strings for the same article.
+	iArticle = StringTableFind(&stArticles, ukiArticle.path);
+	if (iArticle >= 0L)
+		return iArticle;
+	nArticles = GetUkiArticlesAvailable();
+	for (iArticle = 0L; iArticle < nArticles; iArticle++) {
+		ukiCurrent = uki_article((size_t)iArticle);
+		if (ukiCurrent.path == ukiArticle.path)
+			return iArticle;
+	}
+
+	return -1L;
+}
+
+/**
+ * Finds the index of a template in the engine.
+ *
+ * @param  ukiTemplate Uki template structure.
+ * @return             Index of the template or -1 if it wasn't found.
+ */
+LONG GetUkiTemplateIndex(const UKITEMPLATE ukiTemplate) {
+	UKITEMPLATE ukiCurrent;
+	LONG nTemplates;
+	LONG iTemplate;
+
+	// The engine hands out the same strings for the same template.
+	iTemplate = StringTableFind(&stTemplates, ukiTemplate.path);
+	if (iTemplate >= 0L)
+		return iTemplate;
+	nTemplates = GetUkiTemplatesAvailable();
+	for (iTemplate = 0L; iTemplate < nTemplates; iTemplate++) {
+		ukiCurrent = uki_template((size_t)iTemplate);
+		if (ukiCurrent.path == ukiTemplate.path)
+			return iTemplate;
+	}
+
+	return -1L;
+}
+
+/**
+ * Interns the wide forms of the strings of every page in the engine.
+ */
+void BuildUkiStrings() {
+	LONG nPages;
+	LONG iPage;
+
+	// Start from scratch.
+	StringTableFree(&stArticles);
+	StringTableFree(&stTemplates);
+	StringPoolFree(&spStrings);
+
+	// Go through the pages.
+	nPages = GetUkiArticlesAvailable();
+	for (iPage = 0L; iPage < nPages; iPage++)
+		InternUkiArticle(iPage);
+	nPages = GetUkiTemplatesAvailable();
+	for (iPage = 0L; iPage < nPages; iPage++)
+		InternUkiTemplate(iPage);
+}
+
+/**
+ * Interns the wide forms of the strings of an article.
+ *
+ * @param  nIndex Index of the article. Must be the next one in the table.
+ * @return        TRUE if the article was added to the table.
+ */
+BOOL InternUkiArticle(LONG nIndex) {
+	char szaPath[UKI_MAX_PATH];
+	UKIARTICLE ukiArticle;
+
+	// Keep the table in step with the engine.
+	if (stArticles.nEntries != nIndex)
+		return FALSE;
+	if (!GetUkiArticle(&ukiArticle, (size_t)nIndex))
+		return FALSE;
+
+	// Get the file path and intern everything.
+	if (uki_article_fpath(szaPath, ukiArticle) != UKI_OK)
+		return FALSE;
+	return StringTableAdd(&stArticles, &spStrings, ukiArticle.path,
+		ukiArticle.name, ukiArticle.parent, szaPath) >= 0L;
+}
+
+/**
+ * Interns the wide forms of the strings of a template.
+ *
+ * @param  nIndex Index of the template. Must be the next one in the table.
+ * @return        TRUE if the template was added to the table.
+ */
+BOOL InternUkiTemplate(LONG nIndex) {
+	char szaPath[UKI_MAX_PATH];
+	UKITEMPLATE ukiTemplate;
+
+	// Keep the table in step with the engine.
+	if (stTemplates.nEntries != nIndex)
+		return FALSE;
+	if (!GetUkiTemplate(&ukiTemplate, (size_t)nIndex))
+		return FALSE;
+
+	// Get the file path and intern everything.
+	if (uki_template_fpath(szaPath, ukiTemplate) != UKI_OK)
+		return FALSE;
+	return StringTableAdd(&stTemplates, &spStrings, ukiTemplate.path,
+		ukiTemplate.name, ukiTemplate.parent, szaPath) >= 0L;
+}
+
+/**
+ * Gets the name of an article without any conversions.
+ *
+ * @param  nIndex Index of the article.
+ * @return        Interned name or NULL if it isn't available.
+ */
+LPCTSTR GetUkiArticleName(LONG nIndex) {
+	return StringTableGetName(&stArticles, nIndex);
+}
+
+/**
+ * Gets the parent folder of an article without any conversions.
+ *
+ * @param  nIndex Index of the article.
+ * @return        Interned parent or NULL if it isn't available.
+ */
+LPCTSTR GetUkiArticleParent(LONG nIndex) {
+	return StringTableGetParent(&stArticles, nIndex);
+}
+
+/**
+ * Finds a page by its file path among the interned strings, for when all we
+ * have is what's on disk.
+ *
+ * @param  lpTable Interned strings of the articles or templates.
+ * @param  szPath  Full path to the page file.
+ * @return         Index of the page or -1 if it wasn't found.
+ */
+LONG FindInternedPath(const STRINGTABLE *lpTable, LPCTSTR szPath) {
+	LPCTSTR szEntryPath;
+	LONG iEntry;
+
+	for (iEntry = 0L; iEntry < lpTable->nEntries; iEntry++) {
+		szEntryPath = StringTableGetPath(lpTable, iEntry);
+		if ((szEntryPath != NULL) && (_wcsicmp(szEntryPath, szPath) == 0))
+			return iEntry;
+	}
+
+	return -1L;
+}
+
+/**
+ * Gets the file path of an article without any conversions.
+ *
+ * @param  nIndex Index of the article.
+ * @return        Interned path or NULL if it isn't available.
+ */
+LPCTSTR GetUkiArticleFilePath(LONG nIndex) {
+	return StringTableGetPath(&stArticles, nIndex);
+}
+
+/**
+ * Gets the name of a template without any conversions.
+ *
+ * @param  nIndex Index of the template.
+ * @return        Interned name or NULL if it isn't available.
+ */
+LPCTSTR GetUkiTemplateName(LONG nIndex) {
+	return StringTableGetName(&stTemplates, nIndex);
+}
+
+/**
+ * Gets the file path of a template without any conversions.
+ *
+ * @param  nIndex Index of the template.
+ * @return        Interned path or NULL if it isn't available.
+ */
+LPCTSTR GetUkiTemplateFilePath(LONG nIndex) {
+	return StringTableGetPath(&stTemplates, nIndex);
+}
+
 /**
  * Gets the currently open Uki workspace path.
  *
@@ -280,12 +658,17 @@ LPTSTR GetCurrentWorkspace() {
 LPCTSTR GetUkiArticlesFolder() {
 	char szaPath[UKI_MAX_PATH];
 
+	// The folder doesn't change while the workspace is open.
+	if (szArticlesFolder[0] != L'\0')
+		return szArticlesFolder;
+
 	// Get the folder path.
 	if (uki_folder_articles(szaPath) != UKI_OK)
 		return NULL;
 
 	// Convert ASCII string to Unicode.
 	if (!ConvertStringAtoW(szArticlesFolder, szaPath)) {
+		szArticlesFolder[0] = L'\0';
 		MessageBox(NULL, L"Failed to convert the articles folder path from "
 			L"ASCII to Unicode", L"Conversion Error", MB_OK | MB_ICONERROR);
 		return NULL;
@@ -302,12 +685,17 @@ LPCTSTR GetUkiArticlesFolder() {
 LPCTSTR GetUkiTemplatesFolder() {
 	char szaPath[UKI_MAX_PATH];
 
+	// The folder doesn't change while the workspace is open.
+	if (szTemplatesFolder[0] != L'\0')
+		return szTemplatesFolder;
+
 	// Get the folder path.
 	if (uki_folder_templates(szaPath) != UKI_OK)
 		return NULL;
 
 	// Convert ASCII string to Unicode.
 	if (!ConvertStringAtoW(szTemplatesFolder, szaPath)) {
+		szTemplatesFolder[0] = L'\0';
 		MessageBox(NULL, L"Failed to convert the templates folder path from "
 			L"ASCII to Unicode", L"Conversion Error", MB_OK | MB_ICONERROR);
 		return NULL;
@@ -329,10 +717,303 @@ BOOL ReloadUki() {
 	return InitializeUki(szCurrentWikiRoot);
 }
 
+/**
+ * Refreshes the workspace by applying only what changed on disk since it was
+ * loaded or last refreshed.
+ * @remark The engine can't forget pages, so if anything was removed nothing is
+ *         applied and the caller should fall back to ReloadUki. The same goes
+ *         for when the manifest was edited, since the engine only reads the
+ *         variables from it when it starts. It also goes for when this fails,
+ *         since some of the pages may have been added, and every refresh
+ *         after that fails too until the workspace is loaded again.
+ *
+ * @param  lpRefresh Summary of the changes found and applied.
+ * @return           TRUE if the operation was successful.
+ */
+BOOL RefreshUki(UKIREFRESH *lpRefresh) {
+	TCHAR szIndexPath[UKI_MAX_PATH];
+	FOLDERSNAPSHOT fsNewArticles;
+	FOLDERSNAPSHOT fsNewTemplates;
+	FILETIME ftModified;
+	BOOL bSuccess;
+
+	// Set the defaults.
+	lpRefresh->nFirstNewArticle = GetUkiArticlesAvailable();
+	lpRefresh->nFirstNewTemplate = GetUkiTemplatesAvailable();
+	lpRefresh->nAdded = 0L;
+	lpRefresh->nRemoved = 0L;
+	lpRefresh->nChanged = 0L;
+	lpRefresh->fManifestChanged = FALSE;
+
+	// Pages added by a refresh that failed aren't in our reference snapshots,
+	// so going again would add them twice.
+	if (fRefreshBroken)
+		return FALSE;
+
+	// Any variable may have changed, which only a full reload picks up.
+	if (!GetManifestModifiedTime(&ftModified) ||
+			(CompareFileTime(&ftModified, &ftManifest) != 0)) {
+		lpRefresh->fManifestChanged = TRUE;
+		return TRUE;
+	}
+
+	// Take a snapshot of how things are right now.
+	InitializeFolderSnapshot(&fsNewArticles);
+	InitializeFolderSnapshot(&fsNewTemplates);
+	if (!TakeWorkspaceSnapshots(&fsNewArticles, &fsNewTemplates))
+		return FALSE;
+
+	// Check what changed.
+	DiffFolderSnapshots(&fsArticles, &fsNewArticles, CountSnapshotChange,
+		(LPARAM)lpRefresh);
+	DiffFolderSnapshots(&fsTemplates, &fsNewTemplates, CountSnapshotChange,
+		(LPARAM)lpRefresh);
+
+	// Removals can only be handled by a full reload.
+	if (lpRefresh->nRemoved > 0L) {
+		FreeFolderSnapshot(&fsNewArticles);
+		FreeFolderSnapshot(&fsNewTemplates);
+
+		return TRUE;
+	}
+
+	// Add the new pages to the engine.
+	bSuccess = DiffFolderSnapshots(&fsArticles, &fsNewArticles,
+		ApplyArticleChange, (LPARAM)lpRefresh);
+	if (bSuccess) {
+		bSuccess = DiffFolderSnapshots(&fsTemplates, &fsNewTemplates,
+			ApplyTemplateChange, (LPARAM)lpRefresh);
+	}
+
+	// A page that couldn't be added would never be tried again if the new
+	// snapshots became our reference, and the ones that made it would be added
+	// again if the old ones stayed. Only a full reload gets us back in step.
+	if (!bSuccess) {
+		FreeFolderSnapshot(&fsNewArticles);
+		FreeFolderSnapshot(&fsNewTemplates);
+		fRefreshBroken = TRUE;
+
+		return FALSE;
+	}
+
+	// The new snapshots are now our reference.
+	FreeFolderSnapshot(&fsArticles);
+	FreeFolderSnapshot(&fsTemplates);
+	fsArticles = fsNewArticles;
+	fsTemplates = fsNewTemplates;
+
+	// Nothing uses the mapped index anymore, so we can update it.
+	CloseWorkspaceIndex(&wiIndex);
+	GetWorkspaceIndexPath(szIndexPath);
+	SaveWorkspaceIndex(szIndexPath, &fsArticles, &fsTemplates);
+
+	return TRUE;
+}
+
+/**
+ * Gets the workspace snapshots from the index file if it's still current,
+ * otherwise walks the workspace folders and saves a new index.
+ *
+ * @return TRUE if we have the snapshots.
+ */
+BOOL LoadWorkspaceSnapshots() {
+	TCHAR szIndexPath[UKI_MAX_PATH];
+	LPCTSTR szArticles;
+	LPCTSTR szTemplates;
+
+	// Get the folders.
+	GetWorkspaceIndexPath(szIndexPath);
+	szArticles = GetUkiArticlesFolder();
+	szTemplates = GetUkiTemplatesFolder();
+	if ((szArticles == NULL) || (szTemplates == NULL))
+		return FALSE;
+
+	// Try to use the index.
+	if (OpenWorkspaceIndex(&wiIndex, szIndexPath, &fsArticles,
+			&fsTemplates)) {
+		if (IsFolderSnapshotCurrent(&fsArticles, szArticles) &&
+			IsFolderSnapshotCurrent(&fsTemplates, szTemplates)) {
+			return TRUE;
+		}
+
+		// The index is stale.
+		FreeFolderSnapshot(&fsArticles);
+		FreeFolderSnapshot(&fsTemplates);
+		CloseWorkspaceIndex(&wiIndex);
+	}
+
+	// Walk the folders and save a fresh index.
+	if (!TakeWorkspaceSnapshots(&fsArticles, &fsTemplates))
+		return FALSE;
+	SaveWorkspaceIndex(szIndexPath, &fsArticles, &fsTemplates);
+
+	return TRUE;
+}
+
+/**
+ * Builds the path to the workspace index file.
+ *
+ * @param szIndexPath Pre-allocated buffer to receive the index path.
+ */
+void GetWorkspaceIndexPath(LPTSTR szIndexPath) {
+	size_t nLen;
+
+	// The index lives next to the manifest in the workspace root.
+	wcscpy(szIndexPath, szCurrentWikiRoot);
+	nLen = wcslen(szIndexPath);
+	if ((nLen > 0) && (szIndexPath[nLen - 1] != L'\\'))
+		wcscat(szIndexPath, L"\\");
+	wcscat(szIndexPath, WORKSPACE_INDEX_FILE);
+}
+
+/**
+ * Gets the last time the workspace manifest was modified.
+ *
+ * @param  lpftModified Receives the modification time.
+ * @return              TRUE if the manifest could be found.
+ */
+BOOL GetManifestModifiedTime(FILETIME *lpftModified) {
+	TCHAR szManifestPath[UKI_MAX_PATH];
+	size_t nLen;
+
+	// The manifest marks the workspace root.
+	wcscpy(szManifestPath, szCurrentWikiRoot);
+	nLen = wcslen(szManifestPath);
+	if ((nLen > 0) && (szManifestPath[nLen - 1] != L'\\'))
+		wcscat(szManifestPath, L"\\");
+	wcscat(szManifestPath, UKI_MANIFEST_FILE);
+
+	return GetFileModifiedTime(szManifestPath, lpftModified);
+}
+
+/**
+ * Takes snapshots of the articles and templates folders.
+ *
+ * @param  lpArticles  Initialized snapshot for the articles folder.
+ * @param  lpTemplates Initialized snapshot for the templates folder.
+ * @return             TRUE if the operation was successful.
+ */
+BOOL TakeWorkspaceSnapshots(FOLDERSNAPSHOT *lpArticles,
+							FOLDERSNAPSHOT *lpTemplates) {
+	LPCTSTR szFolder;
+
+	// Articles folder.
+	szFolder = GetUkiArticlesFolder();
+	if ((szFolder == NULL) || !SnapshotFolder(lpArticles, szFolder))
+		return FALSE;
+
+	// Templates folder.
+	szFolder = GetUkiTemplatesFolder();
+	if ((szFolder == NULL) || !SnapshotFolder(lpTemplates, szFolder)) {
+		FreeFolderSnapshot(lpArticles);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Counts the changes found between workspace snapshots.
+ *
+ * @param  uChange Type of change.
+ * @param  lpEntry File that changed.
+ * @param  lParam  Pointer to the UKIREFRESH structure.
+ * @return         Always TRUE.
+ */
+BOOL CountSnapshotChange(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+						 LPARAM lParam) {
+	UKIREFRESH *lpRefresh = (UKIREFRESH*)lParam;
+
+	switch (uChange) {
+	case SNAPSHOT_ADDED:
+		lpRefresh->nAdded++;
+		break;
+	case SNAPSHOT_REMOVED:
+		lpRefresh->nRemoved++;
+		break;
+	case SNAPSHOT_CHANGED:
+		lpRefresh->nChanged++;
+		break;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Applies an article change found between workspace snapshots.
+ *
+ * @param  uChange Type of change.
+ * @param  lpEntry File that changed.
+ * @param  lParam  Pointer to the UKIREFRESH structure.
+ * @return         FALSE if we should stop applying changes.
+ */
+BOOL ApplyArticleChange(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+						LPARAM lParam) {
+	LONG nArticle;
+
+	if (uChange == SNAPSHOT_ADDED)
+		return AddUkiArticle(lpEntry->szPath) >= 0L;
+
+	// Someone else edited it, so the indices must learn its new contents.
+	if (uChange == SNAPSHOT_CHANGED) {
+		nArticle = FindInternedPath(&stArticles, lpEntry->szPath);
+		if (nArticle >= 0L) {
+			IndexWorkspacePage(TXTIDX_ARTICLE, nArticle, lpEntry->szPath);
+			if (IsDependencyIndexReady())
+				UpdateArticleDependencies(nArticle);
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Applies a template change found between workspace snapshots.
+ *
+ * @param  uChange Type of change.
+ * @param  lpEntry File that changed.
+ * @param  lParam  Pointer to the UKIREFRESH structure.
+ * @return         FALSE if we should stop applying changes.
+ */
+BOOL ApplyTemplateChange(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+						 LPARAM lParam) {
+	LONG nTemplate;
+
+	if (uChange == SNAPSHOT_ADDED)
+		return AddUkiTemplate(lpEntry->szPath) >= 0L;
+
+	// Every rendered page may have used this template if we can't tell which.
+	nTemplate = FindInternedPath(&stTemplates, lpEntry->szPath);
+	if (!InvalidateTemplateDependents(nTemplate))
+		dwRenderGeneration++;
+
+	// Someone else edited it, so the indices must learn its new contents.
+	if ((uChange == SNAPSHOT_CHANGED) && (nTemplate >= 0L)) {
+		IndexWorkspacePage(TXTIDX_TEMPLATE, nTemplate, lpEntry->szPath);
+		if (IsDependencyIndexReady())
+			UpdateTemplateDependencies(nTemplate);
+	}
+
+	return TRUE;
+}
+
 /**
  * Cleans our mess.
  */
 void CloseUki() {
+	dwRenderGeneration++;
+	fRefreshBroken = FALSE;
+	FreeFolderSnapshot(&fsArticles);
+	FreeFolderSnapshot(&fsTemplates);
+	CloseWorkspaceIndex(&wiIndex);
+
+	// Free all of the interned strings at once.
+	StringTableFree(&stArticles);
+	StringTableFree(&stTemplates);
+	StringPoolFree(&spStrings);
+	szArticlesFolder[0] = L'\0';
+	szTemplatesFolder[0] = L'\0';
+
 	uki_clean();
 }
 
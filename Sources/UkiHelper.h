@@ -15,6 +15,19 @@
 #define UKITEMPLATE uki_template_t
 #define UKIARTICLE  uki_article_t
 
+// Name of the manifest file in the workspace root.
+#define UKI_MANIFEST_FILE L"MANIFEST.uki"
+
+// Summary of the changes applied by a workspace refresh.
+typedef struct {
+	LONG nFirstNewArticle;
+	LONG nFirstNewTemplate;
+	LONG nAdded;
+	LONG nRemoved;
+	LONG nChanged;
+	BOOL fManifestChanged;
+} UKIREFRESH;
+
 // Messages.
 void ShowUkiErrorDialog(int nErrorCode);
 
@@ -24,7 +37,9 @@ BOOL GetUkiRootFromManifest(LPTSTR szWikiRoot, LPCTSTR szManifestPath);
 // Initialization and destruction.
 void CloseUki();
 BOOL InitializeUki(LPCTSTR szWikiPath);
+BOOL InitializeUkiEngine(LPCTSTR szWikiPath, int *lpnError);
 BOOL ReloadUki();
+BOOL RefreshUki(UKIREFRESH *lpRefresh);
 
 // Lookup.
 LPTSTR GetCurrentWorkspace();
@@ -32,9 +47,18 @@ LONG GetUkiArticlesAvailable();
 LONG GetUkiTemplatesAvailable();
 BOOL GetUkiTemplate(UKITEMPLATE *ukiTemplate, size_t nIndex);
 BOOL GetUkiArticle(UKIARTICLE *ukiArticle, size_t nIndex);
+LONG GetUkiArticleIndex(const UKIARTICLE ukiArticle);
+LONG GetUkiTemplateIndex(const UKITEMPLATE ukiTemplate);
 BOOL GetUkiArticlePath(LPTSTR szArticlePath, const UKIARTICLE ukiArticle);
 BOOL GetUkiTemplatePath(LPTSTR szTemplatePath, const UKITEMPLATE ukiTemplate);
 
+// Interned strings.
+LPCTSTR GetUkiArticleName(LONG nIndex);
+LPCTSTR GetUkiArticleParent(LONG nIndex);
+LPCTSTR GetUkiArticleFilePath(LONG nIndex);
+LPCTSTR GetUkiTemplateName(LONG nIndex);
+LPCTSTR GetUkiTemplateFilePath(LONG nIndex);
+
 // Paths.
 LPCTSTR GetUkiArticlesFolder();
 LPCTSTR GetUkiTemplatesFolder();
@@ -43,6 +67,10 @@ LPCTSTR GetUkiTemplatesFolder();
 LONG AddUkiArticle(LPCTSTR szFilePath);
 LONG AddUkiTemplate(LPCTSTR szFilePath);
 
+// Rendering.
+BOOL RenderUkiArticle(const UKIARTICLE ukiArticle, LPTSTR *szHTML);
+DWORD GetUkiRenderGeneration();
+
 // Saving.
 BOOL SaveUkiArticle(const UKIARTICLE ukiArticle, LPCTSTR szContents);
 BOOL SaveUkiTemplate(const UKITEMPLATE ukiTemplate, LPCTSTR szContents);
@@ -6,8 +6,22 @@
  */
 
 #include "Utilities.h"
+#include "ContentHash.h"
+#include "FileMap.h"
+#include "Transcode.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Most bytes a single UTF-16 character can take in the text code page.
+#define MAX_CHAR_BYTES 3
+
+// Private methods.
+DWORD GetSplitCharacterLength(const char *szaBuffer, DWORD cbBuffer);
+BOOL BuildSiblingPath(LPTSTR szSibling, LPCTSTR szPath, LPCTSTR szSuffix);
+HANDLE CreateTempFile(LPCTSTR szPath, LPTSTR szTempPath);
+BOOL CommitTempFile(LPCTSTR szTempPath, LPCTSTR szPath);
+void RecoverLeftoverFile(LPCTSTR szPath);
 
 /**
  * Slurps a file and stores its contents inside a buffer.
@@ -19,105 +33,506 @@
  * @return                TRUE if the operation was successful.
  */
 BOOL ReadFileContents(LPCTSTR szPath, LPTSTR *szFileContents) {
-	DWORD dwFileSize;
-	DWORD dwBytesRead;
-	HANDLE hFile;
-	BOOL bSuccess = TRUE;
-	char *szaBuffer;
-	
-	// Open the file.
-	hFile = CreateFile(szPath, GENERIC_READ, FILE_SHARE_READ, NULL,
-		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-	if (hFile == INVALID_HANDLE_VALUE) {
+	DWORD cchText;
+
+	if (!ReadFileText(szPath, szFileContents, &cchText)) {
 		// TODO: Use GetLastError.
-		MessageBox(NULL, L"Couldn't open file to read contents.",
+		MessageBox(NULL, L"Couldn't read the contents of the file.",
 			L"Read File Error", MB_OK | MB_ICONERROR);
 		return FALSE;
 	}
 
-	// Get file size to use to read the whole thing in one go.
-	dwFileSize = GetFileSize(hFile, NULL);
-	
-	// Allocate the memory for the file contents.
-	*szFileContents = (LPTSTR)LocalAlloc(LMEM_FIXED, (dwFileSize + 1) *
-		sizeof(TCHAR));
-	szaBuffer = (char*)LocalAlloc(LMEM_FIXED, (dwFileSize + 1) * sizeof(char));
-	
-	// Read the file into the buffer.
-	if (!ReadFile(hFile, szaBuffer, dwFileSize, &dwBytesRead, NULL)) {
+	return TRUE;
+}
+
+/**
+ * Reads the whole text of a file without showing any messages, so it's safe
+ * to call from any thread. Large files are mapped and converted straight from
+ * the mapping, so their raw contents never need a buffer of their own.
+ * @remark Remember to free the text with LocalFree.
+ *
+ * @param  szPath    Path to the file to be read.
+ * @param  lpszText  Pointer to receive the NULL terminated text.
+ * @param  lpcchText Pointer to receive the length of the text.
+ * @return           TRUE if the operation was successful.
+ */
+BOOL ReadFileText(LPCTSTR szPath, LPTSTR *lpszText, DWORD *lpcchText) {
+	FILEMAP fmFile;
+	int cchText;
+
+	// Get a view of the raw file.
+	if (!FileMapOpen(&fmFile, szPath, FILEMAP_MIN_MAPPED))
+		return FALSE;
+
+	// Convert it to Unicode.
+	cchText = 0;
+	if (fmFile.cbData > 0) {
+		cchText = ConvertBufferAtoW(NULL, 0, fmFile.lpData, (int)fmFile.cbData);
+		if (cchText == 0) {
+			FileMapClose(&fmFile);
+			return FALSE;
+		}
+	}
+	*lpszText = (LPTSTR)LocalAlloc(LMEM_FIXED, (cchText + 1) * sizeof(TCHAR));
+	if (*lpszText == NULL) {
+		FileMapClose(&fmFile);
+		return FALSE;
+	}
+	if ((cchText > 0) && (ConvertBufferAtoW(*lpszText, cchText, fmFile.lpData,
+			(int)fmFile.cbData) != cchText)) {
+		LocalFree(*lpszText);
+		FileMapClose(&fmFile);
+		return FALSE;
+	}
+	(*lpszText)[cchText] = L'\0';
+	*lpcchText = (DWORD)cchText;
+
+	FileMapClose(&fmFile);
+	return TRUE;
+}
+
+/**
+ * Reads a file in fixed-size blocks, converting each one to Unicode and handing
+ * it to a callback, so that the memory used doesn't depend on the file size.
+ * Large files are converted straight from a mapping of the file.
+ *
+ * @param  szPath    Path to the file to be read.
+ * @param  lpfnChunk Function called with each converted block, which is NULL
+ *                   terminated. Returning FALSE stops the reading.
+ * @param  lParam    Parameter passed to the callback.
+ * @return           TRUE if the whole file was read.
+ */
+BOOL StreamFileContents(LPCTSTR szPath, FILECHUNKPROC lpfnChunk, LPARAM lParam) {
+	WCHAR szChunk[FILE_CHUNK_SIZE + 1];
+	FILEMAP fmFile;
+	const char *szaBlock;
+	size_t cbLeft;
+	DWORD dwConvert;
+	DWORD dwSplit;
+	int cchChunk;
+	BOOL bSuccess = TRUE;
+
+	// Get a view of the file.
+	if (!FileMapOpen(&fmFile, szPath, FILEMAP_MIN_MAPPED)) {
 		// TODO: Use GetLastError.
-		MessageBox(NULL, L"Failed to read the contents of the file.",
+		MessageBox(NULL, L"Couldn't open file to read contents.",
 			L"Read File Error", MB_OK | MB_ICONERROR);
-		bSuccess = FALSE;
+		return FALSE;
 	}
 
-	// Terminate the buffer and convert it.
-	szaBuffer[dwBytesRead] = '\0';
-	if (!ConvertStringAtoW(*szFileContents, szaBuffer)) {
-		MessageBox(NULL, L"Failed to convert file buffer from ASCII to Unicode",
-			L"Conversion Failed", MB_OK | MB_ICONERROR);
+	// Go through the file.
+	szaBlock = fmFile.lpData;
+	cbLeft = fmFile.cbData;
+	while (cbLeft > 0) {
+		// Don't split a character between blocks, unless it's too long to fit
+		// in one or the file ends in the middle of it.
+		dwConvert = (cbLeft > FILE_CHUNK_SIZE) ? FILE_CHUNK_SIZE : (DWORD)cbLeft;
+		if (dwConvert < cbLeft) {
+			dwSplit = GetSplitCharacterLength(szaBlock, dwConvert);
+			if (dwSplit < dwConvert)
+				dwConvert -= dwSplit;
+		}
 
-		LocalFree(*szFileContents);
-		bSuccess = FALSE;
+		// Convert the block.
+		cchChunk = ConvertBufferAtoW(szChunk, FILE_CHUNK_SIZE, szaBlock,
+			(int)dwConvert);
+		if (cchChunk == 0) {
+			MessageBox(NULL, L"Failed to convert file buffer from ASCII to "
+				L"Unicode", L"Conversion Failed", MB_OK | MB_ICONERROR);
+			bSuccess = FALSE;
+			break;
+		}
+		szChunk[cchChunk] = L'\0';
+
+		// Hand it over.
+		if (!lpfnChunk(szChunk, (DWORD)cchChunk, lParam)) {
+			bSuccess = FALSE;
+			break;
+		}
+
+		szaBlock += dwConvert;
+		cbLeft -= dwConvert;
 	}
-    
+
 	// Clean up.
-	CloseHandle(hFile);
-	LocalFree(szaBuffer);
+	FileMapClose(&fmFile);
 
 	return bSuccess;
 }
 
 /**
- * Save contents to a file.
+ * Save contents to a file. The contents are converted and written a chunk at
+ * a time into a temporary file, which only takes the place of the original
+ * once everything is on the disk, so a failure halfway never loses the file.
  *
  * @param  szFilePath Path to the file to be overwritten.
  * @param  szContents Contents to place inside the file.
  * @return            TRUE if the operation was successful.
  */
 BOOL SaveFileContents(LPCTSTR szFilePath, LPCTSTR szContents) {
-    HANDLE hFile;
-	DWORD dwTextLength;
+	TCHAR szTempPath[MAX_PATH];
+	HANDLE hFile;
 	DWORD dwBytesWritten;
-	char *szaBuffer;
+	char *szaChunk;
+	size_t cchLeft;
+	int cchChunk;
+	int cbChunk;
+	BOOL bSuccess;
 
-	// Get text length.
-	dwTextLength = wcslen(szContents);
+	// Allocate a buffer big enough for the conversion of any chunk.
+	szaChunk = (char*)LocalAlloc(LMEM_FIXED, FILE_CHUNK_SIZE * MAX_CHAR_BYTES);
+	if (szaChunk == NULL) {
+		MessageBox(NULL, L"Not enough memory to save the file.",
+			L"Write File Error", MB_OK | MB_ICONERROR);
+		return FALSE;
+	}
 
-	// Open file for writing.
-    hFile = CreateFile(szFilePath, GENERIC_WRITE, FILE_SHARE_WRITE, NULL,
-        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) {
+	// Open the temporary file for writing.
+	hFile = CreateTempFile(szFilePath, szTempPath);
+	if (hFile == INVALID_HANDLE_VALUE) {
 		// TODO: Use GetLastError.
 		MessageBox(NULL, L"Couldn't open file to write contents.",
 			L"Write File Error", MB_OK | MB_ICONERROR);
+
+		LocalFree(szaChunk);
 		return FALSE;
 	}
 
-	// Convert text to ASCII before writing to the file.
-	szaBuffer = (char*)LocalAlloc(LMEM_FIXED, (dwTextLength + 1) * sizeof(char));
-	if (!ConvertStringWtoA(szaBuffer, szContents)) {
-		MessageBox(NULL, L"Failed to convert contents buffer from Unicode to "
-			L"ASCII.", L"Conversion Failed", MB_OK | MB_ICONERROR);
+	// Convert and write the contents one chunk at a time.
+	bSuccess = TRUE;
+	cchLeft = wcslen(szContents);
+	while (cchLeft > 0) {
+		// Never split a surrogate pair between two chunks.
+		cchChunk = (cchLeft > FILE_CHUNK_SIZE) ? FILE_CHUNK_SIZE : (int)cchLeft;
+		if (((size_t)cchChunk < cchLeft) &&
+				(szContents[cchChunk - 1] >= 0xD800) &&
+				(szContents[cchChunk - 1] <= 0xDBFF)) {
+			cchChunk--;
+		}
 
-		CloseHandle(hFile);
-		LocalFree(szaBuffer);
-		return FALSE;
+		// Convert the chunk.
+		cbChunk = ConvertBufferWtoA(szaChunk, FILE_CHUNK_SIZE * MAX_CHAR_BYTES,
+			szContents, cchChunk);
+		if (cbChunk == 0) {
+			MessageBox(NULL, L"Failed to convert contents buffer from Unicode "
+				L"to ASCII.", L"Conversion Failed", MB_OK | MB_ICONERROR);
+			bSuccess = FALSE;
+			break;
+		}
+
+		// Write it.
+		if (!WriteFile(hFile, szaChunk, (DWORD)cbChunk, &dwBytesWritten,
+				NULL) || (dwBytesWritten != (DWORD)cbChunk)) {
+			// TODO: Use GetLastError.
+			MessageBox(NULL, L"Couldn't write contents to file.",
+				L"Write File Error", MB_OK | MB_ICONERROR);
+			bSuccess = FALSE;
+			break;
+		}
+
+		szContents += cchChunk;
+		cchLeft -= (size_t)cchChunk;
 	}
 
-	// Write to the file.
-	if (!WriteFile(hFile, szaBuffer, dwTextLength, &dwBytesWritten, NULL)) {
-		// TODO: Use GetLastError.
+	// Make sure everything is on the disk before it replaces the original.
+	if (bSuccess && !FlushFileBuffers(hFile)) {
 		MessageBox(NULL, L"Couldn't write contents to file.",
 			L"Write File Error", MB_OK | MB_ICONERROR);
+		bSuccess = FALSE;
+	}
+	CloseHandle(hFile);
+	LocalFree(szaChunk);
+
+	// Put it in place of the original.
+	if (bSuccess && !CommitTempFile(szTempPath, szFilePath)) {
+		MessageBox(NULL, L"Couldn't replace the file with the saved contents.",
+			L"Write File Error", MB_OK | MB_ICONERROR);
+		bSuccess = FALSE;
+	}
+	if (!bSuccess)
+		DeleteFile(szTempPath);
+
+	return bSuccess;
+}
+
+/**
+ * Replaces the contents of a file without ever leaving a half written file
+ * behind. The data goes to a temporary file next to the original one, which
+ * only takes its place once everything is on the disk. Doesn't show any
+ * messages, so it's safe to call from any thread.
+ *
+ * @param  szPath Path to the file to be written.
+ * @param  lpData Contents to be written.
+ * @param  cbData Size of the contents in bytes.
+ * @return        TRUE if the operation was successful.
+ */
+BOOL WriteFileAtomically(LPCTSTR szPath, const void *lpData, DWORD cbData) {
+	TCHAR szTempPath[MAX_PATH];
+	DWORD dwBytesWritten;
+	HANDLE hFile;
+	BOOL bSuccess;
+
+	// Write everything to the temporary file.
+	hFile = CreateTempFile(szPath, szTempPath);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return FALSE;
+	bSuccess = WriteFile(hFile, lpData, cbData, &dwBytesWritten, NULL) &&
+		(dwBytesWritten == cbData) && FlushFileBuffers(hFile);
+	CloseHandle(hFile);
+
+	// Put it in place of the original.
+	if (bSuccess)
+		bSuccess = CommitTempFile(szTempPath, szPath);
+	if (!bSuccess)
+		DeleteFile(szTempPath);
+
+	return bSuccess;
+}
+
+/**
+ * Gets the last time a file was modified.
+ *
+ * @param  szPath       Path to the file.
+ * @param  lpftModified Pointer to receive the modification time.
+ * @return              TRUE if the operation was successful.
+ */
+BOOL GetFileModifiedTime(LPCTSTR szPath, FILETIME *lpftModified) {
+	WIN32_FILE_ATTRIBUTE_DATA wfad;
+
+	// Get the file attributes.
+	if (!GetFileAttributesEx(szPath, GetFileExInfoStandard, &wfad))
+		return FALSE;
+
+	*lpftModified = wfad.ftLastWriteTime;
+	return TRUE;
+}
+
+/**
+ * Hashes the raw contents of a file, which is a lot cheaper than doing anything
+ * else with them and tells if they really changed when the modification time
+ * alone isn't enough. Doesn't show any messages.
+ *
+ * @param  szPath   Path to the file.
+ * @param  lpdwHash Pointer to receive the hash of the contents.
+ * @return          TRUE if the operation was successful.
+ */
+BOOL GetFileContentHash(LPCTSTR szPath, DWORD *lpdwHash) {
+	FILEMAP fmFile;
+
+	if (!FileMapOpen(&fmFile, szPath, FILEMAP_MIN_MAPPED))
+		return FALSE;
+	*lpdwHash = (DWORD)ContentHashBuffer(fmFile.lpData, fmFile.cbData);
+	FileMapClose(&fmFile);
+
+	return TRUE;
+}
+
+/**
+ * Builds the path of a file that lives next to another one.
+ *
+ * @param  szSibling Buffer with MAX_PATH characters to receive the path.
+ * @param  szPath    Path to the original file.
+ * @param  szSuffix  Suffix appended to the original path.
+ * @return           TRUE if the path fits in the buffer.
+ */
+BOOL BuildSiblingPath(LPTSTR szSibling, LPCTSTR szPath, LPCTSTR szSuffix) {
+	if ((wcslen(szPath) + wcslen(szSuffix)) >= MAX_PATH)
+		return FALSE;
+
+	wcscpy(szSibling, szPath);
+	wcscat(szSibling, szSuffix);
+
+	return TRUE;
+}
+
+/**
+ * Creates the temporary file that will later replace a file.
+ *
+ * @param  szPath     Path to the file that will be replaced.
+ * @param  szTempPath Buffer with MAX_PATH characters to receive the path of
+ *                    the temporary file.
+ * @return            Handle to the temporary file open for writing or
+ *                    INVALID_HANDLE_VALUE if it couldn't be created.
+ */
+HANDLE CreateTempFile(LPCTSTR szPath, LPTSTR szTempPath) {
+	if (!BuildSiblingPath(szTempPath, szPath, TEMP_FILE_SUFFIX))
+		return INVALID_HANDLE_VALUE;
+
+	return CreateFile(szTempPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+}
+
+/**
+ * Puts a fully written temporary file in place of the original one. Where
+ * MoveFileEx exists this is a single replacing rename. Windows CE doesn't have
+ * it, so there the original is kept aside until the rename succeeds, and
+ * RecoverInterruptedWrites puts it back if we never got that far.
+ *
+ * @param  szTempPath Path to the temporary file.
+ * @param  szPath     Path to the file to be replaced.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL CommitTempFile(LPCTSTR szTempPath, LPCTSTR szPath) {
+#ifdef UNDER_CE
+	TCHAR szBackupPath[MAX_PATH];
+	BOOL fHasBackup;
+
+	// Move the original out of the way, if there's one.
+	if (!BuildSiblingPath(szBackupPath, szPath, BACKUP_FILE_SUFFIX))
+		return FALSE;
+	DeleteFile(szBackupPath);
+	fHasBackup = MoveFile(szPath, szBackupPath);
+	if (!fHasBackup && (GetLastError() != ERROR_FILE_NOT_FOUND))
+		return FALSE;
+
+	// Put the new file in its place.
+	if (!MoveFile(szTempPath, szPath)) {
+		if (fHasBackup)
+			MoveFile(szBackupPath, szPath);
+
 		return FALSE;
 	}
-	
+
+	// The original isn't needed anymore.
+	if (fHasBackup)
+		DeleteFile(szBackupPath);
+
+	return TRUE;
+#else
+	return MoveFileEx(szTempPath, szPath,
+		MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#endif  // UNDER_CE
+}
+
+/**
+ * Cleans up after page replacements that were interrupted, by a crash or a
+ * dead battery, directly inside a folder. Sub-folders aren't looked into, so
+ * that it never costs a walk of the whole workspace on every start. On Windows
+ * CE pages that went missing are restored from their backups and every other
+ * leftover is deleted.
+ *
+ * @param  szFolder Folder to be cleaned up.
+ * @return          Number of leftover files that were dealt with.
+ */
+UINT RecoverInterruptedWrites(LPCTSTR szFolder) {
+	WIN32_FIND_DATA wfd;
+	TCHAR szPath[MAX_PATH];
+	HANDLE hFind;
+	UINT uFound;
+
+	// Build the search pattern.
+	if ((wcslen(szFolder) + 3) >= MAX_PATH)
+		return 0;
+	wsprintf(szPath, L"%s\\*", szFolder);
+
+	// Start looking for files.
+	hFind = FindFirstFile(szPath, &wfd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return 0;
+
+	uFound = 0;
+	do {
+		// Only the leftovers of our own page saves are touched.
+		if ((wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ||
+			!IsTransientFile(wfd.cFileName)) {
+			continue;
+		}
+
+		// Build the full path.
+		if ((wcslen(szFolder) + wcslen(wfd.cFileName) + 2) >= MAX_PATH)
+			continue;
+		wsprintf(szPath, L"%s\\%s", szFolder, wfd.cFileName);
+
+		RecoverLeftoverFile(szPath);
+		uFound++;
+	} while (FindNextFile(hFind, &wfd));
+
 	// Clean up.
-	CloseHandle(hFile);
-	LocalFree(szaBuffer);
+	FindClose(hFind);
+	return uFound;
+}
+
+/**
+ * Checks if a file is one of the temporary or backup files used while
+ * replacing a page, which should never be treated as a page. Backups only
+ * exist on Windows CE, so anywhere else a .bak file belongs to the user.
+ *
+ * @param  szPath Path or name of the file.
+ * @return        TRUE if it's a temporary or backup file of a page.
+ */
+BOOL IsTransientFile(LPCTSTR szPath) {
+	TCHAR szPage[MAX_PATH];
+	size_t nLen;
+
+	nLen = wcslen(szPath);
+	if ((nLen < 4) || (nLen >= MAX_PATH))
+		return FALSE;
+
+#ifdef UNDER_CE
+	if ((_wcsicmp(szPath + nLen - 4, TEMP_FILE_SUFFIX) != 0) &&
+		(_wcsicmp(szPath + nLen - 4, BACKUP_FILE_SUFFIX) != 0)) {
+		return FALSE;
+	}
+#else
+	if (_wcsicmp(szPath + nLen - 4, TEMP_FILE_SUFFIX) != 0)
+		return FALSE;
+#endif  // UNDER_CE
+
+	// It must have been a page before the suffix was added.
+	wcscpy(szPage, szPath);
+	szPage[nLen - 4] = L'\0';
+	return IsPageFile(szPage);
+}
+
+/**
+ * Checks if a file is a page, the same way the engine picks them when it scans
+ * the workspace, by its .htm or .html extension.
+ *
+ * @param  szPath Path or name of the file.
+ * @return        TRUE if the engine would load it as a page.
+ */
+BOOL IsPageFile(LPCTSTR szPath) {
+	LPCTSTR szExtension;
+
+	szExtension = wcsrchr(szPath, L'.');
+	if ((szExtension == NULL) || (wcschr(szExtension, L'\\') != NULL))
+		return FALSE;
 
-    return TRUE;
+	return (_wcsicmp(szExtension, L".htm") == 0) ||
+		(_wcsicmp(szExtension, L".html") == 0);
+}
+
+/**
+ * Deals with a single file left behind by an interrupted replacement. On
+ * Windows CE a backup whose original is missing takes its place again, since
+ * the new contents never made it. Anything else is stale and gets deleted.
+ *
+ * @param szPath Path to the temporary or backup file.
+ */
+void RecoverLeftoverFile(LPCTSTR szPath) {
+#ifdef UNDER_CE
+	TCHAR szOriginal[MAX_PATH];
+	size_t nLen;
+
+	// Temporary files are never the only copy of anything.
+	nLen = wcslen(szPath);
+	if (_wcsicmp(szPath + nLen - 4, BACKUP_FILE_SUFFIX) != 0) {
+		DeleteFile(szPath);
+		return;
+	}
+
+	// Put the backup back in place if the original is gone.
+	wcscpy(szOriginal, szPath);
+	szOriginal[nLen - 4] = L'\0';
+	if (GetFileAttributes(szOriginal) == 0xFFFFFFFF) {
+		MoveFile(szPath, szOriginal);
+	} else {
+		DeleteFile(szPath);
+	}
+#else
+	// MoveFileEx never leaves a backup behind, only temporary files.
+	DeleteFile(szPath);
+#endif  // UNDER_CE
 }
 
 /**
@@ -130,11 +545,7 @@ BOOL SaveFileContents(LPCTSTR szFilePath, LPCTSTR szContents) {
 BOOL ConvertStringAtoW(LPTSTR szUnicode, const char *szASCII) {
 	size_t nLen = strlen(szASCII) + 1;
 
-    if(MultiByteToWideChar(CP_ACP, 0, szASCII, -1, szUnicode, nLen) == 0) {
-		return FALSE;
-    }
-    
-    return TRUE;
+	return ConvertBufferAtoW(szUnicode, (int)nLen, szASCII, (int)nLen) != 0;
 }
 
 /**
@@ -142,18 +553,177 @@ BOOL ConvertStringAtoW(LPTSTR szUnicode, const char *szASCII) {
  *
  * @param  szASCII   Pre-allocated ASCII string.
  * @param  szUnicode Original Unicode string.
+ * @param  cbASCII   Size of the ASCII string buffer in bytes. Characters
+ *                   outside of ASCII may take more than one byte each.
  * @return           TRUE if the conversion was successful.
  */
-BOOL ConvertStringWtoA(char *szASCII, LPCTSTR szUnicode) {
-	size_t nLen = wcslen(szUnicode) + 1;
+BOOL ConvertStringWtoA(char *szASCII, LPCTSTR szUnicode, size_t cbASCII) {
+	return ConvertBufferWtoA(szASCII, (int)cbASCII, szUnicode, -1) != 0;
+}
+
+/**
+ * Converts a buffer in the text code page to Unicode. Works just like
+ * MultiByteToWideChar, but runs of plain ASCII skip the system conversion.
+ *
+ * @param  szUnicode  Buffer to receive the converted text or NULL.
+ * @param  cchUnicode Size of the Unicode buffer in characters or 0 to just get
+ *                    the length needed.
+ * @param  szaBuffer  Text to be converted.
+ * @param  cbBuffer   Length of the text in bytes or -1 if it's NULL terminated,
+ *                    in which case the terminator is also converted.
+ * @return            Number of characters written (or needed) or 0 in case of
+ *                    an error.
+ */
+int ConvertBufferAtoW(LPTSTR szUnicode, int cchUnicode, const char *szaBuffer,
+					  int cbBuffer) {
+	size_t nAscii;
+#if TEXT_CODEPAGE != CP_UTF8
+	int cchRest;
+#endif
 
-    if(WideCharToMultiByte(CP_ACP, 0, szUnicode, -1, szASCII, nLen,
-		NULL, NULL) == 0) {
-		DWORD err = GetLastError();
-		return FALSE;
-    }
+	// Include the terminator in the conversion if there's one.
+	if (cbBuffer < 0)
+		cbBuffer = (int)strlen(szaBuffer) + 1;
+	if (cbBuffer == 0)
+		return 0;
+
+#if TEXT_CODEPAGE == CP_UTF8
+	// Our own transcoder does it all.
+	nAscii = TranscodeUtf8Length(szaBuffer, (size_t)cbBuffer);
+	if (cchUnicode == 0)
+		return (int)nAscii;
+	if (nAscii > (size_t)cchUnicode)
+		return 0;
+
+	return (int)TranscodeUtf8ToWide((unsigned short*)szUnicode, szaBuffer,
+		(size_t)cbBuffer);
+#else
+	// Widen the ASCII text at the start ourselves.
+	nAscii = TranscodeAsciiSpan(szaBuffer, (size_t)cbBuffer);
+	if (cchUnicode > 0) {
+		if (nAscii > (size_t)cchUnicode)
+			return 0;
+
+		TranscodeAsciiToWide((unsigned short*)szUnicode, szaBuffer, nAscii);
+	}
+	if (nAscii == (size_t)cbBuffer)
+		return (int)nAscii;
+
+	// With no room left the system would just return the length needed.
+	if ((cchUnicode > 0) && (nAscii == (size_t)cchUnicode))
+		return 0;
+
+	// Leave the rest to the system.
+	if (cchUnicode > 0) {
+		cchRest = MultiByteToWideChar(TEXT_CODEPAGE, 0, szaBuffer + nAscii,
+			cbBuffer - (int)nAscii, szUnicode + nAscii,
+			cchUnicode - (int)nAscii);
+	} else {
+		cchRest = MultiByteToWideChar(TEXT_CODEPAGE, 0, szaBuffer + nAscii,
+			cbBuffer - (int)nAscii, NULL, 0);
+	}
+	if (cchRest == 0)
+		return 0;
 
-    return TRUE;
+	return (int)nAscii + cchRest;
+#endif
+}
+
+/**
+ * Converts a Unicode buffer to the text code page. Works just like
+ * WideCharToMultiByte, but runs of plain ASCII skip the system conversion.
+ *
+ * @param  szaBuffer  Buffer to receive the converted text or NULL.
+ * @param  cbBuffer   Size of the buffer in bytes or 0 to just get the length
+ *                    needed.
+ * @param  szUnicode  Text to be converted.
+ * @param  cchUnicode Length of the text in characters or -1 if it's NULL
+ *                    terminated, in which case the terminator is also
+ *                    converted.
+ * @return            Number of bytes written (or needed) or 0 in case of an
+ *                    error.
+ */
+int ConvertBufferWtoA(char *szaBuffer, int cbBuffer, LPCTSTR szUnicode,
+					  int cchUnicode) {
+	size_t nAscii;
+#if TEXT_CODEPAGE != CP_UTF8
+	int cbRest;
+#endif
+
+	// Include the terminator in the conversion if there's one.
+	if (cchUnicode < 0)
+		cchUnicode = (int)wcslen(szUnicode) + 1;
+	if (cchUnicode == 0)
+		return 0;
+
+#if TEXT_CODEPAGE == CP_UTF8
+	// Our own transcoder does it all.
+	nAscii = TranscodeWideUtf8Length((const unsigned short*)szUnicode,
+		(size_t)cchUnicode);
+	if (cbBuffer == 0)
+		return (int)nAscii;
+	if (nAscii > (size_t)cbBuffer)
+		return 0;
+
+	return (int)TranscodeWideToUtf8(szaBuffer,
+		(const unsigned short*)szUnicode, (size_t)cchUnicode);
+#else
+	// Narrow the ASCII text at the start ourselves.
+	nAscii = TranscodeWideAsciiSpan((const unsigned short*)szUnicode,
+		(size_t)cchUnicode);
+	if (cbBuffer > 0) {
+		if (nAscii > (size_t)cbBuffer)
+			return 0;
+
+		TranscodeWideToAscii(szaBuffer, (const unsigned short*)szUnicode,
+			nAscii);
+	}
+	if (nAscii == (size_t)cchUnicode)
+		return (int)nAscii;
+
+	// With no room left the system would just return the length needed.
+	if ((cbBuffer > 0) && (nAscii == (size_t)cbBuffer))
+		return 0;
+
+	// Leave the rest to the system.
+	if (cbBuffer > 0) {
+		cbRest = WideCharToMultiByte(TEXT_CODEPAGE, 0, szUnicode + nAscii,
+			cchUnicode - (int)nAscii, szaBuffer + nAscii,
+			cbBuffer - (int)nAscii, NULL, NULL);
+	} else {
+		cbRest = WideCharToMultiByte(TEXT_CODEPAGE, 0, szUnicode + nAscii,
+			cchUnicode - (int)nAscii, NULL, 0, NULL, NULL);
+	}
+	if (cbRest == 0)
+		return 0;
+
+	return (int)nAscii + cbRest;
+#endif
+}
+
+/**
+ * Gets the number of bytes at the end of a buffer that belong to a character
+ * that continues past it.
+ *
+ * @param  szaBuffer Text in the text code page.
+ * @param  cbBuffer  Length of the text in bytes.
+ * @return           Number of bytes to hold back for the next block.
+ */
+DWORD GetSplitCharacterLength(const char *szaBuffer, DWORD cbBuffer) {
+#if TEXT_CODEPAGE == CP_UTF8
+	return (DWORD)TranscodeUtf8Tail(szaBuffer, (size_t)cbBuffer);
+#else
+	DWORD iByte;
+
+	// Trail bytes only come after a lead byte, so ASCII can be skipped.
+	iByte = (DWORD)TranscodeAsciiSpan(szaBuffer, (size_t)cbBuffer);
+	for (; iByte < cbBuffer; iByte++) {
+		if (IsDBCSLeadByte((BYTE)szaBuffer[iByte]))
+			iByte++;
+	}
+
+	return (iByte > cbBuffer) ? 1 : 0;
+#endif
 }
 
 /**
@@ -180,4 +750,4 @@ void PrintDebugConsole(const char* format, ...) {
 
 	// Print to debug console.
 	OutputDebugString(szMsg);
-}
+}
\ No newline at end of file
@@ -10,13 +10,41 @@
 
 #include "windowshelper.h"
 
+// Code page of the text files. CP_UTF8 is handled by our own transcoder since
+// not every Windows CE build supports it.
+#ifndef TEXT_CODEPAGE
+	#define TEXT_CODEPAGE CP_ACP
+#endif
+
+// Suffixes of the files used while replacing a file.
+#define TEMP_FILE_SUFFIX   L".tmp"
+#define BACKUP_FILE_SUFFIX L".bak"
+
+// Size of the blocks used when streaming a file.
+#define FILE_CHUNK_SIZE 4096
+
+// Callback for every block of a streamed file.
+typedef BOOL (*FILECHUNKPROC)(LPCTSTR szChunk, DWORD cchChunk, LPARAM lParam);
+
 // String conversion.
 BOOL ConvertStringAtoW(LPTSTR szUnicode, const char *szASCII);
-BOOL ConvertStringWtoA(char *szASCII, LPCTSTR szUnicode);
+BOOL ConvertStringWtoA(char *szASCII, LPCTSTR szUnicode, size_t cbASCII);
+int ConvertBufferAtoW(LPTSTR szUnicode, int cchUnicode, const char *szaBuffer,
+					  int cbBuffer);
+int ConvertBufferWtoA(char *szaBuffer, int cbBuffer, LPCTSTR szUnicode,
+					  int cchUnicode);
 
 // File utilities.
 BOOL ReadFileContents(LPCTSTR szPath, LPTSTR *szFileContents);
+BOOL ReadFileText(LPCTSTR szPath, LPTSTR *lpszText, DWORD *lpcchText);
+BOOL StreamFileContents(LPCTSTR szPath, FILECHUNKPROC lpfnChunk, LPARAM lParam);
 BOOL SaveFileContents(LPCTSTR szFilePath, LPCTSTR szContents);
+BOOL WriteFileAtomically(LPCTSTR szPath, const void *lpData, DWORD cbData);
+BOOL GetFileModifiedTime(LPCTSTR szPath, FILETIME *lpftModified);
+BOOL GetFileContentHash(LPCTSTR szPath, DWORD *lpdwHash);
+UINT RecoverInterruptedWrites(LPCTSTR szFolder);
+BOOL IsTransientFile(LPCTSTR szPath);
+BOOL IsPageFile(LPCTSTR szPath);
 
 // Debugging.
 void PrintDebugConsole(const char* format, ...);
@@ -15,6 +15,15 @@
 #include "PageManager.h"
 #include "FindReplace.h"
 #include "CommonDlgManager.h"
+#include "ArticleTree.h"
+#include "WorkspaceLoader.h"
+#include "WorkspaceSearch.h"
+#include "PageImport.h"
+#include "RenderCache.h"
+#include "Prefetch.h"
+#include "ImageCache.h"
+#include "DependencyIndex.h"
+#include "EditJournal.h"
 #include "AboutDialog.h"
 
 // Definitions.
@@ -22,8 +31,13 @@
 
 // Global variables.
 HINSTANCE hInst;
+HWND hwndMain;
 int uki_error;
 BOOL fWorkspaceOpen;
+ARTICLETREE atArticles;
+HTREEITEM htiArticleLibrary;
+HTREEITEM htiTemplateLibrary;
+BOOL fSelectionDeferred;
 
 // CommandBar buttons.
 const TBBUTTON tbButtons[] = {
@@ -64,12 +78,12 @@ const TBBUTTON tbButtons[] = {
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 				   LPWSTR lpCmdLine, int nShowCmd) {
 	MSG msg;
-	HWND hwndMain;
 	HACCEL hAccel;
 	int rc;
 
 	// Set flags.
 	fWorkspaceOpen = FALSE;
+	fSelectionDeferred = FALSE;
 
 	// Initialize the application.
 	rc = InitializeApplication(hInstance);
@@ -105,14 +119,26 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
  * @return          0 if a workspace was closed.
  */
 LRESULT CloseWorkspace(BOOL fDestroy) {
+	// Stop any load in progress before touching the engine.
+	CancelWorkspaceLoad();
+
 	// Set all controls to their defaults.
 	TreeViewClear();
+	htiArticleLibrary = NULL;
+	htiTemplateLibrary = NULL;
 	ClearPageToDefaults(fDestroy);
 
-	// Close Uki.
+	// Close Uki and everything that references its pages.
+	ArticleTreeFree(&atArticles);
+	ClearWorkspaceSearch();
+	ClearDependencyIndex();
+	ClearPrefetch();
+	ClearRenderCache();
+	ClearImageCache();
 	CloseUki();
 
 	fWorkspaceOpen = FALSE;
+	fSelectionDeferred = FALSE;
 	return 0;
 }
 
@@ -123,37 +149,129 @@ LRESULT CloseWorkspace(BOOL fDestroy) {
  * @return         0 if a workspace was loaded.
  */
 LRESULT LoadWorkspace(BOOL fReload) {
+	TCHAR szWikiPath[MAX_PATH];
+
 	if (fReload) {
-		// Reload workspace.
-		CloseWorkspace(FALSE);
-		if (!ReloadUki()) {
+		UKIREFRESH ukiRefresh;
+
+		// Let the load in progress finish first.
+		if (IsWorkspaceLoading())
 			return 1;
+
+		// Try to only apply what changed on disk.
+		if (RefreshUki(&ukiRefresh) && (ukiRefresh.nRemoved == 0L) &&
+				!ukiRefresh.fManifestChanged) {
+			// Patch the TreeView with the new pages.
+			PatchTreeView(&ukiRefresh);
+
+			// Reload the open page if someone else changed it.
+			if (!IsPageDirty() && IsPageChangedOnDisk())
+				ReloadCurrentPage();
+
+			fWorkspaceOpen = TRUE;
+			return 0;
 		}
+
+		// Things were removed, couldn't be added, or the variables changed,
+		// so reload the whole workspace.
+		wcscpy(szWikiPath, GetCurrentWorkspace());
+		CloseWorkspace(FALSE);
 	} else {
-		// Open a new workspace.
-		TCHAR szWikiPath[MAX_PATH];
-		
 		// Get the workspace folder.
 		if (!OpenWorkspace(szWikiPath))
 			return 1;
 		
 		// Close the current workspace.
 		CloseWorkspace(FALSE);
-		
-		// Initialize Uki.
-		if (!InitializeUki(szWikiPath)) {
-			fWorkspaceOpen = FALSE;
-			return 1;
-		}
 	}
 
-	// Populate the TreeView with stuff.
-	PopulateTreeView();
+	// Set up the TreeView to receive the articles as they get loaded.
+	PrepareTreeView();
+	ShowWorkspaceLoadProgress(0L, -1L);
+
+	// Load the workspace in the background.
+	if (!StartWorkspaceLoad(hwndMain, szWikiPath)) {
+		MessageBox(NULL, L"Failed to start loading the workspace.",
+			L"Workspace Load Failed", MB_OK | MB_ICONERROR);
+		CloseWorkspace(FALSE);
+
+		return 1;
+	}
 
-	fWorkspaceOpen = TRUE;
 	return 0;
 }
 
+/**
+ * Imports a whole folder of pages into the workspace and adds them all to the
+ * TreeView in one go.
+ *
+ * @param  fIsArticle Are the pages being imported articles?
+ * @return            0 if the pages were imported.
+ */
+LRESULT ImportPages(BOOL fIsArticle) {
+	PAGEIMPORT_REPORT piReport;
+	TCHAR szFolder[MAX_PATH];
+	TCHAR szMessage[LBL_MAX_LEN * 2];
+
+	// The engine can't take new pages while it's being loaded.
+	if (CheckForWorkspaceLoading())
+		return 1;
+
+	// Get the folder to import.
+	if (!OpenImportFolder(szFolder, (fIsArticle) ? L"Import Articles" :
+			L"Import Templates")) {
+		return 1;
+	}
+
+	// Import the pages.
+	if (!ImportPageFolder(szFolder, fIsArticle, &piReport)) {
+		MessageBox(hwndMain, L"Failed to import the pages.", L"Import Failed",
+			MB_OK | MB_ICONERROR);
+		return 1;
+	}
+	PatchTreeView(&piReport.ukiAdded);
+
+	// Let the user know about the pages that were left behind.
+	if (piReport.nFailed > 0L) {
+		wsprintf(szMessage, L"%ld pages were imported, but %ld couldn't be. "
+			L"Pages already in the workspace aren't overwritten.",
+			piReport.ukiAdded.nAdded, piReport.nFailed);
+		MessageBox(hwndMain, szMessage, L"Import Incomplete",
+			MB_OK | MB_ICONEXCLAMATION);
+	}
+
+	return 0;
+}
+
+/**
+ * Shows the progress of a workspace load in the article library caption.
+ *
+ * @param nLoaded Number of articles already in the TreeView.
+ * @param nTotal  Total number of articles or -1 if it isn't known yet.
+ */
+void ShowWorkspaceLoadProgress(LONG nLoaded, LONG nTotal) {
+	WCHAR szLibrary[LBL_MAX_LEN];
+	WCHAR szCaption[LBL_MAX_LEN + 32];
+
+	// Check if there's anything to be done.
+	if (htiArticleLibrary == NULL)
+		return;
+
+	// Build the caption.
+	LoadString(hInst, IDS_ARTICLE_LIBRARY, szLibrary, LBL_MAX_LEN);
+	if (nTotal < 0L) {
+		wsprintf(szCaption, L"%s (loading...)", szLibrary);
+	} else if (nLoaded < nTotal) {
+		wsprintf(szCaption, L"%s (%ld of %ld)", szLibrary, nLoaded, nTotal);
+	} else if (IsWorkspaceLoading()) {
+		wsprintf(szCaption, L"%s (indexing...)", szLibrary);
+	} else {
+		wcscpy(szCaption, szLibrary);
+	}
+
+	TreeViewSetItemText(htiArticleLibrary, szCaption);
+}
+
 /**
  * Checks for unsaved changes and displays a message box if there are any.
  *
@@ -184,62 +302,288 @@ BOOL CheckForUnsavedChanges() {
 	return FALSE;
 }
 
+/**
+ * Checks if the workspace is still being loaded by the worker thread and
+ * displays a message box if it is, since the engine can't take new pages
+ * while it's being loaded.
+ *
+ * @return TRUE if we should abort the current operation.
+ */
+BOOL CheckForWorkspaceLoading() {
+	if (!IsWorkspaceLoading())
+		return FALSE;
+
+	MessageBox(hwndMain, L"Wait for the workspace to finish loading before "
+		L"adding pages to it.", L"Workspace Loading",
+		MB_OK | MB_ICONEXCLAMATION);
+	return TRUE;
+}
+
+/**
+ * Checks if there are unsaved changes left from a previous session that ended
+ * unexpectedly and offers to bring them back.
+ *
+ * @return TRUE if a page was recovered.
+ */
+BOOL RecoverUnsavedPage() {
+	TCHAR szPath[MAX_PATH];
+	TCHAR szMsg[MAX_PATH + 100];
+	LPCTSTR szPagePath;
+	LPTSTR szText;
+	LONG nArticle;
+	LONG nTemplate;
+
+	// Check if there's anything to recover.
+	if (!ReadEditJournal(szPath, &szText))
+		return FALSE;
+
+	// Find out which page it belongs to.
+	for (nArticle = 0; nArticle < GetUkiArticlesAvailable(); nArticle++) {
+		szPagePath = GetUkiArticleFilePath(nArticle);
+		if ((szPagePath != NULL) && (wcscmp(szPagePath, szPath) == 0))
+			break;
+	}
+	nTemplate = 0;
+	if (nArticle == GetUkiArticlesAvailable()) {
+		for (; nTemplate < GetUkiTemplatesAvailable(); nTemplate++) {
+			szPagePath = GetUkiTemplateFilePath(nTemplate);
+			if ((szPagePath != NULL) && (wcscmp(szPagePath, szPath) == 0))
+				break;
+		}
+		if (nTemplate == GetUkiTemplatesAvailable()) {
+			LocalFree(szText);
+			DeleteEditJournal();
+
+			return FALSE;
+		}
+	}
+
+	// Ask the user what to do with it.
+	wsprintf(szMsg, L"There are unsaved changes to \"%s\" from the last "
+		L"session. Do you want to recover them?", szPath);
+	if (MessageBox(NULL, szMsg, L"Recover Unsaved Changes",
+			MB_YESNO | MB_ICONQUESTION) != IDYES) {
+		LocalFree(szText);
+		DeleteEditJournal();
+
+		return FALSE;
+	}
+
+	// Open the page and put back the changes, journaling them right away.
+	if (nArticle < GetUkiArticlesAvailable()) {
+		PopulatePageViewArticle((size_t)nArticle);
+	} else {
+		PopulatePageViewTemplate((size_t)nTemplate);
+	}
+	RestorePageText(szText);
+	FlushEditJournal();
+
+	LocalFree(szText);
+	return TRUE;
+}
+
 /**
  * Populates the Articles node in the TreeView.
+ * @remark Only the first level is inserted, folders are populated on demand.
  *
  * @param  htiParent     Parent TreeView node handle.
  * @return               Last article index processed.
  */
 LONG PopulateArticles(HTREEITEM htiParent) {
+	LONG nArticles;
+
+	// Build the article tree model.
+	ArticleTreeFree(&atArticles);
+	if (!ArticleTreeInitialize(&atArticles)) {
+		MessageBox(NULL, L"Failed to allocate the article tree.",
+			L"Article Population Failed", MB_OK | MB_ICONERROR);
+		return -1L;
+	}
+	nArticles = ArticleTreeBuildFromUki(&atArticles);
+	if (nArticles < 0L) {
+		MessageBox(NULL, L"Failed to build the article tree.",
+			L"Article Population Failed", MB_OK | MB_ICONERROR);
+		return -1L;
+	}
+
+	// Materialize only the root of the article library.
+	PopulateArticleNode(htiParent, ARTTREE_ROOT);
+
+	return nArticles - 1;
+}
+
+/**
+ * Inserts the direct children of an article tree node into the TreeView.
+ *
+ * @param  htiNode TreeView node handle that represents the article tree node.
+ * @param  lNode   Article tree node index.
+ * @return         Number of items inserted.
+ */
+LONG PopulateArticleNode(HTREEITEM htiNode, LONG lNode) {
+	const ARTTREE_NODE *lpNode;
+	const ARTTREE_NODE *lpChild;
 	HTREEITEM htiLastItem;
-	HTREEITEM htiFolder;
-	WCHAR szCaption[LBL_MAX_LEN];
-	char szaLastParent[MAX_PATH];
+	LONG lChild;
+	LONG nInserted;
+	int iFolderIcon;
+	int iArticleIcon;
+
+	// Check if there's anything to be done.
+	lpNode = ArticleTreeGetNode(&atArticles, lNode);
+	if ((lpNode == NULL) || ArticleTreeIsMaterialized(&atArticles, lNode))
+		return 0L;
+
+	// Get the icons only once.
+	iFolderIcon = ImageListIconIndex(IDB_FOLDER);
+	iArticleIcon = ImageListIconIndex(IDB_ARTICLE);
+	ArticleTreeSetItem(&atArticles, lNode, htiNode);
+
+	// Go through the children of the node.
+	nInserted = 0L;
+	htiLastItem = TVI_FIRST;
+	for (lChild = lpNode->lFirstChild; lChild != ARTTREE_NONE;
+			lChild = lpChild->lNextSibling) {
+		lpChild = ArticleTreeGetNode(&atArticles, lChild);
+
+		// Append to the TreeView with the caption fetched on demand.
+		if (lpChild->nArticle == ARTTREE_NONE) {
+			htiLastItem = TreeViewAddCallbackItem(htiNode, htiLastItem,
+				iFolderIcon, lpChild->nChildren > 0L, (LPARAM)lChild);
+		} else {
+			htiLastItem = TreeViewAddCallbackItem(htiNode, htiLastItem,
+				iArticleIcon, FALSE, (LPARAM)lChild);
+		}
+
+		ArticleTreeSetItem(&atArticles, lChild, htiLastItem);
+		nInserted++;
+	}
+
+	// Make sure we don't populate this node again.
+	ArticleTreeSetMaterialized(&atArticles, lNode, TRUE);
+
+	return nInserted;
+}
+
+/**
+ * Appends articles added to the engine after the TreeView was populated.
+ *
+ * @param  nFirstArticle Index of the first article that was added.
+ * @param  nLastArticle  Index after the last article that was added.
+ * @return               Number of TreeView items inserted.
+ */
+LONG PatchArticles(LONG nFirstArticle, LONG nLastArticle) {
+	const ARTTREE_NODE *lpNode;
 	UKIARTICLE ukiArticle;
+	HTREEITEM htiParent;
+	HTREEITEM htiItem;
 	LONG iArticle;
+	LONG lFirstNode;
+	LONG lNode;
+	LONG nInserted;
+
+	// Add the new articles to the model.
+	lFirstNode = atArticles.nNodes;
+	for (iArticle = nFirstArticle; iArticle < nLastArticle; iArticle++) {
+		if (!GetUkiArticle(&ukiArticle, iArticle))
+			break;
+
+		ArticleTreeAddArticle(&atArticles, iArticle, ukiArticle.parent,
+			ukiArticle.name);
+	}
 
-	// Go through articles.
-	htiLastItem = (HTREEITEM)NULL;
-	htiFolder = htiParent;
-	for (iArticle = 0; iArticle < GetUkiArticlesAvailable(); iArticle++) {
-		// Get article.
-		GetUkiArticle(&ukiArticle, iArticle);
-		
-		// Check if we have a parent.
-		if (ukiArticle.parent != NULL) {
-			// Check if we should add a new folder.
-			if (strcmp(szaLastParent, ukiArticle.parent) != 0) {
-				// Set the new last parent.
-				strcpy(szaLastParent, ukiArticle.parent);
-
-				// Add folder.
-				if (ConvertStringAtoW(szCaption, szaLastParent)) {
-					htiFolder = TreeViewAddItem(htiParent, szCaption,
-						htiLastItem, ImageListIconIndex(IDB_FOLDER), (LPARAM)0);
-				} else {
-					MessageBox(NULL, L"Failed to convert article folder name "
-						L"from ASCII to Unicode.", L"Article Population Failed",
-						MB_OK);
-				}
-			}
+	// Only insert the nodes whose parent has already been materialized.
+	nInserted = 0L;
+	for (lNode = lFirstNode; lNode < atArticles.nNodes; lNode++) {
+		lpNode = ArticleTreeGetNode(&atArticles, lNode);
+		if (!ArticleTreeIsMaterialized(&atArticles, lpNode->lParent))
+			continue;
+
+		// Get the parent TreeView item.
+		htiParent = (HTREEITEM)ArticleTreeGetItem(&atArticles,
+			lpNode->lParent);
+		if (htiParent == NULL)
+			continue;
+
+		// Append the item.
+		if (lpNode->nArticle == ARTTREE_NONE) {
+			htiItem = TreeViewAddCallbackItem(htiParent, TVI_LAST,
+				ImageListIconIndex(IDB_FOLDER), lpNode->nChildren > 0L,
+				(LPARAM)lNode);
 		} else {
-			// Go back to the root.
-			htiFolder = htiParent;
+			htiItem = TreeViewAddCallbackItem(htiParent, TVI_LAST,
+				ImageListIconIndex(IDB_ARTICLE), FALSE, (LPARAM)lNode);
 		}
 
-		// Convert name to Unicode.
-		if (ConvertStringAtoW(szCaption, ukiArticle.name)) {
-			// Append to the TreeView.
-			htiLastItem = TreeViewAddItem(htiFolder, szCaption,
-				htiLastItem, ImageListIconIndex(IDB_ARTICLE),
-				(LPARAM)iArticle);
-		} else {
-			MessageBox(NULL, L"Failed to convert article name from ASCII to "
-				L"Unicode.", L"Article Population Failed", MB_OK);
-		}
+		ArticleTreeSetItem(&atArticles, lNode, htiItem);
+		nInserted++;
+	}
+
+	return nInserted;
+}
+
+/**
+ * Appends templates added to the engine after the TreeView was populated.
+ *
+ * @param  nFirstTemplate Index of the first template that was added.
+ * @return                Number of TreeView items inserted.
+ */
+LONG PatchTemplates(LONG nFirstTemplate) {
+	LPCTSTR szCaption;
+	LONG nTemplates;
+	LONG iTemplate;
+
+	// Go through the new templates.
+	nTemplates = GetUkiTemplatesAvailable();
+	for (iTemplate = nFirstTemplate; iTemplate < nTemplates; iTemplate++) {
+		szCaption = GetUkiTemplateName(iTemplate);
+		if (szCaption == NULL)
+			break;
+
+		// Append to the TreeView.
+		TreeViewAddItem(htiTemplateLibrary, (LPTSTR)szCaption, TVI_LAST,
+			ImageListIconIndex(IDB_TEMPLATE), (LPARAM)iTemplate);
 	}
 
-	return iArticle - 1;
+	return iTemplate - nFirstTemplate;
+}
+
+/**
+ * Patches the TreeView with the pages added by a workspace refresh.
+ *
+ * @param  lpRefresh Summary of the workspace refresh.
+ * @return           0 if everything went OK.
+ */
+LRESULT PatchTreeView(const UKIREFRESH *lpRefresh) {
+	// Check if there's anything to be done.
+	if (lpRefresh->nAdded == 0L)
+		return 0;
+
+	PatchArticles(lpRefresh->nFirstNewArticle, GetUkiArticlesAvailable());
+	PatchTemplates(lpRefresh->nFirstNewTemplate);
+
+	return 0;
+}
+
+/**
+ * Patches the TreeView with the pages that were added to the engine since it
+ * had a certain number of them.
+ *
+ * @param  nFirstArticle  Number of articles before the new ones were added.
+ * @param  nFirstTemplate Number of templates before the new ones were added.
+ * @return                0 if everything went OK.
+ */
+LRESULT PatchTreeViewFrom(LONG nFirstArticle, LONG nFirstTemplate) {
+	UKIREFRESH ukiAdded;
+
+	ukiAdded.nFirstNewArticle = nFirstArticle;
+	ukiAdded.nFirstNewTemplate = nFirstTemplate;
+	ukiAdded.nAdded = (GetUkiArticlesAvailable() - nFirstArticle) +
+		(GetUkiTemplatesAvailable() - nFirstTemplate);
+	ukiAdded.nRemoved = 0L;
+	ukiAdded.nChanged = 0L;
+	ukiAdded.fManifestChanged = FALSE;
+
+	return PatchTreeView(&ukiAdded);
 }
 
 /**
@@ -250,20 +594,17 @@ LONG PopulateArticles(HTREEITEM htiParent) {
  */
 LONG PopulateTemplates(HTREEITEM htiParent) {
 	HTREEITEM htiLastItem;
-	WCHAR szCaption[LBL_MAX_LEN];
-	UKITEMPLATE ukiTemplate;
+	LPCTSTR szCaption;
 	LONG iTemplate;
 	
 	// Go through templates.
 	htiLastItem = (HTREEITEM)NULL;
 	for (iTemplate = 0; iTemplate < GetUkiTemplatesAvailable(); iTemplate++) {
-		// Get template.
-		GetUkiTemplate(&ukiTemplate, iTemplate);
-		
-		// Convert name to Unicode.
-		if (ConvertStringAtoW(szCaption, ukiTemplate.name)) {
+		// Get the interned template name.
+		szCaption = GetUkiTemplateName(iTemplate);
+		if (szCaption != NULL) {
 			// Append to the TreeView.
-			htiLastItem = TreeViewAddItem(htiParent, szCaption,
+			htiLastItem = TreeViewAddItem(htiParent, (LPTSTR)szCaption,
 				htiLastItem, ImageListIconIndex(IDB_TEMPLATE),
 				(LPARAM)iTemplate);
 		} else {
@@ -276,13 +617,11 @@ LONG PopulateTemplates(HTREEITEM htiParent) {
 }
 
 /**
- * Populates the TreeView component with stuff.
+ * Clears the TreeView and adds the library items with an empty article tree.
  *
  * @return 0 if everything went OK.
  */
-LRESULT PopulateTreeView() {
-	HTREEITEM htiArticles;
-	HTREEITEM htiTemplates;
+LRESULT PrepareTreeView() {
 	WCHAR szCaption[LBL_MAX_LEN];
 
 	// Clear the TreeView as a precaution.
@@ -290,23 +629,42 @@ LRESULT PopulateTreeView() {
 
 	// Add article library root item.
 	LoadString(hInst, IDS_ARTICLE_LIBRARY, szCaption, LBL_MAX_LEN);
-	htiArticles = TreeViewAddItem((HTREEITEM)NULL, szCaption,
+	htiArticleLibrary = TreeViewAddItem((HTREEITEM)NULL, szCaption,
 		(HTREEITEM)TVI_ROOT, ImageListIconIndex(IDB_LIBRARY), (LPARAM)0);
 
-	// Populate the articles.
-	PopulateArticles(htiArticles);
-
 	// Add template library root item.
 	LoadString(hInst, IDS_TEMPLATE_LIBRARY, szCaption, LBL_MAX_LEN);
-	htiTemplates = TreeViewAddItem((HTREEITEM)NULL, szCaption,
+	htiTemplateLibrary = TreeViewAddItem((HTREEITEM)NULL, szCaption,
 		(HTREEITEM)TVI_ROOT, ImageListIconIndex(IDB_TEMPLATELIBRARY), (LPARAM)0);
 
-	// Populate the templates.
-	PopulateTemplates(htiTemplates);
+	// Start with an empty article tree whose root is the library item.
+	ArticleTreeFree(&atArticles);
+	if (!ArticleTreeInitialize(&atArticles)) {
+		MessageBox(NULL, L"Failed to allocate the article tree.",
+			L"Article Population Failed", MB_OK | MB_ICONERROR);
+		return 1;
+	}
+	PopulateArticleNode(htiArticleLibrary, ARTTREE_ROOT);
+
+	return 0;
+}
+
+/**
+ * Populates the TreeView component with stuff.
+ *
+ * @return 0 if everything went OK.
+ */
+LRESULT PopulateTreeView() {
+	// Add the library items.
+	PrepareTreeView();
+
+	// Populate the articles and templates.
+	PopulateArticles(htiArticleLibrary);
+	PopulateTemplates(htiTemplateLibrary);
 
 	// Expand the view.
-	TreeViewExpandNode(htiArticles);
-	TreeViewExpandNode(htiTemplates);
+	TreeViewExpandNode(htiArticleLibrary);
+	TreeViewExpandNode(htiTemplateLibrary);
 
 	return 0;
 }
@@ -419,12 +777,18 @@ LRESULT CALLBACK MainWindowProc(HWND hWnd, UINT wMsg, WPARAM wParam,
 		return WndMainCommand(hWnd, wMsg, wParam, lParam);
 	case WM_INITMENUPOPUP:
 		return WndMainInitMenuPopUp(hWnd, wMsg, wParam, lParam);
-//	case WM_HIBERNATE:
-//		return WndMainHibernate(hWnd, wMsg, wParam, lParam);
+	case WM_HIBERNATE:
+		return WndMainHibernate(hWnd, wMsg, wParam, lParam);
 //	case WM_ACTIVATE:
 //		return WndMainActivate(hWnd, wMsg, wParam, lParam);
 	case WM_NOTIFY:
 		return WndMainNotify(hWnd, wMsg, wParam, lParam);
+	case WM_WORKSPACE_BATCH:
+		return WndMainWorkspaceBatch(hWnd, wMsg, wParam, lParam);
+	case WM_WORKSPACE_LOADED:
+		return WndMainWorkspaceLoaded(hWnd, wMsg, wParam, lParam);
+	case WM_TIMER:
+		return WndMainTimer(hWnd, wMsg, wParam, lParam);
 	case WM_CLOSE:
 		return WndMainClose(hWnd, wMsg, wParam, lParam);
 	case WM_DESTROY:
@@ -445,12 +809,32 @@ LRESULT CALLBACK MainWindowProc(HWND hWnd, UINT wMsg, WPARAM wParam,
  */
 LRESULT TreeViewSelectionChanged(HWND hWnd, UINT wMsg, WPARAM wParam,
 								 LPARAM lParam) {
-	TVITEM tvItem;
 	NMTREEVIEW* pnmTreeView = (LPNMTREEVIEW)lParam;
+
+	// The loader thread is still reading the engine to build the indices and
+	// rendering would race it, so the page is only opened once it's done.
+	if (IsWorkspaceLoading()) {
+		fSelectionDeferred = TRUE;
+		return 0;
+	}
+
+	return OpenTreeViewItem(pnmTreeView->itemNew.hItem);
+}
+
+/**
+ * Opens the article or template of a TreeView item in the page view.
+ *
+ * @param  hItem Item that was selected.
+ * @return       0 if everything worked.
+ */
+LRESULT OpenTreeViewItem(HTREEITEM hItem) {
+	TVITEM tvItem;
+	LONG alNeighbours[PREFETCH_MAX_NEIGHBOURS];
+	LONG nNeighbours;
 	size_t nIndex;
 
 	// Get item information.
-	tvItem.hItem = pnmTreeView->itemNew.hItem;
+	tvItem.hItem = hItem;
 	tvItem.mask = TVIF_PARAM | TVIF_IMAGE;
 	TreeViewGetItem(&tvItem);
 	
@@ -462,7 +846,16 @@ LRESULT TreeViewSelectionChanged(HWND hWnd, UINT wMsg, WPARAM wParam,
 		if (CheckForUnsavedChanges())
 			return 1;
 
+		// Articles are referenced by their article tree node.
+		nIndex = (size_t)ArticleTreeGetArticle(&atArticles,
+			(long)tvItem.lParam);
 		PopulatePageViewArticle(nIndex);
+
+		// Get its neighbours ready while the user reads it.
+		RecordArticleVisit((LONG)nIndex);
+		nNeighbours = ArticleTreeGetSiblingArticles(&atArticles,
+			(long)tvItem.lParam, alNeighbours, PREFETCH_MAX_NEIGHBOURS);
+		SchedulePrefetch(alNeighbours, nNeighbours);
 	} else if (tvItem.iImage == ImageListIconIndex(IDB_TEMPLATE)) {
 		if (CheckForUnsavedChanges())
 			return 1;
@@ -473,6 +866,78 @@ LRESULT TreeViewSelectionChanged(HWND hWnd, UINT wMsg, WPARAM wParam,
 	return 0;
 }
 
+/**
+ * Process the TVN_ITEMEXPANDING message for the TreeView.
+ *
+ * @param  hWnd   Window handler.
+ * @param  wMsg   Message type.
+ * @param  wParam Message parameter.
+ * @param  lParam Message parameter.
+ * @return        FALSE to allow the item to expand.
+ */
+LRESULT TreeViewItemExpanding(HWND hWnd, UINT wMsg, WPARAM wParam,
+							  LPARAM lParam) {
+	TVITEM tvItem;
+	NMTREEVIEW* pnmTreeView = (LPNMTREEVIEW)lParam;
+
+	// We only care about expansions.
+	if (!(pnmTreeView->action & TVE_EXPAND))
+		return FALSE;
+
+	// Get item information.
+	tvItem.hItem = pnmTreeView->itemNew.hItem;
+	tvItem.mask = TVIF_PARAM | TVIF_IMAGE;
+	TreeViewGetItem(&tvItem);
+
+	// Populate article folders the first time they are expanded.
+	if (tvItem.iImage == ImageListIconIndex(IDB_FOLDER))
+		PopulateArticleNode(tvItem.hItem, (LONG)tvItem.lParam);
+
+	return FALSE;
+}
+
+/**
+ * Process the TVN_GETDISPINFO message for the TreeView.
+ *
+ * @param  hWnd   Window handler.
+ * @param  wMsg   Message type.
+ * @param  wParam Message parameter.
+ * @param  lParam Message parameter.
+ * @return        0 if everything worked.
+ */
+LRESULT TreeViewGetDispInfo(HWND hWnd, UINT wMsg, WPARAM wParam,
+							LPARAM lParam) {
+	TV_DISPINFO *ptvDispInfo = (TV_DISPINFO*)lParam;
+	char szaCaption[LBL_MAX_LEN];
+	LPCTSTR szName;
+	size_t nMaxLen;
+
+	// Check if the caption is what's being requested.
+	if (!(ptvDispInfo->item.mask & TVIF_TEXT) ||
+		(ptvDispInfo->item.cchTextMax <= 0)) {
+		return 0;
+	}
+
+	// Articles can point straight to their interned names.
+	szName = GetUkiArticleName(ArticleTreeGetArticle(&atArticles,
+		(long)ptvDispInfo->item.lParam));
+	if (szName != NULL) {
+		ptvDispInfo->item.pszText = (LPTSTR)szName;
+		return 0;
+	}
+
+	// Get the caption from the article tree.
+	nMaxLen = min(LBL_MAX_LEN, ptvDispInfo->item.cchTextMax);
+	ArticleTreeGetName(&atArticles, (long)ptvDispInfo->item.lParam,
+		szaCaption, nMaxLen);
+
+	// Convert it to Unicode.
+	if (!ConvertStringAtoW(ptvDispInfo->item.pszText, szaCaption))
+		ptvDispInfo->item.pszText[0] = L'\0';
+
+	return 0;
+}
+
 /**
  * Process the WM_CREATE message for the window.
  *
@@ -534,6 +999,14 @@ LRESULT WndMainCreate(HWND hWnd, UINT wMsg, WPARAM wParam,
 
 	// Initialize the find and replace engine.
 	InitializeFindReplace(hInst, hWnd, GetPageEditHandle());
+	InitializeWorkspaceSearch();
+	InitializeDependencyIndex();
+	InitializeRenderCache(RENDERCACHE_MAX_BYTES);
+	InitializePrefetch(hWnd, IDT_PREFETCH, PREFETCH_MAX_BYTES);
+	InitializeImageCache(IMAGECACHE_MAX_BYTES);
+
+	// Journal the unsaved edits every once in a while.
+	SetTimer(hWnd, IDT_EDITJOURNAL, EDIT_JOURNAL_INTERVAL, NULL);
 
 	return 0;
 }
@@ -574,23 +1047,49 @@ LRESULT WndMainInitMenuPopUp(HWND hWnd, UINT wMsg, WPARAM wParam,
 		EnableMenuItem(hMenu, IDM_EDIT_FINDNEXT, MF_BYCOMMAND | MF_GRAYED);
 	}
 
-	// Enable and disable workspace related items.
-	if (fWorkspaceOpen) {
+	// Enable and disable workspace related items. Pages can only be added once
+	// the workspace finished loading.
+	if (fWorkspaceOpen && IsWorkspaceLoading()) {
+		EnableMenuItem(hMenu, IDM_FILE_NEWARTICLE, MF_BYCOMMAND | MF_GRAYED);
+		EnableMenuItem(hMenu, IDM_FILE_NEWTEMPLATE, MF_BYCOMMAND | MF_GRAYED);
+		EnableMenuItem(hMenu, IDM_FILE_IMPORTARTICLES,
+			MF_BYCOMMAND | MF_GRAYED);
+		EnableMenuItem(hMenu, IDM_FILE_IMPORTTEMPLATES,
+			MF_BYCOMMAND | MF_GRAYED);
+		EnableMenuItem(hMenu, IDM_FILE_REFRESHWS, MF_BYCOMMAND | MF_GRAYED);
+		EnableMenuItem(hMenu, IDM_FILE_CLOSEWS, MF_BYCOMMAND | MF_ENABLED);
+	} else if (fWorkspaceOpen) {
 		EnableMenuItem(hMenu, IDM_FILE_NEWARTICLE, MF_BYCOMMAND | MF_ENABLED);
 		EnableMenuItem(hMenu, IDM_FILE_NEWTEMPLATE, MF_BYCOMMAND | MF_ENABLED);
+		EnableMenuItem(hMenu, IDM_FILE_IMPORTARTICLES,
+			MF_BYCOMMAND | MF_ENABLED);
+		EnableMenuItem(hMenu, IDM_FILE_IMPORTTEMPLATES,
+			MF_BYCOMMAND | MF_ENABLED);
 		EnableMenuItem(hMenu, IDM_FILE_REFRESHWS, MF_BYCOMMAND | MF_ENABLED);
 		EnableMenuItem(hMenu, IDM_FILE_CLOSEWS, MF_BYCOMMAND | MF_ENABLED);
 	} else {
 		EnableMenuItem(hMenu, IDM_FILE_NEWARTICLE, MF_BYCOMMAND | MF_GRAYED);
 		EnableMenuItem(hMenu, IDM_FILE_NEWTEMPLATE, MF_BYCOMMAND | MF_GRAYED);
+		EnableMenuItem(hMenu, IDM_FILE_IMPORTARTICLES,
+			MF_BYCOMMAND | MF_GRAYED);
+		EnableMenuItem(hMenu, IDM_FILE_IMPORTTEMPLATES,
+			MF_BYCOMMAND | MF_GRAYED);
 		EnableMenuItem(hMenu, IDM_FILE_REFRESHWS, MF_BYCOMMAND | MF_GRAYED);
 		EnableMenuItem(hMenu, IDM_FILE_CLOSEWS, MF_BYCOMMAND | MF_GRAYED);
 	}
 
+	// Dependents are only known once the workspace finished loading.
+	if (fWorkspaceOpen && IsDependencyIndexReady()) {
+		EnableMenuItem(hMenu, IDM_VIEW_DEPENDENTS, MF_BYCOMMAND | MF_ENABLED);
+	} else {
+		EnableMenuItem(hMenu, IDM_VIEW_DEPENDENTS, MF_BYCOMMAND | MF_GRAYED);
+	}
+
 	// Enable/disable article related items.
 	if (IsArticleLoaded() || IsTemplateLoaded()) {
 		EnableMenuItem(hMenu, IDM_FILE_SAVE, MF_BYCOMMAND | MF_ENABLED);
-		EnableMenuItem(hMenu, IDM_FILE_SAVEAS, MF_BYCOMMAND | MF_ENABLED);
+		EnableMenuItem(hMenu, IDM_FILE_SAVEAS, MF_BYCOMMAND |
+			(IsWorkspaceLoading() ? MF_GRAYED : MF_ENABLED));
 	} else {
 		EnableMenuItem(hMenu, IDM_FILE_SAVE, MF_BYCOMMAND | MF_GRAYED);
 		EnableMenuItem(hMenu, IDM_FILE_SAVEAS, MF_BYCOMMAND | MF_GRAYED);
@@ -610,6 +1109,9 @@ LRESULT WndMainInitMenuPopUp(HWND hWnd, UINT wMsg, WPARAM wParam,
  */
 LRESULT WndMainCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
 					   LPARAM lParam) {
+	LONG nArticles;
+	LONG nTemplates;
+
 	switch (GET_WM_COMMAND_ID(wParam, lParam)) {
 	case IDC_EDITPAGE:
 		// Page Editor.
@@ -617,20 +1119,30 @@ LRESULT WndMainCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
 	case IDC_BTNEW:
 	case IDM_FILE_NEWARTICLE:
 		// New Article.
-		if (CheckForUnsavedChanges())
+		if (CheckForWorkspaceLoading() || CheckForUnsavedChanges())
 			return 1;
 
+		nArticles = GetUkiArticlesAvailable();
+		nTemplates = GetUkiTemplatesAvailable();
 		if (CreateNewPage(TRUE))
 			return 1;
-		return PopulateTreeView();
+		return PatchTreeViewFrom(nArticles, nTemplates);
 	case IDM_FILE_NEWTEMPLATE:
 		// New Template.
-		if (CheckForUnsavedChanges())
+		if (CheckForWorkspaceLoading() || CheckForUnsavedChanges())
 			return 1;
 
+		nArticles = GetUkiArticlesAvailable();
+		nTemplates = GetUkiTemplatesAvailable();
 		if (CreateNewPage(FALSE))
 			return 1;
-		return PopulateTreeView();
+		return PatchTreeViewFrom(nArticles, nTemplates);
+	case IDM_FILE_IMPORTARTICLES:
+		// Import Articles.
+		return ImportPages(TRUE);
+	case IDM_FILE_IMPORTTEMPLATES:
+		// Import Templates.
+		return ImportPages(FALSE);
 	case IDC_BTOPEN:
 	case IDM_FILE_OPENWS:
 		// Open Workspace.
@@ -656,9 +1168,14 @@ LRESULT WndMainCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
 		return SaveCurrentPage();
 	case IDM_FILE_SAVEAS:
 		// Save As.
+		if (CheckForWorkspaceLoading())
+			return 1;
+
+		nArticles = GetUkiArticlesAvailable();
+		nTemplates = GetUkiTemplatesAvailable();
 		if (SavePageAs())
 			return 1;
-		return PopulateTreeView();
+		return PatchTreeViewFrom(nArticles, nTemplates);
 	case IDM_FILE_CLOSE:
 		// Close.
 		if (CheckForUnsavedChanges())
@@ -715,6 +1232,10 @@ LRESULT WndMainCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
 		// Toggle Page View.
 		TogglePageView();
 		break;
+	case IDM_VIEW_DEPENDENTS:
+		// Show what depends on the page or the selected variable.
+		ShowPageDependents();
+		break;
 	case IDM_HELP_ABOUT:
 		// About.
 		ShowAboutDialog(hInst, hWnd);
@@ -737,9 +1258,128 @@ LRESULT WndMainCommand(HWND hWnd, UINT wMsg, WPARAM wParam,
  */
 LRESULT WndMainNotify(HWND hWnd, UINT wMsg, WPARAM wParam,
 					  LPARAM lParam) {
+	// Page viewer.
+	if (((LPNMHDR)lParam)->idFrom == IDC_VIEWPAGE)
+		return PageViewHandleNotify(hWnd, wMsg, wParam, lParam);
+
 	switch (((LPNMHDR)lParam)->code) {
 	case TVN_SELCHANGED:
 		return TreeViewSelectionChanged(hWnd, wMsg, wParam, lParam);
+	case TVN_ITEMEXPANDING:
+		return TreeViewItemExpanding(hWnd, wMsg, wParam, lParam);
+	case TVN_GETDISPINFO:
+		return TreeViewGetDispInfo(hWnd, wMsg, wParam, lParam);
+	}
+
+	return 0;
+}
+
+/**
+ * Process the WM_WORKSPACE_BATCH message for the window.
+ *
+ * @param  hWnd   Window handler.
+ * @param  wMsg   Message type.
+ * @param  wParam Load generation.
+ * @param  lParam Index of the first article in the batch.
+ * @return        0 if everything worked.
+ */
+LRESULT WndMainWorkspaceBatch(HWND hWnd, UINT wMsg, WPARAM wParam,
+							  LPARAM lParam) {
+	LONG nArticles;
+	LONG nLastArticle;
+
+	// Ignore batches from a load that was cancelled.
+	if (!IsCurrentWorkspaceLoad(wParam))
+		return 0;
+
+	// Add the batch to the TreeView.
+	nArticles = GetUkiArticlesAvailable();
+	nLastArticle = (LONG)lParam + WORKSPACE_BATCH_SIZE;
+	if (nLastArticle > nArticles)
+		nLastArticle = nArticles;
+	PatchArticles((LONG)lParam, nLastArticle);
+
+	// Show that things are happening.
+	if (lParam == 0)
+		TreeViewExpandNode(htiArticleLibrary);
+	ShowWorkspaceLoadProgress(nLastArticle, nArticles);
+
+	// Ask for the next batch.
+	AcknowledgeWorkspaceBatch();
+	return 0;
+}
+
+/**
+ * Process the WM_WORKSPACE_LOADED message for the window.
+ *
+ * @param  hWnd   Window handler.
+ * @param  wMsg   Message type.
+ * @param  wParam Load generation.
+ * @param  lParam Message parameter.
+ * @return        0 if everything worked.
+ */
+LRESULT WndMainWorkspaceLoaded(HWND hWnd, UINT wMsg, WPARAM wParam,
+							   LPARAM lParam) {
+	int err;
+
+	// Ignore a load that was cancelled.
+	if (!IsCurrentWorkspaceLoad(wParam))
+		return 0;
+
+	// Check if the engine was initialized.
+	if (!FinishWorkspaceLoad(&err)) {
+		if (err == UKI_OK) {
+			MessageBox(NULL, L"Failed to convert the wiki path from Unicode to "
+				L"ASCII", L"Conversion Error", MB_OK | MB_ICONERROR);
+		} else {
+			ShowUkiErrorDialog(err);
+		}
+
+		CloseWorkspace(FALSE);
+		return 1;
+	}
+
+	// Populate the templates, which are just a handful.
+	PopulateTemplates(htiTemplateLibrary);
+	ShowWorkspaceLoadProgress(0L, 0L);
+
+	// Expand the view.
+	TreeViewExpandNode(htiArticleLibrary);
+	TreeViewExpandNode(htiTemplateLibrary);
+
+	fWorkspaceOpen = TRUE;
+
+	// Open the page that was selected while the workspace was loading.
+	if (fSelectionDeferred && (TreeViewGetSelection() != NULL))
+		OpenTreeViewItem(TreeViewGetSelection());
+	fSelectionDeferred = FALSE;
+
+	// Bring back what wasn't saved when the last session ended.
+	RecoverUnsavedPage();
+
+	return 0;
+}
+
+/**
+ * Process the WM_TIMER message for the window.
+ *
+ * @param  hWnd   Window handler.
+ * @param  wMsg   Message type.
+ * @param  wParam Message parameter.
+ * @param  lParam Message parameter.
+ * @return        0 if everything worked.
+ */
+LRESULT WndMainTimer(HWND hWnd, UINT wMsg, WPARAM wParam,
+					 LPARAM lParam) {
+	switch (wParam) {
+	case IDT_EDITJOURNAL:
+		FlushEditJournal();
+		break;
+	case IDT_PREFETCH:
+		ProcessPrefetch();
+		break;
+	default:
+		return DefWindowProc(hWnd, wMsg, wParam, lParam);
 	}
 
 	return 0;
@@ -756,11 +1396,10 @@ LRESULT WndMainNotify(HWND hWnd, UINT wMsg, WPARAM wParam,
  */
 LRESULT WndMainHibernate(HWND hWnd, UINT wMsg, WPARAM wParam,
 						 LPARAM lParam) {
-	// If we are not the active window, then free the CommandBar to
-	// save memory.
-	if (GetActiveWindow() != hWnd) {
-		CommandBar_Destroy(GetDlgItem(hWnd, IDC_CMDBAR));
-	}
+	// Give back the articles we rendered ahead of time and the images that
+	// aren't being shown.
+	HibernatePrefetch();
+	TrimImageCache();
 
 	return 0;
 }
@@ -822,6 +1461,16 @@ LRESULT WndMainClose(HWND hWnd, UINT wMsg, WPARAM wParam,
  */
 LRESULT WndMainDestroy(HWND hWnd, UINT wMsg, WPARAM wParam,
 					   LPARAM lParam) {
+	// Stop journaling and prefetching.
+	KillTimer(hWnd, IDT_EDITJOURNAL);
+	CancelPrefetch();
+
+	// Free the indices and rendered pages.
+	DestroyWorkspaceSearch();
+	DestroyDependencyIndex();
+	ClearRenderCache();
+	ClearImageCache();
+
 	// Post quit message and return.
 	PostQuitMessage(0);
 	return 0;
@@ -17,6 +17,10 @@
 #define IDC_EDITPAGE 203
 #define IDC_VIEWPAGE 204
 
+// Timers.
+#define IDT_EDITJOURNAL 1
+#define IDT_PREFETCH    2
+
 // CommandBar buttons.
 #define IDC_BTNEW     211
 #define IDC_BTOPEN    212
@@ -39,13 +43,23 @@ int TerminateInstance(HINSTANCE hInstance, int nDefRC);
 
 // Uki workspace.
 BOOL CheckForUnsavedChanges();
+BOOL CheckForWorkspaceLoading();
+BOOL RecoverUnsavedPage();
 LRESULT CloseWorkspace(BOOL fDestroy);
 LRESULT LoadWorkspace(BOOL fReload);
+LRESULT ImportPages(BOOL fIsArticle);
+void ShowWorkspaceLoadProgress(LONG nLoaded, LONG nTotal);
 
 // Control managers.
 LONG PopulateArticles(HTREEITEM htiParent);
+LONG PopulateArticleNode(HTREEITEM htiNode, LONG lNode);
 LONG PopulateTemplates(HTREEITEM htiParent);
+LRESULT PrepareTreeView();
 LRESULT PopulateTreeView();
+LONG PatchArticles(LONG nFirstArticle, LONG nLastArticle);
+LONG PatchTemplates(LONG nFirstTemplate);
+LRESULT PatchTreeView(const UKIREFRESH *lpRefresh);
+LRESULT PatchTreeViewFrom(LONG nFirstArticle, LONG nFirstTemplate);
 
 // Window procedure.
 LRESULT CALLBACK MainWindowProc(HWND hWnd, UINT wMsg, WPARAM wParam,
@@ -54,6 +68,11 @@ LRESULT CALLBACK MainWindowProc(HWND hWnd, UINT wMsg, WPARAM wParam,
 // TreeView message handlers.
 LRESULT TreeViewSelectionChanged(HWND hWnd, UINT wMsg, WPARAM wParam,
 								 LPARAM lParam);
+LRESULT TreeViewItemExpanding(HWND hWnd, UINT wMsg, WPARAM wParam,
+							  LPARAM lParam);
+LRESULT TreeViewGetDispInfo(HWND hWnd, UINT wMsg, WPARAM wParam,
+							LPARAM lParam);
+LRESULT OpenTreeViewItem(HTREEITEM hItem);
 
 // Window message handlers.
 LRESULT WndMainCreate(HWND hWnd, UINT wMsg, WPARAM wParam,
@@ -64,6 +83,12 @@ LRESULT WndMainInitMenuPopUp(HWND hWnd, UINT wMsg, WPARAM wParam,
 							 LPARAM lParam);
 LRESULT WndMainNotify(HWND hWnd, UINT wMsg, WPARAM wParam,
 					  LPARAM lParam);
+LRESULT WndMainWorkspaceBatch(HWND hWnd, UINT wMsg, WPARAM wParam,
+							  LPARAM lParam);
+LRESULT WndMainWorkspaceLoaded(HWND hWnd, UINT wMsg, WPARAM wParam,
+							   LPARAM lParam);
+LRESULT WndMainTimer(HWND hWnd, UINT wMsg, WPARAM wParam,
+					 LPARAM lParam);
 LRESULT WndMainHibernate(HWND hWnd, UINT wMsg, WPARAM wParam,
 						 LPARAM lParam);
 LRESULT WndMainActivate(HWND hWnd, UINT wMsg, WPARAM wParam,
@@ -0,0 +1,404 @@
+/**
+ * WorkspaceIndex.c
+ * Persistent, memory-mapped index of the files in a Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "WorkspaceIndex.h"
+
+// Definitions.
+#define INDEX_MAGIC         0x58494B55  // "UKIX"
+#define INDEX_VERSION       2
+#define INDEX_WRITE_RECORDS 64
+
+// Aligns a byte count to the next 4 byte boundary.
+#define INDEX_ALIGN(n) (((n) + 3) & ~3)
+
+// File header.
+typedef struct {
+	DWORD dwMagic;
+	DWORD dwVersion;
+	DWORD dwFileSize;
+} INDEX_HEADER;
+
+// Header of each snapshot section. Followed by the file records, the folder
+// records, and the string pool.
+typedef struct {
+	DWORD nEntries;
+	DWORD nFolders;
+	DWORD cchPool;
+} INDEX_SECTION;
+
+// A single file or folder record.
+typedef struct {
+	DWORD dwOffset;
+	DWORD dwSize;
+	FILETIME ftModified;
+} INDEX_RECORD;
+
+// Private methods.
+BOOL MapSection(const WORKSPACEINDEX *lpIndex, DWORD *lpdwPos,
+				FOLDERSNAPSHOT *lpSnapshot);
+BOOL CopyRecords(SNAPSHOT_ENTRY **lppEntries, const INDEX_RECORD *lpRecords,
+				 DWORD nRecords, DWORD cchPool);
+DWORD SectionSize(const FOLDERSNAPSHOT *lpSnapshot);
+BOOL WriteSection(HANDLE hFile, const FOLDERSNAPSHOT *lpSnapshot);
+BOOL WriteRecords(HANDLE hFile, const SNAPSHOT_ENTRY *lpEntries,
+				  DWORD nEntries);
+BOOL WriteBlock(HANDLE hFile, LPCVOID lpData, DWORD dwSize);
+
+/**
+ * Initializes an index structure as closed.
+ *
+ * @param lpIndex Index to be initialized.
+ */
+void InitializeWorkspaceIndex(WORKSPACEINDEX *lpIndex) {
+	lpIndex->hFile = INVALID_HANDLE_VALUE;
+	lpIndex->hMapping = NULL;
+	lpIndex->lpView = NULL;
+	lpIndex->dwSize = 0;
+}
+
+/**
+ * Opens a workspace index by mapping it into memory and populates the
+ * snapshots with its contents.
+ * @remark The snapshots use the mapped strings directly, so they must be
+ *         freed before the index gets closed.
+ *
+ * @param  lpIndex     Index structure to hold the mapping.
+ * @param  szIndexPath Path to the index file.
+ * @param  lpArticles  Initialized snapshot to receive the articles folder.
+ * @param  lpTemplates Initialized snapshot to receive the templates folder.
+ * @return             TRUE if the index was valid and could be mapped.
+ */
+BOOL OpenWorkspaceIndex(WORKSPACEINDEX *lpIndex, LPCTSTR szIndexPath,
+						FOLDERSNAPSHOT *lpArticles,
+						FOLDERSNAPSHOT *lpTemplates) {
+	const INDEX_HEADER *lpHeader;
+	DWORD dwPos;
+
+	// Open the file.
+	InitializeWorkspaceIndex(lpIndex);
+#ifdef UNDER_CE
+	lpIndex->hFile = CreateFileForMapping(szIndexPath, GENERIC_READ,
+		FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+#else
+	lpIndex->hFile = CreateFile(szIndexPath, GENERIC_READ, FILE_SHARE_READ,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+#endif
+	if (lpIndex->hFile == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	// Check if it's at least big enough for a header.
+	lpIndex->dwSize = GetFileSize(lpIndex->hFile, NULL);
+	if ((lpIndex->dwSize == 0xFFFFFFFF) ||
+		(lpIndex->dwSize < sizeof(INDEX_HEADER))) {
+		CloseWorkspaceIndex(lpIndex);
+		return FALSE;
+	}
+
+	// Map it into memory.
+	lpIndex->hMapping = CreateFileMapping(lpIndex->hFile, NULL, PAGE_READONLY,
+		0, 0, NULL);
+	if (lpIndex->hMapping == NULL) {
+		CloseWorkspaceIndex(lpIndex);
+		return FALSE;
+	}
+	lpIndex->lpView = (LPBYTE)MapViewOfFile(lpIndex->hMapping, FILE_MAP_READ,
+		0, 0, 0);
+	if (lpIndex->lpView == NULL) {
+		CloseWorkspaceIndex(lpIndex);
+		return FALSE;
+	}
+
+	// Validate the header.
+	lpHeader = (const INDEX_HEADER*)lpIndex->lpView;
+	if ((lpHeader->dwMagic != INDEX_MAGIC) ||
+		(lpHeader->dwVersion != INDEX_VERSION) ||
+		(lpHeader->dwFileSize != lpIndex->dwSize)) {
+		CloseWorkspaceIndex(lpIndex);
+		return FALSE;
+	}
+
+	// Populate the snapshots.
+	dwPos = sizeof(INDEX_HEADER);
+	if (!MapSection(lpIndex, &dwPos, lpArticles) ||
+		!MapSection(lpIndex, &dwPos, lpTemplates)) {
+		FreeFolderSnapshot(lpArticles);
+		FreeFolderSnapshot(lpTemplates);
+		CloseWorkspaceIndex(lpIndex);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Closes a workspace index and unmaps it from memory.
+ *
+ * @param lpIndex Index to be closed.
+ */
+void CloseWorkspaceIndex(WORKSPACEINDEX *lpIndex) {
+	if (lpIndex->lpView != NULL)
+		UnmapViewOfFile(lpIndex->lpView);
+	if (lpIndex->hMapping != NULL)
+		CloseHandle(lpIndex->hMapping);
+
+	// A zeroed structure is also considered closed.
+	if ((lpIndex->hFile != INVALID_HANDLE_VALUE) && (lpIndex->hFile != NULL)) {
+#ifdef UNDER_CE
+		// Windows CE closes the file handle along with its mapping object.
+		if (lpIndex->hMapping == NULL)
+			CloseHandle(lpIndex->hFile);
+#else
+		CloseHandle(lpIndex->hFile);
+#endif
+	}
+
+	InitializeWorkspaceIndex(lpIndex);
+}
+
+/**
+ * Saves the snapshots of a workspace to an index file.
+ * @remark Make sure the index isn't open when saving over it.
+ *
+ * @param  szIndexPath Path to the index file.
+ * @param  lpArticles  Snapshot of the articles folder.
+ * @param  lpTemplates Snapshot of the templates folder.
+ * @return             TRUE if the operation was successful.
+ */
+BOOL SaveWorkspaceIndex(LPCTSTR szIndexPath, const FOLDERSNAPSHOT *lpArticles,
+						const FOLDERSNAPSHOT *lpTemplates) {
+	INDEX_HEADER ihHeader;
+	HANDLE hFile;
+	BOOL bSuccess;
+
+	// Populate the header.
+	ihHeader.dwMagic = INDEX_MAGIC;
+	ihHeader.dwVersion = INDEX_VERSION;
+	ihHeader.dwFileSize = sizeof(INDEX_HEADER) + SectionSize(lpArticles) +
+		SectionSize(lpTemplates);
+
+	// Open the file for writing.
+	hFile = CreateFile(szIndexPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	// Write everything.
+	bSuccess = WriteBlock(hFile, &ihHeader, sizeof(INDEX_HEADER)) &&
+		WriteSection(hFile, lpArticles) && WriteSection(hFile, lpTemplates);
+
+	// Clean up and make sure we never leave a broken index behind.
+	CloseHandle(hFile);
+	if (!bSuccess)
+		DeleteFile(szIndexPath);
+
+	return bSuccess;
+}
+
+/**
+ * Populates a snapshot from a section of the mapped index.
+ *
+ * @param  lpIndex    Mapped index.
+ * @param  lpdwPos    Position of the section. Moved past it on return.
+ * @param  lpSnapshot Snapshot to be populated.
+ * @return            TRUE if the section was valid.
+ */
+BOOL MapSection(const WORKSPACEINDEX *lpIndex, DWORD *lpdwPos,
+				FOLDERSNAPSHOT *lpSnapshot) {
+	const INDEX_SECTION *lpSection;
+	const INDEX_RECORD *lpRecords;
+	DWORD dwRecordsSize;
+	DWORD dwPoolSize;
+	LPTSTR szPool;
+
+	// Get the section header.
+	if ((*lpdwPos + sizeof(INDEX_SECTION)) > lpIndex->dwSize)
+		return FALSE;
+	lpSection = (const INDEX_SECTION*)(lpIndex->lpView + *lpdwPos);
+	*lpdwPos += sizeof(INDEX_SECTION);
+
+	// Check if the sizes make sense.
+	if ((lpSection->nEntries > lpIndex->dwSize) ||
+		(lpSection->nFolders > lpIndex->dwSize) ||
+		(lpSection->cchPool > lpIndex->dwSize)) {
+		return FALSE;
+	}
+	dwRecordsSize = (lpSection->nEntries + lpSection->nFolders) *
+		sizeof(INDEX_RECORD);
+	dwPoolSize = INDEX_ALIGN(lpSection->cchPool * sizeof(TCHAR));
+	if ((*lpdwPos + dwRecordsSize + dwPoolSize) > lpIndex->dwSize)
+		return FALSE;
+
+	// The pool must be terminated so that a bad offset can't run away.
+	lpRecords = (const INDEX_RECORD*)(lpIndex->lpView + *lpdwPos);
+	szPool = (LPTSTR)(lpIndex->lpView + *lpdwPos + dwRecordsSize);
+	if ((lpSection->cchPool == 0) ||
+		(szPool[lpSection->cchPool - 1] != L'\0')) {
+		return FALSE;
+	}
+
+	// Copy the records.
+	if (!CopyRecords(&lpSnapshot->lpEntries, lpRecords, lpSection->nEntries,
+			lpSection->cchPool)) {
+		return FALSE;
+	}
+	lpSnapshot->nEntries = lpSection->nEntries;
+	lpSnapshot->nCapacity = lpSection->nEntries;
+	if (!CopyRecords(&lpSnapshot->lpFolders, lpRecords + lpSection->nEntries,
+			lpSection->nFolders, lpSection->cchPool)) {
+		return FALSE;
+	}
+	lpSnapshot->nFolders = lpSection->nFolders;
+	lpSnapshot->nFolderCapacity = lpSection->nFolders;
+
+	// Use the strings straight from the mapping.
+	lpSnapshot->szPool = szPool;
+	lpSnapshot->cchPool = lpSection->cchPool;
+	lpSnapshot->cchPoolCapacity = lpSection->cchPool;
+	lpSnapshot->fBorrowedPool = TRUE;
+	ResolveSnapshotPaths(lpSnapshot);
+
+	*lpdwPos += dwRecordsSize + dwPoolSize;
+	return TRUE;
+}
+
+/**
+ * Copies index records into a newly allocated snapshot entries array.
+ *
+ * @param  lppEntries Pointer to receive the allocated array.
+ * @param  lpRecords  Records in the index.
+ * @param  nRecords   Number of records.
+ * @param  cchPool    Size of the string pool the records point into.
+ * @return            TRUE if all of the records were valid.
+ */
+BOOL CopyRecords(SNAPSHOT_ENTRY **lppEntries, const INDEX_RECORD *lpRecords,
+				 DWORD nRecords, DWORD cchPool) {
+	SNAPSHOT_ENTRY *lpEntries;
+	DWORD iRecord;
+
+	// Check if there's anything to copy.
+	*lppEntries = NULL;
+	if (nRecords == 0)
+		return TRUE;
+
+	// Allocate the array.
+	lpEntries = (SNAPSHOT_ENTRY*)LocalAlloc(LMEM_FIXED,
+		nRecords * sizeof(SNAPSHOT_ENTRY));
+	if (lpEntries == NULL)
+		return FALSE;
+	*lppEntries = lpEntries;
+
+	// Copy the records.
+	for (iRecord = 0; iRecord < nRecords; iRecord++) {
+		if (lpRecords[iRecord].dwOffset >= cchPool)
+			return FALSE;
+
+		lpEntries[iRecord].szPath = NULL;
+		lpEntries[iRecord].dwOffset = lpRecords[iRecord].dwOffset;
+		lpEntries[iRecord].dwSize = lpRecords[iRecord].dwSize;
+		lpEntries[iRecord].ftModified = lpRecords[iRecord].ftModified;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Calculates the size a snapshot will take in the index file.
+ *
+ * @param  lpSnapshot Snapshot.
+ * @return            Size of the section in bytes.
+ */
+DWORD SectionSize(const FOLDERSNAPSHOT *lpSnapshot) {
+	return sizeof(INDEX_SECTION) + ((lpSnapshot->nEntries +
+		lpSnapshot->nFolders) * sizeof(INDEX_RECORD)) +
+		INDEX_ALIGN(lpSnapshot->cchPool * sizeof(TCHAR));
+}
+
+/**
+ * Writes a snapshot section to the index file.
+ *
+ * @param  hFile      Index file handle.
+ * @param  lpSnapshot Snapshot to be written.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL WriteSection(HANDLE hFile, const FOLDERSNAPSHOT *lpSnapshot) {
+	INDEX_SECTION isSection;
+	DWORD dwPadding = 0;
+	DWORD dwPoolSize;
+
+	// Write the section header.
+	isSection.nEntries = lpSnapshot->nEntries;
+	isSection.nFolders = lpSnapshot->nFolders;
+	isSection.cchPool = lpSnapshot->cchPool;
+	if (!WriteBlock(hFile, &isSection, sizeof(INDEX_SECTION)))
+		return FALSE;
+
+	// Write the records.
+	if (!WriteRecords(hFile, lpSnapshot->lpEntries, lpSnapshot->nEntries) ||
+		!WriteRecords(hFile, lpSnapshot->lpFolders, lpSnapshot->nFolders)) {
+		return FALSE;
+	}
+
+	// Write the string pool and align it.
+	dwPoolSize = lpSnapshot->cchPool * sizeof(TCHAR);
+	if (!WriteBlock(hFile, lpSnapshot->szPool, dwPoolSize))
+		return FALSE;
+
+	return WriteBlock(hFile, &dwPadding, INDEX_ALIGN(dwPoolSize) - dwPoolSize);
+}
+
+/**
+ * Writes snapshot entries as index records in batches.
+ *
+ * @param  hFile     Index file handle.
+ * @param  lpEntries Entries to be written.
+ * @param  nEntries  Number of entries.
+ * @return           TRUE if the operation was successful.
+ */
+BOOL WriteRecords(HANDLE hFile, const SNAPSHOT_ENTRY *lpEntries,
+				  DWORD nEntries) {
+	INDEX_RECORD irBatch[INDEX_WRITE_RECORDS];
+	DWORD iEntry;
+	DWORD nBatch = 0;
+
+	for (iEntry = 0; iEntry < nEntries; iEntry++) {
+		// Convert the entry.
+		irBatch[nBatch].dwOffset = lpEntries[iEntry].dwOffset;
+		irBatch[nBatch].dwSize = lpEntries[iEntry].dwSize;
+		irBatch[nBatch].ftModified = lpEntries[iEntry].ftModified;
+		nBatch++;
+
+		// Flush the batch when it's full.
+		if (nBatch == INDEX_WRITE_RECORDS) {
+			if (!WriteBlock(hFile, irBatch, nBatch * sizeof(INDEX_RECORD)))
+				return FALSE;
+			nBatch = 0;
+		}
+	}
+
+	return WriteBlock(hFile, irBatch, nBatch * sizeof(INDEX_RECORD));
+}
+
+/**
+ * Writes a block of data to a file making sure everything got written.
+ *
+ * @param  hFile  File handle.
+ * @param  lpData Data to be written.
+ * @param  dwSize Size of the data in bytes.
+ * @return        TRUE if the operation was successful.
+ */
+BOOL WriteBlock(HANDLE hFile, LPCVOID lpData, DWORD dwSize) {
+	DWORD dwWritten;
+
+	if (dwSize == 0)
+		return TRUE;
+
+	if (!WriteFile(hFile, lpData, dwSize, &dwWritten, NULL))
+		return FALSE;
+
+	return dwWritten == dwSize;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+/**
+ * WorkspaceIndex.h
+ * Persistent, memory-mapped index of the files in a Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _WORKSPACEINDEX_H
+#define _WORKSPACEINDEX_H
+
+#include <windows.h>
+#include "FolderSnapshot.h"
+
+// Name of the index file that lives next to the manifest.
+#define WORKSPACE_INDEX_FILE L"MANIFEST.idx"
+
+// An open workspace index.
+typedef struct {
+	HANDLE hFile;
+	HANDLE hMapping;
+	LPBYTE lpView;
+	DWORD dwSize;
+} WORKSPACEINDEX;
+
+// Opening and closing.
+void InitializeWorkspaceIndex(WORKSPACEINDEX *lpIndex);
+BOOL OpenWorkspaceIndex(WORKSPACEINDEX *lpIndex, LPCTSTR szIndexPath,
+						FOLDERSNAPSHOT *lpArticles,
+						FOLDERSNAPSHOT *lpTemplates);
+void CloseWorkspaceIndex(WORKSPACEINDEX *lpIndex);
+
+// Saving.
+BOOL SaveWorkspaceIndex(LPCTSTR szIndexPath, const FOLDERSNAPSHOT *lpArticles,
+						const FOLDERSNAPSHOT *lpTemplates);
+
+#endif  // _WORKSPACEINDEX_H
\ No newline at end of file
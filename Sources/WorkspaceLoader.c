@@ -0,0 +1,203 @@
+/**
+ * WorkspaceLoader.c
+ * Loads a Uki workspace on a worker thread and streams its articles to the
+ * main window in batches.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "WorkspaceLoader.h"
+#include "UkiHelper.h"
+#include "WorkspaceSearch.h"
+#include "DependencyIndex.h"
+
+// Global variables.
+HANDLE hLoadThread = NULL;
+HANDLE hCancelEvent = NULL;
+HANDLE hBatchAckEvent = NULL;
+HWND hwndLoadNotify;
+DWORD dwLoadGeneration = 0;
+TCHAR szLoadPath[UKI_MAX_PATH];
+BOOL fLoadSuccess;
+int nLoadError;
+
+// Private methods.
+DWORD WINAPI WorkspaceLoadThread(LPVOID lpParam);
+void CloseWorkspaceLoadHandles();
+
+/**
+ * Starts loading a workspace in the background. The engine must be closed
+ * before calling this.
+ *
+ * @param  hwndNotify Window that will receive the load messages.
+ * @param  szWikiPath Path to the root of the Uki wiki.
+ * @return            TRUE if the worker thread was started.
+ */
+BOOL StartWorkspaceLoad(HWND hwndNotify, LPCTSTR szWikiPath) {
+	DWORD dwThreadID;
+
+	// Make sure there's only one load going on.
+	CancelWorkspaceLoad();
+
+	// Set up the load.
+	wcscpy(szLoadPath, szWikiPath);
+	hwndLoadNotify = hwndNotify;
+	fLoadSuccess = FALSE;
+	nLoadError = UKI_OK;
+	dwLoadGeneration++;
+
+	// Create the synchronization events.
+	hCancelEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	hBatchAckEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if ((hCancelEvent == NULL) || (hBatchAckEvent == NULL)) {
+		CloseWorkspaceLoadHandles();
+		return FALSE;
+	}
+
+	// Start the worker.
+	hLoadThread = CreateThread(NULL, 0, WorkspaceLoadThread,
+		(LPVOID)dwLoadGeneration, 0, &dwThreadID);
+	if (hLoadThread == NULL) {
+		CloseWorkspaceLoadHandles();
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Lets the worker thread know that the last batch was processed and it can
+ * post the next one.
+ */
+void AcknowledgeWorkspaceBatch() {
+	if (hBatchAckEvent != NULL)
+		SetEvent(hBatchAckEvent);
+}
+
+/**
+ * Finishes a load after WM_WORKSPACE_LOADED was received.
+ *
+ * @param  lpnError Engine error code or UKI_OK if the path couldn't be
+ *                  converted to ASCII.
+ * @return          TRUE if the workspace was loaded.
+ */
+BOOL FinishWorkspaceLoad(int *lpnError) {
+	// The worker is about to exit, so wait for it.
+	if (hLoadThread != NULL)
+		WaitForSingleObject(hLoadThread, INFINITE);
+	CloseWorkspaceLoadHandles();
+
+	*lpnError = nLoadError;
+	return fLoadSuccess;
+}
+
+/**
+ * Cancels the load in progress, if any, and waits for the worker to exit.
+ * @remark The engine can't be interrupted while it's scanning the workspace,
+ *         so this only returns after the scan is done. The caller is
+ *         responsible for closing the engine afterwards.
+ */
+void CancelWorkspaceLoad() {
+	// Check if there's anything to be done.
+	if (hLoadThread == NULL)
+		return;
+
+	// Signal the worker and wait for it.
+	SetEvent(hCancelEvent);
+	WaitForSingleObject(hLoadThread, INFINITE);
+	CloseWorkspaceLoadHandles();
+
+	// Make sure any messages still in the queue get ignored.
+	dwLoadGeneration++;
+}
+
+/**
+ * Checks if a workspace is being loaded.
+ *
+ * @return TRUE if the worker thread is running.
+ */
+BOOL IsWorkspaceLoading() {
+	return hLoadThread != NULL;
+}
+
+/**
+ * Checks if a load message belongs to the current load.
+ *
+ * @param  wParam wParam of the load message.
+ * @return        TRUE if the message should be processed.
+ */
+BOOL IsCurrentWorkspaceLoad(WPARAM wParam) {
+	return (hLoadThread != NULL) && ((DWORD)wParam == dwLoadGeneration);
+}
+
+/**
+ * Worker thread that initializes the engine, posts the articles in batches, and
+ * builds the search and dependency indices. Each batch is only posted after
+ * the previous one was acknowledged, so that the message queue never gets
+ * flooded and user input is still processed. The engine isn't safe to render
+ * from while this reads it, so the window holds off opening pages until
+ * WM_WORKSPACE_LOADED arrives.
+ *
+ * @param  lpParam Generation of this load.
+ * @return         Always 0.
+ */
+DWORD WINAPI WorkspaceLoadThread(LPVOID lpParam) {
+	HANDLE ahEvents[2];
+	WPARAM wGeneration;
+	LONG nArticles;
+	LONG iFirst;
+
+	// Initialize the engine, which is the bulk of the work.
+	wGeneration = (WPARAM)lpParam;
+	fLoadSuccess = InitializeUkiEngine(szLoadPath, &nLoadError);
+	if (WaitForSingleObject(hCancelEvent, 0) == WAIT_OBJECT_0)
+		return 0;
+
+	// Stream the articles to the window.
+	if (fLoadSuccess) {
+		ahEvents[0] = hCancelEvent;
+		ahEvents[1] = hBatchAckEvent;
+		nArticles = GetUkiArticlesAvailable();
+
+		for (iFirst = 0L; iFirst < nArticles; iFirst += WORKSPACE_BATCH_SIZE) {
+			PostMessage(hwndLoadNotify, WM_WORKSPACE_BATCH, wGeneration,
+				(LPARAM)iFirst);
+
+			// Wait for the window to process the batch.
+			if (WaitForMultipleObjects(2, ahEvents, FALSE, INFINITE) !=
+					(WAIT_OBJECT_0 + 1)) {
+				return 0;
+			}
+		}
+
+		// Index the text of every page for workspace searches, and with it which
+		// articles use each template and variable.
+		if (!BuildWorkspaceSearch(hCancelEvent))
+			return 0;
+		BuildDependencyIndex();
+	}
+
+	// Let the window know we are done.
+	PostMessage(hwndLoadNotify, WM_WORKSPACE_LOADED, wGeneration, 0);
+	return 0;
+}
+
+/**
+ * Closes the worker thread and event handles.
+ */
+void CloseWorkspaceLoadHandles() {
+	if (hLoadThread != NULL) {
+		CloseHandle(hLoadThread);
+		hLoadThread = NULL;
+	}
+
+	if (hCancelEvent != NULL) {
+		CloseHandle(hCancelEvent);
+		hCancelEvent = NULL;
+	}
+
+	if (hBatchAckEvent != NULL) {
+		CloseHandle(hBatchAckEvent);
+		hBatchAckEvent = NULL;
+	}
+}
\ No newline at end of file
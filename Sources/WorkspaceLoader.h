@@ -0,0 +1,32 @@
+/**
+ * WorkspaceLoader.h
+ * Loads a Uki workspace on a worker thread and streams its articles to the
+ * main window in batches.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _WORKSPACELOADER_H
+#define _WORKSPACELOADER_H
+
+#include <windows.h>
+
+// Messages posted to the notification window. wParam is always the load
+// generation, for WM_WORKSPACE_BATCH lParam is the first article index.
+#define WM_WORKSPACE_BATCH  (WM_APP + 1)
+#define WM_WORKSPACE_LOADED (WM_APP + 2)
+
+// Number of articles in each batch.
+#define WORKSPACE_BATCH_SIZE 256L
+
+// Loading.
+BOOL StartWorkspaceLoad(HWND hwndNotify, LPCTSTR szWikiPath);
+void AcknowledgeWorkspaceBatch();
+BOOL FinishWorkspaceLoad(int *lpnError);
+void CancelWorkspaceLoad();
+
+// State.
+BOOL IsWorkspaceLoading();
+BOOL IsCurrentWorkspaceLoad(WPARAM wParam);
+
+#endif  // _WORKSPACELOADER_H
\ No newline at end of file
@@ -0,0 +1,338 @@
+/**
+ * WorkspaceReplace.c
+ * Find and replace across every article in the Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "WorkspaceReplace.h"
+#include "UkiHelper.h"
+#include "Utilities.h"
+#include "WorkspaceSearch.h"
+#include "DependencyIndex.h"
+
+// Definitions.
+#define WSREPLACE_MAX_WORKERS 4
+#define WSREPLACE_FAILED      -1L
+
+// Work shared between all of the replace threads.
+typedef struct {
+	LPCTSTR szNeedle;
+	size_t cchNeedle;
+	const REGEX *lpRegex;
+	LPCTSTR szReplacement;
+	size_t cchReplacement;
+	BOOL fMatchCase;
+	BOOL fDryRun;
+	LONG nArticles;
+	LONG nNextArticle;
+	LONG *lpnReplaced;
+} WSREPLACE_JOB;
+
+// Private methods.
+DWORD WINAPI WorkspaceReplaceThread(LPVOID lpParam);
+LONG ReplaceInArticle(WSREPLACE_JOB *lpJob, LONG nArticle);
+char *ConvertArticleText(LPCTSTR szText, DWORD cchText,
+						 const TXTSRCH_REPLACE *lpReplace, DWORD *lpcbText);
+BOOL BuildReplaceReport(const WSREPLACE_JOB *lpJob,
+						WSREPLACE_REPORT *lpReport);
+
+/**
+ * Replaces every occurrence of a needle in all of the articles of the
+ * workspace. The articles are shared between a small pool of threads and each
+ * changed file is written atomically. The workspace must not be reloaded
+ * while this runs, which is why it blocks the caller until it's done instead
+ * of running in the background. Templates are never touched.
+ * @remark Remember to free the report with FreeWorkspaceReplaceReport.
+ *
+ * @param  szNeedle      Text to search for.
+ * @param  lpRegex       Compiled regular expression to search for instead of
+ *                       the plain needle or NULL.
+ * @param  szReplacement Text to put in place of each match. Used as an
+ *                       expansion template when searching with lpRegex.
+ * @param  fMatchCase    Should the case of the needle be matched?
+ * @param  fDryRun       Only count what would be replaced without writing
+ *                       anything.
+ * @param  lpReport      Report to receive the replacements made per article.
+ * @return               TRUE if the operation was successful.
+ */
+BOOL ReplaceInWorkspace(LPCTSTR szNeedle, const REGEX *lpRegex,
+						LPCTSTR szReplacement, BOOL fMatchCase, BOOL fDryRun,
+						WSREPLACE_REPORT *lpReport) {
+	HANDLE ahWorkers[WSREPLACE_MAX_WORKERS];
+	WSREPLACE_JOB wrJob;
+	SYSTEM_INFO siSystem;
+	DWORD dwThreadID;
+	DWORD nWorkers;
+	DWORD iWorker;
+	LONG nArticle;
+	BOOL bSuccess;
+
+	// Start with an empty report.
+	lpReport->lpFiles = NULL;
+	lpReport->nFiles = 0;
+	lpReport->nReplaced = 0;
+	lpReport->nFailed = 0;
+
+	// Set up the job.
+	wrJob.szNeedle = szNeedle;
+	wrJob.cchNeedle = wcslen(szNeedle);
+	wrJob.lpRegex = lpRegex;
+	wrJob.szReplacement = szReplacement;
+	wrJob.cchReplacement = wcslen(szReplacement);
+	wrJob.fMatchCase = fMatchCase;
+	wrJob.fDryRun = fDryRun;
+	wrJob.nArticles = GetUkiArticlesAvailable();
+	wrJob.nNextArticle = 0;
+	if ((wrJob.nArticles <= 0) || ((lpRegex == NULL) && (wrJob.cchNeedle == 0)))
+		return TRUE;
+	wrJob.lpnReplaced = (LONG*)LocalAlloc(LMEM_FIXED,
+		wrJob.nArticles * sizeof(LONG));
+	if (wrJob.lpnReplaced == NULL)
+		return FALSE;
+
+	// One thread per processor, plus another to keep them busy while the
+	// others wait on the disk. The calling thread is one of them.
+	GetSystemInfo(&siSystem);
+	nWorkers = siSystem.dwNumberOfProcessors;
+	if (nWorkers >= WSREPLACE_MAX_WORKERS)
+		nWorkers = WSREPLACE_MAX_WORKERS - 1;
+	if (nWorkers >= (DWORD)wrJob.nArticles)
+		nWorkers = (DWORD)wrJob.nArticles - 1;
+
+	// Fan out the articles and pitch in until they've all been taken.
+	for (iWorker = 0; iWorker < nWorkers; iWorker++) {
+		ahWorkers[iWorker] = CreateThread(NULL, 0, WorkspaceReplaceThread,
+			(LPVOID)&wrJob, 0, &dwThreadID);
+		if (ahWorkers[iWorker] == NULL)
+			break;
+	}
+	nWorkers = iWorker;
+	WorkspaceReplaceThread((LPVOID)&wrJob);
+
+	// Wait for the others to finish their last articles.
+	if (nWorkers > 0) {
+		WaitForMultipleObjects(nWorkers, ahWorkers, TRUE, INFINITE);
+		for (iWorker = 0; iWorker < nWorkers; iWorker++)
+			CloseHandle(ahWorkers[iWorker]);
+	}
+
+	// Changed articles may change what they depend on.
+	if (!fDryRun && IsDependencyIndexReady()) {
+		for (nArticle = 0L; nArticle < wrJob.nArticles; nArticle++) {
+			if (wrJob.lpnReplaced[nArticle] > 0L)
+				UpdateArticleDependencies(nArticle);
+		}
+	}
+
+	// Put together the report.
+	bSuccess = BuildReplaceReport(&wrJob, lpReport);
+	LocalFree(wrJob.lpnReplaced);
+
+	return bSuccess;
+}
+
+/**
+ * Frees everything allocated for a workspace replace report.
+ *
+ * @param lpReport Report to be freed.
+ */
+void FreeWorkspaceReplaceReport(WSREPLACE_REPORT *lpReport) {
+	if (lpReport->lpFiles != NULL)
+		LocalFree(lpReport->lpFiles);
+
+	lpReport->lpFiles = NULL;
+	lpReport->nFiles = 0;
+	lpReport->nReplaced = 0;
+	lpReport->nFailed = 0;
+}
+
+/**
+ * Takes articles from the shared job and replaces in them until there are
+ * none left.
+ *
+ * @param  lpParam Pointer to the shared job.
+ * @return         Always 0.
+ */
+DWORD WINAPI WorkspaceReplaceThread(LPVOID lpParam) {
+	WSREPLACE_JOB *lpJob = (WSREPLACE_JOB*)lpParam;
+	LONG nArticle;
+
+	nArticle = InterlockedIncrement(&lpJob->nNextArticle) - 1;
+	while (nArticle < lpJob->nArticles) {
+		lpJob->lpnReplaced[nArticle] = ReplaceInArticle(lpJob, nArticle);
+		nArticle = InterlockedIncrement(&lpJob->nNextArticle) - 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Replaces every occurrence of the needle in a single article.
+ *
+ * @param  lpJob    Shared job with what to replace.
+ * @param  nArticle Index of the article.
+ * @return          Number of replacements made or WSREPLACE_FAILED.
+ */
+LONG ReplaceInArticle(WSREPLACE_JOB *lpJob, LONG nArticle) {
+	TXTSRCH_REPLACE trReplace;
+	LPCTSTR szPath;
+	LPTSTR szText;
+	char *szaText;
+	DWORD cchText;
+	DWORD cbText;
+	long nReplaced;
+
+	// Get the article contents.
+	szPath = GetUkiArticleFilePath(nArticle);
+	if ((szPath == NULL) || !ReadFileText(szPath, &szText, &cchText))
+		return WSREPLACE_FAILED;
+
+	// Replace everything in a single pass over the whole text, since a
+	// regular expression match can be of any length and span any chunk
+	// boundary a streamed read would have.
+	if (lpJob->lpRegex != NULL) {
+		nReplaced = RegexReplaceAll(lpJob->lpRegex, szText, cchText, 0,
+			lpJob->szReplacement, lpJob->cchReplacement, &trReplace);
+	} else {
+		nReplaced = TextSearchReplaceAll(szText, cchText, 0, lpJob->szNeedle,
+			lpJob->cchNeedle, lpJob->szReplacement, lpJob->cchReplacement,
+			lpJob->fMatchCase, &trReplace);
+	}
+	if (nReplaced <= 0) {
+		LocalFree(szText);
+		return (nReplaced < 0) ? WSREPLACE_FAILED : 0;
+	}
+
+	// Write the changes and index the text that was written, instead of
+	// reading it back from the disk.
+	if (!lpJob->fDryRun) {
+		szaText = ConvertArticleText(szText, cchText, &trReplace, &cbText);
+		if ((szaText != NULL) && WriteFileAtomically(szPath, szaText, cbText)) {
+			UpdateWorkspaceSearchBytes(TXTIDX_ARTICLE, nArticle, szaText,
+				cbText);
+		} else {
+			nReplaced = WSREPLACE_FAILED;
+		}
+
+		if (szaText != NULL)
+			LocalFree(szaText);
+	}
+
+	// Clean up.
+	TextSearchFreeReplace(&trReplace);
+	LocalFree(szText);
+
+	return (LONG)nReplaced;
+}
+
+/**
+ * Converts the text of an article with a replacement applied to it into the
+ * encoding of the files. The parts before and after the replaced range are
+ * converted straight from the original text, so the new text never needs to
+ * be put together in memory.
+ * @remark Remember to free the returned buffer with LocalFree.
+ *
+ * @param  szText    Original text of the article.
+ * @param  cchText   Length of the original text.
+ * @param  lpReplace Replacement to apply to the text.
+ * @param  lpcbText  Length of the converted text in bytes.
+ * @return           Converted text or NULL if the operation failed.
+ */
+char *ConvertArticleText(LPCTSTR szText, DWORD cchText,
+						 const TXTSRCH_REPLACE *lpReplace, DWORD *lpcbText) {
+	LPCTSTR aszParts[3];
+	int acchParts[3];
+	int acbParts[3];
+	char *szaBuffer;
+	int cbBuffer;
+	int cbOffset;
+	int iPart;
+
+	// Split the new text into its parts.
+	aszParts[0] = szText;
+	acchParts[0] = (int)lpReplace->nStart;
+	aszParts[1] = lpReplace->szResult;
+	acchParts[1] = (int)lpReplace->cchResult;
+	aszParts[2] = szText + lpReplace->nEnd;
+	acchParts[2] = (int)(cchText - lpReplace->nEnd);
+
+	// Get the converted length of each part.
+	cbBuffer = 0;
+	for (iPart = 0; iPart < 3; iPart++) {
+		acbParts[iPart] = 0;
+		if (acchParts[iPart] > 0) {
+			acbParts[iPart] = ConvertBufferWtoA(NULL, 0, aszParts[iPart],
+				acchParts[iPart]);
+			if (acbParts[iPart] == 0)
+				return NULL;
+		}
+
+		cbBuffer += acbParts[iPart];
+	}
+
+	// Convert everything into a single buffer.
+	szaBuffer = (char*)LocalAlloc(LMEM_FIXED, cbBuffer + 1);
+	if (szaBuffer == NULL)
+		return NULL;
+	cbOffset = 0;
+	for (iPart = 0; iPart < 3; iPart++) {
+		if ((acbParts[iPart] > 0) && (ConvertBufferWtoA(szaBuffer + cbOffset,
+				acbParts[iPart], aszParts[iPart], acchParts[iPart]) !=
+				acbParts[iPart])) {
+			LocalFree(szaBuffer);
+			return NULL;
+		}
+
+		cbOffset += acbParts[iPart];
+	}
+
+	*lpcbText = (DWORD)cbBuffer;
+	return szaBuffer;
+}
+
+/**
+ * Builds the report of a finished replace job.
+ *
+ * @param  lpJob    Finished job.
+ * @param  lpReport Report to be filled with the articles that had matches or
+ *                  failed.
+ * @return          TRUE if the operation was successful.
+ */
+BOOL BuildReplaceReport(const WSREPLACE_JOB *lpJob,
+						WSREPLACE_REPORT *lpReport) {
+	WSREPLACE_FILE *lpFile;
+	LONG nArticle;
+	LONG nFiles;
+
+	// Count the articles worth reporting.
+	nFiles = 0;
+	for (nArticle = 0; nArticle < lpJob->nArticles; nArticle++) {
+		if (lpJob->lpnReplaced[nArticle] != 0)
+			nFiles++;
+	}
+	if (nFiles == 0)
+		return TRUE;
+
+	// Fill in the report.
+	lpReport->lpFiles = (WSREPLACE_FILE*)LocalAlloc(LMEM_FIXED,
+		nFiles * sizeof(WSREPLACE_FILE));
+	if (lpReport->lpFiles == NULL)
+		return FALSE;
+	for (nArticle = 0; nArticle < lpJob->nArticles; nArticle++) {
+		if (lpJob->lpnReplaced[nArticle] == 0)
+			continue;
+
+		lpFile = lpReport->lpFiles + lpReport->nFiles++;
+		lpFile->nArticle = nArticle;
+		lpFile->fFailed = lpJob->lpnReplaced[nArticle] == WSREPLACE_FAILED;
+		lpFile->nReplaced = lpFile->fFailed ? 0 : lpJob->lpnReplaced[nArticle];
+		if (lpFile->fFailed) {
+			lpReport->nFailed++;
+		} else {
+			lpReport->nReplaced += lpFile->nReplaced;
+		}
+	}
+
+	return TRUE;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+/**
+ * WorkspaceReplace.h
+ * Find and replace across every article in the Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _WORKSPACEREPLACE_H
+#define _WORKSPACEREPLACE_H
+
+#include <windows.h>
+#include "Regex.h"
+
+// Replacements made in a single article.
+typedef struct {
+	LONG nArticle;
+	LONG nReplaced;
+	BOOL fFailed;
+} WSREPLACE_FILE;
+
+// Everything that was done in a workspace replace. Only articles that had
+// matches or failed are listed.
+typedef struct {
+	WSREPLACE_FILE *lpFiles;
+	LONG nFiles;
+	LONG nReplaced;
+	LONG nFailed;
+} WSREPLACE_REPORT;
+
+// Replacing.
+BOOL ReplaceInWorkspace(LPCTSTR szNeedle, const REGEX *lpRegex,
+						LPCTSTR szReplacement, BOOL fMatchCase, BOOL fDryRun,
+						WSREPLACE_REPORT *lpReport);
+void FreeWorkspaceReplaceReport(WSREPLACE_REPORT *lpReport);
+
+#endif  // _WORKSPACEREPLACE_H
\ No newline at end of file
@@ -0,0 +1,319 @@
+/**
+ * WorkspaceSearch.c
+ * Full-text search across all of the pages in the Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "WorkspaceSearch.h"
+#include "UkiHelper.h"
+#include "Utilities.h"
+
+// Definitions.
+#define SEARCH_CANCEL_CHECK 64L
+
+// Global variables.
+TEXTINDEX tiWorkspace;
+CRITICAL_SECTION csWorkspace;
+char *szaReadBuffer = NULL;
+DWORD dwReadBufferSize = 0;
+
+// Private methods.
+BOOL IndexPageFile(int iKind, LONG nPage, LPCTSTR szPath);
+BOOL GetPagePath(LPTSTR szPath, int iKind, LONG nPage);
+
+/**
+ * Initializes the workspace search engine.
+ */
+void InitializeWorkspaceSearch() {
+	InitializeCriticalSection(&csWorkspace);
+	TextIndexInitialize(&tiWorkspace);
+}
+
+/**
+ * Frees everything allocated by the workspace search engine.
+ */
+void DestroyWorkspaceSearch() {
+	TextIndexFree(&tiWorkspace);
+	if (szaReadBuffer != NULL) {
+		LocalFree(szaReadBuffer);
+		szaReadBuffer = NULL;
+		dwReadBufferSize = 0;
+	}
+
+	DeleteCriticalSection(&csWorkspace);
+}
+
+/**
+ * Forgets everything that was indexed.
+ */
+void ClearWorkspaceSearch() {
+	EnterCriticalSection(&csWorkspace);
+	TextIndexFree(&tiWorkspace);
+	TextIndexInitialize(&tiWorkspace);
+	LeaveCriticalSection(&csWorkspace);
+}
+
+/**
+ * Indexes every article and template in the workspace. Safe to be called from
+ * a worker thread as long as the engine isn't changed in the meantime.
+ *
+ * @param  hCancelEvent Event that stops the indexing when signaled.
+ * @return              TRUE if everything was indexed.
+ */
+BOOL BuildWorkspaceSearch(HANDLE hCancelEvent) {
+	TCHAR szPath[UKI_MAX_PATH];
+	LONG anPages[TXTIDX_KINDS];
+	LONG nPage;
+	int iKind;
+
+	// Start from scratch.
+	ClearWorkspaceSearch();
+	anPages[TXTIDX_ARTICLE] = GetUkiArticlesAvailable();
+	anPages[TXTIDX_TEMPLATE] = GetUkiTemplatesAvailable();
+
+	// Go through the pages.
+	for (iKind = 0; iKind < TXTIDX_KINDS; iKind++) {
+		for (nPage = 0L; nPage < anPages[iKind]; nPage++) {
+			// Check if we should stop.
+			if (((nPage % SEARCH_CANCEL_CHECK) == 0L) &&
+					(WaitForSingleObject(hCancelEvent, 0) == WAIT_OBJECT_0)) {
+				return FALSE;
+			}
+
+			// Index the page, ignoring the ones that can't be read.
+			if (GetPagePath(szPath, iKind, nPage))
+				IndexWorkspacePage(iKind, nPage, szPath);
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Indexes a page from its file.
+ *
+ * @param  iKind  Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param  nPage  Index of the page in the Uki engine.
+ * @param  szPath Path to the page file.
+ * @return        TRUE if the page was indexed.
+ */
+BOOL IndexWorkspacePage(int iKind, LONG nPage, LPCTSTR szPath) {
+	BOOL bSuccess;
+
+	// The file is read inside the lock so a save can't sneak in between.
+	EnterCriticalSection(&csWorkspace);
+	bSuccess = IndexPageFile(iKind, nPage, szPath);
+	LeaveCriticalSection(&csWorkspace);
+
+	return bSuccess;
+}
+
+/**
+ * Updates the index of a page with the contents that were just saved.
+ *
+ * @param  iKind      Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param  nPage      Index of the page in the Uki engine.
+ * @param  szContents New contents of the page.
+ * @return            TRUE if the page was indexed.
+ */
+BOOL UpdateWorkspaceSearch(int iKind, LONG nPage, LPCTSTR szContents) {
+	char *szaContents;
+	int nLen;
+	BOOL bSuccess;
+
+	// Check if we know which page this is.
+	if (nPage < 0L)
+		return FALSE;
+
+	// Convert the contents to the same encoding as the files.
+	nLen = ConvertBufferWtoA(NULL, 0, szContents, -1);
+	if (nLen == 0)
+		return FALSE;
+	szaContents = (char*)LocalAlloc(LMEM_FIXED, nLen * sizeof(char));
+	if (szaContents == NULL)
+		return FALSE;
+	ConvertBufferWtoA(szaContents, nLen, szContents, -1);
+
+	// Replace the page in the index.
+	bSuccess = UpdateWorkspaceSearchBytes(iKind, nPage, szaContents,
+		(DWORD)(nLen - 1));
+
+	LocalFree(szaContents);
+	return bSuccess;
+}
+
+/**
+ * Updates the index of a page with contents that were just written and are
+ * already in the same encoding as the files.
+ *
+ * @param  iKind       Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param  nPage       Index of the page in the Uki engine.
+ * @param  szaContents New contents of the page as they are in the file.
+ * @param  cbContents  Length of the contents in bytes.
+ * @return             TRUE if the page was indexed.
+ */
+BOOL UpdateWorkspaceSearchBytes(int iKind, LONG nPage, const char *szaContents,
+								DWORD cbContents) {
+	BOOL bSuccess;
+
+	// Check if we know which page this is.
+	if (nPage < 0L)
+		return FALSE;
+
+	EnterCriticalSection(&csWorkspace);
+	bSuccess = TextIndexSetDocument(&tiWorkspace, iKind, nPage, szaContents,
+		(size_t)cbContents);
+	LeaveCriticalSection(&csWorkspace);
+
+	return bSuccess;
+}
+
+/**
+ * Finds the pages in the workspace that contain all of the words in a query.
+ *
+ * @param  szQuery     Words to look for, case insensitive.
+ * @param  lpMatches   Array to receive the pages found and the character
+ *                     offset of the first query word in each of them.
+ * @param  nMaxMatches Maximum number of matches to return.
+ * @return             Number of matches found.
+ */
+LONG FindInWorkspace(LPCTSTR szQuery, TXTIDX_MATCH *lpMatches,
+					 LONG nMaxMatches) {
+	char szaQuery[UKI_MAX_PATH];
+
+	// Convert the query to the same encoding as the files.
+	if (ConvertBufferWtoA(szaQuery, UKI_MAX_PATH, szQuery, -1) == 0)
+		return 0L;
+
+	return FindWordsInWorkspace(szaQuery, lpMatches, nMaxMatches);
+}
+
+/**
+ * Finds the pages in the workspace that contain all of the words in an ASCII
+ * string, like the name of a page.
+ *
+ * @param  szaWords    Words to look for, case insensitive.
+ * @param  lpMatches   Array to receive the pages found.
+ * @param  nMaxMatches Maximum number of matches to return.
+ * @return             Number of matches found.
+ */
+LONG FindWordsInWorkspace(const char *szaWords, TXTIDX_MATCH *lpMatches,
+						  LONG nMaxMatches) {
+	LONG nMatches;
+
+	EnterCriticalSection(&csWorkspace);
+	nMatches = TextIndexQuery(&tiWorkspace, szaWords, lpMatches, nMaxMatches);
+	LeaveCriticalSection(&csWorkspace);
+
+	return nMatches;
+}
+
+/**
+ * Checks if a single page contains all of the words in an ASCII string, like
+ * the name of another page.
+ *
+ * @param  iKind    Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param  nPage    Index of the page in the Uki engine.
+ * @param  szaWords Words to look for, case insensitive.
+ * @return          TRUE if the page contains every word.
+ */
+BOOL WorkspacePageHasWords(int iKind, LONG nPage, const char *szaWords) {
+	BOOL fHasWords;
+
+	EnterCriticalSection(&csWorkspace);
+	fHasWords = TextIndexPageHasWords(&tiWorkspace, iKind, nPage, szaWords);
+	LeaveCriticalSection(&csWorkspace);
+
+	return fHasWords;
+}
+
+/**
+ * Reads a page file into the shared buffer and indexes it.
+ * @remark Must be called with the critical section held.
+ *
+ * @param  iKind  Kind of the page.
+ * @param  nPage  Index of the page in the Uki engine.
+ * @param  szPath Path to the page file.
+ * @return        TRUE if the page was indexed.
+ */
+BOOL IndexPageFile(int iKind, LONG nPage, LPCTSTR szPath) {
+	HANDLE hFile;
+	DWORD dwFileSize;
+	DWORD dwBytesRead;
+	BOOL bSuccess;
+
+	// Open the file.
+	hFile = CreateFile(szPath, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	// Get the file size.
+	dwFileSize = GetFileSize(hFile, NULL);
+	if (dwFileSize == 0xFFFFFFFF) {
+		CloseHandle(hFile);
+		return FALSE;
+	}
+
+	// Reuse the buffer between files and only grow it when needed.
+	if ((szaReadBuffer == NULL) || (dwFileSize > dwReadBufferSize)) {
+		if (szaReadBuffer != NULL)
+			LocalFree(szaReadBuffer);
+
+		dwReadBufferSize = (dwFileSize > 4096) ? dwFileSize : 4096;
+		szaReadBuffer = (char*)LocalAlloc(LMEM_FIXED, dwReadBufferSize);
+		if (szaReadBuffer == NULL) {
+			dwReadBufferSize = 0;
+			CloseHandle(hFile);
+
+			return FALSE;
+		}
+	}
+
+	// Read and index the file.
+	bSuccess = ReadFile(hFile, szaReadBuffer, dwFileSize, &dwBytesRead, NULL);
+	if (bSuccess) {
+		bSuccess = TextIndexSetDocument(&tiWorkspace, iKind, nPage,
+			szaReadBuffer, (size_t)dwBytesRead);
+	}
+
+	CloseHandle(hFile);
+	return bSuccess;
+}
+
+/**
+ * Gets the file path of a page without showing any errors.
+ *
+ * @param  szPath Pre-allocated buffer to receive the file path.
+ * @param  iKind  Kind of the page.
+ * @param  nPage  Index of the page in the Uki engine.
+ * @return        TRUE if the operation was successful.
+ */
+BOOL GetPagePath(LPTSTR szPath, int iKind, LONG nPage) {
+	char szaPath[UKI_MAX_PATH];
+	LPCTSTR szInterned;
+	int err;
+
+	// Use the interned path if we have it.
+	if (iKind == TXTIDX_ARTICLE) {
+		szInterned = GetUkiArticleFilePath(nPage);
+	} else {
+		szInterned = GetUkiTemplateFilePath(nPage);
+	}
+	if (szInterned != NULL) {
+		wcscpy(szPath, szInterned);
+		return TRUE;
+	}
+
+	// Get the file path from the engine.
+	if (iKind == TXTIDX_ARTICLE) {
+		err = uki_article_fpath(szaPath, uki_article((size_t)nPage));
+	} else {
+		err = uki_template_fpath(szaPath, uki_template((size_t)nPage));
+	}
+	if (err != UKI_OK)
+		return FALSE;
+
+	return ConvertBufferAtoW(szPath, UKI_MAX_PATH, szaPath, -1) != 0;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+/**
+ * WorkspaceSearch.h
+ * Full-text search across all of the pages in the Uki workspace.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _WORKSPACESEARCH_H
+#define _WORKSPACESEARCH_H
+
+#include <windows.h>
+#include "TextIndex.h"
+
+// Initialization and destruction.
+void InitializeWorkspaceSearch();
+void DestroyWorkspaceSearch();
+void ClearWorkspaceSearch();
+
+// Indexing.
+BOOL BuildWorkspaceSearch(HANDLE hCancelEvent);
+BOOL IndexWorkspacePage(int iKind, LONG nPage, LPCTSTR szPath);
+BOOL UpdateWorkspaceSearch(int iKind, LONG nPage, LPCTSTR szContents);
+BOOL UpdateWorkspaceSearchBytes(int iKind, LONG nPage, const char *szaContents,
+								DWORD cbContents);
+
+// Querying.
+LONG FindInWorkspace(LPCTSTR szQuery, TXTIDX_MATCH *lpMatches,
+					 LONG nMaxMatches);
+LONG FindWordsInWorkspace(const char *szaWords, TXTIDX_MATCH *lpMatches,
+						  LONG nMaxMatches);
+BOOL WorkspacePageHasWords(int iKind, LONG nPage, const char *szaWords);
+
+#endif  // _WORKSPACESEARCH_H
\ No newline at end of file
@@ -0,0 +1,78 @@
+/**
+ * ArticleTreeBench.c
+ * Measures how long it takes to build the article tree model of a large
+ * workspace, which is all the work done up front when a workspace is opened.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "TestHelper.h"
+#include "UkiStub.h"
+#include "ArticleTree.h"
+
+// Definitions.
+#define NUM_ARTICLES 100000L
+#define NUM_FOLDERS  1000L
+#define NUM_RUNS     5
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	uki_article_t *lpArticles;
+	ARTICLETREE atTree;
+	char *szaParents;
+	char *szaNames;
+	double dBest;
+	double dTime;
+	long i;
+	int iRun;
+
+	// Articles come grouped by folder, with every seventh one in the root.
+	lpArticles = (uki_article_t*)malloc(NUM_ARTICLES * sizeof(uki_article_t));
+	szaParents = (char*)malloc(NUM_FOLDERS * 32);
+	szaNames = (char*)malloc(NUM_ARTICLES * 16);
+	for (i = 0L; i < NUM_FOLDERS; i++)
+		sprintf(szaParents + (i * 32), "dir%ld/sub%ld", i % 50L, i);
+	for (i = 0L; i < NUM_ARTICLES; i++) {
+		sprintf(szaNames + (i * 16), "art%ld", i);
+		lpArticles[i].path = NULL;
+		lpArticles[i].name = szaNames + (i * 16);
+		lpArticles[i].parent = ((i % 7L) == 0L) ? NULL :
+			szaParents + ((i / (NUM_ARTICLES / NUM_FOLDERS)) * 32);
+		lpArticles[i].deepness = 2;
+	}
+	UkiStubSetArticles(lpArticles, NUM_ARTICLES);
+
+	// Keep the best of a few runs.
+	dBest = 0.0;
+	for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+		dTime = TestMilliseconds();
+		ArticleTreeInitialize(&atTree);
+		ArticleTreeBuildFromUki(&atTree);
+		dTime = TestMilliseconds() - dTime;
+
+		if ((iRun == 0) || (dTime < dBest))
+			dBest = dTime;
+		if (iRun < (NUM_RUNS - 1))
+			ArticleTreeFree(&atTree);
+	}
+
+	printf("%ld articles in %ld folders: %ld nodes built in %.2f ms\n",
+		   atTree.nArticles, NUM_FOLDERS, atTree.nNodes, dBest);
+	printf("root shows %ld items, the first folder %ld\n",
+		   ArticleTreeGetNode(&atTree, ARTTREE_ROOT)->nChildren,
+		   ArticleTreeGetNode(&atTree, ArticleTreeGetNode(&atTree,
+				ARTTREE_ROOT)->lFirstFolder)->nChildren);
+
+	ArticleTreeFree(&atTree);
+	free(lpArticles);
+	free(szaParents);
+	free(szaNames);
+
+	return 0;
+}
\ No newline at end of file
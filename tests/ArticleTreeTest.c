@@ -0,0 +1,174 @@
+/**
+ * ArticleTreeTest.c
+ * Checks the article tree model: folder resolution, ordering, names and the
+ * sibling lookup used for prefetching.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "UkiStub.h"
+#include "ArticleTree.h"
+
+// Articles of the workspace, in the order the engine lists them.
+uki_article_t aArticles[] = {
+	{ "index.html", "index", NULL, 0 },
+	{ "a/one.html", "one", "a", 1 },
+	{ "a/two.html", "two", "a", 1 },
+	{ "a/b/deep.html", "deep", "a/b", 2 },
+	{ "about.html", "about", "", 0 },
+	{ "a/three.html", "three", "a", 1 },
+	{ "a/b/deeper.html", "deeper", "a\\b", 2 },
+	{ "c/d/e/far.html", "far", "c//d/e/", 3 }
+};
+
+// Private methods.
+long FindChild(const ARTICLETREE *atTree, long lFolder, const char *szaName);
+void CheckStructure(const ARTICLETREE *atTree);
+void CheckSiblings(const ARTICLETREE *atTree);
+void CheckState(ARTICLETREE *atTree);
+
+/**
+ * Finds a child of a folder by its name.
+ *
+ * @param  atTree  Article tree.
+ * @param  lFolder Folder to look in.
+ * @param  szaName Name of the child.
+ * @return         Index of the child node or ARTTREE_NONE if there's none.
+ */
+long FindChild(const ARTICLETREE *atTree, long lFolder, const char *szaName) {
+	char szaNodeName[64];
+	long lChild;
+
+	lChild = ArticleTreeGetNode(atTree, lFolder)->lFirstChild;
+	while (lChild != ARTTREE_NONE) {
+		ArticleTreeGetName(atTree, lChild, szaNodeName, sizeof(szaNodeName));
+		if (strcmp(szaNodeName, szaName) == 0)
+			return lChild;
+
+		lChild = ArticleTreeGetNode(atTree, lChild)->lNextSibling;
+	}
+
+	return ARTTREE_NONE;
+}
+
+/**
+ * Checks that folders are created once and children keep the engine's order.
+ *
+ * @param atTree Article tree built from aArticles.
+ */
+void CheckStructure(const ARTICLETREE *atTree) {
+	const ARTTREE_NODE *lpRoot;
+	char szaName[4];
+	long lFolder;
+	long lChild;
+	long lNode;
+
+	TEST_CHECK(atTree->nArticles == 8L);
+
+	// Root: index, a, about and c, in the order they were first seen.
+	lpRoot = ArticleTreeGetNode(atTree, ARTTREE_ROOT);
+	TEST_CHECK(ArticleTreeIsFolder(atTree, ARTTREE_ROOT));
+	TEST_CHECK(lpRoot->nChildren == 4L);
+	lChild = lpRoot->lFirstChild;
+	TEST_CHECK(ArticleTreeGetArticle(atTree, lChild) == 0L);
+	lChild = ArticleTreeGetNode(atTree, lChild)->lNextSibling;
+	TEST_CHECK(ArticleTreeIsFolder(atTree, lChild));
+	lChild = ArticleTreeGetNode(atTree, lChild)->lNextSibling;
+	TEST_CHECK(ArticleTreeGetArticle(atTree, lChild) == 4L);
+
+	// Folder a comes back after another one and still gets all of its pages,
+	// and both kinds of separators lead to the same sub-folder.
+	lFolder = FindChild(atTree, ARTTREE_ROOT, "a");
+	TEST_CHECK(lFolder != ARTTREE_NONE);
+	TEST_CHECK(ArticleTreeGetNode(atTree, lFolder)->nChildren == 4L);
+	TEST_CHECK(ArticleTreeGetArticle(atTree,
+		FindChild(atTree, lFolder, "three")) == 5L);
+	lFolder = FindChild(atTree, lFolder, "b");
+	TEST_CHECK(ArticleTreeGetNode(atTree, lFolder)->nChildren == 2L);
+	TEST_CHECK(ArticleTreeGetArticle(atTree,
+		FindChild(atTree, lFolder, "deeper")) == 6L);
+
+	// Empty path components are ignored.
+	lFolder = FindChild(atTree, ARTTREE_ROOT, "c");
+	lFolder = FindChild(atTree, lFolder, "d");
+	lFolder = FindChild(atTree, lFolder, "e");
+	lNode = FindChild(atTree, lFolder, "far");
+	TEST_CHECK(ArticleTreeGetArticle(atTree, lNode) == 7L);
+	TEST_CHECK(ArticleTreeGetArticle(atTree, lFolder) == ARTTREE_NONE);
+
+	// Names are truncated to the buffer.
+	TEST_CHECK(ArticleTreeGetName(atTree, lNode, szaName, 3) == 2);
+	TEST_CHECK(strcmp(szaName, "fa") == 0);
+	TEST_CHECK(ArticleTreeGetNode(atTree, atTree->nNodes) == NULL);
+}
+
+/**
+ * Checks that siblings come closest first, alternating after and before.
+ *
+ * @param atTree Article tree built from aArticles.
+ */
+void CheckSiblings(const ARTICLETREE *atTree) {
+	long alArticles[8];
+	long lFolder;
+	long lNode;
+
+	lFolder = FindChild(atTree, ARTTREE_ROOT, "a");
+	lNode = FindChild(atTree, lFolder, "two");
+	TEST_CHECK(ArticleTreeGetSiblingArticles(atTree, lNode, alArticles, 8L) ==
+			   2L);
+	TEST_CHECK((alArticles[0] == 5L) && (alArticles[1] == 1L));
+
+	TEST_CHECK(ArticleTreeGetSiblingArticles(atTree, lNode, alArticles, 1L) ==
+			   1L);
+	TEST_CHECK(alArticles[0] == 5L);
+
+	lNode = FindChild(atTree, lFolder, "three");
+	TEST_CHECK(ArticleTreeGetSiblingArticles(atTree, lNode, alArticles, 8L) ==
+			   2L);
+	TEST_CHECK((alArticles[0] == 2L) && (alArticles[1] == 1L));
+
+	TEST_CHECK(ArticleTreeGetSiblingArticles(atTree, ARTTREE_ROOT, alArticles,
+											 8L) == 0L);
+}
+
+/**
+ * Checks the materialization flags and user interface items.
+ *
+ * @param atTree Article tree built from aArticles.
+ */
+void CheckState(ARTICLETREE *atTree) {
+	int iItem;
+	long lFolder;
+
+	lFolder = FindChild(atTree, ARTTREE_ROOT, "a");
+	TEST_CHECK(!ArticleTreeIsMaterialized(atTree, lFolder));
+	ArticleTreeSetMaterialized(atTree, lFolder, 1);
+	TEST_CHECK(ArticleTreeIsMaterialized(atTree, lFolder));
+
+	TEST_CHECK(ArticleTreeGetItem(atTree, lFolder) == NULL);
+	ArticleTreeSetItem(atTree, lFolder, &iItem);
+	TEST_CHECK(ArticleTreeGetItem(atTree, lFolder) == &iItem);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	ARTICLETREE atTree;
+
+	UkiStubSetArticles(aArticles, sizeof(aArticles) / sizeof(aArticles[0]));
+	TEST_CHECK(ArticleTreeInitialize(&atTree));
+	TEST_CHECK(ArticleTreeBuildFromUki(&atTree) == 8L);
+
+	CheckStructure(&atTree);
+	CheckSiblings(&atTree);
+	CheckState(&atTree);
+
+	ArticleTreeFree(&atTree);
+	return TestFinish("ArticleTreeTest");
+}
\ No newline at end of file
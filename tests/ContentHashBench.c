@@ -0,0 +1,134 @@
+/**
+ * ContentHashBench.c
+ * Measures how fast pages are hashed at once and in the chunks a save writes
+ * them in, next to the FNV-1a hash that a byte-at-a-time approach would use.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "TestHelper.h"
+#include "ContentHash.h"
+
+// Definitions.
+#define NUM_SIZES   4
+#define TOTAL_BYTES (256L << 20)
+#define CHUNK_SIZE  4096
+
+// Sizes of the pages.
+const size_t acbSizes[NUM_SIZES] = { 4 << 10, 64 << 10, 1 << 20, 16 << 20 };
+
+// Private methods.
+unsigned long HashFnv(const unsigned char *lpData, size_t cbData);
+unsigned long HashChunks(const unsigned char *lpData, size_t cbData);
+double Throughput(size_t cbData, long nRuns, double dTime);
+
+/**
+ * Calculates the 32-bit FNV-1a hash of some data.
+ *
+ * @param  lpData Data to be hashed.
+ * @param  cbData Size of the data.
+ * @return        Hash of the data.
+ */
+unsigned long HashFnv(const unsigned char *lpData, size_t cbData) {
+	unsigned int dwHash;
+	size_t i;
+
+	dwHash = 2166136261U;
+	for (i = 0; i < cbData; i++)
+		dwHash = (dwHash ^ lpData[i]) * 16777619U;
+
+	return dwHash;
+}
+
+/**
+ * Hashes some data a chunk at a time.
+ *
+ * @param  lpData Data to be hashed.
+ * @param  cbData Size of the data.
+ * @return        Hash of the data.
+ */
+unsigned long HashChunks(const unsigned char *lpData, size_t cbData) {
+	CONTENTHASH chHash;
+	size_t iPos;
+
+	ContentHashInitialize(&chHash);
+	for (iPos = 0; iPos < cbData; iPos += CHUNK_SIZE) {
+		ContentHashUpdate(&chHash, lpData + iPos,
+			((cbData - iPos) < CHUNK_SIZE) ? (cbData - iPos) : CHUNK_SIZE);
+	}
+
+	return ContentHashFinal(&chHash);
+}
+
+/**
+ * Works out how many gigabytes were hashed per second.
+ *
+ * @param  cbData Size of the data.
+ * @param  nRuns  Number of times it was hashed.
+ * @param  dTime  Time it took in milliseconds.
+ * @return        Throughput in GB/s.
+ */
+double Throughput(size_t cbData, long nRuns, double dTime) {
+	return ((double)cbData * nRuns) / (dTime * 1e6);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	volatile unsigned long ulSink;
+	unsigned char *lpData;
+	size_t cbData;
+	size_t i;
+	double dOnce;
+	double dChunks;
+	double dFnv;
+	double dTime;
+	long nRuns;
+	long iRun;
+	int iSize;
+
+	lpData = (unsigned char*)malloc(acbSizes[NUM_SIZES - 1]);
+	TestSeed(20);
+	for (i = 0; i < acbSizes[NUM_SIZES - 1]; i++)
+		lpData[i] = (unsigned char)TestRandom(256);
+
+	ulSink = 0;
+	printf("%10s %12s %12s %12s\n", "size", "at once", "4 KB chunks",
+		   "fnv-1a");
+	for (iSize = 0; iSize < NUM_SIZES; iSize++) {
+		cbData = acbSizes[iSize];
+		nRuns = TOTAL_BYTES / (long)cbData;
+		if (HashChunks(lpData, cbData) != ContentHashBuffer(lpData, cbData)) {
+			printf("Hashing in chunks gives something else\n");
+			return 1;
+		}
+
+		dTime = TestMilliseconds();
+		for (iRun = 0L; iRun < nRuns; iRun++)
+			ulSink += ContentHashBuffer(lpData, cbData);
+		dOnce = TestMilliseconds() - dTime;
+
+		dTime = TestMilliseconds();
+		for (iRun = 0L; iRun < nRuns; iRun++)
+			ulSink += HashChunks(lpData, cbData);
+		dChunks = TestMilliseconds() - dTime;
+
+		dTime = TestMilliseconds();
+		for (iRun = 0L; iRun < nRuns; iRun++)
+			ulSink += HashFnv(lpData, cbData);
+		dFnv = TestMilliseconds() - dTime;
+
+		printf("%7lu KB %7.2f GB/s %7.2f GB/s %7.2f GB/s\n",
+			   (unsigned long)(cbData >> 10), Throughput(cbData, nRuns, dOnce),
+			   Throughput(cbData, nRuns, dChunks),
+			   Throughput(cbData, nRuns, dFnv));
+	}
+
+	free(lpData);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+/**
+ * ContentHashTest.c
+ * Checks the content hash against the published xxHash32 values and a plain
+ * implementation of it, and that hashing a piece at a time gives the same
+ * result as hashing everything at once.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "ContentHash.h"
+
+// Definitions.
+#define NUM_CASES 20000
+#define MAX_DATA  5000
+#define MAX_PIECE 40
+
+// Primes of xxHash32.
+#define PRIME1 2654435761U
+#define PRIME2 2246822519U
+#define PRIME3 3266489917U
+#define PRIME4  668265263U
+#define PRIME5  374761393U
+
+// Rotates a 32-bit value to the left.
+#define ROTL(x, r) ((((x) << (r)) | ((x) >> (32 - (r)))) & 0xFFFFFFFFU)
+
+// Private methods.
+unsigned int ReadWord(const unsigned char *lpData);
+unsigned int RoundReference(unsigned int dwLane, unsigned int dwInput);
+unsigned long HashReference(const unsigned char *lpData, size_t cbData);
+void CheckKnownValues(void);
+void CheckRandomData(void);
+
+/**
+ * Reads a little-endian 32-bit value.
+ *
+ * @param  lpData Where the value is.
+ * @return        The value.
+ */
+unsigned int ReadWord(const unsigned char *lpData) {
+	return (unsigned int)lpData[0] | ((unsigned int)lpData[1] << 8) |
+		((unsigned int)lpData[2] << 16) | ((unsigned int)lpData[3] << 24);
+}
+
+/**
+ * Mixes a value into one of the lanes.
+ *
+ * @param  dwLane  Lane to mix it into.
+ * @param  dwInput Value to be mixed.
+ * @return         New value of the lane.
+ */
+unsigned int RoundReference(unsigned int dwLane, unsigned int dwInput) {
+	dwLane += dwInput * PRIME2;
+	dwLane = ROTL(dwLane, 13);
+
+	return dwLane * PRIME1;
+}
+
+/**
+ * Calculates xxHash32 with a seed of zero straight from its specification.
+ *
+ * @param  lpData Data to be hashed.
+ * @param  cbData Size of the data.
+ * @return        Hash of the data.
+ */
+unsigned long HashReference(const unsigned char *lpData, size_t cbData) {
+	unsigned int aLanes[4];
+	unsigned int dwHash;
+	size_t iPos;
+
+	iPos = 0;
+	if (cbData >= 16) {
+		aLanes[0] = PRIME1 + PRIME2;
+		aLanes[1] = PRIME2;
+		aLanes[2] = 0;
+		aLanes[3] = 0U - PRIME1;
+		for (; (iPos + 16) <= cbData; iPos += 16) {
+			aLanes[0] = RoundReference(aLanes[0], ReadWord(lpData + iPos));
+			aLanes[1] = RoundReference(aLanes[1], ReadWord(lpData + iPos + 4));
+			aLanes[2] = RoundReference(aLanes[2], ReadWord(lpData + iPos + 8));
+			aLanes[3] = RoundReference(aLanes[3], ReadWord(lpData + iPos + 12));
+		}
+		dwHash = ROTL(aLanes[0], 1) + ROTL(aLanes[1], 7) +
+			ROTL(aLanes[2], 12) + ROTL(aLanes[3], 18);
+	} else {
+		dwHash = PRIME5;
+	}
+	dwHash += (unsigned int)cbData;
+
+	// Whatever is left over, four bytes and then one byte at a time.
+	for (; (iPos + 4) <= cbData; iPos += 4) {
+		dwHash += ReadWord(lpData + iPos) * PRIME3;
+		dwHash = ROTL(dwHash, 17) * PRIME4;
+	}
+	for (; iPos < cbData; iPos++) {
+		dwHash += lpData[iPos] * PRIME5;
+		dwHash = ROTL(dwHash, 11) * PRIME1;
+	}
+
+	// Avalanche.
+	dwHash ^= dwHash >> 15;
+	dwHash *= PRIME2;
+	dwHash ^= dwHash >> 13;
+	dwHash *= PRIME3;
+	dwHash ^= dwHash >> 16;
+
+	return dwHash;
+}
+
+/**
+ * Checks the values published with xxHash32.
+ */
+void CheckKnownValues(void) {
+	const char *szaLong = "Nobody inspects the spammish repetition";
+
+	TEST_CHECK(ContentHashBuffer("", 0) == 0x02CC5D05UL);
+	TEST_CHECK(ContentHashBuffer("a", 1) == 0x550D7456UL);
+	TEST_CHECK(ContentHashBuffer("abc", 3) == 0x32D153FFUL);
+	TEST_CHECK(ContentHashBuffer(szaLong, strlen(szaLong)) == 0xE2293B2FUL);
+	TEST_CHECK(HashReference((const unsigned char*)szaLong,
+							 strlen(szaLong)) == 0xE2293B2FUL);
+
+	// A single changed byte changes the hash.
+	TEST_CHECK(ContentHashBuffer("abd", 3) != ContentHashBuffer("abc", 3));
+}
+
+/**
+ * Hashes random data at once and in random pieces, and compares both with the
+ * reference.
+ */
+void CheckRandomData(void) {
+	static unsigned char abData[MAX_DATA];
+	CONTENTHASH chHash;
+	unsigned long ulExpected;
+	size_t cbData;
+	size_t cbPiece;
+	size_t iPos;
+	long nFailed;
+	int iCase;
+
+	TestSeed(20);
+	for (iPos = 0; iPos < MAX_DATA; iPos++)
+		abData[iPos] = (unsigned char)TestRandom(256);
+
+	nFailed = 0L;
+	for (iCase = 0; iCase < NUM_CASES; iCase++) {
+		cbData = TestRandom(MAX_DATA);
+		ulExpected = HashReference(abData, cbData);
+
+		ContentHashInitialize(&chHash);
+		for (iPos = 0; iPos < cbData; iPos += cbPiece) {
+			cbPiece = TestRandom(MAX_PIECE);
+			if (cbPiece > (cbData - iPos))
+				cbPiece = cbData - iPos;
+			ContentHashUpdate(&chHash, abData + iPos, cbPiece);
+		}
+
+		if ((ContentHashBuffer(abData, cbData) != ulExpected) ||
+				(ContentHashFinal(&chHash) != ulExpected)) {
+			nFailed++;
+		}
+	}
+
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nFailed);
+	TEST_CHECK(nFailed == 0L);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	CheckKnownValues();
+	CheckRandomData();
+
+	return TestFinish("ContentHashTest");
+}
\ No newline at end of file
@@ -0,0 +1,228 @@
+/**
+ * ConvertTest.c
+ * Checks that converting text between the text code page and Unicode never
+ * writes past the buffer it's given and fails when the buffer is too small,
+ * on a few known strings and then on random ones against a reference
+ * encoder. Built once for UTF-8 and once for the system code page.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "Utilities.h"
+
+// Definitions.
+#define NUM_CASES  20000
+#define MAX_TEXT   64
+#define GUARD      8
+
+// Value put in the buffers right after where the conversion may write.
+#define GUARD_BYTE 0x5A
+
+// Tell the build that goes through the system code page apart.
+#if TEXT_CODEPAGE == CP_UTF8
+	#define SUITE_NAME "ConvertTest"
+#else
+	#define SUITE_NAME "ConvertAcpTest"
+#endif
+
+// Private methods.
+int EncodeReference(char *szaOutput, const TCHAR *szText, int cchText);
+int IsGuarded(const void *lpBuffer, size_t cbBuffer);
+long CheckAtoW(const char *szaText, int cbText, const TCHAR *szExpected,
+			   int cchExpected, int cchBuffer);
+long CheckWtoA(const TCHAR *szText, int cchText, const char *szaExpected,
+			   int cbExpected, int cbBuffer);
+void CheckKnownStrings(void);
+long CheckRandomString(void);
+
+/**
+ * Encodes text to the text code page the simple way.
+ *
+ * @param  szaOutput Buffer to receive the text.
+ * @param  szText    Text with characters up to U+00FF.
+ * @param  cchText   Length of the text.
+ * @return           Length of the encoded text in bytes.
+ */
+int EncodeReference(char *szaOutput, const TCHAR *szText, int cchText) {
+	int cb;
+	int i;
+
+	cb = 0;
+	for (i = 0; i < cchText; i++) {
+#if TEXT_CODEPAGE == CP_UTF8
+		if (szText[i] >= 0x80) {
+			szaOutput[cb++] = (char)(0xC0 | (szText[i] >> 6));
+			szaOutput[cb++] = (char)(0x80 | (szText[i] & 0x3F));
+			continue;
+		}
+#endif
+		szaOutput[cb++] = (char)szText[i];
+	}
+
+	return cb;
+}
+
+/**
+ * Checks that the guard after a buffer is still in place.
+ *
+ * @param  lpBuffer Start of the guard.
+ * @param  cbBuffer Size of the guard in bytes.
+ * @return          Non-zero if nothing was written to it.
+ */
+int IsGuarded(const void *lpBuffer, size_t cbBuffer) {
+	const unsigned char *lpData = (const unsigned char*)lpBuffer;
+	size_t i;
+
+	for (i = 0; i < cbBuffer; i++) {
+		if (lpData[i] != GUARD_BYTE)
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Converts text to Unicode into a buffer of a given size and checks the
+ * result.
+ *
+ * @param  szaText     Text in the text code page.
+ * @param  cbText      Length of the text in bytes.
+ * @param  szExpected  Text it should turn into.
+ * @param  cchExpected Length of the expected text.
+ * @param  cchBuffer   Size of the buffer to convert into.
+ * @return             1 if the conversion went wrong.
+ */
+long CheckAtoW(const char *szaText, int cbText, const TCHAR *szExpected,
+			   int cchExpected, int cchBuffer) {
+	TCHAR szBuffer[MAX_TEXT * 2 + GUARD];
+	int cchConverted;
+
+	// Just measuring.
+	if (ConvertBufferAtoW(NULL, 0, szaText, cbText) != cchExpected)
+		return 1L;
+
+	// Fails when it doesn't fit, without writing past the buffer.
+	memset(szBuffer, GUARD_BYTE, sizeof(szBuffer));
+	cchConverted = ConvertBufferAtoW(szBuffer, cchBuffer, szaText, cbText);
+	if (!IsGuarded(szBuffer + cchBuffer, GUARD * sizeof(TCHAR)))
+		return 1L;
+	if (cchBuffer < cchExpected)
+		return (cchConverted == 0) ? 0L : 1L;
+
+	return ((cchConverted == cchExpected) && (memcmp(szBuffer, szExpected,
+		cchExpected * sizeof(TCHAR)) == 0)) ? 0L : 1L;
+}
+
+/**
+ * Converts Unicode text to the text code page into a buffer of a given size
+ * and checks the result.
+ *
+ * @param  szText      Unicode text.
+ * @param  cchText     Length of the text.
+ * @param  szaExpected Text it should turn into.
+ * @param  cbExpected  Length of the expected text in bytes.
+ * @param  cbBuffer    Size of the buffer to convert into.
+ * @return             1 if the conversion went wrong.
+ */
+long CheckWtoA(const TCHAR *szText, int cchText, const char *szaExpected,
+			   int cbExpected, int cbBuffer) {
+	char szaBuffer[MAX_TEXT * 2 + GUARD];
+	int cbConverted;
+
+	// Just measuring.
+	if (ConvertBufferWtoA(NULL, 0, szText, cchText) != cbExpected)
+		return 1L;
+
+	// Fails when it doesn't fit, without writing past the buffer.
+	memset(szaBuffer, GUARD_BYTE, sizeof(szaBuffer));
+	cbConverted = ConvertBufferWtoA(szaBuffer, cbBuffer, szText, cchText);
+	if (!IsGuarded(szaBuffer + cbBuffer, GUARD))
+		return 1L;
+	if (cbBuffer < cbExpected)
+		return (cbConverted == 0) ? 0L : 1L;
+
+	return ((cbConverted == cbExpected) &&
+		(memcmp(szaBuffer, szaExpected, cbExpected) == 0)) ? 0L : 1L;
+}
+
+/**
+ * Checks a few strings where the answers are known, especially ones whose
+ * plain ASCII start fills the whole buffer.
+ */
+void CheckKnownStrings(void) {
+	static const TCHAR szCafe[] = { 'c', 'a', 'f', 0xE9 };
+	char szaCafe[8];
+	int cbCafe;
+
+	cbCafe = EncodeReference(szaCafe, szCafe, 4);
+
+	// Fits exactly or has room to spare.
+	TEST_CHECK(CheckAtoW("abc", 3, L"abc", 3, 3) == 0L);
+	TEST_CHECK(CheckAtoW(szaCafe, cbCafe, szCafe, 4, 8) == 0L);
+	TEST_CHECK(CheckWtoA(L"abc", 3, "abc", 3, 3) == 0L);
+	TEST_CHECK(CheckWtoA(szCafe, 4, szaCafe, cbCafe, 8) == 0L);
+
+	// Plain ASCII that doesn't fit.
+	TEST_CHECK(CheckAtoW("abcd", 4, L"abcd", 4, 3) == 0L);
+	TEST_CHECK(CheckWtoA(L"abcd", 4, "abcd", 4, 3) == 0L);
+
+	// The ASCII start fills the buffer and there's more after it.
+	TEST_CHECK(CheckAtoW(szaCafe, cbCafe, szCafe, 4, 3) == 0L);
+	TEST_CHECK(CheckWtoA(szCafe, 4, szaCafe, cbCafe, 3) == 0L);
+
+	// Or stops right before the buffer ends.
+	TEST_CHECK(CheckWtoA(szCafe, 4, szaCafe, cbCafe, cbCafe - 1) == 0L);
+}
+
+/**
+ * Converts a random string both ways into buffers of random sizes. A size of
+ * 0 only measures, so it's left out.
+ *
+ * @return Number of conversions that went wrong.
+ */
+long CheckRandomString(void) {
+	TCHAR szText[MAX_TEXT];
+	char szaText[MAX_TEXT * 2];
+	int cchText;
+	int cbText;
+	int i;
+
+	// Mostly plain ASCII, which is what takes the fast path.
+	cchText = 1 + (int)TestRandom(MAX_TEXT);
+	for (i = 0; i < cchText; i++) {
+		szText[i] = (TCHAR)((TestRandom(4) == 0) ?
+			(0xA0 + TestRandom(0x60)) : (0x20 + TestRandom(0x5F)));
+	}
+	cbText = EncodeReference(szaText, szText, cchText);
+
+	return CheckAtoW(szaText, cbText, szText, cchText,
+			1 + (int)TestRandom(cchText + 1)) +
+		CheckWtoA(szText, cchText, szaText, cbText,
+			1 + (int)TestRandom(cbText + 1));
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	long nDisagreements;
+	int i;
+
+	TestSeed(0xC0DE9A6EUL);
+	CheckKnownStrings();
+
+	nDisagreements = 0L;
+	for (i = 0; i < NUM_CASES; i++)
+		nDisagreements += CheckRandomString();
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nDisagreements);
+	TEST_CHECK(nDisagreements == 0L);
+
+	return TestFinish(SUITE_NAME);
+}
\ No newline at end of file
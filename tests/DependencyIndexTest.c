@@ -0,0 +1,555 @@
+/**
+ * DependencyIndexTest.c
+ * Checks that the dependency index finds the articles that use each template
+ * and variable, through any number of templates in between, and that it stays
+ * right when single pages are updated instead of building it again.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "UkiStub.h"
+#include "DependencyStub.h"
+#include "TextIndex.h"
+#include "DependencyIndex.h"
+
+// Definitions.
+#define NUM_CASES       200
+#define NUM_UPDATES     4
+#define NUM_SET_OPS     4000
+#define MAX_ARTICLES    40
+#define MAX_TEMPLATES   12
+#define MAX_VARIABLES   6
+#define MAX_WORDS       6
+#define SET_RANGE       64
+#define ARTICLE(n)      (1UL << (n))
+
+// Mirrors the sorted list kept privately by DependencyIndex.c.
+typedef struct {
+	LONG *lpPages;
+	LONG nPages;
+} DEPENDENTS;
+
+// A random workspace and which names each of its pages mentions.
+typedef struct {
+	LONG nArticles;
+	LONG nTemplates;
+	LONG nVariables;
+	LONG nConfigs;
+	BYTE abArticleTemplates[MAX_ARTICLES][MAX_TEMPLATES];
+	BYTE abArticleVariables[MAX_ARTICLES][MAX_VARIABLES];
+	BYTE abTemplateTemplates[MAX_TEMPLATES][MAX_TEMPLATES];
+	BYTE abTemplateVariables[MAX_TEMPLATES][MAX_VARIABLES];
+} WORKSPACE;
+
+// Names of the pages and variables of the random workspaces.
+char aszaTemplateNames[MAX_TEMPLATES][16];
+char aszaVariableNames[MAX_VARIABLES][16];
+uki_article_t aukiArticles[MAX_ARTICLES];
+uki_template_t aukiTemplates[MAX_TEMPLATES];
+uki_variable_t aukiVariables[MAX_VARIABLES];
+
+// Private methods.
+BOOL SetDependent(DEPENDENTS *lpDeps, LONG nPage, BOOL fDepends);
+unsigned long DependentsMask(LONG nDependents, const LONG *alArticles);
+int TemplateDependentsAre(LONG nTemplate, unsigned long ulArticles);
+int VariableDependentsAre(const char *szaKey, unsigned long ulArticles);
+void CheckFixedWorkspace(void);
+void CheckSetDependent(void);
+void SetUpNames(void);
+void MakePageText(char *szaText, const BYTE *abTemplates,
+				  const BYTE *abVariables, const WORKSPACE *lpWorkspace);
+void RandomizeArticle(WORKSPACE *lpWorkspace, LONG nArticle);
+void RandomizeTemplate(WORKSPACE *lpWorkspace, LONG nTemplate);
+long CountDisagreements(const WORKSPACE *lpWorkspace);
+long CheckRandomWorkspace(void);
+
+/**
+ * Turns a sorted list of articles into a bit mask, or all ones if it isn't
+ * sorted.
+ *
+ * @param  nDependents Number of articles in the list.
+ * @param  alArticles  Articles in the list.
+ * @return             Mask with a bit set for each article.
+ */
+unsigned long DependentsMask(LONG nDependents, const LONG *alArticles) {
+	unsigned long ulMask = 0;
+	LONG i;
+
+	for (i = 0L; i < nDependents; i++) {
+		if ((i > 0L) && (alArticles[i] <= alArticles[i - 1]))
+			return ~0UL;
+		ulMask |= ARTICLE(alArticles[i]);
+	}
+
+	return ulMask;
+}
+
+/**
+ * Checks which articles depend on a template.
+ *
+ * @param  nTemplate  Index of the template.
+ * @param  ulArticles Mask of the articles that should depend on it.
+ * @return            Non-zero if they're exactly the ones expected.
+ */
+int TemplateDependentsAre(LONG nTemplate, unsigned long ulArticles) {
+	LONG alArticles[MAX_ARTICLES];
+	LONG nDependents;
+
+	nDependents = GetTemplateDependents(nTemplate, alArticles, MAX_ARTICLES);
+	return (nDependents >= 0L) &&
+		(DependentsMask(nDependents, alArticles) == ulArticles);
+}
+
+/**
+ * Checks which articles depend on a variable.
+ *
+ * @param  szaKey     Key of the variable.
+ * @param  ulArticles Mask of the articles that should depend on it.
+ * @return            Non-zero if they're exactly the ones expected.
+ */
+int VariableDependentsAre(const char *szaKey, unsigned long ulArticles) {
+	LONG alArticles[MAX_ARTICLES];
+	WCHAR szKey[64];
+	LONG nDependents;
+
+	TestWiden((unsigned short*)szKey, szaKey);
+	nDependents = GetVariableDependents(szKey, alArticles, MAX_ARTICLES);
+	return (nDependents >= 0L) &&
+		(DependentsMask(nDependents, alArticles) == ulArticles);
+}
+
+/**
+ * Checks a small workspace where the answers are known, through saves that
+ * change which templates use which and a template that's added later.
+ */
+void CheckFixedWorkspace(void) {
+	static uki_template_t aukiFixed[5] = {
+		{ "header.html", "header", NULL, 0 },
+		{ "logo.html", "logo", NULL, 0 },
+		{ "footer.html", "footer", NULL, 0 },
+		{ "sidebar.html", "sidebar", NULL, 0 },
+		{ "banner.html", "banner", NULL, 0 }
+	};
+	static uki_variable_t aukiFixedVariables[2] = {
+		{ "sitename", "WinUki" },
+		{ "author", "Nathan" }
+	};
+	static uki_variable_t aukiFixedConfigs[1] = {
+		{ "baseurl", "/" }
+	};
+	WCHAR szKey[16];
+
+	// Five articles, four templates, two variables and a configuration key.
+	UkiStubSetArticles(aukiArticles, 5);
+	UkiStubSetTemplates(aukiFixed, 4);
+	UkiStubSetVariables(aukiFixedVariables, 2);
+	UkiStubSetConfigs(aukiFixedConfigs, 1);
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 0L, "<nav>{{ logo }}</nav>");
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 1L, "<img alt=\"{{ sitename }}\">");
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 2L, "<p>{{ baseurl }}</p>");
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 3L, "<aside>Links</aside>");
+	DependencyStubSetPage(TXTIDX_ARTICLE, 0L, "{{ header }} Hello");
+	DependencyStubSetPage(TXTIDX_ARTICLE, 1L, "{{ logo }}");
+	DependencyStubSetPage(TXTIDX_ARTICLE, 2L, "{{ footer }}");
+	DependencyStubSetPage(TXTIDX_ARTICLE, 3L, "By {{ author }}");
+	DependencyStubSetPage(TXTIDX_ARTICLE, 4L, "Nothing to see here");
+
+	// Nothing can be asked before the index is built.
+	TEST_CHECK(!IsDependencyIndexReady());
+	TEST_CHECK(GetTemplateDependents(0L, NULL, 0L) == -1L);
+	TEST_CHECK(!UpdateArticleDependencies(0L));
+	TEST_CHECK(BuildDependencyIndex() && IsDependencyIndexReady());
+
+	// Templates used directly and through other templates.
+	TEST_CHECK(TemplateDependentsAre(0L, ARTICLE(0)));
+	TEST_CHECK(TemplateDependentsAre(1L, ARTICLE(0) | ARTICLE(1)));
+	TEST_CHECK(TemplateDependentsAre(2L, ARTICLE(2)));
+	TEST_CHECK(TemplateDependentsAre(3L, 0));
+	TEST_CHECK(GetTemplateDependents(4L, NULL, 0L) == -1L);
+
+	// Variables used directly and through templates, and configuration keys.
+	TEST_CHECK(VariableDependentsAre("sitename", ARTICLE(0) | ARTICLE(1)));
+	TEST_CHECK(VariableDependentsAre("author", ARTICLE(3)));
+	TEST_CHECK(VariableDependentsAre("baseurl", ARTICLE(2)));
+	TestWiden((unsigned short*)szKey, "missing");
+	TEST_CHECK(GetVariableDependents(szKey, NULL, 0L) == -1L);
+
+	// An article that starts using a template and stops using a variable.
+	DependencyStubSetPage(TXTIDX_ARTICLE, 3L, "{{ header }}");
+	TEST_CHECK(UpdateArticleDependencies(3L));
+	TEST_CHECK(TemplateDependentsAre(0L, ARTICLE(0) | ARTICLE(3)));
+	TEST_CHECK(TemplateDependentsAre(1L, ARTICLE(0) | ARTICLE(1) |
+		ARTICLE(3)));
+	TEST_CHECK(VariableDependentsAre("sitename", ARTICLE(0) | ARTICLE(1) |
+		ARTICLE(3)));
+	TEST_CHECK(VariableDependentsAre("author", 0));
+
+	// A template that starts using another one.
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 2L, "{{ baseurl }} {{ logo }}");
+	TEST_CHECK(UpdateTemplateDependencies(2L));
+	TEST_CHECK(TemplateDependentsAre(1L, ARTICLE(0) | ARTICLE(1) |
+		ARTICLE(2) | ARTICLE(3)));
+	TEST_CHECK(VariableDependentsAre("sitename", ARTICLE(0) | ARTICLE(1) |
+		ARTICLE(2) | ARTICLE(3)));
+	TEST_CHECK(VariableDependentsAre("baseurl", ARTICLE(2)));
+
+	// Templates that use each other.
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 0L, "{{ logo }} {{ sidebar }}");
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 3L, "{{ header }}");
+	TEST_CHECK(UpdateTemplateDependencies(0L));
+	TEST_CHECK(UpdateTemplateDependencies(3L));
+	TEST_CHECK(TemplateDependentsAre(0L, ARTICLE(0) | ARTICLE(3)));
+	TEST_CHECK(TemplateDependentsAre(3L, ARTICLE(0) | ARTICLE(3)));
+
+	// A template that stops using a variable.
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 1L, "<img>");
+	TEST_CHECK(UpdateTemplateDependencies(1L));
+	TEST_CHECK(VariableDependentsAre("sitename", 0));
+
+	// Only the articles that use a template get invalidated.
+	DependencyStubClearInvalidated();
+	TEST_CHECK(InvalidateTemplateDependents(1L));
+	TEST_CHECK(DependencyStubIsInvalidated(0L) &&
+		DependencyStubIsInvalidated(1L) && DependencyStubIsInvalidated(2L) &&
+		DependencyStubIsInvalidated(3L) && !DependencyStubIsInvalidated(4L));
+
+	// A template added since the build makes the next update a full one.
+	UkiStubSetTemplates(aukiFixed, 5);
+	DependencyStubSetPage(TXTIDX_TEMPLATE, 4L, "<div>Banner</div>");
+	DependencyStubSetPage(TXTIDX_ARTICLE, 4L, "{{ banner }}");
+	TEST_CHECK(UpdateArticleDependencies(4L));
+	TEST_CHECK(TemplateDependentsAre(4L, ARTICLE(4)));
+
+	// Forgetting everything.
+	ClearDependencyIndex();
+	TEST_CHECK(!IsDependencyIndexReady());
+	TEST_CHECK(!InvalidateTemplateDependents(0L));
+	TEST_CHECK(!UpdateTemplateDependencies(0L));
+	DependencyStubReset();
+}
+
+/**
+ * Checks adding pages to and removing them from a sorted list against a plain
+ * array of flags.
+ */
+void CheckSetDependent(void) {
+	BYTE abReference[SET_RANGE];
+	DEPENDENTS dpList;
+	LONG nPage;
+	LONG nPages;
+	long nBad;
+	int i;
+
+	memset(abReference, 0, sizeof(abReference));
+	dpList.lpPages = NULL;
+	dpList.nPages = 0L;
+
+	// Inserting in any order keeps the list sorted without duplicates.
+	TEST_CHECK(SetDependent(&dpList, 5L, TRUE));
+	TEST_CHECK(SetDependent(&dpList, 1L, TRUE));
+	TEST_CHECK(SetDependent(&dpList, 3L, TRUE));
+	TEST_CHECK(SetDependent(&dpList, 3L, TRUE));
+	TEST_CHECK((dpList.nPages == 3L) && (dpList.lpPages[0] == 1L) &&
+		(dpList.lpPages[1] == 3L) && (dpList.lpPages[2] == 5L));
+
+	// Removing what's there and what isn't.
+	TEST_CHECK(SetDependent(&dpList, 1L, FALSE));
+	TEST_CHECK(SetDependent(&dpList, 7L, FALSE));
+	TEST_CHECK((dpList.nPages == 2L) && (dpList.lpPages[0] == 3L) &&
+		(dpList.lpPages[1] == 5L));
+	abReference[3] = 1;
+	abReference[5] = 1;
+
+	// Lots of random changes.
+	nBad = 0L;
+	for (i = 0; i < NUM_SET_OPS; i++) {
+		nPage = (LONG)TestRandom(SET_RANGE);
+		abReference[nPage] = (BYTE)TestRandom(2);
+		if (!SetDependent(&dpList, nPage, abReference[nPage]))
+			nBad++;
+	}
+	nPages = 0L;
+	for (nPage = 0L; nPage < SET_RANGE; nPage++) {
+		if (!abReference[nPage])
+			continue;
+		if ((nPages >= dpList.nPages) || (dpList.lpPages[nPages] != nPage))
+			nBad++;
+		nPages++;
+	}
+	TEST_CHECK((nBad == 0L) && (nPages == dpList.nPages));
+
+	if (dpList.lpPages != NULL)
+		LocalFree(dpList.lpPages);
+}
+
+/**
+ * Names the pages and variables used by the random workspaces.
+ */
+void SetUpNames(void) {
+	LONG i;
+
+	for (i = 0L; i < MAX_TEMPLATES; i++) {
+		sprintf(aszaTemplateNames[i], "tmpl%ld", (long)i);
+		aukiTemplates[i].path = aszaTemplateNames[i];
+		aukiTemplates[i].name = aszaTemplateNames[i];
+		aukiTemplates[i].parent = NULL;
+		aukiTemplates[i].deepness = 0;
+	}
+	for (i = 0L; i < MAX_VARIABLES; i++) {
+		sprintf(aszaVariableNames[i], "var%ld", (long)i);
+		aukiVariables[i].key = aszaVariableNames[i];
+		aukiVariables[i].value = aszaVariableNames[i];
+	}
+	for (i = 0L; i < MAX_ARTICLES; i++) {
+		aukiArticles[i].path = "article.html";
+		aukiArticles[i].name = "article";
+		aukiArticles[i].parent = NULL;
+		aukiArticles[i].deepness = 0;
+	}
+}
+
+/**
+ * Writes the text of a page that mentions the names flagged for it, between
+ * words that aren't names of anything.
+ *
+ * @param szaText     Buffer for the text.
+ * @param abTemplates Flags of the templates it mentions.
+ * @param abVariables Flags of the variables it mentions.
+ * @param lpWorkspace Workspace the page is in.
+ */
+void MakePageText(char *szaText, const BYTE *abTemplates,
+				  const BYTE *abVariables, const WORKSPACE *lpWorkspace) {
+	LONG i;
+
+	strcpy(szaText, "<p>Lorem");
+	for (i = 0L; i < lpWorkspace->nTemplates; i++) {
+		if (abTemplates[i])
+			sprintf(szaText + strlen(szaText), " {{ %s }}",
+				aszaTemplateNames[i]);
+	}
+	for (i = 0L; i < (lpWorkspace->nVariables + lpWorkspace->nConfigs); i++) {
+		if (abVariables[i])
+			sprintf(szaText + strlen(szaText), " %s,", aszaVariableNames[i]);
+	}
+	strcat(szaText, " ipsum</p>");
+}
+
+/**
+ * Gives an article new random mentions and puts its text in the index.
+ *
+ * @param lpWorkspace Workspace the article is in.
+ * @param nArticle    Index of the article.
+ */
+void RandomizeArticle(WORKSPACE *lpWorkspace, LONG nArticle) {
+	char szaText[1024];
+	LONG i;
+
+	for (i = 0L; i < MAX_TEMPLATES; i++) {
+		lpWorkspace->abArticleTemplates[nArticle][i] =
+			(i < lpWorkspace->nTemplates) && (TestRandom(MAX_WORDS) == 0);
+	}
+	for (i = 0L; i < MAX_VARIABLES; i++) {
+		lpWorkspace->abArticleVariables[nArticle][i] =
+			(i < (lpWorkspace->nVariables + lpWorkspace->nConfigs)) &&
+			(TestRandom(MAX_WORDS) == 0);
+	}
+
+	MakePageText(szaText, lpWorkspace->abArticleTemplates[nArticle],
+		lpWorkspace->abArticleVariables[nArticle], lpWorkspace);
+	DependencyStubSetPage(TXTIDX_ARTICLE, nArticle, szaText);
+}
+
+/**
+ * Gives a template new random mentions and puts its text in the index.
+ *
+ * @param lpWorkspace Workspace the template is in.
+ * @param nTemplate   Index of the template.
+ */
+void RandomizeTemplate(WORKSPACE *lpWorkspace, LONG nTemplate) {
+	char szaText[1024];
+	LONG i;
+
+	for (i = 0L; i < MAX_TEMPLATES; i++) {
+		lpWorkspace->abTemplateTemplates[nTemplate][i] = (i != nTemplate) &&
+			(i < lpWorkspace->nTemplates) && (TestRandom(MAX_WORDS) == 0);
+	}
+	for (i = 0L; i < MAX_VARIABLES; i++) {
+		lpWorkspace->abTemplateVariables[nTemplate][i] =
+			(i < (lpWorkspace->nVariables + lpWorkspace->nConfigs)) &&
+			(TestRandom(MAX_WORDS) == 0);
+	}
+
+	MakePageText(szaText, lpWorkspace->abTemplateTemplates[nTemplate],
+		lpWorkspace->abTemplateVariables[nTemplate], lpWorkspace);
+	DependencyStubSetPage(TXTIDX_TEMPLATE, nTemplate, szaText);
+}
+
+/**
+ * Works out what every article depends on the slow way and compares it with
+ * what the index says.
+ *
+ * @param  lpWorkspace Workspace being checked.
+ * @return             Number of lists that don't match.
+ */
+long CountDisagreements(const WORKSPACE *lpWorkspace) {
+	BYTE abReaches[MAX_TEMPLATES][MAX_TEMPLATES];
+	BYTE abUses[MAX_ARTICLES][MAX_TEMPLATES];
+	LONG alArticles[MAX_ARTICLES];
+	LONG nDependents;
+	LONG nExpected;
+	LONG a, t, u, v;
+	WCHAR szKey[16];
+	long nBad = 0L;
+	int fMatch;
+
+	// Which templates end up using which, through any number of others.
+	for (t = 0L; t < lpWorkspace->nTemplates; t++) {
+		for (u = 0L; u < lpWorkspace->nTemplates; u++) {
+			abReaches[t][u] = (t == u) ||
+				lpWorkspace->abTemplateTemplates[t][u];
+		}
+	}
+	for (v = 0L; v < lpWorkspace->nTemplates; v++) {
+		for (t = 0L; t < lpWorkspace->nTemplates; t++) {
+			for (u = 0L; u < lpWorkspace->nTemplates; u++) {
+				if (abReaches[t][v] && abReaches[v][u])
+					abReaches[t][u] = 1;
+			}
+		}
+	}
+
+	// Which templates each article ends up using.
+	for (a = 0L; a < lpWorkspace->nArticles; a++) {
+		for (u = 0L; u < lpWorkspace->nTemplates; u++) {
+			abUses[a][u] = 0;
+			for (t = 0L; t < lpWorkspace->nTemplates; t++) {
+				if (lpWorkspace->abArticleTemplates[a][t] && abReaches[t][u])
+					abUses[a][u] = 1;
+			}
+		}
+	}
+
+	// Compare the templates.
+	for (t = 0L; t < lpWorkspace->nTemplates; t++) {
+		nDependents = GetTemplateDependents(t, alArticles, MAX_ARTICLES);
+		nExpected = 0L;
+		fMatch = nDependents >= 0L;
+		for (a = 0L; fMatch && (a < lpWorkspace->nArticles); a++) {
+			if (!abUses[a][t])
+				continue;
+			fMatch = (nExpected < nDependents) &&
+				(alArticles[nExpected] == a);
+			nExpected++;
+		}
+		if (!fMatch || (nExpected != nDependents))
+			nBad++;
+	}
+
+	// Compare the variables.
+	for (v = 0L; v < (lpWorkspace->nVariables + lpWorkspace->nConfigs); v++) {
+		TestWiden((unsigned short*)szKey, aszaVariableNames[v]);
+		nDependents = GetVariableDependents(szKey, alArticles, MAX_ARTICLES);
+		nExpected = 0L;
+		fMatch = nDependents >= 0L;
+		for (a = 0L; fMatch && (a < lpWorkspace->nArticles); a++) {
+			u = lpWorkspace->abArticleVariables[a][v];
+			for (t = 0L; !u && (t < lpWorkspace->nTemplates); t++)
+				u = abUses[a][t] && lpWorkspace->abTemplateVariables[t][v];
+			if (!u)
+				continue;
+
+			fMatch = (nExpected < nDependents) &&
+				(alArticles[nExpected] == a);
+			nExpected++;
+		}
+		if (!fMatch || (nExpected != nDependents))
+			nBad++;
+	}
+
+	return nBad;
+}
+
+/**
+ * Builds the index of a random workspace, then saves a few of its pages and
+ * updates the index for each of them, comparing it with the slow way along
+ * the way.
+ *
+ * @return Number of lists that didn't match.
+ */
+long CheckRandomWorkspace(void) {
+	WORKSPACE wsRandom;
+	long nBad;
+	LONG i;
+	int iUpdate;
+
+	// Make up a workspace.
+	memset(&wsRandom, 0, sizeof(WORKSPACE));
+	wsRandom.nArticles = 1L + (LONG)TestRandom(MAX_ARTICLES);
+	wsRandom.nTemplates = 1L + (LONG)TestRandom(MAX_TEMPLATES);
+	wsRandom.nVariables = (LONG)TestRandom(MAX_VARIABLES - 1);
+	wsRandom.nConfigs = (LONG)TestRandom(2);
+	UkiStubSetArticles(aukiArticles, (size_t)wsRandom.nArticles);
+	UkiStubSetTemplates(aukiTemplates, (size_t)wsRandom.nTemplates);
+	UkiStubSetVariables(aukiVariables, (size_t)wsRandom.nVariables);
+	UkiStubSetConfigs(aukiVariables + wsRandom.nVariables,
+		(size_t)wsRandom.nConfigs);
+	for (i = 0L; i < wsRandom.nTemplates; i++)
+		RandomizeTemplate(&wsRandom, i);
+	for (i = 0L; i < wsRandom.nArticles; i++)
+		RandomizeArticle(&wsRandom, i);
+
+	// Build it and then keep it up to date.
+	nBad = BuildDependencyIndex() ? CountDisagreements(&wsRandom) : 1L;
+	for (iUpdate = 0; iUpdate < NUM_UPDATES; iUpdate++) {
+		if (TestRandom(2) == 0) {
+			i = (LONG)TestRandom(wsRandom.nArticles);
+			RandomizeArticle(&wsRandom, i);
+			if (!UpdateArticleDependencies(i))
+				nBad++;
+		} else {
+			i = (LONG)TestRandom(wsRandom.nTemplates);
+			RandomizeTemplate(&wsRandom, i);
+			if (!UpdateTemplateDependencies(i))
+				nBad++;
+		}
+
+		nBad += CountDisagreements(&wsRandom);
+	}
+
+	ClearDependencyIndex();
+	DependencyStubReset();
+	return nBad;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	long nDisagreements;
+	int i;
+
+	TestSeed(0xDE9E17DUL);
+	InitializeDependencyIndex();
+	SetUpNames();
+
+	CheckFixedWorkspace();
+	CheckSetDependent();
+
+	nDisagreements = 0L;
+	for (i = 0; i < NUM_CASES; i++)
+		nDisagreements += CheckRandomWorkspace();
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nDisagreements);
+	TEST_CHECK(nDisagreements == 0L);
+
+	DestroyDependencyIndex();
+	TEST_CHECK(Win32ShimLiveBytes() == 0);
+
+	return TestFinish("DependencyIndexTest");
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+/**
+ * DependencyStub.c
+ * A stand-in for the parts of UkiHelper, WorkspaceSearch and RenderCache that
+ * the dependency index uses, which indexes whatever text a test gives it and
+ * remembers which articles were invalidated.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "DependencyStub.h"
+#include <string.h>
+#include "UkiHelper.h"
+#include "WorkspaceSearch.h"
+#include "RenderCache.h"
+
+// Global variables.
+TEXTINDEX tiStubIndex;
+BOOL bStubIndexReady = FALSE;
+BYTE abStubInvalidated[DEPSTUB_MAX_ARTICLES];
+
+/**
+ * Sets the text of a page in the search index, replacing what it had.
+ *
+ * @param  iKind   Kind of the page (TXTIDX_ARTICLE or TXTIDX_TEMPLATE).
+ * @param  nPage   Index of the page.
+ * @param  szaText Contents of the page.
+ * @return         TRUE if the page was indexed.
+ */
+BOOL DependencyStubSetPage(int iKind, LONG nPage, const char *szaText) {
+	if (!bStubIndexReady) {
+		TextIndexInitialize(&tiStubIndex);
+		bStubIndexReady = TRUE;
+	}
+
+	return TextIndexSetDocument(&tiStubIndex, iKind, nPage, szaText,
+		strlen(szaText));
+}
+
+/**
+ * Forgets every page and invalidation.
+ */
+void DependencyStubReset(void) {
+	if (bStubIndexReady) {
+		TextIndexFree(&tiStubIndex);
+		bStubIndexReady = FALSE;
+	}
+
+	DependencyStubClearInvalidated();
+}
+
+/**
+ * Checks if an article was invalidated since the last time they were cleared.
+ *
+ * @param  nArticle Index of the article.
+ * @return          TRUE if the article was invalidated.
+ */
+BOOL DependencyStubIsInvalidated(LONG nArticle) {
+	if ((nArticle < 0L) || (nArticle >= DEPSTUB_MAX_ARTICLES))
+		return FALSE;
+
+	return abStubInvalidated[nArticle];
+}
+
+/**
+ * Forgets which articles were invalidated.
+ */
+void DependencyStubClearInvalidated(void) {
+	memset(abStubInvalidated, 0, sizeof(abStubInvalidated));
+}
+
+/**
+ * Gets the number of articles available.
+ *
+ * @return Number of articles available.
+ */
+LONG GetUkiArticlesAvailable() {
+	return (LONG)uki_articles_available();
+}
+
+/**
+ * Gets the number of templates available.
+ *
+ * @return Number of templates available.
+ */
+LONG GetUkiTemplatesAvailable() {
+	return (LONG)uki_templates_available();
+}
+
+/**
+ * Gets a template from the engine.
+ *
+ * @param  ukiTemplate Receives the template.
+ * @param  nIndex      Index of the template.
+ * @return             TRUE if the template exists.
+ */
+BOOL GetUkiTemplate(UKITEMPLATE *ukiTemplate, size_t nIndex) {
+	*ukiTemplate = uki_template(nIndex);
+	return ukiTemplate->name != NULL;
+}
+
+/**
+ * Finds the pages that contain all of the words in an ASCII string.
+ *
+ * @param  szaWords    Words to look for.
+ * @param  lpMatches   Array to receive the pages found.
+ * @param  nMaxMatches Maximum number of matches to return.
+ * @return             Number of matches found.
+ */
+LONG FindWordsInWorkspace(const char *szaWords, TXTIDX_MATCH *lpMatches,
+						  LONG nMaxMatches) {
+	if (!bStubIndexReady)
+		return 0L;
+
+	return TextIndexQuery(&tiStubIndex, szaWords, lpMatches, nMaxMatches);
+}
+
+/**
+ * Checks if a single page contains all of the words in an ASCII string.
+ *
+ * @param  iKind    Kind of the page.
+ * @param  nPage    Index of the page.
+ * @param  szaWords Words to look for.
+ * @return          TRUE if the page contains every word.
+ */
+BOOL WorkspacePageHasWords(int iKind, LONG nPage, const char *szaWords) {
+	if (!bStubIndexReady)
+		return FALSE;
+
+	return TextIndexPageHasWords(&tiStubIndex, iKind, nPage, szaWords);
+}
+
+/**
+ * Records that a rendered article is stale.
+ *
+ * @param nArticle Index of the article.
+ */
+void InvalidateRenderedArticle(LONG nArticle) {
+	if ((nArticle >= 0L) && (nArticle < DEPSTUB_MAX_ARTICLES))
+		abStubInvalidated[nArticle] = 1;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+/**
+ * DependencyStub.h
+ * A stand-in for the parts of UkiHelper, WorkspaceSearch and RenderCache that
+ * the dependency index uses, which indexes whatever text a test gives it and
+ * remembers which articles were invalidated.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _DEPENDENCYSTUB_H
+#define _DEPENDENCYSTUB_H
+
+#include <windows.h>
+
+// Most articles whose invalidation is tracked.
+#define DEPSTUB_MAX_ARTICLES 1024
+
+// Setup.
+BOOL DependencyStubSetPage(int iKind, LONG nPage, const char *szaText);
+void DependencyStubReset(void);
+
+// Inspection.
+BOOL DependencyStubIsInvalidated(LONG nArticle);
+void DependencyStubClearInvalidated(void);
+
+#endif  // _DEPENDENCYSTUB_H
\ No newline at end of file
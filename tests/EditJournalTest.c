@@ -0,0 +1,426 @@
+/**
+ * EditJournalTest.c
+ * Checks that the edit journal replays back to the text that was in the editor
+ * when it was last flushed, that it keeps its records small, and that a record
+ * that was only partially written or got corrupted ends the journal, on a few
+ * known pages and then on random sequences of edits.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "JournalStub.h"
+#include "Utilities.h"
+#include "EditJournal.h"
+
+// Definitions.
+#define NUM_CASES     200
+#define NUM_STEPS     60
+#define MAX_TEXT      8192
+#define MAX_EDIT      100
+#define MAX_JOURNAL   65536
+
+// Size of the header of a record and the most an edit of a single character
+// may take, since records cover whole blocks of 64 characters.
+#define RECORD_HEADER    (5 * sizeof(DWORD))
+#define MAX_SMALL_RECORD (RECORD_HEADER + (3 * 64 * sizeof(TCHAR)))
+
+// Global variables.
+char szaFolder[256];
+char szaPage[300];
+char szaJournal[300];
+TCHAR szPage[MAX_PATH];
+TCHAR szText[MAX_TEXT + MAX_EDIT + 1];
+DWORD cchText;
+BYTE abJournal[MAX_JOURNAL];
+time_t tModified = 1000000000;
+
+// Private methods.
+BOOL StartPage(const char *szaContents);
+BOOL WritePage(const char *szaContents);
+BOOL EditText(const char *szaText);
+int Recovers(void);
+long JournalSize(void);
+long ReadJournal(void);
+BOOL WriteJournal(long cbJournal);
+void CheckKnownJournal(void);
+void CheckSmallRecords(void);
+void CheckDamagedJournal(void);
+void CheckChangedPage(void);
+long CheckRandomJournal(void);
+
+/**
+ * Writes the page file and starts tracking it, with its contents in the
+ * editor.
+ *
+ * @param  szaContents Contents of the page.
+ * @return             TRUE if the page is being tracked.
+ */
+BOOL StartPage(const char *szaContents) {
+	FILETIME ftModified;
+
+	if (!WritePage(szaContents))
+		return FALSE;
+	cchText = (DWORD)TestWiden((unsigned short*)szText, szaContents);
+	JournalStubSetText(szText, cchText, FALSE);
+	if (!GetFileModifiedTime(szPage, &ftModified))
+		return FALSE;
+
+	ResetEditJournal(szPage, &ftModified);
+	return TRUE;
+}
+
+/**
+ * Writes the page file and gives it a new modification time.
+ *
+ * @param  szaContents Contents of the page.
+ * @return             TRUE if the file was written.
+ */
+BOOL WritePage(const char *szaContents) {
+	struct utimbuf utTimes;
+
+	if (!TestWriteFile(szaPage, szaContents, strlen(szaContents)))
+		return FALSE;
+
+	tModified++;
+	utTimes.actime = tModified;
+	utTimes.modtime = tModified;
+	return utime(szaPage, &utTimes) == 0;
+}
+
+/**
+ * Changes the text in the editor.
+ *
+ * @param  szaText New text, which is different from what's on disk.
+ * @return         TRUE if the text was changed.
+ */
+BOOL EditText(const char *szaText) {
+	cchText = (DWORD)TestWiden((unsigned short*)szText, szaText);
+	return JournalStubSetText(szText, cchText, TRUE);
+}
+
+/**
+ * Checks that the journal recovers the page with the text in the editor.
+ *
+ * @return Non-zero if the page and its text were recovered.
+ */
+int Recovers(void) {
+	TCHAR szRecoveredPage[MAX_PATH];
+	LPTSTR szRecovered;
+	int fSame;
+
+	if (!ReadEditJournal(szRecoveredPage, &szRecovered))
+		return 0;
+
+	fSame = (wcscmp(szRecoveredPage, szPage) == 0) &&
+		(wcslen(szRecovered) == cchText) &&
+		(memcmp(szRecovered, szText, cchText * sizeof(TCHAR)) == 0);
+	LocalFree(szRecovered);
+
+	return fSame;
+}
+
+/**
+ * Gets the size of the journal file.
+ *
+ * @return Size of the journal in bytes or -1 if there isn't one.
+ */
+long JournalSize(void) {
+	struct stat st;
+
+	if (stat(szaJournal, &st) != 0)
+		return -1L;
+
+	return (long)st.st_size;
+}
+
+/**
+ * Reads the whole journal file.
+ *
+ * @return Size of the journal in bytes or -1 if it couldn't be read.
+ */
+long ReadJournal(void) {
+	FILE *lpFile;
+	long cbJournal;
+
+	lpFile = fopen(szaJournal, "rb");
+	if (lpFile == NULL)
+		return -1L;
+	cbJournal = (long)fread(abJournal, 1, sizeof(abJournal), lpFile);
+	fclose(lpFile);
+
+	return cbJournal;
+}
+
+/**
+ * Replaces the journal file with the contents of the buffer.
+ *
+ * @param  cbJournal Number of bytes of the buffer to write.
+ * @return           TRUE if the journal was written.
+ */
+BOOL WriteJournal(long cbJournal) {
+	return TestWriteFile(szaJournal, abJournal, (size_t)cbJournal);
+}
+
+/**
+ * Checks the journal of a page through a few edits, an undo back to what's on
+ * disk and a discard.
+ */
+void CheckKnownJournal(void) {
+	TCHAR szRecoveredPage[MAX_PATH];
+	LPTSTR szRecovered;
+	long cbJournal;
+
+	// Nothing to write until something is edited.
+	TEST_CHECK(StartPage("Hello world"));
+	TEST_CHECK(FlushEditJournal() && (JournalSize() < 0L));
+	TEST_CHECK(!ReadEditJournal(szRecoveredPage, &szRecovered));
+
+	// Every flush leaves the journal with the text as it is.
+	EditText("Hello there world");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	EditText("Hello there, world!");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	cbJournal = JournalSize();
+	TEST_CHECK(FlushEditJournal() && (JournalSize() == cbJournal));
+	EditText("");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+
+	// Undoing everything leaves nothing to recover.
+	cchText = (DWORD)TestWiden((unsigned short*)szText, "Hello world");
+	JournalStubSetText(szText, cchText, FALSE);
+	TEST_CHECK(FlushEditJournal() && (JournalSize() < 0L));
+	TEST_CHECK(!ReadEditJournal(szRecoveredPage, &szRecovered));
+
+	// And the next edit starts a new journal.
+	EditText("Goodbye world");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	DiscardEditJournal();
+	TEST_CHECK(JournalSize() < 0L);
+}
+
+/**
+ * Checks that a small edit to a large page only writes a small record, both
+ * against the file on disk and against the last flush.
+ */
+void CheckSmallRecords(void) {
+	static char szaContents[MAX_TEXT + 1];
+	long cbStart;
+	long cbFirst;
+	DWORD i;
+
+	for (i = 0; i < MAX_TEXT; i++)
+		szaContents[i] = (char)('a' + (i % 26));
+	szaContents[MAX_TEXT] = '\0';
+	TEST_CHECK(StartPage(szaContents));
+
+	// Against the file on disk.
+	szaContents[MAX_TEXT / 2] = '#';
+	EditText(szaContents);
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	cbStart = RECORD_HEADER + (wcslen(szPage) * sizeof(TCHAR));
+	cbFirst = JournalSize();
+	TEST_CHECK((cbFirst - cbStart) <= (long)MAX_SMALL_RECORD);
+
+	// Against the last flush, at both ends.
+	szaContents[0] = '#';
+	EditText(szaContents);
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	TEST_CHECK((JournalSize() - cbFirst) <= (long)MAX_SMALL_RECORD);
+	cbFirst = JournalSize();
+	szaContents[MAX_TEXT - 1] = '#';
+	EditText(szaContents);
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	TEST_CHECK((JournalSize() - cbFirst) <= (long)MAX_SMALL_RECORD);
+	DiscardEditJournal();
+
+	// A text that repeats itself, so the same blocks match from both ends.
+	memset(szaContents, 'a', 1000);
+	szaContents[1000] = '\0';
+	TEST_CHECK(StartPage(szaContents));
+	szaContents[1000] = 'a';
+	szaContents[1001] = '\0';
+	EditText(szaContents);
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	szaContents[10] = '\0';
+	EditText(szaContents);
+	TEST_CHECK(FlushEditJournal() && Recovers());
+
+	DiscardEditJournal();
+}
+
+/**
+ * Checks that a journal with a partial or corrupted record is only replayed up
+ * to the last good one, and that a failed flush starts it over.
+ */
+void CheckDamagedJournal(void) {
+	TCHAR szRecoveredPage[MAX_PATH];
+	LPTSTR szRecovered;
+	long cbFirst;
+	long cbJournal;
+
+	TEST_CHECK(StartPage("One two three"));
+	EditText("One two three four");
+	TEST_CHECK(FlushEditJournal());
+	cbFirst = JournalSize();
+	EditText("One 2 three four");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	cbJournal = ReadJournal();
+	TEST_CHECK(cbJournal > cbFirst);
+
+	// A partial record at the end.
+	TEST_CHECK(WriteJournal(cbJournal - 1));
+	EditText("One two three four");
+	TEST_CHECK(Recovers());
+
+	// A corrupted record at the end.
+	abJournal[cbJournal - 1] ^= 0x20;
+	TEST_CHECK(WriteJournal(cbJournal));
+	TEST_CHECK(Recovers());
+	abJournal[cbJournal - 1] ^= 0x20;
+
+	// A corrupted first edit leaves nothing.
+	abJournal[cbFirst - 1] ^= 0x20;
+	TEST_CHECK(WriteJournal(cbJournal));
+	TEST_CHECK(!ReadEditJournal(szRecoveredPage, &szRecovered));
+	abJournal[cbFirst - 1] ^= 0x20;
+	TEST_CHECK(WriteJournal(cbJournal));
+
+	// A failed flush starts over from the file on disk.
+	EditText("One 2 three four five");
+	Win32ShimFailWrite(0);
+	TEST_CHECK(!FlushEditJournal());
+	Win32ShimFailWrite(-1);
+	TEST_CHECK(FlushEditJournal() && Recovers());
+
+	DiscardEditJournal();
+}
+
+/**
+ * Checks what happens when the page file changes on disk under the journal.
+ */
+void CheckChangedPage(void) {
+	TCHAR szRecoveredPage[MAX_PATH];
+	LPTSTR szRecovered;
+
+	// Before the first flush the whole text is written.
+	TEST_CHECK(StartPage("Original text"));
+	TEST_CHECK(WritePage("Changed on disk"));
+	EditText("Original text, edited");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	EditText("Original text, edited again");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	DiscardEditJournal();
+
+	// After that the edits don't apply to it anymore.
+	TEST_CHECK(StartPage("Original text"));
+	EditText("Original text, edited");
+	TEST_CHECK(FlushEditJournal() && Recovers());
+	TEST_CHECK(WritePage("Changed on disk"));
+	TEST_CHECK(!ReadEditJournal(szRecoveredPage, &szRecovered));
+	DiscardEditJournal();
+}
+
+/**
+ * Makes random edits to a random page, flushing the journal every now and
+ * then and checking that it recovers the text in the editor.
+ *
+ * @return Number of flushes after which the journal was wrong.
+ */
+long CheckRandomJournal(void) {
+	static const TCHAR szAlphabet[] = L"abcde fgh\n\x00E9\x4E2D";
+	static char szaContents[MAX_TEXT + 1];
+	DWORD cchContents;
+	DWORD nStart;
+	DWORD cchDeleted;
+	DWORD cchInserted;
+	DWORD i;
+	BOOL fDirty;
+	long nBad;
+	int iStep;
+
+	// Start with a page of plain text.
+	cchContents = TestRandom(MAX_TEXT / 2);
+	for (i = 0; i < cchContents; i++)
+		szaContents[i] = (char)('a' + TestRandom(8));
+	szaContents[cchContents] = '\0';
+	if (!StartPage(szaContents))
+		return 1L;
+
+	nBad = 0L;
+	for (iStep = 0; iStep < NUM_STEPS; iStep++) {
+		if (TestRandom(20) == 0) {
+			// Undo everything.
+			cchText = (DWORD)TestWiden((unsigned short*)szText, szaContents);
+			fDirty = FALSE;
+		} else {
+			// Replace a random range with random text.
+			nStart = TestRandom(cchText + 1);
+			cchDeleted = TestRandom(min(cchText - nStart, MAX_EDIT) + 1);
+			cchInserted = TestRandom(MAX_EDIT + 1);
+			if ((cchText - cchDeleted + cchInserted) > MAX_TEXT)
+				cchInserted = 0;
+			memmove(szText + nStart + cchInserted,
+				szText + nStart + cchDeleted,
+				(cchText - nStart - cchDeleted) * sizeof(TCHAR));
+			for (i = 0; i < cchInserted; i++) {
+				szText[nStart + i] =
+					szAlphabet[TestRandom(wcslen(szAlphabet))];
+			}
+			cchText = cchText - cchDeleted + cchInserted;
+			fDirty = TRUE;
+		}
+		JournalStubSetText(szText, cchText, fDirty);
+
+		// Flush every now and then.
+		if (TestRandom(3) != 0)
+			continue;
+		if (!FlushEditJournal()) {
+			nBad++;
+		} else if (fDirty ? !Recovers() : (JournalSize() >= 0L)) {
+			nBad++;
+		}
+	}
+
+	DiscardEditJournal();
+	return nBad;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	long nDisagreements;
+	int i;
+
+	TestSeed(0x7EA11E5FUL);
+	TEST_CHECK(TestMakeFolder(szaFolder, "editjournal"));
+	sprintf(szaPage, "%s/page.html", szaFolder);
+	sprintf(szaJournal, "%s/MANIFEST.jnl", szaFolder);
+	Win32ShimWidenPath(szPage, szaPage);
+	JournalStubSetWorkspace(szaFolder);
+
+	CheckKnownJournal();
+	CheckSmallRecords();
+	CheckDamagedJournal();
+	CheckChangedPage();
+
+	nDisagreements = 0L;
+	for (i = 0; i < NUM_CASES; i++)
+		nDisagreements += CheckRandomJournal();
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nDisagreements);
+	TEST_CHECK(nDisagreements == 0L);
+	TEST_CHECK(Win32ShimLiveBytes() == 0);
+
+	JournalStubFree();
+	TestRemoveFolder(szaFolder);
+	return TestFinish("EditJournalTest");
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+/**
+ * FileMapBench.c
+ * Compares reading an article into a buffer with mapping it, both followed
+ * by transcoding the whole text into UTF-16 like ReadFileText does, across
+ * file sizes.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "FileMap.h"
+#include "Transcode.h"
+
+// Definitions.
+#define NUM_SIZES   6
+#define TOTAL_BYTES (64L << 20)
+#define MAX_RUNS    2000L
+
+// Sizes of the files.
+const size_t acbSizes[NUM_SIZES] = {
+	4 << 10, 64 << 10, 256 << 10, 1 << 20, 4 << 20, 16 << 20
+};
+
+// Private methods.
+size_t LoadArticle(const char *szaPath, size_t cbMinMapped);
+void MakeArticle(char *szaArticle, size_t cbArticle);
+
+/**
+ * Loads an article through a view and transcodes it.
+ *
+ * @param  szaPath     Path to the article.
+ * @param  cbMinMapped Size from which the file gets mapped.
+ * @return             Length of the text in characters.
+ */
+size_t LoadArticle(const char *szaPath, size_t cbMinMapped) {
+	FILEMAP fmView;
+	unsigned short *szText;
+	size_t cchText;
+
+	if (!FileMapOpen(&fmView, szaPath, cbMinMapped)) {
+		printf("Couldn't open %s\n", szaPath);
+		exit(1);
+	}
+
+	cchText = TranscodeUtf8Length(fmView.lpData, fmView.cbData);
+	szText = (unsigned short*)malloc((cchText + 1) * sizeof(unsigned short));
+	TranscodeUtf8ToWide(szText, fmView.lpData, fmView.cbData);
+	szText[cchText] = 0;
+
+	FileMapClose(&fmView);
+	free(szText);
+	return cchText;
+}
+
+/**
+ * Fills an article with lines of text and a few accented characters.
+ *
+ * @param szaArticle Buffer to hold the article.
+ * @param cbArticle  Size of the article in bytes.
+ */
+void MakeArticle(char *szaArticle, size_t cbArticle) {
+	const char *szaLine = "<p>Refer\xC3\xAAncia: the quick brown fox jumps "
+		"over the lazy dog.</p>\n";
+	size_t nLine = strlen(szaLine);
+	size_t i;
+
+	for (i = 0; (i + nLine) <= cbArticle; i += nLine)
+		memcpy(szaArticle + i, szaLine, nLine);
+	memset(szaArticle + i, ' ', cbArticle - i);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	char szaRoot[256];
+	char szaPath[512];
+	char *szaArticle;
+	size_t cbArticle;
+	double dBuffered;
+	double dMapped;
+	double dTime;
+	long nRuns;
+	long iRun;
+	int iSize;
+
+	TestMakeFolder(szaRoot, "filemapbench");
+	sprintf(szaPath, "%s/article.html", szaRoot);
+
+	printf("%10s %8s %14s %14s\n", "size", "runs", "buffered ms",
+		   "mapped ms");
+	for (iSize = 0; iSize < NUM_SIZES; iSize++) {
+		cbArticle = acbSizes[iSize];
+		szaArticle = (char*)malloc(cbArticle);
+		MakeArticle(szaArticle, cbArticle);
+		TestWriteFile(szaPath, szaArticle, cbArticle);
+		free(szaArticle);
+
+		// Go through about the same amount of data for every size.
+		nRuns = TOTAL_BYTES / (long)cbArticle;
+		if (nRuns > MAX_RUNS)
+			nRuns = MAX_RUNS;
+		LoadArticle(szaPath, 0);
+
+		dTime = TestMilliseconds();
+		for (iRun = 0L; iRun < nRuns; iRun++)
+			LoadArticle(szaPath, cbArticle + 1);
+		dBuffered = (TestMilliseconds() - dTime) / nRuns;
+
+		dTime = TestMilliseconds();
+		for (iRun = 0L; iRun < nRuns; iRun++)
+			LoadArticle(szaPath, 0);
+		dMapped = (TestMilliseconds() - dTime) / nRuns;
+
+		printf("%7lu KB %8ld %14.4f %14.4f\n",
+			   (unsigned long)(cbArticle >> 10), nRuns, dBuffered, dMapped);
+	}
+
+	TestRemoveFolder(szaRoot);
+	return 0;
+}
\ No newline at end of file
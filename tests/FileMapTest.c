@@ -0,0 +1,97 @@
+/**
+ * FileMapTest.c
+ * Checks that a view of a file has the same contents whether the file was
+ * mapped or read into memory, and that files too small to be worth mapping
+ * or without anything in them are handled.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "FileMap.h"
+
+// Definitions.
+#define NUM_SIZES 6
+
+// Sizes of the files, around a page and the mapping threshold.
+const size_t acbSizes[NUM_SIZES] = {
+	1, 4095, 4097, FILEMAP_MIN_MAPPED - 1, FILEMAP_MIN_MAPPED, 1 << 20
+};
+
+// Private methods.
+void CheckView(const char *szaPath, const char *lpData, size_t cbData,
+			   size_t cbMinMapped, int fMapped);
+
+/**
+ * Opens a view of a file and checks what's in it.
+ *
+ * @param szaPath     Path to the file.
+ * @param lpData      Contents the file was written with.
+ * @param cbData      Size of the contents.
+ * @param cbMinMapped Size from which the file gets mapped.
+ * @param fMapped     Should the file have been mapped?
+ */
+void CheckView(const char *szaPath, const char *lpData, size_t cbData,
+			   size_t cbMinMapped, int fMapped) {
+	FILEMAP fmView;
+
+	TEST_CHECK(FileMapOpen(&fmView, szaPath, cbMinMapped));
+	TEST_CHECK(fmView.cbData == cbData);
+	TEST_CHECK(fmView.fMapped == fMapped);
+	TEST_CHECK(memcmp(fmView.lpData, lpData, cbData) == 0);
+
+	FileMapClose(&fmView);
+	TEST_CHECK((fmView.lpData == NULL) && (fmView.lpBuffer == NULL));
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	FILEMAP fmView;
+	char szaRoot[256];
+	char szaPath[512];
+	char *lpData;
+	size_t cbData;
+	size_t i;
+	int iSize;
+
+	TEST_CHECK(TestMakeFolder(szaRoot, "filemap"));
+	sprintf(szaPath, "%s/article.html", szaRoot);
+
+	// Both ways of getting at a file give the same bytes.
+	TestSeed(19);
+	for (iSize = 0; iSize < NUM_SIZES; iSize++) {
+		cbData = acbSizes[iSize];
+		lpData = (char*)malloc(cbData);
+		for (i = 0; i < cbData; i++)
+			lpData[i] = (char)TestRandom(256);
+		TEST_CHECK(TestWriteFile(szaPath, lpData, cbData));
+
+		CheckView(szaPath, lpData, cbData, 0, 1);
+		CheckView(szaPath, lpData, cbData, cbData + 1, 0);
+		CheckView(szaPath, lpData, cbData, FILEMAP_MIN_MAPPED,
+				  cbData >= FILEMAP_MIN_MAPPED);
+		free(lpData);
+	}
+
+	// Empty files can't be mapped but still have a view.
+	TEST_CHECK(TestWriteFile(szaPath, "", 0));
+	TEST_CHECK(FileMapOpen(&fmView, szaPath, 0));
+	TEST_CHECK((fmView.cbData == 0) && !fmView.fMapped &&
+			   (fmView.lpData != NULL));
+	FileMapClose(&fmView);
+
+	// Files that aren't there can't be opened.
+	sprintf(szaPath, "%s/missing.html", szaRoot);
+	TEST_CHECK(!FileMapOpen(&fmView, szaPath, 0));
+	TEST_CHECK(fmView.lpData == NULL);
+
+	TestRemoveFolder(szaRoot);
+	return TestFinish("FileMapTest");
+}
\ No newline at end of file
@@ -0,0 +1,288 @@
+/**
+ * HtmlChunkTest.c
+ * Checks that documents are split right after tags and never inside a tag,
+ * comment, script or style, on a few known documents and then on random ones
+ * put together from pieces that know where they can be cut.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "HtmlChunk.h"
+
+// Definitions.
+#define NUM_CASES    5000
+#define MAX_DOC      4096
+#define MAX_PIECE    64
+#define MIN_CHUNK    12
+#define MAX_CHUNK    300
+
+// Kinds of pieces of a random document.
+#define PIECE_TEXT    0
+#define PIECE_ENTITY  1
+#define PIECE_PAIR    2
+#define PIECE_TAG     3
+
+// A piece of a random document.
+typedef struct {
+	int iKind;
+	const char *szaText;
+} DOC_PIECE;
+
+// Pieces the random documents are made of. Tags can be cut right after them,
+// entities and surrogate pairs must never be cut through, and text doesn't
+// matter.
+const DOC_PIECE adpPieces[] = {
+	{ PIECE_TEXT, "Lorem ipsum " },
+	{ PIECE_TEXT, "dolor > sit " },
+	{ PIECE_TEXT, "amet" },
+	{ PIECE_ENTITY, "&amp;" },
+	{ PIECE_ENTITY, "&hellip;" },
+	{ PIECE_ENTITY, "&#8212;" },
+	{ PIECE_PAIR, NULL },
+	{ PIECE_TAG, "<p>" },
+	{ PIECE_TAG, "</p>" },
+	{ PIECE_TAG, "<br/>" },
+	{ PIECE_TAG, "<a href=\"x>y\">" },
+	{ PIECE_TAG, "<img alt='a > b' src=\"c\">" },
+	{ PIECE_TAG, "<!-- <b>old</b> -->" },
+	{ PIECE_TAG, "<script>if (a<b) x = '<p>';</script>" },
+	{ PIECE_TAG, "<SCRIPT type=\"text/javascript\">y > 1</Script>" },
+	{ PIECE_TAG, "<style>p>a { color: red; }</style>" },
+	{ PIECE_TAG, "<scripts>" },
+	{ PIECE_TAG, "<stylesheet>" }
+};
+#define NUM_PIECES (sizeof(adpPieces) / sizeof(DOC_PIECE))
+
+// The random document and where it can be cut.
+unsigned short szDocument[MAX_DOC + MAX_PIECE];
+unsigned char abAfterTag[MAX_DOC + MAX_PIECE + 1];
+unsigned char abSplits[MAX_DOC + MAX_PIECE + 1];
+
+// Private methods.
+size_t MakeDocument(size_t cchWanted);
+size_t ExpectedEnd(size_t cchDocument, size_t nStart, size_t cchMax);
+long CheckChunk(size_t cchDocument, size_t nStart, size_t cchMax,
+				int fExact);
+void CheckKnownDocuments(void);
+long CheckRandomDocument(void);
+
+/**
+ * Puts together a random document from the pieces, recording where it can be
+ * cut.
+ *
+ * @param  cchWanted Length the document should at least have.
+ * @return           Length of the document.
+ */
+size_t MakeDocument(size_t cchWanted) {
+	const DOC_PIECE *lpPiece;
+	size_t cchDocument;
+	size_t i;
+
+	cchDocument = 0;
+	memset(abAfterTag, 0, sizeof(abAfterTag));
+	memset(abSplits, 0, sizeof(abSplits));
+	while (cchDocument < cchWanted) {
+		lpPiece = &adpPieces[TestRandom(NUM_PIECES)];
+
+		// A smiley outside the basic plane.
+		if (lpPiece->iKind == PIECE_PAIR) {
+			szDocument[cchDocument++] = 0xD83D;
+			abSplits[cchDocument] = 1;
+			szDocument[cchDocument++] = 0xDE00;
+			continue;
+		}
+
+		// Everything else is plain ASCII.
+		for (i = 0; lpPiece->szaText[i] != '\0'; i++) {
+			if ((i > 0) && (lpPiece->iKind == PIECE_ENTITY))
+				abSplits[cchDocument] = 1;
+			szDocument[cchDocument++] = (unsigned char)lpPiece->szaText[i];
+		}
+		if (lpPiece->iKind == PIECE_TAG)
+			abAfterTag[cchDocument] = 1;
+	}
+
+	return cchDocument;
+}
+
+/**
+ * Works out where a chunk should end when it starts at a place where the
+ * document can be cut.
+ *
+ * @param  cchDocument Length of the document.
+ * @param  nStart      Where the chunk starts.
+ * @param  cchMax      Maximum length of the chunk.
+ * @return             Last place right after a tag that fits in the chunk or
+ *                     0 if it has to be cut somewhere else.
+ */
+size_t ExpectedEnd(size_t cchDocument, size_t nStart, size_t cchMax) {
+	size_t nPos;
+
+	if ((cchDocument - nStart) <= cchMax)
+		return cchDocument;
+
+	for (nPos = nStart + cchMax; nPos > nStart; nPos--) {
+		if (abAfterTag[nPos])
+			return nPos;
+	}
+
+	return 0;
+}
+
+/**
+ * Checks a single chunk of the random document.
+ *
+ * @param  cchDocument Length of the document.
+ * @param  nStart      Where the chunk starts.
+ * @param  cchMax      Maximum length of the chunk.
+ * @param  fExact      Does the chunk start right after a tag, so that exactly
+ *                     where it ends is known?
+ * @return             Position right after the chunk, or 0 if it was wrong.
+ */
+long CheckChunk(size_t cchDocument, size_t nStart, size_t cchMax,
+				int fExact) {
+	size_t nExpected;
+	size_t nEnd;
+
+	// It must make progress without going over the maximum.
+	nEnd = HtmlChunkEnd(szDocument, cchDocument, nStart, cchMax);
+	if ((nEnd <= nStart) || ((nEnd - nStart) > cchMax) || (nEnd > cchDocument))
+		return 0L;
+
+	// And never cut through a character or an entity.
+	if (abSplits[nEnd])
+		return 0L;
+
+	// Right after the last tag that fits, when there's one.
+	if (fExact) {
+		nExpected = ExpectedEnd(cchDocument, nStart, cchMax);
+		if ((nExpected != 0) && (nEnd != nExpected))
+			return 0L;
+	}
+
+	return (long)nEnd;
+}
+
+/**
+ * Checks a few documents where the answers are known.
+ */
+void CheckKnownDocuments(void) {
+	unsigned short szHTML[128];
+	size_t cchHTML;
+
+	// Everything fits.
+	cchHTML = TestWiden(szHTML, "<p>Hello</p>");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 64) == cchHTML);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 3, cchHTML - 3) == cchHTML);
+
+	// Right after the last tag that fits.
+	cchHTML = TestWiden(szHTML, "<p>Hello</p><p>World</p>");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 14) == 12);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 12) == 12);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 11) == 3);
+
+	// Not at a bracket inside an attribute.
+	cchHTML = TestWiden(szHTML, "<a title=\"1 > 0\">x</a>");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 18) == 17);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 16) == 16);
+
+	// Not after a tag inside a comment.
+	cchHTML = TestWiden(szHTML, "<!-- <b> --><i>x</i>");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 14) == 12);
+
+	// Nor after a comment that ends past the limit.
+	cchHTML = TestWiden(szHTML, "<p>ab<!--c-->d");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 13) == 13);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 12) == 3);
+
+	// Not after a tag inside a script, but after the script.
+	cchHTML = TestWiden(szHTML, "<script>a = '<b>';</script><p>");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 29) == 27);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 26) == 26);
+
+	// A tag that only starts like a script is a regular one.
+	cchHTML = TestWiden(szHTML, "<scripts>abc<p>");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 11) == 9);
+
+	// No tag at all, so it's cut without splitting an entity.
+	cchHTML = TestWiden(szHTML, "abc &amp; def");
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 7) == 4);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 9) == 9);
+
+	// Or a surrogate pair.
+	cchHTML = TestWiden(szHTML, "abcdef");
+	szHTML[3] = 0xD83D;
+	szHTML[4] = 0xDE00;
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 4) == 3);
+	TEST_CHECK(HtmlChunkEnd(szHTML, cchHTML, 0, 5) == 5);
+}
+
+/**
+ * Splits a random document the way the viewer does, and also checks chunks
+ * that start right after every tag in it.
+ *
+ * @return Number of chunks that were wrong.
+ */
+long CheckRandomDocument(void) {
+	size_t cchDocument;
+	size_t cchMax;
+	size_t nStart;
+	long nEnd;
+	long nBad;
+	int fExact;
+
+	cchDocument = MakeDocument(1 + TestRandom(MAX_DOC));
+	nBad = 0L;
+
+	// The whole document, a chunk at a time.
+	fExact = 1;
+	for (nStart = 0; nStart < cchDocument; nStart = (size_t)nEnd) {
+		cchMax = MIN_CHUNK + TestRandom(MAX_CHUNK - MIN_CHUNK);
+		nEnd = CheckChunk(cchDocument, nStart, cchMax, fExact);
+		if (nEnd == 0L) {
+			nBad++;
+			break;
+		}
+
+		// Once a chunk was cut somewhere else the next one can only be
+		// checked for the basics.
+		fExact = fExact && abAfterTag[nEnd];
+	}
+
+	// Chunks that start right after each tag.
+	for (nStart = 1; nStart < cchDocument; nStart++) {
+		if (!abAfterTag[nStart])
+			continue;
+
+		cchMax = MIN_CHUNK + TestRandom(MAX_CHUNK - MIN_CHUNK);
+		if (CheckChunk(cchDocument, nStart, cchMax, 1) == 0L)
+			nBad++;
+	}
+
+	return nBad;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	long nDisagreements;
+	int i;
+
+	TestSeed(0xC4C4E11DUL);
+	CheckKnownDocuments();
+
+	nDisagreements = 0L;
+	for (i = 0; i < NUM_CASES; i++)
+		nDisagreements += CheckRandomDocument();
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nDisagreements);
+	TEST_CHECK(nDisagreements == 0L);
+
+	return TestFinish("HtmlChunkTest");
+}
\ No newline at end of file
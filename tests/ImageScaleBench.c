@@ -0,0 +1,124 @@
+/**
+ * ImageScaleBench.c
+ * Measures decoding a large BMP and shrinking it to the width of the page
+ * viewer, which is what every visit to a page used to cost, and how much
+ * memory the shrunk bitmap saves over the full one.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "ImageScale.h"
+
+// Definitions.
+#define NUM_SIZES    3
+#define VIEWER_WIDTH 240
+#define NUM_RUNS     20
+
+// Sizes of the images.
+const long anSizes[NUM_SIZES][2] = { { 640, 480 }, { 1600, 1200 },
+									 { 4096, 3072 } };
+
+// Private methods.
+unsigned char* MakeBmp(long nWidth, long nHeight, size_t *lpcbData);
+
+/**
+ * Makes a bottom-up 24-bit BMP file full of noise.
+ *
+ * @param  nWidth   Width of the image.
+ * @param  nHeight  Height of the image.
+ * @param  lpcbData Size of the file.
+ * @return          Contents of the file. Free it with free.
+ */
+unsigned char* MakeBmp(long nWidth, long nHeight, size_t *lpcbData) {
+	unsigned char *lpData;
+	size_t cbPixels;
+	size_t i;
+
+	cbPixels = (size_t)ImageStride(nWidth) * nHeight;
+	*lpcbData = 54 + cbPixels;
+	lpData = (unsigned char*)calloc(1, *lpcbData);
+
+	lpData[0] = 'B';
+	lpData[1] = 'M';
+	for (i = 0; i < 4; i++) {
+		lpData[2 + i] = (unsigned char)(*lpcbData >> (i * 8));
+		lpData[18 + i] = (unsigned char)(nWidth >> (i * 8));
+		lpData[22 + i] = (unsigned char)(nHeight >> (i * 8));
+	}
+	lpData[10] = 54;
+	lpData[14] = 40;
+	lpData[26] = 1;
+	lpData[28] = 24;
+	for (i = 0; i < cbPixels; i++)
+		lpData[54 + i] = (unsigned char)TestRandom(256);
+
+	return lpData;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	IMAGE_PIXELS ipFull;
+	IMAGE_PIXELS ipScaled;
+	unsigned char *lpData;
+	size_t cbData;
+	long nWidth;
+	long nHeight;
+	double dDecode;
+	double dScale;
+	double dTime;
+	int iSize;
+	int iRun;
+
+	TestSeed(25);
+	printf("%11s %9s %11s %11s %9s %9s\n", "image", "shrunk", "decode ms",
+		   "shrink ms", "full", "shrunk");
+	for (iSize = 0; iSize < NUM_SIZES; iSize++) {
+		lpData = MakeBmp(anSizes[iSize][0], anSizes[iSize][1], &cbData);
+		ImageScaledSize(anSizes[iSize][0], anSizes[iSize][1], VIEWER_WIDTH,
+						&nWidth, &nHeight);
+
+		// Keep the best of a few runs of each step.
+		dDecode = 0.0;
+		dScale = 0.0;
+		for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+			dTime = TestMilliseconds();
+			if (ImageDecodeBmp(lpData, cbData, &ipFull) != IMAGE_OK)
+				return 1;
+			dTime = TestMilliseconds() - dTime;
+			if ((iRun == 0) || (dTime < dDecode))
+				dDecode = dTime;
+
+			dTime = TestMilliseconds();
+			if (ImageDownscale(&ipFull, nWidth, nHeight, &ipScaled) !=
+					IMAGE_OK) {
+				return 1;
+			}
+			dTime = TestMilliseconds() - dTime;
+			if ((iRun == 0) || (dTime < dScale))
+				dScale = dTime;
+
+			ImagePixelsFree(&ipScaled);
+			if (iRun < (NUM_RUNS - 1))
+				ImagePixelsFree(&ipFull);
+		}
+
+		printf("%5ldx%-5ld %4ldx%-4ld %11.2f %11.2f %6ld KB %6ld KB\n",
+			   anSizes[iSize][0], anSizes[iSize][1], nWidth, nHeight, dDecode,
+			   dScale, (ipFull.nStride * ipFull.nHeight) >> 10,
+			   (ImageStride(nWidth) * nHeight) >> 10);
+		ImagePixelsFree(&ipFull);
+		free(lpData);
+	}
+	printf("a cached page skips both steps and keeps only the shrunk "
+		   "bitmap\n");
+
+	return 0;
+}
\ No newline at end of file
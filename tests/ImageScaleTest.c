@@ -0,0 +1,477 @@
+/**
+ * ImageScaleTest.c
+ * Checks that every kind of BMP round-trips exactly, that broken files are
+ * turned down without reading past their end, and that images are shrunk to
+ * within a level of a floating point area average.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "ImageScale.h"
+
+// Definitions.
+#define NUM_SCALES    300
+#define NUM_MUTATIONS 3000
+#define BMP_WIDTH     37
+#define BMP_HEIGHT    23
+
+// Kinds of BMP files to write.
+typedef struct {
+	int nBitCount;
+	int fBitFields;
+} BMP_KIND;
+
+// Every bit depth, with and without masks where they apply.
+const BMP_KIND abkKinds[] = {
+	{ 1, 0 }, { 4, 0 }, { 8, 0 }, { 16, 0 }, { 16, 1 }, { 24, 0 }, { 32, 0 },
+	{ 32, 1 }
+};
+#define NUM_KINDS (sizeof(abkKinds) / sizeof(abkKinds[0]))
+
+// Private methods.
+void MakeRandomImage(IMAGE_PIXELS *lpImage, long nWidth, long nHeight);
+double Overlap(double dStart, double dEnd, long nPixel);
+int AreaAverageError(const IMAGE_PIXELS *lpSource,
+					 const IMAGE_PIXELS *lpScaled);
+void PutLE32(unsigned char *lpData, unsigned long dwValue);
+unsigned char* EncodeBmp(const IMAGE_PIXELS *lpImage, const BMP_KIND *lpKind,
+						 int fTopDown, size_t *lpcbData);
+void ExpectedPixel(const unsigned char *lpPixel, const BMP_KIND *lpKind,
+				   unsigned char *lpExpected);
+int MatchesEncoded(const IMAGE_PIXELS *lpSource, const IMAGE_PIXELS *lpDecoded,
+				   const BMP_KIND *lpKind);
+void CheckScaledSizes(void);
+void CheckDownscale(void);
+void CheckBmpKinds(void);
+
+/**
+ * Allocates an image full of noise.
+ *
+ * @param lpImage Image to be allocated.
+ * @param nWidth  Width of the image.
+ * @param nHeight Height of the image.
+ */
+void MakeRandomImage(IMAGE_PIXELS *lpImage, long nWidth, long nHeight) {
+	long x;
+	long y;
+
+	ImagePixelsAllocate(lpImage, nWidth, nHeight);
+	for (y = 0; y < nHeight; y++) {
+		for (x = 0; x < (nWidth * 3); x++)
+			lpImage->lpBits[(y * lpImage->nStride) + x] =
+				(unsigned char)TestRandom(256);
+	}
+}
+
+/**
+ * Works out how much of a source pixel falls inside a target pixel.
+ *
+ * @param  dStart Start of the target pixel in source pixels.
+ * @param  dEnd   End of the target pixel in source pixels.
+ * @param  nPixel Source pixel.
+ * @return        Fraction of the source pixel that's covered.
+ */
+double Overlap(double dStart, double dEnd, long nPixel) {
+	double dFrom;
+	double dTo;
+
+	dFrom = (dStart > nPixel) ? dStart : (double)nPixel;
+	dTo = (dEnd < (nPixel + 1)) ? dEnd : (double)(nPixel + 1);
+
+	return (dTo > dFrom) ? (dTo - dFrom) : 0.0;
+}
+
+/**
+ * Compares a shrunk image with the exact average of the area every pixel
+ * covers in the source.
+ *
+ * @param  lpSource Original image.
+ * @param  lpScaled Shrunk image.
+ * @return          Largest difference in any channel.
+ */
+int AreaAverageError(const IMAGE_PIXELS *lpSource,
+					 const IMAGE_PIXELS *lpScaled) {
+	double dScaleX;
+	double dScaleY;
+	double dSum;
+	double dWeight;
+	long x;
+	long y;
+	long sx;
+	long sy;
+	int iChannel;
+	int nError;
+	int nMaxError;
+
+	dScaleX = (double)lpSource->nWidth / lpScaled->nWidth;
+	dScaleY = (double)lpSource->nHeight / lpScaled->nHeight;
+	nMaxError = 0;
+	for (y = 0; y < lpScaled->nHeight; y++) {
+		for (x = 0; x < lpScaled->nWidth; x++) {
+			for (iChannel = 0; iChannel < 3; iChannel++) {
+				dSum = 0.0;
+				for (sy = (long)(y * dScaleY); (sy < ((y + 1) * dScaleY)) &&
+						(sy < lpSource->nHeight); sy++) {
+					for (sx = (long)(x * dScaleX); (sx < ((x + 1) * dScaleX))
+							&& (sx < lpSource->nWidth); sx++) {
+						dWeight = Overlap(y * dScaleY, (y + 1) * dScaleY, sy) *
+							Overlap(x * dScaleX, (x + 1) * dScaleX, sx);
+						dSum += dWeight * lpSource->lpBits[(sy *
+							lpSource->nStride) + (sx * 3) + iChannel];
+					}
+				}
+
+				nError = abs(lpScaled->lpBits[(y * lpScaled->nStride) +
+					(x * 3) + iChannel] - (int)((dSum / (dScaleX * dScaleY)) +
+					0.5));
+				if (nError > nMaxError)
+					nMaxError = nError;
+			}
+		}
+	}
+
+	return nMaxError;
+}
+
+/**
+ * Writes a little-endian 32-bit value.
+ *
+ * @param lpData  Where to write it.
+ * @param dwValue Value to be written.
+ */
+void PutLE32(unsigned char *lpData, unsigned long dwValue) {
+	lpData[0] = (unsigned char)dwValue;
+	lpData[1] = (unsigned char)(dwValue >> 8);
+	lpData[2] = (unsigned char)(dwValue >> 16);
+	lpData[3] = (unsigned char)(dwValue >> 24);
+}
+
+/**
+ * Encodes an image as a BMP file. Palettes map index i to the colour
+ * (i * 7, i * 13, i * 29) in BGR order, and the index of a pixel is taken
+ * from its blue channel.
+ *
+ * @param  lpImage  Image to be encoded.
+ * @param  lpKind   Kind of file to write.
+ * @param  fTopDown Should the rows go from top to bottom?
+ * @param  lpcbData Size of the file.
+ * @return          Contents of the file. Free it with free.
+ */
+unsigned char* EncodeBmp(const IMAGE_PIXELS *lpImage, const BMP_KIND *lpKind,
+						 int fTopDown, size_t *lpcbData) {
+	const unsigned char *lpPixel;
+	unsigned char *lpData;
+	unsigned char *lpRow;
+	unsigned long dwValue;
+	size_t dwOffset;
+	long nStride;
+	long nColors;
+	long x;
+	long y;
+	int nBits;
+	int iIndex;
+
+	// Work out the layout.
+	nBits = lpKind->nBitCount;
+	nStride = (((lpImage->nWidth * nBits) + 31) / 32) * 4;
+	nColors = (nBits <= 8) ? (1L << nBits) : 0L;
+	dwOffset = 14 + 40 + (lpKind->fBitFields ? 12 : 0) + (nColors * 4);
+	*lpcbData = dwOffset + (nStride * lpImage->nHeight);
+	lpData = (unsigned char*)calloc(1, *lpcbData);
+
+	// Headers.
+	lpData[0] = 'B';
+	lpData[1] = 'M';
+	PutLE32(lpData + 2, (unsigned long)*lpcbData);
+	PutLE32(lpData + 10, (unsigned long)dwOffset);
+	PutLE32(lpData + 14, 40);
+	PutLE32(lpData + 18, (unsigned long)lpImage->nWidth);
+	PutLE32(lpData + 22, (unsigned long)(fTopDown ? -lpImage->nHeight :
+		lpImage->nHeight));
+	lpData[26] = 1;
+	lpData[28] = (unsigned char)nBits;
+	PutLE32(lpData + 30, lpKind->fBitFields ? 3 : 0);
+
+	// Masks or palette.
+	if (lpKind->fBitFields) {
+		PutLE32(lpData + 54, (nBits == 16) ? 0xF800 : 0xFF0000);
+		PutLE32(lpData + 58, (nBits == 16) ? 0x07E0 : 0x00FF00);
+		PutLE32(lpData + 62, (nBits == 16) ? 0x001F : 0x0000FF);
+	}
+	for (iIndex = 0; iIndex < nColors; iIndex++) {
+		lpData[54 + (iIndex * 4)] = (unsigned char)(iIndex * 7);
+		lpData[55 + (iIndex * 4)] = (unsigned char)(iIndex * 13);
+		lpData[56 + (iIndex * 4)] = (unsigned char)(iIndex * 29);
+	}
+
+	// Pixels.
+	for (y = 0; y < lpImage->nHeight; y++) {
+		lpRow = lpData + dwOffset + ((fTopDown ? y :
+			(lpImage->nHeight - 1 - y)) * nStride);
+		for (x = 0; x < lpImage->nWidth; x++) {
+			lpPixel = lpImage->lpBits + (y * lpImage->nStride) + (x * 3);
+			switch (nBits) {
+			case 24:
+			case 32:
+				memcpy(lpRow + (x * (nBits / 8)), lpPixel, 3);
+				break;
+			case 16:
+				if (lpKind->fBitFields) {
+					dwValue = ((lpPixel[2] >> 3) << 11) |
+						((lpPixel[1] >> 2) << 5) | (lpPixel[0] >> 3);
+				} else {
+					dwValue = ((lpPixel[2] >> 3) << 10) |
+						((lpPixel[1] >> 3) << 5) | (lpPixel[0] >> 3);
+				}
+				lpRow[x * 2] = (unsigned char)dwValue;
+				lpRow[(x * 2) + 1] = (unsigned char)(dwValue >> 8);
+				break;
+			default:
+				iIndex = lpPixel[0] % nColors;
+				lpRow[(x * nBits) / 8] |= (unsigned char)(iIndex <<
+					(8 - nBits - ((x * nBits) % 8)));
+				break;
+			}
+		}
+	}
+
+	return lpData;
+}
+
+/**
+ * Works out what a pixel should decode to after going through a BMP file.
+ *
+ * @param lpPixel    Original pixel.
+ * @param lpKind     Kind of file it went through.
+ * @param lpExpected Buffer for the 3 channels of the decoded pixel.
+ */
+void ExpectedPixel(const unsigned char *lpPixel, const BMP_KIND *lpKind,
+				   unsigned char *lpExpected) {
+	int iIndex;
+
+	switch (lpKind->nBitCount) {
+	case 24:
+	case 32:
+		memcpy(lpExpected, lpPixel, 3);
+		break;
+	case 16:
+		// Channels are widened back to 8 bits with rounding.
+		lpExpected[0] = (unsigned char)((((lpPixel[0] >> 3) * 255) + 15) / 31);
+		lpExpected[2] = (unsigned char)((((lpPixel[2] >> 3) * 255) + 15) / 31);
+		if (lpKind->fBitFields) {
+			lpExpected[1] = (unsigned char)((((lpPixel[1] >> 2) * 255) + 31) /
+				63);
+		} else {
+			lpExpected[1] = (unsigned char)((((lpPixel[1] >> 3) * 255) + 15) /
+				31);
+		}
+		break;
+	default:
+		iIndex = lpPixel[0] % (1 << lpKind->nBitCount);
+		lpExpected[0] = (unsigned char)(iIndex * 7);
+		lpExpected[1] = (unsigned char)(iIndex * 13);
+		lpExpected[2] = (unsigned char)(iIndex * 29);
+		break;
+	}
+}
+
+/**
+ * Checks that a decoded image is what its source should have become.
+ *
+ * @param  lpSource  Image that was encoded.
+ * @param  lpDecoded Image that was decoded.
+ * @param  lpKind    Kind of file it went through.
+ * @return           Non-zero if every pixel is right.
+ */
+int MatchesEncoded(const IMAGE_PIXELS *lpSource, const IMAGE_PIXELS *lpDecoded,
+				   const BMP_KIND *lpKind) {
+	unsigned char abExpected[3];
+	long x;
+	long y;
+
+	if ((lpDecoded->nWidth != lpSource->nWidth) ||
+			(lpDecoded->nHeight != lpSource->nHeight)) {
+		return 0;
+	}
+
+	for (y = 0; y < lpSource->nHeight; y++) {
+		for (x = 0; x < lpSource->nWidth; x++) {
+			ExpectedPixel(lpSource->lpBits + (y * lpSource->nStride) + (x * 3),
+						  lpKind, abExpected);
+			if (memcmp(abExpected, lpDecoded->lpBits +
+					(y * lpDecoded->nStride) + (x * 3), 3) != 0) {
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Checks the sizes images are shrunk to.
+ */
+void CheckScaledSizes(void) {
+	long nWidth;
+	long nHeight;
+
+	ImageScaledSize(1600, 1200, 240, &nWidth, &nHeight);
+	TEST_CHECK((nWidth == 240) && (nHeight == 180));
+	ImageScaledSize(100, 50, 240, &nWidth, &nHeight);
+	TEST_CHECK((nWidth == 100) && (nHeight == 50));
+	ImageScaledSize(1000, 1, 10, &nWidth, &nHeight);
+	TEST_CHECK((nWidth == 10) && (nHeight == 1));
+	ImageScaledSize(300, 200, 0, &nWidth, &nHeight);
+	TEST_CHECK((nWidth == 300) && (nHeight == 200));
+	TEST_CHECK(ImageStride(1) == 4);
+	TEST_CHECK(ImageStride(4) == 12);
+}
+
+/**
+ * Shrinks random images to random sizes and compares them with the exact area
+ * average.
+ */
+void CheckDownscale(void) {
+	IMAGE_PIXELS ipSource;
+	IMAGE_PIXELS ipScaled;
+	long nWidth;
+	long nHeight;
+	int nError;
+	int nMaxError;
+	int iCase;
+
+	// Images are never made larger.
+	MakeRandomImage(&ipSource, 4, 4);
+	TEST_CHECK(ImageDownscale(&ipSource, 5, 4, &ipScaled) == IMAGE_ERR_TOOBIG);
+	ImagePixelsFree(&ipSource);
+
+	TestSeed(25);
+	nMaxError = 0;
+	for (iCase = 0; iCase < NUM_SCALES; iCase++) {
+		nWidth = 1 + (long)TestRandom(300);
+		nHeight = 1 + (long)TestRandom(200);
+		MakeRandomImage(&ipSource, nWidth, nHeight);
+		nWidth = 1 + (long)TestRandom((unsigned long)nWidth);
+		nHeight = 1 + (long)TestRandom((unsigned long)nHeight);
+
+		if (ImageDownscale(&ipSource, nWidth, nHeight, &ipScaled) !=
+				IMAGE_OK) {
+			nMaxError = 256;
+		} else {
+			nError = AreaAverageError(&ipSource, &ipScaled);
+			if (nError > nMaxError)
+				nMaxError = nError;
+			ImagePixelsFree(&ipScaled);
+		}
+		ImagePixelsFree(&ipSource);
+	}
+
+	printf("%d random sizes, off by at most %d levels\n", NUM_SCALES,
+		   nMaxError);
+	TEST_CHECK(nMaxError <= 1);
+}
+
+/**
+ * Round-trips an image through every kind of BMP and checks that truncated
+ * or mangled copies of them are decoded safely or turned down.
+ */
+void CheckBmpKinds(void) {
+	IMAGE_PIXELS ipSource;
+	IMAGE_PIXELS ipDecoded;
+	IMAGE_PIXELS ipScaled;
+	unsigned char *lpData;
+	unsigned char *lpMutated;
+	size_t cbData;
+	size_t cbMutated;
+	long nWidth;
+	long nHeight;
+	long nBroken;
+	int fTopDown;
+	int iKind;
+	int iCase;
+	int i;
+
+	TestSeed(250);
+	nBroken = 0L;
+	for (iKind = 0; iKind < (int)NUM_KINDS; iKind++) {
+		for (fTopDown = 0; fTopDown <= 1; fTopDown++) {
+			MakeRandomImage(&ipSource, BMP_WIDTH, BMP_HEIGHT);
+			lpData = EncodeBmp(&ipSource, &abkKinds[iKind], fTopDown, &cbData);
+			TEST_CHECK(ImageDecodeBmp(lpData, cbData, &ipDecoded) == IMAGE_OK);
+			TEST_CHECK(MatchesEncoded(&ipSource, &ipDecoded, &abkKinds[iKind]));
+			ImagePixelsFree(&ipDecoded);
+
+			// Cut the file short or scribble over it, mostly in the headers.
+			for (iCase = 0; iCase < NUM_MUTATIONS; iCase++) {
+				lpMutated = (unsigned char*)malloc(cbData);
+				memcpy(lpMutated, lpData, cbData);
+				cbMutated = cbData;
+				if ((iCase % 3) == 0) {
+					cbMutated = TestRandom(cbData);
+				} else {
+					for (i = (int)TestRandom(6); i >= 0; i--) {
+						lpMutated[TestRandom((iCase % 2) ? 70 : cbData)] =
+							(unsigned char)TestRandom(256);
+					}
+				}
+
+				// Whatever comes out must be usable.
+				if (ImageDecodeBmp(lpMutated, cbMutated, &ipDecoded) ==
+						IMAGE_OK) {
+					if ((ipDecoded.nWidth > IMAGE_MAX_DIMENSION) ||
+							(ipDecoded.nHeight > IMAGE_MAX_DIMENSION)) {
+						nBroken++;
+					}
+					ImageScaledSize(ipDecoded.nWidth, ipDecoded.nHeight, 16,
+									&nWidth, &nHeight);
+					if (ImageDownscale(&ipDecoded, nWidth, nHeight,
+							&ipScaled) == IMAGE_OK) {
+						ImagePixelsFree(&ipScaled);
+					} else {
+						nBroken++;
+					}
+					ImagePixelsFree(&ipDecoded);
+				} else if (ipDecoded.lpBits != NULL) {
+					nBroken++;
+				}
+				free(lpMutated);
+			}
+
+			free(lpData);
+			ImagePixelsFree(&ipSource);
+		}
+	}
+
+	// Things that aren't BMP files at all, or are too big or too small.
+	TEST_CHECK(ImageDecodeBmp((const unsigned char*)"GIF89a", 6, &ipDecoded) ==
+			   IMAGE_ERR_FORMAT);
+	MakeRandomImage(&ipSource, 1, 1);
+	lpData = EncodeBmp(&ipSource, &abkKinds[0], 0, &cbData);
+	PutLE32(lpData + 18, IMAGE_MAX_DIMENSION + 1);
+	TEST_CHECK(ImageDecodeBmp(lpData, cbData, &ipDecoded) == IMAGE_ERR_TOOBIG);
+	PutLE32(lpData + 18, 0);
+	TEST_CHECK(ImageDecodeBmp(lpData, cbData, &ipDecoded) == IMAGE_ERR_CORRUPT);
+	free(lpData);
+	ImagePixelsFree(&ipSource);
+
+	printf("%d kinds of files with %d mutations each, %ld went wrong\n",
+		   (int)(NUM_KINDS * 2), NUM_MUTATIONS, nBroken);
+	TEST_CHECK(nBroken == 0L);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	CheckScaledSizes();
+	CheckDownscale();
+	CheckBmpKinds();
+
+	return TestFinish("ImageScaleTest");
+}
\ No newline at end of file
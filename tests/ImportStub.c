@@ -0,0 +1,221 @@
+/**
+ * ImportStub.c
+ * A stand-in for the parts of UkiHelper and DependencyIndex that the page
+ * import uses, which keeps a list of the pages registered with it.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "ImportStub.h"
+#include <stdlib.h>
+#include <string.h>
+#include "UkiHelper.h"
+#include "DependencyIndex.h"
+
+// Pages registered with the engine.
+typedef struct {
+	TCHAR (*lpszPaths)[MAX_PATH];
+	LONG nPages;
+	LONG nCapacity;
+} STUB_PAGES;
+
+// Global variables.
+LPCTSTR szStubArticles = NULL;
+LPCTSTR szStubTemplates = NULL;
+STUB_PAGES spArticles = { NULL, 0L, 0L };
+STUB_PAGES spTemplates = { NULL, 0L, 0L };
+BOOL bStubIndexReady = FALSE;
+LONG nStubIndexBuilds = 0L;
+
+// Private methods.
+LONG AddStubPage(STUB_PAGES *lpPages, LPCTSTR szFilePath);
+
+/**
+ * Sets the folders pages get imported into. They aren't copied, so they must
+ * outlive their use.
+ *
+ * @param szArticles  Articles folder, or NULL if there isn't a workspace.
+ * @param szTemplates Templates folder.
+ */
+void ImportStubSetFolders(LPCTSTR szArticles, LPCTSTR szTemplates) {
+	szStubArticles = szArticles;
+	szStubTemplates = szTemplates;
+}
+
+/**
+ * Sets if the dependency index has been built, which is when an import has
+ * to build it again.
+ *
+ * @param bReady Has the index been built?
+ */
+void ImportStubSetIndexReady(BOOL bReady) {
+	bStubIndexReady = bReady;
+}
+
+/**
+ * Forgets every page that was registered and every index build.
+ */
+void ImportStubReset(void) {
+	free(spArticles.lpszPaths);
+	free(spTemplates.lpszPaths);
+	memset(&spArticles, 0, sizeof(STUB_PAGES));
+	memset(&spTemplates, 0, sizeof(STUB_PAGES));
+	nStubIndexBuilds = 0L;
+}
+
+/**
+ * Gets the number of articles registered.
+ *
+ * @return Number of articles.
+ */
+LONG ImportStubArticleCount(void) {
+	return spArticles.nPages;
+}
+
+/**
+ * Gets the number of templates registered.
+ *
+ * @return Number of templates.
+ */
+LONG ImportStubTemplateCount(void) {
+	return spTemplates.nPages;
+}
+
+/**
+ * Gets the path an article was registered with.
+ *
+ * @param  nIndex Index of the article.
+ * @return        Path to the article, or an empty one if there isn't one.
+ */
+LPCTSTR ImportStubArticlePath(LONG nIndex) {
+	if ((nIndex < 0L) || (nIndex >= spArticles.nPages))
+		return L"";
+
+	return spArticles.lpszPaths[nIndex];
+}
+
+/**
+ * Gets the path a template was registered with.
+ *
+ * @param  nIndex Index of the template.
+ * @return        Path to the template, or an empty one if there isn't one.
+ */
+LPCTSTR ImportStubTemplatePath(LONG nIndex) {
+	if ((nIndex < 0L) || (nIndex >= spTemplates.nPages))
+		return L"";
+
+	return spTemplates.lpszPaths[nIndex];
+}
+
+/**
+ * Gets the number of times the dependency index was built.
+ *
+ * @return Number of builds.
+ */
+LONG ImportStubIndexBuilds(void) {
+	return nStubIndexBuilds;
+}
+
+/**
+ * Gets the number of articles in the engine.
+ *
+ * @return Number of articles.
+ */
+LONG GetUkiArticlesAvailable() {
+	return spArticles.nPages;
+}
+
+/**
+ * Gets the number of templates in the engine.
+ *
+ * @return Number of templates.
+ */
+LONG GetUkiTemplatesAvailable() {
+	return spTemplates.nPages;
+}
+
+/**
+ * Gets the folder the articles are in.
+ *
+ * @return Articles folder, or NULL if there isn't a workspace.
+ */
+LPCTSTR GetUkiArticlesFolder() {
+	return szStubArticles;
+}
+
+/**
+ * Gets the folder the templates are in.
+ *
+ * @return Templates folder, or NULL if there isn't a workspace.
+ */
+LPCTSTR GetUkiTemplatesFolder() {
+	return szStubTemplates;
+}
+
+/**
+ * Registers an article with the engine.
+ *
+ * @param  szFilePath Path to the article.
+ * @return            Index of the article or -1 if it couldn't be added.
+ */
+LONG AddUkiArticle(LPCTSTR szFilePath) {
+	return AddStubPage(&spArticles, szFilePath);
+}
+
+/**
+ * Registers a template with the engine.
+ *
+ * @param  szFilePath Path to the template.
+ * @return            Index of the template or -1 if it couldn't be added.
+ */
+LONG AddUkiTemplate(LPCTSTR szFilePath) {
+	return AddStubPage(&spTemplates, szFilePath);
+}
+
+/**
+ * Builds the dependency index, which here only counts the builds.
+ *
+ * @return Always TRUE.
+ */
+BOOL BuildDependencyIndex() {
+	nStubIndexBuilds++;
+	bStubIndexReady = TRUE;
+
+	return TRUE;
+}
+
+/**
+ * Checks if the dependency index has been built.
+ *
+ * @return TRUE if it has.
+ */
+BOOL IsDependencyIndexReady() {
+	return bStubIndexReady;
+}
+
+/**
+ * Appends a page to a list of registered pages.
+ *
+ * @param  lpPages    List of pages.
+ * @param  szFilePath Path to the page.
+ * @return            Index of the page or -1 if it couldn't be added.
+ */
+LONG AddStubPage(STUB_PAGES *lpPages, LPCTSTR szFilePath) {
+	TCHAR (*lpszPaths)[MAX_PATH];
+
+	if (wcslen(szFilePath) >= MAX_PATH)
+		return -1L;
+
+	// Make room for it.
+	if (lpPages->nPages == lpPages->nCapacity) {
+		lpszPaths = realloc(lpPages->lpszPaths, ((lpPages->nCapacity * 2) +
+			16) * sizeof(lpPages->lpszPaths[0]));
+		if (lpszPaths == NULL)
+			return -1L;
+		lpPages->lpszPaths = lpszPaths;
+		lpPages->nCapacity = (lpPages->nCapacity * 2) + 16;
+	}
+
+	wcscpy(lpPages->lpszPaths[lpPages->nPages], szFilePath);
+	return lpPages->nPages++;
+}
\ No newline at end of file
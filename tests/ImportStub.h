@@ -0,0 +1,26 @@
+/**
+ * ImportStub.h
+ * A stand-in for the parts of UkiHelper and DependencyIndex that the page
+ * import uses, which keeps a list of the pages registered with it.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _IMPORTSTUB_H
+#define _IMPORTSTUB_H
+
+#include <windows.h>
+
+// Setup.
+void ImportStubSetFolders(LPCTSTR szArticles, LPCTSTR szTemplates);
+void ImportStubSetIndexReady(BOOL bReady);
+void ImportStubReset(void);
+
+// Inspection.
+LONG ImportStubArticleCount(void);
+LONG ImportStubTemplateCount(void);
+LPCTSTR ImportStubArticlePath(LONG nIndex);
+LPCTSTR ImportStubTemplatePath(LONG nIndex);
+LONG ImportStubIndexBuilds(void);
+
+#endif  // _IMPORTSTUB_H
\ No newline at end of file
@@ -0,0 +1,121 @@
+/**
+ * JournalStub.c
+ * A stand-in for the parts of PageManager and UkiHelper that the edit journal
+ * uses, which holds the text of the page editor and the workspace folder that
+ * a test gives it.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "JournalStub.h"
+#include <stdlib.h>
+#include <string.h>
+#include "PageManager.h"
+#include "UkiHelper.h"
+#include "Win32Shim.h"
+
+// Global variables.
+TCHAR szStubWorkspace[MAX_PATH];
+LPTSTR szStubText = NULL;
+DWORD cchStubText = 0;
+BOOL fStubDirty = FALSE;
+DWORD dwStubGeneration = 0;
+
+/**
+ * Sets the root of the workspace, where the journal lives.
+ *
+ * @param szaFolder Path to the workspace folder.
+ */
+void JournalStubSetWorkspace(const char *szaFolder) {
+	Win32ShimWidenPath(szStubWorkspace, szaFolder);
+}
+
+/**
+ * Replaces the text of the page editor, as if the user had edited it.
+ *
+ * @param  szText  New text of the editor.
+ * @param  cchText Length of the text.
+ * @param  fDirty  Is the text different from what's on disk?
+ * @return         TRUE if the text could be copied.
+ */
+BOOL JournalStubSetText(LPCTSTR szText, DWORD cchText, BOOL fDirty) {
+	LPTSTR szCopy;
+
+	// Kept out of the local memory accounting, which is the journal's.
+	szCopy = (LPTSTR)malloc((cchText + 1) * sizeof(TCHAR));
+	if (szCopy == NULL)
+		return FALSE;
+	memcpy(szCopy, szText, cchText * sizeof(TCHAR));
+	szCopy[cchText] = L'\0';
+
+	free(szStubText);
+	szStubText = szCopy;
+	cchStubText = cchText;
+	fStubDirty = fDirty;
+	dwStubGeneration++;
+
+	return TRUE;
+}
+
+/**
+ * Forgets the text of the page editor.
+ */
+void JournalStubFree(void) {
+	free(szStubText);
+	szStubText = NULL;
+	cchStubText = 0;
+}
+
+/**
+ * Gets the root of the current workspace.
+ *
+ * @return Path to the workspace folder.
+ */
+LPTSTR GetCurrentWorkspace() {
+	return szStubWorkspace;
+}
+
+/**
+ * Answers the messages the journal sends to the page editor.
+ *
+ * @param  wMsg   Message, either WM_GETTEXTLENGTH or WM_GETTEXT.
+ * @param  wParam Size of the buffer for WM_GETTEXT.
+ * @param  lParam Buffer that receives the text for WM_GETTEXT.
+ * @return        Length of the text, or 0 for any other message.
+ */
+LRESULT SendPageEditMessage(UINT wMsg, WPARAM wParam, LPARAM lParam) {
+	DWORD cchCopy;
+
+	switch (wMsg) {
+		case WM_GETTEXTLENGTH:
+			return (LRESULT)cchStubText;
+		case WM_GETTEXT:
+			if (wParam == 0)
+				return 0;
+			cchCopy = min(cchStubText, (DWORD)wParam - 1);
+			if (cchCopy > 0)
+				memcpy((LPTSTR)lParam, szStubText, cchCopy * sizeof(TCHAR));
+			((LPTSTR)lParam)[cchCopy] = L'\0';
+			return (LRESULT)cchCopy;
+	}
+
+	return 0;
+}
+
+/**
+ * Checks if the text of the page editor is different from what's on disk.
+ *
+ * @return TRUE if the text was changed.
+ */
+BOOL IsPageDirty() {
+	return fStubDirty;
+}
+
+/**
+ * Gets a number that changes every time the text of the editor changes.
+ *
+ * @return Edit generation.
+ */
+DWORD GetPageEditGeneration() {
+	return dwStubGeneration;
+}
\ No newline at end of file
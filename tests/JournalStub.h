@@ -0,0 +1,20 @@
+/**
+ * JournalStub.h
+ * A stand-in for the parts of PageManager and UkiHelper that the edit journal
+ * uses, which holds the text of the page editor and the workspace folder that
+ * a test gives it.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _JOURNALSTUB_H
+#define _JOURNALSTUB_H
+
+#include <windows.h>
+
+// Setup.
+void JournalStubSetWorkspace(const char *szaFolder);
+BOOL JournalStubSetText(LPCTSTR szText, DWORD cchText, BOOL fDirty);
+void JournalStubFree(void);
+
+#endif  // _JOURNALSTUB_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+/**
+ * PageImportBench.c
+ * Measures importing a folder of 10k exported pages in a single batch, and
+ * compares adding them to the article tree at once with the old way of
+ * rebuilding the whole tree after every new page.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "UkiStub.h"
+#include "ImportStub.h"
+#include "PageImport.h"
+#include "ArticleTree.h"
+
+// Definitions.
+#define NUM_PAGES    10000L
+#define NUM_SECTIONS 50L
+#define SAMPLE_STEP  100L
+#define NUM_RUNS     5
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	PAGEIMPORT_REPORT prReport;
+	uki_article_t *lpArticles;
+	ARTICLETREE atTree;
+	WCHAR szArticles[MAX_PATH];
+	WCHAR szTemplates[MAX_PATH];
+	WCHAR szFolder[MAX_PATH];
+	char szaRoot[256];
+	char szaPath[512];
+	char szaPage[2048];
+	char *szaParents;
+	char *szaNames;
+	double dImport;
+	double dBatch;
+	double dRebuild;
+	double dTime;
+	long i;
+	long nPages;
+	int iRun;
+
+	// Set up a workspace and a folder of exported pages.
+	TestMakeFolder(szaRoot, "importbench");
+	sprintf(szaPath, "%s/articles", szaRoot);
+	mkdir(szaPath, 0755);
+	Win32ShimWidenPath(szArticles, szaPath);
+	sprintf(szaPath, "%s/templates", szaRoot);
+	mkdir(szaPath, 0755);
+	Win32ShimWidenPath(szTemplates, szaPath);
+	sprintf(szaPath, "%s/export", szaRoot);
+	mkdir(szaPath, 0755);
+	Win32ShimWidenPath(szFolder, szaPath);
+	ImportStubSetFolders(szArticles, szTemplates);
+
+	memset(szaPage, 'x', sizeof(szaPage));
+	for (i = 0L; i < NUM_PAGES; i++) {
+		sprintf(szaPath, "%s/export/page%05ld.html", szaRoot, i);
+		TestWriteFile(szaPath, szaPage, sizeof(szaPage));
+	}
+
+	// Copy and register the whole folder.
+	dTime = TestMilliseconds();
+	if (!ImportPageFolder(szFolder, TRUE, &prReport) ||
+			(prReport.ukiAdded.nAdded != NUM_PAGES)) {
+		printf("The import didn't add every page\n");
+		return 1;
+	}
+	dImport = TestMilliseconds() - dTime;
+	printf("%ld pages of %lu bytes imported in %.1f ms\n", NUM_PAGES,
+		   (unsigned long)sizeof(szaPage), dImport);
+
+	// Pages spread across a few sections, like the engine would list them.
+	lpArticles = (uki_article_t*)malloc(NUM_PAGES * sizeof(uki_article_t));
+	szaParents = (char*)malloc(NUM_SECTIONS * 16);
+	szaNames = (char*)malloc(NUM_PAGES * 16);
+	for (i = 0L; i < NUM_SECTIONS; i++)
+		sprintf(szaParents + (i * 16), "sec%02ld", i);
+	for (i = 0L; i < NUM_PAGES; i++) {
+		sprintf(szaNames + (i * 16), "page%05ld", i);
+		lpArticles[i].path = NULL;
+		lpArticles[i].name = szaNames + (i * 16);
+		lpArticles[i].parent = szaParents + ((i % NUM_SECTIONS) * 16);
+		lpArticles[i].deepness = 1;
+	}
+
+	// Add all of them to the tree in one go, keeping the best of a few runs.
+	dBatch = 0.0;
+	for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+		dTime = TestMilliseconds();
+		ArticleTreeInitialize(&atTree);
+		for (i = 0L; i < NUM_PAGES; i++) {
+			ArticleTreeAddArticle(&atTree, i, lpArticles[i].parent,
+								  lpArticles[i].name);
+		}
+		dTime = TestMilliseconds() - dTime;
+		ArticleTreeFree(&atTree);
+
+		if ((iRun == 0) || (dTime < dBatch))
+			dBatch = dTime;
+	}
+
+	// Rebuilding after every page takes time that grows with the tree, so
+	// time every hundredth rebuild and count it for the ones around it.
+	dRebuild = 0.0;
+	for (nPages = SAMPLE_STEP / 2; nPages <= NUM_PAGES; nPages += SAMPLE_STEP) {
+		UkiStubSetArticles(lpArticles, (size_t)nPages);
+		dTime = TestMilliseconds();
+		ArticleTreeInitialize(&atTree);
+		ArticleTreeBuildFromUki(&atTree);
+		dRebuild += TestMilliseconds() - dTime;
+		ArticleTreeFree(&atTree);
+	}
+	dRebuild *= SAMPLE_STEP;
+
+	printf("tree: single batch %.2f ms, rebuilt after each page about "
+		   "%.0f ms\n", dBatch, dRebuild);
+
+	free(lpArticles);
+	free(szaParents);
+	free(szaNames);
+	ImportStubReset();
+	TestRemoveFolder(szaRoot);
+	return 0;
+}
\ No newline at end of file
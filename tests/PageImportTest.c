@@ -0,0 +1,269 @@
+/**
+ * PageImportTest.c
+ * Checks that importing pages copies them into the workspace without
+ * overwriting anything, registers them in order once they're all copied, and
+ * only rebuilds the dependency index once per batch.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "ImportStub.h"
+#include "PageImport.h"
+
+// Definitions.
+#define NUM_MANY 500
+
+// Private methods.
+int FileEquals(const char *szaPath, const char *szaContents);
+int EndsWith(LPCTSTR szPath, const char *szaName);
+void CheckFolderImport(const char *szaRoot);
+void CheckFileImport(const char *szaRoot);
+void CheckManyFiles(const char *szaRoot);
+
+/**
+ * Checks if a file holds exactly the text given.
+ *
+ * @param  szaPath     Path to the file.
+ * @param  szaContents Text it should have.
+ * @return             Non-zero if it does.
+ */
+int FileEquals(const char *szaPath, const char *szaContents) {
+	char szaBuffer[256];
+	size_t cbRead;
+	FILE *fh;
+
+	fh = fopen(szaPath, "rb");
+	if (fh == NULL)
+		return 0;
+	cbRead = fread(szaBuffer, 1, sizeof(szaBuffer), fh);
+	fclose(fh);
+
+	return (cbRead == strlen(szaContents)) &&
+		(memcmp(szaBuffer, szaContents, cbRead) == 0);
+}
+
+/**
+ * Checks if a path ends with a file name.
+ *
+ * @param  szPath  Path to be checked.
+ * @param  szaName Name of the file.
+ * @return         Non-zero if the path is to that file.
+ */
+int EndsWith(LPCTSTR szPath, const char *szaName) {
+	char szaPath[MAX_PATH * 4];
+	size_t cbPath;
+	size_t cbName;
+
+	cbPath = Win32ShimNarrowPath(szaPath, szPath);
+	cbName = strlen(szaName);
+
+	return (cbPath > cbName) && (szaPath[cbPath - cbName - 1] == '/') &&
+		(strcmp(szaPath + cbPath - cbName, szaName) == 0);
+}
+
+/**
+ * Imports a folder of exported pages into a workspace that already has one of
+ * them.
+ *
+ * @param szaRoot Folder to work in.
+ */
+void CheckFolderImport(const char *szaRoot) {
+	PAGEIMPORT_REPORT prReport;
+	WCHAR szFolder[MAX_PATH];
+	char szaPath[512];
+	LONG i;
+	int fFoundA;
+	int fFoundB;
+
+	// Pages to import, with things that aren't pages mixed in.
+	sprintf(szaPath, "%s/export/a.html", szaRoot);
+	TestWriteFile(szaPath, "page a", 6);
+	sprintf(szaPath, "%s/export/b.htm", szaRoot);
+	TestWriteFile(szaPath, "page b", 6);
+	sprintf(szaPath, "%s/export/c.html", szaRoot);
+	TestWriteFile(szaPath, "new c", 5);
+	sprintf(szaPath, "%s/export/notes.txt", szaRoot);
+	TestWriteFile(szaPath, "notes", 5);
+	sprintf(szaPath, "%s/export/folder.html", szaRoot);
+	mkdir(szaPath, 0755);
+	sprintf(szaPath, "%s/articles/c.html", szaRoot);
+	TestWriteFile(szaPath, "old c", 5);
+
+	// The page that's already there is left alone.
+	sprintf(szaPath, "%s/export", szaRoot);
+	Win32ShimWidenPath(szFolder, szaPath);
+	TEST_CHECK(ImportPageFolder(szFolder, TRUE, &prReport));
+	TEST_CHECK((prReport.ukiAdded.nAdded == 2L) && (prReport.nFailed == 1L));
+	TEST_CHECK((prReport.ukiAdded.nFirstNewArticle == 0L) &&
+			   (prReport.ukiAdded.nFirstNewTemplate == 0L));
+	TEST_CHECK((prReport.ukiAdded.nRemoved == 0L) &&
+			   (prReport.ukiAdded.nChanged == 0L));
+	sprintf(szaPath, "%s/articles/a.html", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "page a"));
+	sprintf(szaPath, "%s/articles/b.htm", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "page b"));
+	sprintf(szaPath, "%s/articles/c.html", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "old c"));
+	sprintf(szaPath, "%s/articles/notes.txt", szaRoot);
+	TEST_CHECK(!FileEquals(szaPath, "notes"));
+
+	// Both copies were registered, from the workspace.
+	fFoundA = 0;
+	fFoundB = 0;
+	TEST_CHECK(ImportStubArticleCount() == 2L);
+	for (i = 0L; i < ImportStubArticleCount(); i++) {
+		fFoundA |= EndsWith(ImportStubArticlePath(i), "articles/a.html");
+		fFoundB |= EndsWith(ImportStubArticlePath(i), "articles/b.htm");
+	}
+	TEST_CHECK(fFoundA && fFoundB);
+	TEST_CHECK(ImportStubIndexBuilds() == 0L);
+
+	// Importing the same folder again adds nothing.
+	TEST_CHECK(ImportPageFolder(szFolder, TRUE, &prReport));
+	TEST_CHECK((prReport.ukiAdded.nAdded == 0L) && (prReport.nFailed == 3L) &&
+			   (prReport.ukiAdded.nFirstNewArticle == 2L));
+	TEST_CHECK(ImportStubArticleCount() == 2L);
+
+	// A folder that isn't there has nothing to import.
+	sprintf(szaPath, "%s/missing", szaRoot);
+	Win32ShimWidenPath(szFolder, szaPath);
+	TEST_CHECK(ImportPageFolder(szFolder, TRUE, &prReport));
+	TEST_CHECK((prReport.ukiAdded.nAdded == 0L) && (prReport.nFailed == 0L));
+}
+
+/**
+ * Imports a list of templates, some of which can't be imported.
+ *
+ * @param szaRoot Folder to work in.
+ */
+void CheckFileImport(const char *szaRoot) {
+	PAGEIMPORT_REPORT prReport;
+	WCHAR aszFiles[3][MAX_PATH];
+	LPCTSTR aszList[3];
+	char szaPath[512];
+
+	// Paths are given the Windows way, which is where the import takes the
+	// name of the file from.
+	sprintf(szaPath, "%s\\export\\a.html", szaRoot);
+	Win32ShimWidenPath(aszFiles[0], szaPath);
+	sprintf(szaPath, "%s\\export\\gone.html", szaRoot);
+	Win32ShimWidenPath(aszFiles[1], szaPath);
+	sprintf(szaPath, "%s\\export\\b.htm", szaRoot);
+	Win32ShimWidenPath(aszFiles[2], szaPath);
+	aszList[0] = aszFiles[0];
+	aszList[1] = aszFiles[1];
+	aszList[2] = aszFiles[2];
+
+	// The dependency index is built once for the whole batch.
+	ImportStubSetIndexReady(TRUE);
+	TEST_CHECK(ImportPageFiles(aszList, 3L, FALSE, &prReport));
+	TEST_CHECK((prReport.ukiAdded.nAdded == 2L) && (prReport.nFailed == 1L));
+	TEST_CHECK((prReport.ukiAdded.nFirstNewArticle == 2L) &&
+			   (prReport.ukiAdded.nFirstNewTemplate == 0L));
+	TEST_CHECK(ImportStubIndexBuilds() == 1L);
+
+	// Templates are registered in the order they were given.
+	TEST_CHECK(ImportStubTemplateCount() == 2L);
+	TEST_CHECK(EndsWith(ImportStubTemplatePath(0), "templates/a.html"));
+	TEST_CHECK(EndsWith(ImportStubTemplatePath(1), "templates/b.htm"));
+	sprintf(szaPath, "%s/templates/b.htm", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "page b"));
+
+	// Nothing added means nothing to rebuild.
+	TEST_CHECK(ImportPageFiles(aszList, 3L, FALSE, &prReport));
+	TEST_CHECK((prReport.ukiAdded.nAdded == 0L) && (prReport.nFailed == 3L));
+	TEST_CHECK(ImportStubIndexBuilds() == 1L);
+	TEST_CHECK(ImportPageFiles(aszList, 0L, FALSE, &prReport));
+	TEST_CHECK(prReport.ukiAdded.nAdded == 0L);
+	ImportStubSetIndexReady(FALSE);
+
+	// Without a workspace there's nowhere to import to.
+	ImportStubSetFolders(NULL, NULL);
+	TEST_CHECK(!ImportPageFiles(aszList, 3L, TRUE, &prReport));
+}
+
+/**
+ * Imports enough pages for every copying thread to have plenty to do, and
+ * checks that each one was copied and registered exactly once, in order.
+ *
+ * @param szaRoot Folder to work in.
+ */
+void CheckManyFiles(const char *szaRoot) {
+	static WCHAR aszFiles[NUM_MANY][MAX_PATH];
+	static LPCTSTR aszList[NUM_MANY];
+	PAGEIMPORT_REPORT prReport;
+	char szaPath[512];
+	char szaName[32];
+	char szaText[32];
+	long nFailed;
+	int i;
+
+	sprintf(szaPath, "%s/many", szaRoot);
+	mkdir(szaPath, 0755);
+	for (i = 0; i < NUM_MANY; i++) {
+		sprintf(szaPath, "%s/many/page%03d.html", szaRoot, i);
+		sprintf(szaText, "page %d", i);
+		TestWriteFile(szaPath, szaText, strlen(szaText));
+		sprintf(szaPath, "%s\\many\\page%03d.html", szaRoot, i);
+		Win32ShimWidenPath(aszFiles[i], szaPath);
+		aszList[i] = aszFiles[i];
+	}
+
+	ImportStubReset();
+	TEST_CHECK(ImportPageFiles(aszList, NUM_MANY, TRUE, &prReport));
+	TEST_CHECK((prReport.ukiAdded.nAdded == NUM_MANY) &&
+			   (prReport.nFailed == 0L));
+	TEST_CHECK(ImportStubArticleCount() == NUM_MANY);
+
+	nFailed = 0L;
+	for (i = 0; i < NUM_MANY; i++) {
+		sprintf(szaName, "page%03d.html", i);
+		sprintf(szaPath, "%s/articles/%s", szaRoot, szaName);
+		sprintf(szaText, "page %d", i);
+		if (!EndsWith(ImportStubArticlePath(i), szaName) ||
+				!FileEquals(szaPath, szaText)) {
+			nFailed++;
+		}
+	}
+	printf("%d pages imported, %ld went wrong\n", NUM_MANY, nFailed);
+	TEST_CHECK(nFailed == 0L);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	WCHAR szArticles[MAX_PATH];
+	WCHAR szTemplates[MAX_PATH];
+	char szaRoot[256];
+	char szaPath[512];
+
+	// Set up a workspace and a folder of exported pages.
+	TEST_CHECK(TestMakeFolder(szaRoot, "import"));
+	sprintf(szaPath, "%s/articles", szaRoot);
+	mkdir(szaPath, 0755);
+	Win32ShimWidenPath(szArticles, szaPath);
+	sprintf(szaPath, "%s/templates", szaRoot);
+	mkdir(szaPath, 0755);
+	Win32ShimWidenPath(szTemplates, szaPath);
+	sprintf(szaPath, "%s/export", szaRoot);
+	mkdir(szaPath, 0755);
+	ImportStubSetFolders(szArticles, szTemplates);
+
+	CheckFolderImport(szaRoot);
+	CheckFileImport(szaRoot);
+	ImportStubSetFolders(szArticles, szTemplates);
+	CheckManyFiles(szaRoot);
+	ImportStubReset();
+	TEST_CHECK(Win32ShimLiveBytes() == 0);
+
+	TestRemoveFolder(szaRoot);
+	return TestFinish("PageImportTest");
+}
\ No newline at end of file
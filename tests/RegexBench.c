@@ -0,0 +1,113 @@
+/**
+ * RegexBench.c
+ * Measures the throughput of the regular expression engine on a megabyte of
+ * page markup, and on the expressions that make a backtracking engine
+ * explode.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Regex.h"
+
+// Definitions.
+#define TEXT_SIZE (1 << 20)
+
+// Markup repeated to fill the text.
+const char *szaFragment = "<p>Some <a href=\"page/link.html\">linked text</a> "
+	"and <b>bold</b> words, 2024-10-17 foo_bar.</p>\r\n";
+
+// Private methods.
+void RunBenchmark(const char *szaName, const char *szaPattern, int fMatchCase,
+				  const unsigned short *szText, size_t cchText, int fReplace);
+
+/**
+ * Times finding or replacing every match of an expression in a text.
+ *
+ * @param szaName    Name of the benchmark.
+ * @param szaPattern Expression to look for.
+ * @param fMatchCase Should the case be matched?
+ * @param szText     Text to search in.
+ * @param cchText    Length of the text in characters.
+ * @param fReplace   Replace the matches instead of just finding them?
+ */
+void RunBenchmark(const char *szaName, const char *szaPattern, int fMatchCase,
+				  const unsigned short *szText, size_t cchText, int fReplace) {
+	unsigned short szPattern[128];
+	unsigned short szTemplate[8];
+	TXTSRCH_REPLACE replace;
+	REGEX regex;
+	size_t *lpStarts;
+	size_t *lpEnds;
+	size_t cchPattern;
+	size_t cchTemplate;
+	size_t nError;
+	long nMatches;
+	double dTime;
+
+	cchPattern = TestWiden(szPattern, szaPattern);
+	if (RegexCompile(&regex, szPattern, cchPattern, fMatchCase, &nError) !=
+			REGEX_OK) {
+		printf("%-26s failed to compile\n", szaName);
+		return;
+	}
+
+	dTime = TestMilliseconds();
+	if (fReplace) {
+		cchTemplate = TestWiden(szTemplate, "[$1]");
+		nMatches = RegexReplaceAll(&regex, szText, cchText, 0, szTemplate,
+								   cchTemplate, &replace);
+		TextSearchFreeReplace(&replace);
+	} else {
+		nMatches = RegexFindAll(&regex, szText, cchText, 0, 0, &lpStarts,
+								&lpEnds);
+		free(lpStarts);
+		free(lpEnds);
+	}
+	dTime = TestMilliseconds() - dTime;
+
+	printf("%-26s %8ld matches %9.2f ms %8.1f MB/s\n", szaName, nMatches,
+		   dTime, (cchText * sizeof(unsigned short)) / (dTime * 1000.0));
+	RegexFree(&regex);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	unsigned short *szText;
+	size_t cchFragment;
+	size_t i;
+
+	szText = (unsigned short*)malloc(TEXT_SIZE * sizeof(unsigned short));
+	cchFragment = strlen(szaFragment);
+	for (i = 0; i < TEXT_SIZE; i++)
+		szText[i] = (unsigned char)szaFragment[i % cchFragment];
+
+	RunBenchmark("literal prefix", "href=\"([^\"]*)\"", 1, szText,
+				 TEXT_SIZE, 0);
+	RunBenchmark("any tag", "<(\\w+)[^>]*>", 1, szText, TEXT_SIZE, 0);
+	RunBenchmark("date", "(\\d{4})-(\\d{2})-(\\d{2})", 1, szText,
+				 TEXT_SIZE, 0);
+	RunBenchmark("ignoring case", "\\bBOLD\\b", 0, szText, TEXT_SIZE, 0);
+	RunBenchmark("alternation", "linked|bold|words", 1, szText, TEXT_SIZE,
+				 0);
+	RunBenchmark("replace tags", "<(/?b)>", 1, szText, TEXT_SIZE, 1);
+
+	// Expressions that take exponential time when backtracking.
+	for (i = 0; i < TEXT_SIZE; i++)
+		szText[i] = 'a';
+	RunBenchmark("(a*)*b on a run of a", "(a*)*b", 1, szText, TEXT_SIZE, 0);
+	RunBenchmark("(a|aa)+c on a run of a", "(a|aa)+c", 1, szText,
+				 TEXT_SIZE, 0);
+	RunBenchmark("(?:a?){30}a{30}", "(?:a?){30}a{30}", 1, szText,
+				 TEXT_SIZE, 0);
+
+	free(szText);
+	return 0;
+}
\ No newline at end of file
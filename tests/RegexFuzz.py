@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# RegexFuzz.py
+# Compares the regular expression engine against Python's re module on random
+# expressions and texts, through the standard input mode of RegexTest.
+#
+# Usage: RegexFuzz.py [seed] [cases]
+#
+# @author Nathan Campos <hi@nathancampos.me>
+
+import random
+import re
+import signal
+import subprocess
+import sys
+
+ALPHABET = "abAB _1\n-"
+ASSERTIONS = ("^", "$", "\\b", "\\B")
+
+class Timeout(Exception):
+	"""Raised when re backtracks for too long on a case."""
+
+def alarm(signum, frame):
+	"""Gives up on the case re is working on."""
+	raise Timeout()
+
+def atom(depth):
+	"""Builds a random atom: a character, a class, an assertion or a group."""
+	r = random.random()
+	if depth > 3 or r < 0.35:
+		return random.choice(["a", "b", "A", "B", "c", "1", "_", " ", "-",
+							  "\\-"])
+	if r < 0.42:
+		return "."
+	if r < 0.52:
+		return random.choice(["[ab]", "[^a]", "[a-c]", "[^ \\n]", "[\\d]",
+							  "[\\w-]", "\\d", "\\w", "\\s", "\\W", "\\S",
+							  "\\D", "[A-Z1]"])
+	if r < 0.58:
+		return random.choice(ASSERTIONS)
+	if r < 0.78:
+		return "(" + alternation(depth + 1) + ")"
+	return "(?:" + alternation(depth + 1) + ")"
+
+def quantified(depth):
+	"""Builds an atom that may be followed by a quantifier."""
+	a = atom(depth)
+	if a in ASSERTIONS or random.random() < 0.6:
+		return a
+	q = random.choice(["*", "+", "?", "{2}", "{1,3}", "{0,2}", "{2,}", "{0}"])
+	if random.random() < 0.3:
+		q += "?"
+	return a + q
+
+def alternation(depth):
+	"""Builds a random alternation of concatenations."""
+	return "|".join("".join(quantified(depth)
+							for _ in range(random.randint(0, 4)))
+					for _ in range(random.randint(1, 3)))
+
+def describe(pattern, match_case, text):
+	"""Describes the matches the same way RegexTest does."""
+	flags = re.M | re.A | (0 if match_case else re.I)
+	try:
+		rx = re.compile(pattern, flags)
+	except re.error:
+		return "ERR", 0
+	result = "OK"
+	pos = 0
+	while pos <= len(text):
+		m = rx.search(text, pos)
+		if not m:
+			break
+		result += " [" + "".join("-," if m.span(g)[0] < 0 else
+								 "%d:%d," % m.span(g)
+								 for g in range(rx.groups + 1)) + "]"
+		pos = m.end() + (m.end() == m.start())
+	return result, rx.groups
+
+def whole_matches(result):
+	"""Keeps only the span of each whole match of a description."""
+	return [m.split(",")[0] for m in result.split(" [")[1:]]
+
+def main():
+	random.seed(int(sys.argv[1]) if len(sys.argv) > 1 else 1)
+	count = int(sys.argv[2]) if len(sys.argv) > 2 else 3000
+	cases = []
+	for _ in range(count):
+		text = "".join(random.choice(ALPHABET)
+					   for _ in range(random.randint(0, 20)))
+		cases.append((alternation(0), random.random() < 0.7, text))
+
+	lines = "".join("%s\t%d\t%s\n" % (p, m, t.replace("\n", "\x01"))
+					for p, m, t in cases)
+	output = subprocess.run(["./RegexTest", "-"], input=lines.encode(),
+							capture_output=True).stdout.decode().split("\n")
+
+	# re backtracks, so a few expressions take it forever. Skip those.
+	signal.signal(signal.SIGALRM, alarm)
+
+	# Python gives up on groups that match empty inside a repeated group in
+	# its own way, so only the whole matches have to agree every time.
+	groups = 0
+	failed = 0
+	skipped = 0
+	for (pattern, match_case, text), ours in zip(cases, output):
+		signal.alarm(1)
+		try:
+			expected, n = describe(pattern, match_case, text)
+		except Timeout:
+			n = 10
+		signal.alarm(0)
+		if n >= 10:
+			skipped += 1
+			continue
+
+		# re never lets \B match in an empty text, unlike other engines.
+		if text == "" and "\\B" in pattern:
+			skipped += 1
+			continue
+		if whole_matches(expected) != whole_matches(ours) or \
+				(expected == "ERR") != (ours == "ERR"):
+			failed += 1
+			print("/%s/ on %r:\n  re:    %s\n  Regex: %s" %
+				  (pattern, text, expected, ours))
+		elif expected != ours:
+			groups += 1
+
+	print("RegexFuzz: %d cases, %d failed, %d skipped, %d with different "
+		  "groups" % (count, failed, skipped, groups))
+	return 1 if failed else 0
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,358 @@
+/**
+ * RegexTest.c
+ * Checks the regular expression engine against matches worked out with
+ * Python's re module, and checks that it stays linear on the expressions that
+ * make a backtracking engine explode.
+ *
+ * Run with - as the only argument to read cases from the standard input
+ * instead, one per line as pattern, match case flag and text separated by
+ * tabs. This is what RegexFuzz.py uses.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Regex.h"
+
+// Definitions.
+#define MAX_TEXT     4096
+#define MAX_RESULT   8192
+#define LINEAR_SIZE  (1 << 16)
+
+// A case of the table.
+typedef struct {
+	const char *szaPattern;
+	int fMatchCase;
+	const char *szaText;
+	const char *szaExpected;
+} REGEX_CASE;
+
+// Expected matches of each case, as printed by DescribeMatches.
+const REGEX_CASE aCases[] = {
+	{ "abc", 1, "xxabcxabc",
+	  "OK [2:5,] [6:9,]" },
+	{ "a.c", 1, "abc a-c a\nc",
+	  "OK [0:3,] [4:7,]" },
+	{ "[a-c]+", 1, "xxabccbaxx",
+	  "OK [2:8,]" },
+	{ "[^ab]+", 1, "aabbccdd",
+	  "OK [4:8,]" },
+	{ "\\d+", 1, "ab 123 4 x56",
+	  "OK [3:6,] [7:8,] [10:12,]" },
+	{ "\\w+", 1, "foo_bar baz!",
+	  "OK [0:7,] [8:11,]" },
+	{ "\\s+", 1, "a \t b",
+	  "OK [1:4,]" },
+	{ "\\D\\W\\S", 1, "a!b",
+	  "OK [0:3,]" },
+	{ "^a", 1, "ab\nab",
+	  "OK [0:1,] [3:4,]" },
+	{ "b$", 1, "ab\nab",
+	  "OK [1:2,] [4:5,]" },
+	{ "\\bfoo\\b", 1, "foo food afoo foo",
+	  "OK [0:3,] [14:17,]" },
+	{ "\\Boo\\B", 1, "foo fook",
+	  "OK [5:7,]" },
+	{ "a|b|c", 1, "xcba",
+	  "OK [1:2,] [2:3,] [3:4,]" },
+	{ "ab|abc", 1, "abc",
+	  "OK [0:2,]" },
+	{ "(a)(b)?", 1, "ab a",
+	  "OK [0:2,0:1,1:2,] [3:4,3:4,-,]" },
+	{ "(?:ab)+", 1, "ababab abx",
+	  "OK [0:6,] [7:9,]" },
+	{ "a*", 1, "baaa",
+	  "OK [0:0,] [1:4,] [4:4,]" },
+	{ "a+?", 1, "aaa",
+	  "OK [0:1,] [1:2,] [2:3,]" },
+	{ "a??b", 1, "ab b",
+	  "OK [0:2,] [3:4,]" },
+	{ "a{2}", 1, "aaaaa",
+	  "OK [0:2,] [2:4,]" },
+	{ "a{2,3}", 1, "aaaaaaa",
+	  "OK [0:3,] [3:6,]" },
+	{ "a{2,}", 1, "a aa aaaa",
+	  "OK [2:4,] [5:9,]" },
+	{ "a{0}b", 1, "ab",
+	  "OK [1:2,]" },
+	{ "(a|ab)(c|bcd)(d*)", 1, "abcd",
+	  "OK [0:4,0:1,1:4,4:4,]" },
+	{ "(b||A)+", 1, "bA",
+	  "OK [0:1,1:1,] [1:1,1:1,] [2:2,2:2,]" },
+	{ "(a*)+", 1, "b",
+	  "OK [0:0,0:0,] [1:1,1:1,]" },
+	{ "(\\d{4})-(\\d{2})-(\\d{2})", 1, "on 2024-10-17.",
+	  "OK [3:13,3:7,8:10,11:13,]" },
+	{ "href=\"([^\"]*)\"", 1, "<a href=\"x.html\">",
+	  "OK [3:16,9:15,]" },
+	{ "HELLO", 0, "say hello Hello",
+	  "OK [4:9,] [10:15,]" },
+	{ "[a-z]+", 0, "ABC def",
+	  "OK [0:3,] [4:7,]" },
+	{ "\\bword\\b", 0, "Word WORDS word",
+	  "OK [0:4,] [11:15,]" },
+	{ "(x)|(y)", 1, "yx",
+	  "OK [0:1,-,0:1,] [1:2,1:2,-,]" },
+	{ "a\\.b", 1, "a.b axb",
+	  "OK [0:3,]" },
+	{ "\\[\\]", 1, "[]",
+	  "OK [0:2,]" },
+	{ "[\\w-]+", 1, "foo-bar baz",
+	  "OK [0:7,] [8:11,]" },
+	{ "(a", 1, "",
+	  "ERR" },
+	{ "a)", 1, "",
+	  "ERR" },
+	{ "[ab", 1, "",
+	  "ERR" },
+	{ "a{2,1}", 1, "",
+	  "ERR" },
+	{ "*a", 1, "",
+	  "ERR" },
+	{ "a\\", 1, "",
+	  "ERR" },
+	{ "", 1, "ab",
+	  "OK [0:0,] [1:1,] [2:2,]" },
+	{ "x*", 1, "",
+	  "OK [0:0,]" },
+	{ "(?:a|b)*?c", 1, "ababc",
+	  "OK [0:5,]" },
+	{ "<(\\w+)[^>]*>", 1, "<p class=x><b>",
+	  "OK [0:11,1:2,] [11:14,12:13,]" }
+};
+
+// Private methods.
+void DescribeMatches(const char *szaPattern, int fMatchCase,
+					 const char *szaText, char *szaResult);
+void CheckTable(void);
+void CheckReplace(void);
+void CheckLinear(void);
+double TimeSearch(const char *szaPattern, size_t cchText);
+int RunStandardInput(void);
+
+/**
+ * Describes every match of an expression in a text, from left to right, with
+ * the span of each group. A group that didn't take part is shown as a dash.
+ *
+ * @param szaPattern Expression.
+ * @param fMatchCase Should the case be matched?
+ * @param szaText    Text to search in.
+ * @param szaResult  Buffer to receive the description, or ERR if the
+ *                   expression doesn't compile.
+ */
+void DescribeMatches(const char *szaPattern, int fMatchCase,
+					 const char *szaText, char *szaResult) {
+	static unsigned short szPattern[MAX_TEXT];
+	static unsigned short szText[MAX_TEXT];
+	REGEX_MATCH match;
+	REGEX regex;
+	size_t cchPattern;
+	size_t cchText;
+	size_t nPos;
+	size_t nError;
+	int iGroup;
+
+	cchPattern = TestWiden(szPattern, szaPattern);
+	cchText = TestWiden(szText, szaText);
+	if (RegexCompile(&regex, szPattern, cchPattern, fMatchCase, &nError) !=
+			REGEX_OK) {
+		strcpy(szaResult, "ERR");
+		return;
+	}
+
+	strcpy(szaResult, "OK");
+	nPos = 0;
+	while ((nPos <= cchText) &&
+			(RegexSearch(&regex, szText, cchText, nPos, &match) > 0)) {
+		strcat(szaResult, " [");
+		for (iGroup = 0; iGroup < (regex.nCaptures / 2); iGroup++) {
+			if (match.aCaptures[iGroup * 2] == REGEX_NONE) {
+				strcat(szaResult, "-,");
+			} else {
+				sprintf(szaResult + strlen(szaResult), "%lu:%lu,",
+						(unsigned long)match.aCaptures[iGroup * 2],
+						(unsigned long)match.aCaptures[(iGroup * 2) + 1]);
+			}
+		}
+		strcat(szaResult, "]");
+
+		// Step over empty matches so that the search moves forward.
+		nPos = match.aCaptures[1];
+		if (match.aCaptures[1] == match.aCaptures[0])
+			nPos++;
+	}
+
+	RegexFree(&regex);
+}
+
+/**
+ * Checks every case of the table.
+ */
+void CheckTable(void) {
+	char szaResult[MAX_RESULT];
+	size_t iCase;
+
+	for (iCase = 0; iCase < (sizeof(aCases) / sizeof(aCases[0])); iCase++) {
+		DescribeMatches(aCases[iCase].szaPattern, aCases[iCase].fMatchCase,
+						aCases[iCase].szaText, szaResult);
+		if (strcmp(szaResult, aCases[iCase].szaExpected) != 0) {
+			printf("/%s/ on \"%s\": expected %s, got %s\n",
+				   aCases[iCase].szaPattern, aCases[iCase].szaText,
+				   aCases[iCase].szaExpected, szaResult);
+		}
+
+		TEST_CHECK(strcmp(szaResult, aCases[iCase].szaExpected) == 0);
+	}
+}
+
+/**
+ * Checks that replacements expand groups and escapes.
+ */
+void CheckReplace(void) {
+	unsigned short szPattern[64];
+	unsigned short szText[64];
+	unsigned short szTemplate[64];
+	unsigned short szExpected[64];
+	TXTSRCH_REPLACE replace;
+	REGEX regex;
+	size_t cchPattern;
+	size_t cchText;
+	size_t cchTemplate;
+	size_t cchExpected;
+	size_t nError;
+	long nMatches;
+
+	cchPattern = TestWiden(szPattern, "(\\w+)@(\\w+)");
+	cchText = TestWiden(szText, "mail bob@home and amy@work.");
+	cchTemplate = TestWiden(szTemplate, "$2:$1$$\\t");
+	cchExpected = TestWiden(szExpected, "home:bob$\t and work:amy$\t");
+
+	TEST_CHECK(RegexCompile(&regex, szPattern, cchPattern, 1, &nError) ==
+			   REGEX_OK);
+	nMatches = RegexReplaceAll(&regex, szText, cchText, 0, szTemplate,
+							   cchTemplate, &replace);
+	TEST_CHECK(nMatches == 2L);
+	TEST_CHECK(replace.nStart == 5);
+	TEST_CHECK(replace.nEnd == 26);
+	TEST_CHECK(replace.cchResult == cchExpected);
+	TEST_CHECK(memcmp(replace.szResult, szExpected,
+					  cchExpected * sizeof(unsigned short)) == 0);
+
+	TextSearchFreeReplace(&replace);
+	RegexFree(&regex);
+}
+
+/**
+ * Times how long it takes to look for an expression in a run of the letter a.
+ *
+ * @param  szaPattern Expression to look for.
+ * @param  cchText    Length of the text in characters.
+ * @return            Time taken in milliseconds.
+ */
+double TimeSearch(const char *szaPattern, size_t cchText) {
+	unsigned short szPattern[64];
+	unsigned short *szText;
+	REGEX_MATCH match;
+	REGEX regex;
+	size_t cchPattern;
+	size_t nError;
+	size_t i;
+	double dStart;
+
+	szText = (unsigned short*)malloc(cchText * sizeof(unsigned short));
+	for (i = 0; i < cchText; i++)
+		szText[i] = 'a';
+
+	cchPattern = TestWiden(szPattern, szaPattern);
+	TEST_CHECK(RegexCompile(&regex, szPattern, cchPattern, 1, &nError) ==
+			   REGEX_OK);
+
+	dStart = TestMilliseconds();
+	RegexSearch(&regex, szText, cchText, 0, &match);
+	dStart = TestMilliseconds() - dStart;
+
+	RegexFree(&regex);
+	free(szText);
+
+	return dStart;
+}
+
+/**
+ * Checks that expressions which take exponential time in a backtracking
+ * engine only take about four times as long on a text four times larger.
+ */
+void CheckLinear(void) {
+	const char *aszaPatterns[] = {
+		"(a*)*b", "(a|aa)+c", "(?:a?){30}a{30}b"
+	};
+	double dSmall;
+	double dLarge;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		dSmall = TimeSearch(aszaPatterns[i], LINEAR_SIZE);
+		dLarge = TimeSearch(aszaPatterns[i], LINEAR_SIZE * 4);
+		printf("/%s/: %.2f ms on %d, %.2f ms on %d characters\n",
+			   aszaPatterns[i], dSmall, LINEAR_SIZE, dLarge, LINEAR_SIZE * 4);
+
+		// Leave a lot of room for noise, an exponential blow up won't fit.
+		TEST_CHECK(dLarge < ((dSmall * 12.0) + 5.0));
+	}
+}
+
+/**
+ * Describes the matches of each case read from the standard input.
+ *
+ * @return Exit code of the program.
+ */
+int RunStandardInput(void) {
+	static char szaLine[MAX_TEXT * 2];
+	static char szaResult[MAX_RESULT * 4];
+	char *szaFlag;
+	char *szaText;
+	char *p;
+
+	while (fgets(szaLine, sizeof(szaLine), stdin) != NULL) {
+		szaLine[strcspn(szaLine, "\n")] = '\0';
+		szaFlag = strchr(szaLine, '\t');
+		if (szaFlag == NULL)
+			continue;
+		*szaFlag++ = '\0';
+		szaText = strchr(szaFlag, '\t');
+		if (szaText == NULL)
+			continue;
+		*szaText++ = '\0';
+
+		// Line breaks in the text are sent as the 0x01 control character.
+		for (p = szaText; *p != '\0'; p++) {
+			if (*p == '\x01')
+				*p = '\n';
+		}
+
+		DescribeMatches(szaLine, szaFlag[0] == '1', szaText, szaResult);
+		printf("%s\n", szaResult);
+	}
+
+	return 0;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @param  argc Number of arguments.
+ * @param  argv Arguments.
+ * @return      Exit code of the program.
+ */
+int main(int argc, char **argv) {
+	if ((argc > 1) && (strcmp(argv[1], "-") == 0))
+		return RunStandardInput();
+
+	CheckTable();
+	CheckReplace();
+	CheckLinear();
+
+	return TestFinish("RegexTest");
+}
\ No newline at end of file
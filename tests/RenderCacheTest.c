@@ -0,0 +1,429 @@
+/**
+ * RenderCacheTest.c
+ * Checks that the render cache only renders articles again when they changed,
+ * keeps the least recently used ones out of the way of the memory budget and
+ * prefetches within its own budget, on a few known cases and then on random
+ * sequences of requests and edits against a model of the cache.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <utime.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "RenderStub.h"
+#include "RenderCache.h"
+
+// Definitions.
+#define NUM_CASES     100
+#define NUM_STEPS     400
+#define NUM_ARTICLES  48
+#define MAX_CONTENTS  3000
+#define MIN_BUDGET    2048
+#define MAX_BUDGET    65536
+
+// Size of the HTML the stub renders for an article.
+#define HTML_BYTES(cb) (((cb) + 8) * sizeof(TCHAR))
+
+// What the model knows about an article.
+typedef struct {
+	size_t cbContents;
+	unsigned long ulVersion;
+	int fCached;
+	unsigned long ulCachedVersion;
+	DWORD cbCached;
+	unsigned long ulGeneration;
+	unsigned long ulLastUsed;
+} MODEL_ARTICLE;
+
+// Global variables.
+char szaFolder[256];
+char aszaPaths[NUM_ARTICLES][300];
+const char *lpszaPaths[NUM_ARTICLES];
+MODEL_ARTICLE amArticles[NUM_ARTICLES];
+unsigned long ulGeneration;
+unsigned long ulUseCounter;
+time_t tModified = 1000000000;
+
+// Private methods.
+int WriteArticle(int iArticle, size_t cbContents);
+int TouchArticle(int iArticle);
+int IsRendered(LPCTSTR szHTML, int iArticle);
+void ModelEvict(DWORD cbNeeded, DWORD cbMax);
+long CheckModelStats(void);
+void CheckKnownCache(void);
+void CheckPrefetch(void);
+long CheckRandomCache(void);
+
+/**
+ * Writes new contents to the file of an article and gives it a new
+ * modification time.
+ *
+ * @param  iArticle   Index of the article.
+ * @param  cbContents Size of the new contents.
+ * @return            1 if the file was written.
+ */
+int WriteArticle(int iArticle, size_t cbContents) {
+	char szaContents[MAX_CONTENTS + 32];
+	size_t i;
+
+	// Contents that are different from every previous version.
+	amArticles[iArticle].ulVersion++;
+	for (i = 0; i < cbContents; i++)
+		szaContents[i] = (char)('a' + ((i + iArticle) % 26));
+	if (cbContents > 0)
+		szaContents[0] = (char)('A' + (amArticles[iArticle].ulVersion % 26));
+	if (cbContents > 1)
+		szaContents[1] = (char)('A' + (amArticles[iArticle].ulVersion / 26));
+	amArticles[iArticle].cbContents = cbContents;
+
+	if (!TestWriteFile(aszaPaths[iArticle], szaContents, cbContents))
+		return 0;
+	return TouchArticle(iArticle);
+}
+
+/**
+ * Gives the file of an article a new modification time without changing it.
+ *
+ * @param  iArticle Index of the article.
+ * @return          1 if the time was changed.
+ */
+int TouchArticle(int iArticle) {
+	struct utimbuf utTimes;
+
+	tModified++;
+	utTimes.actime = tModified;
+	utTimes.modtime = tModified;
+
+	return utime(aszaPaths[iArticle], &utTimes) == 0;
+}
+
+/**
+ * Checks if some HTML is what the stub renders for the current contents of an
+ * article.
+ *
+ * @param  szHTML   HTML returned by the cache, may be NULL.
+ * @param  iArticle Index of the article.
+ * @return          Non-zero if it's the right HTML.
+ */
+int IsRendered(LPCTSTR szHTML, int iArticle) {
+	size_t cchHTML;
+
+	if (szHTML == NULL)
+		return 0;
+
+	cchHTML = wcslen(szHTML);
+	return (cchHTML == (amArticles[iArticle].cbContents + 7)) &&
+		(memcmp(szHTML, L"<p>", 3 * sizeof(TCHAR)) == 0) &&
+		(wcscmp(szHTML + cchHTML - 4, L"</p>") == 0) &&
+		((cchHTML < 9) || (szHTML[3] ==
+			(TCHAR)('A' + (amArticles[iArticle].ulVersion % 26))));
+}
+
+/**
+ * Makes room in the model of the cache the way the cache should, evicting the
+ * least recently used articles until there's a free entry and the new one fits
+ * in the budget, or the cache is empty.
+ *
+ * @param cbNeeded Size of the HTML that will be stored.
+ * @param cbMax    Memory budget of the cache.
+ */
+void ModelEvict(DWORD cbNeeded, DWORD cbMax) {
+	DWORD cbUsed;
+	int nEntries;
+	int iOldest;
+	int i;
+
+	for (;;) {
+		cbUsed = 0;
+		nEntries = 0;
+		iOldest = -1;
+		for (i = 0; i < NUM_ARTICLES; i++) {
+			if (!amArticles[i].fCached)
+				continue;
+
+			cbUsed += amArticles[i].cbCached;
+			nEntries++;
+			if ((iOldest < 0) || (amArticles[i].ulLastUsed <
+					amArticles[iOldest].ulLastUsed)) {
+				iOldest = i;
+			}
+		}
+
+		if ((nEntries < RENDERCACHE_MAX_ENTRIES) &&
+				((nEntries == 0) || ((cbUsed + cbNeeded) <= cbMax))) {
+			return;
+		}
+
+		amArticles[iOldest].fCached = 0;
+	}
+}
+
+/**
+ * Checks that the cache holds as many entries and bytes as the model.
+ *
+ * @return 1 if they disagree.
+ */
+long CheckModelStats(void) {
+	RENDERCACHE_STATS rcsStats;
+	DWORD cbUsed;
+	DWORD nEntries;
+	int i;
+
+	cbUsed = 0;
+	nEntries = 0;
+	for (i = 0; i < NUM_ARTICLES; i++) {
+		if (amArticles[i].fCached) {
+			cbUsed += amArticles[i].cbCached;
+			nEntries++;
+		}
+	}
+
+	GetRenderCacheStats(&rcsStats);
+	return ((rcsStats.nEntries != nEntries) || (rcsStats.cbUsed != cbUsed)) ?
+		1L : 0L;
+}
+
+/**
+ * Checks a few requests where the answers are known.
+ */
+void CheckKnownCache(void) {
+	RENDERCACHE_STATS rcsStats;
+	LPCTSTR szHTML;
+	DWORD dwRenders;
+	int i;
+
+	for (i = 0; i < 5; i++)
+		WriteArticle(i, 100);
+	InitializeRenderCache(3 * HTML_BYTES(100));
+
+	// Rendered once and then served from the cache.
+	dwRenders = RenderStubGetRenders();
+	szHTML = GetRenderedArticle(0L);
+	TEST_CHECK(IsRendered(szHTML, 0));
+	TEST_CHECK(GetRenderedArticle(0L) == szHTML);
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 1));
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.dwHits == 1) && (rcsStats.dwMisses == 1) &&
+		(rcsStats.nEntries == 1) && (rcsStats.cbUsed == HTML_BYTES(100)));
+
+	// A file that was only touched isn't rendered again.
+	TouchArticle(0);
+	TEST_CHECK(IsRendered(GetRenderedArticle(0L), 0));
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 1));
+
+	// But one that changed is, and so is everything after a template change.
+	WriteArticle(0, 100);
+	TEST_CHECK(IsRendered(GetRenderedArticle(0L), 0));
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 2));
+	RenderStubBumpGeneration();
+	TEST_CHECK(IsRendered(GetRenderedArticle(0L), 0));
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 3));
+	InvalidateRenderedArticle(0L);
+	TEST_CHECK(IsRendered(GetRenderedArticle(0L), 0));
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 4));
+
+	// The least recently used article makes room for a new one.
+	GetRenderedArticle(1L);
+	GetRenderedArticle(2L);
+	GetRenderedArticle(0L);
+	GetRenderedArticle(3L);
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.dwEvictions == 1) && (rcsStats.nEntries == 3));
+	dwRenders = RenderStubGetRenders();
+	GetRenderedArticle(0L);
+	GetRenderedArticle(2L);
+	TEST_CHECK(RenderStubGetRenders() == dwRenders);
+	GetRenderedArticle(1L);
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 1));
+	dwRenders = RenderStubGetRenders();
+	GetRenderedArticle(3L);
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 1));
+
+	// An article bigger than the whole budget ends up alone.
+	WriteArticle(4, 1000);
+	TEST_CHECK(IsRendered(GetRenderedArticle(4L), 4));
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.nEntries == 1) &&
+		(rcsStats.cbUsed == HTML_BYTES(1000)));
+
+	// Articles that can't be rendered.
+	TEST_CHECK(GetRenderedArticle(NUM_ARTICLES) == NULL);
+	remove(aszaPaths[5]);
+	TEST_CHECK(GetRenderedArticle(5L) == NULL);
+	ClearRenderCache();
+
+	// No more entries than the cache has.
+	InitializeRenderCache(RENDERCACHE_MAX_BYTES);
+	for (i = 0; i <= RENDERCACHE_MAX_ENTRIES; i++) {
+		WriteArticle(i, 10);
+		GetRenderedArticle(i);
+	}
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.nEntries == RENDERCACHE_MAX_ENTRIES) &&
+		(rcsStats.dwEvictions == 1));
+	dwRenders = RenderStubGetRenders();
+	GetRenderedArticle(RENDERCACHE_MAX_ENTRIES);
+	TEST_CHECK(RenderStubGetRenders() == dwRenders);
+	GetRenderedArticle(0L);
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 1));
+
+	ClearRenderCache();
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.nEntries == 0) && (rcsStats.cbUsed == 0));
+}
+
+/**
+ * Checks that prefetching stays within its budget and that prefetched articles
+ * are served without being rendered again.
+ */
+void CheckPrefetch(void) {
+	RENDERCACHE_STATS rcsStats;
+	DWORD dwRenders;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		WriteArticle(i, 100);
+	InitializeRenderCache(RENDERCACHE_MAX_BYTES);
+
+	// Up to the budget, but never past it.
+	dwRenders = RenderStubGetRenders();
+	TEST_CHECK(PrefetchRenderedArticle(0L, 500));
+	TEST_CHECK(PrefetchRenderedArticle(1L, 500));
+	TEST_CHECK(!PrefetchRenderedArticle(2L, 500));
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.dwPrefetches == 2) && (rcsStats.nEntries == 2) &&
+		(rcsStats.cbPrefetched == (2 * HTML_BYTES(100))));
+	TEST_CHECK(!PrefetchRenderedArticle(3L, 300));
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 3));
+
+	// Requested after being prefetched.
+	TEST_CHECK(IsRendered(GetRenderedArticle(0L), 0));
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 3));
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.dwPrefetchHits == 1) && (rcsStats.dwHits == 1) &&
+		(rcsStats.cbPrefetched == HTML_BYTES(100)));
+
+	// Only the ones nobody asked for are dropped.
+	DropPrefetchedArticles();
+	GetRenderCacheStats(&rcsStats);
+	TEST_CHECK((rcsStats.nEntries == 1) && (rcsStats.cbPrefetched == 0));
+	GetRenderedArticle(0L);
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 3));
+	GetRenderedArticle(1L);
+	TEST_CHECK(RenderStubGetRenders() == (dwRenders + 4));
+
+	ClearRenderCache();
+}
+
+/**
+ * Runs a random sequence of requests, edits, touches, invalidations and
+ * template changes against a cache with a random budget, checking every
+ * request and the contents of the cache against the model.
+ *
+ * @return Number of steps where the cache and the model disagreed.
+ */
+long CheckRandomCache(void) {
+	MODEL_ARTICLE *lpArticle;
+	LPCTSTR szHTML;
+	DWORD dwRenders;
+	DWORD cbMax;
+	long nBad;
+	int fHit;
+	int iStep;
+	int i;
+
+	// Start from scratch.
+	for (i = 0; i < NUM_ARTICLES; i++) {
+		amArticles[i].fCached = 0;
+		WriteArticle(i, 1 + TestRandom(MAX_CONTENTS));
+	}
+	cbMax = MIN_BUDGET + TestRandom(MAX_BUDGET - MIN_BUDGET);
+	InitializeRenderCache(cbMax);
+
+	nBad = 0L;
+	for (iStep = 0; iStep < NUM_STEPS; iStep++) {
+		i = (int)TestRandom(NUM_ARTICLES);
+		lpArticle = &amArticles[i];
+
+		switch (TestRandom(12)) {
+			case 0:
+				WriteArticle(i, 1 + TestRandom(MAX_CONTENTS));
+				break;
+			case 1:
+				TouchArticle(i);
+				break;
+			case 2:
+				InvalidateRenderedArticle(i);
+				lpArticle->fCached = 0;
+				break;
+			case 3:
+				if (TestRandom(8) == 0) {
+					RenderStubBumpGeneration();
+					ulGeneration++;
+				}
+				break;
+			default:
+				// Work out what the cache should do.
+				fHit = lpArticle->fCached &&
+					(lpArticle->ulGeneration == ulGeneration) &&
+					(lpArticle->ulCachedVersion == lpArticle->ulVersion);
+				if (!fHit) {
+					lpArticle->fCached = 0;
+					ModelEvict(HTML_BYTES(lpArticle->cbContents), cbMax);
+					lpArticle->fCached = 1;
+					lpArticle->ulCachedVersion = lpArticle->ulVersion;
+					lpArticle->cbCached = HTML_BYTES(lpArticle->cbContents);
+					lpArticle->ulGeneration = ulGeneration;
+				}
+				lpArticle->ulLastUsed = ++ulUseCounter;
+
+				// And check that it did.
+				dwRenders = RenderStubGetRenders();
+				szHTML = GetRenderedArticle(i);
+				if (!IsRendered(szHTML, i) ||
+						((RenderStubGetRenders() == dwRenders) != fHit)) {
+					nBad++;
+				}
+		}
+
+		nBad += CheckModelStats();
+	}
+
+	ClearRenderCache();
+	return nBad;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	long nDisagreements;
+	int i;
+
+	TestSeed(0x4E7D3CA5UL);
+	TEST_CHECK(TestMakeFolder(szaFolder, "rendercache"));
+	for (i = 0; i < NUM_ARTICLES; i++) {
+		sprintf(aszaPaths[i], "%s/article%d.html", szaFolder, i);
+		lpszaPaths[i] = aszaPaths[i];
+	}
+	RenderStubSetArticles(lpszaPaths, NUM_ARTICLES);
+
+	CheckKnownCache();
+	CheckPrefetch();
+
+	nDisagreements = 0L;
+	for (i = 0; i < NUM_CASES; i++)
+		nDisagreements += CheckRandomCache();
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nDisagreements);
+	TEST_CHECK(nDisagreements == 0L);
+	TEST_CHECK(Win32ShimLiveBytes() == 0);
+
+	TestRemoveFolder(szaFolder);
+	return TestFinish("RenderCacheTest");
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+/**
+ * RenderStub.c
+ * A stand-in for the parts of UkiHelper that the render cache uses, which
+ * "renders" articles by wrapping the contents of their files in a paragraph
+ * and counts how many times it had to.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "RenderStub.h"
+#include <stdio.h>
+#include "UkiHelper.h"
+#include "Win32Shim.h"
+
+// Global variables.
+const char **lpszaStubPaths = NULL;
+LONG nStubArticles = 0L;
+DWORD dwStubGeneration = 1;
+DWORD dwStubRenders = 0;
+
+/**
+ * Sets the files of the articles. They aren't copied, so they must outlive
+ * their use.
+ *
+ * @param lpszaPaths Path to the file of each article.
+ * @param nArticles  Number of articles.
+ */
+void RenderStubSetArticles(const char **lpszaPaths, LONG nArticles) {
+	lpszaStubPaths = lpszaPaths;
+	nStubArticles = nArticles;
+}
+
+/**
+ * Makes every article rendered so far out of date, like a template change.
+ */
+void RenderStubBumpGeneration(void) {
+	dwStubGeneration++;
+}
+
+/**
+ * Gets the number of articles rendered so far.
+ *
+ * @return Number of renders.
+ */
+DWORD RenderStubGetRenders(void) {
+	return dwStubRenders;
+}
+
+/**
+ * Gets an article.
+ *
+ * @param  ukiArticle Receives the article.
+ * @param  nIndex     Index of the article.
+ * @return            TRUE if the article exists.
+ */
+BOOL GetUkiArticle(UKIARTICLE *ukiArticle, size_t nIndex) {
+	if (nIndex >= (size_t)nStubArticles)
+		return FALSE;
+
+	ukiArticle->path = (char*)lpszaStubPaths[nIndex];
+	ukiArticle->name = (char*)lpszaStubPaths[nIndex];
+	ukiArticle->parent = NULL;
+	ukiArticle->deepness = 0;
+
+	return TRUE;
+}
+
+/**
+ * Gets the path to the file of an article.
+ *
+ * @param  szArticlePath Receives the path.
+ * @param  ukiArticle    The article.
+ * @return               TRUE if the operation was successful.
+ */
+BOOL GetUkiArticlePath(LPTSTR szArticlePath, const UKIARTICLE ukiArticle) {
+	Win32ShimWidenPath(szArticlePath, ukiArticle.path);
+	return TRUE;
+}
+
+/**
+ * Gets the generation of the rendered articles.
+ *
+ * @return Current generation.
+ */
+DWORD GetUkiRenderGeneration() {
+	return dwStubGeneration;
+}
+
+/**
+ * Renders an article by wrapping the contents of its file in a paragraph.
+ *
+ * @param  ukiArticle The article.
+ * @param  szHTML     Receives the HTML, which must be freed with LocalFree.
+ * @return            TRUE if the file could be read.
+ */
+BOOL RenderUkiArticle(const UKIARTICLE ukiArticle, LPTSTR *szHTML) {
+	FILE *lpFile;
+	LPTSTR szBuffer;
+	long cbFile;
+	long i;
+	int c;
+
+	// Get the size of the file.
+	lpFile = fopen(ukiArticle.path, "rb");
+	if (lpFile == NULL)
+		return FALSE;
+	fseek(lpFile, 0L, SEEK_END);
+	cbFile = ftell(lpFile);
+	rewind(lpFile);
+
+	// Wrap its contents.
+	szBuffer = (LPTSTR)LocalAlloc(LMEM_FIXED, (cbFile + 8) * sizeof(TCHAR));
+	wcscpy(szBuffer, L"<p>");
+	for (i = 0L; (i < cbFile) && ((c = fgetc(lpFile)) != EOF); i++)
+		szBuffer[3 + i] = (TCHAR)c;
+	wcscpy(szBuffer + 3 + i, L"</p>");
+	fclose(lpFile);
+
+	dwStubRenders++;
+	*szHTML = szBuffer;
+	return TRUE;
+}
\ No newline at end of file
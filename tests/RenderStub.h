@@ -0,0 +1,22 @@
+/**
+ * RenderStub.h
+ * A stand-in for the parts of UkiHelper that the render cache uses, which
+ * "renders" articles by wrapping the contents of their files in a paragraph
+ * and counts how many times it had to.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _RENDERSTUB_H
+#define _RENDERSTUB_H
+
+#include <windows.h>
+
+// Setup.
+void RenderStubSetArticles(const char **lpszaPaths, LONG nArticles);
+void RenderStubBumpGeneration(void);
+
+// Inspection.
+DWORD RenderStubGetRenders(void);
+
+#endif  // _RENDERSTUB_H
\ No newline at end of file
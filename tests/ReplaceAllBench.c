@@ -0,0 +1,166 @@
+/**
+ * ReplaceAllBench.c
+ * Measures Replace All on a large page with many occurrences, and compares it
+ * with the old way of going one replacement at a time, where every step read
+ * the whole text from the editor, upper-cased it and spliced the replacement
+ * into it.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "TextSearch.h"
+
+// Definitions.
+#define PAGE_SIZE    (1 << 20)
+#define NUM_MATCHES  10000
+#define NUM_RUNS     5
+#define NUM_OLD_RUNS 100
+
+// Private methods.
+size_t ReplaceNextOld(unsigned short **lpszText, size_t cchText, size_t nFrom,
+					  const unsigned short *szNeedle, size_t cchNeedle,
+					  const unsigned short *szReplacement,
+					  size_t cchReplacement, int fMatchCase);
+
+/**
+ * Replaces the next occurrence of a needle the way Replace Next used to,
+ * copying the whole text and upper-casing it to search it.
+ *
+ * @param  lpszText       Text to replace in. Gets replaced by a new buffer.
+ * @param  cchText        Length of the text.
+ * @param  nFrom          Position to start searching from.
+ * @param  szNeedle       Upper-case needle if the case is ignored.
+ * @param  cchNeedle      Length of the needle.
+ * @param  szReplacement  Text to put in place of the needle.
+ * @param  cchReplacement Length of the replacement.
+ * @param  fMatchCase     Should the case of the letters be taken into account?
+ * @return                Position after the replacement or TXTSRCH_NONE if
+ *                        there wasn't anything to replace.
+ */
+size_t ReplaceNextOld(unsigned short **lpszText, size_t cchText, size_t nFrom,
+					  const unsigned short *szNeedle, size_t cchNeedle,
+					  const unsigned short *szReplacement,
+					  size_t cchReplacement, int fMatchCase) {
+	unsigned short *szHaystack;
+	unsigned short *szNew;
+	size_t nFound;
+	size_t i;
+
+	// Get a copy of the text, upper-cased if needed.
+	szHaystack = (unsigned short*)malloc(cchText * sizeof(unsigned short));
+	memcpy(szHaystack, *lpszText, cchText * sizeof(unsigned short));
+	if (!fMatchCase) {
+		for (i = 0; i < cchText; i++) {
+			if ((szHaystack[i] >= 'a') && (szHaystack[i] <= 'z'))
+				szHaystack[i] -= 0x20;
+		}
+	}
+
+	// Find the next occurrence.
+	nFound = TextSearchFind(szHaystack, cchText, nFrom, szNeedle, cchNeedle,
+							1);
+	free(szHaystack);
+	if (nFound == TXTSRCH_NONE)
+		return TXTSRCH_NONE;
+
+	// Splice the replacement in, like the editor does with EM_REPLACESEL.
+	szNew = (unsigned short*)malloc((cchText - cchNeedle + cchReplacement) *
+									sizeof(unsigned short));
+	memcpy(szNew, *lpszText, nFound * sizeof(unsigned short));
+	memcpy(szNew + nFound, szReplacement,
+		   cchReplacement * sizeof(unsigned short));
+	memcpy(szNew + nFound + cchReplacement, *lpszText + nFound + cchNeedle,
+		   (cchText - nFound - cchNeedle) * sizeof(unsigned short));
+	free(*lpszText);
+	*lpszText = szNew;
+
+	return nFound + cchReplacement;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	TXTSRCH_REPLACE trReplace;
+	const char *szaFill = "lorem ipsum dolor sit amet, ";
+	unsigned short *szPage;
+	unsigned short *szOld;
+	unsigned short szNeedle[8];
+	unsigned short szMixed[8];
+	unsigned short szUpper[8];
+	unsigned short szReplacement[8];
+	size_t cchNeedle;
+	size_t cchReplacement;
+	size_t cchOld;
+	size_t nPos;
+	size_t nFill;
+	double dBest;
+	double dTime;
+	long nMatches;
+	int fMatchCase;
+	int iRun;
+	size_t i;
+
+	// Fill the page with text and sprinkle the needle in mixed case.
+	szPage = (unsigned short*)malloc(PAGE_SIZE * sizeof(unsigned short));
+	nFill = strlen(szaFill);
+	for (i = 0; i < PAGE_SIZE; i++)
+		szPage[i] = (unsigned short)szaFill[i % nFill];
+	cchNeedle = TestWiden(szMixed, "NeEdLe");
+	for (i = 0; i < NUM_MATCHES; i++)
+		memcpy(szPage + (i * (PAGE_SIZE / NUM_MATCHES)) + 3, szMixed,
+			   cchNeedle * sizeof(unsigned short));
+	TestWiden(szNeedle, "needle");
+	TestWiden(szUpper, "NEEDLE");
+	cchReplacement = TestWiden(szReplacement, "pin");
+
+	printf("%d characters, %d occurrences\n", PAGE_SIZE, NUM_MATCHES);
+	for (fMatchCase = 0; fMatchCase <= 1; fMatchCase++) {
+		// Replace everything in a single pass.
+		nMatches = 0L;
+		dBest = 0.0;
+		for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+			dTime = TestMilliseconds();
+			nMatches = TextSearchReplaceAll(szPage, PAGE_SIZE, 0,
+				fMatchCase ? szMixed : szNeedle, cchNeedle, szReplacement,
+				cchReplacement, fMatchCase, &trReplace);
+			dTime = TestMilliseconds() - dTime;
+			TextSearchFreeReplace(&trReplace);
+
+			if ((iRun == 0) || (dTime < dBest))
+				dBest = dTime;
+		}
+		printf("%-13s single pass: %5ld replaced in %8.2f ms\n",
+			   fMatchCase ? "matching case" : "ignoring case", nMatches,
+			   dBest);
+
+		// Go one at a time for a while and work out how long all of them
+		// would have taken, which is worst when ignoring case.
+		if (fMatchCase)
+			continue;
+		cchOld = PAGE_SIZE;
+		szOld = (unsigned short*)malloc(cchOld * sizeof(unsigned short));
+		memcpy(szOld, szPage, cchOld * sizeof(unsigned short));
+		nPos = 0;
+		dTime = TestMilliseconds();
+		for (iRun = 0; iRun < NUM_OLD_RUNS; iRun++) {
+			nPos = ReplaceNextOld(&szOld, cchOld, nPos, szUpper, cchNeedle,
+				szReplacement, cchReplacement, fMatchCase);
+			cchOld = cchOld - cchNeedle + cchReplacement;
+		}
+		dTime = TestMilliseconds() - dTime;
+		free(szOld);
+		printf("%-13s one by one:  %5d replaced in %8.2f ms, about %.0f ms "
+			   "for all\n", "ignoring case", NUM_OLD_RUNS, dTime,
+			   dTime * ((double)NUM_MATCHES / NUM_OLD_RUNS));
+	}
+
+	free(szPage);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+/**
+ * ReplaceAllTest.c
+ * Checks that replacing every occurrence of a needle in one pass gives the
+ * same text as replacing them one at a time from left to right, which is what
+ * Replace All used to do.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+#include "TestHelper.h"
+#include "TextSearch.h"
+
+// Definitions.
+#define NUM_CASES  20000
+#define MAX_TEXT   64
+#define MAX_NEEDLE 5
+#define MAX_OUTPUT (MAX_TEXT * MAX_NEEDLE)
+
+// Letters of the random texts, with accented ones in both cases.
+const unsigned short awLetters[] = { 'a', 'A', 'b', 'B', 0xE9, 0xC9, ' ' };
+#define NUM_LETTERS (sizeof(awLetters) / sizeof(awLetters[0]))
+
+// Private methods.
+unsigned short FoldReference(unsigned short wChar, int fMatchCase);
+int MatchesAt(const unsigned short *szText, const unsigned short *szNeedle,
+			  size_t cchNeedle, int fMatchCase);
+size_t ReplaceReference(unsigned short *szOutput, const unsigned short *szText,
+						size_t cchText, size_t nFrom,
+						const unsigned short *szNeedle, size_t cchNeedle,
+						const unsigned short *szReplacement,
+						size_t cchReplacement, int fMatchCase,
+						long *lpnMatches);
+size_t ApplyReplace(unsigned short *szOutput, const unsigned short *szText,
+					size_t cchText, const TXTSRCH_REPLACE *lpReplace);
+void CheckKnownCases(void);
+void CheckRandomCases(void);
+
+/**
+ * Folds a character the way a search that ignores case should.
+ *
+ * @param  wChar      Character to fold.
+ * @param  fMatchCase Should the case be kept?
+ * @return            Folded character.
+ */
+unsigned short FoldReference(unsigned short wChar, int fMatchCase) {
+	if (fMatchCase)
+		return wChar;
+
+	return (unsigned short)towupper(wChar);
+}
+
+/**
+ * Checks if a needle is at the start of a text.
+ *
+ * @param  szText     Text with at least cchNeedle characters.
+ * @param  szNeedle   Needle to check.
+ * @param  cchNeedle  Length of the needle.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Non-zero if the needle is there.
+ */
+int MatchesAt(const unsigned short *szText, const unsigned short *szNeedle,
+			  size_t cchNeedle, int fMatchCase) {
+	size_t i;
+
+	for (i = 0; i < cchNeedle; i++) {
+		if (FoldReference(szText[i], fMatchCase) !=
+				FoldReference(szNeedle[i], fMatchCase)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Replaces every occurrence of a needle one at a time, going from left to
+ * right and carrying on after each replacement.
+ *
+ * @param  szOutput       Buffer for the whole new text.
+ * @param  szText         Original text.
+ * @param  cchText        Length of the text.
+ * @param  nFrom          Position to start replacing from.
+ * @param  szNeedle       Text to look for.
+ * @param  cchNeedle      Length of the needle.
+ * @param  szReplacement  Text to put in place of the needle.
+ * @param  cchReplacement Length of the replacement.
+ * @param  fMatchCase     Should the case of the letters be taken into account?
+ * @param  lpnMatches     Number of replacements made.
+ * @return                Length of the new text.
+ */
+size_t ReplaceReference(unsigned short *szOutput, const unsigned short *szText,
+						size_t cchText, size_t nFrom,
+						const unsigned short *szNeedle, size_t cchNeedle,
+						const unsigned short *szReplacement,
+						size_t cchReplacement, int fMatchCase,
+						long *lpnMatches) {
+	size_t cchOutput;
+	size_t iPos;
+
+	memcpy(szOutput, szText, nFrom * sizeof(unsigned short));
+	cchOutput = nFrom;
+	*lpnMatches = 0L;
+	iPos = nFrom;
+	while (iPos < cchText) {
+		if (((iPos + cchNeedle) <= cchText) &&
+				MatchesAt(szText + iPos, szNeedle, cchNeedle, fMatchCase)) {
+			memcpy(szOutput + cchOutput, szReplacement,
+				   cchReplacement * sizeof(unsigned short));
+			cchOutput += cchReplacement;
+			iPos += cchNeedle;
+			(*lpnMatches)++;
+		} else {
+			szOutput[cchOutput++] = szText[iPos++];
+		}
+	}
+
+	return cchOutput;
+}
+
+/**
+ * Puts the result of a replace operation in the text, like the editor does
+ * with a single EM_REPLACESEL.
+ *
+ * @param  szOutput  Buffer for the whole new text.
+ * @param  szText    Original text.
+ * @param  cchText   Length of the text.
+ * @param  lpReplace Result of the operation.
+ * @return           Length of the new text.
+ */
+size_t ApplyReplace(unsigned short *szOutput, const unsigned short *szText,
+					size_t cchText, const TXTSRCH_REPLACE *lpReplace) {
+	size_t cchOutput;
+
+	if (lpReplace->nMatches == 0L) {
+		memcpy(szOutput, szText, cchText * sizeof(unsigned short));
+		return cchText;
+	}
+
+	memcpy(szOutput, szText, lpReplace->nStart * sizeof(unsigned short));
+	cchOutput = lpReplace->nStart;
+	memcpy(szOutput + cchOutput, lpReplace->szResult,
+		   lpReplace->cchResult * sizeof(unsigned short));
+	cchOutput += lpReplace->cchResult;
+	memcpy(szOutput + cchOutput, szText + lpReplace->nEnd,
+		   (cchText - lpReplace->nEnd) * sizeof(unsigned short));
+
+	return cchOutput + (cchText - lpReplace->nEnd);
+}
+
+/**
+ * Checks a few replacements worked out by hand.
+ */
+void CheckKnownCases(void) {
+	TXTSRCH_REPLACE trReplace;
+	unsigned short szText[64];
+	unsigned short szNeedle[8];
+	unsigned short szReplacement[8];
+	unsigned short szExpected[64];
+	size_t cchText;
+	size_t cchNeedle;
+	size_t cchReplacement;
+
+	// Only the part between the first and last occurrences is returned.
+	cchText = TestWiden(szText, "xx Foo foo FOO yy");
+	cchNeedle = TestWiden(szNeedle, "foo");
+	cchReplacement = TestWiden(szReplacement, "bar!");
+	TEST_CHECK(TextSearchReplaceAll(szText, cchText, 0, szNeedle, cchNeedle,
+		szReplacement, cchReplacement, 0, &trReplace) == 3L);
+	TEST_CHECK((trReplace.nStart == 3) && (trReplace.nEnd == 14));
+	TEST_CHECK((trReplace.cchResult == TestWiden(szExpected,
+		"bar! bar! bar!")) && (memcmp(trReplace.szResult, szExpected,
+		trReplace.cchResult * sizeof(unsigned short)) == 0));
+	TEST_CHECK(trReplace.szResult[trReplace.cchResult] == 0);
+	TextSearchFreeReplace(&trReplace);
+
+	// Matching case, and starting after the first occurrence.
+	TEST_CHECK(TextSearchReplaceAll(szText, cchText, 0, szNeedle, cchNeedle,
+		szReplacement, cchReplacement, 1, &trReplace) == 1L);
+	TEST_CHECK((trReplace.nStart == 7) && (trReplace.nEnd == 10));
+	TextSearchFreeReplace(&trReplace);
+	TEST_CHECK(TextSearchReplaceAll(szText, cchText, 4, szNeedle, cchNeedle,
+		szReplacement, cchReplacement, 0, &trReplace) == 2L);
+	TEST_CHECK(trReplace.nStart == 7);
+	TextSearchFreeReplace(&trReplace);
+
+	// Occurrences don't overlap, and can be removed altogether.
+	cchText = TestWiden(szText, "aaaaa");
+	cchNeedle = TestWiden(szNeedle, "aa");
+	TEST_CHECK(TextSearchReplaceAll(szText, cchText, 0, szNeedle, cchNeedle,
+		szReplacement, 0, 1, &trReplace) == 2L);
+	TEST_CHECK((trReplace.nStart == 0) && (trReplace.nEnd == 4) &&
+			   (trReplace.cchResult == 0));
+	TextSearchFreeReplace(&trReplace);
+
+	// Nothing to replace.
+	cchNeedle = TestWiden(szNeedle, "b");
+	TEST_CHECK(TextSearchReplaceAll(szText, cchText, 0, szNeedle, cchNeedle,
+		szReplacement, cchReplacement, 1, &trReplace) == 0L);
+	TEST_CHECK((trReplace.szResult == NULL) && (trReplace.nMatches == 0L));
+	TEST_CHECK(TextSearchReplaceAll(szText, cchText, 0, szNeedle, 0,
+		szReplacement, cchReplacement, 1, &trReplace) == 0L);
+	TEST_CHECK(TextSearchReplaceAll(szText, cchText, cchText, szNeedle,
+		cchNeedle, szReplacement, cchReplacement, 1, &trReplace) == 0L);
+}
+
+/**
+ * Compares single-pass replacements with the reference on random texts,
+ * needles and starting points.
+ */
+void CheckRandomCases(void) {
+	static unsigned short szExpected[MAX_OUTPUT];
+	static unsigned short szOutput[MAX_OUTPUT];
+	TXTSRCH_REPLACE trReplace;
+	unsigned short szText[MAX_TEXT];
+	unsigned short szNeedle[MAX_NEEDLE];
+	unsigned short szReplacement[MAX_NEEDLE];
+	size_t cchText;
+	size_t cchNeedle;
+	size_t cchReplacement;
+	size_t cchExpected;
+	size_t cchOutput;
+	size_t nFrom;
+	long nExpected;
+	long nMatches;
+	long nFailed;
+	int fMatchCase;
+	int iCase;
+	size_t i;
+
+	TestSeed(11);
+	nFailed = 0L;
+	for (iCase = 0; iCase < NUM_CASES; iCase++) {
+		cchText = TestRandom(MAX_TEXT);
+		for (i = 0; i < cchText; i++)
+			szText[i] = awLetters[TestRandom(NUM_LETTERS)];
+		cchNeedle = 1 + TestRandom(MAX_NEEDLE - 1);
+		for (i = 0; i < cchNeedle; i++)
+			szNeedle[i] = awLetters[TestRandom(NUM_LETTERS - 3)];
+		cchReplacement = TestRandom(MAX_NEEDLE);
+		for (i = 0; i < cchReplacement; i++)
+			szReplacement[i] = (unsigned short)('x' + TestRandom(3));
+		nFrom = TestRandom(cchText + 1);
+		fMatchCase = (int)TestRandom(2);
+
+		cchExpected = ReplaceReference(szExpected, szText, cchText, nFrom,
+			szNeedle, cchNeedle, szReplacement, cchReplacement, fMatchCase,
+			&nExpected);
+		nMatches = TextSearchReplaceAll(szText, cchText, nFrom, szNeedle,
+			cchNeedle, szReplacement, cchReplacement, fMatchCase, &trReplace);
+		cchOutput = ApplyReplace(szOutput, szText, cchText, &trReplace);
+
+		if ((nMatches != nExpected) || (trReplace.nMatches != nExpected) ||
+				((nMatches > 0L) && (trReplace.nStart < nFrom)) ||
+				(cchOutput != cchExpected) || (memcmp(szOutput, szExpected,
+				cchOutput * sizeof(unsigned short)) != 0)) {
+			nFailed++;
+		}
+		TextSearchFreeReplace(&trReplace);
+	}
+
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nFailed);
+	TEST_CHECK(nFailed == 0L);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	// Fold accented letters too, like towupper does on Windows CE.
+	setlocale(LC_CTYPE, "C.UTF-8");
+
+	CheckKnownCases();
+	CheckRandomCases();
+
+	return TestFinish("ReplaceAllTest");
+}
\ No newline at end of file
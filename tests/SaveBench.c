@@ -0,0 +1,154 @@
+/**
+ * SaveBench.c
+ * Compares saving a large page through a temporary file in small chunks with
+ * the old way of converting the whole page into one buffer and writing it
+ * straight over the original, both in time and in the peak of memory
+ * allocated along the way.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "Utilities.h"
+
+// Definitions.
+#define NUM_SIZES 3
+#define NUM_RUNS  5
+
+// Sizes of the pages in megabytes.
+const int aiSizes[NUM_SIZES] = { 1, 4, 16 };
+
+// Private methods.
+BOOL SaveFileContentsOld(LPCTSTR szFilePath, LPCTSTR szContents);
+void MakePage(WCHAR *szPage, size_t cchPage);
+
+/**
+ * Saves a page the way SaveFileContents used to, converting all of it at once
+ * and writing it over the original file.
+ *
+ * @param  szFilePath Path to the file to be written.
+ * @param  szContents Contents to place inside the file.
+ * @return            TRUE if the operation was successful.
+ */
+BOOL SaveFileContentsOld(LPCTSTR szFilePath, LPCTSTR szContents) {
+	HANDLE hFile;
+	DWORD dwBytesWritten;
+	char *szaContents;
+	int cbContents;
+	BOOL bSuccess;
+
+	// Convert the whole page.
+	cbContents = ConvertBufferWtoA(NULL, 0, szContents, -1);
+	szaContents = (char*)LocalAlloc(LMEM_FIXED, cbContents);
+	if (szaContents == NULL)
+		return FALSE;
+	ConvertBufferWtoA(szaContents, cbContents, szContents, -1);
+
+	// Write it over the original.
+	hFile = CreateFile(szFilePath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		LocalFree(szaContents);
+		return FALSE;
+	}
+	bSuccess = WriteFile(hFile, szaContents, cbContents - 1, &dwBytesWritten,
+		NULL);
+
+	CloseHandle(hFile);
+	LocalFree(szaContents);
+	return bSuccess;
+}
+
+/**
+ * Fills a page with paragraphs of text that has a few accented characters,
+ * so that chunks convert to a varying number of bytes.
+ *
+ * @param szPage  Buffer for cchPage characters and a terminator.
+ * @param cchPage Length of the page in characters.
+ */
+void MakePage(WCHAR *szPage, size_t cchPage) {
+	WCHAR szLine[128];
+	size_t cchLine;
+	size_t i;
+
+	cchLine = TestWiden((unsigned short*)szLine, "<p>Caf\xC3\xA9 na esquina, "
+		"p\xC3\xA3o e ma\xC3\xA7\xC3\xA3 \xE2\x80\x94 the quick brown fox.</p>\n");
+	for (i = 0; (i + cchLine) <= cchPage; i += cchLine)
+		memcpy(szPage + i, szLine, cchLine * sizeof(WCHAR));
+	for (; i < cchPage; i++)
+		szPage[i] = L' ';
+	szPage[cchPage] = L'\0';
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	WCHAR szPath[MAX_PATH];
+	WCHAR *szPage;
+	char szaRoot[256];
+	char szaPath[512];
+	size_t cchPage;
+	size_t cbNew;
+	size_t cbOld;
+	double dNew;
+	double dOld;
+	double dTime;
+	int iSize;
+	int iRun;
+
+	TestMakeFolder(szaRoot, "savebench");
+	sprintf(szaPath, "%s/page.html", szaRoot);
+	Win32ShimWidenPath(szPath, szaPath);
+
+	printf("%8s %12s %12s %12s %12s\n", "size", "chunked ms", "chunked peak",
+		   "old ms", "old peak");
+	for (iSize = 0; iSize < NUM_SIZES; iSize++) {
+		cchPage = (size_t)aiSizes[iSize] << 20;
+		szPage = (WCHAR*)malloc((cchPage + 1) * sizeof(WCHAR));
+		MakePage(szPage, cchPage);
+
+		// Through a temporary file, flushed before it replaces the page.
+		dNew = 0.0;
+		cbNew = 0;
+		for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+			Win32ShimResetPeak();
+			dTime = TestMilliseconds();
+			if (!SaveFileContents(szPath, szPage))
+				return 1;
+			dTime = TestMilliseconds() - dTime;
+			cbNew = Win32ShimPeakBytes();
+			if ((iRun == 0) || (dTime < dNew))
+				dNew = dTime;
+		}
+
+		// Straight over the page from a single buffer.
+		dOld = 0.0;
+		cbOld = 0;
+		for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+			Win32ShimResetPeak();
+			dTime = TestMilliseconds();
+			if (!SaveFileContentsOld(szPath, szPage))
+				return 1;
+			dTime = TestMilliseconds() - dTime;
+			cbOld = Win32ShimPeakBytes();
+			if ((iRun == 0) || (dTime < dOld))
+				dOld = dTime;
+		}
+
+		printf("%6d MB %12.2f %9lu KB %12.2f %9lu KB\n", aiSizes[iSize],
+			   dNew, (unsigned long)(cbNew >> 10), dOld,
+			   (unsigned long)(cbOld >> 10));
+		free(szPage);
+	}
+	printf("sizes are in characters, chunked saves include the flush\n");
+
+	TestRemoveFolder(szaRoot);
+	return 0;
+}
\ No newline at end of file
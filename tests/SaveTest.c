@@ -0,0 +1,389 @@
+/**
+ * SaveTest.c
+ * Checks that pages are saved byte for byte through a temporary file, that a
+ * failed save leaves the original page untouched and nothing behind it, and
+ * that files left over by an interrupted save are cleaned up.
+ *
+ * Built with UNDER_CE as SaveCeTest, which commits saves by moving the
+ * original out of the way instead of replacing it in one go.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "Utilities.h"
+
+// Definitions.
+#define NUM_PAGES     300
+#define MAX_PAGE      20000
+#define ORIGINAL_TEXT "<p>Original page.</p>"
+
+// Tell the Windows CE build apart.
+#ifdef UNDER_CE
+	#define SUITE_NAME "SaveCeTest"
+#else
+	#define SUITE_NAME "SaveTest"
+#endif
+
+// Private methods.
+size_t MakeRandomPage(WCHAR *szPage);
+size_t EncodePage(char *szaOutput, const WCHAR *szPage);
+int FileEquals(const char *szaPath, const void *lpData, size_t cbData);
+int FileExists(const char *szaPath);
+int SiblingsExist(const char *szaPath);
+void CheckSaves(const char *szaRoot);
+void CheckAtomicWrites(const char *szaRoot);
+void CheckRecovery(const char *szaRoot);
+
+/**
+ * Makes a random page with ASCII, accented letters, CJK and surrogate pairs,
+ * some of them right where a chunk ends.
+ *
+ * @param  szPage Buffer for at least MAX_PAGE + 1 characters.
+ * @return        Length of the page.
+ */
+size_t MakeRandomPage(WCHAR *szPage) {
+	size_t cchPage;
+	size_t i;
+
+	cchPage = TestRandom(MAX_PAGE);
+	for (i = 0; i < cchPage; i++) {
+		switch (TestRandom(10)) {
+		case 0:
+			szPage[i] = 0xE9;
+			break;
+		case 1:
+			szPage[i] = 0x4E2D;
+			break;
+		case 2:
+			szPage[i] = '\n';
+			break;
+		default:
+			szPage[i] = (WCHAR)('a' + TestRandom(26));
+			break;
+		}
+
+		// Add surrogate pairs, with one across every chunk boundary.
+		if ((i + 1) < cchPage) {
+			if ((TestRandom(20) == 0) ||
+					(((i + 1) % FILE_CHUNK_SIZE) == 0)) {
+				szPage[i] = 0xD83D;
+				szPage[++i] = (WCHAR)(0xDC00 + TestRandom(0x400));
+			}
+		}
+	}
+	szPage[cchPage] = L'\0';
+
+	return cchPage;
+}
+
+/**
+ * Encodes a well-formed page as UTF-8, which is what should end up on disk.
+ *
+ * @param  szaOutput Buffer for the encoded page.
+ * @param  szPage    Page to encode.
+ * @return           Length of the encoded page in bytes.
+ */
+size_t EncodePage(char *szaOutput, const WCHAR *szPage) {
+	unsigned char *lpOutput = (unsigned char*)szaOutput;
+	unsigned long dwChar;
+	size_t cbOutput;
+
+	cbOutput = 0;
+	for (; *szPage != L'\0'; szPage++) {
+		dwChar = *szPage;
+		if ((dwChar >= 0xD800) && (dwChar <= 0xDBFF)) {
+			szPage++;
+			dwChar = 0x10000 + ((dwChar - 0xD800) << 10) + (*szPage - 0xDC00);
+		}
+
+		if (dwChar < 0x80) {
+			lpOutput[cbOutput++] = (unsigned char)dwChar;
+		} else if (dwChar < 0x800) {
+			lpOutput[cbOutput++] = (unsigned char)(0xC0 | (dwChar >> 6));
+			lpOutput[cbOutput++] = (unsigned char)(0x80 | (dwChar & 0x3F));
+		} else if (dwChar < 0x10000) {
+			lpOutput[cbOutput++] = (unsigned char)(0xE0 | (dwChar >> 12));
+			lpOutput[cbOutput++] = (unsigned char)(0x80 |
+				((dwChar >> 6) & 0x3F));
+			lpOutput[cbOutput++] = (unsigned char)(0x80 | (dwChar & 0x3F));
+		} else {
+			lpOutput[cbOutput++] = (unsigned char)(0xF0 | (dwChar >> 18));
+			lpOutput[cbOutput++] = (unsigned char)(0x80 |
+				((dwChar >> 12) & 0x3F));
+			lpOutput[cbOutput++] = (unsigned char)(0x80 |
+				((dwChar >> 6) & 0x3F));
+			lpOutput[cbOutput++] = (unsigned char)(0x80 | (dwChar & 0x3F));
+		}
+	}
+
+	return cbOutput;
+}
+
+/**
+ * Checks if a file holds exactly the data given.
+ *
+ * @param  szaPath Path to the file.
+ * @param  lpData  Data it should have.
+ * @param  cbData  Length of the data.
+ * @return         Non-zero if it does.
+ */
+int FileEquals(const char *szaPath, const void *lpData, size_t cbData) {
+	FILE *fh;
+	char *szaContents;
+	size_t cbRead;
+	int fEqual;
+
+	fh = fopen(szaPath, "rb");
+	if (fh == NULL)
+		return 0;
+
+	szaContents = (char*)malloc(cbData + 1);
+	cbRead = fread(szaContents, 1, cbData + 1, fh);
+	fEqual = (cbRead == cbData) && (memcmp(szaContents, lpData, cbData) == 0);
+	free(szaContents);
+	fclose(fh);
+
+	return fEqual;
+}
+
+/**
+ * Checks if a file exists.
+ *
+ * @param  szaPath Path to the file.
+ * @return         Non-zero if it does.
+ */
+int FileExists(const char *szaPath) {
+	return access(szaPath, F_OK) == 0;
+}
+
+/**
+ * Checks if a save left its temporary or backup file next to a page.
+ *
+ * @param  szaPath Path to the page.
+ * @return         Non-zero if either of them is there.
+ */
+int SiblingsExist(const char *szaPath) {
+	char szaSibling[512];
+
+	sprintf(szaSibling, "%s.tmp", szaPath);
+	if (FileExists(szaSibling))
+		return 1;
+	sprintf(szaSibling, "%s.bak", szaPath);
+
+	return FileExists(szaSibling);
+}
+
+/**
+ * Saves random pages over an existing one, making one of the writes fail
+ * every now and then.
+ *
+ * @param szaRoot Folder to work in.
+ */
+void CheckSaves(const char *szaRoot) {
+	static WCHAR szPage[MAX_PAGE + 1];
+	static char szaExpected[MAX_PAGE * 4];
+	WCHAR szPath[MAX_PATH];
+	char szaPath[512];
+	size_t cchPage;
+	size_t cbExpected;
+	long nChunks;
+	long nFailAt;
+	long nMessages;
+	long nBroken;
+	long nFailed;
+	BOOL bSaved;
+	int iPage;
+
+	sprintf(szaPath, "%s/page.html", szaRoot);
+	Win32ShimWidenPath(szPath, szaPath);
+
+	TestSeed(17);
+	nBroken = 0L;
+	nFailed = 0L;
+	for (iPage = 0; iPage < NUM_PAGES; iPage++) {
+		TestWriteFile(szaPath, ORIGINAL_TEXT, strlen(ORIGINAL_TEXT));
+		cchPage = MakeRandomPage(szPage);
+		cbExpected = EncodePage(szaExpected, szPage);
+
+		// Fail one of the writes in every third save.
+		nChunks = (long)((cchPage + FILE_CHUNK_SIZE - 1) / FILE_CHUNK_SIZE);
+		nFailAt = ((iPage % 3) == 0) ? (long)TestRandom(nChunks + 1) : -1L;
+		if (nFailAt >= nChunks)
+			nFailAt = -1L;
+		Win32ShimFailWrite(nFailAt);
+		nMessages = Win32ShimMessageCount();
+		bSaved = SaveFileContents(szPath, szPage);
+		Win32ShimFailWrite(-1L);
+
+		// Either the new page or the original must be there, and nothing else.
+		if (nFailAt >= 0L) {
+			nBroken++;
+			if (bSaved || !FileEquals(szaPath, ORIGINAL_TEXT,
+					strlen(ORIGINAL_TEXT)) ||
+					(Win32ShimMessageCount() != (nMessages + 1))) {
+				nFailed++;
+			}
+		} else if (!bSaved || !FileEquals(szaPath, szaExpected, cbExpected)) {
+			nFailed++;
+		}
+		if (SiblingsExist(szaPath))
+			nFailed++;
+	}
+
+	printf("%d random pages, %ld with a failed write, %ld went wrong\n",
+		   NUM_PAGES, nBroken, nFailed);
+	TEST_CHECK(nFailed == 0L);
+
+	// Saving a new page that fails leaves nothing at all.
+	sprintf(szaPath, "%s/new.html", szaRoot);
+	Win32ShimWidenPath(szPath, szaPath);
+	Win32ShimFailWrite(0L);
+	TEST_CHECK(!SaveFileContents(szPath, L"<p>New page.</p>"));
+	Win32ShimFailWrite(-1L);
+	TEST_CHECK(!FileExists(szaPath) && !SiblingsExist(szaPath));
+	TEST_CHECK(SaveFileContents(szPath, L"<p>New page.</p>"));
+	TEST_CHECK(FileEquals(szaPath, "<p>New page.</p>", 16));
+
+	// An empty page is saved as an empty file.
+	TEST_CHECK(SaveFileContents(szPath, L""));
+	TEST_CHECK(FileEquals(szaPath, "", 0) && !SiblingsExist(szaPath));
+
+	// Memory doesn't grow with the size of the page.
+	cchPage = MakeRandomPage(szPage);
+	while (cchPage < (MAX_PAGE / 2))
+		cchPage = MakeRandomPage(szPage);
+	Win32ShimResetPeak();
+	TEST_CHECK(SaveFileContents(szPath, szPage));
+	TEST_CHECK(Win32ShimPeakBytes() <= (FILE_CHUNK_SIZE * 4));
+}
+
+/**
+ * Checks writing a whole buffer atomically.
+ *
+ * @param szaRoot Folder to work in.
+ */
+void CheckAtomicWrites(const char *szaRoot) {
+	WCHAR szPath[MAX_PATH];
+	char szaPath[512];
+
+	sprintf(szaPath, "%s/index.idx", szaRoot);
+	Win32ShimWidenPath(szPath, szaPath);
+
+	TEST_CHECK(WriteFileAtomically(szPath, "first", 5));
+	TEST_CHECK(FileEquals(szaPath, "first", 5) && !SiblingsExist(szaPath));
+	TEST_CHECK(WriteFileAtomically(szPath, "second", 6));
+	TEST_CHECK(FileEquals(szaPath, "second", 6) && !SiblingsExist(szaPath));
+
+	Win32ShimFailWrite(0L);
+	TEST_CHECK(!WriteFileAtomically(szPath, "third", 5));
+	Win32ShimFailWrite(-1L);
+	TEST_CHECK(FileEquals(szaPath, "second", 6) && !SiblingsExist(szaPath));
+}
+
+/**
+ * Checks that the files of interrupted page saves are cleaned up, putting
+ * backups back where the original is missing on Windows CE, and that nothing
+ * else in the folder or below it is touched.
+ *
+ * @param szaRoot Folder to work in.
+ */
+void CheckRecovery(const char *szaRoot) {
+	WCHAR szFolder[MAX_PATH];
+	char szaFolder[512];
+	char szaPath[512];
+
+	sprintf(szaFolder, "%s/recover", szaRoot);
+	mkdir(szaFolder, 0755);
+	sprintf(szaPath, "%s/recover/sub", szaRoot);
+	mkdir(szaPath, 0755);
+
+	// A half-written temporary file, a backup of a page that's gone, a stale
+	// backup of a page that's there, a page of its own, and files that
+	// belong to the user.
+	sprintf(szaPath, "%s/recover/a.html.tmp", szaRoot);
+	TestWriteFile(szaPath, "half", 4);
+	sprintf(szaPath, "%s/recover/b.htm.bak", szaRoot);
+	TestWriteFile(szaPath, "backup of b", 11);
+	sprintf(szaPath, "%s/recover/c.html.bak", szaRoot);
+	TestWriteFile(szaPath, "old c", 5);
+	sprintf(szaPath, "%s/recover/c.html", szaRoot);
+	TestWriteFile(szaPath, "new c", 5);
+	sprintf(szaPath, "%s/recover/d.html", szaRoot);
+	TestWriteFile(szaPath, "d", 1);
+	sprintf(szaPath, "%s/recover/notes.bak", szaRoot);
+	TestWriteFile(szaPath, "notes", 5);
+	sprintf(szaPath, "%s/recover/notes.tmp", szaRoot);
+	TestWriteFile(szaPath, "notes", 5);
+	sprintf(szaPath, "%s/recover/sub/e.html.tmp", szaRoot);
+	TestWriteFile(szaPath, "e", 1);
+
+	Win32ShimWidenPath(szFolder, szaFolder);
+#ifdef UNDER_CE
+	TEST_CHECK(RecoverInterruptedWrites(szFolder) == 3);
+#else
+	TEST_CHECK(RecoverInterruptedWrites(szFolder) == 1);
+#endif  // UNDER_CE
+
+	sprintf(szaPath, "%s/recover/a.html", szaRoot);
+	TEST_CHECK(!FileExists(szaPath) && !SiblingsExist(szaPath));
+	sprintf(szaPath, "%s/recover/b.htm", szaRoot);
+#ifdef UNDER_CE
+	TEST_CHECK(FileEquals(szaPath, "backup of b", 11) &&
+			   !SiblingsExist(szaPath));
+	sprintf(szaPath, "%s/recover/c.html", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "new c", 5) && !SiblingsExist(szaPath));
+#else
+	TEST_CHECK(!FileExists(szaPath));
+	sprintf(szaPath, "%s/recover/b.htm.bak", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "backup of b", 11));
+	sprintf(szaPath, "%s/recover/c.html.bak", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "old c", 5));
+#endif  // UNDER_CE
+	sprintf(szaPath, "%s/recover/d.html", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "d", 1));
+	sprintf(szaPath, "%s/recover/notes.bak", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "notes", 5));
+	sprintf(szaPath, "%s/recover/notes.tmp", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "notes", 5));
+	sprintf(szaPath, "%s/recover/sub/e.html.tmp", szaRoot);
+	TEST_CHECK(FileEquals(szaPath, "e", 1));
+
+	TEST_CHECK(IsTransientFile(L"page.html.TMP"));
+	TEST_CHECK(IsTransientFile(L"page.HTM.tmp"));
+#ifdef UNDER_CE
+	TEST_CHECK(IsTransientFile(L"page.html.bak"));
+#else
+	TEST_CHECK(!IsTransientFile(L"page.html.bak"));
+#endif  // UNDER_CE
+	TEST_CHECK(!IsTransientFile(L"notes.tmp"));
+	TEST_CHECK(!IsTransientFile(L"notes.bak"));
+	TEST_CHECK(!IsTransientFile(L"page.html"));
+	TEST_CHECK(!IsTransientFile(L"bak"));
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	char szaRoot[256];
+
+	TEST_CHECK(TestMakeFolder(szaRoot, "save"));
+	Win32ShimQuietMessages(TRUE);
+
+	CheckSaves(szaRoot);
+	CheckAtomicWrites(szaRoot);
+	CheckRecovery(szaRoot);
+	TEST_CHECK(Win32ShimLiveBytes() == 0);
+
+	TestRemoveFolder(szaRoot);
+	return TestFinish(SUITE_NAME);
+}
\ No newline at end of file
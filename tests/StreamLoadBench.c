@@ -0,0 +1,159 @@
+/**
+ * StreamLoadBench.c
+ * Compares loading a large page as a whole with streaming it in blocks, both
+ * in time and in the peak of memory allocated along the way.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "Utilities.h"
+
+// Definitions.
+#define NUM_SIZES 4
+#define NUM_RUNS  5
+
+// Text streamed so far, checked against the whole file.
+typedef struct {
+	LPCTSTR szText;
+	DWORD cchDone;
+	BOOL bSame;
+} STREAMCHECK;
+
+// Sizes of the pages in megabytes.
+const int aiSizes[NUM_SIZES] = { 1, 4, 16, 32 };
+
+// Private methods.
+BOOL CheckChunk(LPCTSTR szChunk, DWORD cchChunk, LPARAM lParam);
+void MakePage(char *szaPage, size_t cbPage);
+
+/**
+ * Compares a streamed block with the same stretch of the whole text.
+ *
+ * @param  szChunk  Block of converted text.
+ * @param  cchChunk Length of the block in characters.
+ * @param  lParam   Pointer to the STREAMCHECK of the load.
+ * @return          Always TRUE so that the whole file is streamed.
+ */
+BOOL CheckChunk(LPCTSTR szChunk, DWORD cchChunk, LPARAM lParam) {
+	STREAMCHECK *lpCheck = (STREAMCHECK*)lParam;
+
+	if ((lpCheck->szText != NULL) && (memcmp(lpCheck->szText +
+			lpCheck->cchDone, szChunk, cchChunk * sizeof(TCHAR)) != 0)) {
+		lpCheck->bSame = FALSE;
+	}
+	lpCheck->cchDone += cchChunk;
+
+	return TRUE;
+}
+
+/**
+ * Fills a page with paragraphs of text that has a few accented characters,
+ * so that blocks have to be cut around multi-byte sequences.
+ *
+ * @param szaPage Buffer to hold the page.
+ * @param cbPage  Size of the page in bytes.
+ */
+void MakePage(char *szaPage, size_t cbPage) {
+	const char *szaLine = "<p>Caf\xC3\xA9 na esquina, p\xC3\xA3o e "
+		"ma\xC3\xA7\xC3\xA3 \xE2\x80\x94 the quick brown fox.</p>\n";
+	size_t nLine = strlen(szaLine);
+	size_t i;
+
+	for (i = 0; (i + nLine) <= cbPage; i += nLine)
+		memcpy(szaPage + i, szaLine, nLine);
+	memset(szaPage + i, ' ', cbPage - i);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	STREAMCHECK scCheck;
+	WCHAR szPath[MAX_PATH];
+	LPTSTR szText;
+	DWORD cchText;
+	char szaRoot[256];
+	char szaPath[512];
+	char *szaPage;
+	size_t cbPage;
+	size_t cbWhole;
+	size_t cbStream;
+	double dWhole;
+	double dStream;
+	double dTime;
+	int iSize;
+	int iRun;
+
+	TestMakeFolder(szaRoot, "streambench");
+	sprintf(szaPath, "%s/page.html", szaRoot);
+	Win32ShimWidenPath(szPath, szaPath);
+
+	printf("%8s %12s %12s %12s %12s\n", "size", "whole ms", "whole peak",
+		   "stream ms", "stream peak");
+	for (iSize = 0; iSize < NUM_SIZES; iSize++) {
+		cbPage = (size_t)aiSizes[iSize] << 20;
+		szaPage = (char*)malloc(cbPage);
+		MakePage(szaPage, cbPage);
+		TestWriteFile(szaPath, szaPage, cbPage);
+		free(szaPage);
+
+		// Read the whole text in one go, like ReadFileContents.
+		dWhole = 0.0;
+		cbWhole = 0;
+		for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+			Win32ShimResetPeak();
+			dTime = TestMilliseconds();
+			if (!ReadFileText(szPath, &szText, &cchText))
+				return 1;
+			dTime = TestMilliseconds() - dTime;
+			cbWhole = Win32ShimPeakBytes();
+			if ((iRun == 0) || (dTime < dWhole))
+				dWhole = dTime;
+			if (iRun < (NUM_RUNS - 1))
+				LocalFree(szText);
+		}
+
+		// Stream it, checking that the blocks add up to the same text.
+		scCheck.szText = szText;
+		scCheck.cchDone = 0;
+		scCheck.bSame = TRUE;
+		StreamFileContents(szPath, CheckChunk, (LPARAM)&scCheck);
+		if (!scCheck.bSame || (scCheck.cchDone != cchText)) {
+			printf("The streamed text differs from the whole one\n");
+			return 1;
+		}
+		LocalFree(szText);
+
+		dStream = 0.0;
+		cbStream = 0;
+		scCheck.szText = NULL;
+		for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+			scCheck.cchDone = 0;
+			Win32ShimResetPeak();
+			dTime = TestMilliseconds();
+			if (!StreamFileContents(szPath, CheckChunk, (LPARAM)&scCheck))
+				return 1;
+			dTime = TestMilliseconds() - dTime;
+			cbStream = Win32ShimPeakBytes();
+			if ((iRun == 0) || (dTime < dStream))
+				dStream = dTime;
+		}
+
+		printf("%6d MB %12.2f %9lu KB %12.2f %9lu KB\n", aiSizes[iSize],
+			   dWhole, (unsigned long)(cbWhole >> 10), dStream,
+			   (unsigned long)((cbStream +
+				   ((FILE_CHUNK_SIZE + 1) * sizeof(WCHAR))) >> 10));
+	}
+	printf("stream peak includes the %lu KB block on the stack\n",
+		   (unsigned long)(((FILE_CHUNK_SIZE + 1) * sizeof(WCHAR)) >> 10));
+
+	TestRemoveFolder(szaRoot);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,259 @@
+/**
+ * StringTableTest.c
+ * Checks that interned strings come out the same as they went in and never
+ * move, and that pages are found by the address of their keys however many
+ * get added, against plain arrays of what was added.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "StringTable.h"
+
+// Definitions.
+#define NUM_CASES     100
+#define MAX_ENTRIES   3000
+#define MAX_NAME_LEN  24
+#define NUM_PARENTS   8
+
+// Strings of the pages added in a random case.
+typedef struct {
+	char szaKey[4];
+	char szaName[MAX_NAME_LEN + 1];
+	char szaPath[MAX_NAME_LEN + 16];
+	int iParent;
+} PAGE_STRINGS;
+
+// Pages of the random cases and the folders they can be in.
+PAGE_STRINGS apsPages[MAX_ENTRIES + 1];
+char aszaParents[NUM_PARENTS][16];
+
+// Private methods.
+int WideEquals(LPCTSTR szString, const char *szaExpected);
+void CheckPool(void);
+void CheckKnownTable(void);
+long CheckRandomTable(void);
+
+/**
+ * Checks if a wide string is the same as an ASCII one.
+ *
+ * @param  szString    Wide string, may be NULL.
+ * @param  szaExpected ASCII string it should be equal to.
+ * @return             Non-zero if they're the same.
+ */
+int WideEquals(LPCTSTR szString, const char *szaExpected) {
+	WCHAR szExpected[256];
+
+	if (szString == NULL)
+		return 0;
+
+	TestWiden((unsigned short*)szExpected, szaExpected);
+	return wcscmp(szString, szExpected) == 0;
+}
+
+/**
+ * Checks the string pool on its own, including strings that don't fit in a
+ * block and ones that aren't ASCII.
+ */
+void CheckPool(void) {
+	LPCTSTR aszStrings[STRPOOL_BLOCK_SIZE];
+	STRINGPOOL spPool;
+	LPCTSTR szString;
+	char szaString[16];
+	char *szaLong;
+	int nBad;
+	int i;
+
+	StringPoolInitialize(&spPool);
+
+	// Nothing to intern.
+	TEST_CHECK(StringPoolAdd(&spPool, NULL) == NULL);
+
+	// Text that has to be converted.
+	szString = StringPoolAdd(&spPool, "Caf\xC3\xA9 \xE2\x80\x94 p\xC3\xA3o");
+	TEST_CHECK((szString != NULL) &&
+		(wcscmp(szString, L"Caf\x00E9 \x2014 p\x00E3o") == 0));
+
+	// A string longer than a whole block gets one of its own.
+	szaLong = (char*)malloc((STRPOOL_BLOCK_SIZE * 2) + 1);
+	memset(szaLong, 'x', STRPOOL_BLOCK_SIZE * 2);
+	szaLong[STRPOOL_BLOCK_SIZE * 2] = '\0';
+	szString = StringPoolAdd(&spPool, szaLong);
+	TEST_CHECK((szString != NULL) &&
+		(wcslen(szString) == (STRPOOL_BLOCK_SIZE * 2)) &&
+		(szString[0] == L'x') &&
+		(szString[(STRPOOL_BLOCK_SIZE * 2) - 1] == L'x'));
+	free(szaLong);
+
+	// Enough strings to fill many blocks, which all stay where they were.
+	for (i = 0; i < STRPOOL_BLOCK_SIZE; i++) {
+		sprintf(szaString, "page%d", i);
+		aszStrings[i] = StringPoolAdd(&spPool, szaString);
+	}
+	nBad = 0;
+	for (i = 0; i < STRPOOL_BLOCK_SIZE; i++) {
+		sprintf(szaString, "page%d", i);
+		if (!WideEquals(aszStrings[i], szaString))
+			nBad++;
+	}
+	TEST_CHECK(nBad == 0);
+
+	StringPoolFree(&spPool);
+	TEST_CHECK(spPool.lpBlocks == NULL);
+}
+
+/**
+ * Checks a handful of pages where the answers are known.
+ */
+void CheckKnownTable(void) {
+	static const char szaFirst[] = "first";
+	static const char szaSecond[] = "second";
+	static const char szaThird[] = "third";
+	static const char szaCopy[] = "first";
+	char szaFolder[16];
+	STRINGTABLE stTable;
+	STRINGPOOL spPool;
+
+	StringPoolInitialize(&spPool);
+	StringTableInitialize(&stTable);
+
+	// Nothing to be found in an empty table.
+	TEST_CHECK(StringTableFind(&stTable, szaFirst) == -1L);
+	TEST_CHECK(StringTableGetName(&stTable, 0L) == NULL);
+
+	// Two pages in the same folder and one at the top.
+	strcpy(szaFolder, "docs");
+	TEST_CHECK(StringTableAdd(&stTable, &spPool, szaFirst, "First",
+		szaFolder, "/wiki/docs/first.html") == 0L);
+	strcpy(szaFolder, "docs");
+	TEST_CHECK(StringTableAdd(&stTable, &spPool, szaSecond, "Second",
+		szaFolder, "/wiki/docs/second.html") == 1L);
+	TEST_CHECK(StringTableAdd(&stTable, &spPool, szaThird, "Third", NULL,
+		"/wiki/third.html") == 2L);
+
+	// Found by the address of the key, not by its contents.
+	TEST_CHECK(StringTableFind(&stTable, szaFirst) == 0L);
+	TEST_CHECK(StringTableFind(&stTable, szaSecond) == 1L);
+	TEST_CHECK(StringTableFind(&stTable, szaThird) == 2L);
+	TEST_CHECK(StringTableFind(&stTable, szaCopy) == -1L);
+	TEST_CHECK(StringTableFind(&stTable, NULL) == -1L);
+
+	// Strings of each page.
+	TEST_CHECK(WideEquals(StringTableGetName(&stTable, 1L), "Second"));
+	TEST_CHECK(WideEquals(StringTableGetPath(&stTable, 2L),
+		"/wiki/third.html"));
+	TEST_CHECK(WideEquals(StringTableGetParent(&stTable, 0L), "docs"));
+	TEST_CHECK(StringTableGetParent(&stTable, 0L) ==
+		StringTableGetParent(&stTable, 1L));
+	TEST_CHECK(StringTableGetParent(&stTable, 2L) == NULL);
+	TEST_CHECK(StringTableGetPath(&stTable, 3L) == NULL);
+	TEST_CHECK(StringTableGetName(&stTable, -1L) == NULL);
+
+	StringTableFree(&stTable);
+	TEST_CHECK((stTable.nEntries == 0L) && (stTable.lpszaKeys == NULL));
+	StringPoolFree(&spPool);
+}
+
+/**
+ * Adds a random number of pages to a table, most of them in runs that share a
+ * folder, and checks that every one of them can still be found with the right
+ * strings.
+ *
+ * @return Number of pages that didn't come back as they went in.
+ */
+long CheckRandomTable(void) {
+	STRINGTABLE stTable;
+	STRINGPOOL spPool;
+	PAGE_STRINGS *lpPage;
+	const char *szaParent;
+	LPCTSTR szParent;
+	LONG nEntries;
+	LONG iEntry;
+	long nBad;
+	int iParent;
+
+	StringPoolInitialize(&spPool);
+	StringTableInitialize(&stTable);
+
+	// Add the pages.
+	nBad = 0L;
+	nEntries = 1L + (LONG)TestRandom(MAX_ENTRIES);
+	iParent = 0;
+	for (iEntry = 0L; iEntry < nEntries; iEntry++) {
+		lpPage = &apsPages[iEntry];
+		if (TestRandom(8) == 0)
+			iParent = (int)TestRandom(NUM_PARENTS + 1) - 1;
+		lpPage->iParent = iParent;
+		sprintf(lpPage->szaName, "page%lu", TestRandom(100000));
+		sprintf(lpPage->szaPath, "/wiki/%s.html", lpPage->szaName);
+
+		szaParent = (iParent < 0) ? NULL : aszaParents[iParent];
+		if (StringTableAdd(&stTable, &spPool, lpPage->szaKey, lpPage->szaName,
+				szaParent, lpPage->szaPath) != iEntry) {
+			nBad++;
+		}
+	}
+
+	// Check every one of them.
+	for (iEntry = 0L; iEntry < nEntries; iEntry++) {
+		lpPage = &apsPages[iEntry];
+		szParent = StringTableGetParent(&stTable, iEntry);
+		if ((StringTableFind(&stTable, lpPage->szaKey) != iEntry) ||
+				!WideEquals(StringTableGetName(&stTable, iEntry),
+					lpPage->szaName) ||
+				!WideEquals(StringTableGetPath(&stTable, iEntry),
+					lpPage->szaPath) ||
+				((lpPage->iParent < 0) ? (szParent != NULL) :
+					!WideEquals(szParent, aszaParents[lpPage->iParent]))) {
+			nBad++;
+			continue;
+		}
+
+		// Pages in the same folder as the previous one share its string.
+		if ((iEntry > 0L) && (lpPage->iParent >= 0) &&
+				(lpPage->iParent == apsPages[iEntry - 1].iParent) &&
+				(szParent != StringTableGetParent(&stTable, iEntry - 1))) {
+			nBad++;
+		}
+	}
+
+	// Addresses that were never added.
+	if ((StringTableFind(&stTable, apsPages[nEntries].szaKey) != -1L) ||
+			(StringTableFind(&stTable, aszaParents[0]) != -1L)) {
+		nBad++;
+	}
+
+	StringTableFree(&stTable);
+	StringPoolFree(&spPool);
+	return nBad;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	long nDisagreements;
+	int i;
+
+	TestSeed(0x5781AB1EUL);
+	for (i = 0; i < NUM_PARENTS; i++)
+		sprintf(aszaParents[i], "folder%d", i);
+
+	CheckPool();
+	CheckKnownTable();
+
+	nDisagreements = 0L;
+	for (i = 0; i < NUM_CASES; i++)
+		nDisagreements += CheckRandomTable();
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nDisagreements);
+	TEST_CHECK(nDisagreements == 0L);
+
+	return TestFinish("StringTableTest");
+}
\ No newline at end of file
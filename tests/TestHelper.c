@@ -0,0 +1,180 @@
+/**
+ * TestHelper.c
+ * Small helpers shared by the test suites and benchmarks.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#define _XOPEN_SOURCE 500
+#include "TestHelper.h"
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Private methods.
+int RemoveEntry(const char *szaPath, const struct stat *lpStat, int iFlag,
+				struct FTW *lpFtw);
+
+// Global variables.
+long nChecks = 0L;
+long nFailures = 0L;
+unsigned long ulRandomState = 1UL;
+
+/**
+ * Records the result of a check, printing where it was made if it failed.
+ *
+ * @param fCondition   Result of the check.
+ * @param szaExpression Expression that was checked.
+ * @param szaFile      Source file of the check.
+ * @param iLine        Line of the check.
+ */
+void TestCheck(int fCondition, const char *szaExpression, const char *szaFile,
+			   int iLine) {
+	nChecks++;
+	if (fCondition)
+		return;
+
+	nFailures++;
+	printf("%s:%d: check failed: %s\n", szaFile, iLine, szaExpression);
+}
+
+/**
+ * Prints the summary of a suite.
+ *
+ * @param  szaSuite Name of the suite.
+ * @return          Exit code of the program: 0 if every check passed.
+ */
+int TestFinish(const char *szaSuite) {
+	printf("%s: %ld checks, %ld failed\n", szaSuite, nChecks, nFailures);
+	return (nFailures == 0L) ? 0 : 1;
+}
+
+/**
+ * Gets the current time of a monotonic clock.
+ *
+ * @return Time in milliseconds.
+ */
+double TestMilliseconds(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+/**
+ * Converts an ASCII string into UTF-16, since wide literals aren't 16 bits
+ * wide on every platform.
+ *
+ * @param  szOutput Buffer to receive the string, large enough for the input.
+ * @param  szaInput ASCII string to be converted.
+ * @return          Number of characters converted.
+ */
+size_t TestWiden(unsigned short *szOutput, const char *szaInput) {
+	size_t cch;
+
+	for (cch = 0; szaInput[cch] != '\0'; cch++)
+		szOutput[cch] = (unsigned char)szaInput[cch];
+	szOutput[cch] = 0;
+
+	return cch;
+}
+
+/**
+ * Seeds the random number generator, so that every run of a suite sees the
+ * same data.
+ *
+ * @param ulSeed Seed of the generator.
+ */
+void TestSeed(unsigned long ulSeed) {
+	ulRandomState = (ulSeed == 0UL) ? 1UL : ulSeed;
+}
+
+/**
+ * Gets the next number of a xorshift generator, which gives the same sequence
+ * regardless of the C library.
+ *
+ * @param  ulRange Number of possible values.
+ * @return         Random number between 0 and ulRange - 1.
+ */
+unsigned long TestRandom(unsigned long ulRange) {
+	unsigned long x = ulRandomState;
+
+	x ^= (x << 13) & 0xFFFFFFFFUL;
+	x ^= x >> 17;
+	x ^= (x << 5) & 0xFFFFFFFFUL;
+	ulRandomState = x;
+
+	return (ulRange == 0UL) ? 0UL : (x % ulRange);
+}
+
+/**
+ * Creates an empty scratch folder in the temporary folder, replacing any
+ * left over from a previous run.
+ *
+ * @param  szaPath Buffer of at least 256 bytes to receive the path.
+ * @param  szaName Name of the folder.
+ * @return         1 if the folder was created.
+ */
+int TestMakeFolder(char *szaPath, const char *szaName) {
+	const char *szaTemp;
+
+	szaTemp = getenv("TMPDIR");
+	if ((szaTemp == NULL) || (szaTemp[0] == '\0'))
+		szaTemp = "/tmp";
+	snprintf(szaPath, 256, "%s/winuki-%s-%ld", szaTemp, szaName,
+			 (long)getpid());
+
+	TestRemoveFolder(szaPath);
+	return mkdir(szaPath, 0755) == 0;
+}
+
+/**
+ * Writes a whole file, replacing it if it exists.
+ *
+ * @param  szaPath Path to the file.
+ * @param  lpData  Contents of the file.
+ * @param  cbData  Size of the contents in bytes.
+ * @return         1 if the file was written.
+ */
+int TestWriteFile(const char *szaPath, const void *lpData, size_t cbData) {
+	FILE *lpFile;
+	int fWritten;
+
+	lpFile = fopen(szaPath, "wb");
+	if (lpFile == NULL)
+		return 0;
+
+	fWritten = fwrite(lpData, 1, cbData, lpFile) == cbData;
+	return (fclose(lpFile) == 0) && fWritten;
+}
+
+/**
+ * Removes a scratch folder and everything in it.
+ *
+ * @param szaPath Path to the folder.
+ */
+void TestRemoveFolder(const char *szaPath) {
+	nftw(szaPath, RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/**
+ * Removes a single entry of a folder tree being walked.
+ *
+ * @param  szaPath Path to the entry.
+ * @param  lpStat  Ignored.
+ * @param  iFlag   Ignored.
+ * @param  lpFtw   Ignored.
+ * @return         Always 0 to keep walking.
+ */
+int RemoveEntry(const char *szaPath, const struct stat *lpStat, int iFlag,
+				struct FTW *lpFtw) {
+	(void)lpStat;
+	(void)iFlag;
+	(void)lpFtw;
+
+	remove(szaPath);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+/**
+ * TestHelper.h
+ * Small helpers shared by the test suites and benchmarks.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _TESTHELPER_H
+#define _TESTHELPER_H
+
+#include <stddef.h>
+
+// Checks a condition and records a failure with its location when it's false.
+#define TEST_CHECK(x) TestCheck((x), #x, __FILE__, __LINE__)
+
+// Results.
+void TestCheck(int fCondition, const char *szaExpression, const char *szaFile,
+			   int iLine);
+int TestFinish(const char *szaSuite);
+
+// Timing.
+double TestMilliseconds(void);
+
+// Data generation.
+size_t TestWiden(unsigned short *szOutput, const char *szaInput);
+void TestSeed(unsigned long ulSeed);
+unsigned long TestRandom(unsigned long ulRange);
+
+// Scratch files.
+int TestMakeFolder(char *szaPath, const char *szaName);
+int TestWriteFile(const char *szaPath, const void *lpData, size_t cbData);
+void TestRemoveFolder(const char *szaPath);
+
+#endif  // _TESTHELPER_H
\ No newline at end of file
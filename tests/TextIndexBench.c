@@ -0,0 +1,98 @@
+/**
+ * TextIndexBench.c
+ * Measures the full-text index on a large workspace: building it, answering a
+ * two-word query and re-indexing a single page after it's saved.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "TextIndex.h"
+
+// Definitions.
+#define NUM_PAGES      50000L
+#define WORDS_PER_PAGE 300
+#define NUM_WORDS      20000UL
+#define NUM_QUERIES    1000
+#define NUM_SAVES      1000
+
+// Private methods.
+size_t MakePage(char *szaPage);
+
+/**
+ * Fills a page with random words from the vocabulary.
+ *
+ * @param  szaPage Buffer to hold the page text.
+ * @return         Length of the page text.
+ */
+size_t MakePage(char *szaPage) {
+	size_t nLen;
+	int i;
+
+	nLen = 0;
+	for (i = 0; i < WORDS_PER_PAGE; i++) {
+		nLen += sprintf(szaPage + nLen, "w%lu ",
+						(unsigned long)TestRandom(NUM_WORDS));
+	}
+
+	return nLen;
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	TXTIDX_MATCH aMatches[64];
+	TEXTINDEX tiIndex;
+	char szaPage[WORDS_PER_PAGE * 8];
+	double dBuild;
+	double dQuery;
+	double dSave;
+	size_t nLen;
+	long nMatches;
+	long i;
+
+	TestSeed(5);
+	TextIndexInitialize(&tiIndex);
+
+	// Index every page, as done when a workspace is opened.
+	dBuild = 0.0;
+	for (i = 0L; i < NUM_PAGES; i++) {
+		nLen = MakePage(szaPage);
+		dQuery = TestMilliseconds();
+		TextIndexSetDocument(&tiIndex, TXTIDX_ARTICLE, i, szaPage, nLen);
+		dBuild += TestMilliseconds() - dQuery;
+	}
+
+	// Ask for the same two words a number of times.
+	nMatches = 0L;
+	dQuery = TestMilliseconds();
+	for (i = 0L; i < NUM_QUERIES; i++)
+		nMatches = TextIndexQuery(&tiIndex, "w17 w42", aMatches, 64);
+	dQuery = (TestMilliseconds() - dQuery) / NUM_QUERIES;
+
+	// Save random pages again.
+	dSave = 0.0;
+	for (i = 0L; i < NUM_SAVES; i++) {
+		nLen = MakePage(szaPage);
+		dSave -= TestMilliseconds();
+		TextIndexSetDocument(&tiIndex, TXTIDX_ARTICLE,
+							 (long)TestRandom(NUM_PAGES), szaPage, nLen);
+		dSave += TestMilliseconds();
+	}
+	dSave /= NUM_SAVES;
+
+	printf("%ld pages of %d words indexed in %.0f ms\n", NUM_PAGES,
+		   WORDS_PER_PAGE, dBuild);
+	printf("two-word query: %ld matches in %.4f ms\n", nMatches, dQuery);
+	printf("re-indexing a saved page: %.4f ms\n", dSave);
+
+	TextIndexFree(&tiIndex);
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+/**
+ * TextIndexTest.c
+ * Checks the full-text index on a few known pages, then against a plain scan
+ * of the page texts through a long run of random saves, removals and queries.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "TextIndex.h"
+
+// Definitions.
+#define NUM_PAGES    40
+#define NUM_STEPS    20000
+#define NUM_WORDS    12
+#define MAX_PAGE_LEN 256
+
+// Vocabulary of the random pages.
+const char *aszaWords[NUM_WORDS] = {
+	"alpha", "Beta", "GAMMA", "delta", "epsilon", "zeta", "eta", "theta",
+	"iota", "kappa", "lambda", "mu"
+};
+
+// Private methods.
+void CheckKnownPages(void);
+void CheckAgainstScan(void);
+long FindWord(const char *szaText, const char *szaWord);
+int IsWordChar(char c);
+
+/**
+ * Checks if a character is part of a word, following the index's rules.
+ *
+ * @param  c Character to check.
+ * @return   Non-zero if it's part of a word.
+ */
+int IsWordChar(char c) {
+	return isalnum((unsigned char)c) || (c == '_') || ((unsigned char)c >= 0x80);
+}
+
+/**
+ * Finds the first occurrence of a whole word in a text, ignoring case.
+ *
+ * @param  szaText Text to search in.
+ * @param  szaWord Word to look for.
+ * @return         Offset of the word or -1 if it isn't there.
+ */
+long FindWord(const char *szaText, const char *szaWord) {
+	size_t nLen = strlen(szaWord);
+	size_t i;
+	size_t j;
+
+	for (i = 0; szaText[i] != '\0'; i++) {
+		if ((i > 0) && IsWordChar(szaText[i - 1]))
+			continue;
+
+		for (j = 0; j < nLen; j++) {
+			if (tolower((unsigned char)szaText[i + j]) !=
+					tolower((unsigned char)szaWord[j])) {
+				break;
+			}
+		}
+		if ((j == nLen) && !IsWordChar(szaText[i + nLen]))
+			return (long)i;
+	}
+
+	return -1L;
+}
+
+/**
+ * Checks queries on a few hand-written pages.
+ */
+void CheckKnownPages(void) {
+	TXTIDX_MATCH aMatches[8];
+	TEXTINDEX tiIndex;
+	char szaLong[TXTIDX_MAX_TERM_LEN + 16];
+	long nMatches;
+
+	TEST_CHECK(TextIndexInitialize(&tiIndex));
+	TEST_CHECK(TextIndexSetDocument(&tiIndex, TXTIDX_ARTICLE, 0,
+									"Hello World, hello again", 24));
+	TEST_CHECK(TextIndexSetDocument(&tiIndex, TXTIDX_ARTICLE, 1,
+									"bar hello_there world", 21));
+	TEST_CHECK(TextIndexSetDocument(&tiIndex, TXTIDX_TEMPLATE, 0,
+									"<b>WORLD</b> hello", 18));
+
+	// Every word has to be there, in any case, and the offset is the one of
+	// the first query word.
+	nMatches = TextIndexQuery(&tiIndex, "world HELLO", aMatches, 8);
+	TEST_CHECK(nMatches == 2L);
+	TEST_CHECK((aMatches[0].iKind == TXTIDX_ARTICLE) &&
+			   (aMatches[0].nPage == 0L) && (aMatches[0].dwOffset == 6));
+	TEST_CHECK((aMatches[1].iKind == TXTIDX_TEMPLATE) &&
+			   (aMatches[1].nPage == 0L) && (aMatches[1].dwOffset == 3));
+
+	// Underscores are part of words.
+	TEST_CHECK(TextIndexQuery(&tiIndex, "hello_there", aMatches, 8) == 1L);
+	TEST_CHECK(TextIndexQuery(&tiIndex, "there", aMatches, 8) == 0L);
+	TEST_CHECK(TextIndexQuery(&tiIndex, "", aMatches, 8) == 0L);
+	TEST_CHECK(TextIndexQuery(&tiIndex, "world", aMatches, 1) == 1L);
+
+	// Words longer than the limit are neither indexed nor searchable.
+	memset(szaLong, 'x', sizeof(szaLong) - 1);
+	szaLong[sizeof(szaLong) - 1] = '\0';
+	TEST_CHECK(TextIndexSetDocument(&tiIndex, TXTIDX_ARTICLE, 2, szaLong,
+									strlen(szaLong)));
+	TEST_CHECK(TextIndexQuery(&tiIndex, szaLong, aMatches, 8) == 0L);
+
+	// Saving a page replaces its words, and removing it drops them.
+	TEST_CHECK(TextIndexSetDocument(&tiIndex, TXTIDX_ARTICLE, 0, "bye", 3));
+	TEST_CHECK(TextIndexQuery(&tiIndex, "hello world", aMatches, 8) == 1L);
+	TEST_CHECK(TextIndexPageHasWords(&tiIndex, TXTIDX_ARTICLE, 0, "BYE"));
+	TEST_CHECK(!TextIndexPageHasWords(&tiIndex, TXTIDX_ARTICLE, 0, "hello"));
+	TextIndexRemoveDocument(&tiIndex, TXTIDX_ARTICLE, 0);
+	TEST_CHECK(TextIndexQuery(&tiIndex, "bye", aMatches, 8) == 0L);
+	TEST_CHECK(!TextIndexPageHasWords(&tiIndex, TXTIDX_ARTICLE, 0, "bye"));
+	TEST_CHECK(!TextIndexPageHasWords(&tiIndex, TXTIDX_ARTICLE, 99, "bye"));
+
+	TextIndexFree(&tiIndex);
+}
+
+/**
+ * Compares the index with a plain scan of the current page texts while pages
+ * are saved and removed at random, enough for dead documents to get purged a
+ * number of times.
+ */
+void CheckAgainstScan(void) {
+	static char aszaPages[NUM_PAGES][MAX_PAGE_LEN];
+	TXTIDX_MATCH aMatches[NUM_PAGES];
+	TEXTINDEX tiIndex;
+	const char *aszaQuery[3];
+	char szaQuery[64];
+	long alOffsets[NUM_PAGES];
+	long nExpected;
+	long nMatches;
+	long lOffset;
+	long nFailed;
+	int nQueryWords;
+	int nPageWords;
+	int iStep;
+	int iPage;
+	int iWord;
+	int i;
+
+	TestSeed(5);
+	memset(aszaPages, 0, sizeof(aszaPages));
+	TEST_CHECK(TextIndexInitialize(&tiIndex));
+
+	nFailed = 0L;
+	for (iStep = 0; iStep < NUM_STEPS; iStep++) {
+		iPage = (int)TestRandom(NUM_PAGES);
+
+		// Save or remove a page.
+		if (TestRandom(8) == 0) {
+			aszaPages[iPage][0] = '\0';
+			TextIndexRemoveDocument(&tiIndex, TXTIDX_ARTICLE, iPage);
+		} else {
+			aszaPages[iPage][0] = '\0';
+			nPageWords = (int)TestRandom(8);
+			for (i = 0; i < nPageWords; i++) {
+				strcat(aszaPages[iPage], aszaWords[TestRandom(NUM_WORDS)]);
+				strcat(aszaPages[iPage], (TestRandom(2) == 0) ? " " : ", ");
+			}
+			TEST_CHECK(TextIndexSetDocument(&tiIndex, TXTIDX_ARTICLE, iPage,
+				aszaPages[iPage], strlen(aszaPages[iPage])));
+		}
+
+		// Ask for up to three words.
+		nQueryWords = 1 + (int)TestRandom(3);
+		szaQuery[0] = '\0';
+		for (i = 0; i < nQueryWords; i++) {
+			aszaQuery[i] = aszaWords[TestRandom(NUM_WORDS)];
+			strcat(szaQuery, aszaQuery[i]);
+			strcat(szaQuery, " ");
+		}
+
+		// Work out the answer by scanning every page.
+		nExpected = 0L;
+		for (iPage = 0; iPage < NUM_PAGES; iPage++) {
+			alOffsets[iPage] = -1L;
+			for (iWord = 0; iWord < nQueryWords; iWord++) {
+				lOffset = FindWord(aszaPages[iPage], aszaQuery[iWord]);
+				if (lOffset < 0L)
+					break;
+				if (iWord == 0)
+					alOffsets[iPage] = lOffset;
+			}
+
+			if (iWord < nQueryWords) {
+				alOffsets[iPage] = -1L;
+			} else {
+				nExpected++;
+			}
+
+			if (TextIndexPageHasWords(&tiIndex, TXTIDX_ARTICLE, iPage,
+					szaQuery) != (alOffsets[iPage] >= 0L)) {
+				nFailed++;
+			}
+		}
+
+		// Every match has to be expected, at the right place.
+		nMatches = TextIndexQuery(&tiIndex, szaQuery, aMatches, NUM_PAGES);
+		if (nMatches != nExpected)
+			nFailed++;
+		for (i = 0; i < nMatches; i++) {
+			if ((aMatches[i].iKind != TXTIDX_ARTICLE) ||
+					(alOffsets[aMatches[i].nPage] !=
+					 (long)aMatches[i].dwOffset)) {
+				nFailed++;
+			}
+		}
+	}
+
+	printf("%d random steps, %ld disagreements with the scan\n", NUM_STEPS,
+		   nFailed);
+	TEST_CHECK(nFailed == 0L);
+	TextIndexFree(&tiIndex);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	CheckKnownPages();
+	CheckAgainstScan();
+
+	return TestFinish("TextIndexTest");
+}
\ No newline at end of file
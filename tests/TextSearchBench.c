@@ -0,0 +1,157 @@
+/**
+ * TextSearchBench.c
+ * Compares the search kernels with the old way of finding the next occurrence,
+ * which copied the needle and upper-cased the whole page before every search,
+ * both when the occurrence is right after the cursor and when it isn't there.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+#include "TestHelper.h"
+#include "TextSearch.h"
+
+// Definitions.
+#define PAGE_SIZE (1 << 20)
+#define NUM_RUNS  20
+
+// Private methods.
+size_t FindOld(const unsigned short *szText, size_t cchText, size_t nFrom,
+			   const unsigned short *szNeedle, size_t cchNeedle,
+			   int fMatchCase);
+void Measure(const char *szaName, const unsigned short *szPage, size_t nFrom,
+			 const char *szaNeedle, int fMatchCase);
+
+/**
+ * Finds the next occurrence of a needle the way FindNext used to, with a copy
+ * of the text and the needle upper-cased in full and a plain search.
+ *
+ * @param  szText     Text to search in.
+ * @param  cchText    Length of the text.
+ * @param  nFrom      Position to start searching from.
+ * @param  szNeedle   Text to look for.
+ * @param  cchNeedle  Length of the needle.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Position of the occurrence or TXTSRCH_NONE.
+ */
+size_t FindOld(const unsigned short *szText, size_t cchText, size_t nFrom,
+			   const unsigned short *szNeedle, size_t cchNeedle,
+			   int fMatchCase) {
+	unsigned short *szHaystack;
+	unsigned short *szUpper;
+	size_t nFound;
+	size_t iPos;
+	size_t i;
+
+	// Copy everything, upper-casing it if needed.
+	szHaystack = (unsigned short*)malloc(cchText * sizeof(unsigned short));
+	szUpper = (unsigned short*)malloc(cchNeedle * sizeof(unsigned short));
+	for (i = 0; i < cchText; i++) {
+		szHaystack[i] = fMatchCase ? szText[i] :
+			(unsigned short)towupper(szText[i]);
+	}
+	for (i = 0; i < cchNeedle; i++) {
+		szUpper[i] = fMatchCase ? szNeedle[i] :
+			(unsigned short)towupper(szNeedle[i]);
+	}
+
+	// Look for it from the cursor.
+	nFound = TXTSRCH_NONE;
+	for (iPos = nFrom; (iPos + cchNeedle) <= cchText; iPos++) {
+		if ((szHaystack[iPos] == szUpper[0]) &&
+				(memcmp(szHaystack + iPos, szUpper,
+						cchNeedle * sizeof(unsigned short)) == 0)) {
+			nFound = iPos;
+			break;
+		}
+	}
+
+	free(szHaystack);
+	free(szUpper);
+	return nFound;
+}
+
+/**
+ * Times a search with the kernels and the old way, and prints both.
+ *
+ * @param szaName    Name of the case.
+ * @param szPage     Page to search in.
+ * @param nFrom      Position to start searching from.
+ * @param szaNeedle  Text to look for.
+ * @param fMatchCase Should the case of the letters be taken into account?
+ */
+void Measure(const char *szaName, const unsigned short *szPage, size_t nFrom,
+			 const char *szaNeedle, int fMatchCase) {
+	unsigned short szNeedle[32];
+	size_t cchNeedle;
+	size_t nFound;
+	size_t nOld;
+	double dBest;
+	double dOld;
+	double dTime;
+	int iRun;
+
+	cchNeedle = TestWiden(szNeedle, szaNeedle);
+	nFound = TXTSRCH_NONE;
+	nOld = TXTSRCH_NONE;
+	dBest = 0.0;
+	dOld = 0.0;
+	for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+		dTime = TestMilliseconds();
+		nFound = TextSearchFind(szPage, PAGE_SIZE, nFrom, szNeedle, cchNeedle,
+			fMatchCase);
+		dTime = TestMilliseconds() - dTime;
+		if ((iRun == 0) || (dTime < dBest))
+			dBest = dTime;
+
+		dTime = TestMilliseconds();
+		nOld = FindOld(szPage, PAGE_SIZE, nFrom, szNeedle, cchNeedle,
+			fMatchCase);
+		dTime = TestMilliseconds() - dTime;
+		if ((iRun == 0) || (dTime < dOld))
+			dOld = dTime;
+	}
+
+	if (nFound != nOld) {
+		printf("%s: the old way found something else\n", szaName);
+		exit(1);
+	}
+	printf("%-28s %-13s %10.4f ms %10.4f ms\n", szaName,
+		   fMatchCase ? "matching case" : "ignoring case", dBest, dOld);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	const char *szaFill = "Lorem ipsum dolor sit amet, consectetur. ";
+	unsigned short *szPage;
+	size_t nFill;
+	size_t nNear;
+	size_t i;
+
+	// Fill the page with text and put a needle near its end.
+	szPage = (unsigned short*)malloc(PAGE_SIZE * sizeof(unsigned short));
+	nFill = strlen(szaFill);
+	for (i = 0; i < PAGE_SIZE; i++)
+		szPage[i] = (unsigned short)szaFill[i % nFill];
+	nNear = PAGE_SIZE - 2000;
+	TestWiden(szPage + nNear + 500, "Needle");
+	szPage[nNear + 506] = ' ';
+
+	printf("%d characters\n", PAGE_SIZE);
+	printf("%-28s %-13s %13s %13s\n", "search", "", "kernels", "old way");
+	Measure("from near the end", szPage, nNear, "needle", 0);
+	Measure("from near the end", szPage, nNear, "Needle", 1);
+	Measure("whole page, not found", szPage, 0, "haystack", 0);
+	Measure("whole page, not found", szPage, 0, "haystack", 1);
+	Measure("whole page, short needle", szPage, 0, "zq", 1);
+
+	free(szPage);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,240 @@
+/**
+ * TextSearchTest.c
+ * Checks the search kernels in both directions, with and without matching
+ * case, against a naive search on random texts.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include <wctype.h>
+#include "TestHelper.h"
+#include "TextSearch.h"
+
+// Definitions.
+#define NUM_CASES  200000L
+#define MAX_TEXT   200
+#define MAX_NEEDLE 9
+
+// Letters of the random texts. Some share their low byte with others, which
+// puts them in the same bucket of the skip tables, and some fold to ASCII.
+const unsigned short awLetters[] = {
+	'a', 'A', 'b', 'B', 'i', 'I', ' ', 0xE9, 0xC9, 0x0161, 0x0160, 0x0141,
+	0x0131, 0x4E00
+};
+#define NUM_LETTERS (sizeof(awLetters) / sizeof(awLetters[0]))
+
+// Tell the build without vector paths apart.
+#if defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define SUITE_NAME "TextSearchTest"
+#else
+	#define SUITE_NAME "TextSearchScalarTest"
+#endif
+
+// Private methods.
+int MatchesAt(const unsigned short *szText, const unsigned short *szNeedle,
+			  size_t cchNeedle, int fMatchCase);
+size_t FindReference(const unsigned short *szText, size_t cchText,
+					 size_t nFrom, const unsigned short *szNeedle,
+					 size_t cchNeedle, int fMatchCase);
+size_t FindReverseReference(const unsigned short *szText, size_t cchText,
+							size_t nBefore, const unsigned short *szNeedle,
+							size_t cchNeedle, int fMatchCase);
+void CheckKnownCases(void);
+void CheckRandomCases(void);
+
+/**
+ * Checks if a needle is at the start of a text.
+ *
+ * @param  szText     Text with at least cchNeedle characters.
+ * @param  szNeedle   Needle to check.
+ * @param  cchNeedle  Length of the needle.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Non-zero if the needle is there.
+ */
+int MatchesAt(const unsigned short *szText, const unsigned short *szNeedle,
+			  size_t cchNeedle, int fMatchCase) {
+	size_t i;
+
+	for (i = 0; i < cchNeedle; i++) {
+		if (fMatchCase ? (szText[i] != szNeedle[i]) :
+				(towupper(szText[i]) != towupper(szNeedle[i]))) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Finds the first occurrence of a needle that starts at or after a position
+ * by trying every one of them.
+ *
+ * @param  szText     Text to search in.
+ * @param  cchText    Length of the text.
+ * @param  nFrom      First position the needle can start at.
+ * @param  szNeedle   Text to look for.
+ * @param  cchNeedle  Length of the needle.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Position of the occurrence or TXTSRCH_NONE.
+ */
+size_t FindReference(const unsigned short *szText, size_t cchText,
+					 size_t nFrom, const unsigned short *szNeedle,
+					 size_t cchNeedle, int fMatchCase) {
+	size_t iPos;
+
+	if (cchNeedle == 0)
+		return TXTSRCH_NONE;
+
+	for (iPos = nFrom; (iPos + cchNeedle) <= cchText; iPos++) {
+		if (MatchesAt(szText + iPos, szNeedle, cchNeedle, fMatchCase))
+			return iPos;
+	}
+
+	return TXTSRCH_NONE;
+}
+
+/**
+ * Finds the last occurrence of a needle that ends by a position by trying
+ * every one of them.
+ *
+ * @param  szText     Text to search in.
+ * @param  cchText    Length of the text.
+ * @param  nBefore    Position the needle must end by.
+ * @param  szNeedle   Text to look for.
+ * @param  cchNeedle  Length of the needle.
+ * @param  fMatchCase Should the case of the letters be taken into account?
+ * @return            Position of the occurrence or TXTSRCH_NONE.
+ */
+size_t FindReverseReference(const unsigned short *szText, size_t cchText,
+							size_t nBefore, const unsigned short *szNeedle,
+							size_t cchNeedle, int fMatchCase) {
+	size_t iPos;
+
+	if (nBefore > cchText)
+		nBefore = cchText;
+	if ((cchNeedle == 0) || (cchNeedle > nBefore))
+		return TXTSRCH_NONE;
+
+	for (iPos = nBefore - cchNeedle + 1; iPos > 0; iPos--) {
+		if (MatchesAt(szText + iPos - 1, szNeedle, cchNeedle, fMatchCase))
+			return iPos - 1;
+	}
+
+	return TXTSRCH_NONE;
+}
+
+/**
+ * Checks a few searches worked out by hand.
+ */
+void CheckKnownCases(void) {
+	unsigned short szText[64];
+	unsigned short szNeedle[16];
+	size_t cchText;
+	size_t cchNeedle;
+
+	cchText = TestWiden(szText, "The cat sat on the Cat mat");
+	cchNeedle = TestWiden(szNeedle, "cat");
+	TEST_CHECK(TextSearchFind(szText, cchText, 0, szNeedle, cchNeedle, 1) ==
+			   4);
+	TEST_CHECK(TextSearchFind(szText, cchText, 5, szNeedle, cchNeedle, 1) ==
+			   TXTSRCH_NONE);
+	TEST_CHECK(TextSearchFind(szText, cchText, 5, szNeedle, cchNeedle, 0) ==
+			   19);
+	TEST_CHECK(TextSearchFindReverse(szText, cchText, cchText, szNeedle,
+									 cchNeedle, 0) == 19);
+	TEST_CHECK(TextSearchFindReverse(szText, cchText, 21, szNeedle,
+									 cchNeedle, 0) == 4);
+	TEST_CHECK(TextSearchFindReverse(szText, cchText, 6, szNeedle,
+									 cchNeedle, 0) == TXTSRCH_NONE);
+
+	// Longer needles go through the skip tables.
+	cchNeedle = TestWiden(szNeedle, "THE CAT MAT");
+	TEST_CHECK(TextSearchFind(szText, cchText, 0, szNeedle, cchNeedle, 0) ==
+			   15);
+	TEST_CHECK(TextSearchFind(szText, cchText, 0, szNeedle, cchNeedle, 1) ==
+			   TXTSRCH_NONE);
+	cchNeedle = TestWiden(szNeedle, "ON THE CAT");
+	TEST_CHECK(TextSearchFind(szText, cchText, 0, szNeedle, cchNeedle, 0) ==
+			   12);
+	TEST_CHECK(TextSearchFindReverse(szText, cchText, 1000, szNeedle,
+									 cchNeedle, 0) == 12);
+
+	// Needles that don't fit, or aren't there at all.
+	TEST_CHECK(TextSearchFind(szText, cchText, 0, szNeedle, 0, 1) ==
+			   TXTSRCH_NONE);
+	TEST_CHECK(TextSearchFind(szText, 3, 0, szNeedle, cchNeedle, 0) ==
+			   TXTSRCH_NONE);
+	TEST_CHECK(TextSearchFind(szText, cchText, cchText, szNeedle, 1, 0) ==
+			   TXTSRCH_NONE);
+	TEST_CHECK(TextSearchFindReverse(szText, cchText, 0, szNeedle, 1, 0) ==
+			   TXTSRCH_NONE);
+}
+
+/**
+ * Compares both directions of the search with the reference on random texts,
+ * needles and starting points.
+ */
+void CheckRandomCases(void) {
+	unsigned short szText[MAX_TEXT];
+	unsigned short szNeedle[MAX_NEEDLE];
+	size_t cchText;
+	size_t cchNeedle;
+	size_t nFrom;
+	long nFailed;
+	long iCase;
+	int fMatchCase;
+	size_t i;
+
+	TestSeed(12);
+	nFailed = 0L;
+	for (iCase = 0L; iCase < NUM_CASES; iCase++) {
+		// Keep the alphabet small every now and then so that there are plenty
+		// of occurrences.
+		cchText = TestRandom(MAX_TEXT);
+		for (i = 0; i < cchText; i++)
+			szText[i] = awLetters[TestRandom((iCase & 1) ? NUM_LETTERS : 3)];
+
+		// Take the needle from the text most of the time.
+		cchNeedle = 1 + TestRandom(MAX_NEEDLE - 1);
+		if ((cchNeedle <= cchText) && (TestRandom(4) != 0)) {
+			memcpy(szNeedle, szText + TestRandom(cchText - cchNeedle + 1),
+				   cchNeedle * sizeof(unsigned short));
+		} else {
+			for (i = 0; i < cchNeedle; i++)
+				szNeedle[i] = awLetters[TestRandom(NUM_LETTERS)];
+		}
+		nFrom = TestRandom(cchText + 2);
+		fMatchCase = (int)TestRandom(2);
+
+		if ((TextSearchFind(szText, cchText, nFrom, szNeedle, cchNeedle,
+				fMatchCase) != FindReference(szText, cchText, nFrom, szNeedle,
+				cchNeedle, fMatchCase)) ||
+				(TextSearchFindReverse(szText, cchText, nFrom, szNeedle,
+				cchNeedle, fMatchCase) != FindReverseReference(szText,
+				cchText, nFrom, szNeedle, cchNeedle, fMatchCase))) {
+			nFailed++;
+		}
+	}
+
+	printf("%ld random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nFailed);
+	TEST_CHECK(nFailed == 0L);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	// Fold accented letters too, like towupper does on Windows CE.
+	setlocale(LC_CTYPE, "C.UTF-8");
+
+	CheckKnownCases();
+	CheckRandomCases();
+
+	return TestFinish(SUITE_NAME);
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+/**
+ * TranscodeBench.c
+ * Measures the throughput of the transcoding routines on plain ASCII, on
+ * accented Latin text and on CJK text, next to a plain loop that decodes one
+ * byte at a time.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Transcode.h"
+
+// Definitions.
+#define TEXT_SIZE  (1 << 20)
+#define NUM_RUNS   100
+#define NUM_TEXTS  3
+#define NUM_PASSES 4
+
+// Line repeated to make each text.
+const char *aszaLines[NUM_TEXTS] = {
+	"<p>The quick brown fox jumps over the lazy dog.</p>\n",
+	"<p>Le c\xC5\x93ur a ses raisons que la raison ne conna\xC3\xAEt "
+		"point, d\xC3\xA9j\xC3\xA0 vu.</p>\n",
+	"<p>\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87"
+		"\xE7\xAB\xA0\xE3\x81\xA7\xE3\x81\x99\xE3\x80\x82</p>\n"
+};
+const char *aszaNames[NUM_TEXTS] = { "ascii", "latin", "cjk" };
+
+// Private methods.
+size_t DecodePlain(unsigned short *szDest, const unsigned char *lpSrc,
+				   size_t cbSrc);
+double GigabytesPerSecond(size_t cbData, double dMilliseconds);
+
+/**
+ * Decodes well-formed UTF-8 one byte at a time, as a baseline.
+ *
+ * @param  szDest Buffer for the UTF-16 text.
+ * @param  lpSrc  UTF-8 text.
+ * @param  cbSrc  Length of the text in bytes.
+ * @return        Length of the UTF-16 text.
+ */
+size_t DecodePlain(unsigned short *szDest, const unsigned char *lpSrc,
+				   size_t cbSrc) {
+	unsigned long dwChar;
+	size_t cchDest;
+	size_t iSrc;
+
+	cchDest = 0;
+	for (iSrc = 0; iSrc < cbSrc; iSrc++) {
+		dwChar = lpSrc[iSrc];
+		if (dwChar >= 0xF0) {
+			dwChar = ((dwChar & 0x07) << 18) | ((lpSrc[iSrc + 1] & 0x3F) << 12) |
+				((lpSrc[iSrc + 2] & 0x3F) << 6) | (lpSrc[iSrc + 3] & 0x3F);
+			iSrc += 3;
+		} else if (dwChar >= 0xE0) {
+			dwChar = ((dwChar & 0x0F) << 12) | ((lpSrc[iSrc + 1] & 0x3F) << 6) |
+				(lpSrc[iSrc + 2] & 0x3F);
+			iSrc += 2;
+		} else if (dwChar >= 0xC0) {
+			dwChar = ((dwChar & 0x1F) << 6) | (lpSrc[iSrc + 1] & 0x3F);
+			iSrc++;
+		}
+
+		if (dwChar >= 0x10000) {
+			szDest[cchDest++] = (unsigned short)(0xD800 +
+				((dwChar - 0x10000) >> 10));
+			szDest[cchDest++] = (unsigned short)(0xDC00 + (dwChar & 0x3FF));
+		} else {
+			szDest[cchDest++] = (unsigned short)dwChar;
+		}
+	}
+
+	return cchDest;
+}
+
+/**
+ * Works out a throughput.
+ *
+ * @param  cbData        Bytes processed.
+ * @param  dMilliseconds Time it took.
+ * @return               Throughput in gigabytes per second.
+ */
+double GigabytesPerSecond(size_t cbData, double dMilliseconds) {
+	return ((double)cbData / 1e9) / (dMilliseconds / 1000.0);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	unsigned short *szWide;
+	char *szaBack;
+	char *szaText;
+	size_t cbText;
+	size_t cchWide;
+	size_t cbBack;
+	size_t nLine;
+	double adBest[NUM_PASSES];
+	double adTime[NUM_PASSES + 1];
+	int iText;
+	int iRun;
+	int i;
+
+	szaText = (char*)malloc(TEXT_SIZE);
+	szaBack = (char*)malloc(TEXT_SIZE);
+	szWide = (unsigned short*)malloc(TEXT_SIZE * sizeof(unsigned short));
+
+	printf("%-6s %14s %14s %14s %14s\n", "text", "utf-8 length",
+		   "utf-8 > wide", "plain loop", "wide > utf-8");
+	for (iText = 0; iText < NUM_TEXTS; iText++) {
+		nLine = strlen(aszaLines[iText]);
+		for (cbText = 0; (cbText + nLine) <= TEXT_SIZE; cbText += nLine)
+			memcpy(szaText + cbText, aszaLines[iText], nLine);
+
+		// Go through every pass a number of times, keeping the best times.
+		cchWide = 0;
+		cbBack = 0;
+		for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+			adTime[0] = TestMilliseconds();
+			cchWide = TranscodeUtf8Length(szaText, cbText);
+			adTime[1] = TestMilliseconds();
+			TranscodeUtf8ToWide(szWide, szaText, cbText);
+			adTime[2] = TestMilliseconds();
+			if (DecodePlain(szWide, (unsigned char*)szaText, cbText) !=
+					cchWide) {
+				printf("The plain loop disagrees on the %s text\n",
+					   aszaNames[iText]);
+				return 1;
+			}
+			adTime[3] = TestMilliseconds();
+			cbBack = TranscodeWideToUtf8(szaBack, szWide, cchWide);
+			adTime[4] = TestMilliseconds();
+
+			for (i = 0; i < NUM_PASSES; i++) {
+				if ((iRun == 0) || ((adTime[i + 1] - adTime[i]) < adBest[i]))
+					adBest[i] = adTime[i + 1] - adTime[i];
+			}
+		}
+
+		if ((cbBack != cbText) || (memcmp(szaBack, szaText, cbText) != 0)) {
+			printf("The %s text didn't survive the round trip\n",
+				   aszaNames[iText]);
+			return 1;
+		}
+
+		printf("%-6s", aszaNames[iText]);
+		for (i = 0; i < NUM_PASSES; i++)
+			printf(" %9.2f GB/s", GigabytesPerSecond(cbText, adBest[i]));
+		printf("\n");
+	}
+	printf("throughput is in bytes of UTF-8 text\n");
+
+	free(szaText);
+	free(szaBack);
+	free(szWide);
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,523 @@
+/**
+ * TranscodeTest.c
+ * Checks the transcoding routines on known sequences, then on random and
+ * malformed text against a slow reference that decodes by looking up every
+ * valid UTF-8 sequence, so it shares no logic with the code under test.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestHelper.h"
+#include "Transcode.h"
+
+// Definitions.
+#define NUM_CODES   0x10F800UL
+#define NUM_CASES   20000
+#define MAX_CASE    600
+#define GUARD_WIDE  0xBEEF
+#define GUARD_BYTE  0x5A
+
+// Tell the build without vector paths apart.
+#if defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define SUITE_NAME "TranscodeTest"
+#else
+	#define SUITE_NAME "TranscodeScalarTest"
+#endif
+
+// A known conversion.
+typedef struct {
+	const char *szaUtf8;
+	const char *szaWide;
+} TRANSCODE_CASE;
+
+// Well-formed and ill-formed sequences, with the UTF-16 they decode to in
+// hexadecimal.
+const TRANSCODE_CASE aCases[] = {
+	{ "", "" },
+	{ "abc", "0061 0062 0063" },
+	{ "\xC3\xA9", "00E9" },
+	{ "\xE2\x82\xAC", "20AC" },
+	{ "\xF0\x9D\x84\x9E", "D834 DD1E" },
+	{ "\xEF\xBF\xBF", "FFFF" },
+	{ "\xF4\x8F\xBF\xBF", "DBFF DFFF" },
+	{ "\x80", "FFFD" },
+	{ "\xC0\xAF", "FFFD FFFD" },
+	{ "\xC1\xBF", "FFFD FFFD" },
+	{ "\xE0\x80\xAF", "FFFD FFFD FFFD" },
+	{ "\xED\xA0\x80", "FFFD FFFD FFFD" },
+	{ "\xF4\x90\x80\x80", "FFFD FFFD FFFD FFFD" },
+	{ "\xF5\x80", "FFFD FFFD" },
+	{ "\xE2\x82", "FFFD" },
+	{ "\xE2\x82" "A", "FFFD 0041" },
+	{ "\xF0\x9D\x84", "FFFD" },
+	{ "\xF0\x9D\x84\xC3\xA9", "FFFD 00E9" },
+	{ "\xFF\xFE", "FFFD FFFD" },
+	{ NULL, NULL }
+};
+
+// Every valid UTF-8 sequence, left-aligned in the high bytes with its length
+// in the lowest one, in ascending order.
+unsigned long long *lpEncodings;
+
+// Private methods.
+void BuildEncodings(void);
+size_t EncodeReference(unsigned char *lpDest, unsigned long dwChar);
+size_t LongestPrefix(const unsigned char *lpSrc, size_t cbSrc,
+					 unsigned long *lpdwChar);
+size_t DecodeReference(unsigned short *szDest, const unsigned char *lpSrc,
+					   size_t cbSrc);
+size_t EncodeWideReference(unsigned char *lpDest, const unsigned short *szSrc,
+						   size_t cchSrc);
+void CheckKnownCases(void);
+void CheckAsciiKernels(void);
+size_t MakeRandomText(unsigned char *lpText);
+void CheckRandomText(void);
+
+/**
+ * Encodes a code point as UTF-8.
+ *
+ * @param  lpDest Buffer of at least four bytes.
+ * @param  dwChar Code point, not a surrogate.
+ * @return        Number of bytes written.
+ */
+size_t EncodeReference(unsigned char *lpDest, unsigned long dwChar) {
+	if (dwChar < 0x80) {
+		lpDest[0] = (unsigned char)dwChar;
+		return 1;
+	} else if (dwChar < 0x800) {
+		lpDest[0] = (unsigned char)(0xC0 | (dwChar >> 6));
+		lpDest[1] = (unsigned char)(0x80 | (dwChar & 0x3F));
+		return 2;
+	} else if (dwChar < 0x10000) {
+		lpDest[0] = (unsigned char)(0xE0 | (dwChar >> 12));
+		lpDest[1] = (unsigned char)(0x80 | ((dwChar >> 6) & 0x3F));
+		lpDest[2] = (unsigned char)(0x80 | (dwChar & 0x3F));
+		return 3;
+	}
+
+	lpDest[0] = (unsigned char)(0xF0 | (dwChar >> 18));
+	lpDest[1] = (unsigned char)(0x80 | ((dwChar >> 12) & 0x3F));
+	lpDest[2] = (unsigned char)(0x80 | ((dwChar >> 6) & 0x3F));
+	lpDest[3] = (unsigned char)(0x80 | (dwChar & 0x3F));
+	return 4;
+}
+
+/**
+ * Builds the sorted table of every valid UTF-8 sequence. Encoding code points
+ * in order already sorts them.
+ */
+void BuildEncodings(void) {
+	unsigned char abBytes[4];
+	unsigned long long ullEntry;
+	unsigned long dwChar;
+	size_t nEntries;
+	size_t nLen;
+	size_t i;
+
+	lpEncodings = (unsigned long long*)malloc(NUM_CODES *
+											  sizeof(unsigned long long));
+	nEntries = 0;
+	for (dwChar = 0; dwChar <= 0x10FFFFUL; dwChar++) {
+		if ((dwChar >= 0xD800) && (dwChar <= 0xDFFF))
+			continue;
+
+		nLen = EncodeReference(abBytes, dwChar);
+		ullEntry = 0;
+		for (i = 0; i < 4; i++)
+			ullEntry = (ullEntry << 8) | ((i < nLen) ? abBytes[i] : 0);
+		lpEncodings[nEntries++] = (ullEntry << 8) | nLen;
+	}
+}
+
+/**
+ * Finds the longest run of bytes that starts a valid UTF-8 sequence.
+ *
+ * @param  lpSrc    Start of the bytes.
+ * @param  cbSrc    Bytes available.
+ * @param  lpdwChar Decoded code point if the run is a whole sequence,
+ *                  otherwise TRANSCODE_REPLACEMENT.
+ * @return          Length of the run, which is zero if not even the first
+ *                  byte can start a sequence.
+ */
+size_t LongestPrefix(const unsigned char *lpSrc, size_t cbSrc,
+					 unsigned long *lpdwChar) {
+	unsigned long long ullKey;
+	unsigned long long ullMask;
+	size_t nBest;
+	size_t nLow;
+	size_t nHigh;
+	size_t nMid;
+	size_t nLen;
+
+	*lpdwChar = TRANSCODE_REPLACEMENT;
+	nBest = 0;
+	ullKey = 0;
+	for (nLen = 1; (nLen <= 4) && (nLen <= cbSrc); nLen++) {
+		ullKey |= (unsigned long long)lpSrc[nLen - 1] << (8 * (4 - nLen) + 8);
+		ullMask = ~0ULL << (8 * (4 - nLen) + 8);
+
+		// Look for the first sequence not below the run.
+		nLow = 0;
+		nHigh = NUM_CODES;
+		while (nLow < nHigh) {
+			nMid = (nLow + nHigh) / 2;
+			if (lpEncodings[nMid] < ullKey) {
+				nLow = nMid + 1;
+			} else {
+				nHigh = nMid;
+			}
+		}
+
+		if ((nLow == NUM_CODES) ||
+			((lpEncodings[nLow] & ullMask) != ullKey)) {
+			break;
+		}
+
+		nBest = nLen;
+		if ((lpEncodings[nLow] & 0xFF) == nLen) {
+			*lpdwChar = (unsigned long)nLow;
+			if (nLow >= 0xD800)
+				*lpdwChar += 0x800;
+			break;
+		}
+	}
+
+	return nBest;
+}
+
+/**
+ * Decodes UTF-8 replacing every maximal run that starts a sequence but can't
+ * be completed, or every byte that can't start one, with U+FFFD.
+ *
+ * @param  szDest Buffer for the UTF-16 text.
+ * @param  lpSrc  UTF-8 text.
+ * @param  cbSrc  Length of the text in bytes.
+ * @return        Length of the UTF-16 text.
+ */
+size_t DecodeReference(unsigned short *szDest, const unsigned char *lpSrc,
+					   size_t cbSrc) {
+	unsigned long dwChar;
+	size_t cchDest;
+	size_t iSrc;
+	size_t nLen;
+
+	cchDest = 0;
+	iSrc = 0;
+	while (iSrc < cbSrc) {
+		nLen = LongestPrefix(lpSrc + iSrc, cbSrc - iSrc, &dwChar);
+		iSrc += (nLen == 0) ? 1 : nLen;
+
+		if (dwChar >= 0x10000) {
+			szDest[cchDest++] = (unsigned short)(0xD800 +
+				((dwChar - 0x10000) >> 10));
+			szDest[cchDest++] = (unsigned short)(0xDC00 + (dwChar & 0x3FF));
+		} else {
+			szDest[cchDest++] = (unsigned short)dwChar;
+		}
+	}
+
+	return cchDest;
+}
+
+/**
+ * Encodes UTF-16 as UTF-8, replacing unpaired surrogates with U+FFFD.
+ *
+ * @param  lpDest Buffer for the UTF-8 text.
+ * @param  szSrc  UTF-16 text.
+ * @param  cchSrc Length of the text in characters.
+ * @return        Length of the UTF-8 text in bytes.
+ */
+size_t EncodeWideReference(unsigned char *lpDest, const unsigned short *szSrc,
+						   size_t cchSrc) {
+	unsigned long dwChar;
+	size_t cbDest;
+	size_t i;
+
+	cbDest = 0;
+	for (i = 0; i < cchSrc; i++) {
+		dwChar = szSrc[i];
+		if ((dwChar >= 0xD800) && (dwChar <= 0xDBFF) && ((i + 1) < cchSrc) &&
+			(szSrc[i + 1] >= 0xDC00) && (szSrc[i + 1] <= 0xDFFF)) {
+			dwChar = 0x10000 + ((dwChar - 0xD800) << 10) +
+				(szSrc[i + 1] - 0xDC00);
+			i++;
+		} else if ((dwChar >= 0xD800) && (dwChar <= 0xDFFF)) {
+			dwChar = TRANSCODE_REPLACEMENT;
+		}
+
+		cbDest += EncodeReference(lpDest + cbDest, dwChar);
+	}
+
+	return cbDest;
+}
+
+/**
+ * Checks the decoder on the table of known sequences, and that encoding the
+ * result back gives the same bytes when they were well-formed.
+ */
+void CheckKnownCases(void) {
+	unsigned short szExpected[16];
+	unsigned short szWide[16];
+	char szaBack[64];
+	const char *szaHex;
+	char *szaEnd;
+	size_t cchExpected;
+	size_t cchWide;
+	size_t cbUtf8;
+	size_t cbBack;
+	int fValid;
+	int i;
+
+	for (i = 0; aCases[i].szaUtf8 != NULL; i++) {
+		cchExpected = 0;
+		fValid = 1;
+		for (szaHex = aCases[i].szaWide; *szaHex != '\0'; szaHex = szaEnd) {
+			szExpected[cchExpected] = (unsigned short)strtoul(szaHex, &szaEnd,
+															  16);
+			if (szExpected[cchExpected++] == TRANSCODE_REPLACEMENT)
+				fValid = 0;
+		}
+
+		cbUtf8 = strlen(aCases[i].szaUtf8);
+		cchWide = TranscodeUtf8ToWide(szWide, aCases[i].szaUtf8, cbUtf8);
+		TEST_CHECK(TranscodeUtf8Length(aCases[i].szaUtf8, cbUtf8) ==
+				   cchExpected);
+		TEST_CHECK((cchWide == cchExpected) && (memcmp(szWide, szExpected,
+			cchWide * sizeof(unsigned short)) == 0));
+
+		// Valid text survives the round trip.
+		cbBack = TranscodeWideToUtf8(szaBack, szWide, cchWide);
+		TEST_CHECK(cbBack == TranscodeWideUtf8Length(szWide, cchWide));
+		if (fValid) {
+			TEST_CHECK((cbBack == cbUtf8) &&
+					   (memcmp(szaBack, aCases[i].szaUtf8, cbUtf8) == 0));
+		}
+	}
+
+	// Unpaired surrogates become U+FFFD.
+	szWide[0] = 0xDC00;
+	szWide[1] = 'a';
+	szWide[2] = 0xD800;
+	TEST_CHECK(TranscodeWideUtf8Length(szWide, 3) == 7);
+	TEST_CHECK((TranscodeWideToUtf8(szaBack, szWide, 3) == 7) &&
+			   (memcmp(szaBack, "\xEF\xBF\xBD" "a\xEF\xBF\xBD", 7) == 0));
+
+	// Blocks are only cut before an incomplete sequence.
+	TEST_CHECK(TranscodeUtf8Tail("ab", 2) == 0);
+	TEST_CHECK(TranscodeUtf8Tail("a\xC3", 2) == 1);
+	TEST_CHECK(TranscodeUtf8Tail("a\xC3\xA9", 3) == 0);
+	TEST_CHECK(TranscodeUtf8Tail("\xF0\x9D\x84", 3) == 3);
+	TEST_CHECK(TranscodeUtf8Tail("\xF0\x9D\x84\x9E", 4) == 0);
+	TEST_CHECK(TranscodeUtf8Tail("", 0) == 0);
+}
+
+/**
+ * Checks the ASCII kernels at every alignment and length up to a few vectors,
+ * with a single non-ASCII character at every position.
+ */
+void CheckAsciiKernels(void) {
+	unsigned short szWide[160];
+	char szaText[160];
+	char szaBack[160];
+	size_t nFailed;
+	size_t iStart;
+	size_t nLen;
+	size_t iBad;
+	size_t i;
+
+	nFailed = 0;
+	for (i = 0; i < sizeof(szaText); i++)
+		szaText[i] = (char)(' ' + (i % 95));
+
+	for (iStart = 0; iStart < 16; iStart++) {
+		for (nLen = 0; (iStart + nLen) < 144; nLen++) {
+			// Plain ASCII goes both ways untouched, without writing past
+			// the end.
+			memset(szWide, 0xEE, sizeof(szWide));
+			memset(szaBack, GUARD_BYTE, sizeof(szaBack));
+			TranscodeAsciiToWide(szWide, szaText + iStart, nLen);
+			TranscodeWideToAscii(szaBack, szWide, nLen);
+			if ((szWide[nLen] != 0xEEEE) ||
+				(szaBack[nLen] != GUARD_BYTE) ||
+				(memcmp(szaBack, szaText + iStart, nLen) != 0)) {
+				nFailed++;
+			}
+			for (i = 0; i < nLen; i++) {
+				if (szWide[i] != (unsigned char)szaText[iStart + i])
+					nFailed++;
+			}
+
+			// Spans stop at the first character that isn't ASCII.
+			for (iBad = 0; iBad <= nLen; iBad++) {
+				if (iBad < nLen) {
+					szaText[iStart + iBad] = (char)0xC3;
+					szWide[iBad] = 0x00E9;
+				}
+
+				if ((TranscodeAsciiSpan(szaText + iStart, nLen) != iBad) ||
+					(TranscodeWideAsciiSpan(szWide, nLen) != iBad)) {
+					nFailed++;
+				}
+
+				if (iBad < nLen) {
+					szaText[iStart + iBad] = (char)(' ' +
+						((iStart + iBad) % 95));
+					szWide[iBad] = (unsigned char)szaText[iStart + iBad];
+				}
+			}
+		}
+	}
+
+	TEST_CHECK(nFailed == 0);
+}
+
+/**
+ * Makes a random mix of ASCII runs, valid characters of every length, and
+ * stray or truncated bytes.
+ *
+ * @param  lpText Buffer of at least MAX_CASE bytes.
+ * @return        Length of the text.
+ */
+size_t MakeRandomText(unsigned char *lpText) {
+	unsigned long dwChar;
+	size_t nTarget;
+	size_t cbText;
+	size_t nLen;
+	size_t i;
+
+	nTarget = TestRandom(MAX_CASE - 40);
+	cbText = 0;
+	while (cbText < nTarget) {
+		switch (TestRandom(6)) {
+		case 0:
+			// A run of ASCII long enough for the vector paths.
+			nLen = TestRandom(40);
+			for (i = 0; i < nLen; i++)
+				lpText[cbText++] = (unsigned char)(' ' + TestRandom(95));
+			break;
+		case 1:
+			// A random byte.
+			lpText[cbText++] = (unsigned char)TestRandom(256);
+			break;
+		case 2:
+			// A truncated character.
+			do {
+				dwChar = 0x80 + TestRandom(0x10FF80UL);
+			} while ((dwChar >= 0xD800) && (dwChar <= 0xDFFF));
+			nLen = EncodeReference(lpText + cbText, dwChar);
+			cbText += 1 + TestRandom(nLen - 1);
+			break;
+		case 3:
+			// An encoded surrogate or an overlong form.
+			dwChar = TestRandom(0x800);
+			nLen = EncodeReference(lpText + cbText, 0xD800 + dwChar);
+			if (TestRandom(2) == 0) {
+				lpText[cbText] = 0xC0 | (dwChar & 1);
+				lpText[cbText + 1] = 0x80 | (dwChar & 0x3F);
+				nLen = 2;
+			}
+			cbText += nLen;
+			break;
+		default:
+			// A valid character.
+			do {
+				dwChar = TestRandom((TestRandom(2) == 0) ? 0x800 : 0x110000UL);
+			} while ((dwChar >= 0xD800) && (dwChar <= 0xDFFF));
+			cbText += EncodeReference(lpText + cbText, dwChar);
+			break;
+		}
+	}
+
+	return cbText;
+}
+
+/**
+ * Compares every routine with the reference on random text, and checks that
+ * splitting the text where TranscodeUtf8Tail says gives the same result as
+ * converting it in one go.
+ */
+void CheckRandomText(void) {
+	static unsigned short szExpected[MAX_CASE * 2];
+	static unsigned short szWide[MAX_CASE * 2 + 1];
+	static unsigned char abText[MAX_CASE];
+	static unsigned char abExpected[MAX_CASE * 3];
+	static char szaBack[MAX_CASE * 3 + 1];
+	size_t cchExpected;
+	size_t cbExpected;
+	size_t cbText;
+	size_t cchWide;
+	size_t cbBack;
+	size_t cbCut;
+	long nFailed;
+	int iCase;
+
+	BuildEncodings();
+	TestSeed(10);
+	nFailed = 0L;
+	for (iCase = 0; iCase < NUM_CASES; iCase++) {
+		cbText = MakeRandomText(abText);
+
+		// UTF-8 to UTF-16.
+		cchExpected = DecodeReference(szExpected, abText, cbText);
+		szWide[cchExpected] = GUARD_WIDE;
+		cchWide = TranscodeUtf8ToWide(szWide, (const char*)abText, cbText);
+		if ((TranscodeUtf8Length((const char*)abText, cbText) !=
+				cchExpected) || (cchWide != cchExpected) ||
+				(szWide[cchExpected] != GUARD_WIDE) ||
+				(memcmp(szWide, szExpected,
+						cchWide * sizeof(unsigned short)) != 0)) {
+			nFailed++;
+		}
+
+		// Converting in two blocks gives the same text.
+		cbCut = TestRandom(cbText + 1);
+		cbCut -= TranscodeUtf8Tail((const char*)abText, cbCut);
+		cchWide = TranscodeUtf8ToWide(szWide, (const char*)abText, cbCut);
+		cchWide += TranscodeUtf8ToWide(szWide + cchWide,
+			(const char*)abText + cbCut, cbText - cbCut);
+		if ((cchWide != cchExpected) || (memcmp(szWide, szExpected,
+				cchWide * sizeof(unsigned short)) != 0)) {
+			nFailed++;
+		}
+
+		// UTF-16 to UTF-8, on the decoded text and on random code units.
+		if (TestRandom(2) == 0) {
+			for (cchWide = 0; cchWide < (cbText / 2); cchWide++) {
+				szExpected[cchWide] = (unsigned short)((TestRandom(4) == 0) ?
+					0xD800 + TestRandom(0x800) : TestRandom(0x10000));
+			}
+			cchExpected = cchWide;
+		}
+		cbExpected = EncodeWideReference(abExpected, szExpected,
+										 cchExpected);
+		szaBack[cbExpected] = GUARD_BYTE;
+		cbBack = TranscodeWideToUtf8(szaBack, szExpected, cchExpected);
+		if ((TranscodeWideUtf8Length(szExpected, cchExpected) !=
+				cbExpected) || (cbBack != cbExpected) ||
+				(szaBack[cbExpected] != GUARD_BYTE) ||
+				(memcmp(szaBack, abExpected, cbBack) != 0)) {
+			nFailed++;
+		}
+	}
+
+	printf("%d random cases, %ld disagreements with the reference\n",
+		   NUM_CASES, nFailed);
+	TEST_CHECK(nFailed == 0L);
+	free(lpEncodings);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	CheckKnownCases();
+	CheckAsciiKernels();
+	CheckRandomText();
+
+	return TestFinish(SUITE_NAME);
+}
\ No newline at end of file
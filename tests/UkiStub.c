@@ -0,0 +1,146 @@
+/**
+ * UkiStub.c
+ * A stand-in for the Uki engine that serves whatever pages a test gives it.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "UkiStub.h"
+
+// Global variables.
+const uki_article_t *lpStubArticles = NULL;
+size_t nStubArticles = 0;
+const uki_template_t *lpStubTemplates = NULL;
+size_t nStubTemplates = 0;
+const uki_variable_t *lpStubVariables = NULL;
+size_t nStubVariables = 0;
+const uki_variable_t *lpStubConfigs = NULL;
+size_t nStubConfigs = 0;
+
+/**
+ * Sets the articles the engine serves. They aren't copied, so they must
+ * outlive their use.
+ *
+ * @param lpArticles Articles in the order the engine should list them.
+ * @param nArticles  Number of articles.
+ */
+void UkiStubSetArticles(const uki_article_t *lpArticles, size_t nArticles) {
+	lpStubArticles = lpArticles;
+	nStubArticles = nArticles;
+}
+
+/**
+ * Sets the templates the engine serves. They aren't copied, so they must
+ * outlive their use.
+ *
+ * @param lpTemplates Templates in the order the engine should list them.
+ * @param nTemplates  Number of templates.
+ */
+void UkiStubSetTemplates(const uki_template_t *lpTemplates,
+						 size_t nTemplates) {
+	lpStubTemplates = lpTemplates;
+	nStubTemplates = nTemplates;
+}
+
+/**
+ * Sets the variables the engine serves. They aren't copied, so they must
+ * outlive their use.
+ *
+ * @param lpVariables Variables in the order of the manifest.
+ * @param nVariables  Number of variables.
+ */
+void UkiStubSetVariables(const uki_variable_t *lpVariables,
+						 size_t nVariables) {
+	lpStubVariables = lpVariables;
+	nStubVariables = nVariables;
+}
+
+/**
+ * Sets the configuration keys the engine serves. They aren't copied, so they
+ * must outlive their use.
+ *
+ * @param lpConfigs Configuration keys in the order of the manifest.
+ * @param nConfigs  Number of configuration keys.
+ */
+void UkiStubSetConfigs(const uki_variable_t *lpConfigs, size_t nConfigs) {
+	lpStubConfigs = lpConfigs;
+	nStubConfigs = nConfigs;
+}
+
+/**
+ * Gets an article from the engine.
+ *
+ * @param  index Index of the article.
+ * @return       The article, or one with a NULL name past the end.
+ */
+uki_article_t uki_article(size_t index) {
+	uki_article_t article = { NULL, NULL, NULL, 0 };
+
+	if (index < nStubArticles)
+		article = lpStubArticles[index];
+
+	return article;
+}
+
+/**
+ * Gets the number of articles in the engine.
+ *
+ * @return Number of articles.
+ */
+size_t uki_articles_available(void) {
+	return nStubArticles;
+}
+
+/**
+ * Gets a template from the engine.
+ *
+ * @param  index Index of the template.
+ * @return       The template, or one with a NULL name past the end.
+ */
+uki_template_t uki_template(size_t index) {
+	uki_template_t template = { NULL, NULL, NULL, 0 };
+
+	if (index < nStubTemplates)
+		template = lpStubTemplates[index];
+
+	return template;
+}
+
+/**
+ * Gets the number of templates in the engine.
+ *
+ * @return Number of templates.
+ */
+size_t uki_templates_available(void) {
+	return nStubTemplates;
+}
+
+/**
+ * Gets a variable from the engine.
+ *
+ * @param  index Index of the variable.
+ * @return       The variable, or one with a NULL key past the end.
+ */
+uki_variable_t uki_variable(size_t index) {
+	uki_variable_t variable = { NULL, NULL };
+
+	if (index < nStubVariables)
+		variable = lpStubVariables[index];
+
+	return variable;
+}
+
+/**
+ * Gets a configuration key from the engine.
+ *
+ * @param  index Index of the configuration key.
+ * @return       The configuration key, or one with a NULL key past the end.
+ */
+uki_variable_t uki_config(size_t index) {
+	uki_variable_t config = { NULL, NULL };
+
+	if (index < nStubConfigs)
+		config = lpStubConfigs[index];
+
+	return config;
+}
\ No newline at end of file
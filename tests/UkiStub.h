@@ -0,0 +1,21 @@
+/**
+ * UkiStub.h
+ * A stand-in for the Uki engine that serves whatever pages a test gives it.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _UKISTUB_H
+#define _UKISTUB_H
+
+#include "uki.h"
+
+// Setup.
+void UkiStubSetArticles(const uki_article_t *lpArticles, size_t nArticles);
+void UkiStubSetTemplates(const uki_template_t *lpTemplates,
+						 size_t nTemplates);
+void UkiStubSetVariables(const uki_variable_t *lpVariables,
+						 size_t nVariables);
+void UkiStubSetConfigs(const uki_variable_t *lpConfigs, size_t nConfigs);
+
+#endif  // _UKISTUB_H
\ No newline at end of file
@@ -0,0 +1,1445 @@
+/**
+ * Win32Shim.c
+ * A POSIX implementation of the parts of the Win32 API declared in
+ * win32/windows.h, with a few hooks for the tests. Paths are converted to
+ * UTF-8 with backslashes turned into slashes.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include "Win32Shim.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Definitions.
+#define SHIM_PATH_SIZE   (MAX_PATH * 4)
+#define SHIM_HEADER_SIZE 16
+
+// Seconds between 1601, where FILETIME starts, and 1970.
+#define EPOCH_DIFFERENCE 11644473600LL
+
+// Kinds of handles.
+#define HANDLE_FILE    1
+#define HANDLE_FIND    2
+#define HANDLE_MAPPING 3
+#define HANDLE_THREAD  4
+
+// Everything a handle might point to.
+typedef struct {
+	int iType;
+	int fd;
+	DIR *lpDir;
+	char szaFolder[SHIM_PATH_SIZE];
+	char szaPattern[SHIM_PATH_SIZE];
+	pthread_t thread;
+	LPTHREAD_START_ROUTINE lpStartAddress;
+	LPVOID lpParameter;
+	int fJoined;
+} SHIM_HANDLE;
+
+// A mapped view, which has to remember its size to be unmapped.
+typedef struct SHIM_VIEW {
+	void *lpBase;
+	size_t cbView;
+	struct SHIM_VIEW *lpNext;
+} SHIM_VIEW;
+
+// Global variables.
+DWORD dwLastError = ERROR_SUCCESS;
+long nWritesUntilFailure = -1L;
+size_t cbLive = 0;
+size_t cbPeak = 0;
+long nMessages = 0L;
+BOOL bQuietMessages = FALSE;
+SHIM_VIEW *lpViews = NULL;
+
+// Private methods.
+SHIM_HANDLE* NewHandle(int iType);
+void SetErrorFromErrno(void);
+void StatToFileTime(const struct timespec *lpTime, FILETIME *lpFileTime);
+BOOL FillFindData(SHIM_HANDLE *lpFind, WIN32_FIND_DATA *lpFindFileData);
+size_t WidenUtf8(LPTSTR szOutput, const char *szaInput, size_t cchMax);
+void* ThreadStart(void *lpParam);
+
+/**
+ * Makes the nth write from now on fail, counting from zero.
+ *
+ * @param nWrite Write that should fail, or -1 to stop failing writes.
+ */
+void Win32ShimFailWrite(long nWrite) {
+	nWritesUntilFailure = nWrite;
+}
+
+/**
+ * Starts measuring the peak of local memory from what's allocated right now.
+ */
+void Win32ShimResetPeak(void) {
+	cbPeak = cbLive;
+}
+
+/**
+ * Gets the most local memory that was allocated at once since the last reset.
+ *
+ * @return Peak in bytes.
+ */
+size_t Win32ShimPeakBytes(void) {
+	return cbPeak;
+}
+
+/**
+ * Gets the local memory that's currently allocated.
+ *
+ * @return Allocated memory in bytes.
+ */
+size_t Win32ShimLiveBytes(void) {
+	return cbLive;
+}
+
+/**
+ * Gets the number of message boxes shown so far.
+ *
+ * @return Number of message boxes.
+ */
+long Win32ShimMessageCount(void) {
+	return nMessages;
+}
+
+/**
+ * Stops message boxes from being printed, for tests that expect plenty of
+ * them. They're still counted.
+ *
+ * @param bQuiet Should they be kept quiet?
+ */
+void Win32ShimQuietMessages(BOOL bQuiet) {
+	bQuietMessages = bQuiet;
+}
+
+/**
+ * Converts a path into UTF-8 for the system, with backslashes turned into
+ * slashes.
+ *
+ * @param  szaPath Buffer of SHIM_PATH_SIZE bytes to receive the path.
+ * @param  szPath  Path to be converted.
+ * @return         Length of the converted path in bytes.
+ */
+size_t Win32ShimNarrowPath(char *szaPath, LPCTSTR szPath) {
+	unsigned long ulChar;
+	size_t cb;
+
+	cb = 0;
+	while ((*szPath != 0) && (cb < (SHIM_PATH_SIZE - 5))) {
+		ulChar = *szPath++;
+		if ((ulChar >= 0xD800) && (ulChar < 0xDC00) && (*szPath >= 0xDC00) &&
+				(*szPath < 0xE000)) {
+			ulChar = 0x10000 + ((ulChar - 0xD800) << 10) + (*szPath++ - 0xDC00);
+		}
+
+		if (ulChar == '\\') {
+			szaPath[cb++] = '/';
+		} else if (ulChar < 0x80) {
+			szaPath[cb++] = (char)ulChar;
+		} else if (ulChar < 0x800) {
+			szaPath[cb++] = (char)(0xC0 | (ulChar >> 6));
+			szaPath[cb++] = (char)(0x80 | (ulChar & 0x3F));
+		} else if (ulChar < 0x10000) {
+			szaPath[cb++] = (char)(0xE0 | (ulChar >> 12));
+			szaPath[cb++] = (char)(0x80 | ((ulChar >> 6) & 0x3F));
+			szaPath[cb++] = (char)(0x80 | (ulChar & 0x3F));
+		} else {
+			szaPath[cb++] = (char)(0xF0 | (ulChar >> 18));
+			szaPath[cb++] = (char)(0x80 | ((ulChar >> 12) & 0x3F));
+			szaPath[cb++] = (char)(0x80 | ((ulChar >> 6) & 0x3F));
+			szaPath[cb++] = (char)(0x80 | (ulChar & 0x3F));
+		}
+	}
+	szaPath[cb] = '\0';
+
+	return cb;
+}
+
+/**
+ * Converts a path from the system into UTF-16.
+ *
+ * @param szPath  Buffer of MAX_PATH characters to receive the path.
+ * @param szaPath Path to be converted.
+ */
+void Win32ShimWidenPath(LPTSTR szPath, const char *szaPath) {
+	WidenUtf8(szPath, szaPath, MAX_PATH);
+}
+
+/**
+ * Allocates local memory, keeping track of how much is in use.
+ *
+ * @param  uFlags LMEM_ZEROINIT to clear the memory.
+ * @param  uBytes Size of the block.
+ * @return        The block or NULL if it couldn't be allocated.
+ */
+HLOCAL LocalAlloc(UINT uFlags, size_t uBytes) {
+	unsigned char *lpBlock;
+
+	lpBlock = (unsigned char*)malloc(SHIM_HEADER_SIZE + uBytes);
+	if (lpBlock == NULL)
+		return NULL;
+	if (uFlags & LMEM_ZEROINIT)
+		memset(lpBlock + SHIM_HEADER_SIZE, 0, uBytes);
+
+	// Remember the size in front of the block.
+	*((size_t*)lpBlock) = uBytes;
+	cbLive += uBytes;
+	if (cbLive > cbPeak)
+		cbPeak = cbLive;
+
+	return lpBlock + SHIM_HEADER_SIZE;
+}
+
+/**
+ * Resizes a block of local memory.
+ *
+ * @param  hMem   Block to be resized.
+ * @param  uBytes New size of the block.
+ * @param  uFlags LMEM_ZEROINIT to clear any memory that was added.
+ * @return        The resized block or NULL if it couldn't be resized.
+ */
+HLOCAL LocalReAlloc(HLOCAL hMem, size_t uBytes, UINT uFlags) {
+	HLOCAL hNew;
+	size_t cbOld;
+
+	cbOld = LocalSize(hMem);
+	hNew = LocalAlloc(uFlags, uBytes);
+	if (hNew == NULL)
+		return NULL;
+
+	memcpy(hNew, hMem, (cbOld < uBytes) ? cbOld : uBytes);
+	LocalFree(hMem);
+
+	return hNew;
+}
+
+/**
+ * Frees a block of local memory.
+ *
+ * @param  hMem Block to be freed, which can be NULL.
+ * @return      Always NULL.
+ */
+HLOCAL LocalFree(HLOCAL hMem) {
+	if (hMem == NULL)
+		return NULL;
+
+	cbLive -= LocalSize(hMem);
+	free((unsigned char*)hMem - SHIM_HEADER_SIZE);
+
+	return NULL;
+}
+
+/**
+ * Gets the size of a block of local memory.
+ *
+ * @param  hMem Block of memory.
+ * @return      Size of the block in bytes.
+ */
+size_t LocalSize(HLOCAL hMem) {
+	return *((size_t*)((unsigned char*)hMem - SHIM_HEADER_SIZE));
+}
+
+/**
+ * Creates or opens a file.
+ *
+ * @param  lpFileName            Path to the file.
+ * @param  dwDesiredAccess       GENERIC_READ and/or GENERIC_WRITE.
+ * @param  dwShareMode           Ignored.
+ * @param  lpSecurityAttributes  Ignored.
+ * @param  dwCreationDisposition What to do if the file exists or not.
+ * @param  dwFlagsAndAttributes  Ignored.
+ * @param  hTemplateFile         Ignored.
+ * @return                       Handle to the file or INVALID_HANDLE_VALUE.
+ */
+HANDLE CreateFile(LPCTSTR lpFileName, DWORD dwDesiredAccess,
+				  DWORD dwShareMode, LPVOID lpSecurityAttributes,
+				  DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes,
+				  HANDLE hTemplateFile) {
+	char szaPath[SHIM_PATH_SIZE];
+	SHIM_HANDLE *lpHandle;
+	int iFlags;
+	int fd;
+
+	(void)dwShareMode;
+	(void)lpSecurityAttributes;
+	(void)dwFlagsAndAttributes;
+	(void)hTemplateFile;
+
+	// Translate the access and disposition.
+	if ((dwDesiredAccess & GENERIC_READ) && (dwDesiredAccess & GENERIC_WRITE)) {
+		iFlags = O_RDWR;
+	} else if (dwDesiredAccess & GENERIC_WRITE) {
+		iFlags = O_WRONLY;
+	} else {
+		iFlags = O_RDONLY;
+	}
+	switch (dwCreationDisposition) {
+	case CREATE_NEW:
+		iFlags |= O_CREAT | O_EXCL;
+		break;
+	case CREATE_ALWAYS:
+		iFlags |= O_CREAT | O_TRUNC;
+		break;
+	case OPEN_ALWAYS:
+		iFlags |= O_CREAT;
+		break;
+	}
+
+	Win32ShimNarrowPath(szaPath, lpFileName);
+	fd = open(szaPath, iFlags, 0644);
+	if (fd < 0) {
+		SetErrorFromErrno();
+		return INVALID_HANDLE_VALUE;
+	}
+
+	lpHandle = NewHandle(HANDLE_FILE);
+	lpHandle->fd = fd;
+
+	return lpHandle;
+}
+
+/**
+ * Reads from a file.
+ *
+ * @param  hFile                File handle.
+ * @param  lpBuffer             Buffer to receive the data.
+ * @param  nNumberOfBytesToRead Size of the buffer.
+ * @param  lpNumberOfBytesRead  Number of bytes actually read.
+ * @param  lpOverlapped         Ignored.
+ * @return                      TRUE if the read worked, even at the end.
+ */
+BOOL ReadFile(HANDLE hFile, LPVOID lpBuffer, DWORD nNumberOfBytesToRead,
+			  DWORD *lpNumberOfBytesRead, LPVOID lpOverlapped) {
+	ssize_t nRead;
+
+	(void)lpOverlapped;
+	nRead = read(((SHIM_HANDLE*)hFile)->fd, lpBuffer, nNumberOfBytesToRead);
+	if (nRead < 0) {
+		SetErrorFromErrno();
+		*lpNumberOfBytesRead = 0;
+		return FALSE;
+	}
+
+	*lpNumberOfBytesRead = (DWORD)nRead;
+	return TRUE;
+}
+
+/**
+ * Writes to a file, unless the write was set to fail.
+ *
+ * @param  hFile                  File handle.
+ * @param  lpBuffer               Data to be written.
+ * @param  nNumberOfBytesToWrite  Size of the data.
+ * @param  lpNumberOfBytesWritten Number of bytes actually written.
+ * @param  lpOverlapped           Ignored.
+ * @return                        TRUE if everything was written.
+ */
+BOOL WriteFile(HANDLE hFile, LPCVOID lpBuffer, DWORD nNumberOfBytesToWrite,
+			   DWORD *lpNumberOfBytesWritten, LPVOID lpOverlapped) {
+	ssize_t nWritten;
+
+	(void)lpOverlapped;
+	*lpNumberOfBytesWritten = 0;
+
+	// Fail the write if it's the one that was chosen.
+	if (nWritesUntilFailure >= 0L) {
+		if (nWritesUntilFailure-- == 0L) {
+			dwLastError = ERROR_ACCESS_DENIED;
+			return FALSE;
+		}
+	}
+
+	nWritten = write(((SHIM_HANDLE*)hFile)->fd, lpBuffer,
+		nNumberOfBytesToWrite);
+	if (nWritten < 0) {
+		SetErrorFromErrno();
+		return FALSE;
+	}
+
+	*lpNumberOfBytesWritten = (DWORD)nWritten;
+	return (DWORD)nWritten == nNumberOfBytesToWrite;
+}
+
+/**
+ * Flushes a file to disk.
+ *
+ * @param  hFile File handle.
+ * @return       TRUE if the flush worked.
+ */
+BOOL FlushFileBuffers(HANDLE hFile) {
+	return fsync(((SHIM_HANDLE*)hFile)->fd) == 0;
+}
+
+/**
+ * Gets the size of a file.
+ *
+ * @param  hFile          File handle.
+ * @param  lpFileSizeHigh Optional high part of the size.
+ * @return                Low part of the size or 0xFFFFFFFF on failure.
+ */
+DWORD GetFileSize(HANDLE hFile, DWORD *lpFileSizeHigh) {
+	struct stat st;
+
+	if (fstat(((SHIM_HANDLE*)hFile)->fd, &st) != 0) {
+		SetErrorFromErrno();
+		return 0xFFFFFFFF;
+	}
+
+	if (lpFileSizeHigh != NULL)
+		*lpFileSizeHigh = (DWORD)((unsigned long long)st.st_size >> 32);
+	return (DWORD)st.st_size;
+}
+
+/**
+ * Moves the position of a file.
+ *
+ * @param  hFile                File handle.
+ * @param  lDistanceToMove      Distance to move.
+ * @param  lpDistanceToMoveHigh Ignored, files here are small.
+ * @param  dwMoveMethod         FILE_BEGIN, FILE_CURRENT or FILE_END.
+ * @return                      New position or 0xFFFFFFFF on failure.
+ */
+DWORD SetFilePointer(HANDLE hFile, LONG lDistanceToMove,
+					 LONG *lpDistanceToMoveHigh, DWORD dwMoveMethod) {
+	off_t nPos;
+	int iWhence;
+
+	(void)lpDistanceToMoveHigh;
+	iWhence = (dwMoveMethod == FILE_END) ? SEEK_END :
+		((dwMoveMethod == FILE_CURRENT) ? SEEK_CUR : SEEK_SET);
+	nPos = lseek(((SHIM_HANDLE*)hFile)->fd, lDistanceToMove, iWhence);
+	if (nPos < 0) {
+		SetErrorFromErrno();
+		return 0xFFFFFFFF;
+	}
+
+	return (DWORD)nPos;
+}
+
+/**
+ * Closes a file, folder search or mapping handle.
+ *
+ * @param  hObject Handle to be closed.
+ * @return         TRUE if the handle was closed.
+ */
+BOOL CloseHandle(HANDLE hObject) {
+	SHIM_HANDLE *lpHandle = (SHIM_HANDLE*)hObject;
+
+	if ((hObject == NULL) || (hObject == INVALID_HANDLE_VALUE))
+		return FALSE;
+
+	// Threads that weren't waited for carry on by themselves.
+	if ((lpHandle->iType == HANDLE_THREAD) && !lpHandle->fJoined)
+		pthread_detach(lpHandle->thread);
+	if (lpHandle->lpDir != NULL)
+		closedir(lpHandle->lpDir);
+	if (lpHandle->fd >= 0)
+		close(lpHandle->fd);
+	free(lpHandle);
+
+	return TRUE;
+}
+
+/**
+ * Deletes a file.
+ *
+ * @param  lpFileName Path to the file.
+ * @return            TRUE if the file was deleted.
+ */
+BOOL DeleteFile(LPCTSTR lpFileName) {
+	char szaPath[SHIM_PATH_SIZE];
+
+	Win32ShimNarrowPath(szaPath, lpFileName);
+	if (unlink(szaPath) != 0) {
+		SetErrorFromErrno();
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Copies a file.
+ *
+ * @param  lpExistingFileName File to be copied.
+ * @param  lpNewFileName      Where to copy it to.
+ * @param  bFailIfExists      Should it fail if the destination exists?
+ * @return                    TRUE if the file was copied.
+ */
+BOOL CopyFile(LPCTSTR lpExistingFileName, LPCTSTR lpNewFileName,
+			  BOOL bFailIfExists) {
+	char szaFrom[SHIM_PATH_SIZE];
+	char szaTo[SHIM_PATH_SIZE];
+	char abBuffer[8192];
+	ssize_t cbRead;
+	int fdFrom;
+	int fdTo;
+	BOOL bSuccess;
+
+	// Open both ends.
+	Win32ShimNarrowPath(szaFrom, lpExistingFileName);
+	Win32ShimNarrowPath(szaTo, lpNewFileName);
+	fdFrom = open(szaFrom, O_RDONLY);
+	if (fdFrom < 0) {
+		SetErrorFromErrno();
+		return FALSE;
+	}
+	fdTo = open(szaTo, O_WRONLY | O_CREAT |
+		((bFailIfExists) ? O_EXCL : O_TRUNC), 0644);
+	if (fdTo < 0) {
+		SetErrorFromErrno();
+		close(fdFrom);
+		return FALSE;
+	}
+
+	// Copy everything over.
+	bSuccess = TRUE;
+	while ((cbRead = read(fdFrom, abBuffer, sizeof(abBuffer))) > 0) {
+		if (write(fdTo, abBuffer, (size_t)cbRead) != cbRead) {
+			bSuccess = FALSE;
+			break;
+		}
+	}
+	if (cbRead < 0)
+		bSuccess = FALSE;
+	if (!bSuccess)
+		SetErrorFromErrno();
+
+	close(fdFrom);
+	close(fdTo);
+	return bSuccess;
+}
+
+/**
+ * Moves a file, failing if the destination already exists.
+ *
+ * @param  lpExistingFileName File to be moved.
+ * @param  lpNewFileName      Where to move it to.
+ * @return                    TRUE if the file was moved.
+ */
+BOOL MoveFile(LPCTSTR lpExistingFileName, LPCTSTR lpNewFileName) {
+	return MoveFileEx(lpExistingFileName, lpNewFileName, 0);
+}
+
+/**
+ * Moves a file.
+ *
+ * @param  lpExistingFileName File to be moved.
+ * @param  lpNewFileName      Where to move it to.
+ * @param  dwFlags            MOVEFILE_REPLACE_EXISTING to replace the
+ *                            destination.
+ * @return                    TRUE if the file was moved.
+ */
+BOOL MoveFileEx(LPCTSTR lpExistingFileName, LPCTSTR lpNewFileName,
+				DWORD dwFlags) {
+	char szaFrom[SHIM_PATH_SIZE];
+	char szaTo[SHIM_PATH_SIZE];
+
+	Win32ShimNarrowPath(szaFrom, lpExistingFileName);
+	Win32ShimNarrowPath(szaTo, lpNewFileName);
+	if (!(dwFlags & MOVEFILE_REPLACE_EXISTING) && (access(szaTo, F_OK) == 0)) {
+		dwLastError = ERROR_ALREADY_EXISTS;
+		return FALSE;
+	}
+
+	if (rename(szaFrom, szaTo) != 0) {
+		SetErrorFromErrno();
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Gets the attributes of a file.
+ *
+ * @param  lpFileName Path to the file.
+ * @return            Attributes or INVALID_FILE_ATTRIBUTES if it's missing.
+ */
+DWORD GetFileAttributes(LPCTSTR lpFileName) {
+	WIN32_FILE_ATTRIBUTE_DATA wfad;
+
+	if (!GetFileAttributesEx(lpFileName, GetFileExInfoStandard, &wfad))
+		return INVALID_FILE_ATTRIBUTES;
+
+	return wfad.dwFileAttributes;
+}
+
+/**
+ * Gets the attributes, times and size of a file.
+ *
+ * @param  lpFileName        Path to the file.
+ * @param  fInfoLevelId      Must be GetFileExInfoStandard.
+ * @param  lpFileInformation WIN32_FILE_ATTRIBUTE_DATA to be populated.
+ * @return                   TRUE if the file exists.
+ */
+BOOL GetFileAttributesEx(LPCTSTR lpFileName, int fInfoLevelId,
+						 LPVOID lpFileInformation) {
+	WIN32_FILE_ATTRIBUTE_DATA *lpData;
+	char szaPath[SHIM_PATH_SIZE];
+	struct stat st;
+
+	(void)fInfoLevelId;
+	Win32ShimNarrowPath(szaPath, lpFileName);
+	if (stat(szaPath, &st) != 0) {
+		SetErrorFromErrno();
+		return FALSE;
+	}
+
+	lpData = (WIN32_FILE_ATTRIBUTE_DATA*)lpFileInformation;
+	lpData->dwFileAttributes = S_ISDIR(st.st_mode) ?
+		FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+	StatToFileTime(&st.st_ctim, &lpData->ftCreationTime);
+	StatToFileTime(&st.st_atim, &lpData->ftLastAccessTime);
+	StatToFileTime(&st.st_mtim, &lpData->ftLastWriteTime);
+	lpData->nFileSizeHigh = (DWORD)((unsigned long long)st.st_size >> 32);
+	lpData->nFileSizeLow = (DWORD)st.st_size;
+
+	return TRUE;
+}
+
+/**
+ * Compares two file times.
+ *
+ * @param  lpFileTime1 First time.
+ * @param  lpFileTime2 Second time.
+ * @return             -1, 0 or 1 if the first one is earlier, equal or later.
+ */
+LONG CompareFileTime(const FILETIME *lpFileTime1,
+					 const FILETIME *lpFileTime2) {
+	if (lpFileTime1->dwHighDateTime != lpFileTime2->dwHighDateTime)
+		return (lpFileTime1->dwHighDateTime < lpFileTime2->dwHighDateTime) ?
+			-1 : 1;
+	if (lpFileTime1->dwLowDateTime != lpFileTime2->dwLowDateTime)
+		return (lpFileTime1->dwLowDateTime < lpFileTime2->dwLowDateTime) ?
+			-1 : 1;
+
+	return 0;
+}
+
+/**
+ * Gets the error of the last call that failed.
+ *
+ * @return Error code.
+ */
+DWORD GetLastError(void) {
+	return dwLastError;
+}
+
+/**
+ * Starts listing a folder. Only wildcards in the last component are
+ * supported.
+ *
+ * @param  lpFileName     Folder and pattern, such as C:\Folder\*.
+ * @param  lpFindFileData First file found.
+ * @return                Search handle or INVALID_HANDLE_VALUE.
+ */
+HANDLE FindFirstFile(LPCTSTR lpFileName, WIN32_FIND_DATA *lpFindFileData) {
+	char szaPath[SHIM_PATH_SIZE];
+	SHIM_HANDLE *lpFind;
+	char *lpSlash;
+
+	// Split the folder from the pattern.
+	Win32ShimNarrowPath(szaPath, lpFileName);
+	lpFind = NewHandle(HANDLE_FIND);
+	lpSlash = strrchr(szaPath, '/');
+	if (lpSlash == NULL) {
+		strcpy(lpFind->szaFolder, ".");
+		strcpy(lpFind->szaPattern, szaPath);
+	} else {
+		*lpSlash = '\0';
+		strcpy(lpFind->szaFolder, (lpSlash == szaPath) ? "/" : szaPath);
+		strcpy(lpFind->szaPattern, lpSlash + 1);
+	}
+
+	lpFind->lpDir = opendir(lpFind->szaFolder);
+	if (lpFind->lpDir == NULL) {
+		SetErrorFromErrno();
+		CloseHandle(lpFind);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	if (!FillFindData(lpFind, lpFindFileData)) {
+		CloseHandle(lpFind);
+		dwLastError = ERROR_FILE_NOT_FOUND;
+		return INVALID_HANDLE_VALUE;
+	}
+
+	return lpFind;
+}
+
+/**
+ * Gets the next file of a folder listing.
+ *
+ * @param  hFindFile      Search handle.
+ * @param  lpFindFileData Next file found.
+ * @return                TRUE if there was another file.
+ */
+BOOL FindNextFile(HANDLE hFindFile, WIN32_FIND_DATA *lpFindFileData) {
+	return FillFindData((SHIM_HANDLE*)hFindFile, lpFindFileData);
+}
+
+/**
+ * Ends a folder listing.
+ *
+ * @param  hFindFile Search handle.
+ * @return           TRUE if the handle was closed.
+ */
+BOOL FindClose(HANDLE hFindFile) {
+	return CloseHandle(hFindFile);
+}
+
+/**
+ * Opens a file to be mapped, which Windows CE requires instead of CreateFile.
+ *
+ * @param  lpFileName            Path to the file.
+ * @param  dwDesiredAccess       GENERIC_READ and/or GENERIC_WRITE.
+ * @param  dwShareMode           Ignored.
+ * @param  lpSecurityAttributes  Ignored.
+ * @param  dwCreationDisposition What to do if the file exists or not.
+ * @param  dwFlagsAndAttributes  Ignored.
+ * @param  hTemplateFile         Ignored.
+ * @return                       Handle to the file or INVALID_HANDLE_VALUE.
+ */
+HANDLE CreateFileForMapping(LPCTSTR lpFileName, DWORD dwDesiredAccess,
+							DWORD dwShareMode, LPVOID lpSecurityAttributes,
+							DWORD dwCreationDisposition,
+							DWORD dwFlagsAndAttributes, HANDLE hTemplateFile) {
+	return CreateFile(lpFileName, dwDesiredAccess, dwShareMode,
+		lpSecurityAttributes, dwCreationDisposition, dwFlagsAndAttributes,
+		hTemplateFile);
+}
+
+/**
+ * Creates a read-only mapping of a whole file. Like on Windows, empty files
+ * can't be mapped.
+ *
+ * @param  hFile             File handle.
+ * @param  lpAttributes      Ignored.
+ * @param  flProtect         Must be PAGE_READONLY.
+ * @param  dwMaximumSizeHigh Ignored, the whole file is mapped.
+ * @param  dwMaximumSizeLow  Ignored, the whole file is mapped.
+ * @param  lpName            Ignored.
+ * @return                   Mapping handle or NULL on failure.
+ */
+HANDLE CreateFileMapping(HANDLE hFile, LPVOID lpAttributes, DWORD flProtect,
+						 DWORD dwMaximumSizeHigh, DWORD dwMaximumSizeLow,
+						 LPCTSTR lpName) {
+	SHIM_HANDLE *lpMapping;
+	struct stat st;
+
+	(void)lpAttributes;
+	(void)flProtect;
+	(void)dwMaximumSizeHigh;
+	(void)dwMaximumSizeLow;
+	(void)lpName;
+
+	if ((fstat(((SHIM_HANDLE*)hFile)->fd, &st) != 0) || (st.st_size == 0)) {
+		dwLastError = ERROR_ACCESS_DENIED;
+		return NULL;
+	}
+
+	// Keep a descriptor of our own, the file handle may be closed first.
+	lpMapping = NewHandle(HANDLE_MAPPING);
+	lpMapping->fd = dup(((SHIM_HANDLE*)hFile)->fd);
+
+	return lpMapping;
+}
+
+/**
+ * Maps a view of a whole file.
+ *
+ * @param  hFileMappingObject   Mapping handle.
+ * @param  dwDesiredAccess      Must be FILE_MAP_READ.
+ * @param  dwFileOffsetHigh     Ignored, the whole file is mapped.
+ * @param  dwFileOffsetLow      Ignored, the whole file is mapped.
+ * @param  dwNumberOfBytesToMap Ignored, the whole file is mapped.
+ * @return                      Base of the view or NULL on failure.
+ */
+LPVOID MapViewOfFile(HANDLE hFileMappingObject, DWORD dwDesiredAccess,
+					 DWORD dwFileOffsetHigh, DWORD dwFileOffsetLow,
+					 size_t dwNumberOfBytesToMap) {
+	SHIM_HANDLE *lpMapping = (SHIM_HANDLE*)hFileMappingObject;
+	SHIM_VIEW *lpView;
+	struct stat st;
+	void *lpBase;
+
+	(void)dwDesiredAccess;
+	(void)dwFileOffsetHigh;
+	(void)dwFileOffsetLow;
+	(void)dwNumberOfBytesToMap;
+
+	if (fstat(lpMapping->fd, &st) != 0) {
+		SetErrorFromErrno();
+		return NULL;
+	}
+	lpBase = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+		lpMapping->fd, 0);
+	if (lpBase == MAP_FAILED) {
+		SetErrorFromErrno();
+		return NULL;
+	}
+
+	// Remember the size for when it's unmapped.
+	lpView = (SHIM_VIEW*)malloc(sizeof(SHIM_VIEW));
+	lpView->lpBase = lpBase;
+	lpView->cbView = (size_t)st.st_size;
+	lpView->lpNext = lpViews;
+	lpViews = lpView;
+
+	return lpBase;
+}
+
+/**
+ * Unmaps a view of a file.
+ *
+ * @param  lpBaseAddress Base of the view.
+ * @return               TRUE if the view was unmapped.
+ */
+BOOL UnmapViewOfFile(LPCVOID lpBaseAddress) {
+	SHIM_VIEW **lppView;
+	SHIM_VIEW *lpView;
+
+	for (lppView = &lpViews; *lppView != NULL;
+			lppView = &(*lppView)->lpNext) {
+		lpView = *lppView;
+		if (lpView->lpBase == lpBaseAddress) {
+			munmap(lpView->lpBase, lpView->cbView);
+			*lppView = lpView->lpNext;
+			free(lpView);
+
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Starts a thread.
+ *
+ * @param  lpThreadAttributes Ignored.
+ * @param  dwStackSize        Ignored.
+ * @param  lpStartAddress     Function the thread runs.
+ * @param  lpParameter        Parameter passed to the function.
+ * @param  dwCreationFlags    Ignored.
+ * @param  lpThreadId         Ignored, but set to zero.
+ * @return                    Handle to the thread or NULL if it couldn't be
+ *                            started.
+ */
+HANDLE CreateThread(LPVOID lpThreadAttributes, size_t dwStackSize,
+					LPTHREAD_START_ROUTINE lpStartAddress, LPVOID lpParameter,
+					DWORD dwCreationFlags, DWORD *lpThreadId) {
+	SHIM_HANDLE *lpThread;
+
+	(void)lpThreadAttributes;
+	(void)dwStackSize;
+	(void)dwCreationFlags;
+	if (lpThreadId != NULL)
+		*lpThreadId = 0;
+
+	lpThread = NewHandle(HANDLE_THREAD);
+	lpThread->lpStartAddress = lpStartAddress;
+	lpThread->lpParameter = lpParameter;
+	if (pthread_create(&lpThread->thread, NULL, ThreadStart, lpThread) != 0) {
+		free(lpThread);
+		return NULL;
+	}
+
+	return lpThread;
+}
+
+/**
+ * Waits for threads to finish. Only waiting for all of them forever is
+ * supported.
+ *
+ * @param  nCount         Number of handles.
+ * @param  lpHandles      Handles to the threads.
+ * @param  bWaitAll       Ignored, always waits for all of them.
+ * @param  dwMilliseconds Ignored, always waits forever.
+ * @return                WAIT_OBJECT_0, or WAIT_FAILED if one of the handles
+ *                        isn't a thread.
+ */
+DWORD WaitForMultipleObjects(DWORD nCount, const HANDLE *lpHandles,
+							 BOOL bWaitAll, DWORD dwMilliseconds) {
+	SHIM_HANDLE *lpThread;
+	DWORD i;
+
+	(void)bWaitAll;
+	(void)dwMilliseconds;
+	for (i = 0; i < nCount; i++) {
+		lpThread = (SHIM_HANDLE*)lpHandles[i];
+		if (lpThread->iType != HANDLE_THREAD)
+			return WAIT_FAILED;
+
+		if (!lpThread->fJoined) {
+			pthread_join(lpThread->thread, NULL);
+			lpThread->fJoined = 1;
+		}
+	}
+
+	return WAIT_OBJECT_0;
+}
+
+/**
+ * Increments a value atomically.
+ *
+ * @param  lpAddend Value to be incremented.
+ * @return          Incremented value.
+ */
+LONG InterlockedIncrement(LONG *lpAddend) {
+	return __sync_add_and_fetch(lpAddend, 1);
+}
+
+/**
+ * Sets up a critical section as a recursive mutex, like on Windows.
+ *
+ * @param lpCriticalSection Critical section to be set up.
+ */
+void InitializeCriticalSection(CRITICAL_SECTION *lpCriticalSection) {
+	pthread_mutexattr_t attr;
+	pthread_mutex_t *lpMutex;
+
+	lpMutex = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(lpMutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	lpCriticalSection->lpMutex = lpMutex;
+}
+
+/**
+ * Frees a critical section that nobody holds.
+ *
+ * @param lpCriticalSection Critical section to be freed.
+ */
+void DeleteCriticalSection(CRITICAL_SECTION *lpCriticalSection) {
+	pthread_mutex_destroy((pthread_mutex_t*)lpCriticalSection->lpMutex);
+	free(lpCriticalSection->lpMutex);
+	lpCriticalSection->lpMutex = NULL;
+}
+
+/**
+ * Waits for and takes a critical section.
+ *
+ * @param lpCriticalSection Critical section to be taken.
+ */
+void EnterCriticalSection(CRITICAL_SECTION *lpCriticalSection) {
+	pthread_mutex_lock((pthread_mutex_t*)lpCriticalSection->lpMutex);
+}
+
+/**
+ * Lets go of a critical section.
+ *
+ * @param lpCriticalSection Critical section to be released.
+ */
+void LeaveCriticalSection(CRITICAL_SECTION *lpCriticalSection) {
+	pthread_mutex_unlock((pthread_mutex_t*)lpCriticalSection->lpMutex);
+}
+
+/**
+ * Gets information about the system.
+ *
+ * @param lpSystemInfo Information to be populated.
+ */
+void GetSystemInfo(SYSTEM_INFO *lpSystemInfo) {
+	long nProcessors;
+
+	nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	lpSystemInfo->dwPageSize = (DWORD)sysconf(_SC_PAGESIZE);
+	lpSystemInfo->dwNumberOfProcessors = (nProcessors > 0) ?
+		(DWORD)nProcessors : 1;
+}
+
+/**
+ * Converts text into UTF-16. CP_UTF8 is decoded as UTF-8 and every other code
+ * page as Latin-1.
+ *
+ * @param  CodePage        Code page of the text.
+ * @param  dwFlags         Ignored.
+ * @param  lpMultiByteStr  Text to be converted.
+ * @param  cbMultiByte     Length of the text, or -1 if it's NUL terminated.
+ * @param  lpWideCharStr   Buffer to receive the text.
+ * @param  cchWideChar     Size of the buffer, or 0 to just measure.
+ * @return                 Number of characters converted or 0 on failure.
+ */
+int MultiByteToWideChar(UINT CodePage, DWORD dwFlags, LPCSTR lpMultiByteStr,
+						int cbMultiByte, LPWSTR lpWideCharStr,
+						int cchWideChar) {
+	const unsigned char *lpIn = (const unsigned char*)lpMultiByteStr;
+	unsigned long ulChar;
+	int cbExtra;
+	int iIn;
+	int cch;
+
+	(void)dwFlags;
+	if (cbMultiByte < 0)
+		cbMultiByte = (int)strlen(lpMultiByteStr) + 1;
+
+	cch = 0;
+	iIn = 0;
+	while (iIn < cbMultiByte) {
+		ulChar = lpIn[iIn++];
+
+		// Decode a UTF-8 sequence, replacing anything broken.
+		if ((CodePage == CP_UTF8) && (ulChar >= 0x80)) {
+			cbExtra = (ulChar >= 0xF0) ? 3 : ((ulChar >= 0xE0) ? 2 :
+				((ulChar >= 0xC0) ? 1 : -1));
+			if ((cbExtra < 0) || ((iIn + cbExtra) > cbMultiByte)) {
+				ulChar = 0xFFFD;
+			} else {
+				ulChar &= 0x3F >> cbExtra;
+				while (cbExtra-- > 0)
+					ulChar = (ulChar << 6) | (lpIn[iIn++] & 0x3F);
+			}
+		}
+
+		// Store it, as a surrogate pair if needed.
+		if (ulChar >= 0x10000) {
+			if (cchWideChar > 0) {
+				if ((cch + 2) > cchWideChar)
+					return 0;
+				lpWideCharStr[cch] = (WCHAR)(0xD800 +
+					((ulChar - 0x10000) >> 10));
+				lpWideCharStr[cch + 1] = (WCHAR)(0xDC00 + (ulChar & 0x3FF));
+			}
+			cch += 2;
+		} else {
+			if (cchWideChar > 0) {
+				if (cch >= cchWideChar)
+					return 0;
+				lpWideCharStr[cch] = (WCHAR)ulChar;
+			}
+			cch++;
+		}
+	}
+
+	return cch;
+}
+
+/**
+ * Converts UTF-16 text into a code page. CP_UTF8 is encoded as UTF-8 and every
+ * other code page as Latin-1, with a question mark for what doesn't fit.
+ *
+ * @param  CodePage          Code page to convert into.
+ * @param  dwFlags           Ignored.
+ * @param  lpWideCharStr     Text to be converted.
+ * @param  cchWideChar       Length of the text, or -1 if it's NUL terminated.
+ * @param  lpMultiByteStr    Buffer to receive the text.
+ * @param  cbMultiByte       Size of the buffer, or 0 to just measure.
+ * @param  lpDefaultChar     Ignored.
+ * @param  lpUsedDefaultChar Set if a character didn't fit the code page.
+ * @return                   Number of bytes converted or 0 on failure.
+ */
+int WideCharToMultiByte(UINT CodePage, DWORD dwFlags, LPCWSTR lpWideCharStr,
+						int cchWideChar, LPSTR lpMultiByteStr,
+						int cbMultiByte, LPCSTR lpDefaultChar,
+						BOOL *lpUsedDefaultChar) {
+	unsigned char aBytes[4];
+	unsigned long ulChar;
+	int nBytes;
+	int iIn;
+	int cb;
+
+	(void)dwFlags;
+	(void)lpDefaultChar;
+	if (lpUsedDefaultChar != NULL)
+		*lpUsedDefaultChar = FALSE;
+	if (cchWideChar < 0)
+		cchWideChar = (int)wcslen(lpWideCharStr) + 1;
+
+	cb = 0;
+	for (iIn = 0; iIn < cchWideChar; iIn++) {
+		ulChar = lpWideCharStr[iIn];
+		if ((ulChar >= 0xD800) && (ulChar < 0xDC00) &&
+				((iIn + 1) < cchWideChar) &&
+				(lpWideCharStr[iIn + 1] >= 0xDC00) &&
+				(lpWideCharStr[iIn + 1] < 0xE000)) {
+			ulChar = 0x10000 + ((ulChar - 0xD800) << 10) +
+				(lpWideCharStr[++iIn] - 0xDC00);
+		}
+
+		// Encode the character.
+		if (CodePage != CP_UTF8) {
+			if (ulChar > 0xFF) {
+				ulChar = '?';
+				if (lpUsedDefaultChar != NULL)
+					*lpUsedDefaultChar = TRUE;
+			}
+			aBytes[0] = (unsigned char)ulChar;
+			nBytes = 1;
+		} else if (ulChar < 0x80) {
+			aBytes[0] = (unsigned char)ulChar;
+			nBytes = 1;
+		} else if (ulChar < 0x800) {
+			aBytes[0] = (unsigned char)(0xC0 | (ulChar >> 6));
+			aBytes[1] = (unsigned char)(0x80 | (ulChar & 0x3F));
+			nBytes = 2;
+		} else if (ulChar < 0x10000) {
+			aBytes[0] = (unsigned char)(0xE0 | (ulChar >> 12));
+			aBytes[1] = (unsigned char)(0x80 | ((ulChar >> 6) & 0x3F));
+			aBytes[2] = (unsigned char)(0x80 | (ulChar & 0x3F));
+			nBytes = 3;
+		} else {
+			aBytes[0] = (unsigned char)(0xF0 | (ulChar >> 18));
+			aBytes[1] = (unsigned char)(0x80 | ((ulChar >> 12) & 0x3F));
+			aBytes[2] = (unsigned char)(0x80 | ((ulChar >> 6) & 0x3F));
+			aBytes[3] = (unsigned char)(0x80 | (ulChar & 0x3F));
+			nBytes = 4;
+		}
+
+		// Store it.
+		if (cbMultiByte > 0) {
+			if ((cb + nBytes) > cbMultiByte)
+				return 0;
+			memcpy(lpMultiByteStr + cb, aBytes, nBytes);
+		}
+		cb += nBytes;
+	}
+
+	return cb;
+}
+
+/**
+ * Checks if a byte starts a double-byte character. None of the code pages
+ * here have them.
+ *
+ * @param  TestChar Byte to be checked.
+ * @return          Always FALSE.
+ */
+BOOL IsDBCSLeadByte(BYTE TestChar) {
+	(void)TestChar;
+	return FALSE;
+}
+
+/**
+ * Formats a string. Only %s, %c, %d, %u, %ld, %lu and %% are supported.
+ *
+ * @param  lpOut Buffer to receive the string.
+ * @param  lpFmt Format of the string.
+ * @param  ...   Values to be formatted.
+ * @return       Number of characters written.
+ */
+int wsprintf(LPTSTR lpOut, LPCTSTR lpFmt, ...) {
+	char szaNumber[32];
+	LPCTSTR szValue;
+	va_list args;
+	int fLong;
+	int cch;
+	int i;
+
+	va_start(args, lpFmt);
+	cch = 0;
+	while (*lpFmt != 0) {
+		if (*lpFmt != '%') {
+			lpOut[cch++] = *lpFmt++;
+			continue;
+		}
+
+		lpFmt++;
+		fLong = (*lpFmt == 'l');
+		if (fLong)
+			lpFmt++;
+
+		szaNumber[0] = '\0';
+		switch (*lpFmt++) {
+		case 's':
+			for (szValue = va_arg(args, LPCTSTR); *szValue != 0; szValue++)
+				lpOut[cch++] = *szValue;
+			break;
+		case 'c':
+			lpOut[cch++] = (WCHAR)va_arg(args, int);
+			break;
+		case 'd':
+			if (fLong) {
+				sprintf(szaNumber, "%ld", va_arg(args, long));
+			} else {
+				sprintf(szaNumber, "%d", va_arg(args, int));
+			}
+			break;
+		case 'u':
+			if (fLong) {
+				sprintf(szaNumber, "%lu", va_arg(args, unsigned long));
+			} else {
+				sprintf(szaNumber, "%u", va_arg(args, unsigned int));
+			}
+			break;
+		default:
+			lpOut[cch++] = '%';
+			break;
+		}
+
+		for (i = 0; szaNumber[i] != '\0'; i++)
+			lpOut[cch++] = szaNumber[i];
+	}
+	lpOut[cch] = 0;
+	va_end(args);
+
+	return cch;
+}
+
+/**
+ * Compares two strings ignoring the case of ASCII letters.
+ *
+ * @param  string1 First string.
+ * @param  string2 Second string.
+ * @return         Negative, zero or positive like wcscmp.
+ */
+int _wcsicmp(const wchar_t *string1, const wchar_t *string2) {
+	wchar_t c1;
+	wchar_t c2;
+
+	do {
+		c1 = *string1++;
+		c2 = *string2++;
+		if ((c1 >= 'A') && (c1 <= 'Z'))
+			c1 += 'a' - 'A';
+		if ((c2 >= 'A') && (c2 <= 'Z'))
+			c2 += 'a' - 'A';
+	} while ((c1 == c2) && (c1 != 0));
+
+	return (int)c1 - (int)c2;
+}
+
+/**
+ * Gets the length of a UTF-16 string. The C library's version expects wide
+ * characters of its own size.
+ *
+ * @param  s String.
+ * @return   Length in characters.
+ */
+size_t wcslen(const wchar_t *s) {
+	size_t n;
+
+	for (n = 0; s[n] != 0; n++)
+		;
+
+	return n;
+}
+
+/**
+ * Copies a UTF-16 string.
+ *
+ * @param  dest Buffer to receive the string.
+ * @param  src  String to be copied.
+ * @return      The buffer.
+ */
+wchar_t *wcscpy(wchar_t *dest, const wchar_t *src) {
+	memcpy(dest, src, (wcslen(src) + 1) * sizeof(wchar_t));
+	return dest;
+}
+
+/**
+ * Appends a UTF-16 string to another.
+ *
+ * @param  dest String to be appended to.
+ * @param  src  String to append.
+ * @return      The string that was appended to.
+ */
+wchar_t *wcscat(wchar_t *dest, const wchar_t *src) {
+	wcscpy(dest + wcslen(dest), src);
+	return dest;
+}
+
+/**
+ * Compares two UTF-16 strings.
+ *
+ * @param  s1 First string.
+ * @param  s2 Second string.
+ * @return    Negative, zero or positive like strcmp.
+ */
+int wcscmp(const wchar_t *s1, const wchar_t *s2) {
+	while ((*s1 == *s2) && (*s1 != 0)) {
+		s1++;
+		s2++;
+	}
+
+	return (int)*s1 - (int)*s2;
+}
+
+/**
+ * Finds the first occurrence of a character in a UTF-16 string.
+ *
+ * @param  wcs String to search in.
+ * @param  wc  Character to look for.
+ * @return     Pointer to the character or NULL if it isn't there.
+ */
+wchar_t *wcschr(const wchar_t *wcs, wchar_t wc) {
+	do {
+		if (*wcs == wc)
+			return (wchar_t*)wcs;
+	} while (*wcs++ != 0);
+
+	return NULL;
+}
+
+/**
+ * Finds the last occurrence of a character in a UTF-16 string.
+ *
+ * @param  wcs String to search in.
+ * @param  wc  Character to look for.
+ * @return     Pointer to the character or NULL if it isn't there.
+ */
+wchar_t *wcsrchr(const wchar_t *wcs, wchar_t wc) {
+	const wchar_t *lpLast = NULL;
+
+	do {
+		if (*wcs == wc)
+			lpLast = wcs;
+	} while (*wcs++ != 0);
+
+	return (wchar_t*)lpLast;
+}
+
+/**
+ * Shows a message box, which here only prints its text.
+ *
+ * @param  hWnd      Ignored.
+ * @param  lpText    Message.
+ * @param  lpCaption Title of the message.
+ * @param  uType     Ignored.
+ * @return           IDYES, so that questions are always accepted.
+ */
+int MessageBox(HWND hWnd, LPCTSTR lpText, LPCTSTR lpCaption, UINT uType) {
+	char szaCaption[SHIM_PATH_SIZE];
+	char szaText[SHIM_PATH_SIZE];
+
+	(void)hWnd;
+	(void)uType;
+	Win32ShimNarrowPath(szaCaption, lpCaption);
+	Win32ShimNarrowPath(szaText, lpText);
+	if (!bQuietMessages)
+		fprintf(stderr, "[%s] %s\n", szaCaption, szaText);
+	nMessages++;
+
+	return IDYES;
+}
+
+/**
+ * Prints a debug message, which nobody is listening to here.
+ *
+ * @param lpOutputString Message.
+ */
+void OutputDebugString(LPCTSTR lpOutputString) {
+	(void)lpOutputString;
+}
+
+/**
+ * Allocates a handle.
+ *
+ * @param  iType Kind of handle.
+ * @return       The handle, with nothing open yet.
+ */
+SHIM_HANDLE* NewHandle(int iType) {
+	SHIM_HANDLE *lpHandle;
+
+	lpHandle = (SHIM_HANDLE*)calloc(1, sizeof(SHIM_HANDLE));
+	lpHandle->iType = iType;
+	lpHandle->fd = -1;
+
+	return lpHandle;
+}
+
+/**
+ * Sets the last error from what the system reported.
+ */
+void SetErrorFromErrno(void) {
+	dwLastError = (errno == ENOENT) ? ERROR_FILE_NOT_FOUND :
+		((errno == EEXIST) ? ERROR_ALREADY_EXISTS : ERROR_ACCESS_DENIED);
+}
+
+/**
+ * Converts a system time into a file time.
+ *
+ * @param lpTime     System time.
+ * @param lpFileTime File time, in 100 nanosecond steps since 1601.
+ */
+void StatToFileTime(const struct timespec *lpTime, FILETIME *lpFileTime) {
+	unsigned long long ullTime;
+
+	ullTime = ((unsigned long long)(lpTime->tv_sec + EPOCH_DIFFERENCE) *
+		10000000ULL) + ((unsigned long long)lpTime->tv_nsec / 100ULL);
+	lpFileTime->dwLowDateTime = (DWORD)ullTime;
+	lpFileTime->dwHighDateTime = (DWORD)(ullTime >> 32);
+}
+
+/**
+ * Fills the find data with the next entry of a folder that matches.
+ *
+ * @param  lpFind         Search handle.
+ * @param  lpFindFileData Find data to be populated.
+ * @return                TRUE if there was another entry.
+ */
+BOOL FillFindData(SHIM_HANDLE *lpFind, WIN32_FIND_DATA *lpFindFileData) {
+	WIN32_FILE_ATTRIBUTE_DATA wfad;
+	char szaPath[SHIM_PATH_SIZE * 2];
+	WCHAR szPath[MAX_PATH * 2];
+	struct dirent *lpEntry;
+
+	while ((lpEntry = readdir(lpFind->lpDir)) != NULL) {
+		if (fnmatch(lpFind->szaPattern, lpEntry->d_name, 0) != 0)
+			continue;
+
+		snprintf(szaPath, sizeof(szaPath), "%s/%s", lpFind->szaFolder,
+				 lpEntry->d_name);
+		WidenUtf8(szPath, szaPath, MAX_PATH * 2);
+		if (!GetFileAttributesEx(szPath, GetFileExInfoStandard, &wfad))
+			continue;
+
+		lpFindFileData->dwFileAttributes = wfad.dwFileAttributes;
+		lpFindFileData->ftCreationTime = wfad.ftCreationTime;
+		lpFindFileData->ftLastAccessTime = wfad.ftLastAccessTime;
+		lpFindFileData->ftLastWriteTime = wfad.ftLastWriteTime;
+		lpFindFileData->nFileSizeHigh = wfad.nFileSizeHigh;
+		lpFindFileData->nFileSizeLow = wfad.nFileSizeLow;
+		WidenUtf8(lpFindFileData->cFileName, lpEntry->d_name, MAX_PATH);
+
+		return TRUE;
+	}
+
+	dwLastError = ERROR_FILE_NOT_FOUND;
+	return FALSE;
+}
+
+/**
+ * Converts UTF-8 into UTF-16.
+ *
+ * @param  szOutput Buffer to receive the text.
+ * @param  szaInput Text to be converted.
+ * @param  cchMax   Size of the buffer including the NUL terminator.
+ * @return          Number of characters converted.
+ */
+size_t WidenUtf8(LPTSTR szOutput, const char *szaInput, size_t cchMax) {
+	int cch;
+
+	cch = MultiByteToWideChar(CP_UTF8, 0, szaInput, (int)strlen(szaInput),
+		szOutput, (int)cchMax - 1);
+	szOutput[cch] = 0;
+
+	return (size_t)cch;
+}
+
+/**
+ * Runs the function of a thread started by CreateThread.
+ *
+ * @param  lpParam Handle of the thread.
+ * @return         Always NULL.
+ */
+void* ThreadStart(void *lpParam) {
+	SHIM_HANDLE *lpThread = (SHIM_HANDLE*)lpParam;
+
+	lpThread->lpStartAddress(lpThread->lpParameter);
+	return NULL;
+}
\ No newline at end of file
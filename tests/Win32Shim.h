@@ -0,0 +1,28 @@
+/**
+ * Win32Shim.h
+ * A POSIX implementation of the parts of the Win32 API declared in
+ * win32/windows.h, with a few hooks for the tests.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _WIN32SHIM_H
+#define _WIN32SHIM_H
+
+#include <windows.h>
+
+// Fault injection.
+void Win32ShimFailWrite(long nWrite);
+
+// Accounting.
+void Win32ShimResetPeak(void);
+size_t Win32ShimPeakBytes(void);
+size_t Win32ShimLiveBytes(void);
+long Win32ShimMessageCount(void);
+void Win32ShimQuietMessages(BOOL bQuiet);
+
+// Paths.
+size_t Win32ShimNarrowPath(char *szaPath, LPCTSTR szPath);
+void Win32ShimWidenPath(LPTSTR szPath, const char *szaPath);
+
+#endif  // _WIN32SHIM_H
\ No newline at end of file
@@ -0,0 +1,95 @@
+/**
+ * WorkspaceIndexBench.c
+ * Compares walking the folders of a large workspace with opening its saved
+ * index and checking that it's still current, which is what opening a
+ * workspace does when nothing changed.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "WorkspaceIndex.h"
+
+// Definitions.
+#define NUM_FOLDERS 50
+#define NUM_PAGES   5000
+#define NUM_RUNS    20
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	FOLDERSNAPSHOT fsArticles;
+	FOLDERSNAPSHOT fsTemplates;
+	WORKSPACEINDEX wiIndex;
+	WCHAR szArticles[MAX_PATH];
+	WCHAR szTemplates[MAX_PATH];
+	WCHAR szIndexPath[MAX_PATH];
+	char szaRoot[256];
+	char szaPath[512];
+	double dWalk;
+	double dIndex;
+	int iRun;
+	int i;
+
+	// Create the workspace.
+	TestMakeFolder(szaRoot, "indexbench");
+	sprintf(szaPath, "%s/articles", szaRoot);
+	mkdir(szaPath, 0755);
+	Win32ShimWidenPath(szArticles, szaPath);
+	sprintf(szaPath, "%s/templates", szaRoot);
+	mkdir(szaPath, 0755);
+	Win32ShimWidenPath(szTemplates, szaPath);
+	sprintf(szaPath, "%s/MANIFEST.idx", szaRoot);
+	Win32ShimWidenPath(szIndexPath, szaPath);
+	for (i = 0; i < NUM_FOLDERS; i++) {
+		sprintf(szaPath, "%s/articles/folder%d", szaRoot, i);
+		mkdir(szaPath, 0755);
+	}
+	for (i = 0; i < NUM_PAGES; i++) {
+		sprintf(szaPath, "%s/articles/folder%d/page%d.html", szaRoot,
+				i % NUM_FOLDERS, i);
+		TestWriteFile(szaPath, "<p>page</p>", 11);
+	}
+
+	// Walk the folders like a workspace without an index.
+	InitializeFolderSnapshot(&fsArticles);
+	InitializeFolderSnapshot(&fsTemplates);
+	dWalk = TestMilliseconds();
+	for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+		SnapshotFolder(&fsArticles, szArticles);
+		SnapshotFolder(&fsTemplates, szTemplates);
+	}
+	dWalk = (TestMilliseconds() - dWalk) / NUM_RUNS;
+	SaveWorkspaceIndex(szIndexPath, &fsArticles, &fsTemplates);
+	FreeFolderSnapshot(&fsArticles);
+	FreeFolderSnapshot(&fsTemplates);
+
+	// Open the index and check it.
+	dIndex = TestMilliseconds();
+	for (iRun = 0; iRun < NUM_RUNS; iRun++) {
+		if (!OpenWorkspaceIndex(&wiIndex, szIndexPath, &fsArticles,
+				&fsTemplates) ||
+				!IsFolderSnapshotCurrent(&fsArticles, szArticles) ||
+				!IsFolderSnapshotCurrent(&fsTemplates, szTemplates)) {
+			printf("The index wasn't usable\n");
+			return 1;
+		}
+
+		FreeFolderSnapshot(&fsArticles);
+		FreeFolderSnapshot(&fsTemplates);
+		CloseWorkspaceIndex(&wiIndex);
+	}
+	dIndex = (TestMilliseconds() - dIndex) / NUM_RUNS;
+
+	printf("%d pages in %d folders: walk %.2f ms, index %.2f ms\n",
+		   NUM_PAGES, NUM_FOLDERS, dWalk, dIndex);
+
+	TestRemoveFolder(szaRoot);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,307 @@
+/**
+ * WorkspaceIndexTest.c
+ * Checks folder snapshots and the workspace index saved from them: what gets
+ * recorded, what a reopened index holds, when it's considered stale and what
+ * a comparison reports.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "TestHelper.h"
+#include "Win32Shim.h"
+#include "WorkspaceIndex.h"
+
+// Changes reported by a comparison.
+typedef struct {
+	int nAdded;
+	int nRemoved;
+	int nChanged;
+} DIFF_COUNTS;
+
+// Private methods.
+void BuildWorkspace(const char *szaRoot);
+void CheckSnapshot(const FOLDERSNAPSHOT *lpSnapshot);
+void CheckIndex(const char *szaRoot);
+void CheckCorruptIndex(const char *szaRoot);
+void CheckDiff(const char *szaRoot);
+BOOL CountDifference(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+					 LPARAM lParam);
+int HasEntry(const FOLDERSNAPSHOT *lpSnapshot, const char *szaSuffix);
+
+// Global variables.
+WCHAR szArticles[MAX_PATH];
+WCHAR szTemplates[MAX_PATH];
+WCHAR szIndexPath[MAX_PATH];
+
+/**
+ * Creates a small workspace with pages, leftovers of an interrupted save and
+ * files that aren't pages.
+ *
+ * @param szaRoot Scratch folder to create it in.
+ */
+void BuildWorkspace(const char *szaRoot) {
+	char szaPath[512];
+
+	sprintf(szaPath, "%s/articles", szaRoot);
+	mkdir(szaPath, 0755);
+	sprintf(szaPath, "%s/articles/sub", szaRoot);
+	mkdir(szaPath, 0755);
+	sprintf(szaPath, "%s/templates", szaRoot);
+	mkdir(szaPath, 0755);
+
+	sprintf(szaPath, "%s/articles/index.html", szaRoot);
+	TestWriteFile(szaPath, "<p>index</p>", 12);
+	sprintf(szaPath, "%s/articles/b.htm", szaRoot);
+	TestWriteFile(szaPath, "b", 1);
+	sprintf(szaPath, "%s/articles/sub/deep.HTML", szaRoot);
+	TestWriteFile(szaPath, "deep page", 9);
+	sprintf(szaPath, "%s/articles/sub/deep.HTML.tmp", szaRoot);
+	TestWriteFile(szaPath, "partial", 7);
+	sprintf(szaPath, "%s/articles/image.bmp", szaRoot);
+	TestWriteFile(szaPath, "BM", 2);
+	sprintf(szaPath, "%s/templates/head.html", szaRoot);
+	TestWriteFile(szaPath, "<head>", 6);
+
+	sprintf(szaPath, "%s/articles", szaRoot);
+	Win32ShimWidenPath(szArticles, szaPath);
+	sprintf(szaPath, "%s/templates", szaRoot);
+	Win32ShimWidenPath(szTemplates, szaPath);
+	sprintf(szaPath, "%s/MANIFEST.idx", szaRoot);
+	Win32ShimWidenPath(szIndexPath, szaPath);
+}
+
+/**
+ * Checks if a snapshot has a page whose path ends in a suffix.
+ *
+ * @param  lpSnapshot Snapshot to look in.
+ * @param  szaSuffix  End of the path, with backslashes as separators.
+ * @return            Size of the page plus one, or 0 if it isn't there.
+ */
+int HasEntry(const FOLDERSNAPSHOT *lpSnapshot, const char *szaSuffix) {
+	WCHAR szSuffix[MAX_PATH];
+	size_t cchSuffix;
+	size_t cchPath;
+	DWORD iEntry;
+
+	Win32ShimWidenPath(szSuffix, szaSuffix);
+	cchSuffix = wcslen(szSuffix);
+	for (iEntry = 0; iEntry < lpSnapshot->nEntries; iEntry++) {
+		cchPath = wcslen(lpSnapshot->lpEntries[iEntry].szPath);
+		if ((cchPath >= cchSuffix) &&
+				(memcmp(lpSnapshot->lpEntries[iEntry].szPath + cchPath -
+						cchSuffix, szSuffix, cchSuffix * sizeof(WCHAR)) == 0)) {
+			return (int)lpSnapshot->lpEntries[iEntry].dwSize + 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Checks that a snapshot of the articles folder has the pages and nothing
+ * else, sorted, along with every folder it walked.
+ *
+ * @param lpSnapshot Snapshot of the articles folder.
+ */
+void CheckSnapshot(const FOLDERSNAPSHOT *lpSnapshot) {
+	DWORD iEntry;
+
+	TEST_CHECK(lpSnapshot->nEntries == 3);
+	TEST_CHECK(HasEntry(lpSnapshot, "\\index.html") == 13);
+	TEST_CHECK(HasEntry(lpSnapshot, "\\b.htm") == 2);
+	TEST_CHECK(HasEntry(lpSnapshot, "\\sub\\deep.HTML") == 10);
+	TEST_CHECK(!HasEntry(lpSnapshot, ".tmp"));
+	TEST_CHECK(!HasEntry(lpSnapshot, ".bmp"));
+
+	for (iEntry = 1; iEntry < lpSnapshot->nEntries; iEntry++) {
+		TEST_CHECK(wcscmp(lpSnapshot->lpEntries[iEntry - 1].szPath,
+						  lpSnapshot->lpEntries[iEntry].szPath) < 0);
+	}
+
+	TEST_CHECK(lpSnapshot->nFolders == 2);
+	TEST_CHECK(wcscmp(lpSnapshot->lpFolders[0].szPath, szArticles) == 0);
+}
+
+/**
+ * Checks that a saved index reopens with the same contents, and stops being
+ * current once a folder changes.
+ *
+ * @param szaRoot Scratch folder of the workspace.
+ */
+void CheckIndex(const char *szaRoot) {
+	FOLDERSNAPSHOT fsArticles;
+	FOLDERSNAPSHOT fsTemplates;
+	WORKSPACEINDEX wiIndex;
+	char szaPath[512];
+
+	// Save an index of the current state.
+	InitializeFolderSnapshot(&fsArticles);
+	InitializeFolderSnapshot(&fsTemplates);
+	TEST_CHECK(SnapshotFolder(&fsArticles, szArticles));
+	TEST_CHECK(SnapshotFolder(&fsTemplates, szTemplates));
+	CheckSnapshot(&fsArticles);
+	TEST_CHECK(fsTemplates.nEntries == 1);
+	TEST_CHECK(SaveWorkspaceIndex(szIndexPath, &fsArticles, &fsTemplates));
+	FreeFolderSnapshot(&fsArticles);
+	FreeFolderSnapshot(&fsTemplates);
+
+	// Reopen it.
+	TEST_CHECK(OpenWorkspaceIndex(&wiIndex, szIndexPath, &fsArticles,
+								  &fsTemplates));
+	CheckSnapshot(&fsArticles);
+	TEST_CHECK(fsTemplates.nEntries == 1);
+	TEST_CHECK(IsFolderSnapshotCurrent(&fsArticles, szArticles));
+	TEST_CHECK(IsFolderSnapshotCurrent(&fsTemplates, szTemplates));
+	TEST_CHECK(!IsFolderSnapshotCurrent(&fsArticles, szTemplates));
+
+	// Adding a page to a sub-folder makes it stale.
+	sprintf(szaPath, "%s/articles/sub/new.html", szaRoot);
+	TestWriteFile(szaPath, "new", 3);
+	TEST_CHECK(!IsFolderSnapshotCurrent(&fsArticles, szArticles));
+	TEST_CHECK(IsFolderSnapshotCurrent(&fsTemplates, szTemplates));
+
+	FreeFolderSnapshot(&fsArticles);
+	FreeFolderSnapshot(&fsTemplates);
+	CloseWorkspaceIndex(&wiIndex);
+}
+
+/**
+ * Checks that a truncated or damaged index is refused.
+ *
+ * @param szaRoot Scratch folder of the workspace.
+ */
+void CheckCorruptIndex(const char *szaRoot) {
+	FOLDERSNAPSHOT fsArticles;
+	FOLDERSNAPSHOT fsTemplates;
+	WORKSPACEINDEX wiIndex;
+	char szaPath[512];
+	char *lpData;
+	long cbData;
+	FILE *lpFile;
+
+	// Read the good index.
+	sprintf(szaPath, "%s/MANIFEST.idx", szaRoot);
+	lpFile = fopen(szaPath, "rb");
+	fseek(lpFile, 0, SEEK_END);
+	cbData = ftell(lpFile);
+	rewind(lpFile);
+	lpData = (char*)malloc(cbData);
+	TEST_CHECK(fread(lpData, 1, cbData, lpFile) == (size_t)cbData);
+	fclose(lpFile);
+
+	InitializeFolderSnapshot(&fsArticles);
+	InitializeFolderSnapshot(&fsTemplates);
+
+	// Truncated.
+	TestWriteFile(szaPath, lpData, cbData - 4);
+	TEST_CHECK(!OpenWorkspaceIndex(&wiIndex, szIndexPath, &fsArticles,
+								   &fsTemplates));
+
+	// Wrong magic.
+	lpData[0] ^= 0xFF;
+	TestWriteFile(szaPath, lpData, cbData);
+	TEST_CHECK(!OpenWorkspaceIndex(&wiIndex, szIndexPath, &fsArticles,
+								   &fsTemplates));
+
+	// Empty and missing.
+	TestWriteFile(szaPath, lpData, 0);
+	TEST_CHECK(!OpenWorkspaceIndex(&wiIndex, szIndexPath, &fsArticles,
+								   &fsTemplates));
+	remove(szaPath);
+	TEST_CHECK(!OpenWorkspaceIndex(&wiIndex, szIndexPath, &fsArticles,
+								   &fsTemplates));
+	TEST_CHECK(fsArticles.nEntries == 0);
+
+	free(lpData);
+}
+
+/**
+ * Counts a difference between two snapshots.
+ *
+ * @param  uChange Type of change.
+ * @param  lpEntry Entry that changed.
+ * @param  lParam  DIFF_COUNTS to be updated.
+ * @return         Always TRUE to keep comparing.
+ */
+BOOL CountDifference(UINT uChange, const SNAPSHOT_ENTRY *lpEntry,
+					 LPARAM lParam) {
+	DIFF_COUNTS *lpCounts = (DIFF_COUNTS*)lParam;
+
+	(void)lpEntry;
+	switch (uChange) {
+	case SNAPSHOT_ADDED:
+		lpCounts->nAdded++;
+		break;
+	case SNAPSHOT_REMOVED:
+		lpCounts->nRemoved++;
+		break;
+	case SNAPSHOT_CHANGED:
+		lpCounts->nChanged++;
+		break;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Checks that comparing snapshots finds added, removed and changed pages.
+ *
+ * @param szaRoot Scratch folder of the workspace.
+ */
+void CheckDiff(const char *szaRoot) {
+	FOLDERSNAPSHOT fsOld;
+	FOLDERSNAPSHOT fsNew;
+	DIFF_COUNTS dcCounts;
+	char szaPath[512];
+
+	InitializeFolderSnapshot(&fsOld);
+	InitializeFolderSnapshot(&fsNew);
+	TEST_CHECK(SnapshotFolder(&fsOld, szArticles));
+
+	sprintf(szaPath, "%s/articles/b.htm", szaRoot);
+	remove(szaPath);
+	sprintf(szaPath, "%s/articles/index.html", szaRoot);
+	TestWriteFile(szaPath, "<p>longer index</p>", 19);
+	sprintf(szaPath, "%s/articles/c.html", szaRoot);
+	TestWriteFile(szaPath, "c", 1);
+	TEST_CHECK(SnapshotFolder(&fsNew, szArticles));
+
+	memset(&dcCounts, 0, sizeof(dcCounts));
+	TEST_CHECK(DiffFolderSnapshots(&fsOld, &fsNew, CountDifference,
+								   (LPARAM)&dcCounts));
+	TEST_CHECK(dcCounts.nAdded == 1);
+	TEST_CHECK(dcCounts.nRemoved == 1);
+	TEST_CHECK(dcCounts.nChanged == 1);
+
+	memset(&dcCounts, 0, sizeof(dcCounts));
+	TEST_CHECK(DiffFolderSnapshots(&fsNew, &fsNew, CountDifference,
+								   (LPARAM)&dcCounts));
+	TEST_CHECK(dcCounts.nAdded + dcCounts.nRemoved + dcCounts.nChanged == 0);
+
+	FreeFolderSnapshot(&fsOld);
+	FreeFolderSnapshot(&fsNew);
+}
+
+/**
+ * Program's main entry point.
+ *
+ * @return Exit code of the program.
+ */
+int main(void) {
+	char szaRoot[256];
+
+	TEST_CHECK(TestMakeFolder(szaRoot, "index"));
+	BuildWorkspace(szaRoot);
+
+	CheckIndex(szaRoot);
+	CheckCorruptIndex(szaRoot);
+	CheckDiff(szaRoot);
+	TEST_CHECK(Win32ShimLiveBytes() == 0);
+
+	TestRemoveFolder(szaRoot);
+	return TestFinish("WorkspaceIndexTest");
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+/**
+ * uki.h
+ * Declarations of the parts of libuki that the modules under test use, so
+ * that they can be built against UkiStub instead of the real engine.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _UKI_H
+#define _UKI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Limits.
+#define UKI_MAX_PATH 255
+
+// Error codes.
+#define UKI_OK 0
+
+// Pages of a workspace.
+typedef struct {
+	char *path;
+	char *name;
+	char *parent;
+	uint8_t deepness;
+} uki_article_t;
+typedef uki_article_t uki_template_t;
+
+// Variables and configuration keys from the manifest.
+typedef struct {
+	char *key;
+	char *value;
+} uki_variable_t;
+
+// Articles.
+uki_article_t uki_article(size_t index);
+size_t uki_articles_available(void);
+
+// Templates.
+uki_template_t uki_template(size_t index);
+size_t uki_templates_available(void);
+
+// Variables.
+uki_variable_t uki_variable(size_t index);
+uki_variable_t uki_config(size_t index);
+
+#endif  // _UKI_H
\ No newline at end of file
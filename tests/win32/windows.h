@@ -0,0 +1,260 @@
+/**
+ * windows.h
+ * The parts of the Win32 API that the file handling modules use, declared for
+ * Win32Shim so that they can be tested on a regular Unix box. Build with
+ * -fshort-wchar so that wide strings are UTF-16 like on Windows.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _WINDOWS_H
+#define _WINDOWS_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <wchar.h>
+
+// Basic types.
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned int DWORD;
+typedef int LONG;
+typedef unsigned int UINT;
+typedef BYTE *LPBYTE;
+typedef void *LPVOID;
+typedef const void *LPCVOID;
+typedef long LPARAM;
+typedef unsigned long WPARAM;
+typedef long LRESULT;
+
+// Strings.
+typedef wchar_t WCHAR;
+typedef wchar_t TCHAR;
+typedef wchar_t *LPWSTR;
+typedef const wchar_t *LPCWSTR;
+typedef wchar_t *LPTSTR;
+typedef const wchar_t *LPCTSTR;
+typedef char *LPSTR;
+typedef const char *LPCSTR;
+
+// Handles.
+typedef void *HANDLE;
+typedef void *HLOCAL;
+typedef void *HWND;
+typedef void *HINSTANCE;
+typedef void *HMENU;
+
+// Calling conventions.
+#define WINAPI
+#define CALLBACK
+
+// Boolean values.
+#define TRUE  1
+#define FALSE 0
+
+// Limits.
+#define MAX_PATH 260
+
+// Smaller and larger of two values.
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+// Special handle values.
+#define INVALID_HANDLE_VALUE ((HANDLE)(long)-1)
+
+// Waiting.
+#define INFINITE      0xFFFFFFFF
+#define WAIT_OBJECT_0 0x00000000
+#define WAIT_FAILED   0xFFFFFFFF
+
+// Memory allocation flags.
+#define LMEM_FIXED    0x0000
+#define LMEM_MOVEABLE 0x0002
+#define LMEM_ZEROINIT 0x0040
+#define LPTR          (LMEM_FIXED | LMEM_ZEROINIT)
+
+// Code pages.
+#define CP_ACP  0
+#define CP_UTF8 65001
+
+// File access.
+#define GENERIC_READ          0x80000000
+#define GENERIC_WRITE         0x40000000
+#define FILE_SHARE_READ       0x00000001
+#define FILE_SHARE_WRITE      0x00000002
+#define CREATE_NEW            1
+#define CREATE_ALWAYS         2
+#define OPEN_EXISTING         3
+#define OPEN_ALWAYS           4
+#define FILE_BEGIN            0
+#define FILE_CURRENT          1
+#define FILE_END              2
+
+// File attributes.
+#define FILE_ATTRIBUTE_DIRECTORY 0x00000010
+#define FILE_ATTRIBUTE_NORMAL    0x00000080
+#define INVALID_FILE_ATTRIBUTES  ((DWORD)-1)
+#define GetFileExInfoStandard    0
+
+// Moving files.
+#define MOVEFILE_REPLACE_EXISTING 0x00000001
+#define MOVEFILE_WRITE_THROUGH    0x00000008
+
+// File mappings.
+#define PAGE_READONLY 0x02
+#define FILE_MAP_READ 0x04
+
+// Error codes.
+#define ERROR_SUCCESS        0L
+#define ERROR_FILE_NOT_FOUND 2L
+#define ERROR_ACCESS_DENIED  5L
+#define ERROR_ALREADY_EXISTS 183L
+
+// Window messages.
+#define WM_GETTEXT       0x000D
+#define WM_GETTEXTLENGTH 0x000E
+
+// Message boxes.
+#define MB_OK          0x00000000
+#define MB_YESNO       0x00000004
+#define MB_ICONERROR   0x00000010
+#define MB_ICONWARNING 0x00000030
+#define IDYES          6
+
+// A rectangle on the screen.
+typedef struct {
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+} RECT;
+
+// Time of a file.
+typedef struct {
+	DWORD dwLowDateTime;
+	DWORD dwHighDateTime;
+} FILETIME;
+
+// Attributes of a file.
+typedef struct {
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime;
+	FILETIME ftLastAccessTime;
+	FILETIME ftLastWriteTime;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+} WIN32_FILE_ATTRIBUTE_DATA;
+
+// A file found in a folder.
+typedef struct {
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime;
+	FILETIME ftLastAccessTime;
+	FILETIME ftLastWriteTime;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+	WCHAR cFileName[MAX_PATH];
+} WIN32_FIND_DATA;
+
+// Entry point of a thread.
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)(LPVOID lpParameter);
+
+// A lock that the thread holding it can take again.
+typedef struct {
+	void *lpMutex;
+} CRITICAL_SECTION;
+
+// Information about the system.
+typedef struct {
+	DWORD dwPageSize;
+	DWORD dwNumberOfProcessors;
+} SYSTEM_INFO;
+
+// Memory.
+HLOCAL LocalAlloc(UINT uFlags, size_t uBytes);
+HLOCAL LocalReAlloc(HLOCAL hMem, size_t uBytes, UINT uFlags);
+HLOCAL LocalFree(HLOCAL hMem);
+size_t LocalSize(HLOCAL hMem);
+
+// Files.
+HANDLE CreateFile(LPCTSTR lpFileName, DWORD dwDesiredAccess,
+				  DWORD dwShareMode, LPVOID lpSecurityAttributes,
+				  DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes,
+				  HANDLE hTemplateFile);
+BOOL ReadFile(HANDLE hFile, LPVOID lpBuffer, DWORD nNumberOfBytesToRead,
+			  DWORD *lpNumberOfBytesRead, LPVOID lpOverlapped);
+BOOL WriteFile(HANDLE hFile, LPCVOID lpBuffer, DWORD nNumberOfBytesToWrite,
+			   DWORD *lpNumberOfBytesWritten, LPVOID lpOverlapped);
+BOOL FlushFileBuffers(HANDLE hFile);
+DWORD GetFileSize(HANDLE hFile, DWORD *lpFileSizeHigh);
+DWORD SetFilePointer(HANDLE hFile, LONG lDistanceToMove,
+					 LONG *lpDistanceToMoveHigh, DWORD dwMoveMethod);
+BOOL CloseHandle(HANDLE hObject);
+BOOL DeleteFile(LPCTSTR lpFileName);
+BOOL CopyFile(LPCTSTR lpExistingFileName, LPCTSTR lpNewFileName,
+			  BOOL bFailIfExists);
+BOOL MoveFile(LPCTSTR lpExistingFileName, LPCTSTR lpNewFileName);
+BOOL MoveFileEx(LPCTSTR lpExistingFileName, LPCTSTR lpNewFileName,
+				DWORD dwFlags);
+DWORD GetFileAttributes(LPCTSTR lpFileName);
+BOOL GetFileAttributesEx(LPCTSTR lpFileName, int fInfoLevelId,
+						 LPVOID lpFileInformation);
+LONG CompareFileTime(const FILETIME *lpFileTime1,
+					 const FILETIME *lpFileTime2);
+DWORD GetLastError(void);
+
+// Folders.
+HANDLE FindFirstFile(LPCTSTR lpFileName, WIN32_FIND_DATA *lpFindFileData);
+BOOL FindNextFile(HANDLE hFindFile, WIN32_FIND_DATA *lpFindFileData);
+BOOL FindClose(HANDLE hFindFile);
+
+// File mappings.
+HANDLE CreateFileForMapping(LPCTSTR lpFileName, DWORD dwDesiredAccess,
+							DWORD dwShareMode, LPVOID lpSecurityAttributes,
+							DWORD dwCreationDisposition,
+							DWORD dwFlagsAndAttributes, HANDLE hTemplateFile);
+HANDLE CreateFileMapping(HANDLE hFile, LPVOID lpAttributes, DWORD flProtect,
+						 DWORD dwMaximumSizeHigh, DWORD dwMaximumSizeLow,
+						 LPCTSTR lpName);
+LPVOID MapViewOfFile(HANDLE hFileMappingObject, DWORD dwDesiredAccess,
+					 DWORD dwFileOffsetHigh, DWORD dwFileOffsetLow,
+					 size_t dwNumberOfBytesToMap);
+BOOL UnmapViewOfFile(LPCVOID lpBaseAddress);
+
+// Threads.
+HANDLE CreateThread(LPVOID lpThreadAttributes, size_t dwStackSize,
+					LPTHREAD_START_ROUTINE lpStartAddress, LPVOID lpParameter,
+					DWORD dwCreationFlags, DWORD *lpThreadId);
+DWORD WaitForMultipleObjects(DWORD nCount, const HANDLE *lpHandles,
+							 BOOL bWaitAll, DWORD dwMilliseconds);
+LONG InterlockedIncrement(LONG *lpAddend);
+void InitializeCriticalSection(CRITICAL_SECTION *lpCriticalSection);
+void DeleteCriticalSection(CRITICAL_SECTION *lpCriticalSection);
+void EnterCriticalSection(CRITICAL_SECTION *lpCriticalSection);
+void LeaveCriticalSection(CRITICAL_SECTION *lpCriticalSection);
+
+// System.
+void GetSystemInfo(SYSTEM_INFO *lpSystemInfo);
+
+// Text.
+int MultiByteToWideChar(UINT CodePage, DWORD dwFlags, LPCSTR lpMultiByteStr,
+						int cbMultiByte, LPWSTR lpWideCharStr,
+						int cchWideChar);
+int WideCharToMultiByte(UINT CodePage, DWORD dwFlags, LPCWSTR lpWideCharStr,
+						int cchWideChar, LPSTR lpMultiByteStr,
+						int cbMultiByte, LPCSTR lpDefaultChar,
+						BOOL *lpUsedDefaultChar);
+BOOL IsDBCSLeadByte(BYTE TestChar);
+int wsprintf(LPTSTR lpOut, LPCTSTR lpFmt, ...);
+int _wcsicmp(const wchar_t *string1, const wchar_t *string2);
+
+// User interface.
+int MessageBox(HWND hWnd, LPCTSTR lpText, LPCTSTR lpCaption, UINT uType);
+void OutputDebugString(LPCTSTR lpOutputString);
+
+#endif  // _WINDOWS_H
\ No newline at end of file
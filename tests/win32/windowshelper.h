@@ -0,0 +1,14 @@
+/**
+ * windowshelper.h
+ * Stands in for the WindowsHelper library header, which only brings in the
+ * Win32 API as far as the modules under test are concerned.
+ *
+ * @author Nathan Campos <hi@nathancampos.me>
+ */
+
+#ifndef _WINDOWSHELPER_H
+#define _WINDOWSHELPER_H
+
+#include <windows.h>
+
+#endif  // _WINDOWSHELPER_H
\ No newline at end of file